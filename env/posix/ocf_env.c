@@ -6,6 +6,52 @@
 #include "ocf_env.h"
 #include <sched.h>
 #include <execinfo.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+
+/*
+ * Allocator keeps free items in per-CPU magazines, so that most allocations
+ * and deallocations touch only CPU local stack of items. Full and empty
+ * magazines are exchanged with allocator depot, and new items are carved
+ * out of slabs, which are released only when allocator is destroyed.
+ */
+#define ENV_ALLOCATOR_MAGAZINE_SIZE	64
+#define ENV_ALLOCATOR_SLAB_SIZE		(64 * 1024)
+#define ENV_ALLOCATOR_SLAB_MIN_ITEMS	16
+#define ENV_ALLOCATOR_CACHE_LINE	64
+
+struct _env_allocator_item {
+	uint32_t flags;
+	uint32_t cpu;
+	char data[];
+};
+
+struct _env_allocator_magazine {
+	struct _env_allocator_magazine *next;
+	uint32_t count;
+	struct _env_allocator_item *items[ENV_ALLOCATOR_MAGAZINE_SIZE];
+};
+
+struct _env_allocator_slab {
+	struct _env_allocator_slab *next;
+	uint64_t pad;
+	char data[];
+};
+
+struct _env_allocator_cpu {
+	env_spinlock lock;
+
+	/*!< Magazine items are allocated from and freed to */
+	struct _env_allocator_magazine *loaded;
+
+	/*!< Previously loaded magazine, either full or empty */
+	struct _env_allocator_magazine *previous;
+
+	/*!< Number of items allocated minus freed on this CPU */
+	long count;
+} __attribute__((aligned(ENV_ALLOCATOR_CACHE_LINE)));
 
 struct _env_allocator {
 	/*!< Memory pool ID unique name */
@@ -14,8 +60,32 @@ struct _env_allocator {
 	/*!< Size of specific item of memory pool */
 	uint32_t item_size;
 
-	/*!< Number of currently allocated items in pool */
-	env_atomic count;
+	/*!< Number of per-CPU caches */
+	uint32_t cpus;
+
+	/*!< Per-CPU caches of free items */
+	struct _env_allocator_cpu *cpu;
+
+	/*!< Protects depot and slabs */
+	env_spinlock depot_lock;
+
+	/*!< Depot of full magazines */
+	struct _env_allocator_magazine *full;
+
+	/*!< Depot of empty magazines */
+	struct _env_allocator_magazine *empty;
+
+	/*!< Free items which didn't fit in any magazine */
+	struct _env_allocator_item *overflow;
+
+	/*!< All slabs of allocator */
+	struct _env_allocator_slab *slabs;
+
+	/*!< Not yet used part of the newest slab */
+	char *slab_next, *slab_end;
+
+	/*!< Number of items in single slab */
+	uint32_t slab_items;
 };
 
 static inline size_t env_allocator_align(size_t size)
@@ -25,32 +95,169 @@ static inline size_t env_allocator_align(size_t size)
 	return (1ULL << 32) >> __builtin_clz(size - 1);
 }
 
-struct _env_allocator_item {
-	uint32_t flags;
-	uint32_t cpu;
-	char data[];
-};
+/* Overflow list is linked through data of free items */
+#define _ENV_ALLOCATOR_ITEM_NEXT(item) \
+	(*(struct _env_allocator_item **)(item)->data)
 
-void *env_allocator_new(env_allocator *allocator)
+static inline struct _env_allocator_cpu *_env_allocator_cpu(
+		env_allocator *allocator)
 {
-	struct _env_allocator_item *item = NULL;
+	int cpu = sched_getcpu();
+
+	return &allocator->cpu[cpu < 0 ? 0 : cpu % allocator->cpus];
+}
 
-	item = calloc(1, allocator->item_size);
+/* Called under depot lock */
+static struct _env_allocator_item *_env_allocator_slab_item(
+		env_allocator *allocator)
+{
+	struct _env_allocator_item *item;
+	struct _env_allocator_slab *slab;
 
+	item = allocator->overflow;
 	if (item) {
-		item->cpu = 0;
-		env_atomic_inc(&allocator->count);
+		allocator->overflow = _ENV_ALLOCATOR_ITEM_NEXT(item);
+		return item;
+	}
+
+	if (allocator->slab_next == allocator->slab_end) {
+		slab = malloc(sizeof(*slab) + (size_t)allocator->item_size *
+				allocator->slab_items);
+		if (!slab)
+			return NULL;
+
+		slab->next = allocator->slabs;
+		allocator->slabs = slab;
+		allocator->slab_next = slab->data;
+		allocator->slab_end = slab->data + (size_t)allocator->item_size *
+				allocator->slab_items;
 	}
 
+	item = (struct _env_allocator_item *)allocator->slab_next;
+	allocator->slab_next += allocator->item_size;
+
+	return item;
+}
+
+/* Called under CPU cache lock */
+static struct _env_allocator_item *_env_allocator_get(
+		env_allocator *allocator, struct _env_allocator_cpu *cpu)
+{
+	struct _env_allocator_magazine *mag;
+	struct _env_allocator_item *item;
+
+	if (!cpu->loaded->count && cpu->previous->count) {
+		mag = cpu->loaded;
+		cpu->loaded = cpu->previous;
+		cpu->previous = mag;
+	}
+
+	if (cpu->loaded->count)
+		return cpu->loaded->items[--cpu->loaded->count];
+
+	env_spinlock_lock(&allocator->depot_lock);
+
+	mag = allocator->full;
+	if (mag) {
+		allocator->full = mag->next;
+		cpu->loaded->next = allocator->empty;
+		allocator->empty = cpu->loaded;
+		cpu->loaded = mag;
+	} else {
+		/* Refill half of magazine, leaving room for freed items */
+		while (cpu->loaded->count < ENV_ALLOCATOR_MAGAZINE_SIZE / 2) {
+			item = _env_allocator_slab_item(allocator);
+			if (!item)
+				break;
+			cpu->loaded->items[cpu->loaded->count++] = item;
+		}
+	}
+
+	env_spinlock_unlock(&allocator->depot_lock);
+
+	if (!cpu->loaded->count)
+		return NULL;
+
+	return cpu->loaded->items[--cpu->loaded->count];
+}
+
+/* Called under CPU cache lock */
+static void _env_allocator_put(env_allocator *allocator,
+		struct _env_allocator_cpu *cpu, struct _env_allocator_item *item)
+{
+	struct _env_allocator_magazine *mag;
+
+	if (cpu->loaded->count == ENV_ALLOCATOR_MAGAZINE_SIZE &&
+			!cpu->previous->count) {
+		mag = cpu->loaded;
+		cpu->loaded = cpu->previous;
+		cpu->previous = mag;
+	}
+
+	if (cpu->loaded->count < ENV_ALLOCATOR_MAGAZINE_SIZE) {
+		cpu->loaded->items[cpu->loaded->count++] = item;
+		return;
+	}
+
+	env_spinlock_lock(&allocator->depot_lock);
+
+	mag = allocator->empty;
+	if (mag)
+		allocator->empty = mag->next;
+	else
+		mag = calloc(1, sizeof(*mag));
+
+	if (mag) {
+		cpu->loaded->next = allocator->full;
+		allocator->full = cpu->loaded;
+		cpu->loaded = mag;
+		cpu->loaded->items[cpu->loaded->count++] = item;
+	} else {
+		_ENV_ALLOCATOR_ITEM_NEXT(item) = allocator->overflow;
+		allocator->overflow = item;
+	}
+
+	env_spinlock_unlock(&allocator->depot_lock);
+}
+
+void *env_allocator_new(env_allocator *allocator)
+{
+	struct _env_allocator_cpu *cpu = _env_allocator_cpu(allocator);
+	struct _env_allocator_item *item;
+
+	env_spinlock_lock(&cpu->lock);
+	item = _env_allocator_get(allocator, cpu);
+	if (item)
+		cpu->count++;
+	env_spinlock_unlock(&cpu->lock);
+
+	if (!item)
+		return NULL;
+
+	memset(item, 0, allocator->item_size);
+	item->cpu = cpu - allocator->cpu;
+
 	return &item->data;
 }
 
+static void _env_allocator_free_magazines(
+		struct _env_allocator_magazine *mag)
+{
+	struct _env_allocator_magazine *next;
+
+	for (; mag; mag = next) {
+		next = mag->next;
+		free(mag);
+	}
+}
 
 env_allocator *env_allocator_create(uint32_t size, const char *fmt_name, ...)
 {
 	char name[OCF_ALLOCATOR_NAME_MAX] = { '\0' };
 	int result, error = -1;
 	va_list args;
+	long cpus;
+	uint32_t i;
 
 	env_allocator *allocator = calloc(1, sizeof(*allocator));
 	if (!allocator) {
@@ -58,7 +265,36 @@ env_allocator *env_allocator_create(uint32_t size, const char *fmt_name, ...)
 		goto err;
 	}
 
-	allocator->item_size = size + sizeof(struct _env_allocator_item);
+	env_spinlock_init(&allocator->depot_lock);
+
+	/* Item has to fit overflow list link, keep data aligned as malloc */
+	allocator->item_size = roundup(sizeof(struct _env_allocator_item) +
+			MAX(size, sizeof(void *)), 16);
+	allocator->slab_items = MAX(ENV_ALLOCATOR_SLAB_MIN_ITEMS,
+			ENV_ALLOCATOR_SLAB_SIZE / allocator->item_size);
+
+	cpus = sysconf(_SC_NPROCESSORS_CONF);
+	allocator->cpus = cpus > 0 ? cpus : 1;
+
+	if (posix_memalign((void **)&allocator->cpu, ENV_ALLOCATOR_CACHE_LINE,
+			sizeof(*allocator->cpu) * allocator->cpus)) {
+		allocator->cpu = NULL;
+		error = __LINE__;
+		goto err;
+	}
+	memset(allocator->cpu, 0, sizeof(*allocator->cpu) * allocator->cpus);
+
+	for (i = 0; i < allocator->cpus; i++) {
+		env_spinlock_init(&allocator->cpu[i].lock);
+		allocator->cpu[i].loaded = calloc(1,
+				sizeof(*allocator->cpu[i].loaded));
+		allocator->cpu[i].previous = calloc(1,
+				sizeof(*allocator->cpu[i].previous));
+		if (!allocator->cpu[i].loaded || !allocator->cpu[i].previous) {
+			error = __LINE__;
+			goto err;
+		}
+	}
 
 	/* Format allocator name */
 	va_start(args, fmt_name);
@@ -91,20 +327,38 @@ void env_allocator_del(env_allocator *allocator, void *obj)
 {
 	struct _env_allocator_item *item =
 		container_of(obj, struct _env_allocator_item, data);
+	struct _env_allocator_cpu *cpu = _env_allocator_cpu(allocator);
 
-	env_atomic_dec(&allocator->count);
-
-	free(item);
+	env_spinlock_lock(&cpu->lock);
+	_env_allocator_put(allocator, cpu, item);
+	cpu->count--;
+	env_spinlock_unlock(&cpu->lock);
 }
 
 void env_allocator_destroy(env_allocator *allocator)
 {
+	struct _env_allocator_slab *slab, *next;
+	uint32_t i;
+
 	if (allocator) {
-		if (env_atomic_read(&allocator->count)) {
+		if (allocator->cpu && env_allocator_item_count(allocator)) {
 			printf("Not all objects deallocated\n");
 			ENV_WARN(true, OCF_PREFIX_SHORT" Cleanup problem\n");
 		}
 
+		for (i = 0; allocator->cpu && i < allocator->cpus; i++) {
+			free(allocator->cpu[i].loaded);
+			free(allocator->cpu[i].previous);
+		}
+		_env_allocator_free_magazines(allocator->full);
+		_env_allocator_free_magazines(allocator->empty);
+
+		for (slab = allocator->slabs; slab; slab = next) {
+			next = slab->next;
+			free(slab);
+		}
+
+		free(allocator->cpu);
 		free(allocator->name);
 		free(allocator);
 	}
@@ -112,13 +366,222 @@ void env_allocator_destroy(env_allocator *allocator)
 
 uint32_t env_allocator_item_count(env_allocator *allocator)
 {
-	return env_atomic_read(&allocator->count);
+	long count = 0;
+	uint32_t i;
+
+	for (i = 0; i < allocator->cpus; i++) {
+		env_spinlock_lock(&allocator->cpu[i].lock);
+		count += allocator->cpu[i].count;
+		env_spinlock_unlock(&allocator->cpu[i].lock);
+	}
+
+	return count;
+}
+
+/* *** RW SEMAPHORE *** */
+
+/* Number of lock attempts before contended locker is parked */
+#define ENV_RWSEM_SPIN	256
+
+static void _env_rwsem_wait(env_rwsem *s, int (*trylock)(env_rwsem *s))
+{
+	int seq, i;
+
+	while (true) {
+		for (i = 0; i < ENV_RWSEM_SPIN; i++) {
+			if (!trylock(s))
+				return;
+			env_cpu_relax();
+		}
+
+		/* Sample futex word before last attempt, so that release
+		 * in between makes futex wait return immediately
+		 */
+		env_atomic_inc(&s->sleepers);
+		seq = env_atomic_read(&s->seq);
+		if (!trylock(s)) {
+			env_atomic_dec(&s->sleepers);
+			return;
+		}
+
+		syscall(SYS_futex, &s->seq.counter, FUTEX_WAIT_PRIVATE, seq,
+				NULL, NULL, 0);
+		env_atomic_dec(&s->sleepers);
+	}
+}
+
+void __env_rwsem_down_read(env_rwsem *s)
+{
+	_env_rwsem_wait(s, env_rwsem_down_read_trylock);
+}
+
+void __env_rwsem_down_write(env_rwsem *s)
+{
+	/* Hold off new readers until writer gets in */
+	env_atomic_inc(&s->writers);
+	_env_rwsem_wait(s, env_rwsem_down_write_trylock);
+	env_atomic_dec(&s->writers);
+}
+
+void __env_rwsem_wake(env_rwsem *s)
+{
+	env_atomic_inc(&s->seq);
+	syscall(SYS_futex, &s->seq.counter, FUTEX_WAKE_PRIVATE, INT_MAX,
+			NULL, NULL, 0);
 }
 
 /* *** DEBUGING *** */
 
 #define ENV_TRACE_DEPTH	16
 
+/* *** HUGE PAGES *** */
+
+#define ENV_HUGE_PAGE_SIZE	(2ULL << 20)
+#define ENV_GIANT_PAGE_SIZE	(1ULL << 30)
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+static inline size_t env_huge_align(size_t size)
+{
+	return (size + ENV_HUGE_PAGE_SIZE - 1) & ~(ENV_HUGE_PAGE_SIZE - 1);
+}
+
+static void *env_huge_mmap(size_t size, int flags)
+{
+	void *ptr;
+
+	ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+
+	return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+void *env_vzalloc_huge(size_t size)
+{
+	void *ptr = NULL;
+
+	size = env_huge_align(size);
+
+#ifdef MAP_HUGETLB
+	/* Reserved huge pages, 1 GiB ones only when whole page is used */
+	if (size % ENV_GIANT_PAGE_SIZE == 0)
+		ptr = env_huge_mmap(size, MAP_HUGETLB | (30 << MAP_HUGE_SHIFT));
+	if (!ptr)
+		ptr = env_huge_mmap(size, MAP_HUGETLB);
+	if (ptr)
+		return ptr;
+#endif
+
+#ifdef MADV_HUGEPAGE
+	/* Transparent huge pages */
+	ptr = env_huge_mmap(size, 0);
+	if (ptr && madvise(ptr, size, MADV_HUGEPAGE)) {
+		munmap(ptr, size);
+		ptr = NULL;
+	}
+#endif
+
+	return ptr;
+}
+
+void env_vfree_huge(void *ptr, size_t size)
+{
+	if (ptr)
+		munmap(ptr, env_huge_align(size));
+}
+
+/* *** NUMA *** */
+
+#define ENV_NUMA_MAX_NODES	1024
+#define ENV_NUMA_MASK_WORDS	(ENV_NUMA_MAX_NODES / (8 * sizeof(unsigned long)))
+
+/* Bind page aligned part of memory range with given policy */
+static void env_numa_mbind(void *ptr, size_t size, int mode,
+		const unsigned long *nodes)
+{
+	uintptr_t page = sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t)ptr + page - 1) & ~(page - 1);
+	uintptr_t end = ((uintptr_t)ptr + size) & ~(page - 1);
+
+	if (start >= end)
+		return;
+
+	syscall(SYS_mbind, start, end - start, mode, nodes,
+			ENV_NUMA_MAX_NODES, 0);
+}
+
+void *env_zalloc_node(size_t size, int flags, int node)
+{
+	unsigned long nodes[ENV_NUMA_MASK_WORDS] = { 0 };
+	size_t page = sysconf(_SC_PAGESIZE);
+	void *ptr;
+
+	if (node < 0 || node >= ENV_NUMA_MAX_NODES)
+		return env_zalloc(size, flags);
+
+	/* Memory policy applies to whole pages, so don't share them */
+	size = (size + page - 1) & ~(page - 1);
+	if (posix_memalign(&ptr, page, size))
+		return NULL;
+
+	nodes[node / (8 * sizeof(nodes[0]))] |=
+			1UL << (node % (8 * sizeof(nodes[0])));
+	env_numa_mbind(ptr, size, MPOL_PREFERRED, nodes);
+
+	memset(ptr, 0, size);
+
+	return ptr;
+}
+
+void env_numa_interleave(void *ptr, size_t size)
+{
+	unsigned long nodes[ENV_NUMA_MASK_WORDS] = { 0 };
+	int count = 0, i;
+
+	if (syscall(SYS_get_mempolicy, NULL, nodes, ENV_NUMA_MAX_NODES,
+			NULL, MPOL_F_MEMS_ALLOWED)) {
+		return;
+	}
+
+	for (i = 0; i < ENV_NUMA_MASK_WORDS; i++)
+		count += __builtin_popcountl(nodes[i]);
+
+	if (count > 1)
+		env_numa_mbind(ptr, size, MPOL_INTERLEAVE, nodes);
+}
+
+int env_get_numa_node_count(void)
+{
+	unsigned long nodes[ENV_NUMA_MASK_WORDS] = { 0 };
+	int i;
+
+	if (syscall(SYS_get_mempolicy, NULL, nodes, ENV_NUMA_MAX_NODES,
+			NULL, MPOL_F_MEMS_ALLOWED)) {
+		return 1;
+	}
+
+	for (i = ENV_NUMA_MASK_WORDS - 1; i >= 0; i--) {
+		if (nodes[i]) {
+			return i * 8 * sizeof(nodes[0]) + 8 * sizeof(nodes[0]) -
+					__builtin_clzl(nodes[i]);
+		}
+	}
+
+	return 1;
+}
+
+int env_numa_node_query(void)
+{
+	unsigned int cpu, node;
+
+	if (syscall(SYS_getcpu, &cpu, &node, NULL))
+		return 0;
+
+	return node;
+}
+
 void env_stack_trace(void)
 {
 	void *trace[ENV_TRACE_DEPTH];
@@ -140,3 +603,105 @@ uint32_t env_crc32(uint32_t crc, uint8_t const *data, size_t len)
 {
 	return crc32(crc, data, len);
 }
+
+/* CRC32C (Castagnoli), reflected polynomial */
+#define ENV_CRC32C_POLY 0x82F63B78U
+
+static uint32_t env_crc32c_table[256];
+static pthread_once_t env_crc32c_table_once = PTHREAD_ONCE_INIT;
+
+static void env_crc32c_table_init(void)
+{
+	uint32_t i, j, crc;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (ENV_CRC32C_POLY & -(crc & 1));
+		env_crc32c_table[i] = crc;
+	}
+}
+
+static uint32_t env_crc32c_sw(uint32_t crc, uint8_t const *data, size_t len)
+{
+	pthread_once(&env_crc32c_table_once, env_crc32c_table_init);
+
+	while (len--)
+		crc = (crc >> 8) ^ env_crc32c_table[(crc ^ *data++) & 0xFF];
+
+	return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t env_crc32c_hw(uint32_t crc, uint8_t const *data, size_t len)
+{
+	uint64_t crc64 = crc, word;
+
+	for (; len >= sizeof(word); len -= sizeof(word)) {
+		memcpy(&word, data, sizeof(word));
+		crc64 = __builtin_ia32_crc32di(crc64, word);
+		data += sizeof(word);
+	}
+
+	crc = crc64;
+	while (len--)
+		crc = __builtin_ia32_crc32qi(crc, *data++);
+
+	return crc;
+}
+
+static bool env_crc32c_hw_supported(void)
+{
+	return __builtin_cpu_supports("sse4.2");
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+
+static uint32_t env_crc32c_hw(uint32_t crc, uint8_t const *data, size_t len)
+{
+	uint64_t word;
+
+	for (; len >= sizeof(word); len -= sizeof(word)) {
+		memcpy(&word, data, sizeof(word));
+		crc = __crc32cd(crc, word);
+		data += sizeof(word);
+	}
+
+	while (len--)
+		crc = __crc32cb(crc, *data++);
+
+	return crc;
+}
+
+static bool env_crc32c_hw_supported(void)
+{
+	return true;
+}
+#else
+static uint32_t env_crc32c_hw(uint32_t crc, uint8_t const *data, size_t len)
+{
+	return env_crc32c_sw(crc, data, len);
+}
+
+static bool env_crc32c_hw_supported(void)
+{
+	return false;
+}
+#endif
+
+/* Same calling convention as env_crc32(), crc of previous chunk is passed
+ * to continue checksum */
+uint32_t env_crc32c(uint32_t crc, uint8_t const *data, size_t len)
+{
+	static int hw = -1;
+
+	if (hw < 0)
+		hw = env_crc32c_hw_supported();
+
+	crc = ~crc;
+	crc = hw ? env_crc32c_hw(crc, data, len) :
+		env_crc32c_sw(crc, data, len);
+
+	return ~crc;
+}
@@ -30,6 +30,7 @@
 #include <unistd.h>
 #include <inttypes.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/param.h>
 #include <zlib.h>
 
@@ -99,6 +100,80 @@ static inline void env_vfree(const void *ptr)
 	free((void *)ptr);
 }
 
+/*
+ * Allocate zeroed memory backed by huge pages. Returns NULL when huge pages
+ * are not available, so that caller can fall back to env_vzalloc().
+ * Memory has to be freed with env_vfree_huge() with the same size.
+ */
+void *env_vzalloc_huge(size_t size);
+
+void env_vfree_huge(void *ptr, size_t size);
+
+/*
+ * Allocate zeroed memory preferably placed on given NUMA node, negative node
+ * means no preference. Memory has to be freed with env_free().
+ */
+void *env_zalloc_node(size_t size, int flags, int node);
+
+/*
+ * Spread pages of memory, which wasn't touched yet, over all NUMA nodes.
+ * This is only a hint, memory is usable regardless of the result.
+ */
+void env_numa_interleave(void *ptr, size_t size);
+
+/*
+ * Number of NUMA nodes memory may be allocated on, counted up to the highest
+ * allowed node. Returns 1 if it can't be determined.
+ */
+int env_get_numa_node_count(void);
+
+/* Query NUMA node of CPU calling thread runs on, 0 if unknown */
+int env_numa_node_query(void);
+
+/* Number of calls after which cached NUMA node of thread is queried again */
+#define ENV_NUMA_NODE_REFRESH 1024
+
+/*
+ * NUMA node of CPU calling thread runs on. It is cached per thread and
+ * refreshed periodically, so it may be stale shortly after migration and
+ * should be used only as placement hint.
+ */
+static inline int env_get_numa_node(void)
+{
+	static __thread int node;
+	static __thread uint32_t calls;
+
+	if (unlikely(!(calls++ % ENV_NUMA_NODE_REFRESH)))
+		node = env_numa_node_query();
+
+	return node;
+}
+
+/*
+ * Make stores to byte addressable persistent memory durable, by writing back
+ * CPU cache lines of given range and ordering it with subsequent stores
+ */
+static inline void env_pmem_persist(const void *addr, size_t size)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	uintptr_t line = (uintptr_t)addr & ~(uintptr_t)63;
+	uintptr_t end = (uintptr_t)addr + size;
+
+	for (; line < end; line += 64)
+		__builtin_ia32_clflush((const void *)line);
+
+	__builtin_ia32_sfence();
+#else
+	__sync_synchronize();
+#endif
+}
+
+/* Hint that memory at given address will be read soon */
+static inline void env_prefetch(const void *addr)
+{
+	__builtin_prefetch(addr, 0, 3);
+}
+
 static inline uint64_t env_get_free_memory(void)
 {
 	return sysconf(_SC_PAGESIZE) * sysconf(_SC_AVPHYS_PAGES);
@@ -200,68 +275,6 @@ static inline int env_rmutex_is_locked(env_rmutex *rmutex)
 	return env_mutex_is_locked(rmutex);
 }
 
-/* *** RW SEMAPHORE *** */
-typedef struct {
-	 pthread_rwlock_t lock;
-} env_rwsem;
-
-static inline int env_rwsem_init(env_rwsem *s)
-{
-	return pthread_rwlock_init(&s->lock, NULL);
-}
-
-static inline void env_rwsem_up_read(env_rwsem *s)
-{
-	pthread_rwlock_unlock(&s->lock);
-}
-
-static inline void env_rwsem_down_read(env_rwsem *s)
-{
-	pthread_rwlock_rdlock(&s->lock);
-}
-
-static inline int env_rwsem_down_read_trylock(env_rwsem *s)
-{
-	return pthread_rwlock_tryrdlock(&s->lock) ? -OCF_ERR_NO_LOCK : 0;
-}
-
-static inline void env_rwsem_up_write(env_rwsem *s)
-{
-	pthread_rwlock_unlock(&s->lock);
-}
-
-static inline void env_rwsem_down_write(env_rwsem *s)
-{
-	pthread_rwlock_wrlock(&s->lock);
-}
-
-static inline int env_rwsem_down_write_trylock(env_rwsem *s)
-{
-	return pthread_rwlock_trywrlock(&s->lock) ? -OCF_ERR_NO_LOCK : 0;
-}
-
-static inline int env_rwsem_is_locked(env_rwsem *s)
-{
-	if (env_rwsem_down_read_trylock(s) == 0) {
-		env_rwsem_up_read(s);
-		return 0;
-	}
-
-	return 1;
-}
-
-static inline int env_rwsem_down_write_interruptible(env_rwsem *s)
-{
-	env_rwsem_down_write(s);
-	return 0;
-}
-
-static inline int env_rwsem_down_read_interruptible(env_rwsem *s)
-{
-	env_rwsem_down_read(s);
-	return 0;
-}
-
 /* *** COMPLETION *** */
 struct completion {
 	sem_t sem;
@@ -425,6 +438,107 @@ static inline long env_atomic64_cmpxchg(env_atomic64 *a, long old, long new)
 	return __sync_val_compare_and_swap(&a->counter, old, new);
 }
 
+/* *** RW SEMAPHORE *** */
+
+/*
+ * Reader-writer semaphore preferring writers, as kernel one does - readers
+ * don't enter while any writer waits. Contended lockers spin for a while
+ * before parking on futex.
+ */
+#define ENV_RWSEM_WRITER	(1 << 30)
+
+typedef struct {
+	/*!< Number of readers holding semaphore or ENV_RWSEM_WRITER */
+	env_atomic state;
+
+	/*!< Number of writers waiting for semaphore */
+	env_atomic writers;
+
+	/*!< Number of parked lockers */
+	env_atomic sleepers;
+
+	/*!< Futex word changed on every release waking parked lockers */
+	env_atomic seq;
+} env_rwsem;
+
+void __env_rwsem_down_read(env_rwsem *s);
+
+void __env_rwsem_down_write(env_rwsem *s);
+
+void __env_rwsem_wake(env_rwsem *s);
+
+static inline int env_rwsem_init(env_rwsem *s)
+{
+	env_atomic_set(&s->state, 0);
+	env_atomic_set(&s->writers, 0);
+	env_atomic_set(&s->sleepers, 0);
+	env_atomic_set(&s->seq, 0);
+	return 0;
+}
+
+static inline int env_rwsem_down_read_trylock(env_rwsem *s)
+{
+	int state;
+
+	do {
+		state = env_atomic_read(&s->state);
+		if ((state & ENV_RWSEM_WRITER) || env_atomic_read(&s->writers))
+			return -OCF_ERR_NO_LOCK;
+	} while (env_atomic_cmpxchg(&s->state, state, state + 1) != state);
+
+	return 0;
+}
+
+static inline void env_rwsem_down_read(env_rwsem *s)
+{
+	if (env_rwsem_down_read_trylock(s))
+		__env_rwsem_down_read(s);
+}
+
+static inline void env_rwsem_up_read(env_rwsem *s)
+{
+	if (env_atomic_dec_return(&s->state) == 0 &&
+			env_atomic_read(&s->sleepers)) {
+		__env_rwsem_wake(s);
+	}
+}
+
+static inline int env_rwsem_down_write_trylock(env_rwsem *s)
+{
+	return env_atomic_cmpxchg(&s->state, 0, ENV_RWSEM_WRITER) ?
+			-OCF_ERR_NO_LOCK : 0;
+}
+
+static inline void env_rwsem_down_write(env_rwsem *s)
+{
+	if (env_rwsem_down_write_trylock(s))
+		__env_rwsem_down_write(s);
+}
+
+static inline void env_rwsem_up_write(env_rwsem *s)
+{
+	env_atomic_sub(ENV_RWSEM_WRITER, &s->state);
+	if (env_atomic_read(&s->sleepers))
+		__env_rwsem_wake(s);
+}
+
+static inline int env_rwsem_is_locked(env_rwsem *s)
+{
+	return !!env_atomic_read(&s->state);
+}
+
+static inline int env_rwsem_down_write_interruptible(env_rwsem *s)
+{
+	env_rwsem_down_write(s);
+	return 0;
+}
+
+static inline int env_rwsem_down_read_interruptible(env_rwsem *s)
+{
+	env_rwsem_down_read(s);
+	return 0;
+}
+
 /* *** SPIN LOCKS *** */
 
 typedef struct {
@@ -495,6 +609,16 @@ static inline void env_rwlock_write_unlock(env_rwlock *l)
 	pthread_rwlock_unlock(&l->lock);
 }
 
+static inline int env_rwlock_read_trylock(env_rwlock *l)
+{
+	return pthread_rwlock_tryrdlock(&l->lock) ? -OCF_ERR_NO_LOCK : 0;
+}
+
+static inline int env_rwlock_write_trylock(env_rwlock *l)
+{
+	return pthread_rwlock_trywrlock(&l->lock) ? -OCF_ERR_NO_LOCK : 0;
+}
+
 /* *** WAITQUEUE *** */
 
 typedef struct {
@@ -552,36 +676,50 @@ static inline void env_schedule(void)
 	sched_yield();
 }
 
+static inline void env_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#else
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
 static inline int env_in_interrupt(void)
 {
 	return 0;
 }
 
+/*
+ * Ticks are nanoseconds of monotonic clock, which is served from vDSO without
+ * syscall and isn't affected by wall clock adjustments
+ */
 static inline uint64_t env_get_tick_count(void)
 {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	return tv.tv_sec * 1000000 + tv.tv_usec;
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
 }
 
 static inline uint64_t env_ticks_to_nsecs(uint64_t j)
 {
-	return j * 1000;
+	return j;
 }
 
 static inline uint64_t env_ticks_to_msecs(uint64_t j)
 {
-	return j / 1000;
+	return j / 1000000;
 }
 
 static inline uint64_t env_ticks_to_secs(uint64_t j)
 {
-	return j / 1000000;
+	return j / 1000000000;
 }
 
 static inline uint64_t env_secs_to_ticks(uint64_t j)
 {
-	return j * 1000000;
+	return j * 1000000000;
 }
 
 /* *** SORTING *** */
@@ -647,6 +785,8 @@ static inline void env_gettimeofday(struct env_timeval *tv)
 
 uint32_t env_crc32(uint32_t crc, uint8_t const *data, size_t len);
 
+uint32_t env_crc32c(uint32_t crc, uint8_t const *data, size_t len);
+
 #define ENV_PRIu64 "lu"
 
 #endif /* __OCF_ENV_H__ */
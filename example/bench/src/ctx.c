@@ -0,0 +1,442 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <ocf/ocf.h>
+#include "ocf_env.h"
+#include "data.h"
+#include "volume.h"
+#include "queue.h"
+#include "ctx.h"
+
+#define PAGE_SIZE 4096
+
+/*
+ * Allocate structure representing data for io operations.
+ */
+ctx_data_t *ctx_data_alloc(uint32_t pages)
+{
+	struct volume_data *data;
+
+	data = malloc(sizeof(*data));
+	data->ptr = malloc(pages * PAGE_SIZE);
+	data->offset = 0;
+
+	return data;
+}
+
+/*
+ * Free data structure.
+ */
+void ctx_data_free(ctx_data_t *ctx_data)
+{
+	struct volume_data *data = ctx_data;
+
+	if (!data)
+		return;
+
+	free(data->ptr);
+	free(data);
+}
+
+/*
+ * This function is supposed to set protection of data pages against swapping.
+ * Can be non-implemented if not needed.
+ */
+static int ctx_data_mlock(ctx_data_t *ctx_data)
+{
+	return 0;
+}
+
+/*
+ * Stop protecting data pages against swapping.
+ */
+static void ctx_data_munlock(ctx_data_t *ctx_data)
+{
+}
+
+/*
+ * Read data into flat memory buffer.
+ */
+static uint32_t ctx_data_read(void *dst, ctx_data_t *src, uint32_t size)
+{
+	struct volume_data *data = src;
+
+	memcpy(dst, data->ptr + data->offset, size);
+
+	return size;
+}
+
+/*
+ * Write data from flat memory buffer.
+ */
+static uint32_t ctx_data_write(ctx_data_t *dst, const void *src, uint32_t size)
+{
+	struct volume_data *data = dst;
+
+	memcpy(data->ptr + data->offset, src, size);
+
+	return size;
+}
+
+/*
+ * Fill data with zeros.
+ */
+static uint32_t ctx_data_zero(ctx_data_t *dst, uint32_t size)
+{
+	struct volume_data *data = dst;
+
+	memset(data->ptr + data->offset, 0, size);
+
+	return size;
+}
+
+/*
+ * Perform seek operation on data.
+ */
+static uint32_t ctx_data_seek(ctx_data_t *dst, ctx_data_seek_t seek,
+		uint32_t offset)
+{
+	struct volume_data *data = dst;
+
+	switch (seek) {
+	case ctx_data_seek_begin:
+		data->offset = offset;
+		break;
+	case ctx_data_seek_current:
+		data->offset += offset;
+		break;
+	}
+
+	return offset;
+}
+
+/*
+ * Copy data from one structure to another.
+ */
+static uint64_t ctx_data_copy(ctx_data_t *dst, ctx_data_t *src,
+		uint64_t to, uint64_t from, uint64_t bytes)
+{
+	struct volume_data *data_dst = dst;
+	struct volume_data *data_src = src;
+
+	memcpy(data_dst->ptr + to, data_src->ptr + from, bytes);
+
+	return bytes;
+}
+
+/*
+ * Perform secure erase of data (e.g. fill pages with zeros).
+ * Can be left non-implemented if not needed.
+ */
+static void ctx_data_secure_erase(ctx_data_t *ctx_data)
+{
+}
+
+struct cleaner_thread {
+	ocf_cleaner_t cleaner;
+	ocf_queue_t queue;
+	pthread_t thread;
+	sem_t done;
+	sem_t wake;
+	uint32_t interval;
+	bool stop;
+};
+
+/*
+ * Cleaner completion passes time to sleep before next cleaner run.
+ */
+static void ctx_cleaner_end(ocf_cleaner_t c, uint32_t interval)
+{
+	struct cleaner_thread *ct = ocf_cleaner_get_priv(c);
+
+	ct->interval = interval;
+	sem_post(&ct->done);
+}
+
+/*
+ * Cleaner thread runs cleaner, waits for it to finish and then sleeps for
+ * requested interval, unless it is stopped meanwhile.
+ */
+static void *ctx_cleaner_thread_run(void *arg)
+{
+	struct cleaner_thread *ct = arg;
+	struct timespec ts;
+
+	while (!ct->stop) {
+		ocf_cleaner_run(ct->cleaner, ct->queue);
+		sem_wait(&ct->done);
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += ct->interval / 1000;
+		ts.tv_nsec += (ct->interval % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+		sem_timedwait(&ct->wake, &ts);
+	}
+
+	return NULL;
+}
+
+/*
+ * Initialize cleaner thread. Each cleaner instance gets its own thread and
+ * queue, so that cleaning doesn't delay benchmark I/O handling.
+ */
+static int ctx_cleaner_init(ocf_cleaner_t c)
+{
+	struct cleaner_thread *ct;
+	int ret;
+
+	ct = calloc(1, sizeof(*ct));
+	if (!ct)
+		return -ENOMEM;
+
+	ret = queue_create(ocf_cleaner_get_cache(c), &ct->queue);
+	if (ret) {
+		free(ct);
+		return ret;
+	}
+
+	ct->cleaner = c;
+	sem_init(&ct->done, 0, 0);
+	sem_init(&ct->wake, 0, 0);
+	ocf_cleaner_set_priv(c, ct);
+	ocf_cleaner_set_cmpl(c, ctx_cleaner_end);
+
+	ret = pthread_create(&ct->thread, NULL, ctx_cleaner_thread_run, ct);
+	if (ret) {
+		ocf_cleaner_set_priv(c, NULL);
+		ocf_queue_put(ct->queue);
+		sem_destroy(&ct->wake);
+		sem_destroy(&ct->done);
+		free(ct);
+		return -ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Stop cleaner thread. Cleaner run in progress is completed first.
+ */
+static void ctx_cleaner_stop(ocf_cleaner_t c)
+{
+	struct cleaner_thread *ct = ocf_cleaner_get_priv(c);
+
+	if (!ct)
+		return;
+
+	ct->stop = true;
+	sem_post(&ct->wake);
+	pthread_join(ct->thread, NULL);
+
+	/* Queue is released with other I/O queues when cache is stopped */
+	sem_destroy(&ct->wake);
+	sem_destroy(&ct->done);
+	free(ct);
+}
+
+struct metadata_updater_thread {
+	ocf_metadata_updater_t mu;
+	pthread_t thread;
+	sem_t sem;
+	bool stop;
+};
+
+/*
+ * Metadata updater thread runs metadata updater each time it is kicked,
+ * until there is no more work to do.
+ */
+static void *ctx_metadata_updater_thread_run(void *arg)
+{
+	struct metadata_updater_thread *mt = arg;
+
+	while (true) {
+		sem_wait(&mt->sem);
+		if (mt->stop)
+			break;
+		while (ocf_metadata_updater_run(mt->mu))
+			;
+	}
+
+	return NULL;
+}
+
+/*
+ * Initialize metadata updater thread.
+ */
+static int ctx_metadata_updater_init(ocf_metadata_updater_t mu)
+{
+	struct metadata_updater_thread *mt;
+	int ret;
+
+	mt = calloc(1, sizeof(*mt));
+	if (!mt)
+		return -ENOMEM;
+
+	mt->mu = mu;
+	sem_init(&mt->sem, 0, 0);
+	ocf_metadata_updater_set_priv(mu, mt);
+
+	ret = pthread_create(&mt->thread, NULL,
+			ctx_metadata_updater_thread_run, mt);
+	if (ret) {
+		ocf_metadata_updater_set_priv(mu, NULL);
+		sem_destroy(&mt->sem);
+		free(mt);
+		return -ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Kick metadata updater thread.
+ */
+static void ctx_metadata_updater_kick(ocf_metadata_updater_t mu)
+{
+	struct metadata_updater_thread *mt = ocf_metadata_updater_get_priv(mu);
+
+	sem_post(&mt->sem);
+}
+
+/*
+ * Stop metadata updater thread.
+ */
+static void ctx_metadata_updater_stop(ocf_metadata_updater_t mu)
+{
+	struct metadata_updater_thread *mt = ocf_metadata_updater_get_priv(mu);
+
+	if (!mt)
+		return;
+
+	mt->stop = true;
+	sem_post(&mt->sem);
+	pthread_join(mt->thread, NULL);
+
+	sem_destroy(&mt->sem);
+	free(mt);
+}
+
+/*
+ * Function prividing interface for printing to log used by OCF internals.
+ * It can handle differently messages at varous log levels.
+ */
+static int ctx_logger_printf(ocf_logger_t logger, ocf_logger_lvl_t lvl,
+		const char *fmt, va_list args)
+{
+	FILE *lfile = stdout;
+
+	if (lvl > log_info)
+		return 0;
+
+	if (lvl <= log_warn)
+		lfile = stderr;
+
+	return vfprintf(lfile, fmt, args);
+}
+
+#define CTX_LOG_TRACE_DEPTH	16
+
+/*
+ * Function prividing interface for printing current stack. Used for debugging,
+ * and for providing additional information in log in case of errors.
+ */
+static int ctx_logger_dump_stack(ocf_logger_t logger)
+{
+	void *trace[CTX_LOG_TRACE_DEPTH];
+	char **messages = NULL;
+	int i, size;
+
+	size = backtrace(trace, CTX_LOG_TRACE_DEPTH);
+	messages = backtrace_symbols(trace, size);
+	printf("[stack trace]>>>\n");
+	for (i = 0; i < size; ++i)
+		printf("%s\n", messages[i]);
+	printf("<<<[stack trace]\n");
+	free(messages);
+
+	return 0;
+}
+
+/*
+ * This structure describes context config, containing simple context info
+ * and pointers to ops callbacks. Ops are splitted into few categories:
+ * - data ops, providing context specific data handing interface,
+ * - cleaner ops, providing interface to start and stop cleaner thread,
+ * - metadata updater ops, providing interface for starting, stoping
+ *   and kicking metadata updater thread.
+ * - logger ops, providing interface for text message logging
+ */
+static const struct ocf_ctx_config ctx_cfg = {
+	.name = "OCF Bench",
+	.ops = {
+		.data = {
+			.alloc = ctx_data_alloc,
+			.free = ctx_data_free,
+			.mlock = ctx_data_mlock,
+			.munlock = ctx_data_munlock,
+			.read = ctx_data_read,
+			.write = ctx_data_write,
+			.zero = ctx_data_zero,
+			.seek = ctx_data_seek,
+			.copy = ctx_data_copy,
+			.secure_erase = ctx_data_secure_erase,
+		},
+
+		.cleaner = {
+			.init = ctx_cleaner_init,
+			.stop = ctx_cleaner_stop,
+		},
+
+		.metadata_updater = {
+			.init = ctx_metadata_updater_init,
+			.kick = ctx_metadata_updater_kick,
+			.stop = ctx_metadata_updater_stop,
+		},
+
+		.logger = {
+			.printf = ctx_logger_printf,
+			.dump_stack = ctx_logger_dump_stack,
+		},
+	},
+};
+
+
+/*
+ * Function initializing context. Prepares context, sets logger and
+ * registers volume type.
+ */
+int ctx_init(ocf_ctx_t *ctx)
+{
+	int ret;
+
+	ret = ocf_ctx_init(ctx, &ctx_cfg);
+	if (ret)
+		return ret;
+
+	ret = volume_init(*ctx);
+	if (ret) {
+		ocf_ctx_exit(*ctx);
+		return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Function cleaning up context. Unregisters volume type and
+ * deinitializes context.
+ */
+void ctx_cleanup(ocf_ctx_t ctx)
+{
+	volume_cleanup(ctx);
+	ocf_ctx_exit(ctx);
+}
@@ -0,0 +1,915 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Benchmark tool. It runs synthetic workload through cache backed by RAM or
+ * null volumes from number of jobs, each submitting I/O to its own queue
+ * served by separate thread, and reports throughput, latency percentiles
+ * and hit ratio. Null volumes with no latency complete I/O without touching
+ * data, so that only CPU cost of OCF is measured.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#include <ocf/ocf.h>
+#include "data.h"
+#include "ctx.h"
+#include "queue.h"
+#include "volume.h"
+
+#define PAGE_SIZE 4096
+
+/* Latency histogram with 8 linear buckets per power of two */
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 << HIST_SUB_BITS)
+
+enum bench_op {
+	bench_op_read,
+	bench_op_write,
+	bench_op_max,
+};
+
+static const char *bench_op_name[bench_op_max] = {
+	[bench_op_read] = "read",
+	[bench_op_write] = "write",
+};
+
+struct latency_hist {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t buckets[HIST_BUCKETS];
+};
+
+struct bench_config {
+	uint64_t cache_size;
+	uint64_t core_size;
+	ocf_cache_line_size_t cache_line_size;
+	ocf_cache_mode_t cache_mode;
+	bool cache_ram;
+	bool core_ram;
+	uint32_t cache_latency_us;
+	uint32_t core_latency_us;
+	uint32_t jobs;
+	uint32_t queue_depth;
+		/*!< I/Os in flight per job */
+	uint32_t block_size;
+	uint32_t write_pct;
+	bool sequential;
+	double zipf_theta;
+		/*!< Skew of block popularity, 0 for uniform random access */
+	uint32_t runtime;
+	uint32_t warmup;
+};
+
+/*
+ * Zipfian distribution of block ranks, generated as described in "Quickly
+ * Generating Billion-Record Synthetic Databases" by Gray et al.
+ */
+struct zipf {
+	uint64_t n;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+};
+
+struct bench_job;
+
+struct bench_slot {
+	struct bench_job *job;
+	struct volume_data *data;
+	uint64_t start_ns;
+	enum bench_op op;
+	bool record;
+		/*!< I/O was submitted in measured part of run */
+};
+
+struct bench_job {
+	struct bench *bench;
+	uint32_t id;
+	ocf_queue_t queue;
+	pthread_t thread;
+	bool started;
+
+	uint64_t rng;
+	uint64_t next_block;
+		/*!< Next block of sequential workload */
+
+	/* Free I/O slots, bounding queue depth */
+	pthread_mutex_t lock;
+	sem_t free_sem;
+	struct bench_slot **free;
+	uint32_t free_count;
+	struct bench_slot *slots;
+
+	struct latency_hist hist[bench_op_max];
+	uint64_t bytes[bench_op_max];
+	uint64_t errors;
+};
+
+struct bench {
+	struct bench_config cfg;
+	struct zipf zipf;
+	uint64_t blocks;
+		/*!< Number of blocks of core */
+
+	ocf_ctx_t ctx;
+	ocf_cache_t cache;
+	ocf_queue_t mngt_queue;
+	ocf_core_t core;
+
+	struct bench_job *jobs;
+
+	bool recording;
+	bool stop;
+};
+
+/*
+ * Simple context for synchronous waiting on completion of management
+ * operations.
+ */
+struct mngt_wait {
+	sem_t sem;
+	ocf_core_t core;
+	int error;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned hist_bucket(uint64_t ns)
+{
+	unsigned msb;
+
+	if (ns < HIST_SUB)
+		return ns;
+
+	msb = 63 - __builtin_clzll(ns);
+
+	return ((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) |
+		((ns >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+static uint64_t hist_bucket_value(unsigned bucket)
+{
+	unsigned msb;
+
+	if (bucket < HIST_SUB)
+		return bucket;
+
+	msb = (bucket >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+
+	return (uint64_t)(HIST_SUB | (bucket & (HIST_SUB - 1))) <<
+		(msb - HIST_SUB_BITS);
+}
+
+static uint64_t hist_percentile(const struct latency_hist *hist,
+		double percentile)
+{
+	uint64_t target, seen = 0;
+	unsigned i;
+
+	target = hist->count * percentile / 100;
+	if (target >= hist->count)
+		target = hist->count - 1;
+
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen > target)
+			return hist_bucket_value(i);
+	}
+
+	return hist->max_ns;
+}
+
+static void hist_merge(struct latency_hist *dst,
+		const struct latency_hist *src)
+{
+	unsigned i;
+
+	dst->count += src->count;
+	dst->total_ns += src->total_ns;
+	if (src->max_ns > dst->max_ns)
+		dst->max_ns = src->max_ns;
+	for (i = 0; i < HIST_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+}
+
+/*
+ * Per job xorshift64* generator, so that jobs don't contend on shared
+ * random state.
+ */
+static uint64_t rng_next(uint64_t *state)
+{
+	uint64_t x = *state;
+
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double rng_double(uint64_t *state)
+{
+	return (rng_next(state) >> 11) * (1.0 / (1ULL << 53));
+}
+
+static double zeta(uint64_t n, double theta)
+{
+	double sum = 0;
+	uint64_t i;
+
+	for (i = 1; i <= n; i++)
+		sum += 1 / pow(i, theta);
+
+	return sum;
+}
+
+static void zipf_init(struct zipf *zipf, uint64_t n, double theta)
+{
+	zipf->n = n;
+	zipf->theta = theta;
+	zipf->alpha = 1 / (1 - theta);
+	zipf->zetan = zeta(n, theta);
+	zipf->eta = (1 - pow(2.0 / n, 1 - theta)) /
+		(1 - zeta(2, theta) / zipf->zetan);
+}
+
+static uint64_t zipf_next(const struct zipf *zipf, uint64_t *rng)
+{
+	double u = rng_double(rng);
+	double uz = u * zipf->zetan;
+	uint64_t rank;
+
+	if (uz < 1)
+		return 0;
+
+	if (uz < 1 + pow(0.5, zipf->theta))
+		return 1;
+
+	rank = zipf->n * pow(zipf->eta * u - zipf->eta + 1, zipf->alpha);
+
+	return rank < zipf->n ? rank : zipf->n - 1;
+}
+
+/*
+ * Pick block of next I/O. Zipfian ranks are spread over whole core, so
+ * that hot blocks don't form single contiguous range.
+ */
+static uint64_t bench_next_block(struct bench_job *job)
+{
+	struct bench *bench = job->bench;
+	uint64_t block;
+
+	if (bench->cfg.sequential) {
+		block = job->next_block;
+		job->next_block = (block + 1) % bench->blocks;
+		return block;
+	}
+
+	if (bench->cfg.zipf_theta) {
+		block = zipf_next(&bench->zipf, &job->rng);
+		return (block * 0x9E3779B97F4A7C15ULL) % bench->blocks;
+	}
+
+	return rng_next(&job->rng) % bench->blocks;
+}
+
+static void mngt_wait_init(struct mngt_wait *wait)
+{
+	sem_init(&wait->sem, 0, 0);
+	wait->core = NULL;
+	wait->error = 0;
+}
+
+static int mngt_wait_finish(struct mngt_wait *wait)
+{
+	sem_wait(&wait->sem);
+	sem_destroy(&wait->sem);
+
+	return wait->error;
+}
+
+static void mngt_cache_cmpl(ocf_cache_t cache, void *priv, int error)
+{
+	struct mngt_wait *wait = priv;
+
+	wait->error = error;
+	sem_post(&wait->sem);
+}
+
+static void mngt_core_cmpl(ocf_cache_t cache, ocf_core_t core, void *priv,
+		int error)
+{
+	struct mngt_wait *wait = priv;
+
+	wait->core = core;
+	wait->error = error;
+	sem_post(&wait->sem);
+}
+
+/*
+ * Stop cache, which has to be locked by caller.
+ */
+static void bench_stop_cache(struct bench *bench)
+{
+	struct mngt_wait wait;
+
+	mngt_wait_init(&wait);
+	ocf_mngt_cache_stop(bench->cache, mngt_cache_cmpl, &wait);
+	if (mngt_wait_finish(&wait))
+		printf("Failed to stop cache\n");
+
+	if (bench->mngt_queue)
+		queue_sync(bench->mngt_queue);
+}
+
+/*
+ * Start cache, attach it to RAM or null volume and create I/O queue for
+ * each job.
+ */
+static int bench_start_cache(struct bench *bench)
+{
+	struct ocf_mngt_cache_config cache_cfg = { };
+	struct ocf_mngt_cache_device_config device_cfg = { };
+	struct mngt_wait wait;
+	char uuid[VOLUME_UUID_MAX];
+	uint32_t i;
+	int ret;
+
+	cache_cfg.id = OCF_CACHE_ID_INVALID;
+	cache_cfg.name = "bench";
+	cache_cfg.cache_mode = bench->cfg.cache_mode;
+	cache_cfg.cache_line_size = bench->cfg.cache_line_size;
+	cache_cfg.backfill.max_queue_size = 65536;
+	cache_cfg.backfill.queue_unblock_size = 60000;
+	cache_cfg.locked = true;
+
+	ret = ocf_mngt_cache_start(bench->ctx, &bench->cache, &cache_cfg);
+	if (ret)
+		return ret;
+
+	ret = queue_create(bench->cache, &bench->mngt_queue);
+	if (ret)
+		goto err_stop;
+
+	ocf_mngt_cache_set_mngt_queue(bench->cache, bench->mngt_queue);
+
+	for (i = 0; i < bench->cfg.jobs; i++) {
+		ret = queue_create(bench->cache, &bench->jobs[i].queue);
+		if (ret)
+			goto err_stop;
+	}
+
+	snprintf(uuid, sizeof(uuid), "%s:%llu:%u",
+			bench->cfg.cache_ram ? "ram" : "null",
+			(unsigned long long)bench->cfg.cache_size,
+			bench->cfg.cache_latency_us);
+
+	device_cfg.volume_type = VOL_TYPE;
+	device_cfg.cache_line_size = cache_cfg.cache_line_size;
+	device_cfg.force = true;
+	ret = ocf_uuid_set_str(&device_cfg.uuid, uuid);
+	if (ret)
+		goto err_stop;
+
+	mngt_wait_init(&wait);
+	ocf_mngt_cache_attach(bench->cache, &device_cfg, mngt_cache_cmpl,
+			&wait);
+	ret = mngt_wait_finish(&wait);
+	if (ret)
+		goto err_stop;
+
+	return 0;
+
+err_stop:
+	bench_stop_cache(bench);
+	return ret;
+}
+
+static int bench_add_core(struct bench *bench)
+{
+	struct ocf_mngt_core_config core_cfg = { };
+	struct mngt_wait wait;
+	char uuid[VOLUME_UUID_MAX];
+	int ret;
+
+	snprintf(uuid, sizeof(uuid), "%s:%llu:%u",
+			bench->cfg.core_ram ? "ram" : "null",
+			(unsigned long long)bench->cfg.core_size,
+			bench->cfg.core_latency_us);
+
+	core_cfg.volume_type = VOL_TYPE;
+	core_cfg.core_id = OCF_CORE_ID_INVALID;
+	core_cfg.name = "core";
+	ret = ocf_uuid_set_str(&core_cfg.uuid, uuid);
+	if (ret)
+		return ret;
+
+	mngt_wait_init(&wait);
+	ocf_mngt_cache_add_core(bench->cache, &core_cfg, mngt_core_cmpl,
+			&wait);
+	ret = mngt_wait_finish(&wait);
+	if (ret)
+		return ret;
+
+	bench->core = wait.core;
+
+	return 0;
+}
+
+static int bench_job_init(struct bench *bench, struct bench_job *job,
+		uint32_t id)
+{
+	uint32_t pages = (bench->cfg.block_size + PAGE_SIZE - 1) / PAGE_SIZE;
+	uint32_t i;
+
+	job->bench = bench;
+	job->id = id;
+	job->rng = 0x9E3779B97F4A7C15ULL * (id + 1);
+	/* Sequential jobs start at evenly spread offsets */
+	job->next_block = bench->blocks / bench->cfg.jobs * id;
+
+	job->slots = calloc(bench->cfg.queue_depth, sizeof(*job->slots));
+	job->free = calloc(bench->cfg.queue_depth, sizeof(*job->free));
+	if (!job->slots || !job->free)
+		return -ENOMEM;
+
+	for (i = 0; i < bench->cfg.queue_depth; i++) {
+		job->slots[i].job = job;
+		job->slots[i].data = ctx_data_alloc(pages);
+		if (!job->slots[i].data)
+			return -ENOMEM;
+		job->free[job->free_count++] = &job->slots[i];
+	}
+
+	pthread_mutex_init(&job->lock, NULL);
+	sem_init(&job->free_sem, 0, bench->cfg.queue_depth);
+
+	return 0;
+}
+
+static void bench_job_deinit(struct bench *bench, struct bench_job *job)
+{
+	uint32_t i;
+
+	if (job->slots) {
+		for (i = 0; i < bench->cfg.queue_depth; i++)
+			ctx_data_free(job->slots[i].data);
+	}
+
+	free(job->slots);
+	free(job->free);
+}
+
+static struct bench_slot *bench_slot_get(struct bench_job *job)
+{
+	struct bench_slot *slot;
+
+	sem_wait(&job->free_sem);
+
+	pthread_mutex_lock(&job->lock);
+	slot = job->free[--job->free_count];
+	pthread_mutex_unlock(&job->lock);
+
+	return slot;
+}
+
+static void bench_slot_put(struct bench_slot *slot, int error)
+{
+	struct bench_job *job = slot->job;
+	struct latency_hist *hist = &job->hist[slot->op];
+	uint64_t latency = now_ns() - slot->start_ns;
+
+	pthread_mutex_lock(&job->lock);
+	if (slot->record) {
+		hist->count++;
+		hist->total_ns += latency;
+		if (latency > hist->max_ns)
+			hist->max_ns = latency;
+		hist->buckets[hist_bucket(latency)]++;
+		job->bytes[slot->op] += job->bench->cfg.block_size;
+	}
+	if (error)
+		job->errors++;
+	job->free[job->free_count++] = slot;
+	pthread_mutex_unlock(&job->lock);
+
+	sem_post(&job->free_sem);
+}
+
+static void bench_io_cmpl(struct ocf_io *io, int error)
+{
+	struct bench_slot *slot = io->priv1;
+
+	ocf_io_put(io);
+	bench_slot_put(slot, error);
+}
+
+static void bench_submit(struct bench_job *job)
+{
+	struct bench *bench = job->bench;
+	struct bench_slot *slot;
+	struct ocf_io *io;
+	uint64_t addr;
+	uint32_t dir;
+
+	slot = bench_slot_get(job);
+
+	if (rng_next(&job->rng) % 100 < bench->cfg.write_pct) {
+		slot->op = bench_op_write;
+		dir = OCF_WRITE;
+	} else {
+		slot->op = bench_op_read;
+		dir = OCF_READ;
+	}
+
+	addr = bench_next_block(job) * bench->cfg.block_size;
+
+	slot->record = __atomic_load_n(&bench->recording, __ATOMIC_RELAXED);
+	slot->start_ns = now_ns();
+
+	io = ocf_core_new_io(bench->core);
+	if (!io) {
+		bench_slot_put(slot, -ENOMEM);
+		return;
+	}
+
+	ocf_io_configure(io, addr, bench->cfg.block_size, dir, 0, 0);
+	ocf_io_set_queue(io, job->queue);
+	ocf_io_set_cmpl(io, slot, NULL, bench_io_cmpl);
+
+	slot->data->offset = 0;
+	if (ocf_io_set_data(io, slot->data, 0)) {
+		ocf_io_put(io);
+		bench_slot_put(slot, -EINVAL);
+		return;
+	}
+
+	ocf_core_submit_io(io);
+}
+
+/*
+ * Job keeps its queue depth of I/Os in flight until run is stopped, and
+ * then waits for all of them to complete.
+ */
+static void *bench_job_run(void *arg)
+{
+	struct bench_job *job = arg;
+	struct bench *bench = job->bench;
+	uint32_t i;
+
+	while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED))
+		bench_submit(job);
+
+	for (i = 0; i < bench->cfg.queue_depth; i++)
+		sem_wait(&job->free_sem);
+
+	return NULL;
+}
+
+static uint64_t bench_run(struct bench *bench)
+{
+	uint64_t start_ns;
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < bench->cfg.jobs; i++) {
+		ret = pthread_create(&bench->jobs[i].thread, NULL,
+				bench_job_run, &bench->jobs[i]);
+		if (ret) {
+			printf("Unable to start job %u (%d)\n", i, ret);
+			__atomic_store_n(&bench->stop, true, __ATOMIC_RELAXED);
+			break;
+		}
+		bench->jobs[i].started = true;
+	}
+
+	if (bench->cfg.warmup && !bench->stop) {
+		sleep(bench->cfg.warmup);
+		ocf_core_stats_initialize(bench->core);
+	}
+
+	start_ns = now_ns();
+	__atomic_store_n(&bench->recording, true, __ATOMIC_RELAXED);
+
+	if (!bench->stop)
+		sleep(bench->cfg.runtime);
+
+	__atomic_store_n(&bench->stop, true, __ATOMIC_RELAXED);
+
+	for (i = 0; i < bench->cfg.jobs; i++) {
+		if (bench->jobs[i].started)
+			pthread_join(bench->jobs[i].thread, NULL);
+	}
+
+	return now_ns() - start_ns;
+}
+
+static void print_hit_ratio(const char *name, const struct ocf_stats_req *req)
+{
+	/* Total counts requests serviced by cache, without pass-through */
+	uint64_t hits = req->total - req->partial_miss - req->full_miss;
+	uint64_t cached = req->total;
+
+	printf("  %-6s requests %10llu  hits %10llu  partial misses %10llu  "
+			"full misses %10llu  pass-through %10llu",
+			name, (unsigned long long)(req->total +
+				req->pass_through),
+			(unsigned long long)hits,
+			(unsigned long long)req->partial_miss,
+			(unsigned long long)req->full_miss,
+			(unsigned long long)req->pass_through);
+	if (cached)
+		printf("  hit ratio %.2f%%", 100.0 * hits / cached);
+	printf("\n");
+}
+
+static void bench_report(struct bench *bench, uint64_t elapsed_ns)
+{
+	struct latency_hist hist[bench_op_max] = { };
+	uint64_t bytes[bench_op_max] = { };
+	struct ocf_cache_info info;
+	struct ocf_stats_core stats;
+	uint64_t ios = 0, total_bytes = 0, errors = 0;
+	double seconds = elapsed_ns / 1e9;
+	uint32_t i, j;
+
+	for (i = 0; i < bench->cfg.jobs; i++) {
+		struct bench_job *job = &bench->jobs[i];
+		uint64_t job_ios = 0;
+
+		for (j = 0; j < bench_op_max; j++) {
+			hist_merge(&hist[j], &job->hist[j]);
+			bytes[j] += job->bytes[j];
+			job_ios += job->hist[j].count;
+		}
+		errors += job->errors;
+
+		if (bench->cfg.jobs > 1) {
+			printf("Job %u: %.0f IOPS\n", i,
+					seconds ? job_ios / seconds : 0);
+		}
+	}
+
+	for (i = 0; i < bench_op_max; i++) {
+		ios += hist[i].count;
+		total_bytes += bytes[i];
+	}
+
+	printf("Completed %llu I/Os (%llu errors) in %.3f s: %.0f IOPS, "
+			"%.2f MiB/s\n", (unsigned long long)ios,
+			(unsigned long long)errors, seconds,
+			seconds ? ios / seconds : 0,
+			seconds ? total_bytes / seconds / (1 << 20) : 0);
+
+	printf("Latency [us]:\n");
+	for (i = 0; i < bench_op_max; i++) {
+		if (!hist[i].count)
+			continue;
+
+		printf("  %-6s count %10llu  avg %9.2f  p50 %9.2f  "
+				"p99 %9.2f  p99.9 %9.2f  max %9.2f\n",
+				bench_op_name[i],
+				(unsigned long long)hist[i].count,
+				hist[i].total_ns / 1e3 / hist[i].count,
+				hist_percentile(&hist[i], 50) / 1e3,
+				hist_percentile(&hist[i], 99) / 1e3,
+				hist_percentile(&hist[i], 99.9) / 1e3,
+				hist[i].max_ns / 1e3);
+	}
+
+	if (!ocf_cache_get_info(bench->cache, &info)) {
+		printf("Cache: %u lines, occupancy %u, dirty %u\n",
+				info.size, info.occupancy, info.dirty);
+	}
+
+	if (!ocf_core_get_stats(bench->core, &stats)) {
+		printf("Core:\n");
+		print_hit_ratio("read", &stats.read_reqs);
+		print_hit_ratio("write", &stats.write_reqs);
+	}
+}
+
+static int parse_cache_mode(const char *name, ocf_cache_mode_t *mode)
+{
+	static const char *names[ocf_cache_mode_max] = {
+		[ocf_cache_mode_wt] = "wt",
+		[ocf_cache_mode_wb] = "wb",
+		[ocf_cache_mode_wa] = "wa",
+		[ocf_cache_mode_pt] = "pt",
+		[ocf_cache_mode_wi] = "wi",
+	};
+	int i;
+
+	for (i = 0; i < ocf_cache_mode_max; i++) {
+		if (names[i] && !strcmp(name, names[i])) {
+			*mode = i;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+static void usage(const char *prog)
+{
+	printf("Usage: %s [options]\n"
+		"  -c <MiB>   cache size (default: 1024)\n"
+		"  -s <MiB>   core size (default: 4096)\n"
+		"  -l <KiB>   cache line size (default: 4)\n"
+		"  -m <mode>  cache mode: wt, wb, wa, pt or wi (default: wt)\n"
+		"  -C         back cache with RAM instead of null volume\n"
+		"  -R         back core with RAM instead of null volume\n"
+		"  -A <us>    latency of cache volume (default: 0)\n"
+		"  -L <us>    latency of core volume (default: 0)\n"
+		"  -j <n>     number of jobs, each with its own queue "
+			"(default: 1)\n"
+		"  -d <n>     queue depth per job (default: 32)\n"
+		"  -b <KiB>   block size (default: 4)\n"
+		"  -w <pct>   percentage of writes (default: 0)\n"
+		"  -S         sequential instead of random access\n"
+		"  -z <theta> zipfian access skew in range (0, 1) "
+			"(default: uniform)\n"
+		"  -t <s>     measured run time (default: 10)\n"
+		"  -W <s>     warm up time before measurement (default: 0)\n",
+		prog);
+}
+
+static int parse_args(struct bench *bench, int argc, char *argv[])
+{
+	struct bench_config *cfg = &bench->cfg;
+	int opt;
+
+	cfg->cache_size = 1024ULL << 20;
+	cfg->core_size = 4096ULL << 20;
+	cfg->cache_line_size = ocf_cache_line_size_4;
+	cfg->cache_mode = ocf_cache_mode_wt;
+	cfg->jobs = 1;
+	cfg->queue_depth = 32;
+	cfg->block_size = 4 * KiB;
+	cfg->runtime = 10;
+
+	while ((opt = getopt(argc, argv, "c:s:l:m:CRA:L:j:d:b:w:Sz:t:W:h")) != -1) {
+		switch (opt) {
+		case 'c':
+			cfg->cache_size = strtoull(optarg, NULL, 10) << 20;
+			break;
+		case 's':
+			cfg->core_size = strtoull(optarg, NULL, 10) << 20;
+			break;
+		case 'l':
+			cfg->cache_line_size = strtoul(optarg, NULL, 10) * KiB;
+			break;
+		case 'm':
+			if (parse_cache_mode(optarg, &cfg->cache_mode))
+				return -EINVAL;
+			break;
+		case 'C':
+			cfg->cache_ram = true;
+			break;
+		case 'R':
+			cfg->core_ram = true;
+			break;
+		case 'A':
+			cfg->cache_latency_us = strtoul(optarg, NULL, 10);
+			break;
+		case 'L':
+			cfg->core_latency_us = strtoul(optarg, NULL, 10);
+			break;
+		case 'j':
+			cfg->jobs = strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			cfg->queue_depth = strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			cfg->block_size = strtoul(optarg, NULL, 10) * KiB;
+			break;
+		case 'w':
+			cfg->write_pct = strtoul(optarg, NULL, 10);
+			break;
+		case 'S':
+			cfg->sequential = true;
+			break;
+		case 'z':
+			cfg->zipf_theta = strtod(optarg, NULL);
+			if (cfg->zipf_theta <= 0 || cfg->zipf_theta >= 1)
+				return -EINVAL;
+			break;
+		case 't':
+			cfg->runtime = strtoul(optarg, NULL, 10);
+			break;
+		case 'W':
+			cfg->warmup = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	if (optind != argc || !cfg->jobs || !cfg->queue_depth ||
+			!cfg->block_size || cfg->write_pct > 100 ||
+			!cfg->runtime) {
+		return -EINVAL;
+	}
+
+	bench->blocks = cfg->core_size / cfg->block_size;
+	if (!bench->blocks) {
+		printf("Core smaller than block size\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct bench *bench;
+	uint64_t elapsed_ns;
+	uint32_t i;
+	int ret;
+
+	bench = calloc(1, sizeof(*bench));
+	if (!bench)
+		return 1;
+
+	if (parse_args(bench, argc, argv)) {
+		usage(argv[0]);
+		free(bench);
+		return 1;
+	}
+
+	bench->jobs = calloc(bench->cfg.jobs, sizeof(*bench->jobs));
+	if (!bench->jobs) {
+		free(bench);
+		return 1;
+	}
+
+	for (i = 0; i < bench->cfg.jobs; i++) {
+		ret = bench_job_init(bench, &bench->jobs[i], i);
+		if (ret) {
+			printf("Failed to allocate I/O buffers\n");
+			goto err_jobs;
+		}
+	}
+
+	if (bench->cfg.zipf_theta && !bench->cfg.sequential)
+		zipf_init(&bench->zipf, bench->blocks, bench->cfg.zipf_theta);
+
+	ret = ctx_init(&bench->ctx);
+	if (ret) {
+		printf("Unable to initialize context (%d)\n", ret);
+		goto err_jobs;
+	}
+
+	ret = bench_start_cache(bench);
+	if (ret) {
+		printf("Unable to start cache (%d)\n", ret);
+		goto err_ctx;
+	}
+
+	ret = bench_add_core(bench);
+	if (ret) {
+		printf("Unable to add core (%d)\n", ret);
+		bench_stop_cache(bench);
+		goto err_ctx;
+	}
+
+	ocf_mngt_cache_unlock(bench->cache);
+
+	elapsed_ns = bench_run(bench);
+	bench_report(bench, elapsed_ns);
+
+	ocf_mngt_cache_lock(bench->cache);
+	bench_stop_cache(bench);
+
+err_ctx:
+	ctx_cleanup(bench->ctx);
+err_jobs:
+	for (i = 0; i < bench->cfg.jobs; i++)
+		bench_job_deinit(bench, &bench->jobs[i]);
+	free(bench->jobs);
+	free(bench);
+
+	return ret ? 1 : 0;
+}
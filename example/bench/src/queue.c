@@ -0,0 +1,126 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <ocf/ocf.h>
+#include "ocf_env.h"
+#include "queue.h"
+
+struct queue_thread {
+	ocf_queue_t queue;
+	pthread_t thread;
+	sem_t sem;
+	sem_t synced;
+	bool sync;
+	bool started;
+	bool stop;
+};
+
+/*
+ * Each queue is served by its own thread, which sleeps until queue is kicked
+ * and then handles all requests pending in queue.
+ */
+static void *queue_thread_run(void *arg)
+{
+	struct queue_thread *qt = arg;
+
+	while (true) {
+		sem_wait(&qt->sem);
+		ocf_queue_run(qt->queue);
+		if (qt->sync) {
+			qt->sync = false;
+			sem_post(&qt->synced);
+		}
+		if (qt->stop)
+			break;
+	}
+
+	return NULL;
+}
+
+static void queue_kick(ocf_queue_t q)
+{
+	struct queue_thread *qt = ocf_queue_get_priv(q);
+
+	sem_post(&qt->sem);
+}
+
+/*
+ * Called when the last reference to queue is dropped. Thread handles
+ * remaining requests and exits.
+ */
+static void queue_stop(ocf_queue_t q)
+{
+	struct queue_thread *qt = ocf_queue_get_priv(q);
+
+	qt->stop = true;
+	sem_post(&qt->sem);
+	if (qt->started)
+		pthread_join(qt->thread, NULL);
+	sem_destroy(&qt->synced);
+	sem_destroy(&qt->sem);
+	free(qt);
+}
+
+static const struct ocf_queue_ops queue_ops = {
+	.kick = queue_kick,
+	.kick_sync = queue_kick,
+	.stop = queue_stop,
+};
+
+/*
+ * Create queue together with thread serving it. Queue is released with
+ * ocf_queue_put().
+ */
+int queue_create(ocf_cache_t cache, ocf_queue_t *queue)
+{
+	struct queue_thread *qt;
+	int ret;
+
+	qt = calloc(1, sizeof(*qt));
+	if (!qt)
+		return -ENOMEM;
+
+	sem_init(&qt->sem, 0, 0);
+	sem_init(&qt->synced, 0, 0);
+
+	ret = ocf_queue_create(cache, &qt->queue, &queue_ops);
+	if (ret) {
+		sem_destroy(&qt->synced);
+		sem_destroy(&qt->sem);
+		free(qt);
+		return ret;
+	}
+
+	ocf_queue_set_priv(qt->queue, qt);
+
+	ret = pthread_create(&qt->thread, NULL, queue_thread_run, qt);
+	if (ret) {
+		ocf_queue_put(qt->queue);
+		return -ret;
+	}
+
+	qt->started = true;
+
+	*queue = qt->queue;
+
+	return 0;
+}
+
+/*
+ * Wait until queue thread returns from handling requests it is processing.
+ * Management queue outlives stopped cache, and cache stop completion is
+ * called before cache is actually released, so this allows to wait until
+ * stop is really finished.
+ */
+void queue_sync(ocf_queue_t queue)
+{
+	struct queue_thread *qt = ocf_queue_get_priv(queue);
+
+	qt->sync = true;
+	sem_post(&qt->sem);
+	sem_wait(&qt->synced);
+}
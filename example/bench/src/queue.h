@@ -0,0 +1,14 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#include <ocf/ocf.h>
+
+int queue_create(ocf_cache_t cache, ocf_queue_t *queue);
+void queue_sync(ocf_queue_t queue);
+
+#endif
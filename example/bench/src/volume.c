@@ -0,0 +1,334 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <time.h>
+#include <ocf/ocf.h>
+#include "volume.h"
+#include "data.h"
+#include "ctx.h"
+
+static uint64_t volume_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Completion thread sleeps until deadline of the oldest I/O and completes
+ * it, until volume is closed.
+ */
+static void *volume_complete_run(void *arg)
+{
+	struct myvolume *myvolume = arg;
+	struct myvolume_io *myvolume_io;
+	struct timespec ts;
+
+	pthread_mutex_lock(&myvolume->lock);
+
+	while (true) {
+		myvolume_io = myvolume->head;
+		if (!myvolume_io) {
+			if (myvolume->stop)
+				break;
+			pthread_cond_wait(&myvolume->cond, &myvolume->lock);
+			continue;
+		}
+
+		if (volume_now_ns() < myvolume_io->deadline_ns) {
+			pthread_mutex_unlock(&myvolume->lock);
+			ts.tv_sec = myvolume_io->deadline_ns / 1000000000ULL;
+			ts.tv_nsec = myvolume_io->deadline_ns % 1000000000ULL;
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+					&ts, NULL))
+				;
+			pthread_mutex_lock(&myvolume->lock);
+			continue;
+		}
+
+		myvolume->head = myvolume_io->next;
+		if (!myvolume->head)
+			myvolume->tail = NULL;
+
+		pthread_mutex_unlock(&myvolume->lock);
+		myvolume_io->io->end(myvolume_io->io, myvolume_io->error);
+		pthread_mutex_lock(&myvolume->lock);
+	}
+
+	pthread_mutex_unlock(&myvolume->lock);
+
+	return NULL;
+}
+
+/*
+ * Complete I/O right away, or pass it to completion thread if volume has
+ * latency set.
+ */
+static void volume_complete(struct ocf_io *io, int error)
+{
+	struct myvolume_io *myvolume_io = ocf_io_get_priv(io);
+	struct myvolume *myvolume = ocf_volume_get_priv(io->volume);
+
+	if (!myvolume->latency_ns) {
+		io->end(io, error);
+		return;
+	}
+
+	myvolume_io->io = io;
+	myvolume_io->error = error;
+	myvolume_io->deadline_ns = volume_now_ns() + myvolume->latency_ns;
+	myvolume_io->next = NULL;
+
+	pthread_mutex_lock(&myvolume->lock);
+	if (myvolume->tail)
+		myvolume->tail->next = myvolume_io;
+	else
+		myvolume->head = myvolume_io;
+	myvolume->tail = myvolume_io;
+	pthread_cond_signal(&myvolume->cond);
+	pthread_mutex_unlock(&myvolume->lock);
+}
+
+/*
+ * Parse "<size>[:<latency in us>]" part of uuid.
+ */
+static int volume_parse(struct myvolume *myvolume, const char *str)
+{
+	char *end;
+
+	myvolume->length = strtoull(str, &end, 10);
+	if (!myvolume->length)
+		return -OCF_ERR_INVAL;
+
+	if (*end == ':')
+		myvolume->latency_ns = strtoull(end + 1, &end, 10) * 1000;
+
+	return *end ? -OCF_ERR_INVAL : 0;
+}
+
+/*
+ * In open() function we parse backend, size and latency from uuid. RAM
+ * backend allocates memory to simulate backend storage device, null backend
+ * only keeps its size. Volume with latency starts its completion thread.
+ */
+static int volume_open(ocf_volume_t volume, void *volume_params)
+{
+	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(volume);
+	struct myvolume *myvolume = ocf_volume_get_priv(volume);
+	const char *name = ocf_uuid_to_str(uuid);
+	int ret;
+
+	myvolume->name = name;
+	myvolume->mem = NULL;
+	myvolume->latency_ns = 0;
+	myvolume->head = myvolume->tail = NULL;
+	myvolume->stop = false;
+
+	if (!strncmp(name, "ram:", 4)) {
+		ret = volume_parse(myvolume, name + 4);
+		if (ret)
+			return ret;
+
+		myvolume->mem = calloc(1, myvolume->length);
+		if (!myvolume->mem)
+			return -OCF_ERR_NO_MEM;
+	} else if (!strncmp(name, "null:", 5)) {
+		ret = volume_parse(myvolume, name + 5);
+		if (ret)
+			return ret;
+	} else {
+		return -OCF_ERR_INVAL;
+	}
+
+	if (!myvolume->latency_ns)
+		return 0;
+
+	pthread_mutex_init(&myvolume->lock, NULL);
+	pthread_cond_init(&myvolume->cond, NULL);
+
+	ret = pthread_create(&myvolume->thread, NULL, volume_complete_run,
+			myvolume);
+	if (ret) {
+		pthread_cond_destroy(&myvolume->cond);
+		pthread_mutex_destroy(&myvolume->lock);
+		free(myvolume->mem);
+		return -OCF_ERR_NO_MEM;
+	}
+
+	return 0;
+}
+
+/*
+ * In close() function we stop completion thread, once all I/Os are
+ * completed, and free memory allocated in open().
+ */
+static void volume_close(ocf_volume_t volume)
+{
+	struct myvolume *myvolume = ocf_volume_get_priv(volume);
+
+	if (myvolume->latency_ns) {
+		pthread_mutex_lock(&myvolume->lock);
+		myvolume->stop = true;
+		pthread_cond_signal(&myvolume->cond);
+		pthread_mutex_unlock(&myvolume->lock);
+
+		pthread_join(myvolume->thread, NULL);
+		pthread_cond_destroy(&myvolume->cond);
+		pthread_mutex_destroy(&myvolume->lock);
+	}
+
+	free(myvolume->mem);
+}
+
+/*
+ * In submit_io() function we simulate read or write to backend storage
+ * device by doing memcpy() to or from previously allocated memory buffer.
+ * Null backend doesn't touch data at all, so that only cost of OCF itself
+ * is measured.
+ */
+static void volume_submit_io(struct ocf_io *io)
+{
+	struct myvolume_io *myvolume_io = ocf_io_get_priv(io);
+	struct myvolume *myvolume = ocf_volume_get_priv(io->volume);
+	uint8_t *buf;
+
+	/* Flush requests are passed down as zero length I/O without data */
+	if (!io->bytes) {
+		volume_complete(io, 0);
+		return;
+	}
+
+	if (io->addr + io->bytes > myvolume->length) {
+		io->end(io, -OCF_ERR_INVAL);
+		return;
+	}
+
+	if (myvolume->mem) {
+		buf = (uint8_t *)myvolume_io->data->ptr + myvolume_io->offset;
+
+		if (io->dir == OCF_WRITE)
+			memcpy(myvolume->mem + io->addr, buf, io->bytes);
+		else
+			memcpy(buf, myvolume->mem + io->addr, io->bytes);
+	}
+
+	volume_complete(io, 0);
+}
+
+/*
+ * Flush is completed with latency of volume.
+ */
+static void volume_submit_flush(struct ocf_io *io)
+{
+	volume_complete(io, 0);
+}
+
+/*
+ * Discard zeroes discarded range of RAM backend.
+ */
+static void volume_submit_discard(struct ocf_io *io)
+{
+	struct myvolume *myvolume = ocf_volume_get_priv(io->volume);
+
+	if (io->addr + io->bytes > myvolume->length) {
+		io->end(io, -OCF_ERR_INVAL);
+		return;
+	}
+
+	if (myvolume->mem)
+		memset(myvolume->mem + io->addr, 0, io->bytes);
+
+	volume_complete(io, 0);
+}
+
+/*
+ * Let's set maximum io size to 128 KiB.
+ */
+static unsigned int volume_get_max_io_size(ocf_volume_t volume)
+{
+	return 128 * 1024;
+}
+
+/*
+ * Return volume size.
+ */
+static uint64_t volume_get_length(ocf_volume_t volume)
+{
+	struct myvolume *myvolume = ocf_volume_get_priv(volume);
+
+	return myvolume->length;
+}
+
+/*
+ * In set_data() we just assing data and offset to io.
+ */
+static int myvolume_io_set_data(struct ocf_io *io, ctx_data_t *data,
+		uint32_t offset)
+{
+	struct myvolume_io *myvolume_io = ocf_io_get_priv(io);
+
+	myvolume_io->data = data;
+	myvolume_io->offset = offset;
+
+	return 0;
+}
+
+/*
+ * In get_data() return data stored in io.
+ */
+static ctx_data_t *myvolume_io_get_data(struct ocf_io *io)
+{
+	struct myvolume_io *myvolume_io = ocf_io_get_priv(io);
+
+	return myvolume_io->data;
+}
+
+/*
+ * This structure contains volume properties. It describes volume
+ * type, which can be later instantiated as backend storage for cache
+ * or core.
+ */
+const struct ocf_volume_properties volume_properties = {
+	.name = "Bench volume",
+	.io_priv_size = sizeof(struct myvolume_io),
+	.volume_priv_size = sizeof(struct myvolume),
+	.caps = {
+		.atomic_writes = 0,
+	},
+	.ops = {
+		.open = volume_open,
+		.close = volume_close,
+		.submit_io = volume_submit_io,
+		.submit_flush = volume_submit_flush,
+		.submit_discard = volume_submit_discard,
+		.get_max_io_size = volume_get_max_io_size,
+		.get_length = volume_get_length,
+	},
+	.io_ops = {
+		.set_data = myvolume_io_set_data,
+		.get_data = myvolume_io_get_data,
+	},
+};
+
+/*
+ * This function registers volume type in OCF context.
+ * It should be called just after context initialization.
+ */
+int volume_init(ocf_ctx_t ocf_ctx)
+{
+	return ocf_ctx_register_volume_type(ocf_ctx, VOL_TYPE,
+			&volume_properties);
+}
+
+/*
+ * This function unregisters volume type in OCF context.
+ * It should be called just before context cleanup.
+ */
+void volume_cleanup(ocf_ctx_t ocf_ctx)
+{
+	ocf_ctx_unregister_volume_type(ocf_ctx, VOL_TYPE);
+}
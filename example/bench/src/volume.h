@@ -0,0 +1,56 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __VOLUME_H__
+#define __VOLUME_H__
+
+#include <pthread.h>
+#include <ocf/ocf.h>
+#include "ocf_env.h"
+#include "ctx.h"
+#include "data.h"
+
+/*
+ * Volume UUID has form of "<backend>:<size in bytes>[:<latency in us>]",
+ * where backend is either "ram" (data kept in memory) or "null" (data is
+ * not touched at all, writes are dropped and read buffers are left as they
+ * are). With latency given, each I/O is completed that long after it was
+ * submitted, otherwise it's completed right away in submit context.
+ */
+#define VOLUME_UUID_MAX 64
+
+struct myvolume_io {
+	struct volume_data *data;
+	uint32_t offset;
+
+	/* Delayed completion */
+	struct ocf_io *io;
+	int error;
+	uint64_t deadline_ns;
+	struct myvolume_io *next;
+};
+
+struct myvolume {
+	uint8_t *mem;
+	uint64_t length;
+	const char *name;
+
+	/*
+	 * I/Os waiting for completion, in order of their deadlines as all
+	 * of them are delayed by the same latency
+	 */
+	uint64_t latency_ns;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct myvolume_io *head;
+	struct myvolume_io *tail;
+	bool stop;
+};
+
+int volume_init(ocf_ctx_t ocf_ctx);
+void volume_cleanup(ocf_ctx_t ocf_ctx);
+
+#endif
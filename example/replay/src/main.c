@@ -0,0 +1,754 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Trace replay tool. It feeds I/Os recorded with OCF tracing through cache
+ * backed by RAM or null volumes and reports throughput, latency and hit
+ * ratio. I/Os are replayed either as fast as possible with bounded queue
+ * depth, or at their original timing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <ocf/ocf.h>
+#include "data.h"
+#include "ctx.h"
+#include "queue.h"
+#include "volume.h"
+#include "trace.h"
+
+#define PAGE_SIZE 4096
+
+/* Latency histogram with 8 linear buckets per power of two */
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 << HIST_SUB_BITS)
+
+enum replay_op {
+	replay_op_read,
+	replay_op_write,
+	replay_op_other,
+	replay_op_max,
+};
+
+static const char *replay_op_name[replay_op_max] = {
+	[replay_op_read] = "read",
+	[replay_op_write] = "write",
+	[replay_op_other] = "flush/discard",
+};
+
+struct latency_hist {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint64_t buckets[HIST_BUCKETS];
+};
+
+struct replay_slot {
+	struct replay *replay;
+	struct volume_data *data;
+	uint64_t start_ns;
+	enum replay_op op;
+};
+
+struct replay_config {
+	const char *trace_path;
+	uint64_t cache_size;
+	ocf_cache_line_size_t cache_line_size;
+	ocf_cache_mode_t cache_mode;
+	bool cache_ram;
+	bool core_ram;
+	uint32_t queue_depth;
+	bool timed;
+	double speed;
+};
+
+struct replay {
+	struct replay_config cfg;
+	struct trace trace;
+
+	ocf_ctx_t ctx;
+	ocf_cache_t cache;
+	ocf_queue_t mngt_queue;
+	ocf_queue_t io_queue;
+	ocf_core_t cores[OCF_CORE_MAX];
+
+	/* Free I/O slots, bounding queue depth */
+	pthread_mutex_t lock;
+	sem_t free_sem;
+	struct replay_slot **free;
+	uint32_t free_count;
+	struct replay_slot *slots;
+
+	struct latency_hist hist[replay_op_max];
+	uint64_t bytes[replay_op_max];
+	uint64_t errors;
+};
+
+/*
+ * Simple context for synchronous waiting on completion of management
+ * operations.
+ */
+struct mngt_wait {
+	sem_t sem;
+	ocf_core_t core;
+	int error;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned hist_bucket(uint64_t ns)
+{
+	unsigned msb;
+
+	if (ns < HIST_SUB)
+		return ns;
+
+	msb = 63 - __builtin_clzll(ns);
+
+	return ((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) |
+		((ns >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+static uint64_t hist_bucket_value(unsigned bucket)
+{
+	unsigned msb;
+
+	if (bucket < HIST_SUB)
+		return bucket;
+
+	msb = (bucket >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+
+	return (uint64_t)(HIST_SUB | (bucket & (HIST_SUB - 1))) <<
+		(msb - HIST_SUB_BITS);
+}
+
+static uint64_t hist_percentile(const struct latency_hist *hist,
+		double percentile)
+{
+	uint64_t target, seen = 0;
+	unsigned i;
+
+	target = hist->count * percentile / 100;
+	if (target >= hist->count)
+		target = hist->count - 1;
+
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		seen += hist->buckets[i];
+		if (seen > target)
+			return hist_bucket_value(i);
+	}
+
+	return hist->max_ns;
+}
+
+static void mngt_wait_init(struct mngt_wait *wait)
+{
+	sem_init(&wait->sem, 0, 0);
+	wait->core = NULL;
+	wait->error = 0;
+}
+
+static int mngt_wait_finish(struct mngt_wait *wait)
+{
+	sem_wait(&wait->sem);
+	sem_destroy(&wait->sem);
+
+	return wait->error;
+}
+
+static void mngt_cache_cmpl(ocf_cache_t cache, void *priv, int error)
+{
+	struct mngt_wait *wait = priv;
+
+	wait->error = error;
+	sem_post(&wait->sem);
+}
+
+static void mngt_core_cmpl(ocf_cache_t cache, ocf_core_t core, void *priv,
+		int error)
+{
+	struct mngt_wait *wait = priv;
+
+	wait->core = core;
+	wait->error = error;
+	sem_post(&wait->sem);
+}
+
+/*
+ * Stop cache, which has to be locked by caller.
+ */
+static void replay_stop_cache(struct replay *replay)
+{
+	struct mngt_wait wait;
+
+	mngt_wait_init(&wait);
+	ocf_mngt_cache_stop(replay->cache, mngt_cache_cmpl, &wait);
+	if (mngt_wait_finish(&wait))
+		printf("Failed to stop cache\n");
+
+	if (replay->mngt_queue)
+		queue_sync(replay->mngt_queue);
+}
+
+/*
+ * Start cache with parameters of traced cache, unless overridden by user,
+ * and attach it to RAM or null volume of traced cache size.
+ */
+static int replay_start_cache(struct replay *replay)
+{
+	struct ocf_mngt_cache_config cache_cfg = { };
+	struct ocf_mngt_cache_device_config device_cfg = { };
+	struct mngt_wait wait;
+	char uuid[VOLUME_UUID_MAX];
+	int ret;
+
+	cache_cfg.id = OCF_CACHE_ID_INVALID;
+	cache_cfg.name = "replay";
+	cache_cfg.cache_mode = replay->cfg.cache_mode;
+	cache_cfg.cache_line_size = replay->cfg.cache_line_size;
+	cache_cfg.backfill.max_queue_size = 65536;
+	cache_cfg.backfill.queue_unblock_size = 60000;
+	cache_cfg.locked = true;
+
+	ret = ocf_mngt_cache_start(replay->ctx, &replay->cache, &cache_cfg);
+	if (ret)
+		return ret;
+
+	ret = queue_create(replay->cache, &replay->mngt_queue);
+	if (ret)
+		goto err_stop;
+
+	ocf_mngt_cache_set_mngt_queue(replay->cache, replay->mngt_queue);
+
+	ret = queue_create(replay->cache, &replay->io_queue);
+	if (ret)
+		goto err_stop;
+
+	snprintf(uuid, sizeof(uuid), "%s:%llu",
+			replay->cfg.cache_ram ? "ram" : "null",
+			(unsigned long long)replay->cfg.cache_size);
+
+	device_cfg.volume_type = VOL_TYPE;
+	device_cfg.cache_line_size = cache_cfg.cache_line_size;
+	device_cfg.force = true;
+	ret = ocf_uuid_set_str(&device_cfg.uuid, uuid);
+	if (ret)
+		goto err_stop;
+
+	mngt_wait_init(&wait);
+	ocf_mngt_cache_attach(replay->cache, &device_cfg, mngt_cache_cmpl,
+			&wait);
+	ret = mngt_wait_finish(&wait);
+	if (ret)
+		goto err_stop;
+
+	return 0;
+
+err_stop:
+	replay_stop_cache(replay);
+	return ret;
+}
+
+/*
+ * Add core for each core id found in trace, keeping traced ids.
+ */
+static int replay_add_cores(struct replay *replay)
+{
+	struct ocf_mngt_core_config core_cfg = { };
+	struct mngt_wait wait;
+	char uuid[VOLUME_UUID_MAX];
+	char name[OCF_CORE_NAME_SIZE];
+	ocf_core_id_t id;
+	int ret;
+
+	for (id = 0; id < OCF_CORE_MAX; id++) {
+		if (!replay->trace.core_size[id])
+			continue;
+
+		snprintf(uuid, sizeof(uuid), "%s:%llu",
+				replay->cfg.core_ram ? "ram" : "null",
+				(unsigned long long)
+					replay->trace.core_size[id]);
+		snprintf(name, sizeof(name), "core%u", id);
+
+		core_cfg.volume_type = VOL_TYPE;
+		core_cfg.core_id = id;
+		core_cfg.name = name;
+		ret = ocf_uuid_set_str(&core_cfg.uuid, uuid);
+		if (ret)
+			return ret;
+
+		mngt_wait_init(&wait);
+		ocf_mngt_cache_add_core(replay->cache, &core_cfg,
+				mngt_core_cmpl, &wait);
+		ret = mngt_wait_finish(&wait);
+		if (ret)
+			return ret;
+
+		replay->cores[id] = wait.core;
+	}
+
+	return 0;
+}
+
+static int replay_slots_init(struct replay *replay)
+{
+	uint32_t pages = (replay->trace.max_io_len + PAGE_SIZE - 1) /
+		PAGE_SIZE ?: 1;
+	uint32_t i;
+
+	replay->slots = calloc(replay->cfg.queue_depth,
+			sizeof(*replay->slots));
+	replay->free = calloc(replay->cfg.queue_depth,
+			sizeof(*replay->free));
+	if (!replay->slots || !replay->free)
+		return -ENOMEM;
+
+	for (i = 0; i < replay->cfg.queue_depth; i++) {
+		replay->slots[i].replay = replay;
+		replay->slots[i].data = ctx_data_alloc(pages);
+		if (!replay->slots[i].data)
+			return -ENOMEM;
+		replay->free[replay->free_count++] = &replay->slots[i];
+	}
+
+	pthread_mutex_init(&replay->lock, NULL);
+	sem_init(&replay->free_sem, 0, replay->cfg.queue_depth);
+
+	return 0;
+}
+
+static void replay_slots_deinit(struct replay *replay)
+{
+	uint32_t i;
+
+	if (replay->slots) {
+		for (i = 0; i < replay->cfg.queue_depth; i++)
+			ctx_data_free(replay->slots[i].data);
+	}
+
+	free(replay->slots);
+	free(replay->free);
+}
+
+static struct replay_slot *replay_slot_get(struct replay *replay)
+{
+	struct replay_slot *slot;
+
+	sem_wait(&replay->free_sem);
+
+	pthread_mutex_lock(&replay->lock);
+	slot = replay->free[--replay->free_count];
+	pthread_mutex_unlock(&replay->lock);
+
+	return slot;
+}
+
+static void replay_slot_put(struct replay_slot *slot, int error)
+{
+	struct replay *replay = slot->replay;
+	struct latency_hist *hist = &replay->hist[slot->op];
+	uint64_t latency = now_ns() - slot->start_ns;
+
+	pthread_mutex_lock(&replay->lock);
+	hist->count++;
+	hist->total_ns += latency;
+	if (latency > hist->max_ns)
+		hist->max_ns = latency;
+	hist->buckets[hist_bucket(latency)]++;
+	if (error)
+		replay->errors++;
+	replay->free[replay->free_count++] = slot;
+	pthread_mutex_unlock(&replay->lock);
+
+	sem_post(&replay->free_sem);
+}
+
+static void replay_io_cmpl(struct ocf_io *io, int error)
+{
+	struct replay_slot *slot = io->priv1;
+
+	ocf_io_put(io);
+	replay_slot_put(slot, error);
+}
+
+static void replay_submit(struct replay *replay, const struct trace_io *tio)
+{
+	struct replay_slot *slot;
+	struct ocf_io *io;
+	uint32_t dir;
+
+	slot = replay_slot_get(replay);
+
+	switch (tio->operation) {
+	case ocf_event_operation_rd:
+		slot->op = replay_op_read;
+		dir = OCF_READ;
+		break;
+	case ocf_event_operation_wr:
+		slot->op = replay_op_write;
+		dir = OCF_WRITE;
+		break;
+	default:
+		slot->op = replay_op_other;
+		dir = OCF_WRITE;
+		break;
+	}
+
+	slot->start_ns = now_ns();
+
+	io = ocf_core_new_io(replay->cores[tio->core_id]);
+	if (!io) {
+		replay_slot_put(slot, -ENOMEM);
+		return;
+	}
+
+	ocf_io_set_queue(io, replay->io_queue);
+	ocf_io_set_cmpl(io, slot, NULL, replay_io_cmpl);
+
+	switch (tio->operation) {
+	case ocf_event_operation_flush:
+		ocf_io_configure(io, 0, 0, dir, tio->io_class, 0);
+		ocf_core_submit_flush(io);
+		break;
+	case ocf_event_operation_discard:
+		ocf_io_configure(io, tio->addr, tio->len, dir, tio->io_class,
+				0);
+		ocf_core_submit_discard(io);
+		break;
+	default:
+		ocf_io_configure(io, tio->addr, tio->len, dir, tio->io_class,
+				0);
+		replay->bytes[slot->op] += tio->len;
+		slot->data->offset = 0;
+		if (ocf_io_set_data(io, slot->data, 0)) {
+			ocf_io_put(io);
+			replay_slot_put(slot, -EINVAL);
+			return;
+		}
+		ocf_core_submit_io(io);
+		break;
+	}
+}
+
+/*
+ * In timed mode wait until time elapsed since replay start matches time
+ * elapsed since first traced I/O, scaled by replay speed.
+ */
+static void replay_wait_timestamp(struct replay *replay,
+		const struct trace_io *tio, uint64_t start_ns)
+{
+	uint64_t delay, target;
+	struct timespec ts;
+
+	delay = (tio->timestamp - replay->trace.ios[0].timestamp) /
+		replay->cfg.speed;
+	target = start_ns + delay;
+
+	if (now_ns() >= target)
+		return;
+
+	ts.tv_sec = target / 1000000000ULL;
+	ts.tv_nsec = target % 1000000000ULL;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL))
+		;
+}
+
+static uint64_t replay_run(struct replay *replay)
+{
+	uint64_t i, start_ns;
+
+	start_ns = now_ns();
+
+	for (i = 0; i < replay->trace.io_count; i++) {
+		if (replay->cfg.timed)
+			replay_wait_timestamp(replay, &replay->trace.ios[i],
+					start_ns);
+		replay_submit(replay, &replay->trace.ios[i]);
+	}
+
+	/* Wait for all I/Os in flight */
+	for (i = 0; i < replay->cfg.queue_depth; i++)
+		sem_wait(&replay->free_sem);
+
+	return now_ns() - start_ns;
+}
+
+static void print_hit_ratio(const char *name, const struct ocf_stats_req *req)
+{
+	/* Total counts requests serviced by cache, without pass-through */
+	uint64_t hits = req->total - req->partial_miss - req->full_miss;
+	uint64_t cached = req->total;
+
+	printf("  %-6s requests %10llu  hits %10llu  partial misses %10llu  "
+			"full misses %10llu  pass-through %10llu",
+			name, (unsigned long long)(req->total +
+				req->pass_through),
+			(unsigned long long)hits,
+			(unsigned long long)req->partial_miss,
+			(unsigned long long)req->full_miss,
+			(unsigned long long)req->pass_through);
+	if (cached)
+		printf("  hit ratio %.2f%%", 100.0 * hits / cached);
+	printf("\n");
+}
+
+static void replay_report(struct replay *replay, uint64_t elapsed_ns)
+{
+	struct ocf_cache_info info;
+	struct ocf_stats_core stats;
+	uint64_t ios = 0, bytes = 0;
+	double seconds = elapsed_ns / 1e9;
+	ocf_core_id_t id;
+	int i;
+
+	for (i = 0; i < replay_op_max; i++) {
+		ios += replay->hist[i].count;
+		bytes += replay->bytes[i];
+	}
+
+	printf("Replayed %llu I/Os (%llu errors) in %.3f s: %.0f IOPS, "
+			"%.2f MiB/s\n", (unsigned long long)ios,
+			(unsigned long long)replay->errors, seconds,
+			seconds ? ios / seconds : 0,
+			seconds ? bytes / seconds / (1 << 20) : 0);
+
+	printf("Latency [us]:\n");
+	for (i = 0; i < replay_op_max; i++) {
+		const struct latency_hist *hist = &replay->hist[i];
+
+		if (!hist->count)
+			continue;
+
+		printf("  %-13s count %10llu  avg %9.2f  p50 %9.2f  "
+				"p99 %9.2f  p99.9 %9.2f  max %9.2f\n",
+				replay_op_name[i],
+				(unsigned long long)hist->count,
+				hist->total_ns / 1e3 / hist->count,
+				hist_percentile(hist, 50) / 1e3,
+				hist_percentile(hist, 99) / 1e3,
+				hist_percentile(hist, 99.9) / 1e3,
+				hist->max_ns / 1e3);
+	}
+
+	if (!ocf_cache_get_info(replay->cache, &info)) {
+		printf("Cache: %u lines, occupancy %u, dirty %u\n",
+				info.size, info.occupancy, info.dirty);
+	}
+
+	for (id = 0; id < OCF_CORE_MAX; id++) {
+		if (!replay->cores[id])
+			continue;
+
+		if (ocf_core_get_stats(replay->cores[id], &stats))
+			continue;
+
+		printf("Core %u:\n", id);
+		print_hit_ratio("read", &stats.read_reqs);
+		print_hit_ratio("write", &stats.write_reqs);
+	}
+}
+
+static int parse_cache_mode(const char *name, ocf_cache_mode_t *mode)
+{
+	static const char *names[ocf_cache_mode_max] = {
+		[ocf_cache_mode_wt] = "wt",
+		[ocf_cache_mode_wb] = "wb",
+		[ocf_cache_mode_wa] = "wa",
+		[ocf_cache_mode_pt] = "pt",
+		[ocf_cache_mode_wi] = "wi",
+	};
+	int i;
+
+	for (i = 0; i < ocf_cache_mode_max; i++) {
+		if (names[i] && !strcmp(name, names[i])) {
+			*mode = i;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
+
+static void usage(const char *prog)
+{
+	printf("Usage: %s [options] <trace file>\n"
+		"  -c <MiB>   cache size (default: traced cache size)\n"
+		"  -l <KiB>   cache line size (default: traced line size)\n"
+		"  -m <mode>  cache mode: wt, wb, wa, pt or wi "
+			"(default: traced mode)\n"
+		"  -C         back cache with RAM instead of null volume\n"
+		"  -R         back cores with RAM instead of null volumes\n"
+		"  -d <n>     queue depth (default: 32)\n"
+		"  -t         replay at original timing instead of "
+			"maximum speed\n"
+		"  -s <x>     speed of timed replay (default: 1.0)\n",
+		prog);
+}
+
+static int parse_args(struct replay *replay, int argc, char *argv[])
+{
+	struct replay_config *cfg = &replay->cfg;
+	bool mode_set = false, line_set = false;
+	struct trace *trace = &replay->trace;
+	int opt, ret;
+
+	cfg->queue_depth = 32;
+	cfg->speed = 1.0;
+
+	while ((opt = getopt(argc, argv, "c:l:m:CRd:ts:h")) != -1) {
+		switch (opt) {
+		case 'c':
+			cfg->cache_size = strtoull(optarg, NULL, 10) << 20;
+			break;
+		case 'l':
+			cfg->cache_line_size = strtoul(optarg, NULL, 10) * KiB;
+			line_set = true;
+			break;
+		case 'm':
+			if (parse_cache_mode(optarg, &cfg->cache_mode))
+				return -EINVAL;
+			mode_set = true;
+			break;
+		case 'C':
+			cfg->cache_ram = true;
+			break;
+		case 'R':
+			cfg->core_ram = true;
+			break;
+		case 'd':
+			cfg->queue_depth = strtoul(optarg, NULL, 10);
+			break;
+		case 't':
+			cfg->timed = true;
+			break;
+		case 's':
+			cfg->speed = strtod(optarg, NULL);
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	if (optind != argc - 1 || !cfg->queue_depth || cfg->speed <= 0)
+		return -EINVAL;
+
+	cfg->trace_path = argv[optind];
+
+	ret = trace_load(trace, cfg->trace_path);
+	if (ret) {
+		printf("Failed to load trace %s (%d)\n", cfg->trace_path, ret);
+		return ret;
+	}
+
+	if (trace->has_cache_desc) {
+		if (trace->cache_desc.version != OCF_EVENT_VERSION) {
+			printf("Trace version %u differs from %u\n",
+					trace->cache_desc.version,
+					OCF_EVENT_VERSION);
+		}
+		if (!cfg->cache_size)
+			cfg->cache_size = trace->cache_desc.cache_size;
+		if (!line_set)
+			cfg->cache_line_size =
+				trace->cache_desc.cache_line_size;
+		if (!mode_set)
+			cfg->cache_mode = trace->cache_desc.cache_mode;
+	} else {
+		if (!line_set)
+			cfg->cache_line_size = ocf_cache_line_size_default;
+		if (!mode_set)
+			cfg->cache_mode = ocf_cache_mode_default;
+	}
+
+	if (!cfg->cache_size) {
+		printf("Cache size not traced, use -c to set it\n");
+		return -EINVAL;
+	}
+
+	if (!trace->io_count) {
+		printf("No I/O in trace\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct replay *replay;
+	uint64_t elapsed_ns;
+	int ret;
+
+	replay = calloc(1, sizeof(*replay));
+	if (!replay)
+		return 1;
+
+	if (parse_args(replay, argc, argv)) {
+		usage(argv[0]);
+		trace_free(&replay->trace);
+		free(replay);
+		return 1;
+	}
+
+	printf("Trace: %llu I/Os, %llu other events\n",
+			(unsigned long long)replay->trace.io_count,
+			(unsigned long long)replay->trace.skipped);
+
+	ret = replay_slots_init(replay);
+	if (ret) {
+		printf("Failed to allocate I/O buffers\n");
+		goto err_slots;
+	}
+
+	ret = ctx_init(&replay->ctx);
+	if (ret) {
+		printf("Unable to initialize context (%d)\n", ret);
+		goto err_slots;
+	}
+
+	ret = replay_start_cache(replay);
+	if (ret) {
+		printf("Unable to start cache (%d)\n", ret);
+		goto err_ctx;
+	}
+
+	ret = replay_add_cores(replay);
+	if (ret) {
+		printf("Unable to add core (%d)\n", ret);
+		replay_stop_cache(replay);
+		goto err_ctx;
+	}
+
+	ocf_mngt_cache_unlock(replay->cache);
+
+	elapsed_ns = replay_run(replay);
+	replay_report(replay, elapsed_ns);
+
+	ocf_mngt_cache_lock(replay->cache);
+	replay_stop_cache(replay);
+
+err_ctx:
+	ctx_cleanup(replay->ctx);
+err_slots:
+	replay_slots_deinit(replay);
+	trace_free(&replay->trace);
+	free(replay);
+
+	return ret ? 1 : 0;
+}
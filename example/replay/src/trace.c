@@ -0,0 +1,170 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "trace.h"
+
+static int trace_io_cmp(const void *a, const void *b)
+{
+	const struct trace_io *io_a = a, *io_b = b;
+
+	if (io_a->timestamp != io_b->timestamp)
+		return io_a->timestamp < io_b->timestamp ? -1 : 1;
+
+	return io_a->seq < io_b->seq ? -1 : io_a->seq > io_b->seq;
+}
+
+static int trace_add_io(struct trace *trace, const struct ocf_event_io *ev,
+		uint64_t *capacity)
+{
+	struct trace_io *io, *ios;
+	uint64_t end;
+
+	if (ev->core_id >= OCF_CORE_MAX)
+		return -EINVAL;
+
+	if (trace->io_count == *capacity) {
+		*capacity = *capacity ? *capacity * 2 : 4096;
+		ios = realloc(trace->ios, *capacity * sizeof(*ios));
+		if (!ios)
+			return -ENOMEM;
+		trace->ios = ios;
+	}
+
+	io = &trace->ios[trace->io_count];
+	io->timestamp = ev->hdr.timestamp;
+	io->seq = trace->io_count++;
+	io->addr = ev->addr;
+	io->len = ev->len;
+	io->io_class = ev->io_class;
+	io->core_id = ev->core_id;
+	io->operation = ev->operation;
+
+	if (io->len > trace->max_io_len)
+		trace->max_io_len = io->len;
+
+	/* Size cores without description to fit all their I/Os */
+	end = io->addr + io->len;
+	if (!trace->has_core[io->core_id] &&
+			end > trace->core_size[io->core_id]) {
+		trace->core_size[io->core_id] = end;
+	}
+
+	return 0;
+}
+
+static int trace_parse_event(struct trace *trace, const uint8_t *ev,
+		const struct ocf_event_hdr *hdr, uint64_t *capacity)
+{
+	struct ocf_event_core_desc core_desc;
+	struct ocf_event_io io;
+
+	switch (hdr->type) {
+	case ocf_event_type_cache_desc:
+		if (hdr->size < sizeof(trace->cache_desc))
+			return -EINVAL;
+		memcpy(&trace->cache_desc, ev, sizeof(trace->cache_desc));
+		trace->has_cache_desc = true;
+		return 0;
+	case ocf_event_type_core_desc:
+		if (hdr->size < sizeof(core_desc))
+			return -EINVAL;
+		memcpy(&core_desc, ev, sizeof(core_desc));
+		if (core_desc.id >= OCF_CORE_MAX)
+			return -EINVAL;
+		trace->has_core[core_desc.id] = true;
+		trace->core_size[core_desc.id] = core_desc.core_size;
+		return 0;
+	case ocf_event_type_io:
+		if (hdr->size < sizeof(io))
+			return -EINVAL;
+		memcpy(&io, ev, sizeof(io));
+		return trace_add_io(trace, &io, capacity);
+	default:
+		trace->skipped++;
+		return 0;
+	}
+}
+
+/*
+ * Read whole trace file, collect cache and core descriptions and I/O events
+ * sorted by time stamps. Events traced on different queues are not ordered
+ * in trace file, so sorting restores their original order.
+ */
+int trace_load(struct trace *trace, const char *path)
+{
+	struct ocf_event_hdr hdr;
+	uint64_t capacity = 0;
+	struct stat st;
+	uint8_t *buf;
+	size_t off;
+	FILE *file;
+	int ret = 0;
+
+	memset(trace, 0, sizeof(*trace));
+
+	file = fopen(path, "rb");
+	if (!file)
+		return -errno;
+
+	if (fstat(fileno(file), &st)) {
+		ret = -errno;
+		fclose(file);
+		return ret;
+	}
+
+	buf = malloc(st.st_size ?: 1);
+	if (!buf) {
+		fclose(file);
+		return -ENOMEM;
+	}
+
+	if (fread(buf, 1, st.st_size, file) != st.st_size) {
+		free(buf);
+		fclose(file);
+		return -EIO;
+	}
+
+	fclose(file);
+
+	for (off = 0; off < st.st_size; off += hdr.size) {
+		if (st.st_size - off < sizeof(hdr)) {
+			ret = -EINVAL;
+			break;
+		}
+
+		memcpy(&hdr, buf + off, sizeof(hdr));
+		if (hdr.size < sizeof(hdr) || hdr.size > st.st_size - off) {
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = trace_parse_event(trace, buf + off, &hdr, &capacity);
+		if (ret)
+			break;
+	}
+
+	free(buf);
+
+	if (ret) {
+		trace_free(trace);
+		return ret;
+	}
+
+	qsort(trace->ios, trace->io_count, sizeof(*trace->ios), trace_io_cmp);
+
+	return 0;
+}
+
+void trace_free(struct trace *trace)
+{
+	free(trace->ios);
+	trace->ios = NULL;
+	trace->io_count = 0;
+}
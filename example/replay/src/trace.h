@@ -0,0 +1,54 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <ocf/ocf.h>
+
+/*
+ * Trace file is a sequence of OCF trace events stored back to back, exactly
+ * as they are passed to ocf_trace_callback_t or drained from trace rings
+ * with ocf_trace_ring_drain(). Each event starts with struct ocf_event_hdr
+ * holding its size. Cache and core description events set up replay cache,
+ * I/O events are replayed in order of their timestamps, other events are
+ * skipped.
+ */
+
+struct trace_io {
+	uint64_t timestamp;
+		/*!< Time stamp of I/O in nanoseconds */
+
+	uint64_t seq;
+		/*!< Position of I/O in trace file */
+
+	uint64_t addr;
+	uint32_t len;
+	uint32_t io_class;
+	ocf_core_id_t core_id;
+	ocf_event_operation_t operation;
+};
+
+struct trace {
+	bool has_cache_desc;
+	struct ocf_event_cache_desc cache_desc;
+
+	bool has_core[OCF_CORE_MAX];
+	uint64_t core_size[OCF_CORE_MAX];
+		/*!< Core size from core description, or extent of I/Os
+		 * traced on core if there was no description */
+
+	struct trace_io *ios;
+	uint64_t io_count;
+
+	uint32_t max_io_len;
+	uint64_t skipped;
+		/*!< Number of events other than I/O and descriptions */
+};
+
+int trace_load(struct trace *trace, const char *path);
+void trace_free(struct trace *trace);
+
+#endif
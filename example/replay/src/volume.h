@@ -0,0 +1,35 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __VOLUME_H__
+#define __VOLUME_H__
+
+#include <ocf/ocf.h>
+#include "ocf_env.h"
+#include "ctx.h"
+#include "data.h"
+
+/*
+ * Volume UUID has form of "<backend>:<size in bytes>", where backend is
+ * either "ram" (data kept in memory) or "null" (writes are dropped, reads
+ * return zeros).
+ */
+#define VOLUME_UUID_MAX 64
+
+struct myvolume_io {
+	struct volume_data *data;
+	uint32_t offset;
+};
+
+struct myvolume {
+	uint8_t *mem;
+	uint64_t length;
+	const char *name;
+};
+
+int volume_init(ocf_ctx_t ocf_ctx);
+void volume_cleanup(ocf_ctx_t ocf_ctx);
+
+#endif
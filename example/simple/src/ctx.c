@@ -8,6 +8,7 @@
 #include "ocf_env.h"
 #include "data.h"
 #include "volume.h"
+#include "uring_volume.h"
 #include "ctx.h"
 
 #define PAGE_SIZE 4096
@@ -126,6 +127,22 @@ static uint64_t ctx_data_copy(ctx_data_t *dst, ctx_data_t *src,
 	return bytes;
 }
 
+/*
+ * Check if data range holds only zeroes.
+ */
+static bool ctx_data_is_zero(ctx_data_t *src, uint64_t from, uint64_t bytes)
+{
+	struct volume_data *data = src;
+	const char *ptr = data->ptr + from;
+
+	while (bytes--) {
+		if (*ptr++)
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * Perform secure erase of data (e.g. fill pages with zeros).
  * Can be left non-implemented if not needed.
@@ -239,6 +256,7 @@ static const struct ocf_ctx_config ctx_cfg = {
 			.zero = ctx_data_zero,
 			.seek = ctx_data_seek,
 			.copy = ctx_data_copy,
+			.is_zero = ctx_data_is_zero,
 			.secure_erase = ctx_data_secure_erase,
 		},
 
@@ -279,6 +297,13 @@ int ctx_init(ocf_ctx_t *ctx)
 		return ret;
 	}
 
+	ret = uring_volume_init(*ctx);
+	if (ret) {
+		volume_cleanup(*ctx);
+		ocf_ctx_exit(*ctx);
+		return ret;
+	}
+
 	return 0;
 }
 
@@ -288,6 +313,7 @@ int ctx_init(ocf_ctx_t *ctx)
  */
 void ctx_cleanup(ocf_ctx_t ctx)
 {
+	uring_volume_cleanup(ctx);
 	volume_cleanup(ctx);
 	ocf_ctx_exit(ctx);
 }
@@ -0,0 +1,460 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <ocf/ocf.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <linux/falloc.h>
+#include <linux/io_uring.h>
+#include "uring_volume.h"
+#include "data.h"
+#include "ctx.h"
+
+/*
+ * Volume backed by file or block device with path given as volume uuid.
+ * IOs are submitted to io_uring of the volume and completed by thread
+ * reaping its completion queue. io_uring syscalls are used directly, so
+ * that example doesn't depend on liburing.
+ */
+
+#define URING_ENTRIES		256
+#define URING_STOP		0ULL
+
+static int uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+		unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+			flags, NULL, 0);
+}
+
+/*
+ * Take submission queue entry, waiting for reaper to free some space when
+ * queue is full. Called with submission queue lock held.
+ */
+static struct io_uring_sqe *uring_get_sqe(struct uring_volume_ring *ring)
+{
+	unsigned tail = *ring->sq_tail;
+
+	while (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >=
+			ring->sq_entries) {
+		if (!(ring->flags & IORING_SETUP_SQPOLL))
+			uring_enter(ring->fd, 0, 0, 0);
+		sched_yield();
+	}
+
+	return &ring->sqes[tail & *ring->sq_mask];
+}
+
+/*
+ * Publish entry taken with uring_get_sqe(). With kernel submission thread
+ * no syscall is needed unless the thread went idle. Called with submission
+ * queue lock held.
+ */
+static void uring_commit_sqe(struct uring_volume_ring *ring)
+{
+	unsigned tail = *ring->sq_tail;
+
+	ring->sq_array[tail & *ring->sq_mask] = tail & *ring->sq_mask;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	if (ring->flags & IORING_SETUP_SQPOLL) {
+		if (__atomic_load_n(ring->sq_flags, __ATOMIC_ACQUIRE) &
+				IORING_SQ_NEED_WAKEUP) {
+			uring_enter(ring->fd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+		}
+	} else {
+		uring_enter(ring->fd, 1, 0, 0);
+	}
+}
+
+/*
+ * Queue operation on volume file. Meaning of buf, len and flags follows
+ * the opcode, e.g. fallocate takes length in buf and mode in len.
+ */
+static void uring_submit(struct uring_volume *uvolume, uint8_t opcode,
+		uint64_t addr, uint64_t buf, uint32_t len, uint32_t flags,
+		uint64_t user_data)
+{
+	struct uring_volume_ring *ring = &uvolume->ring;
+	struct io_uring_sqe *sqe;
+
+	pthread_mutex_lock(&ring->sq_lock);
+
+	sqe = uring_get_sqe(ring);
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->fd = uvolume->fd;
+	sqe->off = addr;
+	sqe->addr = buf;
+	sqe->len = len;
+	sqe->rw_flags = flags;
+	sqe->user_data = user_data;
+
+	uring_commit_sqe(ring);
+
+	pthread_mutex_unlock(&ring->sq_lock);
+}
+
+static int uring_cqe_error(struct ocf_io *io, struct io_uring_cqe *cqe)
+{
+	struct uring_volume_io *uio = ocf_io_get_priv(io);
+
+	if (cqe->res < 0)
+		return cqe->res;
+	if (uio->data_io && cqe->res != io->bytes)
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * Completion reaper. Runs until stop marker posted by close() comes back.
+ */
+static void *uring_reaper(void *arg)
+{
+	struct uring_volume_ring *ring = arg;
+	struct ocf_io *ios[URING_ENTRIES];
+	int errors[URING_ENTRIES];
+	struct io_uring_cqe *cqe;
+	unsigned head, tail, count;
+	bool stop = false;
+
+	while (!stop) {
+		head = *ring->cq_head;
+		tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+		if (head == tail) {
+			uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS);
+			continue;
+		}
+
+		/* Reap available completions and end their IOs at once, so that
+		 * IOs of the same OCF request are accounted together
+		 */
+		for (count = 0; head != tail && count < URING_ENTRIES; head++) {
+			cqe = &ring->cqes[head & *ring->cq_mask];
+			if (cqe->user_data == URING_STOP) {
+				stop = true;
+				continue;
+			}
+
+			ios[count] = (struct ocf_io *)(uintptr_t)cqe->user_data;
+			errors[count] = uring_cqe_error(ios[count], cqe);
+			count++;
+		}
+
+		__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+		ocf_io_end_batch(ios, errors, count);
+	}
+
+	return NULL;
+}
+
+static void uring_ring_unmap(struct uring_volume_ring *ring)
+{
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_len);
+	if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_len);
+	if (ring->sq_ptr)
+		munmap(ring->sq_ptr, ring->sq_len);
+}
+
+/*
+ * Set up ring, preferably with kernel thread polling submission queue so
+ * that submit_io() usually doesn't enter the kernel at all.
+ */
+static int uring_ring_init(struct uring_volume_ring *ring)
+{
+	struct io_uring_params p;
+	int ret;
+
+	memset(ring, 0, sizeof(*ring));
+
+	memset(&p, 0, sizeof(p));
+	p.flags = IORING_SETUP_SQPOLL;
+	p.sq_thread_idle = 1000;
+	ring->fd = uring_setup(URING_ENTRIES, &p);
+	if (ring->fd < 0) {
+		/* Unprivileged or old kernel, submit with syscalls */
+		memset(&p, 0, sizeof(p));
+		ring->fd = uring_setup(URING_ENTRIES, &p);
+	}
+	if (ring->fd < 0)
+		return -errno;
+
+	ring->flags = p.flags;
+
+	ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_len = p.cq_off.cqes +
+			p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_len > ring->sq_len)
+			ring->sq_len = ring->cq_len;
+		ring->cq_len = ring->sq_len;
+	}
+
+	ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ptr == MAP_FAILED) {
+		ring->sq_ptr = NULL;
+		goto err;
+	}
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ptr = ring->sq_ptr;
+	} else {
+		ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ring->fd,
+				IORING_OFF_CQ_RING);
+		if (ring->cq_ptr == MAP_FAILED) {
+			ring->cq_ptr = NULL;
+			goto err;
+		}
+	}
+
+	ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto err;
+	}
+
+	ring->sq_head = ring->sq_ptr + p.sq_off.head;
+	ring->sq_tail = ring->sq_ptr + p.sq_off.tail;
+	ring->sq_mask = ring->sq_ptr + p.sq_off.ring_mask;
+	ring->sq_flags = ring->sq_ptr + p.sq_off.flags;
+	ring->sq_array = ring->sq_ptr + p.sq_off.array;
+	ring->sq_entries = p.sq_entries;
+
+	ring->cq_head = ring->cq_ptr + p.cq_off.head;
+	ring->cq_tail = ring->cq_ptr + p.cq_off.tail;
+	ring->cq_mask = ring->cq_ptr + p.cq_off.ring_mask;
+	ring->cqes = ring->cq_ptr + p.cq_off.cqes;
+
+	pthread_mutex_init(&ring->sq_lock, NULL);
+
+	ret = pthread_create(&ring->reaper, NULL, uring_reaper, ring);
+	if (ret) {
+		errno = ret;
+		goto err;
+	}
+
+	return 0;
+
+err:
+	ret = -errno;
+	uring_ring_unmap(ring);
+	close(ring->fd);
+	return ret;
+}
+
+static void uring_ring_deinit(struct uring_volume *uvolume)
+{
+	struct uring_volume_ring *ring = &uvolume->ring;
+
+	/* All IOs are completed by now, stop marker is the last completion */
+	uring_submit(uvolume, IORING_OP_NOP, 0, 0, 0, 0, URING_STOP);
+	pthread_join(ring->reaper, NULL);
+
+	pthread_mutex_destroy(&ring->sq_lock);
+	uring_ring_unmap(ring);
+	close(ring->fd);
+}
+
+/*
+ * In open() function we open file or block device with path given in uuid
+ * and set up io_uring serving its IOs.
+ */
+static int uring_volume_open(ocf_volume_t volume, void *volume_params)
+{
+	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(volume);
+	struct uring_volume *uvolume = ocf_volume_get_priv(volume);
+	struct stat st;
+	int ret;
+
+	uvolume->name = ocf_uuid_to_str(uuid);
+
+	uvolume->fd = open(uvolume->name, O_RDWR);
+	if (uvolume->fd < 0)
+		return -errno;
+
+	if (fstat(uvolume->fd, &st)) {
+		ret = -errno;
+		goto err;
+	}
+
+	if (S_ISBLK(st.st_mode)) {
+		if (ioctl(uvolume->fd, BLKGETSIZE64, &uvolume->length)) {
+			ret = -errno;
+			goto err;
+		}
+	} else {
+		uvolume->length = st.st_size;
+	}
+
+	ret = uring_ring_init(&uvolume->ring);
+	if (ret)
+		goto err;
+
+	printf("URING VOL OPEN: (name: %s, sq poll: %s)\n", uvolume->name,
+			uvolume->ring.flags & IORING_SETUP_SQPOLL ?
+			"yes" : "no");
+
+	return 0;
+
+err:
+	close(uvolume->fd);
+	return ret;
+}
+
+/*
+ * In close() function we stop io_uring and close the file.
+ */
+static void uring_volume_close(ocf_volume_t volume)
+{
+	struct uring_volume *uvolume = ocf_volume_get_priv(volume);
+
+	printf("URING VOL CLOSE: (name: %s)\n", uvolume->name);
+
+	uring_ring_deinit(uvolume);
+	close(uvolume->fd);
+}
+
+/*
+ * In submit_io() function we queue read or write of data buffer at offset
+ * set by set_data(). IO is completed by the reaper thread.
+ */
+static void uring_volume_submit_io(struct ocf_io *io)
+{
+	struct uring_volume *uvolume = ocf_volume_get_priv(io->volume);
+	struct uring_volume_io *uio = ocf_io_get_priv(io);
+
+	uio->data_io = true;
+	uring_submit(uvolume, io->dir == OCF_WRITE ?
+			IORING_OP_WRITE : IORING_OP_READ, io->addr,
+			(uintptr_t)(uio->data->ptr + uio->offset), io->bytes,
+			0, (uintptr_t)io);
+}
+
+/*
+ * In submit_flush() function we sync written data with fdatasync().
+ */
+static void uring_volume_submit_flush(struct ocf_io *io)
+{
+	struct uring_volume *uvolume = ocf_volume_get_priv(io->volume);
+	struct uring_volume_io *uio = ocf_io_get_priv(io);
+
+	uio->data_io = false;
+	uring_submit(uvolume, IORING_OP_FSYNC, 0, 0, 0, IORING_FSYNC_DATASYNC,
+			(uintptr_t)io);
+}
+
+/*
+ * In submit_discard() function we punch hole in the backing file. Block
+ * devices and filesystems not supporting it report error.
+ */
+static void uring_volume_submit_discard(struct ocf_io *io)
+{
+	struct uring_volume *uvolume = ocf_volume_get_priv(io->volume);
+	struct uring_volume_io *uio = ocf_io_get_priv(io);
+
+	uio->data_io = false;
+	uring_submit(uvolume, IORING_OP_FALLOCATE, io->addr, io->bytes,
+			FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0,
+			(uintptr_t)io);
+}
+
+/*
+ * Let's set maximum io size to 128 KiB.
+ */
+static unsigned int uring_volume_get_max_io_size(ocf_volume_t volume)
+{
+	return 128 * 1024;
+}
+
+/*
+ * Return volume size.
+ */
+static uint64_t uring_volume_get_length(ocf_volume_t volume)
+{
+	struct uring_volume *uvolume = ocf_volume_get_priv(volume);
+
+	return uvolume->length;
+}
+
+/*
+ * In set_data() we just assing data and offset to io.
+ */
+static int uring_volume_io_set_data(struct ocf_io *io, ctx_data_t *data,
+		uint32_t offset)
+{
+	struct uring_volume_io *uio = ocf_io_get_priv(io);
+
+	uio->data = data;
+	uio->offset = offset;
+
+	return 0;
+}
+
+/*
+ * In get_data() return data stored in io.
+ */
+static ctx_data_t *uring_volume_io_get_data(struct ocf_io *io)
+{
+	struct uring_volume_io *uio = ocf_io_get_priv(io);
+
+	return uio->data;
+}
+
+const struct ocf_volume_properties uring_volume_properties = {
+	.name = "Example io_uring volume",
+	.io_priv_size = sizeof(struct uring_volume_io),
+	.volume_priv_size = sizeof(struct uring_volume),
+	.caps = {
+		.atomic_writes = 0,
+	},
+	.ops = {
+		.open = uring_volume_open,
+		.close = uring_volume_close,
+		.submit_io = uring_volume_submit_io,
+		.submit_flush = uring_volume_submit_flush,
+		.submit_discard = uring_volume_submit_discard,
+		.get_max_io_size = uring_volume_get_max_io_size,
+		.get_length = uring_volume_get_length,
+	},
+	.io_ops = {
+		.set_data = uring_volume_io_set_data,
+		.get_data = uring_volume_io_get_data,
+	},
+};
+
+/*
+ * This function registers io_uring volume type in OCF context.
+ */
+int uring_volume_init(ocf_ctx_t ocf_ctx)
+{
+	return ocf_ctx_register_volume_type(ocf_ctx, URING_VOL_TYPE,
+			&uring_volume_properties);
+}
+
+/*
+ * This function unregisters io_uring volume type from OCF context.
+ */
+void uring_volume_cleanup(ocf_ctx_t ocf_ctx)
+{
+	ocf_ctx_unregister_volume_type(ocf_ctx, URING_VOL_TYPE);
+}
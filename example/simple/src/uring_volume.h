@@ -0,0 +1,52 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __URING_VOLUME_H__
+#define __URING_VOLUME_H__
+
+#include <ocf/ocf.h>
+#include "ocf_env.h"
+#include "ctx.h"
+#include "data.h"
+
+struct uring_volume_io {
+	struct volume_data *data;
+	uint32_t offset;
+	bool data_io;
+};
+
+struct uring_volume_ring {
+	int fd;
+
+	/* Submission queue */
+	void *sq_ptr;
+	size_t sq_len;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array;
+	unsigned sq_entries;
+	struct io_uring_sqe *sqes;
+	size_t sqes_len;
+	pthread_mutex_t sq_lock;
+
+	/* Completion queue */
+	void *cq_ptr;
+	size_t cq_len;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	unsigned flags;
+	pthread_t reaper;
+};
+
+struct uring_volume {
+	int fd;
+	uint64_t length;
+	const char *name;
+	struct uring_volume_ring ring;
+};
+
+int uring_volume_init(ocf_ctx_t ocf_ctx);
+void uring_volume_cleanup(ocf_ctx_t ocf_ctx);
+
+#endif
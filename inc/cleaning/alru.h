@@ -15,6 +15,8 @@ enum ocf_cleaning_alru_parameters {
 	ocf_alru_stale_buffer_time,
 	ocf_alru_flush_max_buffers,
 	ocf_alru_activity_threshold,
+	ocf_alru_lba_window,
+	ocf_alru_hot_deferral,
 };
 
 /**
@@ -66,6 +68,36 @@ enum ocf_cleaning_alru_parameters {
 /** Idle time before flushing thread can start default value */
 #define OCF_ALRU_DEFAULT_ACTIVITY_THRESHOLD	10000
 
+/**
+ * ALRU number of cleaning batches worth of stale dirty cache lines collected
+ * in one cycle. Lines collected are cleaned in order of core LBA, going up
+ * from position where previous cycle stopped on each core. Value of 1 cleans
+ * lines in order of their age.
+ */
+
+/** LBA ordering window minimum value */
+#define OCF_ALRU_MIN_LBA_WINDOW			1
+/** LBA ordering window maximum value */
+#define OCF_ALRU_MAX_LBA_WINDOW			64
+/** LBA ordering window default value */
+#define OCF_ALRU_DEFAULT_LBA_WINDOW		1
+
+/**
+ * ALRU maximum deferral of cleaning of frequently rewritten cache lines.
+ * Line which gets dirty again shortly after it was cleaned is considered
+ * hot, and each such rewrite extends staleness time required to clean it
+ * by one staleness time, up to given number of staleness times. Lines are
+ * cleaned without deferral when partition is under dirty pressure.
+ * Value of 0 disables deferral.
+ */
+
+/** Hot line deferral minimum value */
+#define OCF_ALRU_MIN_HOT_DEFERRAL		0
+/** Hot line deferral maximum value */
+#define OCF_ALRU_MAX_HOT_DEFERRAL		15
+/** Hot line deferral default value */
+#define OCF_ALRU_DEFAULT_HOT_DEFERRAL		4
+
 /**
  * @}
  */
@@ -59,7 +59,8 @@ struct ocf_cache_info {
 	/* Statistics of fallback Pass Through */
 	struct {
 		int error_counter;
-			/*!< How many requests to cache failed because of IO error */
+			/*!< How many requests to cache failed because of IO error,
+			  counting stops once error threshold is reached */
 
 		bool status;
 			/*!< Current cache mode is PT,
@@ -229,6 +230,78 @@ uint32_t ocf_cache_get_core_count(ocf_cache_t cache);
  */
 int ocf_cache_get_info(ocf_cache_t cache, struct ocf_cache_info *info);
 
+/** Maximum number of metadata segments reported in memory usage */
+#define OCF_CACHE_MEMORY_SEGMENTS_MAX	16
+
+/** Number of request allocator size classes reported in memory usage */
+#define OCF_CACHE_MEMORY_REQ_CLASSES	13
+
+/**
+ * @brief Memory footprint of cache per subsystem, in bytes
+ */
+struct ocf_cache_memory_usage {
+	struct {
+		const char *name;
+		uint64_t bytes;
+	} segments[OCF_CACHE_MEMORY_SEGMENTS_MAX];
+		/*!< Metadata segments, only resident pages of dynamic ones */
+
+	uint32_t segments_count;
+
+	uint64_t metadata_other;
+		/*!< Volatile lookup table, free map, lookup filter and trim map */
+
+	uint64_t concurrency;
+		/*!< Cache line locks and waiters lists */
+
+	uint32_t waiters_allocs;
+		/*!< Waiter allocations of requests waiting for cache lines */
+
+	uint64_t waiters;
+		/*!< Memory of waiter allocations */
+
+	uint64_t cleaning;
+		/*!< Cleaning policy structures outside of metadata */
+
+	uint64_t promotion;
+		/*!< Promotion policy data */
+
+	uint64_t trace;
+		/*!< Trace rings of I/O queues */
+
+	uint64_t stats;
+		/*!< Statistics counters of cores */
+
+	uint64_t total;
+		/*!< Sum of all above */
+
+	struct {
+		uint32_t lines;
+			/*!< Cache lines of request (or map only) of class */
+		uint32_t items;
+			/*!< Allocated items */
+		uint64_t bytes;
+			/*!< Memory of allocated items */
+	} req_classes[OCF_CACHE_MEMORY_REQ_CLASSES];
+		/*!< Request allocators shared by all caches of context, not
+		 * included in total
+		 */
+};
+
+/**
+ * @brief Get memory footprint of cache per subsystem
+ *
+ * Values are snapshot of counters read without locking out I/O.
+ *
+ * @param[in] cache Cache object
+ * @param[out] usage Memory usage
+ *
+ * @retval 0 Success
+ * @retval Non-zero Fail
+ */
+int ocf_cache_get_memory_usage(ocf_cache_t cache,
+		struct ocf_cache_memory_usage *usage);
+
 /**
  * @brief Get UUID of volume associated with cache
  *
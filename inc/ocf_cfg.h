@@ -28,7 +28,619 @@
 #error "Limit of maximum number of IO classes exceeded"
 #endif
 
-/** Enabling debug statistics */
+/**
+ * Number of locks protecting cache line status (valid/dirty) bits. Cache
+ * lines are spread over the locks by cache line index, so status updates of
+ * different cache lines don't serialize. Setting it to 1 makes a single
+ * cache-wide status lock.
+ */
+#ifndef OCF_CONFIG_METADATA_STATUS_LOCKS
+#define OCF_CONFIG_METADATA_STATUS_LOCKS 1024
+#endif
+
+#if OCF_CONFIG_METADATA_STATUS_LOCKS < 1
+#error "At least one status bits lock is required"
+#endif
+
+/**
+ * Checksum metadata with CRC32C instead of CRC32. Environment may implement
+ * CRC32C with CPU instructions. The algorithm is part of metadata version,
+ * so metadata checksummed with the other one is reported as version
+ * mismatch on load.
+ */
+#ifndef OCF_CONFIG_METADATA_CRC32C
+#define OCF_CONFIG_METADATA_CRC32C 0
+#endif
+
+#if OCF_CONFIG_METADATA_CRC32C != 0 && OCF_CONFIG_METADATA_CRC32C != 1
+#error "Invalid metadata checksum selection"
+#endif
+
+/**
+ * Compact metadata format, which keeps core line of each cache line in 32
+ * instead of 64 bits. It saves 4 bytes of RAM and metadata per cache line,
+ * but limits size of each core to (2^32 - 1) cache lines of the smallest
+ * size, i.e. a bit less than 16 TiB. The format is part of metadata version.
+ */
+#ifndef OCF_CONFIG_METADATA_COMPACT
+#define OCF_CONFIG_METADATA_COMPACT 0
+#endif
+
+#if OCF_CONFIG_METADATA_COMPACT != 0 && OCF_CONFIG_METADATA_COMPACT != 1
+#error "Invalid metadata format selection"
+#endif
+
+/**
+ * Cleaning policies built in, bit mask of (1 << ocf_cleaning_t) values.
+ * Per cache line cleaning metadata is sized for the largest policy built in,
+ * so leaving out ALRU saves 11 bytes of RAM and metadata per cache line and
+ * leaving out ACP as well saves another one. Cleaning policy may be switched
+ * only to policies built in, default policy is the first available of ALRU,
+ * ACP and NOP. The mask is part of metadata version.
+ */
+#ifndef OCF_CONFIG_CLEANING_POLICIES
+#define OCF_CONFIG_CLEANING_POLICIES 0x7
+#endif
+
+#if !(OCF_CONFIG_CLEANING_POLICIES & 0x1) || (OCF_CONFIG_CLEANING_POLICIES & ~0x7)
+#error "Invalid cleaning policies selection, NOP policy is required"
+#endif
+
+/**
+ * Track pages of per cache line metadata modified since they were last
+ * loaded or flushed as a whole, so that flushing all metadata on cache stop
+ * writes only modified pages of these segments. Superblock, core metadata
+ * and checksums are always written.
+ */
+#ifndef OCF_CONFIG_METADATA_FLUSH_MODIFIED_ONLY
+#define OCF_CONFIG_METADATA_FLUSH_MODIFIED_ONLY 0
+#endif
+
+/**
+ * Interval in seconds of background checkpoint of modified pages of per cache
+ * line metadata in caches which can't hold dirty data, so that flushing all
+ * metadata on cache stop has only pages modified since last checkpoint left
+ * to write. Checkpoints are started by cleaner runs, 0 disables them.
+ */
+#ifndef OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL
+#define OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL 0
+#endif
+
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0 && \
+		!OCF_CONFIG_METADATA_FLUSH_MODIFIED_ONLY
+#error "Metadata checkpoint requires tracking of modified metadata pages"
+#endif
+
+/**
+ * Back RAM metadata containers of at least 2 MiB with huge pages allocated by
+ * env_vzalloc_huge(), which lowers TLB pressure of metadata lookups. When
+ * environment cannot provide huge pages regular memory is used.
+ */
+#ifndef OCF_CONFIG_METADATA_HUGE_PAGES
+#define OCF_CONFIG_METADATA_HUGE_PAGES 0
+#endif
+
+/**
+ * Keep in-memory copy of the collision table fields read by lookup (core
+ * line, core id and next collision) packed together per cache line, so that
+ * each hop of hash chain walk touches single CPU cache line. Costs 16 bytes
+ * of RAM per cache line; persistent metadata format is not affected.
+ */
+#ifndef OCF_CONFIG_METADATA_LOOKUP_PACKED
+#define OCF_CONFIG_METADATA_LOOKUP_PACKED 0
+#endif
+
+/**
+ * Keep replica of data read by lookup - hash table and packed collision
+ * entries - on each of up to this many NUMA nodes, so that lookups don't
+ * read remote memory. Lookup reads replica of node of calling CPU, setters
+ * update all replicas. Costs 16 bytes per cache line and 4 bytes per hash
+ * table entry of RAM on each node. Setting it to 0 disables replication.
+ */
+#ifndef OCF_CONFIG_METADATA_LOOKUP_NODES
+#define OCF_CONFIG_METADATA_LOOKUP_NODES 0
+#endif
+
+/**
+ * Bind metadata accessors used on I/O path to hash layout at compile time.
+ * Accessors are inlined and read entries of RAM backed containers in place,
+ * other containers are still read through metadata interface.
+ */
+#ifndef OCF_CONFIG_METADATA_INLINE
+#define OCF_CONFIG_METADATA_INLINE 0
+#endif
+
+/**
+ * Number of core lines of request looked up together. Hash buckets of the
+ * group are prefetched at once and their chains walked interleaved, one hop
+ * of each at a time, so that memory latency of lookups overlaps. Set to 0 to
+ * look up core lines one by one. At most 32.
+ */
+#ifndef OCF_CONFIG_LOOKUP_BATCH
+#define OCF_CONFIG_LOOKUP_BATCH 16
+#endif
+
+#if OCF_CONFIG_LOOKUP_BATCH > 32
+#error "Lookup batch is limited to 32 core lines"
+#endif
+
+/**
+ * Keep counting filter of core lines mapped in each hash bucket, indexed by
+ * fingerprint of core line, so that lookup of most core lines which are not
+ * mapped is answered without walking collision chain. Costs 8 bytes of RAM
+ * per hash bucket; persistent metadata format is not affected.
+ */
+#ifndef OCF_CONFIG_LOOKUP_FILTER
+#define OCF_CONFIG_LOOKUP_FILTER 0
+#endif
+
+/**
+ * Track cache lines of partitions only by partition id of each cache line
+ * and occupancy counter of partition, instead of linking them into per
+ * partition lists. Adding, removing and moving cache line between partitions
+ * becomes counter update, but walk over cache lines of partition has to scan
+ * the whole collision table. Free list is kept in bitmap of free cache lines,
+ * so cache line metadata has no partition links, which saves 8 bytes per
+ * cache line. Metadata written with it enabled is not loaded without it and
+ * vice versa.
+ */
+#ifndef OCF_CONFIG_PARTITION_COUNTERS
+#define OCF_CONFIG_PARTITION_COUNTERS 0
+#endif
+
+/**
+ * Maximum number of metadata pages written by single combined flush. Requests
+ * which flush metadata while previous flush is in progress join a common
+ * batch, which writes each dirtied page once when previous flush completes.
+ * Requests are completed only after all their pages are written. Setting it
+ * to 0 makes each request write its own pages.
+ */
+#ifndef OCF_CONFIG_METADATA_FLUSH_COMBINE_PAGES
+#define OCF_CONFIG_METADATA_FLUSH_COMBINE_PAGES 0
+#endif
+
+/**
+ * Maximum number of metadata IOs in flight to cache device, 0 for no limit.
+ * Requests above the limit wait in metadata updater, which writes contiguous
+ * pages of waiting requests with single IO once they are started.
+ */
+#ifndef OCF_CONFIG_METADATA_IO_QD
+#define OCF_CONFIG_METADATA_IO_QD 0
+#endif
+
+/**
+ * Maximum number of pages of single metadata IO, 0 to use max IO size of
+ * cache volume
+ */
+#ifndef OCF_CONFIG_METADATA_IO_MAX_PAGES
+#define OCF_CONFIG_METADATA_IO_MAX_PAGES 0
+#endif
+
+/**
+ * Size in MiB of RAM tier, which keeps copies of cache lines recently read
+ * from cache device so that following reads of them are served from memory,
+ * 0 disables RAM tier
+ */
+#ifndef OCF_CONFIG_RAM_TIER_SIZE
+#define OCF_CONFIG_RAM_TIER_SIZE 0
+#endif
+
+/**
+ * Serve reads of cache lines being backfilled from data copied by read miss
+ * which inserts them, instead of waiting for cache line lock held by the
+ * backfill
+ */
+#ifndef OCF_CONFIG_HIT_UNDER_FILL
+#define OCF_CONFIG_HIT_UNDER_FILL 0
+#endif
+
+/**
+ * Keep cache lines written with zeroes as zero lines, which are marked in
+ * metadata and not written to cache device. Reads of zero lines are served
+ * by zero-filling request data and cleaner writes them to core with
+ * write-zeroes. Zero writes are detected with is_zero context data operation
+ * and not for atomic cache devices. Adds one byte per cache line to metadata
+ * and is part of metadata version.
+ */
+#ifndef OCF_CONFIG_ZERO_LINES
+#define OCF_CONFIG_ZERO_LINES 0
+#endif
+
+#if OCF_CONFIG_ZERO_LINES != 0 && OCF_CONFIG_ZERO_LINES != 1
+#error "Invalid zero lines selection"
+#endif
+
+/**
+ * Minimum number of cache lines of request mapped to consecutive cache lines
+ * for which request is locked with single range lock instead of one lock per
+ * cache line. Setting it to 0 always locks cache lines one by one.
+ */
+#ifndef OCF_CONFIG_RANGE_LOCK_MIN_LINES
+#define OCF_CONFIG_RANGE_LOCK_MIN_LINES 0
+#endif
+
+/**
+ * Number of freed requests of each size class kept by I/O queue for reuse
+ * by requests allocated on the same queue. Reused requests don't go through
+ * the environment allocator shared by all queues. Setting it to 0 frees
+ * requests immediately.
+ */
+#ifndef OCF_CONFIG_QUEUE_REQ_CACHE
+#define OCF_CONFIG_QUEUE_REQ_CACHE 0
+#endif
+
+/**
+ * Number of cache lines of request embedded in core IO. Request of IO which
+ * spans at most that many cache lines is set up in memory of the IO, so IO
+ * and its request take single allocation. Every core IO grows by size of
+ * request with its map. Setting it to 0 allocates requests separately.
+ */
+#ifndef OCF_CONFIG_CORE_IO_EMBEDDED_LINES
+#define OCF_CONFIG_CORE_IO_EMBEDDED_LINES 0
+#endif
+
+/**
+ * Use lock-free multi-producer single-consumer request queues instead of
+ * spinlock protected lists. Requests can be pushed to the queue from any
+ * context, but each queue has to be processed (ocf_queue_run() or
+ * ocf_queue_run_single()) by at most one thread at a time.
+ */
+#ifndef OCF_CONFIG_QUEUE_LOCKLESS
+#define OCF_CONFIG_QUEUE_LOCKLESS 0
+#endif
+
+/**
+ * Complete cache and core IOs of requests on I/O queue of request instead of
+ * the thread volume completes them on. Completions are queued on lock-free
+ * stack of the queue, the queue is kicked and completions are processed by
+ * the queue runner in batches, before queued requests.
+ */
+#ifndef OCF_CONFIG_QUEUE_CMPL_STEERING
+#define OCF_CONFIG_QUEUE_CMPL_STEERING 0
+#endif
+
+/**
+ * Granularity in seconds of ALRU timestamps of dirty cache lines. Write to
+ * cache line which is already dirty moves it to the ALRU head only if its
+ * timestamp would fall into another bucket, so that write-hot cache lines
+ * are not relinked on every write. Setting it to 0 relinks on every write.
+ */
+#ifndef OCF_CONFIG_ALRU_TIMESTAMP_BUCKET
+#define OCF_CONFIG_ALRU_TIMESTAMP_BUCKET 1
+#endif
+
+/**
+ * Number of 100 MiB ACP chunks tracked by single lazily allocated leaf of
+ * per core chunk table. Leaf is allocated once cache line of any of its
+ * chunks becomes dirty and is kept until core is removed, so that memory
+ * and initialization time of ACP follow dirty footprint of core rather than
+ * its size. Setting it to 0 allocates chunks of whole core upfront.
+ */
+#ifndef OCF_CONFIG_ACP_LAZY_CHUNKS
+#define OCF_CONFIG_ACP_LAZY_CHUNKS 0
+#endif
+
+/**
+ * Number of foreground requests processed by I/O queue in row while there
+ * are background requests pending, before one background request is taken.
+ * Internal requests (cleaning, metadata IO, read-ahead) and backfills are
+ * background ones, so that they can't delay user IO for longer than that.
+ * Setting it to 0 processes all requests in single FIFO.
+ */
+#ifndef OCF_CONFIG_QUEUE_BG_WEIGHT
+#define OCF_CONFIG_QUEUE_BG_WEIGHT 8
+#endif
+
+/**
+ * LRU promotion window. A cache line hit is not moved to the head of its LRU
+ * list when fewer than this number of cache lines were inserted at the head
+ * of the same LRU shard since the line was last put there, i.e. when the line
+ * is still among the most recently used ones. It saves eviction metadata
+ * updates on the read hit path at the cost of 4 bytes of metadata per cache
+ * line. Setting it to 0 promotes cache line on every hit. Metadata written
+ * with and without the window are not compatible with each other.
+ */
+#ifndef OCF_CONFIG_LRU_PROMOTION_WINDOW
+#define OCF_CONFIG_LRU_PROMOTION_WINDOW 0
+#endif
+
+/**
+ * Number of free cache lines taken at once from the cache free list to the
+ * free line cache of each I/O queue. Misses mapped without eviction take
+ * cache lines from the cache of their queue, and the shared free list lock
+ * is held only to refill it and to put mapped cache lines on the partition
+ * list. Set to 0 to take cache lines from the free list one by one.
+ */
+#ifndef OCF_CONFIG_QUEUE_FREELIST_BATCH
+#define OCF_CONFIG_QUEUE_FREELIST_BATCH 32
+#endif
+
+/**
+ * Free cache lines reserve, in per mille of cache lines. When mapping leaves
+ * fewer free cache lines than the low watermark, eviction is scheduled on
+ * the I/O queue to refill the free list up to the high watermark, so that
+ * subsequent misses find free cache lines without evicting inline. Setting
+ * the low watermark to 0 disables the reserve.
+ */
+#ifndef OCF_CONFIG_EVICTION_RESERVE_LOW
+#define OCF_CONFIG_EVICTION_RESERVE_LOW 0
+#endif
+
+#ifndef OCF_CONFIG_EVICTION_RESERVE_HIGH
+#define OCF_CONFIG_EVICTION_RESERVE_HIGH (OCF_CONFIG_EVICTION_RESERVE_LOW * 2)
+#endif
+
+#if OCF_CONFIG_EVICTION_RESERVE_HIGH < OCF_CONFIG_EVICTION_RESERVE_LOW || \
+		OCF_CONFIG_EVICTION_RESERVE_HIGH > 1000
+#error "Invalid free cache lines reserve watermarks"
+#endif
+
+/**
+ * Maximum number of cache lines in super-line of IO class, power of two up
+ * to 64. Misses of IO class with super-lines set by
+ * ocf_mngt_cache_io_class_set_super_line() are mapped to physically
+ * contiguous, aligned groups of cache lines, so that large I/O of the class
+ * goes to cache device in few requests and lookup of cache line following
+ * one in the same super-line skips hash table. Costs one bit of RAM per
+ * cache line. Setting it to 0 disables super-lines.
+ */
+#ifndef OCF_CONFIG_SUPER_LINE_MAX
+#define OCF_CONFIG_SUPER_LINE_MAX 0
+#endif
+
+#if OCF_CONFIG_SUPER_LINE_MAX > 64 || \
+		(OCF_CONFIG_SUPER_LINE_MAX & (OCF_CONFIG_SUPER_LINE_MAX - 1))
+#error "Invalid maximum super-line size"
+#endif
+
+/**
+ * Number of cache lines in log-structured allocation segment, power of two
+ * up to 4096. Each I/O queue maps misses to consecutive physical cache lines
+ * of its current segment, and starts new segment at next aligned group of
+ * free cache lines once it is used up, so that writes of new data go to cache
+ * device sequentially. When no whole segment is free, cache lines are taken
+ * from the free list as usual, and segment cleaner empties the segment with
+ * most free cache lines among the ones it checks, by dropping its clean cache
+ * lines and cleaning the dirty ones. Costs one bit of RAM per cache line.
+ * Setting it to 0 disables log-structured allocation.
+ */
+#ifndef OCF_CONFIG_LOG_SEGMENT_LINES
+#define OCF_CONFIG_LOG_SEGMENT_LINES 0
+#endif
+
+#if OCF_CONFIG_LOG_SEGMENT_LINES > 4096 || \
+		(OCF_CONFIG_LOG_SEGMENT_LINES & (OCF_CONFIG_LOG_SEGMENT_LINES - 1))
+#error "Invalid log-structured allocation segment size"
+#endif
+
+/**
+ * Minimum number of physically adjacent freed cache lines discarded on cache
+ * device at once. Cache lines put on free list by eviction, purge or discard
+ * are collected, and the cleaner discards runs of them in background, taking
+ * them off free list until discard completes, so that cache device learns
+ * about unused space. Not done for atomic cache devices. Costs two bits of
+ * RAM per cache line. Setting it to 0 disables discarding of freed cache
+ * lines.
+ */
+#ifndef OCF_CONFIG_TRIM_MIN_LINES
+#define OCF_CONFIG_TRIM_MIN_LINES 0
+#endif
+
+/* Bitmap of free physical cache lines is kept for contiguous allocation
+ * and discarding of freed cache lines, and it is the free list itself when
+ * partitions are tracked by counters
+ */
+#define OCF_CONFIG_FREE_MAP \
+	(OCF_CONFIG_SUPER_LINE_MAX > 0 || OCF_CONFIG_LOG_SEGMENT_LINES > 0 || \
+	 OCF_CONFIG_TRIM_MIN_LINES > 0 || OCF_CONFIG_PARTITION_COUNTERS)
+
+/**
+ * Park requests which need eviction while the metadata lock is contended,
+ * instead of waiting for exclusive access. Parked requests are retried once
+ * background eviction freed cache lines for them.
+ */
+#ifndef OCF_CONFIG_EVICTION_ASYNC
+#define OCF_CONFIG_EVICTION_ASYNC 0
+#endif
+
+/**
+ * Ghost history of cache lines evicted from each IO class. When enabled,
+ * misses of recently evicted core lines are counted per IO class and IO
+ * class occupancy targets may be adapted to them at runtime.
+ */
+#ifndef OCF_CONFIG_EVICTION_GHOST
+#define OCF_CONFIG_EVICTION_GHOST 0
+#endif
+
+/**
+ * Keep index of mapped core lines of each core, so that purge, flush and
+ * discard of core range visit only its mapped cache lines instead of
+ * scanning the whole collision table or looking up each core line. Costs one
+ * bit of RAM per core line of each core.
+ */
+#ifndef OCF_CONFIG_CORE_LINE_INDEX
+#define OCF_CONFIG_CORE_LINE_INDEX 0
+#endif
+
+/**
+ * Maximum number of write-invalidate requests of single queue whose clean
+ * cache lines are invalidated together in one metadata write section.
+ * Requests wait for the batch to be applied by a deferred request processed
+ * after the ones already queued. Set to 0 to purge each request separately.
+ */
+#ifndef OCF_CONFIG_WI_PURGE_BATCH
+#define OCF_CONFIG_WI_PURGE_BATCH 32
+#endif
+
+/**
+ * Serve partial hit reads from both devices: runs of hit cache lines are
+ * read from cache and runs of missed ones from core, and only the latter
+ * are backfilled. When disabled, whole partial hit is read from core.
+ */
+#ifndef OCF_CONFIG_READ_SPLIT
+#define OCF_CONFIG_READ_SPLIT 1
+#endif
+
+/**
+ * Serve read misses of cache lines with dirty sectors without cleaning them
+ * first. Missing sectors are read from core, dirty ones from cache over them,
+ * and only clean sectors are backfilled, so partial writes of write-back
+ * cache lines never make reads wait for core writes. Requires
+ * OCF_CONFIG_READ_SPLIT. When disabled, dirty cache lines of read miss are
+ * cleaned before whole request is read from core.
+ */
+#ifndef OCF_CONFIG_READ_DIRTY_MERGE
+#define OCF_CONFIG_READ_DIRTY_MERGE 1
+#endif
+
+#if OCF_CONFIG_READ_DIRTY_MERGE && !OCF_CONFIG_READ_SPLIT
+#error "Dirty read merge requires split read"
+#endif
+
+/**
+ * Split IO larger than given number of bytes into requests aligned to
+ * multiples of that size, rounded to cache lines. Requests are pushed to
+ * I/O queue together, so they lock cache lines and go to devices
+ * independently, and IO completes once all of them are done. Set to 0 to
+ * handle each IO with single request.
+ */
+#ifndef OCF_CONFIG_SPLIT_IO_BYTES
+#define OCF_CONFIG_SPLIT_IO_BYTES 0
+#endif
+
+/**
+ * Number of partition moves of hit cache lines queued per cache. Hits whose
+ * IO class differs from partition of their cache lines only record the move,
+ * and queued moves are applied together by the next metadata write section
+ * or once the queue is full. Set to 0 to move cache lines synchronously.
+ */
+#ifndef OCF_CONFIG_PART_MOVE_BATCH
+#define OCF_CONFIG_PART_MOVE_BATCH 64
+#endif
+
+/**
+ * Interleave pages of RAM metadata containers of at least 2 MiB over all
+ * NUMA nodes, so that metadata accesses from queues running on different
+ * nodes are spread evenly instead of all hitting the node of the thread
+ * which happened to touch the memory first. Containers are allocated with
+ * env_vzalloc_huge(), as pages have to be placed before first access.
+ */
+#ifndef OCF_CONFIG_METADATA_NUMA_INTERLEAVE
+#define OCF_CONFIG_METADATA_NUMA_INTERLEAVE 0
+#endif
+
+/**
+ * Number of locked data buffers of each size kept by OCF context for reuse
+ * as backfill and prefetch buffers, instead of allocating and locking new
+ * buffer through context operations for every request. 0 disables pool.
+ */
+#ifndef OCF_CONFIG_CTX_DATA_POOL
+#define OCF_CONFIG_CTX_DATA_POOL 16
+#endif
+
+/**
+ * Number of events held by trace ring buffer of each I/O queue, power of two
+ */
+#ifndef OCF_CONFIG_TRACE_RING_SIZE
+#define OCF_CONFIG_TRACE_RING_SIZE 4096
+#endif
+
+/**
+ * Number of distinct messages of I/O error paths held by log ring of each
+ * I/O queue. Repeated messages are coalesced with count, messages which
+ * don't fit are counted as dropped, and the ring is logged by cleaner runs,
+ * so that error storms don't slow down I/O with logging. Setting it to 0
+ * logs the messages right away.
+ */
+#ifndef OCF_CONFIG_LOG_RING
+#define OCF_CONFIG_LOG_RING 0
+#endif
+
+/**
+ * Log time of each step of management pipelines, from its start until
+ * pipeline is resumed, including I/O and nested pipelines of the step.
+ * Used to measure cache startup, load and shutdown.
+ */
+#ifndef OCF_CONFIG_PIPELINE_TIMING
+#define OCF_CONFIG_PIPELINE_TIMING 0
+#endif
+
+/**
+ * Enable latency histograms of requests per core, I/O class and engine path.
+ * Costs two clock reads per request and enlarges per-core statistics
+ * counters of every statistics shard.
+ */
+#ifndef OCF_CONFIG_STATS_LATENCY
+#define OCF_CONFIG_STATS_LATENCY 0
+#endif
+
+/**
+ * Enable counting of contended acquisitions and wait time of metadata global
+ * lock, status bits locks and cache line locks
+ */
+#ifndef OCF_CONFIG_STATS_LOCK
+#define OCF_CONFIG_STATS_LOCK 0
+#endif
+
+/**
+ * Number of per-interval aggregates kept for each IO class, 0 disables
+ * statistics windows. Intervals are closed by cleaner runs.
+ */
+#ifndef OCF_CONFIG_STATS_WINDOW
+#define OCF_CONFIG_STATS_WINDOW 60
+#endif
+
+/**
+ * Length of statistics window interval in milliseconds
+ */
+#ifndef OCF_CONFIG_STATS_WINDOW_INTERVAL_MS
+#define OCF_CONFIG_STATS_WINDOW_INTERVAL_MS 1000
+#endif
+
+/**
+ * Length of interval of which statistics cache mode advisor of core uses,
+ * in milliseconds. Intervals are closed by cleaner runs.
+ */
+#ifndef OCF_CONFIG_MODE_ADVISOR_INTERVAL_MS
+#define OCF_CONFIG_MODE_ADVISOR_INTERVAL_MS 10000
+#endif
+
+/**
+ * Number of sampled core lines tracked by miss ratio curve estimator of
+ * each core it is enabled for, which bounds its memory footprint
+ */
+#ifndef OCF_CONFIG_MRC_SAMPLES
+#define OCF_CONFIG_MRC_SAMPLES 4096
+#endif
+
+/**
+ * Compressibility estimator samples one cache line of every given number
+ * of writes to cache device
+ */
+#ifndef OCF_CONFIG_COMPRESS_SAMPLE_RATE
+#define OCF_CONFIG_COMPRESS_SAMPLE_RATE 64
+#endif
+
+/**
+ * Deduplication estimator fingerprints one cache line of every given number
+ * of writes to cache device
+ */
+#ifndef OCF_CONFIG_DEDUP_SAMPLE_RATE
+#define OCF_CONFIG_DEDUP_SAMPLE_RATE 16
+#endif
+
+/**
+ * Number of fingerprints tracked by deduplication estimator, which bounds
+ * its memory footprint
+ */
+#ifndef OCF_CONFIG_DEDUP_SAMPLES
+#define OCF_CONFIG_DEDUP_SAMPLES 16384
+#endif
+
+/**
+ * Collecting of debug statistics enabled by default for started caches, may
+ * be changed at runtime with ocf_mngt_cache_set_debug_stats()
+ */
 #ifndef OCF_CONFIG_DEBUG_STATS
 #define OCF_CONFIG_DEBUG_STATS 0
 #endif
@@ -73,6 +73,16 @@ uint32_t ocf_core_get_seq_cutoff_threshold(ocf_core_t core);
  */
 ocf_seq_cutoff_policy ocf_core_get_seq_cutoff_policy(ocf_core_t core);
 
+/**
+ * @brief Get cache mode advised for core
+ *
+ * @param[in] core Core object
+ *
+ * @retval Advised cache mode, ocf_cache_mode_none if advisor is off or it
+ *	has not seen enough IO yet
+ */
+ocf_cache_mode_t ocf_core_get_advised_mode(ocf_core_t core);
+
 /**
  * @brief Get ID of given core object
  *
@@ -156,6 +166,23 @@ static inline void ocf_core_submit_io(struct ocf_io *io)
 	ocf_volume_submit_io(io);
 }
 
+/**
+ * @brief Submit multiple ocf_io at once
+ *
+ * Each IO is handled as if it was submitted with ocf_core_submit_io(), but
+ * cache mode of IO class is resolved once per batch, and requests are looked
+ * up under single shared access to metadata lock. Hits are started right
+ * away, as with ocf_core_submit_io_fast(). Remaining requests of consecutive
+ * IOs assigned to the same queue are pushed to it in single critical section
+ * and the queue is kicked once. If write combining is enabled for core,
+ * contiguous writes are also combined into single request (see
+ * ocf_mngt_core_set_write_combining()).
+ *
+ * @param[in] ios Array of IOs allocated with ocf_core_new_io()
+ * @param[in] count Number of IOs in array
+ */
+void ocf_core_submit_io_batch(struct ocf_io **ios, uint32_t count);
+
 /**
  * @brief Fast path for submitting IO. If possible, request is processed
  * immediately without adding to internal request queue
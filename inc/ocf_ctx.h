@@ -126,6 +126,20 @@ struct ocf_data_ops {
 	 * @param[in] dst Contex data buffer which shall be erased
 	 */
 	void (*secure_erase)(ctx_data_t *dst);
+
+	/**
+	 * @brief Check if range of context data buffer holds only zeroes
+	 *
+	 * @param[in] src Context data buffer
+	 * @param[in] from Starting offset in buffer
+	 * @param[in] bytes Number of bytes to be checked
+	 *
+	 * @retval true Range holds only zeroes
+	 * @retval false Range holds non-zero byte
+	 *
+	 * @note Optional, zero writes are not detected when not provided
+	 */
+	bool (*is_zero)(ctx_data_t *src, uint64_t from, uint64_t bytes);
 };
 
 /**
@@ -151,6 +165,18 @@ struct ocf_cleaner_ops {
 	 * @param[in] c Descriptor of cleaner beeing stopped
 	 */
 	void (*stop)(ocf_cleaner_t c);
+
+	/**
+	 * @brief Kick cleaner
+	 *
+	 * This function should make cleaner routine run as soon as possible
+	 * even if interval requested by its previous run didn't pass yet.
+	 * It's requested when eviction has to clean lines inline. This
+	 * operation is optional.
+	 *
+	 * @param[in] c Descriptor of cleaner to be kicked
+	 */
+	void (*kick)(ocf_cleaner_t c);
 };
 
 /**
@@ -49,6 +49,34 @@
  * Maximum value of io error threshold
  */
 #define OCF_CACHE_FALLBACK_PT_MAX_ERROR_THRESHOLD	1000000
+/**
+ * Maximum user IO latency target of cleaner in microseconds
+ */
+#define OCF_CLEANER_LATENCY_TARGET_MAX_US	10000000
+/**
+ * Maximum number of cleaner instances of cache
+ */
+#define OCF_CLEANER_INSTANCES_MAX	16
+/**
+ * Minimum number of flush portions of single core in flight
+ */
+#define OCF_CACHE_FLUSH_QUEUE_DEPTH_MIN	1
+/**
+ * Maximum number of flush portions of single core in flight
+ */
+#define OCF_CACHE_FLUSH_QUEUE_DEPTH_MAX	64
+/**
+ * Default number of flush portions of single core in flight
+ */
+#define OCF_CACHE_FLUSH_QUEUE_DEPTH_DEFAULT	4
+/**
+ * Default average number of cache lines per metadata hash table entry
+ */
+#define OCF_HASH_LOAD_FACTOR_DEFAULT	4
+/**
+ * Maximum average number of cache lines per metadata hash table entry
+ */
+#define OCF_HASH_LOAD_FACTOR_MAX	64
 /**
  * @}
  */
@@ -189,6 +217,48 @@ typedef enum {
 		/*!< Default sequential cutoff policy*/
 } ocf_seq_cutoff_policy;
 
+/**
+ * Policies of core which is lower tier of another cache
+ */
+typedef enum {
+	ocf_tier_inclusive = 0,
+		/*!< Lines read by upper tier stay cached in this one */
+
+	ocf_tier_exclusive,
+		/*!< Lines read by upper tier move to it - read misses are not
+		 * inserted and clean sectors of read hits are invalidated.
+		 * Clean lines evicted from upper tier are not moved back.
+		 */
+
+	ocf_tier_max,
+		/*!< Stopper of enumerator */
+
+	ocf_tier_default = ocf_tier_inclusive,
+		/*!< Default tier policy */
+} ocf_tier_policy_t;
+
+/**
+ * Policies of cache mode advisor of core
+ */
+typedef enum {
+	ocf_mode_advisor_off = 0,
+		/*!< Cache mode is not advised */
+
+	ocf_mode_advisor_recommend,
+		/*!< Cache mode is advised, but not applied */
+
+	ocf_mode_advisor_apply,
+		/*!< Advised cache mode is applied to IO of core instead of
+		 * cache mode, IO class cache modes still take precedence
+		 */
+
+	ocf_mode_advisor_max,
+		/*!< Stopper of enumerator */
+
+	ocf_mode_advisor_default = ocf_mode_advisor_off,
+		/*!< Default mode advisor policy */
+} ocf_mode_advisor_t;
+
 /**
  * OCF supported eviction types
  */
@@ -196,6 +266,17 @@ typedef enum {
 	ocf_eviction_lru = 0,
 		/*!< Last recently used eviction policy */
 
+	ocf_eviction_clock,
+		/*!< CLOCK (second chance) eviction policy */
+
+	ocf_eviction_2q,
+		/*!< Scan resistant 2Q eviction policy */
+
+	ocf_eviction_lru_cost,
+		/*!< LRU eviction policy preferring cache lines of cores with
+		 * the lowest read latency
+		 */
+
 	ocf_eviction_max,
 		/*!< Stopper of enumerator */
 
@@ -203,6 +284,23 @@ typedef enum {
 		/*!< Default eviction policy */
 } ocf_eviction_t;
 
+/**
+ * OCF supported promotion policy types
+ */
+typedef enum {
+	ocf_promotion_always = 0,
+		/*!< Insert every missed core line into cache */
+
+	ocf_promotion_nhit,
+		/*!< Insert core line after it was missed N times */
+
+	ocf_promotion_max,
+		/*!< Stopper of enumerator */
+
+	ocf_promotion_default = ocf_promotion_always,
+		/*!< Default promotion policy */
+} ocf_promotion_t;
+
 /**
  * OCF supported Write-Back cleaning policies type
  */
@@ -298,6 +396,9 @@ typedef enum {
 /** IO class priority which indicates pinning */
 #define OCF_IO_CLASS_PRIO_PINNED -1
 
+/** Maximum number of pinned ranges of core */
+#define OCF_CORE_PINNED_RANGES_MAX 8
+
 /** The highest IO class priority  */
 #define OCF_IO_CLASS_PRIO_HIGHEST 0
 
@@ -306,6 +407,9 @@ typedef enum {
 
 /** Default IO class priority */
 #define OCF_IO_CLASS_PRIO_DEFAULT OCF_IO_CLASS_PRIO_LOWEST
+
+/** Maximum cache bandwidth limit of IO class, in bytes per second */
+#define OCF_IO_CLASS_QOS_RATE_MAX (1ULL << 40)
 /**
  * @}
  */
@@ -95,6 +95,9 @@ typedef enum {
 
 	/** Invalid cache line size */
 	OCF_ERR_INVALID_CACHE_LINE_SIZE,
+
+	/** Core size exceeds limit of metadata format */
+	OCF_ERR_CORE_SIZE_EXCEEDED,
 } ocf_error_t;
 
 #endif /* __OCF_ERR_H__ */
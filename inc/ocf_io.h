@@ -188,6 +188,19 @@ void ocf_io_get(struct ocf_io *io);
  */
 void ocf_io_put(struct ocf_io *io);
 
+/**
+ * @brief Complete array of OCF IOs
+ *
+ * Volumes reaping completions in bulk may use it instead of calling
+ * completion function of each IO. IOs of the same OCF request are then
+ * accounted to the request in one step.
+ *
+ * @param[in] ios Completed OCF IOs
+ * @param[in] errors Completion status of each IO, NULL if all succeeded
+ * @param[in] count Number of IOs
+ */
+void ocf_io_end_batch(struct ocf_io **ios, const int *errors, uint32_t count);
+
 /**
  * @brief Set OCF IO completion function
  *
@@ -44,6 +44,16 @@ struct ocf_io_class_info {
 		 * allocation for this IO class takes place
 		 */
 
+	uint32_t ghost_hits;
+		/*!< Number of misses of cache lines recently evicted from
+		 * this IO class
+		 */
+
+	uint32_t target_size;
+		/*!< Number of cache lines protected from eviction by adaptive
+		 * occupancy target of this IO class
+		 */
+
 	uint8_t eviction_policy_type;
 		/*!< The type of eviction policy for given IO class */
 
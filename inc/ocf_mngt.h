@@ -258,6 +258,11 @@ struct ocf_mngt_cache_config {
 	 */
 	ocf_eviction_t eviction_policy;
 
+	/**
+	 * @brief Promotion policy type
+	 */
+	ocf_promotion_t promotion_policy;
+
 	/**
 	 * @brief Cache line size
 	 */
@@ -276,6 +281,25 @@ struct ocf_mngt_cache_config {
 	struct {
 		 uint32_t max_queue_size;
 		 uint32_t queue_unblock_size;
+
+		/**
+		 * @brief Write data read from core on read miss directly from
+		 *	request buffer, instead of its copy
+		 *
+		 * @note Read request is then completed only after backfill
+		 *	write to cache finishes
+		 */
+		 bool zero_copy;
+
+		/**
+		 * @brief Backfill write latency target in microseconds
+		 *
+		 * @note When set, limit of pending backfills adapts between
+		 *	max_queue_size and a small minimum, so that average
+		 *	latency of backfill writes stays within target.
+		 *	0 keeps the limit fixed at max_queue_size.
+		 */
+		 uint32_t latency_target_us;
 	} backfill;
 
 	/**
@@ -295,6 +319,27 @@ struct ocf_mngt_cache_config {
 	 * @brief If set, try to submit all I/O in fast path.
 	 */
 	bool use_submit_io_fast;
+
+	/**
+	 * @brief Number of cleaner instances, 0 means single cleaner
+	 *
+	 * @note Each instance is initialized with cleaner ops of context and
+	 *	cleans dirty data of its own subset of cores, so instances can
+	 *	run concurrently on separate queues.
+	 */
+	uint32_t cleaner_instances;
+
+	/**
+	 * @brief Average number of cache lines per metadata hash table
+	 *	entry, 0 means OCF_HASH_LOAD_FACTOR_DEFAULT
+	 *
+	 * @note Number of hash table entries is rounded up to power of two,
+	 *	so actual load factor may be up to two times lower. Lower
+	 *	value shortens collision chains walked by lookup at cost of
+	 *	4 bytes of metadata per hash table entry. Value is stored in
+	 *	cache metadata and restored on cache load.
+	 */
+	uint32_t hash_load_factor;
 };
 
 /**
@@ -342,6 +387,27 @@ struct ocf_mngt_cache_device_config {
 	 */
 	bool discard_on_start;
 
+	/**
+	 * @brief If set together with discard_on_start, attach doesn't wait
+	 *		for discard of cache device. Device is discarded in
+	 *		background and cache lines become usable as their range
+	 *		gets discarded, until then misses are not inserted.
+	 *
+	 * @note Ignored for atomic volumes, which have to be zeroed before
+	 *		cache lines are used
+	 */
+	bool discard_in_background;
+
+	/**
+	 * @brief Size up to which cache device may grow while attached, in
+	 *		bytes. Metadata is sized for it, so cache capacity can
+	 *		be raised with ocf_mngt_cache_resize() once cache volume
+	 *		reports larger size. 0 means size of cache device.
+	 *
+	 * @note Ignored on load, size stored in cache metadata is used
+	 */
+	uint64_t max_size;
+
 	/**
 	 * @brief Optional opaque volume parameters, passed down to cache volume
 	 * open callback
@@ -393,6 +459,40 @@ typedef void (*ocf_mngt_cache_stop_end_t)(ocf_cache_t cache,
 void ocf_mngt_cache_stop(ocf_cache_t cache,
 		ocf_mngt_cache_stop_end_t cmpl, void *priv);
 
+/**
+ * @brief Breakdown of RAM needed to attach cache volume
+ */
+struct ocf_mngt_cache_ram_needed {
+	uint64_t cache_lines;
+		/*!< Number of cache lines which fit caching device */
+
+	uint64_t cleaning;
+		/*!< Cleaning policy metadata */
+
+	uint64_t eviction;
+		/*!< Eviction policy metadata */
+
+	uint64_t collision;
+		/*!< Collision table with cache line mapping and status */
+
+	uint64_t list_info;
+		/*!< Partition list metadata */
+
+	uint64_t hash;
+		/*!< Hash table */
+
+	uint64_t concurrency;
+		/*!< Cache line concurrency (locks and waiters lists) */
+
+	uint64_t other;
+		/*!< Volatile lookup table, eviction ghost history and promotion
+		 * policy data
+		 */
+
+	uint64_t total;
+		/*!< Sum of all above */
+};
+
 /**
  * @brief Get amount of free RAM needed to attach cache volume
  *
@@ -406,6 +506,25 @@ void ocf_mngt_cache_stop(ocf_cache_t cache,
 int ocf_mngt_get_ram_needed(ocf_cache_t cache,
 		struct ocf_mngt_cache_device_config *cfg, uint64_t *ram_needed);
 
+/**
+ * @brief Get per metadata segment breakdown of RAM needed to attach cache
+ *	volume
+ *
+ * Estimation uses the same sizing code as attach, so it follows cache line
+ * size from \a cfg (or current one if not specified) and build configuration.
+ * Only metadata which size depends on caching device is accounted.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] cfg Caching device configuration
+ * @param[out] ram_needed RAM needed per metadata segment in bytes
+ *
+ * @retval 0 Success
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_get_ram_needed_detail(ocf_cache_t cache,
+		struct ocf_mngt_cache_device_config *cfg,
+		struct ocf_mngt_cache_ram_needed *ram_needed);
+
 /**
  * @brief Completion callback of cache attach operation
  *
@@ -554,6 +673,38 @@ typedef void (*ocf_mngt_cache_flush_end_t)(ocf_cache_t cache,
 void ocf_mngt_cache_flush(ocf_cache_t cache, bool interruption,
 		ocf_mngt_cache_flush_end_t cmpl, void *priv);
 
+/**
+ * @brief Limits of partial cache flush
+ */
+struct ocf_mngt_cache_flush_limits {
+	uint64_t max_bytes;
+		/*!< Maximum amount of dirty data to be flushed in bytes,
+		 * 0 means no limit
+		 */
+
+	uint32_t dirty_ratio;
+		/*!< Flush stops once dirty cache lines take no more than given
+		 * percent of cache lines, 0 means no limit
+		 */
+};
+
+/**
+ * @brief Flush part of dirty data from given cache
+ *
+ * Flush proceeds like ocf_mngt_cache_flush(), but stops once any of given
+ * limits is met. Cache may still be dirty when flush completes successfully.
+ * Next flush continues where the partial one stopped.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] limits Flush limits
+ * @param[in] interruption Allow for interruption
+ * @param[in] cmpl Completion callback
+ * @param[in] priv Completion callback context
+ */
+void ocf_mngt_cache_flush_partial(ocf_cache_t cache,
+		const struct ocf_mngt_cache_flush_limits *limits,
+		bool interruption, ocf_mngt_cache_flush_end_t cmpl, void *priv);
+
 /**
  * @brief Completion callback of core flush operation
  *
@@ -622,6 +773,143 @@ void ocf_mngt_core_purge(ocf_core_t core,
  */
 void ocf_mngt_cache_flush_interrupt(ocf_cache_t cache);
 
+/**
+ * @brief Core range read into cache by warm-up
+ */
+struct ocf_mngt_core_warm_range {
+	uint64_t addr;
+		/*!< Byte position of range in core */
+
+	uint64_t bytes;
+		/*!< Length of range in bytes */
+
+	uint32_t io_class;
+		/*!< IO class of range, it selects partition into which range
+		 * is inserted like IO class of user IO
+		 */
+};
+
+/**
+ * @brief Core warm-up parameters
+ */
+struct ocf_mngt_core_warm_config {
+	const struct ocf_mngt_core_warm_range *ranges;
+		/*!< Ranges to be read into cache, in order of reading */
+
+	uint32_t count;
+		/*!< Number of ranges */
+
+	uint32_t io_size;
+		/*!< Size of core read in bytes, rounded down to cache line size,
+		 * 0 means default
+		 */
+
+	uint32_t queue_depth;
+		/*!< Maximum number of core reads in flight, 0 means default */
+};
+
+/**
+ * @brief Completion callback of core warm-up operation
+ *
+ * @param[in] core Core handle
+ * @param[in] priv Callback context
+ * @param[in] error Error code (zero on success)
+ */
+typedef void (*ocf_mngt_core_warm_end_t)(ocf_core_t core,
+		void *priv, int error);
+
+/**
+ * @brief Read ranges of core into cache in background
+ *
+ * Ranges are read from core sequentially in large reads, with bounded number
+ * of reads in flight, and inserted into cache like read misses. Reads are
+ * background requests of management queue, so user IO takes precedence.
+ * Ranges are inserted into partitions of their IO classes; ranges of
+ * partitions which don't insert read misses are skipped. Reads of which any
+ * cache line is already mapped are skipped, so is part of range which
+ * doesn't fit in cache. Ranges are copied, they may be freed once call
+ * returns.
+ *
+ * @note Caller must hold cache read lock until warm-up completes.
+ *
+ * @param[in] core Core handle
+ * @param[in] cfg Warm-up parameters
+ * @param[in] cmpl Completion callback
+ * @param[in] priv Completion callback context
+ */
+void ocf_mngt_core_warm(ocf_core_t core,
+		const struct ocf_mngt_core_warm_config *cfg,
+		ocf_mngt_core_warm_end_t cmpl, void *priv);
+
+/**
+ * @brief Range of core cached in hot set of cache
+ */
+struct ocf_mngt_hot_range {
+	ocf_core_id_t core_id;
+		/*!< Core of range */
+
+	uint64_t addr;
+		/*!< Byte position of range in core */
+
+	uint64_t bytes;
+		/*!< Length of range in bytes */
+
+	uint32_t io_class;
+		/*!< IO class of partition in which range is cached */
+};
+
+/**
+ * @brief Export hot set of cache
+ *
+ * Cached core ranges are exported from the hottest to the coldest one,
+ * partitions of higher priority first and cache lines of each partition in
+ * order kept by eviction policy. Consecutive core lines visited one after
+ * another are exported as single range.
+ *
+ * @note IO is blocked while cache lines are walked.
+ *
+ * @param[in] cache Cache handle
+ * @param[out] ranges Exported ranges
+ * @param[in,out] count Number of entries of ranges on input, number of
+ *		exported ranges on output. If hot set doesn't fit, the
+ *		hottest part of it is exported.
+ *
+ * @retval 0 Hot set has been exported successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_hot_set_export(ocf_cache_t cache,
+		struct ocf_mngt_hot_range *ranges, uint32_t *count);
+
+/**
+ * @brief Completion callback of hot set import operation
+ *
+ * @param[in] cache Cache handle
+ * @param[in] priv Callback context
+ * @param[in] error Error code (zero on success)
+ */
+typedef void (*ocf_mngt_cache_hot_set_import_end_t)(ocf_cache_t cache,
+		void *priv, int error);
+
+/**
+ * @brief Read exported hot set into cache in background
+ *
+ * Ranges of each core are read by core warm-up (ocf_mngt_core_warm()) in
+ * order of export, warm-ups of all cores run concurrently. Ranges of cores
+ * not added to cache are skipped. Ranges are copied, they may be freed once
+ * call returns.
+ *
+ * @note Caller must hold cache read lock until import completes.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] ranges Ranges exported by ocf_mngt_cache_hot_set_export()
+ * @param[in] count Number of ranges
+ * @param[in] cmpl Completion callback
+ * @param[in] priv Completion callback context
+ */
+void ocf_mngt_cache_hot_set_import(ocf_cache_t cache,
+		const struct ocf_mngt_hot_range *ranges, uint32_t count,
+		ocf_mngt_cache_hot_set_import_end_t cmpl, void *priv);
+
 /**
  * @brief Completion callback of save operation
  *
@@ -659,6 +947,77 @@ void ocf_mngt_cache_save(ocf_cache_t cache,
  */
 int ocf_mngt_cache_set_mode(ocf_cache_t cache, ocf_cache_mode_t mode);
 
+/**
+ * @brief Set cache mode and drain dirty data in background
+ *
+ * New requests follow \a mode immediately. Dirty data left in partitions
+ * which are no longer in write-back mode is cleaned by cleaner as fast as
+ * cleaning policy batch allows, regardless of its staleness and user IO
+ * activity. Drain ends once there is no such dirty data left, or when
+ * write-back mode is set again.
+ *
+ * @attention This changes only runtime state. To make changes persistent
+ *            use function ocf_mngt_cache_save().
+ *
+ * @param[in] cache Cache handle
+ * @param[in] mode Cache mode to set
+ * @param[in] rate Cache lines cleaned per second, 0 if not limited
+ *
+ * @retval 0 Cache mode have been set successfully
+ * @retval -OCF_ERR_INVAL Cache mode is invalid or cleaning policy is nop
+ *		while cache is dirty
+ */
+int ocf_mngt_cache_set_mode_drain(ocf_cache_t cache, ocf_cache_mode_t mode,
+		uint32_t rate);
+
+/**
+ * @brief Progress of dirty data drain after cache mode change
+ */
+struct ocf_mngt_cache_drain_status {
+	bool active;
+		/*!< Drain is in progress */
+
+	uint32_t rate;
+		/*!< Cache lines cleaned per second, 0 if not limited */
+
+	uint64_t dirty_initial;
+		/*!< Dirty cache lines to be drained when drain started */
+
+	uint64_t dirty;
+		/*!< Dirty cache lines left to be drained */
+};
+
+/**
+ * @brief Get progress of dirty data drain after cache mode change
+ *
+ * @param[in] cache Cache handle
+ * @param[out] status Drain progress
+ *
+ * @retval 0 Success
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_get_drain_status(ocf_cache_t cache,
+		struct ocf_mngt_cache_drain_status *status);
+
+/**
+ * @brief Set capacity of cache device used by cache
+ *
+ * Capacity can be changed with I/O running, between minimal cache size and
+ * current size of cache device, up to max_size set on attach. When shrinking,
+ * clean cache lines above the new capacity are evicted, the rest stays in
+ * cache until it's evicted regularly.
+ *
+ * @attention Capacity is stored in cache metadata with the rest of cache
+ *            configuration, and restored on cache load.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] size Capacity to set in bytes, rounded down to cache lines
+ *
+ * @retval 0 Capacity has been set successfully
+ * @retval Non-zero Error occurred and capacity has not been changed
+ */
+int ocf_mngt_cache_resize(ocf_cache_t cache, uint64_t size);
+
 /**
  * @brief Set cleaning policy in given cache
  *
@@ -713,6 +1072,74 @@ int ocf_mngt_cache_cleaning_set_param(ocf_cache_t cache, ocf_cleaning_t type,
 int ocf_mngt_cache_cleaning_get_param(ocf_cache_t cache,ocf_cleaning_t type,
 		uint32_t param_id, uint32_t *param_value);
 
+/**
+ * @brief Set user IO latency target of cleaner
+ *
+ * While average latency of user IO is above target, cleaner cleans smaller
+ * batches and wakes up less often. Below target it gradually returns to
+ * rate configured for cleaning policy, and runs at full rate when there is
+ * no user IO. This replaces IO activity threshold of ALRU policy.
+ *
+ * @attention This changes only runtime state.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] target_us Latency target in microseconds, 0 to disable
+ *
+ * @retval 0 Latency target has been set successfully
+ * @retval Non-zero Error occurred and latency target has not been set
+ */
+int ocf_mngt_cache_cleaning_set_latency_target(ocf_cache_t cache,
+		uint32_t target_us);
+
+/**
+ * @brief Get user IO latency target of cleaner
+ *
+ * @param[in] cache Cache handle
+ * @param[out] target_us Latency target in microseconds, 0 if disabled
+ *
+ * @retval 0 Latency target has been get successfully
+ * @retval Non-zero Error occurred and latency target has not been get
+ */
+int ocf_mngt_cache_cleaning_get_latency_target(ocf_cache_t cache,
+		uint32_t *target_us);
+
+/**
+ * @brief Get current promotion policy of given cache
+ *
+ * @param[in] cache Cache handle
+ *
+ * @retval Promotion policy type
+ */
+ocf_promotion_t ocf_mngt_cache_promotion_get_policy(ocf_cache_t cache);
+
+/**
+ * @brief Set promotion policy parameter in given cache
+ *
+ * @attention This changes only runtime state.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] param_id Promotion policy parameter id
+ * @param[in] param_value Promotion policy parameter value
+ *
+ * @retval 0 Parameter has been set successfully
+ * @retval Non-zero Error occurred and parameter has not been set
+ */
+int ocf_mngt_cache_promotion_set_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t param_value);
+
+/**
+ * @brief Get promotion policy parameter from given cache
+ *
+ * @param[in] cache Cache handle
+ * @param[in] param_id Promotion policy parameter id
+ * @param[out] param_value Variable to store parameter value
+ *
+ * @retval 0 Parameter has been get successfully
+ * @retval Non-zero Error occurred and parameter has not been get
+ */
+int ocf_mngt_cache_promotion_get_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t *param_value);
+
 /**
  * @brief IO class configuration
  */
@@ -767,6 +1194,174 @@ struct ocf_mngt_io_classes_config {
 int ocf_mngt_cache_io_classes_configure(ocf_cache_t cache,
 		const struct ocf_mngt_io_classes_config *cfg);
 
+/**
+ * @brief Enable or disable adaptive IO class occupancy targets
+ *
+ * In adaptive mode misses of cache lines recently evicted from IO class
+ * raise its occupancy target, protecting that many of its cache lines from
+ * eviction on top of IO class minimum size. Requires cache built with
+ * OCF_CONFIG_EVICTION_GHOST.
+ *
+ * @attention This changes only runtime state.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] enable Adaptive mode state
+ *
+ * @retval 0 Adaptive mode has been set successfully
+ * @retval Non-zero Error occurred and adaptive mode has not been set
+ */
+int ocf_mngt_cache_io_classes_set_adaptive(ocf_cache_t cache, bool enable);
+
+/**
+ * @brief Check whether adaptive IO class occupancy targets are enabled
+ *
+ * @param[in] cache Cache handle
+ *
+ * @retval Adaptive mode state
+ */
+bool ocf_mngt_cache_io_classes_get_adaptive(ocf_cache_t cache);
+
+/**
+ * @brief Set dirty watermarks of IO class
+ *
+ * Once dirty data of IO class exceeds low watermark cleaning policy stops
+ * waiting for idle time and stale data and its cleaning rate ramps up,
+ * reaching its highest value at high watermark. This keeps eviction from
+ * cleaning dirty cache lines inline with user IO.
+ *
+ * @attention This changes only runtime state.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] io_class IO class id
+ * @param[in] high High watermark in percent of IO class size,
+ *		0 disables watermarks
+ * @param[in] low Low watermark in percent of IO class size,
+ *		must be lower than high watermark
+ *
+ * @retval 0 Watermarks have been set successfully
+ * @retval Non-zero Error occurred and watermarks have not been set
+ */
+int ocf_mngt_cache_io_class_set_dirty_watermarks(ocf_cache_t cache,
+		uint32_t io_class, uint8_t high, uint8_t low);
+
+/**
+ * @brief Get dirty watermarks of IO class
+ *
+ * @param[in] cache Cache handle
+ * @param[in] io_class IO class id
+ * @param[out] high High watermark in percent, 0 if watermarks are disabled
+ * @param[out] low Low watermark in percent
+ *
+ * @retval 0 Watermarks have been read successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_io_class_get_dirty_watermarks(ocf_cache_t cache,
+		uint32_t io_class, uint8_t *high, uint8_t *low);
+
+/**
+ * @brief Limit cache device bandwidth used by IO class
+ *
+ * Bytes written to cache device by backfill of read misses of IO class and
+ * read from it by cleaning of its dirty data are accounted in token bucket
+ * refilled at given rate. Once bucket is empty, reads of IO class are
+ * serviced in pass-through mode until it refills, so that they don't
+ * compete with other IO classes for cache device. Cleaning is never
+ * held back by the limit.
+ *
+ * @attention This changes only runtime state.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] io_class IO class id
+ * @param[in] rate Bandwidth in bytes per second, up to
+ *		OCF_IO_CLASS_QOS_RATE_MAX, 0 disables the limit
+ * @param[in] burst Bytes that can be used at once after idle period,
+ *		0 sets it to one second worth of rate
+ *
+ * @retval 0 Limit has been set successfully
+ * @retval Non-zero Error occurred and limit has not been set
+ */
+int ocf_mngt_cache_io_class_set_qos(ocf_cache_t cache,
+		uint32_t io_class, uint64_t rate, uint64_t burst);
+
+/**
+ * @brief Get cache device bandwidth limit of IO class
+ *
+ * @param[in] cache Cache handle
+ * @param[in] io_class IO class id
+ * @param[out] rate Bandwidth in bytes per second, 0 if IO class is not
+ *		limited
+ * @param[out] burst Burst size in bytes
+ *
+ * @retval 0 Limit has been read successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_io_class_get_qos(ocf_cache_t cache,
+		uint32_t io_class, uint64_t *rate, uint64_t *burst);
+
+/**
+ * @brief Set super-line size of IO class
+ *
+ * Cache misses of IO class are mapped to physically contiguous, aligned
+ * groups of cache lines covering aligned ranges of core of super-line size,
+ * as long as such groups can be found free. Each cache line is still cached,
+ * locked and evicted on its own. Available only if OCF is built with
+ * OCF_CONFIG_SUPER_LINE_MAX.
+ *
+ * @attention This changes only runtime state.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] io_class IO class id
+ * @param[in] size Super-line size in bytes, power of two multiple of cache
+ *		line size up to OCF_CONFIG_SUPER_LINE_MAX cache lines,
+ *		0 disables super-lines
+ *
+ * @retval 0 Super-line size has been set successfully
+ * @retval Non-zero Error occurred and super-line size has not been set
+ */
+int ocf_mngt_cache_io_class_set_super_line(ocf_cache_t cache,
+		uint32_t io_class, uint32_t size);
+
+/**
+ * @brief Get super-line size of IO class
+ *
+ * @param[in] cache Cache handle
+ * @param[in] io_class IO class id
+ * @param[out] size Super-line size in bytes, 0 if super-lines are disabled
+ *
+ * @retval 0 Super-line size has been read successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_io_class_get_super_line(ocf_cache_t cache,
+		uint32_t io_class, uint32_t *size);
+
+/**
+ * @brief Set pinned capacity of cache
+ *
+ * Cache lines of IO classes with OCF_IO_CLASS_PRIO_PINNED priority are never
+ * evicted. Misses of pinned IO classes, which would take their total
+ * occupancy beyond pinned capacity, are not inserted into cache.
+ *
+ * @attention This changes only runtime state.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] lines Pinned capacity in cache lines, 0 means no limit
+ *
+ * @retval 0 Pinned capacity has been set successfully
+ * @retval Non-zero Error occurred and pinned capacity has not been set
+ */
+int ocf_mngt_cache_set_pinned_max(ocf_cache_t cache, uint32_t lines);
+
+/**
+ * @brief Get pinned capacity of cache
+ *
+ * @param[in] cache Cache handle
+ * @param[out] lines Pinned capacity in cache lines, 0 means no limit
+ *
+ * @retval 0 Pinned capacity has been read successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_get_pinned_max(ocf_cache_t cache, uint32_t *lines);
+
 /**
  * @brief Asociate new UUID value with given core
  *
@@ -890,6 +1485,262 @@ int ocf_mngt_core_set_seq_cutoff_policy_all(ocf_cache_t cache,
 int ocf_mngt_core_get_seq_cutoff_policy(ocf_core_t core,
 		ocf_seq_cutoff_policy *policy);
 
+/**
+ * @brief Maximum number of cache lines read ahead of sequential stream
+ */
+#define OCF_CORE_PREFETCH_LINES_MAX 256
+
+/**
+ * @brief Set number of cache lines read ahead of sequential read stream
+ *
+ * Once read stream is detected, next cache lines following it are read
+ * from core into cache in background, so that stream is served from cache.
+ * Streams which are cut off by sequential cutoff are not read ahead.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] core Core handle
+ * @param[in] lines Number of cache lines, 0 disables read-ahead
+ *
+ * @retval 0 Read-ahead has been set successfully
+ * @retval Non-zero Error occured and read-ahead hasn't been updated
+ */
+int ocf_mngt_core_set_prefetch_lines(ocf_core_t core, uint32_t lines);
+
+/**
+ * @brief Get number of cache lines read ahead of sequential read stream
+ *
+ * @param[in] core Core handle
+ * @param[out] lines Number of cache lines, 0 if read-ahead is disabled
+ *
+ * @retval 0 Read-ahead has been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_core_get_prefetch_lines(ocf_core_t core, uint32_t *lines);
+
+/**
+ * @brief Enable or disable combining of writes to core
+ *
+ * When enabled, contiguous write-back writes submitted together with
+ * ocf_core_submit_io_batch() to the same queue, with the same IO class and
+ * flags, are served as single request. Their data is copied to common
+ * buffer and each IO is completed with the result of the request.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] core Core handle
+ * @param[in] enable Combine writes if true
+ *
+ * @retval 0 Write combining has been set successfully
+ * @retval Non-zero Error occured and write combining hasn't been updated
+ */
+int ocf_mngt_core_set_write_combining(ocf_core_t core, bool enable);
+
+/**
+ * @brief Check if combining of writes to core is enabled
+ *
+ * @param[in] core Core handle
+ * @param[out] enabled Write combining state
+ *
+ * @retval 0 Write combining state has been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_core_get_write_combining(ocf_core_t core, bool *enabled);
+
+/**
+ * @brief Write-back limits of core volume
+ */
+struct ocf_mngt_core_writeback_limits {
+	uint32_t max_inflight;
+		/*!< Maximum number of writes to core submitted by cleaner and
+		 * flush at once, 0 means no limit
+		 */
+
+	uint32_t max_io_size;
+		/*!< Maximum size of single write to core in bytes, 0 means
+		 * maximum IO size of core volume
+		 */
+};
+
+/**
+ * @brief Set limits of writes to core submitted by cleaner and flush
+ *
+ * Writes over in-flight limit are deferred until earlier writes to core
+ * complete, so that cleaning doesn't overwhelm slow core devices. Size limit
+ * never splits single cache line and doesn't exceed maximum IO size of core.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] core Core handle
+ * @param[in] limits Write-back limits
+ *
+ * @retval 0 Limits have been set successfully
+ * @retval Non-zero Error occured and limits haven't been updated
+ */
+int ocf_mngt_core_set_writeback_limits(ocf_core_t core,
+		const struct ocf_mngt_core_writeback_limits *limits);
+
+/**
+ * @brief Get limits of writes to core submitted by cleaner and flush
+ *
+ * @param[in] core Core handle
+ * @param[out] limits Write-back limits
+ *
+ * @retval 0 Limits have been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_core_get_writeback_limits(ocf_core_t core,
+		struct ocf_mngt_core_writeback_limits *limits);
+
+/**
+ * @brief Set policy of core used as lower tier of another cache
+ *
+ * Another cache may use front volume of core (ocf_core_get_front_volume())
+ * as its core volume. With exclusive policy, core lines read by upper tier
+ * move to it instead of being cached twice - read misses go to core volume
+ * without insert and clean sectors of read hits are invalidated once read.
+ * Writes, which include data written back by upper tier, are cached as
+ * usual, so dirty lines cleaned by upper tier land in this one. This is
+ * the only demotion - clean lines evicted from upper tier are dropped and
+ * are read from core volume on next access.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] core Core handle
+ * @param[in] policy Tier policy
+ *
+ * @retval 0 Tier policy has been set successfully
+ * @retval Non-zero Error occured and tier policy hasn't been updated
+ */
+int ocf_mngt_core_set_tier_policy(ocf_core_t core, ocf_tier_policy_t policy);
+
+/**
+ * @brief Get policy of core used as lower tier of another cache
+ *
+ * @param[in] core Core handle
+ * @param[out] policy Tier policy
+ *
+ * @retval 0 Tier policy has been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_core_get_tier_policy(ocf_core_t core,
+		ocf_tier_policy_t *policy);
+
+/**
+ * @brief Cache mode advisor parameters of core
+ */
+struct ocf_mngt_core_mode_advisor {
+	ocf_mode_advisor_t policy;
+		/*!< Advisor policy */
+
+	uint32_t allowed_modes;
+		/*!< Bit mask of cache modes (1 << mode) which may be advised,
+		 * out of WT, WB, WA and WI, 0 means WT, WB and WA
+		 */
+};
+
+/**
+ * @brief Set cache mode advisor of core
+ *
+ * Advisor picks cache mode from read/write ratio and write hit (rewrite)
+ * ratio of IO of core in intervals of OCF_CONFIG_MODE_ADVISOR_INTERVAL_MS:
+ * read-mostly core gets WT, write-heavy or rewriting one WB and one which
+ * writes data it doesn't cache WA. Advised mode changes once the same mode
+ * was picked for two intervals in a row. If picked mode is not allowed, the
+ * closest allowed one is advised. Setting advisor restarts it.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] core Core handle
+ * @param[in] cfg Advisor parameters
+ *
+ * @retval 0 Advisor has been set successfully
+ * @retval Non-zero Error occured and advisor hasn't been updated
+ */
+int ocf_mngt_core_set_mode_advisor(ocf_core_t core,
+		const struct ocf_mngt_core_mode_advisor *cfg);
+
+/**
+ * @brief Get cache mode advisor parameters of core
+ *
+ * @param[in] core Core handle
+ * @param[out] cfg Advisor parameters
+ *
+ * @retval 0 Advisor parameters have been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_core_get_mode_advisor(ocf_core_t core,
+		struct ocf_mngt_core_mode_advisor *cfg);
+
+/**
+ * @brief Enable or disable miss ratio curve estimation of core
+ *
+ * Core lines referenced by IO submitted to core are sampled and hit ratio
+ * of cache of different sizes is estimated from their reuse distances.
+ * Estimator uses constant memory, bounded by OCF_CONFIG_MRC_SAMPLES, which
+ * is allocated when estimation is enabled for the first time and is kept
+ * until core is removed. Enabling estimation resets it.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] core Core handle
+ * @param[in] enable Estimate miss ratio curve if true
+ *
+ * @retval 0 Estimation has been set successfully
+ * @retval Non-zero Error occured and estimation hasn't been updated
+ */
+int ocf_mngt_core_set_mrc(ocf_core_t core, bool enable);
+
+/**
+ * @brief Core range pinned in cache
+ */
+struct ocf_mngt_core_pinned_range {
+	uint64_t addr;
+		/*!< Byte position of range in core */
+
+	uint64_t bytes;
+		/*!< Length of range in bytes */
+
+	uint32_t io_class;
+		/*!< Pinned IO class, IO overlapping range is assigned to it
+		 * instead of IO class it was submitted with
+		 */
+};
+
+/**
+ * @brief Set pinned ranges of core
+ *
+ * Cache lines of pinned ranges are mapped to pinned IO classes, so they are
+ * never evicted, within pinned capacity of cache. Setting ranges replaces
+ * previously set ones, IO already submitted keeps its IO class.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] core Core handle
+ * @param[in] ranges Pinned ranges, IO classes of which have to be pinned
+ * @param[in] count Number of ranges, up to OCF_CORE_PINNED_RANGES_MAX,
+ *		0 unpins all ranges
+ *
+ * @retval 0 Pinned ranges have been set successfully
+ * @retval Non-zero Error occured and pinned ranges haven't been updated
+ */
+int ocf_mngt_core_set_pinned_ranges(ocf_core_t core,
+		const struct ocf_mngt_core_pinned_range *ranges,
+		uint32_t count);
+
+/**
+ * @brief Get pinned ranges of core
+ *
+ * @param[in] core Core handle
+ * @param[out] ranges Pinned ranges, OCF_CORE_PINNED_RANGES_MAX entries
+ * @param[out] count Number of pinned ranges
+ *
+ * @retval 0 Pinned ranges have been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_core_get_pinned_ranges(ocf_core_t core,
+		struct ocf_mngt_core_pinned_range *ranges, uint32_t *count);
+
 /**
  * @brief Set cache fallback Pass Through error threshold
  *
@@ -914,6 +1765,125 @@ int ocf_mngt_cache_set_fallback_pt_error_threshold(ocf_cache_t cache,
 int ocf_mngt_cache_get_fallback_pt_error_threshold(ocf_cache_t cache,
 		uint32_t *threshold);
 
+/**
+ * @brief Set number of flush portions of each core flushed concurrently
+ *
+ * All cores are flushed in parallel, each of them with up to given number
+ * of portions in flight.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] queue_depth Per core flush queue depth
+ *
+ * @retval 0 Flush queue depth have been set successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_set_flush_queue_depth(ocf_cache_t cache,
+		uint32_t queue_depth);
+
+/**
+ * @brief Get number of flush portions of each core flushed concurrently
+ *
+ * @param[in] cache Cache handle
+ * @param[out] queue_depth Per core flush queue depth
+ *
+ * @retval 0 Flush queue depth have been get successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_get_flush_queue_depth(ocf_cache_t cache,
+		uint32_t *queue_depth);
+
+/**
+ * @brief Enable or disable collecting of core debug statistics
+ *
+ * Debug statistics are histograms of sizes and alignments of I/Os
+ * submitted to cores, reported in debug_stat of ocf_stats_core. Initial
+ * state is set by OCF_CONFIG_DEBUG_STATS.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] enable Collect debug statistics
+ *
+ * @retval 0 Debug statistics have been enabled or disabled successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_set_debug_stats(ocf_cache_t cache, bool enable);
+
+/**
+ * @brief Check if core debug statistics are collected
+ *
+ * @param[in] cache Cache handle
+ * @param[out] enabled Debug statistics collecting state
+ *
+ * @retval 0 State has been get successfully
+ * @retval Non-zero Error occurred
+ */
+int ocf_mngt_cache_get_debug_stats(ocf_cache_t cache, bool *enabled);
+
+/**
+ * @brief Enable or disable estimation of cached data compressibility
+ *
+ * Cache lines written to cache device are sampled and compressed with LZ4
+ * class compressor to estimate how much more data cache would hold if
+ * cache lines were stored compressed, see ocf_cache_get_compress_stats().
+ * Only estimation is done - OCF has no compressed cache line mode and
+ * cache lines are always stored uncompressed, one per cache device line.
+ * Estimator uses constant memory, which is allocated when estimation is
+ * enabled for the first time and is kept until cache is stopped. Enabling
+ * estimation resets it.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] enable Estimate compressibility if true
+ *
+ * @retval 0 Estimation has been set successfully
+ * @retval Non-zero Error occured and estimation hasn't been updated
+ */
+int ocf_mngt_cache_set_compress_estimate(ocf_cache_t cache, bool enable);
+
+/**
+ * @brief Check if estimation of cached data compressibility is enabled
+ *
+ * @param[in] cache Cache handle
+ * @param[out] enabled Estimation state
+ *
+ * @retval 0 Estimation state has been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_cache_get_compress_estimate(ocf_cache_t cache, bool *enabled);
+
+/**
+ * @brief Enable or disable estimation of duplicate data in cache
+ *
+ * Cache lines written to cache device are sampled and fingerprinted to
+ * estimate how much more data cache would hold if cache lines of the same
+ * content were stored once, see ocf_cache_get_dedup_stats(). Only
+ * estimation is done - OCF has no deduplication and every cache line keeps
+ * its own cache device line, even if its content is duplicated. Estimator
+ * uses constant memory, bounded by OCF_CONFIG_DEDUP_SAMPLES, which is
+ * allocated when estimation is enabled for the first time and is kept
+ * until cache is stopped. Enabling estimation resets it.
+ *
+ * @attention This changes only runtime state and is not saved in metadata.
+ *
+ * @param[in] cache Cache handle
+ * @param[in] enable Estimate duplication if true
+ *
+ * @retval 0 Estimation has been set successfully
+ * @retval Non-zero Error occured and estimation hasn't been updated
+ */
+int ocf_mngt_cache_set_dedup_estimate(ocf_cache_t cache, bool enable);
+
+/**
+ * @brief Check if estimation of duplicate data in cache is enabled
+ *
+ * @param[in] cache Cache handle
+ * @param[out] enabled Estimation state
+ *
+ * @retval 0 Estimation state has been get successfully
+ * @retval Non-zero Error occured
+ */
+int ocf_mngt_cache_get_dedup_estimate(ocf_cache_t cache, bool *enabled);
+
 /**
  * @brief Reset cache fallback Pass Through error counter
  *
@@ -59,6 +59,56 @@ struct ocf_queue_ops {
 int ocf_queue_create(ocf_cache_t cache, ocf_queue_t *queue,
 		const struct ocf_queue_ops *ops);
 
+/**
+ * @brief Allocate IO queue on given NUMA node and add it to list in cache
+ *
+ * Queue should be placed on node of CPUs running it, so that its state
+ * touched by every request doesn't live in remote memory.
+ *
+ * @param[in] cache Handle to cache instance
+ * @param[out] queue Handle to created queue
+ * @param[in] ops Queue operations
+ * @param[in] node NUMA node to allocate queue on, negative for no preference
+ *
+ * @return Zero on success, otherwise error code
+ */
+int ocf_queue_create_node(ocf_cache_t cache, ocf_queue_t *queue,
+		const struct ocf_queue_ops *ops, int node);
+
+/**
+ * @brief Allocate context-level queue shared by I/O queues of several caches
+ *
+ * Shared queue has no requests of its own. It is kicked whenever any of its
+ * member queues is, and running it with ocf_queue_run() or
+ * ocf_queue_run_polled() processes requests of members in round robin,
+ * so that single thread or poller may serve many caches.
+ *
+ * @param[in] ctx OCF context
+ * @param[out] queue Handle to created queue
+ * @param[in] ops Queue operations
+ * @param[in] node NUMA node to allocate queue on, negative for no preference
+ *
+ * @return Zero on success, otherwise error code
+ */
+int ocf_queue_create_shared(ocf_ctx_t ctx, ocf_queue_t *queue,
+		const struct ocf_queue_ops *ops, int node);
+
+/**
+ * @brief Allocate IO queue of cache served by shared queue
+ *
+ * Queue is used by cache as any other I/O queue, but it's kicked and run
+ * through the shared queue. Queue keeps reference of the shared queue
+ * until it's freed.
+ *
+ * @param[in] cache Handle to cache instance
+ * @param[out] queue Handle to created queue
+ * @param[in] shared Shared queue created with ocf_queue_create_shared()
+ *
+ * @return Zero on success, otherwise error code
+ */
+int ocf_queue_create_on_shared(ocf_cache_t cache, ocf_queue_t *queue,
+		ocf_queue_t shared);
+
 /**
  * @brief Increase reference counter in queue
  *
@@ -91,6 +141,51 @@ void ocf_queue_run_single(ocf_queue_t q);
  */
 void ocf_queue_run(ocf_queue_t q);
 
+/**
+ * @brief Run queue processing in polled mode
+ *
+ * Processes requests like ocf_queue_run(), then keeps busy-polling queue
+ * for new requests for up to poll time set with ocf_queue_set_poll().
+ * Queue kick callbacks are not called while queue is being polled. Poll
+ * time adapts to load: it grows when requests keep arriving and shrinks
+ * when polling finds queue empty. Function returns once queue stays empty
+ * for the whole poll time, with kicks delivered again, so that caller can
+ * sleep until the next kick.
+ *
+ * @note Only one thread may run queue in polled mode at a time
+ *
+ * @param[in] q Queue to run
+ */
+void ocf_queue_run_polled(ocf_queue_t q);
+
+/**
+ * @brief Set busy-poll time of queue run in polled mode
+ *
+ * @param[in] q Queue
+ * @param[in] max_poll_us Maximal busy-poll time in microseconds,
+ *		zero disables polling
+ */
+void ocf_queue_set_poll(ocf_queue_t q, uint32_t max_poll_us);
+
+/**
+ * @brief Enable or disable work stealing for queue
+ *
+ * With work stealing enabled ocf_queue_run() processes requests pending on
+ * sibling I/O queues of the same cache once its own queue is empty. Stolen
+ * requests are still resumed and completed on the queue they were
+ * submitted to.
+ *
+ * @note Work stealing is not supported with lock-free queues and for
+ *	shared queues
+ *
+ * @param[in] q Queue
+ * @param[in] enable Work stealing enable flag
+ *
+ * @retval 0 Success
+ * @retval -ENOTSUP Work stealing is not supported
+ */
+int ocf_queue_set_work_stealing(ocf_queue_t q, bool enable);
+
 /**
  * @brief Set queue private data
  *
@@ -122,7 +217,7 @@ uint32_t ocf_queue_pending_io(ocf_queue_t q);
  *
  * @param[in] q I/O queue
  *
- * @retval Cache instance
+ * @retval Cache instance, NULL for shared queue
  */
 ocf_cache_t ocf_queue_get_cache(ocf_queue_t q);
 
@@ -81,6 +81,73 @@ struct ocf_stats_io_class {
 	uint64_t dirty_clines;
 };
 
+/**
+ * Eviction statistics of given IO class
+ */
+struct ocf_stats_eviction {
+	/** Number of cache lines evicted from IO class */
+	uint64_t evicted_clines;
+
+	/** Number of eviction candidates skipped as being locked */
+	uint64_t locked_clines;
+
+	/** Number of times dirty lines were cleaned for lack of clean ones */
+	uint64_t dirty_fallbacks;
+
+	/** Number of requests which evicted from IO class */
+	uint64_t requests;
+
+	/** Total time spent on eviction (in nanoseconds) */
+	uint64_t time_ns;
+
+	/** The longest eviction of single request (in nanoseconds) */
+	uint64_t max_time_ns;
+};
+
+/** Number of buckets of cleaning I/O size distribution */
+#define OCF_STATS_CLEANING_IO_SIZES 10
+
+/**
+ * Cleaning statistics of given IO class
+ */
+struct ocf_stats_cleaning {
+	/** Number of dirty cache lines cleaned, by cleaner or flush */
+	uint64_t cleaned_clines;
+
+	/** Number of bytes written to core when cleaning */
+	uint64_t write_bytes;
+
+	/**
+	 * Number of writes to core, bucket 0 counts ones up to 4 KiB and
+	 * bucket i ones larger than 2^(i + 11) bytes and up to 2^(i + 12)
+	 * bytes. The last bucket counts all larger writes.
+	 */
+	uint64_t io_size[OCF_STATS_CLEANING_IO_SIZES];
+
+	/** Number of dirty cache lines skipped by cleaner as being in use */
+	uint64_t busy_clines;
+};
+
+/**
+ * Statistics of cleaner runs, summed over all cleaner instances
+ */
+struct ocf_stats_cleaner {
+	/** Number of runs in which cleaning policy was invoked */
+	uint64_t runs;
+
+	/**
+	 * Number of runs which cleaned nothing because policy decided to
+	 * clean later, e.g. for user IO activity
+	 */
+	uint64_t postponed_runs;
+
+	/** Total time from cleaner wake up to end of run (in nanoseconds) */
+	uint64_t time_ns;
+
+	/** The longest single run (in nanoseconds) */
+	uint64_t max_time_ns;
+};
+
 #define IO_PACKET_NO 12
 #define IO_ALIGN_NO 4
 
@@ -188,6 +255,112 @@ void ocf_core_stats_initialize_all(ocf_cache_t cache);
 int ocf_core_io_class_get_stats(ocf_core_t core, ocf_part_id_t part_id,
 		struct ocf_stats_io_class *stats);
 
+/**
+ * @brief Retrieve eviction statistics of IO class
+ *
+ * @param[in] cache cache handle
+ * @param[in] part_id IO class, stats of which are requested
+ * @param[out] stats statistic structure that shall be filled as
+ *             a result of this function invocation.
+ *
+ * @result zero upon successful completion; error code otherwise
+ */
+int ocf_cache_io_class_get_eviction_stats(ocf_cache_t cache,
+		ocf_part_id_t part_id, struct ocf_stats_eviction *stats);
+
+/**
+ * @brief Retrieve cleaning statistics of IO class for given core
+ *
+ * @param[in] core core handle
+ * @param[in] part_id IO class, stats of which are requested
+ * @param[out] stats statistic structure that shall be filled as
+ *             a result of this function invocation.
+ *
+ * @result zero upon successful completion; error code otherwise
+ */
+int ocf_core_io_class_get_cleaning_stats(ocf_core_t core,
+		ocf_part_id_t part_id, struct ocf_stats_cleaning *stats);
+
+/**
+ * @brief Retrieve cleaning statistics of core, for all IO classes together
+ *
+ * @param[in] core core handle
+ * @param[out] stats statistic structure that shall be filled as
+ *             a result of this function invocation.
+ *
+ * @result zero upon successful completion; error code otherwise
+ */
+int ocf_core_get_cleaning_stats(ocf_core_t core,
+		struct ocf_stats_cleaning *stats);
+
+/**
+ * @brief Retrieve cleaning statistics of IO class, for all cores together
+ *
+ * @param[in] cache cache handle
+ * @param[in] part_id IO class, stats of which are requested
+ * @param[out] stats statistic structure that shall be filled as
+ *             a result of this function invocation.
+ *
+ * @result zero upon successful completion; error code otherwise
+ */
+int ocf_cache_io_class_get_cleaning_stats(ocf_cache_t cache,
+		ocf_part_id_t part_id, struct ocf_stats_cleaning *stats);
+
+/**
+ * @brief Retrieve statistics of cleaner runs
+ *
+ * Average time from cleaner wake up to end of run is time_ns / runs.
+ *
+ * @param[in] cache cache handle
+ * @param[out] stats statistic structure that shall be filled as
+ *             a result of this function invocation.
+ *
+ * @result zero upon successful completion; error code otherwise
+ */
+int ocf_cache_get_cleaner_stats(ocf_cache_t cache,
+		struct ocf_stats_cleaner *stats);
+
+/**
+ * Aggregates of IO class over single statistics window interval
+ */
+struct ocf_stats_interval {
+	/** Length of interval in milliseconds */
+	uint64_t duration_ms;
+
+	/** Number of requests fully hit in cache, summed over all cores */
+	uint64_t hits;
+
+	/** Number of requests missed at least partially */
+	uint64_t misses;
+
+	/** Number of cache lines evicted from IO class */
+	uint64_t evicted_clines;
+
+	/** Number of cache lines of IO class at the end of interval */
+	uint64_t occupancy_clines;
+
+	/** Number of dirty cache lines of IO class at the end of interval */
+	uint64_t dirty_clines;
+};
+
+/**
+ * @brief Retrieve recent intervals of IO class statistics
+ *
+ * Intervals of OCF_CONFIG_STATS_WINDOW_INTERVAL_MS are closed by cleaner
+ * runs and last OCF_CONFIG_STATS_WINDOW of them are kept for each IO class.
+ *
+ * @param[in] cache cache handle
+ * @param[in] part_id IO class, stats of which are requested
+ * @param[out] samples intervals, newest first
+ * @param[inout] count size of samples on input, number of intervals
+ *		filled on output
+ *
+ * @result zero upon successful completion; error code otherwise
+ */
+int ocf_cache_io_class_get_stats_window(ocf_cache_t cache,
+		ocf_part_id_t part_id, struct ocf_stats_interval *samples,
+		uint32_t *count);
+
 /**
  * @brief retrieve core stats
  *
@@ -213,4 +386,215 @@ int ocf_core_get_stats(ocf_core_t core, struct ocf_stats_core *stats);
  */
 void ocf_core_update_stats(ocf_core_t core, struct ocf_io *io);
 
+/** Number of cache sizes in miss ratio curve */
+#define OCF_STATS_MRC_POINTS 32
+
+/**
+ * @brief Estimated miss ratio curve of core
+ */
+struct ocf_stats_mrc {
+	/** Number of sampled core line references */
+	uint64_t references;
+
+	/** Estimated number of distinct core lines referenced */
+	uint64_t working_set;
+
+	/** Current sampling rate in parts per million */
+	uint32_t sampling_ppm;
+
+	/** Estimated hit ratio (in permille) of LRU cache of 2^i lines */
+	uint32_t hit_ratio[OCF_STATS_MRC_POINTS];
+};
+
+/**
+ * @brief Retrieve estimated miss ratio curve of core
+ *
+ * @param[in] core core handle
+ * @param[out] mrc miss ratio curve
+ *
+ * @retval 0 Success
+ * @retval -OCF_ERR_INVAL Estimator was never enabled for core
+ */
+int ocf_core_get_mrc(ocf_core_t core, struct ocf_stats_mrc *mrc);
+
+/**
+ * @brief Estimated compressibility of data written to cache device
+ *
+ * Data in cache is never stored compressed, these are estimates only.
+ */
+struct ocf_stats_compress {
+	/** Number of sampled cache lines */
+	uint64_t sampled_lines;
+
+	/** Number of sampled cache lines which don't fit in fewer sectors */
+	uint64_t incompressible_lines;
+
+	/** Bytes of sampled cache lines */
+	uint64_t sampled_bytes;
+
+	/** Bytes of sampled cache lines compressed with LZ4 class compressor */
+	uint64_t compressed_bytes;
+
+	/** Bytes of compressed cache lines rounded up to whole sectors */
+	uint64_t stored_bytes;
+
+	/** Estimated effective cache capacity (in permille of cache size) */
+	uint32_t capacity_ratio;
+};
+
+/**
+ * @brief Retrieve estimated compressibility of cached data
+ *
+ * @param[in] cache cache handle
+ * @param[out] stats compressibility statistics
+ *
+ * @retval 0 Success
+ * @retval -OCF_ERR_INVAL Estimator was never enabled for cache
+ */
+int ocf_cache_get_compress_stats(ocf_cache_t cache,
+		struct ocf_stats_compress *stats);
+
+/**
+ * @brief Estimated duplication of data written to cache device
+ *
+ * Duplicated data in cache is never stored once, these are estimates only.
+ */
+struct ocf_stats_dedup {
+	/** Number of fingerprinted cache lines */
+	uint64_t sampled_lines;
+
+	/** Number of fingerprinted cache lines with tracked fingerprint */
+	uint64_t tracked_lines;
+
+	/** Number of distinct tracked fingerprints */
+	uint64_t distinct_lines;
+
+	/** Tracked part of fingerprint space in parts per million */
+	uint32_t sampling_ppm;
+
+	/** Estimated effective cache capacity (in permille of cache size) if
+	 * cache lines of the same content were stored once
+	 */
+	uint32_t capacity_ratio;
+};
+
+/**
+ * @brief Retrieve estimated duplication of cached data
+ *
+ * @param[in] cache cache handle
+ * @param[out] stats deduplication statistics
+ *
+ * @retval 0 Success
+ * @retval -OCF_ERR_INVAL Estimator was never enabled for cache
+ */
+int ocf_cache_get_dedup_stats(ocf_cache_t cache,
+		struct ocf_stats_dedup *stats);
+
+/** Layout version of statistics snapshot */
+#define OCF_STATS_SNAPSHOT_VERSION 1
+
+/**
+ * @brief Counters of single core in statistics snapshot
+ */
+struct ocf_stats_snapshot_core {
+	/** Core id */
+	ocf_core_id_t core_id;
+
+	/** Number of cache lines allocated in the cache for this core */
+	uint32_t cache_occupancy;
+
+	/** Number of dirty cache lines allocated in the cache for this core */
+	uint32_t dirty;
+
+	/** Read requests statistics */
+	struct ocf_stats_req read_reqs;
+
+	/** Write requests statistics */
+	struct ocf_stats_req write_reqs;
+
+	/** Block requests for cache volume statistics */
+	struct ocf_stats_block cache_volume;
+
+	/** Block requests for core volume statistics */
+	struct ocf_stats_block core_volume;
+
+	/** Block requests submitted by user to this core */
+	struct ocf_stats_block core;
+
+	/** Cache volume error statistics */
+	struct ocf_stats_error cache_errors;
+
+	/** Core volume error statistics */
+	struct ocf_stats_error core_errors;
+};
+
+/**
+ * @brief Statistics snapshot of all cores of cache
+ *
+ * Buffer is provided by caller, who sets version and size before taking
+ * snapshot. Required size is returned by ocf_stats_snapshot_size().
+ */
+struct ocf_stats_snapshot {
+	/** Layout version, set by caller to OCF_STATS_SNAPSHOT_VERSION */
+	uint32_t version;
+
+	/** Size of snapshot buffer in bytes, set by caller */
+	uint32_t size;
+
+	/** Time at which snapshot was taken (in nanoseconds) */
+	uint64_t timestamp_ns;
+
+	/** Number of valid entries in cores */
+	uint32_t core_count;
+
+	/** Counters of cores in ascending order of core id */
+	struct ocf_stats_snapshot_core cores[];
+};
+
+/**
+ * @brief Get size of statistics snapshot buffer
+ *
+ * @param[in] core_count number of cores snapshot should hold
+ *
+ * @result Snapshot buffer size in bytes
+ */
+uint32_t ocf_stats_snapshot_size(uint32_t core_count);
+
+/**
+ * @brief Take statistics snapshot of all cores of cache
+ *
+ * Counters are copied in single pass over cores without taking any lock
+ * and without management of cores, so snapshot is not atomic against
+ * concurrent I/O, but every counter is read exactly once.
+ *
+ * @param[in] cache cache handle
+ * @param[inout] snapshot snapshot buffer with version and size set
+ *
+ * @retval 0 Success
+ * @retval -OCF_ERR_INVAL Unsupported snapshot version
+ * @retval -ENOSPC Snapshot buffer too small for all cores of cache
+ */
+int ocf_cache_get_stats_snapshot(ocf_cache_t cache,
+		struct ocf_stats_snapshot *snapshot);
+
+/**
+ * @brief Compute difference between two statistics snapshots
+ *
+ * Cumulative counters of delta hold increase from prev to curr, gauges
+ * (occupancy and dirty) hold value of curr and timestamp holds interval
+ * between snapshots. Cores missing in prev, or whose counters were reset
+ * in between, are taken as a whole from curr.
+ *
+ * @param[in] prev older snapshot
+ * @param[in] curr newer snapshot
+ * @param[inout] delta buffer with version and size set
+ *
+ * @retval 0 Success
+ * @retval -OCF_ERR_INVAL Unsupported snapshot version
+ * @retval -ENOSPC Delta buffer too small for all cores of curr
+ */
+int ocf_stats_snapshot_delta(const struct ocf_stats_snapshot *prev,
+		const struct ocf_stats_snapshot *curr,
+		struct ocf_stats_snapshot *delta);
+
 #endif /* __OCF_STATS_H__ */
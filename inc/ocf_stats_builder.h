@@ -151,6 +151,132 @@ struct ocf_stats_errors {
 	struct ocf_stat total;
 };
 
+/** Number of buckets of latency histogram */
+#define OCF_STATS_LATENCY_BUCKETS 24
+
+/**
+ * @brief Latency histogram in log2 microsecond buckets
+ *
+ * Bucket 0 counts latencies below 2 us, bucket i counts latencies in range
+ * [2^i, 2^(i+1)) us and last bucket counts all longer latencies.
+ */
+struct ocf_stats_latency_hist {
+	/** Number of sampled requests */
+	uint64_t count;
+	/** Sum of sampled latencies in nanoseconds */
+	uint64_t total_ns;
+	/** Number of requests in each latency bucket */
+	uint64_t buckets[OCF_STATS_LATENCY_BUCKETS];
+};
+
+/**
+ * @brief Latency histograms breakdown
+ */
+enum ocf_stats_latency_type {
+	ocf_stats_latency_read_hit = 0,
+	/*!< Read requests fully hit in cache, from creation to completion */
+
+	ocf_stats_latency_read_miss,
+	/*!< Read requests missed at least partially */
+
+	ocf_stats_latency_write_hit,
+	/*!< Write requests fully hit in cache */
+
+	ocf_stats_latency_write_miss,
+	/*!< Write requests missed at least partially */
+
+	ocf_stats_latency_lock_wait,
+	/*!< Time requests spent waiting for cache line locks */
+
+	ocf_stats_latency_max,
+	/*!< Stopper of enumerator */
+};
+
+/**
+ * @brief Latency statistics
+ */
+struct ocf_stats_latency {
+	struct ocf_stats_latency_hist hist[ocf_stats_latency_max];
+};
+
+/**
+ * @brief Instrumented locks
+ */
+enum ocf_stats_lock_type {
+	ocf_stats_lock_metadata_rd = 0,
+	/*!< Global metadata lock taken for READ access */
+
+	ocf_stats_lock_metadata_wr,
+	/*!< Global metadata lock taken for WRITE access */
+
+	ocf_stats_lock_status_bits_rd,
+	/*!< Status bits locks taken for READ access */
+
+	ocf_stats_lock_status_bits_wr,
+	/*!< Status bits locks taken for WRITE access */
+
+	ocf_stats_lock_cache_line,
+	/*!< Cache line locks of requests, waited for asynchronously */
+
+	ocf_stats_lock_max,
+	/*!< Stopper of enumerator */
+};
+
+/**
+ * @brief Contention statistics of single lock type
+ */
+struct ocf_stats_lock {
+	/** Number of acquisitions which had to wait for lock */
+	uint64_t contended;
+	/** Total time spent waiting in nanoseconds */
+	uint64_t wait_ns;
+};
+
+/**
+ * @brief Lock contention statistics of cache
+ */
+struct ocf_stats_locks {
+	struct ocf_stats_lock lock[ocf_stats_lock_max];
+
+	/** Number of cache line waiters added since cache was attached */
+	uint64_t cache_line_waiters;
+
+	/** Number of requests currently waiting for cache line locks */
+	uint32_t suspended;
+};
+
+/**
+ * @brief Number of buckets of collision chain length histogram
+ */
+#define OCF_STATS_HASH_CHAIN_HIST 16
+
+/**
+ * @brief Metadata hash table statistics
+ */
+struct ocf_stats_hash {
+	/** Number of hash table entries */
+	uint32_t entries;
+
+	/** Average number of cache lines per hash table entry set at start */
+	uint32_t load_factor;
+
+	/** Number of hash table entries with non-empty collision chain */
+	uint32_t used;
+
+	/** Number of cache lines in all collision chains */
+	uint32_t lines;
+
+	/** Length of longest collision chain */
+	uint32_t max_chain;
+
+	/**
+	 * Number of hash table entries by collision chain length, last
+	 * bucket counts all chains of OCF_STATS_HASH_CHAIN_HIST - 1 or more
+	 * cache lines
+	 */
+	uint32_t chains[OCF_STATS_HASH_CHAIN_HIST];
+};
+
 /**
  * @param Collect statistics for given cache
  *
@@ -187,4 +313,57 @@ int ocf_stats_collect_core(ocf_core_t core,
 		struct ocf_stats_blocks *blocks,
 		struct ocf_stats_errors *errors);
 
+/**
+ * @brief Collect latency histograms of given core
+ *
+ * @param core Core for which statistics will be collected
+ * @param latency Latency statistics
+ *
+ * @retval 0 Success
+ * @retval -ENOTSUP Latency statistics not built in
+ *	(OCF_CONFIG_STATS_LATENCY)
+ */
+int ocf_stats_collect_core_latency(ocf_core_t core,
+		struct ocf_stats_latency *latency);
+
+/**
+ * @brief Collect latency histogram of requests of given IO class of core
+ *
+ * @param core Core for which statistics will be collected
+ * @param part_id IO class id
+ * @param hist Latency histogram of all requests of IO class
+ *
+ * @retval 0 Success
+ * @retval -ENOTSUP Latency statistics not built in
+ *	(OCF_CONFIG_STATS_LATENCY)
+ * @retval Non-zero Other error
+ */
+int ocf_stats_collect_part_latency(ocf_core_t core, ocf_part_id_t part_id,
+		struct ocf_stats_latency_hist *hist);
+
+/**
+ * @brief Collect lock contention statistics of given cache
+ *
+ * @param cache Cache for which statistics will be collected
+ * @param locks Lock contention statistics
+ *
+ * @retval 0 Success
+ * @retval -ENOTSUP Lock statistics not built in (OCF_CONFIG_STATS_LOCK)
+ */
+int ocf_stats_collect_locks(ocf_cache_t cache, struct ocf_stats_locks *locks);
+
+/**
+ * @brief Collect collision chain lengths of metadata hash table of given cache
+ *
+ * @note Hash table is walked in chunks under exclusive metadata lock, so
+ *	I/O of cache is stalled for duration of each chunk
+ *
+ * @param cache Cache for which statistics will be collected
+ * @param hash Hash table statistics
+ *
+ * @retval 0 Success
+ * @retval -OCF_ERR_INVAL Cache device is not attached
+ */
+int ocf_stats_collect_hash(ocf_cache_t cache, struct ocf_stats_hash *hash);
+
 #endif /* __OCF_STATS_BUILDER_H__ */
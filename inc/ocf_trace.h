@@ -11,7 +11,7 @@
 
 typedef uint64_t log_sid_t;
 
-#define OCF_EVENT_VERSION	1
+#define OCF_EVENT_VERSION	3
 #define OCF_TRACING_STOP	1
 
 /**
@@ -33,6 +33,12 @@ typedef enum {
 
 	/** IO in file domain */
 	ocf_event_type_io_file,
+
+	/** Eviction done on behalf of IO */
+	ocf_event_type_eviction,
+
+	/** IO request reached stage of its processing */
+	ocf_event_type_req_stage,
 } ocf_event_type;
 
 /**
@@ -144,6 +150,81 @@ struct ocf_event_io_cmpl {
 	bool is_hit;
 };
 
+/**
+ * @brief Eviction event
+ */
+struct ocf_event_eviction {
+	/** Trace event header */
+	struct ocf_event_hdr hdr;
+
+	/** Core ID of IO which needed space */
+	ocf_core_id_t core_id;
+
+	/** IO class of IO which needed space */
+	uint32_t io_class;
+
+	/** Number of cache lines requested to be evicted */
+	uint32_t requested;
+
+	/** Number of cache lines actually evicted */
+	uint32_t evicted;
+
+	/** Time spent on eviction in nanoseconds */
+	uint64_t duration;
+};
+
+/**
+ * @brief Stage of IO request processing
+ */
+typedef enum {
+	/** Request pushed to I/O queue */
+	ocf_event_req_stage_queued,
+
+	/** Metadata lock acquired, value: 0 - hash read, 1 - hash write,
+	 * 2 - global write */
+	ocf_event_req_stage_metadata_locked,
+
+	/** Cache line locks not granted, request waits for them */
+	ocf_event_req_stage_cline_lock_wait,
+
+	/** Cache line locks granted */
+	ocf_event_req_stage_cline_lock_granted,
+
+	/** Eviction done, value: number of evicted cache lines */
+	ocf_event_req_stage_eviction_done,
+
+	/** I/O submitted to cache volume, value: number of bytes */
+	ocf_event_req_stage_cache_io_submitted,
+
+	/** I/O to cache volume completed */
+	ocf_event_req_stage_cache_io_completed,
+
+	/** I/O submitted to core volume, value: number of bytes */
+	ocf_event_req_stage_core_io_submitted,
+
+	/** I/O to core volume completed */
+	ocf_event_req_stage_core_io_completed,
+
+	/** Backfill of cache lines read from core completed */
+	ocf_event_req_stage_backfill_completed,
+} ocf_event_req_stage_t;
+
+/**
+ * @brief Request stage event
+ */
+struct ocf_event_req_stage {
+	/** Trace event header */
+	struct ocf_event_hdr hdr;
+
+	/** Sequence ID of IO event of request */
+	log_sid_t rsid;
+
+	/** Stage reached by request */
+	ocf_event_req_stage_t stage;
+
+	/** Stage specific value */
+	uint32_t value;
+};
 
 /** @brief Push log callback.
  *
@@ -172,6 +253,61 @@ typedef void (*ocf_trace_callback_t)(ocf_cache_t cache, void *trace_ctx,
 int ocf_mngt_start_trace(ocf_cache_t cache, void *trace_ctx,
 		ocf_trace_callback_t trace_callback);
 
+/**
+ * @brief Start tracing to ring buffers of I/O queues
+ *
+ * Instead of being passed to callback, events are stored in fixed size
+ * ring buffer of I/O queue they were traced on, to be drained by adapter
+ * in bulk with ocf_trace_ring_drain(). Events which don't fit in ring are
+ * dropped and counted. Sequence IDs of events are numbered per queue.
+ *
+ * @param[in] cache OCF cache
+ *
+ * @retval 0 Tracing started successfully
+ * @retval Non-zero Error
+ */
+int ocf_mngt_start_trace_ring(ocf_cache_t cache);
+
+/**
+ * @brief Copy events from trace ring of I/O queue to buffer
+ *
+ * Events are copied back to back, each one starting with ocf_event_hdr
+ * holding its size. Events left in ring after tracing is stopped may be
+ * still drained.
+ *
+ * @note Ring of queue may be drained by single thread at a time
+ *
+ * @param[in] queue I/O queue
+ * @param[out] buf Buffer for events
+ * @param[in] size Size of buffer
+ *
+ * @return Number of bytes copied to buffer
+ */
+uint32_t ocf_trace_ring_drain(ocf_queue_t queue, void *buf, uint32_t size);
+
+/**
+ * @brief Get number of events dropped due to trace ring of I/O queue
+ *	  being full
+ *
+ * @param[in] queue I/O queue
+ *
+ * @return Number of dropped events
+ */
+uint64_t ocf_trace_ring_dropped(ocf_queue_t queue);
+
+/**
+ * @brief Enable or disable request stage events
+ *
+ * Request stage events allow to break down latency of traced IO into time
+ * spent in queue, waiting for locks, on eviction and on cache and core
+ * I/O. They are disabled by default, as several of them are pushed for
+ * each IO.
+ *
+ * @param[in] cache OCF cache
+ * @param[in] enable Push request stage events when tracing
+ */
+void ocf_mngt_trace_req_stages(ocf_cache_t cache, bool enable);
+
 /**
  * @brief Stop tracing
  *
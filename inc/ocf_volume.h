@@ -39,6 +39,9 @@ struct ocf_volume_uuid {
 struct ocf_volume_caps {
 	uint32_t atomic_writes : 1;
 		/*!< Volume supports atomic writes */
+	uint32_t tested : 1;
+		/*!< Volume is known to behave correctly and to return zeroes
+		 * from discarded ranges, so it's not tested on attach */
 };
 
 /**
@@ -112,6 +115,41 @@ struct ocf_volume_ops {
 	 * @param[in] volume Volume
 	 */
 	uint64_t (*get_length)(ocf_volume_t volume);
+
+	/**
+	 * @brief Start burst of IOs submitted in a row
+	 *
+	 * @note Optional. IOs submitted until unplug() may be held by volume
+	 *	 and dispatched together, e.g. merged or with single doorbell.
+	 *	 Plug is per submitting thread. It may nest when completion
+	 *	 of IO leads to synchronous submission of more IOs, so volume
+	 *	 should dispatch held IOs on the outermost unplug().
+	 *
+	 * @param[in] volume Volume
+	 */
+	void (*plug)(ocf_volume_t volume);
+
+	/**
+	 * @brief End burst of IOs started with plug(), dispatching IOs held
+	 *	  by volume
+	 *
+	 * @param[in] volume Volume
+	 */
+	void (*unplug)(ocf_volume_t volume);
+
+	/**
+	 * @brief Get byte addressable mapping of volume
+	 *
+	 * @note Optional. Volume backed by persistent memory (e.g. DAX) may
+	 *	 return address at which its whole content is mapped, so that
+	 *	 metadata is stored to it instead of being written with IOs.
+	 *	 Stores to mapping are made durable with env_pmem_persist().
+	 *
+	 * @param[in] volume Volume
+	 *
+	 * @return Address of volume offset 0 or NULL if not mapped
+	 */
+	void *(*get_direct_mapping)(ocf_volume_t volume);
 };
 
 /**
@@ -0,0 +1,49 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __OCF_PROMOTION_NHIT_H__
+#define __OCF_PROMOTION_NHIT_H__
+
+/**
+ * @file
+ * @brief NHIT promotion policy API
+ */
+
+enum ocf_promotion_nhit_parameters {
+	ocf_nhit_insertion_threshold,
+	ocf_nhit_trigger_threshold,
+};
+
+/**
+ * @name NHIT promotion policy parameters
+ * @{
+ */
+
+/**
+ * Number of misses of core line after which it is inserted into cache
+ */
+
+/** Insertion threshold minimum value */
+#define OCF_NHIT_MIN_INSERTION_THRESHOLD	2
+/** Insertion threshold maximum value */
+#define OCF_NHIT_MAX_INSERTION_THRESHOLD	255
+/** Insertion threshold default value */
+#define OCF_NHIT_DEFAULT_INSERTION_THRESHOLD	3
+
+/**
+ * Cache occupancy (percent) below which every miss is inserted into cache
+ */
+
+/** Trigger threshold minimum value */
+#define OCF_NHIT_MIN_TRIGGER_THRESHOLD		0
+/** Trigger threshold maximum value */
+#define OCF_NHIT_MAX_TRIGGER_THRESHOLD		100
+/** Trigger threshold default value */
+#define OCF_NHIT_DEFAULT_TRIGGER_THRESHOLD	80
+
+/**
+ * @}
+ */
+
+#endif /* __OCF_PROMOTION_NHIT_H__ */
@@ -12,7 +12,7 @@
 #include "../utils/utils_req.h"
 #include "../cleaning/acp.h"
 #include "../engine/engine_common.h"
-#include "../concurrency/ocf_cache_concurrency.h"
+#include "../concurrency/ocf_concurrency.h"
 #include "cleaning_priv.h"
 #include "../utils/utils_core.h"
 
@@ -98,24 +98,28 @@ struct acp_chunk_info {
 };
 
 struct acp_bucket {
-	struct list_head chunk_list;
 	uint16_t threshold; /* threshold in clines */
 };
 
-struct acp_context {
-	env_rwsem chunks_lock;
+/* chunks of single core sorted into buckets */
+struct acp_core {
+	/* chunks in each bucket */
+	struct list_head bucket_list[ACP_MAX_BUCKETS];
 
-	/* number of chunks per core */
-	uint64_t num_chunks[OCF_CORE_MAX];
+	/* entry on dirty cores list of cleaner instance owning core */
+	struct list_head dirty_list;
 
-	/* per core array of all chunks */
-	struct acp_chunk_info *chunk_info[OCF_CORE_MAX];
+	/* number of chunks above bucket 0 */
+	uint64_t dirty_chunks;
 
-	struct acp_bucket bucket_info[ACP_MAX_BUCKETS];
+	/* chunks left to be cleaned in current round robin turn */
+	uint16_t credit;
 
-	/* total number of chunks in cache */
-	uint64_t chunks_total;
+	ocf_core_id_t core_id;
+};
 
+/* state of single cleaner instance */
+struct acp_cleaner {
 	/* structure to keep track of I/O in progress */
 	struct acp_flush_context flush;
 
@@ -123,18 +127,58 @@ struct acp_context {
 	 perform_cleaning */
 	struct acp_state state;
 
-	/* cache handle */
-	ocf_cache_t cache;
+	/* policy context */
+	struct acp_context *acp;
+
+	/* cleaner instance */
+	ocf_cleaner_t cleaner;
 
 	/* cleaner completion callback */
 	ocf_cleaner_end_t cmpl;
 
+	/* round robin list of owned cores having dirty chunks */
+	struct list_head dirty_cores;
+	uint32_t dirty_cores_no;
+
+	/* dirty pressure of current perform_cleaning call */
+	uint32_t pressure;
+
 #if 1 == OCF_ACP_DEBUG
 	/* debug only */
 	uint64_t checksum;
 #endif
 };
 
+struct acp_context {
+	env_rwsem chunks_lock;
+
+	/* number of chunks per core */
+	uint64_t num_chunks[OCF_CORE_MAX];
+
+#if OCF_CONFIG_ACP_LAZY_CHUNKS
+	/* per core array of leaves of OCF_CONFIG_ACP_LAZY_CHUNKS chunks,
+	 * leaf is NULL until any of its chunks gets dirty */
+	struct acp_chunk_info **chunk_leaf[OCF_CORE_MAX];
+#else
+	/* per core array of all chunks */
+	struct acp_chunk_info *chunk_info[OCF_CORE_MAX];
+#endif
+
+	/* per core chunk buckets */
+	struct acp_core *core_info[OCF_CORE_MAX];
+
+	struct acp_bucket bucket_info[ACP_MAX_BUCKETS];
+
+	/* total number of chunks in cache */
+	uint64_t chunks_total;
+
+	/* cache handle */
+	ocf_cache_t cache;
+
+	/* state of each cleaner instance */
+	struct acp_cleaner cleaner[];
+};
+
 struct acp_core_line_info
 {
 	ocf_cache_line_t cache_line;
@@ -178,8 +222,44 @@ static struct acp_core_line_info _acp_core_line_info(struct ocf_cache *cache,
 	return acp_core_line_info;
 }
 
+#if OCF_CONFIG_ACP_LAZY_CHUNKS
+static struct acp_chunk_info *_acp_get_lazy_chunk(struct acp_context *acp,
+		ocf_core_id_t core_id, uint64_t chunk_id, bool alloc)
+{
+	struct acp_chunk_info **leaf, *chunks;
+	uint64_t first, i, count;
+
+	leaf = &acp->chunk_leaf[core_id][chunk_id / OCF_CONFIG_ACP_LAZY_CHUNKS];
+	if (*leaf || !alloc)
+		goto out;
+
+	chunks = env_zalloc(sizeof(*chunks) * OCF_CONFIG_ACP_LAZY_CHUNKS,
+			ENV_MEM_NOIO);
+	if (!chunks)
+		return NULL;
+
+	first = chunk_id - chunk_id % OCF_CONFIG_ACP_LAZY_CHUNKS;
+	count = OCF_MIN(acp->num_chunks[core_id] - first,
+			(uint64_t)OCF_CONFIG_ACP_LAZY_CHUNKS);
+
+	for (i = 0; i < count; i++) {
+		/* fill in chunk metadata and add to the clean bucket */
+		chunks[i].core_id = core_id;
+		chunks[i].chunk_id = first + i;
+		list_add(&chunks[i].list,
+				&acp->core_info[core_id]->bucket_list[0]);
+	}
+
+	*leaf = chunks;
+
+out:
+	return *leaf ? &(*leaf)[chunk_id % OCF_CONFIG_ACP_LAZY_CHUNKS] : NULL;
+}
+#endif
+
+/* Returns NULL if chunk is not allocated and alloc is false or fails */
 static struct acp_chunk_info *_acp_get_chunk(struct ocf_cache *cache,
-		uint32_t cache_line)
+		uint32_t cache_line, bool alloc)
 {
 	struct acp_context *acp = _acp_get_ctx_from_cache(cache);
 	struct acp_core_line_info core_line =
@@ -188,7 +268,11 @@ static struct acp_chunk_info *_acp_get_chunk(struct ocf_cache *cache,
 
 	chunk_id = core_line.core_line * ocf_line_size(cache) / ACP_CHUNK_SIZE;
 
+#if OCF_CONFIG_ACP_LAZY_CHUNKS
+	return _acp_get_lazy_chunk(acp, core_line.core_id, chunk_id, alloc);
+#else
 	return &acp->chunk_info[core_line.core_id][chunk_id];
+#endif
 }
 
 static void _acp_remove_cores(struct ocf_cache *cache)
@@ -237,6 +321,47 @@ void cleaning_policy_acp_deinitialize(struct ocf_cache *cache)
 	cache->cleaner.cleaning_policy_context = NULL;
 }
 
+size_t cleaning_policy_acp_size_of(struct ocf_cache *cache)
+{
+	struct acp_context *acp = _acp_get_ctx_from_cache(cache);
+	size_t size;
+	int i;
+#if OCF_CONFIG_ACP_LAZY_CHUNKS
+	uint64_t j, leaves;
+#endif
+
+	if (!acp)
+		return 0;
+
+	size = sizeof(*acp) + sizeof(acp->cleaner[0]) * cache->cleaner.count;
+
+	ACP_LOCK_CHUNKS_RD();
+
+	for (i = 0; i < OCF_CORE_MAX; i++) {
+		if (!acp->core_info[i])
+			continue;
+
+		size += sizeof(*acp->core_info[i]);
+#if OCF_CONFIG_ACP_LAZY_CHUNKS
+		leaves = OCF_DIV_ROUND_UP(acp->num_chunks[i],
+				OCF_CONFIG_ACP_LAZY_CHUNKS);
+		size += leaves * sizeof(acp->chunk_leaf[0][0]);
+		for (j = 0; j < leaves; j++) {
+			if (acp->chunk_leaf[i][j]) {
+				size += sizeof(acp->chunk_leaf[0][0][0]) *
+						OCF_CONFIG_ACP_LAZY_CHUNKS;
+			}
+		}
+#else
+		size += acp->num_chunks[i] * sizeof(acp->chunk_info[0][0]);
+#endif
+	}
+
+	ACP_UNLOCK_CHUNKS_RD();
+
+	return size;
+}
+
 static void _acp_rebuild(struct ocf_cache *cache)
 {
 	ocf_cache_line_t cline;
@@ -282,15 +407,18 @@ int cleaning_policy_acp_initialize(struct ocf_cache *cache,
 	/* bug if max chunk number would overflow dirty_no array type */
 #if defined (BUILD_BUG_ON)
 	BUILD_BUG_ON(ACP_CHUNK_SIZE / ocf_cache_line_size_min >=
-			1U << (sizeof(acp->chunk_info[0][0].num_dirty) * 8));
+			1U << (sizeof(acp->cleaner[0].state.chunk->num_dirty) *
+					8));
 #else
 	ENV_BUG_ON(ACP_CHUNK_SIZE / ocf_cache_line_size_min >=
-			1U << (sizeof(acp->chunk_info[0][0].num_dirty) * 8));
+			1U << (sizeof(acp->cleaner[0].state.chunk->num_dirty) *
+					8));
 #endif
 
 	ENV_BUG_ON(cache->cleaner.cleaning_policy_context);
 
-	acp = env_vzalloc(sizeof(*acp));
+	acp = env_vzalloc(sizeof(*acp) +
+			sizeof(acp->cleaner[0]) * cache->cleaner.count);
 	if (!acp) {
 		ocf_cache_log(cache, log_err, "acp context allocation error\n");
 		return -OCF_ERR_NO_MEM;
@@ -298,10 +426,15 @@ int cleaning_policy_acp_initialize(struct ocf_cache *cache,
 	cache->cleaner.cleaning_policy_context = acp;
 	acp->cache = cache;
 
+	for (i = 0; i < cache->cleaner.count; i++) {
+		acp->cleaner[i].acp = acp;
+		acp->cleaner[i].cleaner = &cache->cleaner.instance[i];
+		INIT_LIST_HEAD(&acp->cleaner[i].dirty_cores);
+	}
+
 	env_rwsem_init(&acp->chunks_lock);
 
 	for (i = 0; i < ACP_MAX_BUCKETS; i++) {
-		INIT_LIST_HEAD(&acp->bucket_info[i].chunk_list);
 		acp->bucket_info[i].threshold =
 			((ACP_CHUNK_SIZE/ocf_line_size(cache)) *
 			 ACP_BUCKET_DEFAULTS[i]) / 100;
@@ -377,32 +510,36 @@ int cleaning_policy_acp_get_cleaning_param(ocf_cache_t cache,
 
 
 /* attempt to lock cache line if it's dirty */
-static ocf_cache_line_t _acp_trylock_dirty(struct ocf_cache *cache,
+static ocf_cache_line_t _acp_trylock_dirty(struct acp_cleaner *ac,
 		uint32_t core_id, uint64_t core_line)
 {
+	struct ocf_cache *cache = ac->acp->cache;
 	struct ocf_map_info info;
 	bool locked = false;
+	ocf_cache_line_t hash = ocf_metadata_hash_func(cache, core_line,
+			core_id);
 
-	OCF_METADATA_LOCK_RD();
+	ocf_metadata_hash_lock_rd(cache, hash);
 
 	ocf_engine_lookup_map_entry(cache, &info, core_id,
 			core_line);
 
 	if (info.status == LOOKUP_HIT &&
-			metadata_test_dirty(cache, info.coll_idx) &&
-			ocf_cache_line_try_lock_rd(cache, info.coll_idx)) {
-		locked = true;
+			metadata_test_dirty(cache, info.coll_idx)) {
+		locked = ocf_cache_line_try_lock_rd(cache, info.coll_idx);
+		if (!locked)
+			ocf_cleaner_account_busy(ac->cleaner, info.coll_idx);
 	}
 
-	OCF_METADATA_UNLOCK_RD();
+	ocf_metadata_hash_unlock_rd(cache, hash);
 
 	return locked ? info.coll_idx : cache->device->collision_table_entries;
 }
 
 static void _acp_handle_flush_error(struct ocf_cache *cache,
-		struct acp_context *acp)
+		struct acp_cleaner *ac)
 {
-	struct acp_flush_context *flush = &acp->flush;
+	struct acp_flush_context *flush = &ac->flush;
 
 	flush->chunk->next_cleaning_timestamp = env_get_tick_count() +
 			env_secs_to_ticks(ACP_CHUNK_CLEANING_BACKOFF_TIME);
@@ -422,83 +559,123 @@ static void _acp_handle_flush_error(struct ocf_cache *cache,
 static inline bool _acp_can_clean_chunk(struct ocf_cache *cache,
 		struct acp_chunk_info *chunk)
 {
-	/* Check if core device is opened and if timeout after cleaning error
-	 * expired or wasn't set in the first place */
-	return (cache->core[chunk->core_id].opened &&
-			(chunk->next_cleaning_timestamp > env_get_tick_count() ||
-					!chunk->next_cleaning_timestamp));
+	/* Check if timeout after cleaning error expired or wasn't set in the
+	 * first place */
+	return (chunk->next_cleaning_timestamp <= env_get_tick_count() ||
+			!chunk->next_cleaning_timestamp);
 }
 
-static struct acp_chunk_info *_acp_get_cleaning_candidate(ocf_cache_t cache)
+/* Pick chunk of core from its dirtiest bucket, return 0 if there is none */
+static int _acp_get_core_candidate(struct ocf_cache *cache,
+		struct acp_core *core, struct acp_chunk_info **chunk)
 {
-	int i;
 	struct acp_chunk_info *cur;
-	struct acp_context *acp = cache->cleaner.cleaning_policy_context;
+	int i;
 
-	ACP_LOCK_CHUNKS_RD();
+	if (!cache->core[core->core_id].opened)
+		return 0;
 
-	/* go through all buckets in descending order, excluding bucket 0 which
+	/* go through buckets in descending order, excluding bucket 0 which
 	 * is supposed to contain all clean chunks */
 	for (i = ACP_MAX_BUCKETS - 1; i > 0; i--) {
-		list_for_each_entry(cur, &acp->bucket_info[i].chunk_list, list) {
+		list_for_each_entry(cur, &core->bucket_list[i], list) {
 			if (_acp_can_clean_chunk(cache, cur)) {
-				ACP_UNLOCK_CHUNKS_RD();
-				return cur;
+				*chunk = cur;
+				return i;
 			}
 		}
 	}
 
-	ACP_UNLOCK_CHUNKS_RD();
-	return NULL;
+	return 0;
+}
+
+/*
+ * Dirty cores owned by cleaner instance take turns in round robin. In each
+ * turn core gets as many chunks as is the number of its dirtiest bucket, so
+ * cores drain in proportion to how dirty they are and none of them starves.
+ */
+static struct acp_chunk_info *_acp_get_cleaning_candidate(ocf_cache_t cache,
+		struct acp_cleaner *ac)
+{
+	struct acp_context *acp = ac->acp;
+	struct acp_chunk_info *chunk = NULL;
+	struct acp_core *core;
+	uint32_t i;
+	int bucket;
+
+	ACP_LOCK_CHUNKS_WR();
+
+	for (i = 0; i < ac->dirty_cores_no; i++) {
+		core = list_first_entry(&ac->dirty_cores, struct acp_core,
+				dirty_list);
+
+		bucket = _acp_get_core_candidate(cache, core, &chunk);
+		if (bucket) {
+			if (!core->credit)
+				core->credit = bucket;
+			if (--core->credit == 0)
+				list_move_tail(&core->dirty_list, &ac->dirty_cores);
+			break;
+		}
+
+		core->credit = 0;
+		list_move_tail(&core->dirty_list, &ac->dirty_cores);
+	}
+
+	ACP_UNLOCK_CHUNKS_WR();
+
+	return chunk;
 }
 
 /* called after flush request completed */
 static void _acp_flush_end(void *priv, int error)
 {
 	struct acp_cleaning_policy_config *config;
-	struct acp_context *acp = priv;
-	struct acp_flush_context *flush = &acp->flush;
-	ocf_cache_t cache = acp->cache;
+	struct acp_cleaner *ac = priv;
+	struct acp_flush_context *flush = &ac->flush;
+	ocf_cache_t cache = ac->acp->cache;
 	int i;
 
 	config = (void *)&cache->conf_meta->cleaning[ocf_cleaning_acp].data;
 
 	for (i = 0; i < flush->size; i++) {
 		ocf_cache_line_unlock_rd(cache, flush->data[i].cache_line);
-		ACP_DEBUG_END(acp, flush->data[i].cache_line);
+		ACP_DEBUG_END(ac, flush->data[i].cache_line);
 	}
 
 	if (error) {
 		flush->error = error;
-		_acp_handle_flush_error(cache, acp);
+		_acp_handle_flush_error(cache, ac);
 	}
 
-	ACP_DEBUG_CHECK(acp);
+	ACP_DEBUG_CHECK(ac);
 
-	acp->cmpl(&cache->cleaner, config->thread_wakeup_time);
+	/* Don't sleep between chunks while nearing high dirty watermark */
+	ac->cmpl(ac->cleaner, ac->pressure ? 0 :
+			config->thread_wakeup_time);
 }
 
 /* flush data  */
-static void _acp_flush(struct acp_context *acp)
+static void _acp_flush(struct acp_cleaner *ac)
 {
-	ocf_cache_t cache = acp->cache;
+	ocf_cache_t cache = ac->acp->cache;
 	struct ocf_cleaner_attribs attribs = {
-		.cmpl_context = acp,
+		.cmpl_context = ac,
 		.cmpl_fn = _acp_flush_end,
 		.cache_line_lock = false,
 		.do_sort = false,
-		.io_queue = cache->cleaner.io_queue,
+		.io_queue = ac->cleaner->io_queue,
 	};
 
-	ocf_cleaner_do_flush_data_async(cache, acp->flush.data,
-				acp->flush.size, &attribs);
+	ocf_cleaner_do_flush_data_async(cache, ac->flush.data,
+				ac->flush.size, &attribs);
 }
 
-static bool _acp_prepare_flush_data(struct acp_context *acp,
+static bool _acp_prepare_flush_data(struct acp_cleaner *ac,
 		uint32_t flush_max_buffers)
 {
-	ocf_cache_t cache = acp->cache;
-	struct acp_state *state = &acp->state;
+	ocf_cache_t cache = ac->acp->cache;
+	struct acp_state *state = &ac->state;
 	struct acp_chunk_info *chunk = state->chunk;
 	size_t lines_per_chunk = ACP_CHUNK_SIZE / ocf_line_size(cache);
 	uint64_t first_core_line = chunk->chunk_id * lines_per_chunk;
@@ -507,23 +684,23 @@ static bool _acp_prepare_flush_data(struct acp_context *acp,
 			"first_core_line %llu\n", (uint64_t)lines_per_chunk,
 			chunk->chunk_id, first_core_line);
 
-	acp->flush.size = 0;
-	acp->flush.chunk = chunk;
+	ac->flush.size = 0;
+	ac->flush.chunk = chunk;
 	for (; state->iter < lines_per_chunk &&
-			acp->flush.size < flush_max_buffers; state->iter++) {
+			ac->flush.size < flush_max_buffers; state->iter++) {
 		uint64_t core_line = first_core_line + state->iter;
 		ocf_cache_line_t cache_line;
 
-		cache_line = _acp_trylock_dirty(cache, chunk->core_id, core_line);
+		cache_line = _acp_trylock_dirty(ac, chunk->core_id, core_line);
 		if (cache_line == cache->device->collision_table_entries)
 			continue;
 
-		ACP_DEBUG_BEGIN(acp, cache_line);
+		ACP_DEBUG_BEGIN(ac, cache_line);
 
-		acp->flush.data[acp->flush.size].core_id = chunk->core_id;
-		acp->flush.data[acp->flush.size].core_line = core_line;
-		acp->flush.data[acp->flush.size].cache_line = cache_line;
-		acp->flush.size++;
+		ac->flush.data[ac->flush.size].core_id = chunk->core_id;
+		ac->flush.data[ac->flush.size].core_line = core_line;
+		ac->flush.data[ac->flush.size].cache_line = cache_line;
+		ac->flush.size++;
 	}
 
 	if (state->iter == lines_per_chunk) {
@@ -531,27 +708,29 @@ static bool _acp_prepare_flush_data(struct acp_context *acp,
 		state->in_progress = false;
 	}
 
-	return (acp->flush.size > 0);
+	return (ac->flush.size > 0);
 }
 
 /* Clean at most 'flush_max_buffers' cache lines from current or newly
  * selected chunk */
 void cleaning_policy_acp_perform_cleaning(ocf_cache_t cache,
-		ocf_cleaner_end_t cmpl)
+		ocf_cleaner_t cleaner, ocf_cleaner_end_t cmpl)
 {
 	struct acp_cleaning_policy_config *config;
 	struct acp_context *acp = _acp_get_ctx_from_cache(cache);
-	struct acp_state *state = &acp->state;
+	struct acp_cleaner *ac = &acp->cleaner[cleaner->id];
+	struct acp_state *state = &ac->state;
+	uint32_t batch;
 
-	acp->cmpl = cmpl;
+	ac->cmpl = cmpl;
 
 	if (!state->in_progress) {
 		/* get next chunk to clean */
-		state->chunk = _acp_get_cleaning_candidate(cache);
+		state->chunk = _acp_get_cleaning_candidate(cache, ac);
 
 		if (!state->chunk) {
 			/* nothing co clean */
-			cmpl(&cache->cleaner, ACP_BACKOFF_TIME_MS);
+			cmpl(cleaner, ACP_BACKOFF_TIME_MS);
 			return;
 		}
 
@@ -560,38 +739,66 @@ void cleaning_policy_acp_perform_cleaning(ocf_cache_t cache,
 		state->in_progress = true;
 	}
 
-	ACP_DEBUG_INIT(acp);
+	ACP_DEBUG_INIT(ac);
 
 	config = (void *)&cache->conf_meta->cleaning[ocf_cleaning_acp].data;
 
-	if (_acp_prepare_flush_data(acp, config->flush_max_buffers))
-		_acp_flush(acp);
+	ocf_cleaner_pool_set_batch(cache, config->flush_max_buffers);
+
+	ac->pressure = ocf_cleaning_dirty_pressure(cache);
+	batch = ocf_cleaning_pressure_batch(ocf_cleaner_throttle_batch(cache,
+			config->flush_max_buffers), ac->pressure);
+	batch = ocf_cleaner_drain_batch(cache, batch);
+
+	if (_acp_prepare_flush_data(ac, OCF_MIN(batch,
+			(uint32_t)OCF_ACP_MAX_FLUSH_MAX_BUFFERS)))
+		_acp_flush(ac);
 	else
-		_acp_flush_end(acp, 0);
+		_acp_flush_end(ac, 0);
+}
+
+static inline struct acp_cleaner *_acp_core_cleaner(struct acp_context *acp,
+		ocf_core_id_t core_id)
+{
+	return &acp->cleaner[core_id % acp->cache->cleaner.count];
 }
 
 static void _acp_update_bucket(struct acp_context *acp,
 		struct acp_chunk_info *chunk)
 {
 	struct acp_bucket *bucket = &acp->bucket_info[chunk->bucket_id];
+	struct acp_core *core = acp->core_info[chunk->core_id];
+	struct acp_cleaner *ac;
 
 	if (chunk->num_dirty > bucket->threshold) {
 		ENV_BUG_ON(chunk->bucket_id == ACP_MAX_BUCKETS - 1);
 
-		chunk->bucket_id++;
 		/* buckets are stored in array, move up one bucket.
 		 * No overflow here. ENV_BUG_ON made sure of no incrementation on
 		 * last bucket */
-		bucket++;
+		chunk->bucket_id++;
+
+		list_move_tail(&chunk->list,
+				&core->bucket_list[chunk->bucket_id]);
 
-		list_move_tail(&chunk->list, &bucket->chunk_list);
+		if (chunk->bucket_id == 1 && core->dirty_chunks++ == 0) {
+			ac = _acp_core_cleaner(acp, chunk->core_id);
+			list_add_tail(&core->dirty_list, &ac->dirty_cores);
+			ac->dirty_cores_no++;
+		}
 	} else if (chunk->bucket_id &&
 			chunk->num_dirty <= (bucket - 1)->threshold) {
-		chunk->bucket_id--;
 		/* move down one bucket, we made sure we won't underflow */
-		bucket--;
+		chunk->bucket_id--;
 
-		list_move(&chunk->list, &bucket->chunk_list);
+		list_move(&chunk->list, &core->bucket_list[chunk->bucket_id]);
+
+		if (chunk->bucket_id == 0 && --core->dirty_chunks == 0) {
+			ac = _acp_core_cleaner(acp, chunk->core_id);
+			list_del(&core->dirty_list);
+			ac->dirty_cores_no--;
+			core->credit = 0;
+		}
 	}
 }
 
@@ -606,7 +813,12 @@ void cleaning_policy_acp_set_hot_cache_line(struct ocf_cache *cache,
 	ACP_LOCK_CHUNKS_WR();
 
 	acp_meta = _acp_meta_get(cache, cache_line, &policy_meta);
-	chunk = _acp_get_chunk(cache, cache_line);
+	chunk = _acp_get_chunk(cache, cache_line, true);
+	if (!chunk) {
+		/* Cache line stays untracked, it's cleaned only by flush */
+		ACP_UNLOCK_CHUNKS_WR();
+		return;
+	}
 
 	if (!acp_meta->dirty) {
 		acp_meta->dirty = 1;
@@ -628,13 +840,16 @@ void cleaning_policy_acp_purge_block(struct ocf_cache *cache,
 	struct acp_chunk_info *chunk;
 
 	acp_meta = _acp_meta_get(cache, cache_line, &policy_meta);
-	chunk = _acp_get_chunk(cache, cache_line);
 
-	if (acp_meta->dirty) {
-		acp_meta->dirty = 0;
-		_acp_meta_set(cache, cache_line, &policy_meta);
-		chunk->num_dirty--;
-	}
+	/* Chunk of clean cache line may be not allocated */
+	if (!acp_meta->dirty)
+		return;
+
+	chunk = _acp_get_chunk(cache, cache_line, false);
+
+	acp_meta->dirty = 0;
+	_acp_meta_set(cache, cache_line, &policy_meta);
+	chunk->num_dirty--;
 
 	_acp_update_bucket(acp, chunk);
 }
@@ -651,26 +866,53 @@ void cleaning_policy_acp_remove_core(ocf_cache_t cache,
 		ocf_core_id_t core_id)
 {
 	struct acp_context *acp  = _acp_get_ctx_from_cache(cache);
+	struct acp_state *state;
 	uint64_t i;
 
 	ENV_BUG_ON(acp->chunks_total < acp->num_chunks[core_id]);
 
-	if (acp->state.in_progress && acp->state.chunk->core_id == core_id) {
-		acp->state.in_progress = false;
-		acp->state.iter = 0;
-		acp->state.chunk = NULL;
+	for (i = 0; i < cache->cleaner.count; i++) {
+		state = &acp->cleaner[i].state;
+
+		if (state->in_progress && state->chunk->core_id == core_id) {
+			state->in_progress = false;
+			state->iter = 0;
+			state->chunk = NULL;
+		}
 	}
 
 	ACP_LOCK_CHUNKS_WR();
 
-	for (i = 0; i < acp->num_chunks[core_id]; i++)
-		list_del(&acp->chunk_info[core_id][i].list);
+	/* Core may be already removed */
+	if (!acp->core_info[core_id]) {
+		ACP_UNLOCK_CHUNKS_WR();
+		return;
+	}
+
+	if (acp->core_info[core_id]->dirty_chunks) {
+		list_del(&acp->core_info[core_id]->dirty_list);
+		_acp_core_cleaner(acp, core_id)->dirty_cores_no--;
+	}
 
 	acp->chunks_total -= acp->num_chunks[core_id];
-	acp->num_chunks[core_id] = 0;
 
+#if OCF_CONFIG_ACP_LAZY_CHUNKS
+	for (i = 0; i < OCF_DIV_ROUND_UP(acp->num_chunks[core_id],
+			OCF_CONFIG_ACP_LAZY_CHUNKS); i++) {
+		env_free(acp->chunk_leaf[core_id][i]);
+	}
+
+	env_vfree(acp->chunk_leaf[core_id]);
+	acp->chunk_leaf[core_id] = NULL;
+#else
 	env_vfree(acp->chunk_info[core_id]);
 	acp->chunk_info[core_id] = NULL;
+#endif
+
+	acp->num_chunks[core_id] = 0;
+
+	env_vfree(acp->core_info[core_id]);
+	acp->core_info[core_id] = NULL;
 
 	ACP_UNLOCK_CHUNKS_WR();
 }
@@ -688,30 +930,53 @@ int cleaning_policy_acp_add_core(ocf_cache_t cache,
 
 	ACP_LOCK_CHUNKS_WR();
 
+#if OCF_CONFIG_ACP_LAZY_CHUNKS
+	ENV_BUG_ON(acp->chunk_leaf[core_id]);
+
+	acp->chunk_leaf[core_id] = env_vzalloc(OCF_DIV_ROUND_UP(num_chunks,
+			OCF_CONFIG_ACP_LAZY_CHUNKS) * sizeof(acp->chunk_leaf[0][0]));
+	acp->core_info[core_id] = env_vzalloc(sizeof(*acp->core_info[0]));
+
+	if (!acp->chunk_leaf[core_id] || !acp->core_info[core_id]) {
+		env_vfree(acp->chunk_leaf[core_id]);
+		acp->chunk_leaf[core_id] = NULL;
+#else
 	ENV_BUG_ON(acp->chunk_info[core_id]);
 
 	acp->chunk_info[core_id] =
 			env_vzalloc(num_chunks * sizeof(acp->chunk_info[0][0]));
+	acp->core_info[core_id] = env_vzalloc(sizeof(*acp->core_info[0]));
 
-	if (!acp->chunk_info[core_id]) {
+	if (!acp->chunk_info[core_id] || !acp->core_info[core_id]) {
+		env_vfree(acp->chunk_info[core_id]);
+		acp->chunk_info[core_id] = NULL;
+#endif
+		env_vfree(acp->core_info[core_id]);
+		acp->core_info[core_id] = NULL;
 		ACP_UNLOCK_CHUNKS_WR();
 		OCF_DEBUG_PARAM(cache, "failed to allocate acp tables\n");
 		return -ENOMEM;
 	}
 
+	acp->core_info[core_id]->core_id = core_id;
+	for (i = 0; i < ACP_MAX_BUCKETS; i++)
+		INIT_LIST_HEAD(&acp->core_info[core_id]->bucket_list[i]);
+
 	OCF_DEBUG_PARAM(cache, "successfully allocated acp tables\n");
 
 	/* increment counters */
 	acp->num_chunks[core_id] = num_chunks;
 	acp->chunks_total += num_chunks;
 
+#if !OCF_CONFIG_ACP_LAZY_CHUNKS
 	for (i = 0; i < acp->num_chunks[core_id]; i++) {
 		/* fill in chunk metadata and add to the clean bucket */
 		acp->chunk_info[core_id][i].core_id = core_id;
 		acp->chunk_info[core_id][i].chunk_id = i;
 		list_add(&acp->chunk_info[core_id][i].list,
-				&acp->bucket_info[0].chunk_list);
+				&acp->core_info[core_id]->bucket_list[0]);
 	}
+#endif
 
 	ACP_UNLOCK_CHUNKS_WR();
 
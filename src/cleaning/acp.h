@@ -14,8 +14,10 @@ int cleaning_policy_acp_initialize(ocf_cache_t cache, int init_metadata);
 
 void cleaning_policy_acp_deinitialize(ocf_cache_t cache);
 
+size_t cleaning_policy_acp_size_of(ocf_cache_t cache);
+
 void cleaning_policy_acp_perform_cleaning(ocf_cache_t cache,
-		ocf_cleaner_end_t cmpl);
+		ocf_cleaner_t cleaner, ocf_cleaner_end_t cmpl);
 
 void cleaning_policy_acp_init_cache_block(ocf_cache_t cache,
 		uint32_t cache_line);
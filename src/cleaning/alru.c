@@ -53,10 +53,23 @@ struct alru_flush_ctx {
 	struct ocf_cleaner_attribs attribs;
 	bool flush_perfomed;
 	uint32_t clines_no;
+	uint32_t pressure;
+	uint32_t cleaning_access;
+		/*!< Time at which instance found nothing to clean */
 	ocf_cache_t cache;
+	ocf_cleaner_t cleaner;
 	ocf_cleaner_end_t cmpl;
 	struct flush_data *flush_data;
 	size_t flush_data_limit;
+	struct ocf_user_part *parts[OCF_IO_CLASS_MAX];
+		/*!< Partitions sorted by priority */
+	uint32_t parts_gen;
+		/*!< Partitions sort generation parts are sorted for */
+	bool parts_sorted;
+	uint32_t window_no;
+		/*!< Number of lines collected for LBA ordering */
+	uint64_t elevator[OCF_CORE_MAX];
+		/*!< Core line at which next LBA ordered cycle starts */
 };
 
 /* -- Start of ALRU functions -- */
@@ -105,8 +118,11 @@ static void add_alru_head(struct ocf_cache *cache, int partition_id,
 	ENV_BUG_ON(env_atomic_read(
 			&part->runtime->cleaning.policy.alru.size) < 0);
 
+#if 1 == OCF_CLEANING_DEBUG
+	/* Status bits are tested under their lock */
 	ENV_WARN_ON(!metadata_test_dirty(cache, collision_index));
 	ENV_WARN_ON(!metadata_test_valid_any(cache, collision_index));
+#endif
 
 	/* First node to be added/ */
 	if (env_atomic_read(&part->runtime->cleaning.policy.alru.size) == 0) {
@@ -310,6 +326,7 @@ void cleaning_policy_alru_init_cache_block(struct ocf_cache *cache,
 	ocf_metadata_get_cleaning_policy(cache, cache_line, &policy);
 
 	policy.meta.alru.timestamp = 0;
+	policy.meta.alru.rewrites = 0;
 	policy.meta.alru.lru_prev = cache->device->collision_table_entries;
 	policy.meta.alru.lru_next = cache->device->collision_table_entries;
 
@@ -354,6 +371,60 @@ int cleaning_policy_alru_purge_range(struct ocf_cache *cache, int core_id,
 	return ret;
 }
 
+/*
+ * Line getting dirty again not later than it would be cleaned with current
+ * deferral since previous dirtying was most likely cleaned in vain.
+ */
+static void update_alru_rewrites(struct ocf_cache *cache,
+		ocf_cache_line_t cache_line, struct cleaning_policy_meta *policy)
+{
+	struct alru_cleaning_policy_config *config;
+	uint32_t now = env_ticks_to_secs(env_get_tick_count());
+	uint32_t rewrites = policy->meta.alru.rewrites;
+	uint32_t window;
+
+	config = (void *)&cache->conf_meta->cleaning[ocf_cleaning_alru].data;
+
+	window = config->stale_buffer_time * (2 + rewrites);
+
+	if (policy->meta.alru.timestamp &&
+			now - policy->meta.alru.timestamp <= window) {
+		if (rewrites < OCF_ALRU_MAX_HOT_DEFERRAL)
+			rewrites++;
+	} else {
+		rewrites = 0;
+	}
+
+	if (rewrites == policy->meta.alru.rewrites)
+		return;
+
+	policy->meta.alru.rewrites = rewrites;
+	ocf_metadata_set_cleaning_policy(cache, cache_line, policy);
+}
+
+/* ALRU timestamp field width */
+#define ALRU_TIMESTAMP_MASK ((1U << 28) - 1)
+
+/*
+ * Check if cache line put to ALRU head now would get timestamp of the same
+ * bucket it already has. Line is then left in place, so it may be cleaned
+ * up to one bucket earlier than if it was relinked.
+ */
+static inline bool alru_same_bucket(struct cleaning_policy_meta *policy)
+{
+#if OCF_CONFIG_ALRU_TIMESTAMP_BUCKET > 0
+	uint32_t now;
+
+	now = env_ticks_to_secs(env_get_tick_count()) & ALRU_TIMESTAMP_MASK;
+
+	return now / OCF_CONFIG_ALRU_TIMESTAMP_BUCKET ==
+			policy->meta.alru.timestamp /
+			OCF_CONFIG_ALRU_TIMESTAMP_BUCKET;
+#else
+	return false;
+#endif
+}
+
 void cleaning_policy_alru_set_hot_cache_line(struct ocf_cache *cache,
 		uint32_t cache_line)
 {
@@ -365,8 +436,10 @@ void cleaning_policy_alru_set_hot_cache_line(struct ocf_cache *cache,
 	uint32_t collision_table_entries = cache->device->collision_table_entries;
 	struct cleaning_policy_meta policy;
 
+#if 1 == OCF_CLEANING_DEBUG
 	ENV_WARN_ON(!metadata_test_dirty(cache, cache_line));
 	ENV_WARN_ON(!metadata_test_valid_any(cache, cache_line));
+#endif
 
 	ocf_metadata_get_cleaning_policy(cache, cache_line, &policy);
 	next_lru_node = policy.meta.alru.lru_next;
@@ -377,8 +450,15 @@ void cleaning_policy_alru_set_hot_cache_line(struct ocf_cache *cache,
 			((part->runtime->cleaning.policy.
 				alru.lru_head == cache_line) &&
 			(part->runtime->cleaning.policy.
-				alru.lru_tail == cache_line)))
+				alru.lru_tail == cache_line))) {
+		/* Already dirty, keep position within timestamp bucket */
+		if (alru_same_bucket(&policy))
+			return;
+
 		remove_alru_list(cache, part_id, cache_line);
+	} else {
+		update_alru_rewrites(cache, cache_line, &policy);
+	}
 
 	add_alru_head(cache, part_id, cache_line);
 }
@@ -398,7 +478,6 @@ static void _alru_rebuild(struct ocf_cache *cache)
 				cache->device->collision_table_entries;
 		part->runtime->cleaning.policy.alru.lru_tail =
 				cache->device->collision_table_entries;
-		cache->device->runtime_meta->cleaning_thread_access = 0;
 	}
 
 	for (cline = 0; cline < cache->device->collision_table_entries; cline++) {
@@ -431,8 +510,6 @@ static int cleaning_policy_alru_initialize_part(struct ocf_cache *cache,
 				cache->device->collision_table_entries;
 	}
 
-	cache->device->runtime_meta->cleaning_thread_access = 0;
-
 	return 0;
 }
 
@@ -446,6 +523,8 @@ void cleaning_policy_alru_setup(struct ocf_cache *cache)
 	config->stale_buffer_time = OCF_ALRU_DEFAULT_STALENESS_TIME;
 	config->flush_max_buffers = OCF_ALRU_DEFAULT_FLUSH_MAX_BUFFERS;
 	config->activity_threshold = OCF_ALRU_DEFAULT_ACTIVITY_THRESHOLD;
+	config->lba_window = OCF_ALRU_DEFAULT_LBA_WINDOW;
+	config->hot_deferral = OCF_ALRU_DEFAULT_HOT_DEFERRAL;
 }
 
 int cleaning_policy_alru_initialize(ocf_cache_t cache, int init_metadata)
@@ -454,7 +533,8 @@ int cleaning_policy_alru_initialize(ocf_cache_t cache, int init_metadata)
 	ocf_part_id_t part_id;
 	struct alru_flush_ctx *fctx;
 
-	fctx = env_vzalloc(sizeof(*fctx));
+	/* Flush context of each cleaner instance */
+	fctx = env_vzalloc(sizeof(*fctx) * cache->cleaner.count);
 	if (!fctx) {
 		ocf_cache_log(cache, log_err, "alru ctx allocation error\n");
 		return -OCF_ERR_NO_MEM;
@@ -479,6 +559,14 @@ void cleaning_policy_alru_deinitialize(struct ocf_cache *cache)
 	cache->cleaner.cleaning_policy_context = NULL;
 }
 
+size_t cleaning_policy_alru_size_of(struct ocf_cache *cache)
+{
+	if (!cache->cleaner.cleaning_policy_context)
+		return 0;
+
+	return sizeof(struct alru_flush_ctx) * cache->cleaner.count;
+}
+
 int cleaning_policy_alru_set_cleaning_param(ocf_cache_t cache,
 		uint32_t param_id, uint32_t param_value)
 {
@@ -525,6 +613,26 @@ int cleaning_policy_alru_set_cleaning_param(ocf_cache_t cache,
 				"activity time threshold: %d\n",
 				config->activity_threshold);
 		break;
+	case ocf_alru_lba_window:
+		OCF_CLEANING_CHECK_PARAM(cache, param_value,
+				OCF_ALRU_MIN_LBA_WINDOW,
+				OCF_ALRU_MAX_LBA_WINDOW,
+				"lba_window");
+		config->lba_window = param_value;
+		ocf_cache_log(cache, log_info, "Write-back flush thread "
+				"LBA ordering window: %d\n",
+				config->lba_window);
+		break;
+	case ocf_alru_hot_deferral:
+		OCF_CLEANING_CHECK_PARAM(cache, param_value,
+				OCF_ALRU_MIN_HOT_DEFERRAL,
+				OCF_ALRU_MAX_HOT_DEFERRAL,
+				"hot_deferral");
+		config->hot_deferral = param_value;
+		ocf_cache_log(cache, log_info, "Write-back flush thread "
+				"hot line deferral: %d\n",
+				config->hot_deferral);
+		break;
 	default:
 		return -OCF_ERR_INVAL;
 	}
@@ -552,6 +660,12 @@ int cleaning_policy_alru_get_cleaning_param(ocf_cache_t cache,
 	case ocf_alru_activity_threshold:
 		*param_value = config->activity_threshold;
 		break;
+	case ocf_alru_lba_window:
+		*param_value = config->lba_window;
+		break;
+	case ocf_alru_hot_deferral:
+		*param_value = config->hot_deferral;
+		break;
 	default:
 		return -OCF_ERR_INVAL;
 	}
@@ -574,12 +688,7 @@ static inline uint32_t compute_timestamp(
 static int check_for_io_activity(struct ocf_cache *cache,
 		struct alru_cleaning_policy_config *config)
 {
-	unsigned int now, last;
-
-	now = env_ticks_to_msecs(env_get_tick_count());
-	last = env_atomic_read(&cache->last_access_ms);
-
-	if ((now - last) < config->activity_threshold)
+	if (ocf_queue_get_idle_ms(cache) < config->activity_threshold)
 		return 1;
 	return 0;
 }
@@ -603,48 +712,69 @@ static void swp_ocf_user_part(void *part1, void *part2, int size) {
 	*(void **)part2 = tmp;
 }
 
-static void get_parts_sorted(struct ocf_user_part **parts,
-		struct ocf_cache *cache) {
+/* Partitions are resorted only after IO class configuration changed */
+static struct ocf_user_part **get_parts_sorted(struct alru_flush_ctx *fctx)
+{
+	ocf_cache_t cache = fctx->cache;
+	uint32_t gen = env_atomic_read(&cache->part_sort_gen);
 	int i;
 
+	if (fctx->parts_sorted && fctx->parts_gen == gen)
+		return fctx->parts;
+
 	for (i = 0; i < OCF_IO_CLASS_MAX; i++)
-		parts[i] = &cache->user_parts[i];
+		fctx->parts[i] = &cache->user_parts[i];
 
-	env_sort(parts, OCF_IO_CLASS_MAX, sizeof(struct ocf_user_part*),
+	env_sort(fctx->parts, OCF_IO_CLASS_MAX, sizeof(struct ocf_user_part*),
 			cmp_ocf_user_parts, swp_ocf_user_part);
+
+	fctx->parts_gen = gen;
+	fctx->parts_sorted = true;
+
+	return fctx->parts;
 }
 
-static bool clean_later(ocf_cache_t cache, uint32_t *delta)
+static bool clean_later(struct alru_flush_ctx *fctx, uint32_t *delta)
 {
 	struct alru_cleaning_policy_config *config;
+	ocf_cache_t cache = fctx->cache;
 
 	config = (void *)&cache->conf_meta->cleaning[ocf_cleaning_alru].data;
 
 	*delta = env_ticks_to_secs(env_get_tick_count()) -
-			cache->device->runtime_meta->cleaning_thread_access;
+			fctx->cleaning_access;
 	if (*delta <= config->thread_wakeup_time)
 		return true;
 
 	return false;
 }
 
-static bool is_cleanup_possible(ocf_cache_t cache)
+static bool is_cleanup_possible(struct alru_flush_ctx *fctx)
 {
 	struct alru_cleaning_policy_config *config;
+	ocf_cache_t cache = fctx->cache;
 	uint32_t delta;
 
 	config = (void *)&cache->conf_meta->cleaning[ocf_cleaning_alru].data;
 
-	if (check_for_io_activity(cache, config)) {
+	/* Partition nearing its high dirty watermark can't wait for idle */
+	if (fctx->pressure)
+		return config->flush_max_buffers != 0;
+
+	/* With cleaner throttling user IO latency decides when to back off */
+	if (!cache->cleaner.throttle.target_us &&
+			check_for_io_activity(cache, config)) {
 		OCF_DEBUG_PARAM(cache, "IO activity detected");
+		ocf_cleaner_account_postponed(fctx->cleaner);
 		return false;
 	}
 
-	if (clean_later(cache, &delta)) {
+	if (clean_later(fctx, &delta)) {
 		OCF_DEBUG_PARAM(cache,
 			"Cleaning policy configured to clean later "
 			"delta=%u wake_up=%u", delta,
 			config->thread_wakeup_time);
+		ocf_cleaner_account_postponed(fctx->cleaner);
 		return false;
 	}
 
@@ -685,8 +815,35 @@ static bool more_blocks_to_flush(struct ocf_cache *cache,
 	return true;
 }
 
-static bool block_is_busy(struct ocf_cache *cache,
-		ocf_cache_line_t cache_line)
+/* Cleaning of frequently rewritten line waits for longer staleness time */
+static bool block_is_deferred(struct ocf_cache *cache,
+		const struct alru_cleaning_policy_config *config,
+		ocf_cache_line_t cache_line, uint32_t now)
+{
+	struct cleaning_policy_meta policy;
+	uint32_t deferral;
+
+	ocf_metadata_get_cleaning_policy(cache, cache_line, &policy);
+
+	deferral = OCF_MIN((uint32_t)policy.meta.alru.rewrites,
+			config->hot_deferral);
+	if (!deferral)
+		return false;
+
+	return now - policy.meta.alru.timestamp <
+			config->stale_buffer_time * (1 + deferral);
+}
+
+enum alru_block_state {
+	alru_block_ready,
+	alru_block_foreign,
+		/*!< Cleaned by other cleaner instance */
+	alru_block_busy,
+		/*!< Locked or of inactive core */
+};
+
+static enum alru_block_state block_get_state(struct ocf_cache *cache,
+		ocf_cleaner_t cleaner, ocf_cache_line_t cache_line)
 {
 	ocf_core_id_t core_id;
 	uint64_t core_line;
@@ -694,52 +851,118 @@ static bool block_is_busy(struct ocf_cache *cache,
 	ocf_metadata_get_core_info(cache, cache_line,
 			&core_id, &core_line);
 
+	/* Leave cache line to cleaner instance owning its core */
+	if (!ocf_cleaner_owns_core(cleaner, core_id))
+		return alru_block_foreign;
+
 	if (!cache->core[core_id].opened)
-		return true;
+		return alru_block_busy;
 
-	if (ocf_cache_line_is_used(cache, cache_line))
-		return true;
+	if (ocf_cache_line_is_used(cache, cache_line)) {
+		ocf_cleaner_account_busy(cleaner, cache_line);
+		return alru_block_busy;
+	}
 
-	return false;
+	return alru_block_ready;
+}
+
+/*
+ * Move busy cache line to head of ALRU list keeping its timestamp, so that
+ * following scans reach lines which can be cleaned without walking it again.
+ * It's reached once all lines dirtied after it got stale as well.
+ */
+static void move_alru_head(struct ocf_cache *cache, int partition_id,
+		ocf_cache_line_t cache_line)
+{
+	struct cleaning_policy_meta policy;
+	uint32_t timestamp;
+
+	ocf_metadata_get_cleaning_policy(cache, cache_line, &policy);
+	timestamp = policy.meta.alru.timestamp;
+
+	remove_alru_list(cache, partition_id, cache_line);
+	add_alru_head(cache, partition_id, cache_line);
+
+	ocf_metadata_get_cleaning_policy(cache, cache_line, &policy);
+	policy.meta.alru.timestamp = timestamp;
+	ocf_metadata_set_cleaning_policy(cache, cache_line, &policy);
 }
 
 static int get_data_to_flush(struct alru_flush_ctx *fctx)
 {
 	ocf_cache_t cache = fctx->cache;
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
 	struct alru_cleaning_policy_config *config;
 	struct cleaning_policy_meta policy;
-	ocf_cache_line_t cache_line;
-	struct ocf_user_part *parts[OCF_IO_CLASS_MAX];
-	uint32_t last_access;
+	ocf_cache_line_t cache_line, moved;
+	struct ocf_user_part **parts;
+	uint32_t last_access, now;
+	bool pressure;
 	int to_flush = 0;
 	int part_id = OCF_IO_CLASS_ID_MAX;
+	ocf_part_id_t id;
 
 	config = (void *)&cache->conf_meta->cleaning[ocf_cleaning_alru].data;
 
-	get_parts_sorted(parts, cache);
+	parts = get_parts_sorted(fctx);
 
 	while (part_id >= OCF_IO_CLASS_ID_MIN) {
+		id = parts[part_id] - cache->user_parts;
 		cache_line =
 			parts[part_id]->runtime->cleaning.policy.alru.lru_tail;
+		moved = collision_table_entries;
 
-		last_access = compute_timestamp(config);
+		/* Under dirty pressure don't wait for lines to become stale */
+		pressure = fctx->pressure && ocf_cleaning_part_dirty_pressure(
+				cache, id);
+		if (pressure)
+			last_access = ~0U;
+		else
+			last_access = compute_timestamp(config);
+		now = env_ticks_to_secs(env_get_tick_count());
 
 		OCF_DEBUG_PARAM(cache, "Last access=%u, timestamp=%u rel=%d",
 				last_access, policy.meta.alru.timestamp,
 				policy.meta.alru.timestamp < last_access);
 
-		while (more_blocks_to_flush(cache, cache_line, last_access)) {
-			if (to_flush >= fctx->clines_no)
-				goto end;
+		/* Stop at first moved line, the rest was already scanned */
+		while (cache_line != moved && more_blocks_to_flush(cache,
+				cache_line, last_access)) {
+			ocf_cache_line_t curr = cache_line;
+			enum alru_block_state state;
 
-			if (!block_is_busy(cache, cache_line)) {
-				get_block_to_flush(&fctx->flush_data[to_flush], cache_line,
-						cache);
-				to_flush++;
-			}
+			if (to_flush >= fctx->window_no)
+				goto end;
 
 			ocf_metadata_get_cleaning_policy(cache, cache_line, &policy);
 			cache_line = policy.meta.alru.lru_prev;
+
+			state = block_get_state(cache, fctx->cleaner, curr);
+			if (state == alru_block_ready && !pressure &&
+					block_is_deferred(cache, config,
+						curr, now)) {
+				state = alru_block_busy;
+			}
+
+			switch (state) {
+			case alru_block_ready:
+				get_block_to_flush(&fctx->flush_data[to_flush],
+						curr, cache);
+				to_flush++;
+				break;
+			case alru_block_busy:
+				/* Line which is already head stays in place */
+				if (cache_line == collision_table_entries)
+					break;
+
+				move_alru_head(cache, id, curr);
+				if (moved == collision_table_entries)
+					moved = curr;
+				break;
+			case alru_block_foreign:
+				break;
+			}
 		}
 		part_id--;
 	}
@@ -750,6 +973,75 @@ end:
 	return to_flush;
 }
 
+static int cmp_flush_data_elevator(const void *d1, const void *d2)
+{
+	const struct flush_data *t1 = d1, *t2 = d2;
+
+	if (t1->core_id != t2->core_id)
+		return t1->core_id < t2->core_id ? -1 : 1;
+
+	if (t1->core_line != t2->core_line)
+		return t1->core_line < t2->core_line ? -1 : 1;
+
+	return 0;
+}
+
+static void swp_flush_data(void *d1, void *d2, int size)
+{
+	struct flush_data tmp = *(struct flush_data *)d1;
+
+	*(struct flush_data *)d1 = *(struct flush_data *)d2;
+	*(struct flush_data *)d2 = tmp;
+}
+
+/*
+ * Select lines to be cleaned from window of stale lines in order of core
+ * LBA. Each core is walked up from its elevator position, wrapping around
+ * to the beginning, and gets an equal share of the batch.
+ */
+static int get_data_lba_ordered(struct alru_flush_ctx *fctx, int collected)
+{
+	struct flush_data *data = fctx->flush_data;
+	uint32_t quota, cores = 0, taken;
+	int i, j, to_flush = 0;
+
+	if (collected <= fctx->clines_no)
+		return collected;
+
+	/* Distance from elevator position orders lines past it first */
+	for (i = 0; i < collected; i++)
+		data[i].core_line -= fctx->elevator[data[i].core_id];
+
+	env_sort(data, collected, sizeof(*data), cmp_flush_data_elevator,
+			swp_flush_data);
+
+	for (i = 0; i < collected; i++) {
+		data[i].core_line += fctx->elevator[data[i].core_id];
+		if (!i || data[i].core_id != data[i - 1].core_id)
+			cores++;
+	}
+
+	quota = OCF_DIV_ROUND_UP(fctx->clines_no, cores);
+
+	for (i = 0; i < collected && to_flush < fctx->clines_no; i = j) {
+		taken = 0;
+
+		for (j = i; j < collected && data[j].core_id == data[i].core_id;
+				j++) {
+			if (taken == quota || to_flush == fctx->clines_no)
+				continue;
+
+			data[to_flush++] = data[j];
+			taken++;
+		}
+
+		fctx->elevator[data[to_flush - 1].core_id] =
+				data[to_flush - 1].core_line + 1;
+	}
+
+	return to_flush;
+}
+
 static void alru_clean_complete(void *priv, int err)
 {
 	struct alru_cleaning_policy_config *config;
@@ -763,7 +1055,7 @@ static void alru_clean_complete(void *priv, int err)
 
 	interval = fctx->flush_perfomed ? 0 : config->thread_wakeup_time * 1000;
 
-	fctx->cmpl(&fctx->cache->cleaner, interval);
+	fctx->cmpl(fctx->cleaner, interval);
 }
 
 static void alru_clean(struct alru_flush_ctx *fctx)
@@ -771,25 +1063,26 @@ static void alru_clean(struct alru_flush_ctx *fctx)
 	ocf_cache_t cache = fctx->cache;
 	int to_clean;
 
-	if (!is_cleanup_possible(cache)) {
+	if (!is_cleanup_possible(fctx)) {
 		alru_clean_complete(fctx, 0);
 		return;
 	}
 
 	if (OCF_METADATA_LOCK_WR_TRY()) {
+		ocf_cleaner_account_postponed(fctx->cleaner);
 		alru_clean_complete(fctx, 0);
 		return;
 	}
 
 	OCF_REALLOC(&fctx->flush_data, sizeof(fctx->flush_data[0]),
-			fctx->clines_no, &fctx->flush_data_limit);
+			fctx->window_no, &fctx->flush_data_limit);
 	if (!fctx->flush_data) {
 		ocf_cache_log(cache, log_warn, "No memory to allocate flush "
 				"data for ALRU cleaning policy");
 		goto end;
 	}
 
-	to_clean = get_data_to_flush(fctx);
+	to_clean = get_data_lba_ordered(fctx, get_data_to_flush(fctx));
 	if (to_clean > 0) {
 		fctx->flush_perfomed = true;
 		ocf_cleaner_do_flush_data_async(cache, fctx->flush_data, to_clean,
@@ -799,19 +1092,21 @@ static void alru_clean(struct alru_flush_ctx *fctx)
 	}
 
 	/* Update timestamp only if there are no items to be cleaned */
-	cache->device->runtime_meta->cleaning_thread_access =
-		env_ticks_to_secs(env_get_tick_count());
+	fctx->cleaning_access = env_ticks_to_secs(env_get_tick_count());
 
 end:
 	OCF_METADATA_UNLOCK_WR();
 	alru_clean_complete(fctx, 0);
 }
 
-void cleaning_alru_perform_cleaning(ocf_cache_t cache, ocf_cleaner_end_t cmpl)
+void cleaning_alru_perform_cleaning(ocf_cache_t cache, ocf_cleaner_t cleaner,
+		ocf_cleaner_end_t cmpl)
 {
 	struct alru_flush_ctx *fctx = cache->cleaner.cleaning_policy_context;
 	struct alru_cleaning_policy_config *config;
 
+	fctx += cleaner->id;
+
 	config = (void *)&cache->conf_meta->cleaning[ocf_cleaning_alru].data;
 
 	OCF_REALLOC_INIT(&fctx->flush_data, &fctx->flush_data_limit);
@@ -820,10 +1115,17 @@ void cleaning_alru_perform_cleaning(ocf_cache_t cache, ocf_cleaner_end_t cmpl)
 	fctx->attribs.cmpl_fn = alru_clean_complete;
 	fctx->attribs.cache_line_lock = true;
 	fctx->attribs.do_sort = true;
-	fctx->attribs.io_queue = cache->cleaner.io_queue;
+	fctx->attribs.io_queue = cleaner->io_queue;
+
+	ocf_cleaner_pool_set_batch(cache, config->flush_max_buffers);
 
-	fctx->clines_no = config->flush_max_buffers;
+	fctx->pressure = ocf_cleaning_dirty_pressure(cache);
+	fctx->clines_no = ocf_cleaner_drain_batch(cache,
+			ocf_cleaning_pressure_batch(ocf_cleaner_throttle_batch(
+			cache, config->flush_max_buffers), fctx->pressure));
+	fctx->window_no = fctx->clines_no * OCF_MAX(config->lba_window, 1U);
 	fctx->cache = cache;
+	fctx->cleaner = cleaner;
 	fctx->cmpl = cmpl;
 	fctx->flush_perfomed = false;
 
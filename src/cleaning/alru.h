@@ -12,6 +12,7 @@
 void cleaning_policy_alru_setup(ocf_cache_t cache);
 int cleaning_policy_alru_initialize(ocf_cache_t cache, int init_metadata);
 void cleaning_policy_alru_deinitialize(ocf_cache_t cache);
+size_t cleaning_policy_alru_size_of(ocf_cache_t cache);
 void cleaning_policy_alru_init_cache_block(ocf_cache_t cache,
 		uint32_t cache_line);
 void cleaning_policy_alru_purge_cache_block(ocf_cache_t cache,
@@ -24,7 +25,8 @@ int cleaning_policy_alru_set_cleaning_param(ocf_cache_t cache,
 		uint32_t param_id, uint32_t param_value);
 int cleaning_policy_alru_get_cleaning_param(ocf_cache_t cache,
 		uint32_t param_id, uint32_t *param_value);
-void cleaning_alru_perform_cleaning(ocf_cache_t cache, ocf_cleaner_end_t cmpl);
+void cleaning_alru_perform_cleaning(ocf_cache_t cache, ocf_cleaner_t cleaner,
+		ocf_cleaner_end_t cmpl);
 
 #endif
 
@@ -9,8 +9,11 @@
 #include "ocf_env.h"
 
 struct alru_cleaning_policy_meta {
+	/* Seconds since line got dirty, 28 bits wrap after 8 years */
+	uint32_t timestamp : 28;
+	/* Times line got dirty again shortly after it was cleaned */
+	uint32_t rewrites : 4;
 	/* Lru pointers 2*4=8 bytes */
-	uint32_t timestamp;
 	uint32_t lru_prev;
 	uint32_t lru_next;
 } __attribute__((packed));
@@ -20,6 +23,8 @@ struct alru_cleaning_policy_config {
 	uint32_t stale_buffer_time;	/* in seconds */
 	uint32_t flush_max_buffers;	/* in lines */
 	uint32_t activity_threshold;	/* in milliseconds */
+	uint32_t lba_window;		/* in cleaning batches */
+	uint32_t hot_deferral;		/* in staleness times */
 };
 
 struct alru_cleaning_policy {
@@ -13,6 +13,13 @@
 #include "../mngt/ocf_mngt_common.h"
 #include "../metadata/metadata.h"
 #include "../ocf_queue_priv.h"
+#include "../utils/utils_checkpoint.h"
+#include "../utils/utils_cleaner.h"
+#include "../utils/utils_core.h"
+#include "../utils/utils_log.h"
+#include "../utils/utils_mode_advisor.h"
+#include "../utils/utils_part.h"
+#include "../utils/utils_trim.h"
 
 struct cleaning_policy_ops cleaning_policy_ops[ocf_cleaning_max] = {
 	[ocf_cleaning_nop] = {
@@ -27,6 +34,7 @@ struct cleaning_policy_ops cleaning_policy_ops[ocf_cleaning_max] = {
 		.set_hot_cache_line = cleaning_policy_alru_set_hot_cache_line,
 		.initialize = cleaning_policy_alru_initialize,
 		.deinitialize = cleaning_policy_alru_deinitialize,
+		.size_of = cleaning_policy_alru_size_of,
 		.set_cleaning_param = cleaning_policy_alru_set_cleaning_param,
 		.get_cleaning_param = cleaning_policy_alru_get_cleaning_param,
 		.perform_cleaning = cleaning_alru_perform_cleaning,
@@ -40,6 +48,7 @@ struct cleaning_policy_ops cleaning_policy_ops[ocf_cleaning_max] = {
 		.set_hot_cache_line = cleaning_policy_acp_set_hot_cache_line,
 		.initialize = cleaning_policy_acp_initialize,
 		.deinitialize = cleaning_policy_acp_deinitialize,
+		.size_of = cleaning_policy_acp_size_of,
 		.set_cleaning_param = cleaning_policy_acp_set_cleaning_param,
 		.get_cleaning_param = cleaning_policy_acp_get_cleaning_param,
 		.add_core = cleaning_policy_acp_add_core,
@@ -49,14 +58,108 @@ struct cleaning_policy_ops cleaning_policy_ops[ocf_cleaning_max] = {
 	},
 };
 
+void ocf_cleaner_setup(ocf_cache_t cache, uint32_t count)
+{
+	uint32_t i;
+
+	cache->cleaner.count = count ?: 1;
+	env_spinlock_init(&cache->cleaner.pool.lock);
+	env_spinlock_init(&cache->cleaner.drain.lock);
+
+	for (i = 0; i < cache->cleaner.count; i++) {
+		cache->cleaner.instance[i].cache = cache;
+		cache->cleaner.instance[i].id = i;
+	}
+}
+
 int ocf_start_cleaner(ocf_cache_t cache)
 {
-	return ctx_cleaner_init(cache->owner, &cache->cleaner);
+	uint32_t i;
+	int result;
+
+	for (i = 0; i < cache->cleaner.count; i++) {
+		result = ctx_cleaner_init(cache->owner,
+				&cache->cleaner.instance[i]);
+		if (result)
+			goto err;
+	}
+
+	return 0;
+
+err:
+	while (i--)
+		ctx_cleaner_stop(cache->owner, &cache->cleaner.instance[i]);
+
+	return result;
+}
+
+bool ocf_cleaner_is_active(ocf_cache_t cache)
+{
+	return env_atomic_read(&cache->cleaner.active);
+}
+
+/* Time emergency cleaning lasts after last inline cleaning by eviction */
+#define OCF_CLEANER_EMERGENCY_MS		1000
+
+bool ocf_cleaner_in_emergency(ocf_cache_t cache)
+{
+	uint64_t ticks = env_atomic64_read(&cache->cleaner.emergency_ticks);
+
+	return ticks && env_ticks_to_msecs(env_get_tick_count() - ticks) <
+			OCF_CLEANER_EMERGENCY_MS;
+}
+
+void ocf_cleaner_emergency(ocf_cache_t cache)
+{
+	bool active = ocf_cleaner_in_emergency(cache);
+	uint32_t i;
+
+	env_atomic64_set(&cache->cleaner.emergency_ticks,
+			env_get_tick_count() ?: 1);
+
+	/* Kick instances only when entering emergency mode */
+	if (active)
+		return;
+
+	for (i = 0; i < cache->cleaner.count; i++)
+		ctx_cleaner_kick(cache->owner, &cache->cleaner.instance[i]);
+}
+
+/* Interval of polling for end of cleaner runs */
+#define OCF_CLEANER_WAIT_INTERVAL_MS		10
+
+int ocf_cleaner_wait_for_finish(ocf_cache_t cache, int32_t timeout_ms)
+{
+	bool limit = timeout_ms > 0;
+
+	while (ocf_cleaner_is_active(cache)) {
+		if (limit && timeout_ms <= 0)
+			return -OCF_ERR_CACHE_IN_USE;
+
+		env_msleep(OCF_CLEANER_WAIT_INTERVAL_MS);
+		timeout_ms -= OCF_CLEANER_WAIT_INTERVAL_MS;
+	}
+
+	return 0;
 }
 
 void ocf_stop_cleaner(ocf_cache_t cache)
 {
-	ctx_cleaner_stop(cache->owner, &cache->cleaner);
+	uint32_t i;
+
+	for (i = 0; i < cache->cleaner.count; i++)
+		ctx_cleaner_stop(cache->owner, &cache->cleaner.instance[i]);
+
+	/* Runs started before stop may still have cleaning I/O in flight */
+	ocf_cleaner_wait_for_finish(cache, 0);
+
+	ocf_cleaner_pool_drain(cache);
+	ocf_cleaner_drain_stop(cache);
+}
+
+bool ocf_cleaner_owns_core(ocf_cleaner_t cleaner, ocf_core_id_t core_id)
+{
+	return core_id % cleaner->cache->cleaner.count == cleaner->id;
 }
 
 void ocf_cleaner_set_cmpl(ocf_cleaner_t cleaner, ocf_cleaner_end_t fn)
@@ -79,17 +182,17 @@ void *ocf_cleaner_get_priv(ocf_cleaner_t c)
 ocf_cache_t ocf_cleaner_get_cache(ocf_cleaner_t c)
 {
 	OCF_CHECK_NULL(c);
-	return container_of(c, struct ocf_cache, cleaner);
+	return c->cache;
 }
 
 static int _ocf_cleaner_run_check_dirty_inactive(ocf_cache_t cache)
 {
-	int i;
+	ocf_core_id_t i;
 
 	if (!env_bit_test(ocf_cache_state_incomplete, &cache->cache_state))
 		return 0;
 
-	for (i = 0; i < OCF_CORE_MAX; ++i) {
+	for_each_dirty_core(cache, i) {
 		if (!env_bit_test(i, cache->conf_meta->valid_core_bitmap))
 			continue;
 
@@ -102,12 +205,384 @@ static int _ocf_cleaner_run_check_dirty_inactive(ocf_cache_t cache)
 	return 1;
 }
 
+/* Weight of new sample in user IO latency moving average */
+#define OCF_CLEANER_THROTTLE_WEIGHT		16
+
+/* Smallest part of policy batch cleaned under load, in permille */
+#define OCF_CLEANER_THROTTLE_SCALE_MIN		16
+#define OCF_CLEANER_THROTTLE_SCALE_MAX		1000
+#define OCF_CLEANER_THROTTLE_SCALE_STEP		64
+
+#define OCF_CLEANER_THROTTLE_BACKOFF_MIN_MS	10
+#define OCF_CLEANER_THROTTLE_BACKOFF_MAX_MS	1000
+
+void ocf_cleaner_throttle_io_done(ocf_cache_t cache, uint64_t submit_ticks)
+{
+	struct ocf_cleaner_throttle *throttle = &cache->cleaner.throttle;
+	int64_t sample, avg;
+
+	if (!throttle->target_us)
+		return;
+
+	sample = env_ticks_to_nsecs(env_get_tick_count() - submit_ticks);
+	avg = env_atomic64_read(&throttle->io_latency);
+	avg = avg ? avg + (sample - avg) / OCF_CLEANER_THROTTLE_WEIGHT : sample;
+
+	/* Lost update only drops single sample */
+	env_atomic64_set(&throttle->io_latency, avg);
+	env_atomic_inc(&throttle->io_count);
+}
+
+uint32_t ocf_cleaner_throttle_batch(ocf_cache_t cache, uint32_t batch)
+{
+	struct ocf_cleaner_throttle *throttle = &cache->cleaner.throttle;
+
+	if (!throttle->target_us || !batch)
+		return batch;
+
+	return OCF_MAX(1U, (uint32_t)((uint64_t)batch * throttle->scale /
+			OCF_CLEANER_THROTTLE_SCALE_MAX));
+}
+
+void ocf_cleaner_throttle_set_target(ocf_cache_t cache, uint32_t target_us)
+{
+	struct ocf_cleaner_throttle *throttle = &cache->cleaner.throttle;
+
+	throttle->scale = OCF_CLEANER_THROTTLE_SCALE_MAX;
+	throttle->backoff_ms = 0;
+	env_atomic64_set(&throttle->io_latency, 0);
+	env_atomic_set(&throttle->io_count, 0);
+	throttle->target_us = target_us;
+}
+
+/* Time cleaner sleeps when drain budget is used up */
+#define OCF_CLEANER_DRAIN_BACKOFF_MS		100
+
+static uint64_t ocf_cleaning_part_dirty(ocf_cache_t cache,
+		ocf_part_id_t part_id)
+{
+	ocf_core_id_t core_id;
+	uint64_t dirty = 0;
+
+	for_each_dirty_core(cache, core_id) {
+		dirty += env_atomic_read(&cache->core_runtime_meta[core_id].
+				part_counters[part_id].dirty_clines);
+	}
+
+	return dirty;
+}
+
+static bool ocf_cleaner_drain_part(ocf_cache_t cache, ocf_part_id_t part_id)
+{
+	ocf_cache_mode_t mode;
+
+	if (!env_atomic_read(&cache->cleaner.drain.active))
+		return false;
+
+	mode = ocf_part_get_cache_mode(cache, part_id);
+	if (!ocf_cache_mode_is_valid(mode))
+		mode = cache->conf_meta->cache_mode;
+
+	return mode != ocf_cache_mode_wb;
+}
+
+uint64_t ocf_cleaner_drain_dirty(ocf_cache_t cache)
+{
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+	uint64_t dirty = 0;
+
+	for_each_part(cache, part, part_id) {
+		if (ocf_part_is_valid(part) &&
+				ocf_cleaner_drain_part(cache, part_id)) {
+			dirty += ocf_cleaning_part_dirty(cache, part_id);
+		}
+	}
+
+	return dirty;
+}
+
+void ocf_cleaner_drain_start(ocf_cache_t cache, uint32_t rate)
+{
+	struct ocf_cleaner_drain *drain = &cache->cleaner.drain;
+
+	env_spinlock_lock(&drain->lock);
+	drain->rate = rate;
+	drain->budget = rate;
+	drain->refill_ticks = env_get_tick_count();
+	env_spinlock_unlock(&drain->lock);
+
+	env_atomic_set(&drain->active, 1);
+
+	drain->dirty_initial = ocf_cleaner_drain_dirty(cache);
+}
+
+void ocf_cleaner_drain_stop(ocf_cache_t cache)
+{
+	env_atomic_set(&cache->cleaner.drain.active, 0);
+}
+
+/* Budget grows with rate up to one second worth of cleaning */
+static void ocf_cleaner_drain_refill(struct ocf_cleaner_drain *drain)
+{
+	uint64_t now = env_get_tick_count();
+	uint64_t refill;
+
+	refill = env_ticks_to_nsecs(now - drain->refill_ticks) * drain->rate /
+			(1000ULL * 1000 * 1000);
+	if (!refill)
+		return;
+
+	drain->budget = OCF_MIN(drain->budget + refill, (uint64_t)drain->rate);
+	drain->refill_ticks = now;
+}
+
+uint32_t ocf_cleaner_drain_batch(ocf_cache_t cache, uint32_t batch)
+{
+	struct ocf_cleaner_drain *drain = &cache->cleaner.drain;
+
+	if (!env_atomic_read(&drain->active) || !drain->rate)
+		return batch;
+
+	env_spinlock_lock(&drain->lock);
+	ocf_cleaner_drain_refill(drain);
+	batch = OCF_MIN((uint64_t)batch, drain->budget);
+	drain->budget -= batch;
+	env_spinlock_unlock(&drain->lock);
+
+	return batch;
+}
+
+/*
+ * Once drain budget is used up cleaner waits for its refill rather than
+ * for wake up time of policy, as there is dirty data left to be drained
+ */
+static uint32_t ocf_cleaner_drain_backoff(ocf_cache_t cache)
+{
+	struct ocf_cleaner_drain *drain = &cache->cleaner.drain;
+
+	if (!env_atomic_read(&drain->active) || !drain->rate)
+		return 0;
+
+	return drain->budget ? 0 : OCF_CLEANER_DRAIN_BACKOFF_MS;
+}
+
+/* Finish drain once there is no dirty data left to be drained */
+static void ocf_cleaner_drain_update(ocf_cache_t cache)
+{
+	struct ocf_cleaner_drain *drain = &cache->cleaner.drain;
+
+	if (!env_atomic_read(&drain->active) || ocf_cleaner_drain_dirty(cache))
+		return;
+
+	if (env_atomic_cmpxchg(&drain->active, 1, 0) == 1)
+		ocf_cache_log(cache, log_info, "Dirty data drained\n");
+}
+
+uint32_t ocf_cleaning_part_dirty_pressure(ocf_cache_t cache,
+		ocf_part_id_t part_id)
+{
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+	uint64_t size, dirty, low, high;
+	bool drain = ocf_cleaner_drain_part(cache, part_id);
+
+	/* Eviction stalls on dirty data, clean it as if at high watermark */
+	if (ocf_cleaner_in_emergency(cache))
+		return ocf_cleaning_part_dirty(cache, part_id) ?
+				OCF_CLEANING_PRESSURE_MAX : 0;
+
+	if (!part->dirty_high && !drain)
+		return 0;
+
+	dirty = ocf_cleaning_part_dirty(cache, part_id);
+
+	/* Dirty data being drained is cleaned as if at high watermark */
+	if (drain)
+		return dirty ? OCF_CLEANING_PRESSURE_MAX : 0;
+
+	size = OCF_MIN(part->config->max_size,
+			cache->device->collision_table_entries);
+	low = size * part->dirty_low / 100;
+	high = size * part->dirty_high / 100;
+
+	if (dirty <= low)
+		return 0;
+
+	if (dirty >= high)
+		return OCF_CLEANING_PRESSURE_MAX;
+
+	return (dirty - low) * OCF_CLEANING_PRESSURE_MAX / (high - low);
+}
+
+uint32_t ocf_cleaning_dirty_pressure(ocf_cache_t cache)
+{
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+	uint32_t pressure = 0;
+
+	for_each_part(cache, part, part_id) {
+		if (!ocf_part_is_valid(part))
+			continue;
+
+		pressure = OCF_MAX(pressure,
+				ocf_cleaning_part_dirty_pressure(cache, part_id));
+		if (pressure == OCF_CLEANING_PRESSURE_MAX)
+			break;
+	}
+
+	return pressure;
+}
+
+/*
+ * Multiplicative decrease of cleaning rate while user IO latency is above
+ * target, additive increase while it is below, full rate when there is no
+ * user IO at all.
+ */
+static void ocf_cleaner_throttle_update(ocf_cleaner_t cleaner)
+{
+	struct ocf_cleaner_throttle *throttle = &cleaner->cache->cleaner.throttle;
+	uint64_t latency;
+	int io_count;
+
+	/* First instance drives throttling shared by all of them */
+	if (!throttle->target_us || cleaner->id)
+		return;
+
+	io_count = env_atomic_read(&throttle->io_count);
+	env_atomic_sub(io_count, &throttle->io_count);
+	latency = env_atomic64_read(&throttle->io_latency);
+
+	if (!io_count) {
+		throttle->scale = OCF_CLEANER_THROTTLE_SCALE_MAX;
+		throttle->backoff_ms = 0;
+	} else if (latency > throttle->target_us * 1000ULL) {
+		throttle->scale = OCF_MAX(throttle->scale / 2,
+				(uint32_t)OCF_CLEANER_THROTTLE_SCALE_MIN);
+		throttle->backoff_ms = OCF_MIN(OCF_MAX(throttle->backoff_ms * 2,
+				(uint32_t)OCF_CLEANER_THROTTLE_BACKOFF_MIN_MS),
+				(uint32_t)OCF_CLEANER_THROTTLE_BACKOFF_MAX_MS);
+	} else {
+		throttle->scale = OCF_MIN(throttle->scale +
+				OCF_CLEANER_THROTTLE_SCALE_STEP,
+				(uint32_t)OCF_CLEANER_THROTTLE_SCALE_MAX);
+		throttle->backoff_ms /= 2;
+	}
+}
+
+void ocf_cleaner_account_busy(ocf_cleaner_t cleaner, ocf_cache_line_t line)
+{
+	ocf_cache_t cache = ocf_cleaner_get_cache(cleaner);
+	ocf_core_id_t core_id;
+	ocf_part_id_t part_id;
+
+	ocf_metadata_get_core_and_part_id(cache, line, &core_id, &part_id);
+
+	env_atomic64_inc(&ocf_core_stats(&cache->core[core_id],
+			cleaner->io_queue)->part_counters[part_id].
+					cleaning.busy_clines);
+}
+
+void ocf_cleaner_account_postponed(ocf_cleaner_t cleaner)
+{
+	ocf_cache_t cache = ocf_cleaner_get_cache(cleaner);
+
+	env_atomic64_inc(&cache->cleaner_counters.postponed_runs);
+}
+
+static void ocf_cleaner_account_run(ocf_cleaner_t cleaner)
+{
+	ocf_cache_t cache = ocf_cleaner_get_cache(cleaner);
+	struct ocf_counters_cleaner *counters = &cache->cleaner_counters;
+	uint64_t duration;
+	long old;
+
+	duration = env_ticks_to_nsecs(env_get_tick_count() -
+			cleaner->run_ticks);
+
+	env_atomic64_inc(&counters->runs);
+	env_atomic64_add(duration, &counters->time_ns);
+
+	do {
+		old = env_atomic64_read(&counters->max_time_ns);
+		if (old >= (long)duration)
+			break;
+	} while (env_atomic64_cmpxchg(&counters->max_time_ns, old,
+			duration) != old);
+}
+
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0
+/*
+ * Only metadata of lines which can't be dirty is written in background, as
+ * writes of dirty lines metadata must not be overtaken by checkpoint of
+ * older page content
+ */
+static bool ocf_cleaner_checkpoint_allowed(ocf_cache_t cache)
+{
+	struct ocf_user_part *part;
+	ocf_part_id_t id;
+
+	if (cache->conf_meta->cache_mode == ocf_cache_mode_wb)
+		return false;
+
+	for_each_part(cache, part, id) {
+		if (part->config->cache_mode == ocf_cache_mode_wb)
+			return false;
+	}
+
+	return !ocf_mngt_cache_is_dirty(cache);
+}
+
+static void ocf_cleaner_checkpoint_complete(void *priv, int error)
+{
+	ocf_cache_t cache = priv;
+
+	env_atomic_set(&cache->checkpoint.in_progress, 0);
+	env_rwsem_up_read(&cache->lock);
+}
+
+/*
+ * Start checkpoint of metadata once interval has passed since last one.
+ * Cache lock is held until checkpoint is written, so that cache mode can't
+ * be changed meanwhile. Caller holds cache lock.
+ */
+static void ocf_cleaner_checkpoint(ocf_cache_t cache)
+{
+	uint64_t now = env_get_tick_count();
+
+	if (env_ticks_to_secs(now - cache->checkpoint.last_ticks) <
+			OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL) {
+		return;
+	}
+
+	if (env_atomic_cmpxchg(&cache->checkpoint.in_progress, 0, 1))
+		return;
+
+	if (!ocf_cleaner_checkpoint_allowed(cache) ||
+			env_rwsem_down_read_trylock(&cache->lock)) {
+		env_atomic_set(&cache->checkpoint.in_progress, 0);
+		return;
+	}
+
+	cache->checkpoint.last_ticks = now;
+
+	ocf_checkpoint_write(cache, ocf_cleaner_checkpoint_complete, cache);
+}
+#else
+static inline void ocf_cleaner_checkpoint(ocf_cache_t cache)
+{
+}
+#endif
+
 static void ocf_cleaner_run_complete(ocf_cleaner_t cleaner, uint32_t interval)
 {
 	ocf_cache_t cache = ocf_cleaner_get_cache(cleaner);
 
-	env_rwsem_up_write(&cache->lock);
-	cleaner->end(cleaner, interval);
+	ocf_cleaner_account_run(cleaner);
+
+	env_atomic_set(&cleaner->running, 0);
+	env_atomic_dec(&cache->cleaner.active);
+	cleaner->end(cleaner, ocf_cleaner_drain_backoff(cache) ?:
+			interval + cache->cleaner.throttle.backoff_ms);
 
 	ocf_queue_put(cleaner->io_queue);
 }
@@ -131,14 +606,33 @@ void ocf_cleaner_run(ocf_cleaner_t cleaner, ocf_queue_t queue)
 		return;
 	}
 
-	/* Sleep in case there is management operation in progress. */
-	if (env_rwsem_down_write_trylock(&cache->lock)) {
+	/* Sleep in case there is management operation in progress. Cleaner
+	 * instances run concurrently, so they share the lock. Lock is held only
+	 * until run is started, so that management operations don't wait for
+	 * cleaning I/O. Those depending on cleaner state wait for runs in
+	 * progress with ocf_cleaner_wait_for_finish().
+	 */
+	if (env_rwsem_down_read_trylock(&cache->lock)) {
+		cleaner->end(cleaner, SLEEP_TIME_MS);
+		return;
+	}
+
+	/* Each instance runs one at a time */
+	if (env_atomic_cmpxchg(&cleaner->running, 0, 1)) {
+		env_rwsem_up_read(&cache->lock);
 		cleaner->end(cleaner, SLEEP_TIME_MS);
 		return;
 	}
 
+	ocf_cleaner_checkpoint(cache);
+
+	ocf_trim_kick(cache, queue);
+
+	ocf_cleaner_drain_update(cache);
+
 	if (_ocf_cleaner_run_check_dirty_inactive(cache)) {
-		env_rwsem_up_write(&cache->lock);
+		env_atomic_set(&cleaner->running, 0);
+		env_rwsem_up_read(&cache->lock);
 		cleaner->end(cleaner, SLEEP_TIME_MS);
 		return;
 	}
@@ -147,9 +641,20 @@ void ocf_cleaner_run(ocf_cleaner_t cleaner, ocf_queue_t queue)
 
 	ENV_BUG_ON(clean_type >= ocf_cleaning_max);
 
+	cleaner->run_ticks = env_get_tick_count();
+
 	ocf_queue_get(queue);
 	cleaner->io_queue = queue;
 
-	cleaning_policy_ops[clean_type].perform_cleaning(cache,
+	ocf_cleaner_throttle_update(cleaner);
+
+	ocf_stats_window_tick(cache);
+	ocf_mode_advisor_tick(cache);
+	ocf_log_ring_flush_all(cache);
+
+	env_atomic_inc(&cache->cleaner.active);
+	env_rwsem_up_read(&cache->lock);
+
+	cleaning_policy_ops[clean_type].perform_cleaning(cache, cleaner,
 			ocf_cleaner_run_complete);
 }
@@ -38,10 +38,41 @@ struct cleaning_policy_meta {
 	} meta;
 };
 
+static inline bool ocf_cleaning_is_built(ocf_cleaning_t type)
+{
+	return OCF_CONFIG_CLEANING_POLICIES & (1 << type);
+}
+
+static inline ocf_cleaning_t ocf_cleaning_get_default(void)
+{
+	if (ocf_cleaning_is_built(ocf_cleaning_default))
+		return ocf_cleaning_default;
+
+	return ocf_cleaning_is_built(ocf_cleaning_acp) ?
+			ocf_cleaning_acp : ocf_cleaning_nop;
+}
+
+/*
+ * Size of per cache line cleaning metadata, only the part of union used by
+ * policies built in is kept in metadata.
+ */
+static inline uint32_t ocf_cleaning_meta_size(void)
+{
+	if (ocf_cleaning_is_built(ocf_cleaning_alru))
+		return sizeof(struct alru_cleaning_policy_meta);
+
+	if (ocf_cleaning_is_built(ocf_cleaning_acp))
+		return sizeof(struct acp_cleaning_policy_meta);
+
+	/* NOP keeps no metadata, but metadata entry can't be empty */
+	return 1;
+}
+
 struct cleaning_policy_ops {
 	void (*setup)(ocf_cache_t cache);
 	int (*initialize)(ocf_cache_t cache, int init_metadata);
 	void (*deinitialize)(ocf_cache_t cache);
+	size_t (*size_of)(ocf_cache_t cache);
 	int (*add_core)(ocf_cache_t cache, ocf_core_id_t core_id);
 	void (*remove_core)(ocf_cache_t cache, ocf_core_id_t core_id);
 	void (*init_cache_block)(ocf_cache_t cache, uint32_t cache_line);
@@ -53,21 +84,276 @@ struct cleaning_policy_ops {
 			uint32_t param_value);
 	int (*get_cleaning_param)(ocf_cache_t cache, uint32_t param_id,
 			uint32_t *param_value);
-	void (*perform_cleaning)(ocf_cache_t cache, ocf_cleaner_end_t cmpl);
+	void (*perform_cleaning)(ocf_cache_t cache, ocf_cleaner_t cleaner,
+			ocf_cleaner_end_t cmpl);
 	const char *name;
 };
 
 extern struct cleaning_policy_ops cleaning_policy_ops[ocf_cleaning_max];
 
+/*
+ * Cleaner throttling keeps average latency of user IO within target by
+ * scaling cleaning batch of policy and extending cleaner wake up interval.
+ */
+struct ocf_cleaner_throttle {
+	uint32_t target_us;
+		/*!< User IO latency target, 0 if throttling is disabled */
+
+	env_atomic64 io_latency;
+		/*!< Moving average of user IO latency in nanoseconds */
+
+	env_atomic io_count;
+		/*!< User IOs completed since previous cleaner run */
+
+	uint32_t scale;
+		/*!< Part of policy cleaning batch to be cleaned, in permille */
+
+	uint32_t backoff_ms;
+		/*!< Time added to wake up interval of policy */
+};
+
+/*
+ * Drain of dirty data left in partitions which cache mode no longer is
+ * write-back. Until no such dirty data is left, policy cleans it as if its
+ * partition reached high dirty watermark, limited to given rate.
+ */
+struct ocf_cleaner_drain {
+	env_atomic active;
+
+	env_spinlock lock;
+		/*!< Protects drain budget */
+
+	uint32_t rate;
+		/*!< Cache lines cleaned per second, 0 if not limited */
+
+	uint64_t budget;
+		/*!< Cache lines which can be cleaned until budget refill */
+
+	uint64_t refill_ticks;
+		/*!< Tick count of last budget refill */
+
+	uint64_t dirty_initial;
+		/*!< Cache lines to be cleaned when drain started */
+};
+
 struct ocf_cleaner {
-	void *cleaning_policy_context;
+	ocf_cache_t cache;
+	uint32_t id;
+		/*!< Instance number, selects cores cleaned by instance */
 	ocf_queue_t io_queue;
 	ocf_cleaner_end_t end;
 	void *priv;
+	env_atomic running;
+		/*!< Instance run is in progress */
+	uint64_t run_ticks;
+		/*!< Tick count at which current run started */
+};
+
+/* Maximum number of data buffers kept in cleaner pool */
+#define OCF_CLEANER_POOL_SIZE_MAX	64
+
+/*
+ * Pool of data buffers of cleaning requests. Buffers hold data of given
+ * number of cache lines and are kept for reuse, up to the capacity needed
+ * to run cleaning batch of policy on each cleaner instance.
+ */
+struct ocf_cleaner_pool {
+	env_spinlock lock;
+
+	ctx_data_t *data[OCF_CLEANER_POOL_SIZE_MAX];
+	uint32_t count;
+		/*!< Number of free buffers in pool */
+
+	uint32_t capacity;
+
+	uint32_t lines;
+		/*!< Number of cache lines of pooled buffer, 0 if pool is off */
+};
+
+/*
+ * Cleaner instances share policy context and throttling. Each instance
+ * cleans cores which id modulo number of instances is equal to its id.
+ */
+struct ocf_cleaners {
+	void *cleaning_policy_context;
+	struct ocf_cleaner_throttle throttle;
+	struct ocf_cleaner_drain drain;
+	struct ocf_cleaner_pool pool;
+	struct ocf_cleaner instance[OCF_CLEANER_INSTANCES_MAX];
+	uint32_t count;
+	env_atomic active;
+		/*!< Number of cleaner runs in progress */
+	env_atomic64 emergency_ticks;
+		/*!< Time eviction last had to clean lines inline */
 };
 
+
+/**
+ * @brief Initialize cleaner instances of cache
+ *
+ * @param cache - Cache instance
+ * @param count - Number of instances, 0 means single instance
+ */
+void ocf_cleaner_setup(ocf_cache_t cache, uint32_t count);
+
 int ocf_start_cleaner(ocf_cache_t cache);
 
 void ocf_stop_cleaner(ocf_cache_t cache);
 
+/**
+ * @brief Check whether any cleaner run is in progress
+ *
+ * Runs start only while no management operation holds cache lock, but they
+ * don't hold cache lock themselves until their I/O is finished. Management
+ * operations changing state used by cleaner have to wait for them.
+ *
+ * @param cache - Cache instance
+ */
+bool ocf_cleaner_is_active(ocf_cache_t cache);
+
+/**
+ * @brief Synchronously wait until cleaner runs in progress are finished
+ *
+ * @param cache - Cache instance
+ * @param timeout_ms - Time limit of wait, 0 means no limit
+ *
+ * @retval 0 No cleaner run is in progress
+ * @retval -OCF_ERR_CACHE_IN_USE Timeout reached
+ */
+int ocf_cleaner_wait_for_finish(ocf_cache_t cache, int32_t timeout_ms);
+
+/**
+ * @brief Request emergency cleaning after eviction found only dirty lines
+ *
+ * Cleaner instances are kicked, and until eviction goes without cleaning
+ * inline for OCF_CLEANER_EMERGENCY_MS, partitions holding dirty data are
+ * cleaned at maximum dirty pressure, regardless of I/O activity and
+ * staleness of dirty data.
+ *
+ * @param cache - Cache instance
+ */
+void ocf_cleaner_emergency(ocf_cache_t cache);
+
+/**
+ * @brief Check whether emergency cleaning is in effect
+ *
+ * @param cache - Cache instance
+ */
+bool ocf_cleaner_in_emergency(ocf_cache_t cache);
+
+/**
+ * @brief Check whether core is cleaned by cleaner instance
+ *
+ * @param cleaner - Cleaner instance
+ * @param core_id - Core id
+ */
+bool ocf_cleaner_owns_core(ocf_cleaner_t cleaner, ocf_core_id_t core_id);
+
+/**
+ * @brief Account dirty cache line skipped by cleaner as being in use
+ *
+ * @param cleaner - Cleaner instance
+ * @param line - Cache line
+ */
+void ocf_cleaner_account_busy(ocf_cleaner_t cleaner, ocf_cache_line_t line);
+
+/**
+ * @brief Account cleaner run in which policy decided to clean later
+ *
+ * @param cleaner - Cleaner instance
+ */
+void ocf_cleaner_account_postponed(ocf_cleaner_t cleaner);
+
+/**
+ * @brief Account latency of completed user IO
+ *
+ * @param cache - Cache instance
+ * @param submit_ticks - Tick count at which IO was submitted
+ */
+void ocf_cleaner_throttle_io_done(ocf_cache_t cache, uint64_t submit_ticks);
+
+/**
+ * @brief Get number of cache lines to be cleaned by policy in single run
+ *
+ * @param cache - Cache instance
+ * @param batch - Cleaning batch configured for policy
+ */
+uint32_t ocf_cleaner_throttle_batch(ocf_cache_t cache, uint32_t batch);
+
+/**
+ * @brief Set user IO latency target and restart throttling
+ *
+ * @param cache - Cache instance
+ * @param target_us - Latency target in microseconds, 0 disables throttling
+ */
+void ocf_cleaner_throttle_set_target(ocf_cache_t cache, uint32_t target_us);
+
+/**
+ * @brief Start drain of dirty data of partitions not in write-back mode
+ *
+ * @param cache - Cache instance
+ * @param rate - Cache lines cleaned per second, 0 if not limited
+ */
+void ocf_cleaner_drain_start(ocf_cache_t cache, uint32_t rate);
+
+/**
+ * @brief Stop drain of dirty data
+ *
+ * @param cache - Cache instance
+ */
+void ocf_cleaner_drain_stop(ocf_cache_t cache);
+
+/**
+ * @brief Get number of dirty cache lines left to be drained
+ *
+ * @param cache - Cache instance
+ */
+uint64_t ocf_cleaner_drain_dirty(ocf_cache_t cache);
+
+/**
+ * @brief Limit policy cleaning batch to drain rate
+ *
+ * @param cache - Cache instance
+ * @param batch - Cleaning batch of policy
+ */
+uint32_t ocf_cleaner_drain_batch(ocf_cache_t cache, uint32_t batch);
+
+/* Dirty pressure at and above high watermark */
+#define OCF_CLEANING_PRESSURE_MAX		1000
+
+/* Policy cleaning batch multiplier at high watermark */
+#define OCF_CLEANING_PRESSURE_BATCH_SCALE	4
+
+/**
+ * @brief Get dirty pressure of partition
+ *
+ * Pressure is 0 up to low dirty watermark of partition and grows linearly
+ * up to OCF_CLEANING_PRESSURE_MAX reached at high watermark.
+ *
+ * @param cache - Cache instance
+ * @param part_id - Partition id
+ */
+uint32_t ocf_cleaning_part_dirty_pressure(ocf_cache_t cache,
+		ocf_part_id_t part_id);
+
+/**
+ * @brief Get highest dirty pressure of all valid partitions
+ *
+ * @param cache - Cache instance
+ */
+uint32_t ocf_cleaning_dirty_pressure(ocf_cache_t cache);
+
+/**
+ * @brief Scale policy cleaning batch up with dirty pressure
+ *
+ * @param batch - Cleaning batch of policy
+ * @param pressure - Dirty pressure
+ */
+static inline uint32_t ocf_cleaning_pressure_batch(uint32_t batch,
+		uint32_t pressure)
+{
+	return batch + (uint64_t)batch * (OCF_CLEANING_PRESSURE_BATCH_SCALE - 1) *
+			pressure / OCF_CLEANING_PRESSURE_MAX;
+}
+
 #endif
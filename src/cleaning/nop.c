@@ -7,8 +7,9 @@
 #include "nop.h"
 #include "../ocf_cache_priv.h"
 
-void cleaning_nop_perform_cleaning(ocf_cache_t cache, ocf_cleaner_end_t cmpl)
+void cleaning_nop_perform_cleaning(ocf_cache_t cache, ocf_cleaner_t cleaner,
+		ocf_cleaner_end_t cmpl)
 {
 	uint32_t interval = SLEEP_TIME_MS;
-	cmpl(&cache->cleaner, interval);
+	cmpl(cleaner, interval);
 }
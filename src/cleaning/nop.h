@@ -9,6 +9,7 @@
 #include "cleaning.h"
 #include "nop_structs.h"
 
-void cleaning_nop_perform_cleaning(ocf_cache_t cache, ocf_cleaner_end_t cmpl);
+void cleaning_nop_perform_cleaning(ocf_cache_t cache, ocf_cleaner_t cleaner,
+		ocf_cleaner_end_t cmpl);
 
 #endif
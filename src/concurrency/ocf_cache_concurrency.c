@@ -8,6 +8,7 @@
 #include "../ocf_request.h"
 #include "../utils/utils_cache_line.h"
 #include "../utils/utils_allocator.h"
+#include "../ocf_trace_priv.h"
 
 #define OCF_CACHE_CONCURRENCY_DEBUG 0
 
@@ -25,15 +26,32 @@
 #define OCF_DEBUG_RQ(req, format, ...)
 #endif
 
-#define OCF_CACHE_LINE_ACCESS_WR	INT_MAX
+/*
+ * Cache line access value holds number of readers or OCF_CACHE_LINE_ACCESS_WR
+ * for writer. OCF_CACHE_LINE_ACCESS_WAITERS flag is set while there are
+ * waiters on the cache line; it is modified only under waiters list lock and
+ * lets lock-free fast paths bail out to the waiters list.
+ */
+#define OCF_CACHE_LINE_ACCESS_WAITERS	(1 << 30)
+#define OCF_CACHE_LINE_ACCESS_MASK	(OCF_CACHE_LINE_ACCESS_WAITERS - 1)
+#define OCF_CACHE_LINE_ACCESS_WR	OCF_CACHE_LINE_ACCESS_MASK
 #define OCF_CACHE_LINE_ACCESS_IDLE	0
 #define OCF_CACHE_LINE_ACCESS_ONE_RD	1
 
-#define _WAITERS_LIST_SIZE	(16UL * MiB)
-#define _WAITERS_LIST_ENTRIES \
-	(_WAITERS_LIST_SIZE / sizeof(struct __waiters_list))
+#define __access_value(v) ((v) & OCF_CACHE_LINE_ACCESS_MASK)
+#define __access_waiters(v) ((v) & OCF_CACHE_LINE_ACCESS_WAITERS)
+
+/*
+ * Waiters lists table is sized from number of cache lines, one list per
+ * _WAITERS_LIST_LINES cache lines, limited to _WAITERS_LIST_MAX_SIZE
+ */
+#define _WAITERS_LIST_LINES	16
+#define _WAITERS_LIST_MAX_SIZE	(16UL * MiB)
+#define _WAITERS_LIST_MAX_ENTRIES \
+	(_WAITERS_LIST_MAX_SIZE / sizeof(struct __waiters_list))
 
-#define _WAITERS_LIST_ITEM(cache_line) ((cache_line) % _WAITERS_LIST_ENTRIES)
+#define _WAITERS_LIST_ITEM(c, cache_line) \
+	((cache_line) % (c)->waiters_lsts_count)
 
 typedef void (*__on_lock)(void *ctx, uint32_t ctx_id, ocf_cache_line_t line,
 		int rw);
@@ -47,40 +65,77 @@ struct __waiter {
 	int rw;
 };
 
+/*
+ * Aligned to CPU cache line so that spinlocks of neighbouring lists are not
+ * false shared
+ */
 struct __waiters_list {
 	struct list_head head;
 	env_spinlock lock;
+} __attribute__((aligned(64)));
+
+#if OCF_CONFIG_RANGE_LOCK_MIN_LINES
+/*
+ * Range lock covers run of consecutive cache lines of large request. Access
+ * values of range locked cache lines are not changed, instead every grant of
+ * cache line lock checks held ranges as long as any range is held.
+ */
+#define _RANGE_LOCK_SLOTS	32
+
+struct __range {
+	ocf_cache_line_t first;
+	ocf_cache_line_t last;
+	int rw;
+	bool used;
+	env_atomic contended;
+		/* Waiters were queued on cache lines of range */
 };
+#endif
 
 struct ocf_cache_concurrency {
 	env_rwlock lock;
 	env_atomic *access;
 	env_atomic waiting;
+#if OCF_CONFIG_STATS_LOCK
+	env_atomic64 waiters_total;
+#endif
+	env_atomic waiters_allocs;
+	env_atomic64 waiters_bytes;
 	size_t access_limit;
-	env_allocator *allocator;
-	struct __waiters_list waiters_lsts[_WAITERS_LIST_ENTRIES];
-
+	uint32_t waiters_lsts_count;
+	struct __waiters_list *waiters_lsts;
+#if OCF_CONFIG_RANGE_LOCK_MIN_LINES
+	env_rwlock ranges_lock;
+	env_atomic ranges_held;
+	struct __range ranges[_RANGE_LOCK_SLOTS];
+#endif
 };
 
+static uint32_t _ocf_cache_concurrency_waiters_lsts_count(
+		ocf_cache_line_t entries)
+{
+	uint64_t count = OCF_DIV_ROUND_UP((uint64_t)entries,
+			(uint64_t)_WAITERS_LIST_LINES);
+
+	count = OCF_MIN(count, (uint64_t)_WAITERS_LIST_MAX_ENTRIES);
+
+	return count ?: 1;
+}
+
 /*
  *
  */
-
-#define ALLOCATOR_NAME_FMT "ocf_%s_cache_concurrency"
-#define ALLOCATOR_NAME_MAX (sizeof(ALLOCATOR_NAME_FMT) + OCF_CACHE_NAME_SIZE)
-
 int ocf_cache_concurrency_init(struct ocf_cache *cache)
 {
 	uint32_t i;
 	int error = 0;
 	struct ocf_cache_concurrency *c;
-	char name[ALLOCATOR_NAME_MAX];
 
 	ENV_BUG_ON(cache->device->concurrency.cache);
 
 	OCF_DEBUG_TRACE(cache);
 
-	c = env_vmalloc(sizeof(*c));
+	c = env_vzalloc(sizeof(*c));
 	if (!c) {
 		error = __LINE__;
 		goto ocf_cache_concurrency_init;
@@ -97,25 +152,25 @@ int ocf_cache_concurrency_init(struct ocf_cache *cache)
 		goto ocf_cache_concurrency_init;
 	}
 
-	if (snprintf(name, sizeof(name), ALLOCATOR_NAME_FMT,
-			ocf_cache_get_name(cache)) < 0) {
-		error = __LINE__;
-		goto ocf_cache_concurrency_init;
-	}
-
-	c->allocator = env_allocator_create(sizeof(struct __waiter), name);
-	if (!c->allocator) {
+	c->waiters_lsts_count = _ocf_cache_concurrency_waiters_lsts_count(
+			cache->device->collision_table_entries);
+	c->waiters_lsts = env_vmalloc(sizeof(*c->waiters_lsts) *
+			c->waiters_lsts_count);
+	if (!c->waiters_lsts) {
 		error = __LINE__;
 		goto ocf_cache_concurrency_init;
 	}
 
 	/* Init concurrency control table */
-	for (i = 0; i < _WAITERS_LIST_ENTRIES; i++) {
+	for (i = 0; i < c->waiters_lsts_count; i++) {
 		INIT_LIST_HEAD(&c->waiters_lsts[i].head);
 		env_spinlock_init(&c->waiters_lsts[i].lock);
 	}
 
 	env_rwlock_init(&c->lock);
+#if OCF_CONFIG_RANGE_LOCK_MIN_LINES
+	env_rwlock_init(&c->ranges_lock);
+#endif
 
 	return 0;
 
@@ -147,25 +202,34 @@ void ocf_cache_concurrency_deinit(struct ocf_cache *cache)
 		OCF_REALLOC_DEINIT(&concurrency->access,
 				&concurrency->access_limit);
 
-	if (concurrency->allocator)
-		env_allocator_destroy(concurrency->allocator);
+	if (concurrency->waiters_lsts)
+		env_vfree(concurrency->waiters_lsts);
 
 	env_vfree(concurrency);
 	cache->device->concurrency.cache = NULL;
 }
 
-size_t ocf_cache_concurrency_size_of(struct ocf_cache *cache)
+size_t ocf_cache_concurrency_size_for(ocf_cache_line_t entries)
 {
 	size_t size;
 
 	size = sizeof(env_atomic);
-	size *= cache->device->collision_table_entries;
+	size *= entries;
 
 	size += sizeof(struct ocf_cache_concurrency);
 
+	size += sizeof(struct __waiters_list) *
+			_ocf_cache_concurrency_waiters_lsts_count(entries);
+
 	return size;
 }
 
+size_t ocf_cache_concurrency_size_of(struct ocf_cache *cache)
+{
+	return ocf_cache_concurrency_size_for(
+			cache->device->collision_table_entries);
+}
+
 /*
  *
  */
@@ -174,7 +238,7 @@ static inline bool __are_waiters(struct ocf_cache_concurrency *c,
 {
 	bool are = false;
 	struct list_head *iter;
-	uint32_t idx = _WAITERS_LIST_ITEM(line);
+	uint32_t idx = _WAITERS_LIST_ITEM(c, line);
 	struct __waiters_list *lst = &c->waiters_lsts[idx];
 	struct __waiter *waiter;
 
@@ -200,66 +264,192 @@ static inline bool __are_waiters(struct ocf_cache_concurrency *c,
 static inline void __add_waiter(struct ocf_cache_concurrency *c,
 		ocf_cache_line_t line, struct __waiter *waiter)
 {
-	uint32_t idx = _WAITERS_LIST_ITEM(line);
+	uint32_t idx = _WAITERS_LIST_ITEM(c, line);
 	struct __waiters_list *lst = &c->waiters_lsts[idx];
 
 	list_add_tail(&waiter->item, &lst->head);
+#if OCF_CONFIG_STATS_LOCK
+	env_atomic64_inc(&c->waiters_total);
+#endif
 }
 
+/*
+ * Set waiters flag of cache line, caller has to hold waiters list lock
+ */
+static inline void __set_waiters(struct ocf_cache_concurrency *c,
+		ocf_cache_line_t line)
+{
+	env_atomic *access = &c->access[line];
+	int v;
+
+	do {
+		v = env_atomic_read(access);
+	} while (env_atomic_cmpxchg(access, v,
+			v | OCF_CACHE_LINE_ACCESS_WAITERS) != v);
+}
+
+/*
+ * Clear waiters flag of cache line, caller has to hold waiters list lock
+ */
+static inline void __clear_waiters(struct ocf_cache_concurrency *c,
+		ocf_cache_line_t line)
+{
+	env_atomic *access = &c->access[line];
+	int v;
+
+	do {
+		v = env_atomic_read(access);
+	} while (env_atomic_cmpxchg(access, v,
+			v & ~OCF_CACHE_LINE_ACCESS_WAITERS) != v);
+}
+
+/*
+ * Check waiters flag of cache line, exact when waiters list lock is held
+ */
+static inline bool __test_waiters(struct ocf_cache_concurrency *c,
+		ocf_cache_line_t line)
+{
+	return __access_waiters(env_atomic_read(&c->access[line]));
+}
 
 #define __lock_waiters_list(cncrrncy, line, flags) \
 	do { \
-		uint32_t idx = _WAITERS_LIST_ITEM(line); \
+		uint32_t idx = _WAITERS_LIST_ITEM(cncrrncy, line); \
 		struct __waiters_list *lst = &cncrrncy->waiters_lsts[idx]; \
 		env_spinlock_lock_irqsave(&lst->lock, flags); \
 	} while (0)
 
 #define __unlock_waiters_list(cncrrncy, line, flags) \
 	do { \
-		uint32_t idx = _WAITERS_LIST_ITEM(line); \
+		uint32_t idx = _WAITERS_LIST_ITEM(cncrrncy, line); \
 		struct __waiters_list *lst = &cncrrncy->waiters_lsts[idx]; \
 		env_spinlock_unlock_irqrestore(&lst->lock, flags); \
 	} while (0)
 
+#if OCF_CONFIG_RANGE_LOCK_MIN_LINES
+/*
+ * Check if cache line can't be granted for rw access because of held range
+ * lock. With mark set, conflicting range is marked as contended, so that
+ * waiters of cache line are woken up when range is released.
+ */
+static inline bool __range_conflict(struct ocf_cache_concurrency *c,
+		ocf_cache_line_t line, int rw, bool mark)
+{
+	struct __range *range;
+	bool conflict = false;
+	uint32_t i;
+
+	/* Read after cache line access value was changed, range lockers check
+	 * access values after ranges_held is incremented
+	 */
+	if (!env_atomic_read(&c->ranges_held))
+		return false;
+
+	env_rwlock_read_lock(&c->ranges_lock);
+
+	for (i = 0; i < _RANGE_LOCK_SLOTS; i++) {
+		range = &c->ranges[i];
+
+		if (!range->used || line < range->first || line > range->last)
+			continue;
+
+		if (rw == OCF_READ && range->rw == OCF_READ)
+			continue;
+
+		conflict = true;
+		if (mark)
+			env_atomic_set(&range->contended, 1);
+		break;
+	}
+
+	env_rwlock_read_unlock(&c->ranges_lock);
+
+	return conflict;
+}
+#else
+static inline bool __range_conflict(struct ocf_cache_concurrency *c,
+		ocf_cache_line_t line, int rw, bool mark)
+{
+	return false;
+}
+#endif
+
 
 /*
- *
+ * Lock cache line for write if it is idle, waiters flag is preserved
  */
 static inline bool __try_lock_wr(struct ocf_cache_concurrency *c,
 		ocf_cache_line_t line)
 {
 	env_atomic *access = &c->access[line];
-	int prev = env_atomic_cmpxchg(access, OCF_CACHE_LINE_ACCESS_IDLE,
-			OCF_CACHE_LINE_ACCESS_WR);
+	int v, prev;
 
-	if (prev == OCF_CACHE_LINE_ACCESS_IDLE)
-		return true;
-	else
-		return false;
+	do {
+		v = env_atomic_read(access);
+		if (__access_value(v) != OCF_CACHE_LINE_ACCESS_IDLE)
+			return false;
+
+		prev = env_atomic_cmpxchg(access, v,
+				__access_waiters(v) | OCF_CACHE_LINE_ACCESS_WR);
+	} while (prev != v);
+
+	return true;
 }
 
 /*
- *
+ * Lock-free fast path, lock cache line for write only if it is idle and
+ * there are no waiters
  */
-static inline bool __try_lock_rd_idle(struct ocf_cache_concurrency *c,
+static inline bool __try_lock_wr_fast(struct ocf_cache_concurrency *c,
 		ocf_cache_line_t line)
 {
 	env_atomic *access = &c->access[line];
 	int prev = env_atomic_cmpxchg(access, OCF_CACHE_LINE_ACCESS_IDLE,
-			OCF_CACHE_LINE_ACCESS_ONE_RD);
+			OCF_CACHE_LINE_ACCESS_WR);
 
 	return (prev == OCF_CACHE_LINE_ACCESS_IDLE);
 }
 
 /*
- *
+ * Lock-free fast path, lock cache line for read if it is not write locked
+ * and there are no waiters
+ */
+static inline bool __try_lock_rd_fast(struct ocf_cache_concurrency *c,
+		ocf_cache_line_t line)
+{
+	env_atomic *access = &c->access[line];
+	int v, prev;
+
+	do {
+		v = env_atomic_read(access);
+		if (__access_waiters(v) || v == OCF_CACHE_LINE_ACCESS_WR)
+			return false;
+
+		prev = env_atomic_cmpxchg(access, v, v + 1);
+	} while (prev != v);
+
+	return true;
+}
+
+/*
+ * Lock cache line for read if it is not write locked, waiters flag is
+ * preserved
  */
 static inline bool __try_lock_rd(struct ocf_cache_concurrency *c,
 		ocf_cache_line_t line)
 {
 	env_atomic *access = &c->access[line];
+	int v, prev;
+
+	do {
+		v = env_atomic_read(access);
+		if (__access_value(v) == OCF_CACHE_LINE_ACCESS_WR)
+			return false;
 
-	return !!env_atomic_add_unless(access, 1, OCF_CACHE_LINE_ACCESS_WR);
+		prev = env_atomic_cmpxchg(access, v, v + 1);
+	} while (prev != v);
+
+	return true;
 }
 
 /*
@@ -269,9 +459,11 @@ static inline void __unlock_wr(struct ocf_cache_concurrency *c,
 		ocf_cache_line_t line)
 {
 	env_atomic *access = &c->access[line];
+	int v = env_atomic_read(access);
 
-	ENV_BUG_ON(env_atomic_read(access) != OCF_CACHE_LINE_ACCESS_WR);
-	env_atomic_set(access, OCF_CACHE_LINE_ACCESS_IDLE);
+	ENV_BUG_ON(__access_value(v) != OCF_CACHE_LINE_ACCESS_WR);
+	env_atomic_set(access, __access_waiters(v) |
+			OCF_CACHE_LINE_ACCESS_IDLE);
 }
 
 /*
@@ -281,12 +473,37 @@ static inline void __unlock_rd(struct ocf_cache_concurrency *c,
 		ocf_cache_line_t line)
 {
 	env_atomic *access = &c->access[line];
+	int v = __access_value(env_atomic_read(access));
 
-	ENV_BUG_ON(env_atomic_read(access) == 0);
-	ENV_BUG_ON(env_atomic_read(access) == OCF_CACHE_LINE_ACCESS_WR);
+	ENV_BUG_ON(v == 0);
+	ENV_BUG_ON(v == OCF_CACHE_LINE_ACCESS_WR);
 	env_atomic_dec(access);
 }
 
+/*
+ * Lock-free fast path, unlock cache line read lock if there are no waiters
+ * to be woken up
+ */
+static inline bool __unlock_rd_fast(struct ocf_cache_concurrency *c,
+		ocf_cache_line_t line)
+{
+	env_atomic *access = &c->access[line];
+	int v, prev;
+
+	do {
+		v = env_atomic_read(access);
+		if (__access_waiters(v))
+			return false;
+
+		ENV_BUG_ON(v == 0);
+		ENV_BUG_ON(v == OCF_CACHE_LINE_ACCESS_WR);
+
+		prev = env_atomic_cmpxchg(access, v, v - 1);
+	} while (prev != v);
+
+	return true;
+}
+
 /*
  *
  */
@@ -295,7 +512,8 @@ static inline bool __try_lock_wr2wr(struct ocf_cache_concurrency *c,
 {
 	env_atomic *access = &c->access[line];
 
-	ENV_BUG_ON(env_atomic_read(access) != OCF_CACHE_LINE_ACCESS_WR);
+	ENV_BUG_ON(__access_value(env_atomic_read(access)) !=
+			OCF_CACHE_LINE_ACCESS_WR);
 	return true;
 }
 
@@ -306,9 +524,11 @@ static inline bool __try_lock_wr2rd(struct ocf_cache_concurrency *c,
 		ocf_cache_line_t line)
 {
 	env_atomic *access = &c->access[line];
+	int v = env_atomic_read(access);
 
-	ENV_BUG_ON(env_atomic_read(access) != OCF_CACHE_LINE_ACCESS_WR);
-	env_atomic_set(access, OCF_CACHE_LINE_ACCESS_ONE_RD);
+	ENV_BUG_ON(__access_value(v) != OCF_CACHE_LINE_ACCESS_WR);
+	env_atomic_set(access, __access_waiters(v) |
+			OCF_CACHE_LINE_ACCESS_ONE_RD);
 	return true;
 }
 
@@ -321,14 +541,15 @@ static inline bool __try_lock_rd2wr(struct ocf_cache_concurrency *c,
 	env_atomic *access = &c->access[line];
 
 	int v = env_atomic_read(access);
+	int flag = __access_waiters(v);
 
-	ENV_BUG_ON(v == OCF_CACHE_LINE_ACCESS_IDLE);
-	ENV_BUG_ON(v == OCF_CACHE_LINE_ACCESS_WR);
+	ENV_BUG_ON(__access_value(v) == OCF_CACHE_LINE_ACCESS_IDLE);
+	ENV_BUG_ON(__access_value(v) == OCF_CACHE_LINE_ACCESS_WR);
 
-	v = env_atomic_cmpxchg(access, OCF_CACHE_LINE_ACCESS_ONE_RD,
-			OCF_CACHE_LINE_ACCESS_WR);
+	v = env_atomic_cmpxchg(access, flag | OCF_CACHE_LINE_ACCESS_ONE_RD,
+			flag | OCF_CACHE_LINE_ACCESS_WR);
 
-	return (v == OCF_CACHE_LINE_ACCESS_ONE_RD);
+	return (v == (flag | OCF_CACHE_LINE_ACCESS_ONE_RD));
 }
 
 /*
@@ -339,7 +560,7 @@ static inline bool __try_lock_rd2rd(struct ocf_cache_concurrency *c,
 {
 	env_atomic *access = &c->access[line];
 
-	int v = env_atomic_read(access);
+	int v = __access_value(env_atomic_read(access));
 
 	ENV_BUG_ON(v == OCF_CACHE_LINE_ACCESS_IDLE);
 	ENV_BUG_ON(v == OCF_CACHE_LINE_ACCESS_WR);
@@ -347,39 +568,58 @@ static inline bool __try_lock_rd2rd(struct ocf_cache_concurrency *c,
 	return true;
 }
 
+static inline void __unlock_cache_line_rd(struct ocf_cache_concurrency *c,
+		const ocf_cache_line_t line);
+static inline void __unlock_cache_line_wr(struct ocf_cache_concurrency *c,
+		const ocf_cache_line_t line);
+
 /*
  *
  */
 static inline bool __lock_cache_line_wr(struct ocf_cache_concurrency *c,
 		const ocf_cache_line_t line, __on_lock on_lock,
-		void *ctx, uint32_t ctx_id)
+		void *ctx, uint32_t ctx_id, struct __waiter *waiter)
 {
-	struct __waiter *waiter;
 	bool locked = false;
 	bool waiting = false;
+	bool waiters;
 	unsigned long flags = 0;
 
-	if (__try_lock_wr(c, line)) {
-		/* No activity before look get */
-		if (on_lock)
-			on_lock(ctx, ctx_id, line, OCF_WRITE);
-		return true;
+	if (__try_lock_wr_fast(c, line)) {
+		if (!__range_conflict(c, line, OCF_WRITE, false)) {
+			/* No activity before look get */
+			if (on_lock)
+				on_lock(ctx, ctx_id, line, OCF_WRITE);
+			return true;
+		}
+
+		__unlock_cache_line_wr(c, line);
 	}
 
 	__lock_waiters_list(c, line, flags);
 
 	/* At the moment list is protected, double check if the cache line is
-	 * unlocked
+	 * unlocked. Readers release the lock without taking waiters list lock
+	 * unless waiters flag is set, so set it before checking.
 	 */
-	if (__try_lock_wr(c, line)) {
-		/* Look get */
-		locked = true;
-	} else {
-		waiter = NULL;
-		if (on_lock != NULL) {
-			/* Need to create waiters and add it into list */
-			waiter = env_allocator_new(c->allocator);
+	waiters = __test_waiters(c, line);
+	if (!waiters)
+		__set_waiters(c, line);
+
+	if (!waiters && __try_lock_wr(c, line)) {
+		if (__range_conflict(c, line, OCF_WRITE, !!waiter)) {
+			/* Range locked, back to idle keeping waiters flag */
+			__unlock_wr(c, line);
+		} else {
+			/* Look get */
+			locked = true;
+			__clear_waiters(c, line);
 		}
+	}
+
+	if (!locked) {
+		if (!waiter && !waiters)
+			__clear_waiters(c, line);
 		if (waiter) {
 			/* Setup waiters filed */
 			waiter->line = line;
@@ -409,39 +649,48 @@ static inline bool __lock_cache_line_wr(struct ocf_cache_concurrency *c,
  */
 static inline bool __lock_cache_line_rd(struct ocf_cache_concurrency *c,
 		const ocf_cache_line_t line, __on_lock on_lock,
-		void *ctx, uint32_t ctx_id)
+		void *ctx, uint32_t ctx_id, struct __waiter *waiter)
 {
-	struct __waiter *waiter;
 	bool locked = false;
 	bool waiting = false;
+	bool waiters;
 	unsigned long flags = 0;
 
-	if (__try_lock_rd_idle(c, line)) {
-		/* No activity before look get, it is first reader */
-		if (on_lock)
-			on_lock(ctx, ctx_id, line, OCF_READ);
-		return true;
+	if (__try_lock_rd_fast(c, line)) {
+		if (!__range_conflict(c, line, OCF_READ, false)) {
+			/* No writer and no waiters, lock get without waiters
+			 * list
+			 */
+			if (on_lock)
+				on_lock(ctx, ctx_id, line, OCF_READ);
+			return true;
+		}
+
+		__unlock_cache_line_rd(c, line);
 	}
 
 	/* Lock waiters list */
 	__lock_waiters_list(c, line, flags);
 
-	if (!__are_waiters(c, line)) {
+	waiters = __test_waiters(c, line);
+	if (!waiters) {
 		/* No waiters at the moment */
 
 		/* Check if read lock can be obtained */
 		if (__try_lock_rd(c, line)) {
-			/* Cache line locked */
-			locked = true;
+			if (__range_conflict(c, line, OCF_READ, !!waiter)) {
+				/* Range locked for write */
+				__unlock_rd(c, line);
+			} else {
+				/* Cache line locked */
+				locked = true;
+			}
 		}
 	}
 
 	if (!locked) {
-		waiter = NULL;
-		if (on_lock) {
-			/* Need to create waiters and add it into list */
-			waiter = env_allocator_new(c->allocator);
-		}
+		if (waiter && !waiters)
+			__set_waiters(c, line);
 		if (waiter) {
 			/* Setup waiters field */
 			waiter->line = line;
@@ -470,9 +719,10 @@ static inline void __unlock_cache_line_rd_common(struct ocf_cache_concurrency *c
 {
 	bool locked = false;
 	bool exchanged = true;
+	bool remaining = false;
 	uint32_t i = 0;
 
-	uint32_t idx = _WAITERS_LIST_ITEM(line);
+	uint32_t idx = _WAITERS_LIST_ITEM(c, line);
 	struct __waiters_list *lst = &c->waiters_lsts[idx];
 	struct __waiter *waiter;
 
@@ -492,6 +742,12 @@ static inline void __unlock_cache_line_rd_common(struct ocf_cache_concurrency *c
 		if (line != waiter->line)
 			continue;
 
+		if (__range_conflict(c, line, waiter->rw, true)) {
+			/* Waiter is woken up when range is released */
+			remaining = true;
+			break;
+		}
+
 		if (exchanged) {
 			if (waiter->rw == OCF_WRITE)
 				locked = __try_lock_rd2wr(c, line);
@@ -514,15 +770,20 @@ static inline void __unlock_cache_line_rd_common(struct ocf_cache_concurrency *c
 			exchanged = false;
 			list_del(iter);
 
+			/* Waiter is owned by the request, it must not be
+			 * touched once lock is handed over
+			 */
 			waiter->on_lock(waiter->ctx, waiter->ctx_id, line,
 					waiter->rw);
-
-			env_allocator_del(c->allocator, waiter);
 		} else {
+			remaining = true;
 			break;
 		}
 	}
 
+	if (!remaining)
+		__clear_waiters(c, line);
+
 	if (exchanged) {
 		/* No exchange, no waiters on the list, unlock and return
 		 * WR -> IDLE
@@ -539,6 +800,9 @@ static inline void __unlock_cache_line_rd(struct ocf_cache_concurrency *c,
 {
 	unsigned long flags = 0;
 
+	if (__unlock_rd_fast(c, line))
+		return;
+
 	/* Lock waiters list */
 	__lock_waiters_list(c, line, flags);
 	__unlock_cache_line_rd_common(c, line);
@@ -552,8 +816,9 @@ static inline void __unlock_cache_line_wr_common(struct ocf_cache_concurrency *c
 	uint32_t i = 0;
 	bool locked = false;
 	bool exchanged = true;
+	bool remaining = false;
 
-	uint32_t idx = _WAITERS_LIST_ITEM(line);
+	uint32_t idx = _WAITERS_LIST_ITEM(c, line);
 	struct __waiters_list *lst = &c->waiters_lsts[idx];
 	struct __waiter *waiter;
 
@@ -573,6 +838,12 @@ static inline void __unlock_cache_line_wr_common(struct ocf_cache_concurrency *c
 		if (line != waiter->line)
 			continue;
 
+		if (__range_conflict(c, line, waiter->rw, true)) {
+			/* Waiter is woken up when range is released */
+			remaining = true;
+			break;
+		}
+
 		if (exchanged) {
 			if (waiter->rw == OCF_WRITE)
 				locked = __try_lock_wr2wr(c, line);
@@ -595,15 +866,20 @@ static inline void __unlock_cache_line_wr_common(struct ocf_cache_concurrency *c
 			exchanged = false;
 			list_del(iter);
 
+			/* Waiter is owned by the request, it must not be
+			 * touched once lock is handed over
+			 */
 			waiter->on_lock(waiter->ctx, waiter->ctx_id, line,
 					waiter->rw);
-
-			env_allocator_del(c->allocator, waiter);
 		} else {
+			remaining = true;
 			break;
 		}
 	}
 
+	if (!remaining)
+		__clear_waiters(c, line);
+
 	if (exchanged) {
 		/* No exchange, no waiters on the list, unlock and return
 		 * WR -> IDLE
@@ -626,40 +902,275 @@ static inline void __unlock_cache_line_wr(struct ocf_cache_concurrency *c,
 	__unlock_waiters_list(c, line, flags);
 }
 
+#if OCF_CONFIG_RANGE_LOCK_MIN_LINES
 /*
- * Safely remove cache line lock waiter from waiting list.
- * Request can be assigned with lock asynchronously at any point of time,
- * so need to check lock state under a common lock.
+ * Grant cache line to waiters queued while it was covered by range lock,
+ * caller has to hold waiters list lock
  */
-static inline void __remove_line_from_waiters_list(struct ocf_cache_concurrency *c,
-	struct ocf_request *req, int i, void *ctx, int rw)
+static inline void __wake_cache_line_waiters(struct ocf_cache_concurrency *c,
+		const ocf_cache_line_t line)
 {
-	ocf_cache_line_t line = req->map[i].coll_idx;
-	uint32_t idx = _WAITERS_LIST_ITEM(line);
+	bool locked;
+	bool remaining = false;
+
+	uint32_t idx = _WAITERS_LIST_ITEM(c, line);
 	struct __waiters_list *lst = &c->waiters_lsts[idx];
-	struct list_head *iter, *next;
 	struct __waiter *waiter;
+
+	struct list_head *iter, *next;
+
+	list_for_each_safe(iter, next, &lst->head) {
+		waiter = list_entry(iter, struct __waiter, item);
+
+		if (line != waiter->line)
+			continue;
+
+		if (__range_conflict(c, line, waiter->rw, true)) {
+			remaining = true;
+			break;
+		}
+
+		if (waiter->rw == OCF_WRITE)
+			locked = __try_lock_wr(c, line);
+		else if (waiter->rw == OCF_READ)
+			locked = __try_lock_rd(c, line);
+		else
+			ENV_BUG();
+
+		if (!locked) {
+			/* Cache line holder hands it over on unlock */
+			remaining = true;
+			break;
+		}
+
+		list_del(iter);
+		waiter->on_lock(waiter->ctx, waiter->ctx_id, line, waiter->rw);
+	}
+
+	if (!remaining)
+		__clear_waiters(c, line);
+}
+
+/*
+ * Release range lock and wake up waiters queued on its cache lines
+ */
+static void __release_range(struct ocf_cache_concurrency *c,
+		struct __range *range)
+{
+	ocf_cache_line_t line, first = range->first, last = range->last;
 	unsigned long flags = 0;
+	bool contended;
 
-	__lock_waiters_list(c, line, flags);
+	env_rwlock_write_lock(&c->ranges_lock);
+	range->used = false;
+	contended = env_atomic_read(&range->contended);
+	env_rwlock_write_unlock(&c->ranges_lock);
+
+	env_atomic_dec(&c->ranges_held);
+
+	if (!contended)
+		return;
+
+	for (line = first; line <= last; line++) {
+		__lock_waiters_list(c, line, flags);
+		__wake_cache_line_waiters(c, line);
+		__unlock_waiters_list(c, line, flags);
+	}
+}
 
-	if (rw == OCF_READ && req->map[i].rd_locked) {
-		__unlock_cache_line_rd_common(c, line);
+/*
+ * Lock all cache lines of request with single range lock. It is possible
+ * only if request is mapped to consecutive cache lines and none of them is
+ * locked in conflicting way or waited for.
+ */
+static bool __lock_range(struct ocf_cache_concurrency *c,
+		struct ocf_request *req, int rw)
+{
+	struct __range *range = NULL;
+	ocf_cache_line_t line, first, last;
+	bool conflict = false;
+	uint32_t i;
+	int v;
+
+	if (req->core_line_count < OCF_CONFIG_RANGE_LOCK_MIN_LINES)
+		return false;
+
+	first = req->map[0].coll_idx;
+	for (i = 0; i < req->core_line_count; i++) {
+		if (req->map[i].status == LOOKUP_MISS)
+			return false;
+		if (req->map[i].coll_idx != first + i)
+			return false;
+	}
+	last = first + req->core_line_count - 1;
+
+	env_rwlock_write_lock(&c->ranges_lock);
+
+	for (i = 0; i < _RANGE_LOCK_SLOTS; i++) {
+		if (!c->ranges[i].used) {
+			if (!range)
+				range = &c->ranges[i];
+			continue;
+		}
+
+		if (c->ranges[i].last < first || c->ranges[i].first > last)
+			continue;
+
+		if (rw == OCF_READ && c->ranges[i].rw == OCF_READ)
+			continue;
+
+		conflict = true;
+		break;
+	}
+
+	if (conflict || !range) {
+		env_rwlock_write_unlock(&c->ranges_lock);
+		return false;
+	}
+
+	range->first = first;
+	range->last = last;
+	range->rw = rw;
+	range->used = true;
+	env_atomic_set(&range->contended, 0);
+
+	env_rwlock_write_unlock(&c->ranges_lock);
+
+	/* From now on cache line lockers see the range, check cache lines
+	 * locked before that
+	 */
+	env_atomic_inc(&c->ranges_held);
+
+	for (line = first; line <= last; line++) {
+		v = env_atomic_read(&c->access[line]);
+
+		if (__access_waiters(v))
+			break;
+
+		if (rw == OCF_WRITE && v != OCF_CACHE_LINE_ACCESS_IDLE)
+			break;
+
+		if (rw == OCF_READ && v == OCF_CACHE_LINE_ACCESS_WR)
+			break;
+	}
+
+	if (line <= last) {
+		/* Lock cache lines one by one */
+		__release_range(c, range);
+		return false;
+	}
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (rw == OCF_READ)
+			req->map[i].rd_locked = true;
+		else
+			req->map[i].wr_locked = true;
+	}
+
+	req->lock_range = range;
+
+	OCF_DEBUG_RQ(req, "Range lock %u-%u", first, last);
+
+	return true;
+}
+
+/*
+ *
+ */
+static void __unlock_range(struct ocf_cache_concurrency *c,
+		struct ocf_request *req)
+{
+	uint32_t i;
+
+	for (i = 0; i < req->core_line_count; i++) {
 		req->map[i].rd_locked = false;
-	} else if (rw == OCF_WRITE && req->map[i].wr_locked) {
-		__unlock_cache_line_wr_common(c, line);
 		req->map[i].wr_locked = false;
-	} else {
-		list_for_each_safe(iter, next, &lst->head) {
-			waiter = list_entry(iter, struct __waiter, item);
-			if (waiter->ctx == ctx) {
-				list_del(iter);
-				env_allocator_del(c->allocator, waiter);
-			}
+	}
+
+	__release_range(c, req->lock_range);
+	req->lock_range = NULL;
+}
+
+/*
+ * Turn range lock of request into cache line locks, so that cache lines can
+ * be unlocked one by one
+ */
+static void __range_to_lines(struct ocf_cache_concurrency *c,
+		struct ocf_request *req)
+{
+	struct __range *range = req->lock_range;
+	env_atomic *access;
+	ocf_cache_line_t line;
+	int v;
+
+	for (line = range->first; line <= range->last; line++) {
+		access = &c->access[line];
+
+		if (range->rw == OCF_READ) {
+			env_atomic_inc(access);
+			continue;
 		}
+
+		do {
+			v = env_atomic_read(access);
+			ENV_BUG_ON(__access_value(v) !=
+					OCF_CACHE_LINE_ACCESS_IDLE);
+		} while (env_atomic_cmpxchg(access, v,
+				__access_waiters(v) |
+				OCF_CACHE_LINE_ACCESS_WR) != v);
 	}
 
-	__unlock_waiters_list(c, line, flags);
+	__release_range(c, range);
+	req->lock_range = NULL;
+}
+#else
+static inline bool __lock_range(struct ocf_cache_concurrency *c,
+		struct ocf_request *req, int rw)
+{
+	return false;
+}
+
+static inline void __unlock_range(struct ocf_cache_concurrency *c,
+		struct ocf_request *req)
+{
+}
+
+static inline void __range_to_lines(struct ocf_cache_concurrency *c,
+		struct ocf_request *req)
+{
+}
+#endif
+
+/*
+ * Allocate waiters of all cache lines of request in single allocation
+ */
+static inline struct __waiter *__req_alloc_waiters(
+		struct ocf_cache_concurrency *c, struct ocf_request *req)
+{
+	size_t size = sizeof(struct __waiter) * req->core_line_count;
+
+	req->lock_waiters = env_malloc(size, ENV_MEM_NOIO);
+	if (!req->lock_waiters)
+		return NULL;
+
+	env_atomic_inc(&c->waiters_allocs);
+	env_atomic64_add(size, &c->waiters_bytes);
+
+	return req->lock_waiters;
+}
+
+/*
+ * Free cache line waiters of request, called once all of them are granted
+ */
+static inline void __req_free_waiters(struct ocf_cache_concurrency *c,
+		struct ocf_request *req)
+{
+	env_atomic_dec(&c->waiters_allocs);
+	env_atomic64_sub(sizeof(struct __waiter) * req->core_line_count,
+			&c->waiters_bytes);
+
+	env_free(req->lock_waiters);
+	req->lock_waiters = NULL;
 }
 
 /*
@@ -671,6 +1182,7 @@ static int _ocf_req_lock_rd_common(struct ocf_request *req, void *context,
 	bool locked, waiting;
 	int32_t i;
 	struct ocf_cache_concurrency *c = req->cache->device->concurrency.cache;
+	struct __waiter *waiters;
 	ocf_cache_line_t line;
 
 	OCF_DEBUG_RQ(req, "Lock");
@@ -681,6 +1193,14 @@ static int _ocf_req_lock_rd_common(struct ocf_request *req, void *context,
 	/* Try lock request without adding waiters */
 
 	env_rwlock_read_lock(&c->lock);
+
+	if (__lock_range(c, req, OCF_READ)) {
+		env_rwlock_read_unlock(&c->lock);
+		ocf_trace_req_stage(req,
+				ocf_event_req_stage_cline_lock_granted, 0);
+		return OCF_LOCK_ACQUIRED;
+	}
+
 	/* At this point we have many thread that tries get lock for request */
 
 	locked = true;
@@ -696,7 +1216,7 @@ static int _ocf_req_lock_rd_common(struct ocf_request *req, void *context,
 		ENV_BUG_ON(req->map[i].rd_locked);
 		ENV_BUG_ON(req->map[i].wr_locked);
 
-		if (__lock_cache_line_rd(c, line, NULL, NULL, 0)) {
+		if (__lock_cache_line_rd(c, line, NULL, NULL, 0, NULL)) {
 			/* cache line locked */
 			req->map[i].rd_locked = true;
 		} else {
@@ -714,7 +1234,7 @@ static int _ocf_req_lock_rd_common(struct ocf_request *req, void *context,
 			line = req->map[i].coll_idx;
 
 			if (req->map[i].rd_locked) {
-				__unlock_rd(c, line);
+				__unlock_cache_line_rd(c, line);
 				req->map[i].rd_locked = false;
 			}
 		}
@@ -724,9 +1244,24 @@ static int _ocf_req_lock_rd_common(struct ocf_request *req, void *context,
 
 	if (locked) {
 		/* Request completely locked, return acquired status */
+		ocf_trace_req_stage(req,
+				ocf_event_req_stage_cline_lock_granted, 0);
 		return OCF_LOCK_ACQUIRED;
 	}
 
+	waiters = __req_alloc_waiters(c, req);
+	if (!waiters)
+		return -ENOMEM;
+
+#if OCF_CONFIG_STATS_LATENCY || OCF_CONFIG_STATS_LOCK
+	req->lock_ticks = env_get_tick_count();
+#endif
+
+	/* Request may be resumed by other thread as soon as cache lines are
+	 * queued for, so it can't be traced after that
+	 */
+	ocf_trace_req_stage(req, ocf_event_req_stage_cline_lock_wait, 0);
+
 	env_atomic_set(&req->lock_remaining, req->core_line_count);
 	env_atomic_inc(&req->lock_remaining);
 
@@ -749,31 +1284,24 @@ static int _ocf_req_lock_rd_common(struct ocf_request *req, void *context,
 		ENV_BUG_ON(req->map[i].rd_locked);
 		ENV_BUG_ON(req->map[i].wr_locked);
 
-		if (!__lock_cache_line_rd(c, line, on_lock, context, i)) {
-			/* lock not acquired and not added to wait list */
-			waiting = false;
-			break;
-		}
-	}
-
-	if (!waiting) {
-		for (; i >= 0; i--)
-			__remove_line_from_waiters_list(c, req, i, context, OCF_READ);
+		waiting = __lock_cache_line_rd(c, line, on_lock, context, i,
+				&waiters[i]);
+		ENV_BUG_ON(!waiting);
 	}
 
 	OCF_DEBUG_RQ(req, "Exclusive END");
 
 	env_rwlock_write_unlock(&c->lock);
 
-	if (env_atomic_dec_return(&req->lock_remaining) == 0)
+	if (env_atomic_dec_return(&req->lock_remaining) == 0) {
+		__req_free_waiters(c, req);
+		ocf_trace_req_stage(req,
+				ocf_event_req_stage_cline_lock_granted, 0);
 		return OCF_LOCK_ACQUIRED;
-
-	if (waiting) {
-		env_atomic_inc(&c->waiting);
-		return OCF_LOCK_NOT_ACQUIRED;
 	}
 
-	return -ENOMEM;
+	env_atomic_inc(&c->waiting);
+	return OCF_LOCK_NOT_ACQUIRED;
 }
 
 /*
@@ -795,8 +1323,18 @@ static void _req_on_lock(void *ctx, uint32_t ctx_id,
 	if (env_atomic_dec_return(&req->lock_remaining) == 0) {
 		/* All cache line locked, resume request */
 		OCF_DEBUG_RQ(req, "Resume");
+		__req_free_waiters(c, req);
+#if OCF_CONFIG_STATS_LATENCY
+		req->lock_wait_ticks += env_get_tick_count() - req->lock_ticks;
+#endif
+#if OCF_CONFIG_STATS_LOCK
+		ocf_stats_lock_contended(&req->cache->lock_counters[
+				ocf_stats_lock_cache_line], req->lock_ticks);
+#endif
 		OCF_CHECK_NULL(req->resume);
 		env_atomic_dec(&c->waiting);
+		ocf_trace_req_stage(req,
+				ocf_event_req_stage_cline_lock_granted, 0);
 		req->resume(req);
 	}
 }
@@ -807,6 +1345,7 @@ static void _req_on_lock(void *ctx, uint32_t ctx_id,
 int ocf_req_trylock_rd(struct ocf_request *req)
 {
 	OCF_CHECK_NULL(req->resume);
+	req->hash_gen = ocf_req_hash_gen(req);
 	return _ocf_req_lock_rd_common(req, req, _req_on_lock);
 }
 
@@ -819,6 +1358,7 @@ static int _ocf_req_lock_wr_common(struct ocf_request *req, void *context,
 	bool locked, waiting;
 	int32_t i;
 	struct ocf_cache_concurrency *c = req->cache->device->concurrency.cache;
+	struct __waiter *waiters;
 	ocf_cache_line_t line;
 
 	OCF_DEBUG_RQ(req, "Lock");
@@ -828,6 +1368,14 @@ static int _ocf_req_lock_wr_common(struct ocf_request *req, void *context,
 	/* Try lock request without adding waiters */
 
 	env_rwlock_read_lock(&c->lock);
+
+	if (__lock_range(c, req, OCF_WRITE)) {
+		env_rwlock_read_unlock(&c->lock);
+		ocf_trace_req_stage(req,
+				ocf_event_req_stage_cline_lock_granted, 0);
+		return OCF_LOCK_ACQUIRED;
+	}
+
 	/* At this point many thread that tries getting lock for request */
 
 	locked = true;
@@ -843,7 +1391,7 @@ static int _ocf_req_lock_wr_common(struct ocf_request *req, void *context,
 		ENV_BUG_ON(req->map[i].rd_locked);
 		ENV_BUG_ON(req->map[i].wr_locked);
 
-		if (__lock_cache_line_wr(c, line, NULL, NULL, 0)) {
+		if (__lock_cache_line_wr(c, line, NULL, NULL, 0, NULL)) {
 			/* cache line locked */
 			req->map[i].wr_locked = true;
 		} else {
@@ -861,7 +1409,7 @@ static int _ocf_req_lock_wr_common(struct ocf_request *req, void *context,
 			line = req->map[i].coll_idx;
 
 			if (req->map[i].wr_locked) {
-				__unlock_wr(c, line);
+				__unlock_cache_line_wr(c, line);
 				req->map[i].wr_locked = false;
 			}
 		}
@@ -871,9 +1419,24 @@ static int _ocf_req_lock_wr_common(struct ocf_request *req, void *context,
 
 	if (locked) {
 		/* Request completely locked, return acquired status */
+		ocf_trace_req_stage(req,
+				ocf_event_req_stage_cline_lock_granted, 0);
 		return OCF_LOCK_ACQUIRED;
 	}
 
+	waiters = __req_alloc_waiters(c, req);
+	if (!waiters)
+		return -ENOMEM;
+
+#if OCF_CONFIG_STATS_LATENCY || OCF_CONFIG_STATS_LOCK
+	req->lock_ticks = env_get_tick_count();
+#endif
+
+	/* Request may be resumed by other thread as soon as cache lines are
+	 * queued for, so it can't be traced after that
+	 */
+	ocf_trace_req_stage(req, ocf_event_req_stage_cline_lock_wait, 0);
+
 	env_atomic_set(&req->lock_remaining, req->core_line_count);
 	env_atomic_inc(&req->lock_remaining);
 
@@ -896,31 +1459,24 @@ static int _ocf_req_lock_wr_common(struct ocf_request *req, void *context,
 		ENV_BUG_ON(req->map[i].rd_locked);
 		ENV_BUG_ON(req->map[i].wr_locked);
 
-		if (!__lock_cache_line_wr(c, line, on_lock, context, i)) {
-			/* lock not acquired and not added to wait list */
-			waiting = false;
-			break;
-		}
-	}
-
-	if (!waiting) {
-		for (; i >= 0; i--)
-			__remove_line_from_waiters_list(c, req, i, context, OCF_WRITE);
+		waiting = __lock_cache_line_wr(c, line, on_lock, context, i,
+				&waiters[i]);
+		ENV_BUG_ON(!waiting);
 	}
 
 	OCF_DEBUG_RQ(req, "Exclusive END");
 
 	env_rwlock_write_unlock(&c->lock);
 
-	if (env_atomic_dec_return(&req->lock_remaining) == 0)
+	if (env_atomic_dec_return(&req->lock_remaining) == 0) {
+		__req_free_waiters(c, req);
+		ocf_trace_req_stage(req,
+				ocf_event_req_stage_cline_lock_granted, 0);
 		return OCF_LOCK_ACQUIRED;
-
-	if (waiting) {
-		env_atomic_inc(&c->waiting);
-		return OCF_LOCK_NOT_ACQUIRED;
 	}
 
-	return -ENOMEM;
+	env_atomic_inc(&c->waiting);
+	return OCF_LOCK_NOT_ACQUIRED;
 }
 
 /*
@@ -929,6 +1485,7 @@ static int _ocf_req_lock_wr_common(struct ocf_request *req, void *context,
 int ocf_req_trylock_wr(struct ocf_request *req)
 {
 	OCF_CHECK_NULL(req->resume);
+	req->hash_gen = ocf_req_hash_gen(req);
 	return _ocf_req_lock_wr_common(req, req, _req_on_lock);
 }
 
@@ -943,6 +1500,11 @@ void ocf_req_unlock_rd(struct ocf_request *req)
 
 	OCF_DEBUG_RQ(req, "Unlock");
 
+	if (req->lock_range) {
+		__unlock_range(c, req);
+		return;
+	}
+
 	for (i = 0; i < req->core_line_count; i++) {
 
 		if (req->map[i].status == LOOKUP_MISS) {
@@ -971,6 +1533,11 @@ void ocf_req_unlock_wr(struct ocf_request *req)
 
 	OCF_DEBUG_RQ(req, "Unlock");
 
+	if (req->lock_range) {
+		__unlock_range(c, req);
+		return;
+	}
+
 	for (i = 0; i < req->core_line_count; i++) {
 
 		if (req->map[i].status == LOOKUP_MISS) {
@@ -999,6 +1566,11 @@ void ocf_req_unlock(struct ocf_request *req)
 
 	OCF_DEBUG_RQ(req, "Unlock");
 
+	if (req->lock_range) {
+		__unlock_range(c, req);
+		return;
+	}
+
 	for (i = 0; i < req->core_line_count; i++) {
 
 		if (req->map[i].status == LOOKUP_MISS) {
@@ -1033,6 +1605,9 @@ void ocf_req_unlock_entry(struct ocf_cache *cache,
 
 	ENV_BUG_ON(req->map[entry].status == LOOKUP_MISS);
 
+	if (req->lock_range)
+		__range_to_lines(c, req);
+
 	if (req->map[entry].rd_locked && req->map[entry].wr_locked) {
 		ENV_BUG();
 	} else if (req->map[entry].rd_locked) {
@@ -1059,6 +1634,9 @@ bool ocf_cache_line_is_used(struct ocf_cache *cache,
 	if (env_atomic_read(&(c->access[line])))
 		return true;
 
+	if (__range_conflict(c, line, OCF_WRITE, false))
+		return true;
+
 	if (ocf_cache_line_are_waiters(cache, line))
 		return true;
 	else
@@ -1097,10 +1675,28 @@ uint32_t ocf_cache_concurrency_suspended_no(struct ocf_cache *cache)
 	return env_atomic_read(&c->waiting);
 }
 
+#if OCF_CONFIG_STATS_LOCK
+uint64_t ocf_cache_concurrency_waiters_total(struct ocf_cache *cache)
+{
+	struct ocf_cache_concurrency *c = cache->device->concurrency.cache;
+
+	return env_atomic64_read(&c->waiters_total);
+}
+#endif
+
+void ocf_cache_concurrency_waiters_usage(struct ocf_cache *cache,
+		uint32_t *allocs, uint64_t *bytes)
+{
+	struct ocf_cache_concurrency *c = cache->device->concurrency.cache;
+
+	*allocs = env_atomic_read(&c->waiters_allocs);
+	*bytes = env_atomic64_read(&c->waiters_bytes);
+}
+
 bool ocf_cache_line_try_lock_rd(struct ocf_cache *cache, ocf_cache_line_t line)
 {
 	struct ocf_cache_concurrency *c = cache->device->concurrency.cache;
-	return __lock_cache_line_rd(c, line, NULL, NULL, 0);
+	return __lock_cache_line_rd(c, line, NULL, NULL, 0, NULL);
 }
 
 /*
@@ -41,6 +41,27 @@ void ocf_cache_concurrency_deinit(struct ocf_cache *cache);
  */
 uint32_t ocf_cache_concurrency_suspended_no(struct ocf_cache *cache);
 
+#if OCF_CONFIG_STATS_LOCK
+/**
+ * @brief Get number of cache line waiters added since cache was attached
+ *
+ * @param cache - OCF cache instance
+ *
+ * @return Cumulative number of cache line waiters
+ */
+uint64_t ocf_cache_concurrency_waiters_total(struct ocf_cache *cache);
+#endif
+
+/**
+ * @brief Get memory of cache line waiters currently allocated by requests
+ *
+ * @param cache - OCF cache instance
+ * @param allocs - Number of waiter allocations
+ * @param bytes - Size of waiter allocations in bytes
+ */
+void ocf_cache_concurrency_waiters_usage(struct ocf_cache *cache,
+		uint32_t *allocs, uint64_t *bytes);
+
 /**
  * @brief Return memory footprint conusmed by cache concurrency module
  *
@@ -50,6 +71,16 @@ uint32_t ocf_cache_concurrency_suspended_no(struct ocf_cache *cache);
  */
 size_t ocf_cache_concurrency_size_of(struct ocf_cache *cache);
 
+/**
+ * @brief Return memory footprint of cache concurrency module for cache with
+ *	given number of cache lines
+ *
+ * @param entries - Number of cache lines
+ *
+ * @return Memory footprint of cache concurrency module
+ */
+size_t ocf_cache_concurrency_size_for(ocf_cache_line_t entries);
+
 /**
  * @brief Lock OCF request for WRITE access (Lock all cache lines in map info)
  *
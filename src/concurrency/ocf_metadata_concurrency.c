@@ -0,0 +1,233 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf_concurrency.h"
+#include "../ocf_priv.h"
+#include "../ocf_request.h"
+#include "../metadata/metadata.h"
+
+#define _HASH_LOCK_ID(hash) ((hash) % OCF_METADATA_HASH_LOCKS)
+
+#define _HASH_LOCK_MAP_BITS	(sizeof(uint64_t) * 8)
+#define _HASH_LOCK_MAP_WORDS	((OCF_METADATA_HASH_LOCKS + \
+		_HASH_LOCK_MAP_BITS - 1) / _HASH_LOCK_MAP_BITS)
+
+/*
+ * Set of lock stripes used by a request, iterated in ascending order so
+ * that requests sharing more than one stripe never deadlock one another
+ */
+struct _hash_lock_map {
+	uint64_t bits[_HASH_LOCK_MAP_WORDS];
+};
+
+int ocf_metadata_concurrency_attached_init(struct ocf_cache *cache)
+{
+	struct ocf_metadata_lock *lock = &cache->metadata.lock;
+	uint32_t i;
+
+	ENV_BUG_ON(lock->hash);
+
+	lock->hash = env_vzalloc(sizeof(*lock->hash) * OCF_METADATA_HASH_LOCKS);
+	if (!lock->hash) {
+		ocf_cache_log(cache, log_err, "Cannot initialize metadata "
+				"hash bucket locks\n");
+		return -OCF_ERR_NO_MEM;
+	}
+
+	lock->hash_gen = env_vzalloc(sizeof(*lock->hash_gen) *
+			OCF_METADATA_HASH_LOCKS);
+	if (!lock->hash_gen) {
+		env_vfree(lock->hash);
+		lock->hash = NULL;
+		ocf_cache_log(cache, log_err, "Cannot initialize metadata "
+				"hash bucket generations\n");
+		return -OCF_ERR_NO_MEM;
+	}
+
+	for (i = 0; i < OCF_METADATA_HASH_LOCKS; i++)
+		env_rwsem_init(&lock->hash[i]);
+
+	return 0;
+}
+
+void ocf_metadata_concurrency_attached_deinit(struct ocf_cache *cache)
+{
+	struct ocf_metadata_lock *lock = &cache->metadata.lock;
+
+	if (!lock->hash)
+		return;
+
+	env_vfree(lock->hash_gen);
+	lock->hash_gen = NULL;
+
+	env_vfree(lock->hash);
+	lock->hash = NULL;
+}
+
+void ocf_metadata_hash_gen_inc(struct ocf_cache *cache, ocf_cache_line_t hash)
+{
+	env_atomic_inc(&cache->metadata.lock.hash_gen[_HASH_LOCK_ID(hash)]);
+}
+
+uint32_t ocf_req_hash_gen(struct ocf_request *req)
+{
+	env_atomic *gen = req->cache->metadata.lock.hash_gen;
+	uint32_t i, sum = 0;
+
+	for (i = 0; i < req->core_line_count; i++)
+		sum += env_atomic_read(&gen[_HASH_LOCK_ID(req->map[i].hash_key)]);
+
+	return sum;
+}
+
+static inline void _ocf_hash_lock(struct ocf_cache *cache, uint32_t id,
+		int rw)
+{
+	env_rwsem *sem = &cache->metadata.lock.hash[id];
+
+	if (rw == OCF_METADATA_WR)
+		env_rwsem_down_write(sem);
+	else if (rw == OCF_METADATA_RD)
+		env_rwsem_down_read(sem);
+	else
+		ENV_BUG();
+}
+
+static inline void _ocf_hash_unlock(struct ocf_cache *cache, uint32_t id,
+		int rw)
+{
+	env_rwsem *sem = &cache->metadata.lock.hash[id];
+
+	if (rw == OCF_METADATA_WR)
+		env_rwsem_up_write(sem);
+	else if (rw == OCF_METADATA_RD)
+		env_rwsem_up_read(sem);
+	else
+		ENV_BUG();
+}
+
+void ocf_metadata_hash_lock_rd(struct ocf_cache *cache, ocf_cache_line_t hash)
+{
+	ocf_metadata_lock(cache, OCF_METADATA_RD);
+	_ocf_hash_lock(cache, _HASH_LOCK_ID(hash), OCF_METADATA_RD);
+}
+
+void ocf_metadata_hash_unlock_rd(struct ocf_cache *cache,
+		ocf_cache_line_t hash)
+{
+	_ocf_hash_unlock(cache, _HASH_LOCK_ID(hash), OCF_METADATA_RD);
+	ocf_metadata_unlock(cache, OCF_METADATA_RD);
+}
+
+static void _ocf_req_hash_map(struct ocf_request *req,
+		struct _hash_lock_map *map)
+{
+	uint32_t i, id;
+
+	ENV_BUG_ON(env_memset(map, sizeof(*map), 0));
+
+	for (i = 0; i < req->core_line_count; i++) {
+		id = _HASH_LOCK_ID(req->map[i].hash_key);
+		map->bits[id / _HASH_LOCK_MAP_BITS] |=
+				1ULL << (id % _HASH_LOCK_MAP_BITS);
+	}
+}
+
+static void _ocf_req_hash_lock(struct ocf_request *req, int rw, bool global)
+{
+	struct ocf_cache *cache = req->cache;
+	struct _hash_lock_map map;
+	uint64_t core_line;
+	uint32_t i, j;
+
+	/* Hash keys are needed before the lookup so compute them here */
+	for (i = 0, core_line = req->core_line_first;
+			core_line <= req->core_line_last; core_line++, i++) {
+		req->map[i].hash_key = ocf_metadata_hash_func(cache,
+				core_line, req->core_id);
+	}
+
+	if (global)
+		ocf_metadata_lock(cache, OCF_METADATA_RD);
+
+	if (req->core_line_count == 1) {
+		_ocf_hash_lock(cache, _HASH_LOCK_ID(req->map[0].hash_key), rw);
+		return;
+	}
+
+	_ocf_req_hash_map(req, &map);
+
+	for (i = 0; i < _HASH_LOCK_MAP_WORDS; i++) {
+		if (!map.bits[i])
+			continue;
+
+		for (j = 0; j < _HASH_LOCK_MAP_BITS; j++) {
+			if (map.bits[i] & (1ULL << j))
+				_ocf_hash_lock(cache, i * _HASH_LOCK_MAP_BITS + j,
+						rw);
+		}
+	}
+}
+
+static void _ocf_req_hash_unlock(struct ocf_request *req, int rw,
+		bool global)
+{
+	struct ocf_cache *cache = req->cache;
+	struct _hash_lock_map map;
+	uint32_t i, j;
+
+	if (req->core_line_count == 1) {
+		_ocf_hash_unlock(cache, _HASH_LOCK_ID(req->map[0].hash_key),
+				rw);
+	} else {
+		_ocf_req_hash_map(req, &map);
+
+		for (i = 0; i < _HASH_LOCK_MAP_WORDS; i++) {
+			if (!map.bits[i])
+				continue;
+
+			for (j = 0; j < _HASH_LOCK_MAP_BITS; j++) {
+				if (map.bits[i] & (1ULL << j)) {
+					_ocf_hash_unlock(cache,
+						i * _HASH_LOCK_MAP_BITS + j,
+						rw);
+				}
+			}
+		}
+	}
+
+	if (global)
+		ocf_metadata_unlock(cache, OCF_METADATA_RD);
+}
+
+void ocf_req_hash_lock_rd(struct ocf_request *req)
+{
+	_ocf_req_hash_lock(req, OCF_METADATA_RD, true);
+}
+
+void ocf_req_hash_unlock_rd(struct ocf_request *req)
+{
+	_ocf_req_hash_unlock(req, OCF_METADATA_RD, true);
+}
+
+void ocf_req_hash_lock_rd_nested(struct ocf_request *req)
+{
+	_ocf_req_hash_lock(req, OCF_METADATA_RD, false);
+}
+
+void ocf_req_hash_unlock_rd_nested(struct ocf_request *req)
+{
+	_ocf_req_hash_unlock(req, OCF_METADATA_RD, false);
+}
+
+void ocf_req_hash_lock_wr(struct ocf_request *req)
+{
+	_ocf_req_hash_lock(req, OCF_METADATA_WR, true);
+}
+
+void ocf_req_hash_unlock_wr(struct ocf_request *req)
+{
+	_ocf_req_hash_unlock(req, OCF_METADATA_WR, true);
+}
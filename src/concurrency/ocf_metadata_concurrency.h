@@ -0,0 +1,133 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef OCF_METADATA_CONCURRENCY_H_
+#define OCF_METADATA_CONCURRENCY_H_
+
+/**
+ * @file ocf_metadata_concurrency.h
+ * @brief OCF metadata hash bucket concurrency module
+ *
+ * Lookup and mapping of cache lines are protected by locks striped over
+ * metadata hash buckets, taken on top of shared access to the global metadata
+ * lock. Operations touching arbitrary hash buckets (eviction, partition move,
+ * management) still take the global metadata lock for exclusive access.
+ */
+
+/**
+ * @brief Number of hash bucket lock stripes
+ */
+#define OCF_METADATA_HASH_LOCKS 4096
+
+/**
+ * @brief Initialize hash bucket locks of attached cache
+ *
+ * @param cache - OCF cache instance
+ * @return 0 - Initialization successful, otherwise ERROR
+ */
+int ocf_metadata_concurrency_attached_init(struct ocf_cache *cache);
+
+/**
+ * @brief De-Initialize hash bucket locks of attached cache
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_metadata_concurrency_attached_deinit(struct ocf_cache *cache);
+
+/**
+ * @brief Lock single hash bucket for READ access
+ *
+ * @note Shared access to global metadata lock is acquired as well
+ *
+ * @param cache - OCF cache instance
+ * @param hash - Hash bucket index
+ */
+void ocf_metadata_hash_lock_rd(struct ocf_cache *cache, ocf_cache_line_t hash);
+
+/**
+ * @brief Unlock single hash bucket locked for READ access
+ *
+ * @param cache - OCF cache instance
+ * @param hash - Hash bucket index
+ */
+void ocf_metadata_hash_unlock_rd(struct ocf_cache *cache,
+		ocf_cache_line_t hash);
+
+/**
+ * @brief Lock all hash buckets of OCF request for READ access
+ *
+ * @note Hash buckets are locked in ascending order of lock stripe
+ * @note Shared access to global metadata lock is acquired as well
+ *
+ * @param req - OCF request
+ */
+void ocf_req_hash_lock_rd(struct ocf_request *req);
+
+/**
+ * @brief Unlock all hash buckets of OCF request locked for READ access
+ *
+ * @param req - OCF request
+ */
+void ocf_req_hash_unlock_rd(struct ocf_request *req);
+
+/**
+ * @brief Lock all hash buckets of OCF request for READ access, with shared
+ *	access to global metadata lock already held by caller
+ *
+ * @note Hash buckets are locked in ascending order of lock stripe
+ *
+ * @param req - OCF request
+ */
+void ocf_req_hash_lock_rd_nested(struct ocf_request *req);
+
+/**
+ * @brief Unlock all hash buckets of OCF request locked with
+ *	ocf_req_hash_lock_rd_nested()
+ *
+ * @param req - OCF request
+ */
+void ocf_req_hash_unlock_rd_nested(struct ocf_request *req);
+
+/**
+ * @brief Lock all hash buckets of OCF request for WRITE access
+ *
+ * @note Hash buckets are locked in ascending order of lock stripe
+ * @note Shared access to global metadata lock is acquired as well
+ *
+ * @param req - OCF request
+ */
+void ocf_req_hash_lock_wr(struct ocf_request *req);
+
+/**
+ * @brief Unlock all hash buckets of OCF request locked for WRITE access
+ *
+ * @param req - OCF request
+ */
+void ocf_req_hash_unlock_wr(struct ocf_request *req);
+
+/**
+ * @brief Note change of mapping in hash bucket
+ *
+ * Called whenever cache line is added to or removed from collision list of
+ * hash bucket, with the hash bucket locked for WRITE access.
+ *
+ * @param cache - OCF cache instance
+ * @param hash - Hash bucket index
+ */
+void ocf_metadata_hash_gen_inc(struct ocf_cache *cache, ocf_cache_line_t hash);
+
+/**
+ * @brief Get mapping generation of all hash buckets of OCF request
+ *
+ * Generation is the same as long as no cache line was added to or removed
+ * from any hash bucket lock stripe of the request, so request which saw
+ * the same generation before and after waiting needs no fresh lookup.
+ *
+ * @param req - OCF request
+ * @return Sum of generations of hash bucket lock stripes of request
+ */
+uint32_t ocf_req_hash_gen(struct ocf_request *req);
+
+#endif /* OCF_METADATA_CONCURRENCY_H_ */
@@ -19,9 +19,12 @@
 #include "engine_discard.h"
 #include "engine_d2c.h"
 #include "engine_ops.h"
+#include "engine_prefetch.h"
+#include "../utils/utils_mode_advisor.h"
 #include "../utils/utils_part.h"
 #include "../utils/utils_refcnt.h"
 #include "../utils/utils_req.h"
+#include "../utils/utils_cache_line.h"
 #include "../metadata/metadata.h"
 #include "../eviction/eviction.h"
 
@@ -36,6 +39,7 @@ enum ocf_io_if_type {
 
 	/* Private OCF interfaces */
 	OCF_IO_FAST_IF,
+	OCF_IO_FAST_WT_IF,
 	OCF_IO_DISCARD_IF,
 	OCF_IO_D2C_IF,
 	OCF_IO_OPS_IF,
@@ -73,6 +77,11 @@ static const struct ocf_io_if IO_IFS[OCF_IO_PRIV_MAX_IF] = {
 		.write = ocf_write_fast,
 		.name = "Fast",
 	},
+	[OCF_IO_FAST_WT_IF] = {
+		.read = ocf_read_fast,
+		.write = ocf_write_wt_fast,
+		.name = "Fast Write Through",
+	},
 	[OCF_IO_DISCARD_IF] = {
 		.read = ocf_discard,
 		.write = ocf_discard,
@@ -97,6 +106,7 @@ static const struct ocf_io_if *cache_mode_io_if_map[ocf_req_cache_mode_max] = {
 	[ocf_req_cache_mode_wi] = &IO_IFS[OCF_IO_WI_IF],
 	[ocf_req_cache_mode_pt] = &IO_IFS[OCF_IO_PT_IF],
 	[ocf_req_cache_mode_fast] = &IO_IFS[OCF_IO_FAST_IF],
+	[ocf_req_cache_mode_fast_wt] = &IO_IFS[OCF_IO_FAST_WT_IF],
 	[ocf_req_cache_mode_d2c] = &IO_IFS[OCF_IO_D2C_IF],
 };
 
@@ -109,15 +119,26 @@ const struct ocf_io_if *ocf_get_io_if(ocf_req_cache_mode_t req_cache_mode)
 
 struct ocf_request *ocf_engine_pop_req(ocf_cache_t cache, ocf_queue_t q)
 {
+#if OCF_CONFIG_QUEUE_LOCKLESS != 1
 	unsigned long lock_flags = 0;
+#endif
 	struct ocf_request *req;
+#if OCF_CONFIG_QUEUE_LOCKLESS != 1
+	struct list_head *list;
+#endif
 
 	OCF_CHECK_NULL(q);
 
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+	req = ocf_queue_pop_req_lockless(q);
+	if (!req)
+		return NULL;
+#else
 	/* LOCK */
 	env_spinlock_lock_irqsave(&q->io_list_lock, lock_flags);
 
-	if (list_empty(&q->io_list)) {
+	list = ocf_queue_pick_list(q);
+	if (!list) {
 		/* No items on the list */
 		env_spinlock_unlock_irqrestore(&q->io_list_lock,
 				lock_flags);
@@ -125,13 +146,14 @@ struct ocf_request *ocf_engine_pop_req(ocf_cache_t cache, ocf_queue_t q)
 	}
 
 	/* Get the first request and remove it from the list */
-	req = list_first_entry(&q->io_list, struct ocf_request, list);
+	req = list_first_entry(list, struct ocf_request, list);
 
 	env_atomic_dec(&q->io_no);
 	list_del(&req->list);
 
 	/* UNLOCK */
 	env_spinlock_unlock_irqrestore(&q->io_list_lock, lock_flags);
+#endif
 
 	OCF_CHECK_NULL(req);
 
@@ -164,20 +186,49 @@ static inline bool ocf_seq_cutoff_is_on(ocf_cache_t cache)
 	return (cache->device->freelist_part->curr_size <= SEQ_CUTOFF_FULL_MARGIN);
 }
 
-bool ocf_seq_cutoff_check(ocf_core_t core, uint32_t dir, uint64_t addr,
-		uint64_t bytes)
+void ocf_seq_cutoff_init(ocf_core_t core)
 {
-	ocf_cache_t cache = ocf_core_get_cache(core);
+	int i;
+
+	for (i = 0; i < OCF_SEQ_CUTOFF_SHARDS; i++)
+		env_spinlock_init(&core->seq_cutoff[i].lock);
+}
+
+static inline struct ocf_seq_cutoff_shard *ocf_seq_cutoff_shard(
+		ocf_core_t core, ocf_queue_t queue)
+{
+	return &core->seq_cutoff[queue->id % OCF_SEQ_CUTOFF_SHARDS];
+}
+
+/*
+ * Find stream continued by I/O at given position, caller has to hold shard
+ * lock
+ */
+static struct ocf_seq_cutoff_stream *ocf_seq_cutoff_find(
+		struct ocf_seq_cutoff_shard *shard, uint32_t dir, uint64_t addr)
+{
+	struct ocf_seq_cutoff_stream *stream;
+	int i;
+
+	for (i = 0; i < OCF_SEQ_CUTOFF_SHARD_STREAMS; i++) {
+		stream = &shard->streams[i];
+		if (stream->bytes && stream->rw == dir && stream->last == addr)
+			return stream;
+	}
 
-	ocf_seq_cutoff_policy policy = ocf_core_get_seq_cutoff_policy(core);
+	return NULL;
+}
 
-	switch (policy) {
+static bool ocf_seq_cutoff_policy_on(ocf_core_t core)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+
+	switch (ocf_core_get_seq_cutoff_policy(core)) {
 	case ocf_seq_cutoff_policy_always:
-		break;
+		return true;
 
 	case ocf_seq_cutoff_policy_full:
-		if (ocf_seq_cutoff_is_on(cache))
-			break;
+		return ocf_seq_cutoff_is_on(cache);
 
 	case ocf_seq_cutoff_policy_never:
 		return false;
@@ -185,73 +236,194 @@ bool ocf_seq_cutoff_check(ocf_core_t core, uint32_t dir, uint64_t addr,
 		ENV_WARN(true, "Invalid sequential cutoff policy!");
 		return false;
 	}
+}
 
-	if (dir == core->seq_cutoff.rw &&
-			core->seq_cutoff.last == addr &&
-			core->seq_cutoff.bytes + bytes >=
+bool ocf_seq_cutoff_check(ocf_core_t core, ocf_queue_t queue, uint32_t dir,
+		uint64_t addr, uint64_t bytes)
+{
+	struct ocf_seq_cutoff_shard *shard;
+	struct ocf_seq_cutoff_stream *stream;
+	unsigned long flags = 0;
+	bool result = false;
+
+	if (!ocf_seq_cutoff_policy_on(core))
+		return false;
+
+	shard = ocf_seq_cutoff_shard(core, queue);
+
+	env_spinlock_lock_irqsave(&shard->lock, flags);
+
+	stream = ocf_seq_cutoff_find(shard, dir, addr);
+	if (stream && stream->bytes + bytes >=
 			ocf_core_get_seq_cutoff_threshold(core)) {
-		return true;
+		result = true;
 	}
 
-	return false;
+	env_spinlock_unlock_irqrestore(&shard->lock, flags);
+
+	return result;
 }
 
-void ocf_seq_cutoff_update(ocf_core_t core, struct ocf_request *req)
+/*
+ * Get range to be read ahead of sequential read stream, caller has to hold
+ * shard lock. Next part of read-ahead window is requested once stream
+ * consumed half of it. Streams which are cut off are not read ahead.
+ */
+static uint64_t ocf_seq_cutoff_prefetch(ocf_core_t core,
+		struct ocf_seq_cutoff_stream *stream, struct ocf_request *req,
+		uint64_t *addr)
 {
-	/*
-	 * If IO is not consequent or has another direction,
-	 * reset sequential cutoff state.
-	 */
-	if (req->byte_position != core->seq_cutoff.last ||
-			req->rw != core->seq_cutoff.rw) {
-		core->seq_cutoff.rw = req->rw;
-		core->seq_cutoff.bytes = 0;
+	uint64_t line_size = ocf_line_size(req->cache);
+	uint64_t window = (uint64_t)core->prefetch_lines * line_size;
+	uint64_t start, end;
+
+	if (!window || req->rw != OCF_READ || stream->bytes == req->byte_length)
+		return 0;
+
+	if (stream->bytes >= ocf_core_get_seq_cutoff_threshold(core) &&
+			ocf_seq_cutoff_policy_on(core)) {
+		return 0;
+	}
+
+	start = OCF_DIV_ROUND_UP(stream->last, line_size) * line_size;
+	if (stream->prefetch < start)
+		stream->prefetch = start;
+
+	if (stream->prefetch - start >= window / 2)
+		return 0;
+
+	end = OCF_MIN(start + window, ocf_volume_get_length(&core->volume));
+	if (end <= stream->prefetch)
+		return 0;
+
+	*addr = stream->prefetch;
+	stream->prefetch = end;
+
+	return end - *addr;
+}
+
+/*
+ * Account I/O in sequential stream it continues. Stream of request may be
+ * read ahead, I/O submitted without request (req == NULL) is not.
+ */
+static void _ocf_seq_cutoff_update(ocf_core_t core, ocf_queue_t queue,
+		int rw, uint64_t addr, uint32_t bytes, struct ocf_request *req)
+{
+	struct ocf_seq_cutoff_shard *shard;
+	struct ocf_seq_cutoff_stream *stream;
+	unsigned long flags = 0;
+	uint64_t prefetch_addr = 0, prefetch_bytes = 0;
+	int i;
+
+	shard = ocf_seq_cutoff_shard(core, queue);
+
+	env_spinlock_lock_irqsave(&shard->lock, flags);
+
+	stream = ocf_seq_cutoff_find(shard, rw, addr);
+	if (!stream) {
+		/*
+		 * IO doesn't continue any tracked stream, start new stream
+		 * in place of least recently used one
+		 */
+		stream = &shard->streams[0];
+		for (i = 1; i < OCF_SEQ_CUTOFF_SHARD_STREAMS; i++) {
+			if ((int32_t)(shard->streams[i].stamp -
+					stream->stamp) < 0) {
+				stream = &shard->streams[i];
+			}
+		}
+
+		stream->rw = rw;
+		stream->bytes = 0;
+		stream->prefetch = 0;
 	}
 
 	/* Update last accessed position and bytes counter */
-	core->seq_cutoff.last = req->byte_position + req->byte_length;
-	core->seq_cutoff.bytes += req->byte_length;
+	stream->last = addr + bytes;
+	stream->bytes += bytes;
+	stream->stamp = ++shard->stamp;
+
+	if (req) {
+		prefetch_bytes = ocf_seq_cutoff_prefetch(core, stream, req,
+				&prefetch_addr);
+	}
+
+	env_spinlock_unlock_irqrestore(&shard->lock, flags);
+
+	if (prefetch_bytes)
+		ocf_engine_prefetch(req, prefetch_addr, prefetch_bytes);
 }
 
-ocf_cache_mode_t ocf_get_effective_cache_mode(ocf_cache_t cache,
-		ocf_core_t core, struct ocf_io *io)
+void ocf_seq_cutoff_update(ocf_core_t core, struct ocf_request *req)
 {
-	ocf_cache_mode_t mode;
+	_ocf_seq_cutoff_update(core, req->io_queue, req->rw,
+			req->byte_position, req->byte_length, req);
+}
 
-	if (cache->pt_unaligned_io && !ocf_req_is_4k(io->addr, io->bytes))
+void ocf_seq_cutoff_update_io(ocf_core_t core, struct ocf_io *io)
+{
+	_ocf_seq_cutoff_update(core, io->io_queue, io->dir, io->addr,
+			io->bytes, NULL);
+}
+
+ocf_cache_mode_t ocf_get_class_cache_mode(ocf_cache_t cache,
+		ocf_core_t core, uint32_t io_class)
+{
+	ocf_cache_mode_t mode, advised;
+
+	/* Degraded cache serves everything in PT, so don't bother with
+	 * partition lookup and sequential stream search under shard lock
+	 */
+	if (ocf_fallback_pt_is_on(cache))
 		return ocf_cache_mode_pt;
 
-	mode = ocf_part_get_cache_mode(cache,
-			ocf_part_class2id(cache, io->io_class));
-	if (!ocf_cache_mode_is_valid(mode))
+	mode = ocf_part_class_cache_mode(cache, io_class);
+	if (!ocf_cache_mode_is_valid(mode)) {
 		mode = cache->conf_meta->cache_mode;
 
-	if (ocf_seq_cutoff_check(core, io->dir, io->addr, io->bytes))
-		mode = ocf_cache_mode_pt;
-
-	if (ocf_fallback_pt_is_on(cache))
-		mode = ocf_cache_mode_pt;
+		/* Advised mode replaces cache mode, unless cache is in PT */
+		advised = ocf_mode_advisor_get(core);
+		if (advised != ocf_cache_mode_none &&
+				mode != ocf_cache_mode_pt) {
+			mode = advised;
+		}
+	}
 
 	return mode;
 }
 
-int ocf_engine_hndl_req(struct ocf_request *req,
-		ocf_req_cache_mode_t req_cache_mode)
+ocf_cache_mode_t ocf_get_io_cache_mode(ocf_cache_t cache, ocf_core_t core,
+		struct ocf_io *io, ocf_cache_mode_t class_mode)
 {
-	ocf_cache_t cache = req->cache;
+	if (class_mode == ocf_cache_mode_pt)
+		return class_mode;
 
-	OCF_CHECK_NULL(cache);
+	if (cache->pt_unaligned_io && !ocf_req_is_4k(io->addr, io->bytes))
+		return ocf_cache_mode_pt;
+
+	if (ocf_seq_cutoff_check(core, io->io_queue, io->dir, io->addr,
+			io->bytes))
+		return ocf_cache_mode_pt;
+
+	return class_mode;
+}
+
+ocf_cache_mode_t ocf_get_effective_cache_mode(ocf_cache_t cache,
+		ocf_core_t core, struct ocf_io *io)
+{
+	return ocf_get_io_cache_mode(cache, core, io,
+			ocf_get_class_cache_mode(cache, core, io->io_class));
+}
+
+int ocf_engine_prepare_req(struct ocf_request *req,
+		ocf_req_cache_mode_t req_cache_mode)
+{
+	OCF_CHECK_NULL(req->cache);
 
 	req->io_if = ocf_get_io_if(req_cache_mode);
 	if (!req->io_if)
 		return -EINVAL;
 
-	/* Till OCF engine is not synchronous fully need to push OCF request
-	 * to into OCF workers
-	 */
-
-	ocf_engine_push_req_back(req, true);
-
 	return 0;
 }
 
@@ -24,6 +24,8 @@ typedef enum {
 	/* internal modes */
 	ocf_req_cache_mode_fast,
 		/*!< Fast path */
+	ocf_req_cache_mode_fast_wt,
+		/*!< Fast path of write-through writes */
 	ocf_req_cache_mode_d2c,
 		/*!< Direct to Core - pass through to core without
 				touching cacheline metadata */
@@ -39,6 +41,14 @@ struct ocf_io_if {
 	const char *name;
 };
 
+/* Get cache mode of IO class, regardless of particular IO */
+ocf_cache_mode_t ocf_get_class_cache_mode(ocf_cache_t cache,
+		ocf_core_t core, uint32_t io_class);
+
+/* Get cache mode of IO, given cache mode of its IO class */
+ocf_cache_mode_t ocf_get_io_cache_mode(ocf_cache_t cache, ocf_core_t core,
+		struct ocf_io *io, ocf_cache_mode_t class_mode);
+
 ocf_cache_mode_t ocf_get_effective_cache_mode(ocf_cache_t cache,
 		ocf_core_t core, struct ocf_io *io);
 
@@ -56,17 +66,22 @@ static inline bool ocf_cache_mode_is_valid(ocf_cache_mode_t mode)
 	return mode >= ocf_cache_mode_wt && mode < ocf_cache_mode_max;
 }
 
+void ocf_seq_cutoff_init(ocf_core_t core);
+
 void ocf_seq_cutoff_update(ocf_core_t core, struct ocf_request *req);
 
+void ocf_seq_cutoff_update_io(ocf_core_t core, struct ocf_io *io);
+
 bool ocf_fallback_pt_is_on(ocf_cache_t cache);
 
-bool ocf_seq_cutoff_check(ocf_core_t core, uint32_t dir, uint64_t addr,
-		uint64_t bytes);
+bool ocf_seq_cutoff_check(ocf_core_t core, ocf_queue_t queue, uint32_t dir,
+		uint64_t addr, uint64_t bytes);
 
 struct ocf_request *ocf_engine_pop_req(struct ocf_cache *cache,
 		struct ocf_queue *q);
 
-int ocf_engine_hndl_req(struct ocf_request *req,
+/* Set up request to be handled in given mode once pushed to I/O queue */
+int ocf_engine_prepare_req(struct ocf_request *req,
 		ocf_req_cache_mode_t req_cache_mode);
 
 #define OCF_FAST_PATH_YES	7
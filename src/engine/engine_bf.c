@@ -4,39 +4,97 @@
  */
 
 #include "ocf/ocf.h"
+#include "../ocf_priv.h"
 #include "../ocf_cache_priv.h"
 #include "../ocf_ctx_priv.h"
+#include "../ocf_trace_priv.h"
 #include "engine_bf.h"
 #include "engine_inv.h"
 #include "engine_common.h"
 #include "cache_engine.h"
 #include "../utils/utils_req.h"
 #include "../utils/utils_io.h"
+#include "../utils/utils_data.h"
+#include "../utils/utils_cache_line.h"
+#include "../utils/utils_part.h"
+#include "../utils/utils_fill.h"
 #include "../concurrency/ocf_concurrency.h"
 
 #define OCF_ENGINE_DEBUG_IO_NAME "bf"
 #include "engine_debug.h"
 
+/* Weight of new sample in backfill write latency moving average */
+#define BACKFILL_LATENCY_WEIGHT		16
+
+/* Smallest limit of pending backfills set by latency adaptation */
+#define BACKFILL_QUEUE_LIMIT_MIN	16
+
+/* Number of pending backfills below which queue is unblocked, scaled down
+ * together with adaptive limit
+ */
+static inline uint32_t backfill_queue_unblock_size(struct ocf_cache *cache,
+		uint32_t limit)
+{
+	if (limit >= cache->backfill.max_queue_size)
+		return cache->backfill.queue_unblock_size;
+
+	return (uint64_t)cache->backfill.queue_unblock_size * limit /
+			cache->backfill.max_queue_size;
+}
+
 /* Decrements and checks if queue may be unblocked again */
 static inline void backfill_queue_dec_unblock(struct ocf_cache *cache)
 {
+	uint32_t limit;
+
 	env_atomic_dec(&cache->pending_read_misses_list_count);
 
 	if (!env_atomic_read(&cache->pending_read_misses_list_blocked))
 		return;
 
+	limit = env_atomic_read(&cache->backfill.queue_limit);
 	if (env_atomic_read(&cache->pending_read_misses_list_count)
-			< cache->backfill.queue_unblock_size)
+			< backfill_queue_unblock_size(cache, limit))
 		env_atomic_set(&cache->pending_read_misses_list_blocked, 0);
 }
 
 static inline void backfill_queue_inc_block(struct ocf_cache *cache)
 {
 	if (env_atomic_inc_return(&cache->pending_read_misses_list_count)
-			>= cache->backfill.max_queue_size)
+			>= env_atomic_read(&cache->backfill.queue_limit))
 		env_atomic_set(&cache->pending_read_misses_list_blocked, 1);
 }
 
+/*
+ * Adapt limit of pending backfills to latency of backfill writes. Limit is
+ * cut by 1/8 when average latency exceeds target and grows by one backfill
+ * otherwise, up to configured max_queue_size.
+ */
+static void backfill_queue_adapt(struct ocf_cache *cache, uint64_t ticks)
+{
+	uint32_t max = cache->backfill.max_queue_size;
+	uint32_t min = OCF_MIN(max, (uint32_t)BACKFILL_QUEUE_LIMIT_MIN);
+	int64_t sample, avg;
+	uint32_t limit;
+
+	sample = env_ticks_to_nsecs(env_get_tick_count() - ticks);
+	avg = env_atomic64_read(&cache->backfill.write_latency);
+	avg = avg ? avg + (sample - avg) / BACKFILL_LATENCY_WEIGHT : sample;
+
+	/* Lost update only drops single sample */
+	env_atomic64_set(&cache->backfill.write_latency, avg);
+
+	limit = env_atomic_read(&cache->backfill.queue_limit);
+	if (avg > cache->backfill.latency_target_us * 1000LL) {
+		if (limit > min)
+			limit = OCF_MAX(min, limit - OCF_MAX(1U, limit / 8));
+	} else if (limit < max) {
+		limit++;
+	}
+
+	env_atomic_set(&cache->backfill.queue_limit, limit);
+}
+
 static void _ocf_backfill_complete(struct ocf_request *req, int error)
 {
 	struct ocf_cache *cache = req->cache;
@@ -52,15 +110,31 @@ static void _ocf_backfill_complete(struct ocf_request *req, int error)
 	 * sub-request to complete
 	 */
 	if (env_atomic_dec_return(&req->req_remaining) == 0) {
-		/* We must free the pages we have allocated */
-		ctx_data_secure_erase(cache->owner, req->data);
-		ctx_data_munlock(cache->owner, req->data);
-		ctx_data_free(cache->owner, req->data);
-		req->data = NULL;
+		if (req->backfill_ticks)
+			backfill_queue_adapt(cache, req->backfill_ticks);
+
+		ocf_trace_req_stage(req, ocf_event_req_stage_backfill_completed,
+				0);
+
+		if (req->cp_data) {
+			/* Readers copy from cp_data until it is unregistered */
+			ocf_fill_unregister(req);
+
+			/* We must free the pages we have allocated */
+			ctx_data_secure_erase(cache->owner, req->data);
+			ocf_data_put_locked(cache->owner, req->data,
+					BYTES_TO_PAGES(req->byte_length));
+			req->data = NULL;
+		} else {
+			/* Zero copy - data read from core is fine regardless
+			 * of backfill result
+			 */
+			req->complete(req, 0);
+		}
 
 		if (req->error) {
-			env_atomic_inc(&cache->core[req->core_id].
-					counters->cache_errors.write);
+			env_atomic_inc(&ocf_req_core_stats(req)->
+					cache_errors.write);
 			ocf_engine_invalidate(req);
 		} else {
 			ocf_req_unlock(req);
@@ -73,19 +147,86 @@ static void _ocf_backfill_complete(struct ocf_request *req, int error)
 	}
 }
 
+/* Write clean sectors of cache line merged from core and cache */
+static void _ocf_backfill_merged(struct ocf_request *req, uint32_t map_idx)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_cache_line_t line = req->map[map_idx].coll_idx;
+	uint8_t start, stop, end;
+
+	ocf_map_info_sectors(req, map_idx, &start, &stop);
+
+	for (; start <= stop; start = end + 1) {
+		end = ocf_dirty_run_end(cache, line, start, stop);
+
+		if (metadata_test_dirty_one(cache, line, start))
+			continue;
+
+		env_atomic_inc(&req->req_remaining);
+		ocf_submit_cache_sectors(cache, req, OCF_WRITE, map_idx,
+				start, end, _ocf_backfill_complete);
+	}
+}
+
+/* Write only cache lines which split read got from core */
+static void _ocf_backfill_split(struct ocf_request *req)
+{
+	struct ocf_map_info *map = req->map;
+	uint32_t count = req->core_line_count;
+	uint32_t i, j, run;
+
+	/* Keep request from completing until all IOs are submitted */
+	env_atomic_set(&req->req_remaining, 1);
+
+	for (i = 0; i < count; i += run) {
+		for (run = 1; i + run < count; run++) {
+			if (map[i + run].split_hit != map[i].split_hit ||
+					map[i + run].merge != map[i].merge) {
+				break;
+			}
+		}
+
+		if (map[i].split_hit)
+			continue;
+
+		if (map[i].merge) {
+			for (j = i; j < i + run; j++)
+				_ocf_backfill_merged(req, j);
+			continue;
+		}
+
+		env_atomic_add(run, &req->req_remaining);
+		ocf_submit_cache_lines(req->cache, req, OCF_WRITE, i, run,
+				_ocf_backfill_complete);
+	}
+
+	_ocf_backfill_complete(req, 0);
+}
+
 static int _ocf_backfill_do(struct ocf_request *req)
 {
 	unsigned int reqs_to_issue;
 
 	backfill_queue_dec_unblock(req->cache);
 
+	if (req->cp_data) {
+		req->data = req->cp_data;
+		req->data_offset = 0;
+	}
+
+	if (req->cache->backfill.latency_target_us)
+		req->backfill_ticks = env_get_tick_count();
+
+	if (req->info.split_read) {
+		_ocf_backfill_split(req);
+		return 0;
+	}
+
 	reqs_to_issue = ocf_engine_io_count(req);
 
 	/* There will be #reqs_to_issue completions */
 	env_atomic_set(&req->req_remaining, reqs_to_issue);
 
-	req->data = req->cp_data;
-
 	ocf_submit_cache_reqs(req->cache, req->map, req, OCF_WRITE, reqs_to_issue,
 			      _ocf_backfill_complete);
 
@@ -99,6 +240,20 @@ static const struct ocf_io_if _io_if_backfill = {
 
 void ocf_engine_backfill(struct ocf_request *req)
 {
+	uint64_t bytes = req->byte_length;
+
+	if (req->info.split_read) {
+		bytes = OCF_MIN(bytes, (uint64_t)(req->core_line_count -
+				req->info.hit_no) * ocf_line_size(req->cache));
+	}
+	ocf_part_qos_charge(req->cache, req->part_id, bytes);
+
+	/* Backfill of copied data is done after request was completed, so it
+	 * doesn't hold user IO
+	 */
+	req->background = !!req->cp_data;
+	ocf_fill_register(req);
+
 	backfill_queue_inc_block(req->cache);
 	ocf_engine_push_req_front_if(req, &_io_if_backfill, true);
 }
@@ -13,8 +13,14 @@
 #include "../utils/utils_cache_line.h"
 #include "../utils/utils_req.h"
 #include "../utils/utils_cleaner.h"
+#include "../utils/utils_log.h"
+#include "../utils/utils_part.h"
 #include "../metadata/metadata.h"
 #include "../eviction/eviction.h"
+#include "../eviction/segment.h"
+#include "../promotion/promotion.h"
+#include "../concurrency/ocf_concurrency.h"
+#include "../ocf_trace_priv.h"
 
 void ocf_engine_error(struct ocf_request *req,
 		bool stop_cache, const char *msg)
@@ -24,6 +30,9 @@ void ocf_engine_error(struct ocf_request *req,
 	if (stop_cache)
 		env_bit_clear(ocf_cache_state_running, &cache->cache_state);
 
+	if (ocf_log_ring_req_error(req, msg))
+		return;
+
 	ocf_core_log(&cache->core[req->core_id], log_err,
 			"%s sector: %" ENV_PRIu64 ", bytes: %u\n", msg,
 			BYTES_TO_SECTORS(req->byte_position), req->byte_length);
@@ -46,13 +55,19 @@ void ocf_engine_lookup_map_entry(struct ocf_cache *cache,
 	entry->coll_idx = cache->device->collision_table_entries;
 	entry->core_line = core_line;
 
+	if (!ocf_metadata_lookup_filter_test(cache, hash_key, core_id,
+			core_line)) {
+		return;
+	}
+
 	line = ocf_metadata_get_hash(cache, hash_key);
 
 	while (line != cache->device->collision_table_entries) {
 		ocf_core_id_t curr_core_id;
 		uint64_t curr_core_line;
+		ocf_cache_line_t next;
 
-		ocf_metadata_get_core_info(cache, line, &curr_core_id,
+		next = ocf_metadata_get_lookup_info(cache, line, &curr_core_id,
 				&curr_core_line);
 
 		if (core_id == curr_core_id && curr_core_line == core_line) {
@@ -61,7 +76,7 @@ void ocf_engine_lookup_map_entry(struct ocf_cache *cache,
 			break;
 		}
 
-		line = ocf_metadata_get_collision_next(cache, line);
+		line = next;
 	}
 }
 
@@ -76,7 +91,7 @@ static inline int _ocf_engine_check_map_entry(struct ocf_cache *cache,
 
 	ENV_BUG_ON(entry->coll_idx >= cache->device->collision_table_entries);
 
-	ocf_metadata_get_core_info(cache, entry->coll_idx, &_core_id,
+	ocf_metadata_get_lookup_info(cache, entry->coll_idx, &_core_id,
 			&_core_line);
 
 	if (core_id == _core_id && _core_line == entry->core_line)
@@ -85,6 +100,154 @@ static inline int _ocf_engine_check_map_entry(struct ocf_cache *cache,
 		return -1;
 }
 
+#if OCF_CONFIG_LOOKUP_BATCH
+/* Prefetch collision entry of request entry checked later */
+static inline void ocf_engine_prefetch_map_entry(struct ocf_cache *cache,
+		struct ocf_request *req, uint32_t idx)
+{
+	struct ocf_map_info *entry = &req->map[idx];
+
+	if (idx < req->core_line_count && entry->status != LOOKUP_MISS &&
+			entry->coll_idx <
+				cache->device->collision_table_entries) {
+		ocf_metadata_prefetch_lookup_info(cache, entry->coll_idx);
+	}
+}
+#else
+static inline void ocf_engine_prefetch_map_entry(struct ocf_cache *cache,
+		struct ocf_request *req, uint32_t idx)
+{
+}
+#endif
+
+/* Number of cache lines in super-line of request IO class, 0 if disabled */
+static inline uint32_t ocf_engine_super_line(struct ocf_request *req)
+{
+#if OCF_CONFIG_SUPER_LINE_MAX > 0
+	return req->cache->user_parts[req->part_id].super_line;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Look up request entry. Core line following the one of previous entry in
+ * the same super-line is most likely mapped to next physical cache line, so
+ * hash table is searched only if it isn't.
+ */
+static void ocf_engine_lookup_req_entry(struct ocf_request *req, uint32_t idx,
+		uint64_t core_line)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	struct ocf_map_info *entry = &req->map[idx];
+	uint32_t lines = ocf_engine_super_line(req);
+	ocf_core_id_t curr_core_id;
+	uint64_t curr_core_line;
+	ocf_cache_line_t phy, line;
+
+	if (!lines || !idx || !(core_line % lines) ||
+			req->map[idx - 1].status == LOOKUP_MISS) {
+		ocf_engine_lookup_map_entry(cache, entry, req->core_id,
+				core_line);
+		return;
+	}
+
+	phy = ocf_metadata_map_lg2phy(cache, req->map[idx - 1].coll_idx) + 1;
+	if (phy % lines && phy < line_entries) {
+		line = ocf_metadata_map_phy2lg(cache, phy);
+		ocf_metadata_get_lookup_info(cache, line, &curr_core_id,
+				&curr_core_line);
+
+		if (curr_core_id == req->core_id &&
+				curr_core_line == core_line) {
+			entry->hash_key = ocf_metadata_hash_func(cache,
+					core_line, req->core_id);
+			entry->status = LOOKUP_HIT;
+			entry->coll_idx = line;
+			entry->core_line = core_line;
+			return;
+		}
+	}
+
+	ocf_engine_lookup_map_entry(cache, entry, req->core_id, core_line);
+}
+
+#if OCF_CONFIG_LOOKUP_BATCH
+/*
+ * Look up group of request entries. Hash buckets of the group are prefetched
+ * first, then chains are walked one hop of each entry at a time, prefetching
+ * the next hop, so that cache misses of all chains overlap.
+ */
+static void ocf_engine_lookup_req_batch(struct ocf_request *req,
+		uint32_t first, uint32_t count)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_cache_line_t end = cache->device->collision_table_entries;
+	struct ocf_map_info *entries = &req->map[first];
+	ocf_core_id_t curr_core_id;
+	uint64_t curr_core_line;
+	ocf_cache_line_t next;
+	uint32_t pending = 0;
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		entries[i].core_line = req->core_line_first + first + i;
+		entries[i].hash_key = ocf_metadata_hash_func(cache,
+				entries[i].core_line, req->core_id);
+		entries[i].status = LOOKUP_MISS;
+		entries[i].coll_idx = end;
+
+		if (!ocf_metadata_lookup_filter_test(cache,
+				entries[i].hash_key, req->core_id,
+				entries[i].core_line)) {
+			continue;
+		}
+
+		ocf_metadata_prefetch_hash(cache, entries[i].hash_key);
+		pending |= 1U << i;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (!(pending & (1U << i)))
+			continue;
+
+		entries[i].coll_idx = ocf_metadata_get_hash(cache,
+				entries[i].hash_key);
+		if (entries[i].coll_idx == end) {
+			pending &= ~(1U << i);
+			continue;
+		}
+
+		ocf_metadata_prefetch_lookup_info(cache, entries[i].coll_idx);
+	}
+
+	while (pending) {
+		for (i = 0; i < count; i++) {
+			if (!(pending & (1U << i)))
+				continue;
+
+			next = ocf_metadata_get_lookup_info(cache,
+					entries[i].coll_idx, &curr_core_id,
+					&curr_core_line);
+
+			if (curr_core_id == req->core_id &&
+					curr_core_line == entries[i].core_line) {
+				entries[i].status = LOOKUP_HIT;
+				pending &= ~(1U << i);
+				continue;
+			}
+
+			entries[i].coll_idx = next;
+			if (next == end)
+				pending &= ~(1U << i);
+			else
+				ocf_metadata_prefetch_lookup_info(cache, next);
+		}
+	}
+}
+#endif
+
 void ocf_engine_update_req_info(struct ocf_cache *cache,
 		struct ocf_request *req, uint32_t entry)
 {
@@ -94,12 +257,12 @@ void ocf_engine_update_req_info(struct ocf_cache *cache,
 
 	if (entry == 0) {
 		start_sector = BYTES_TO_SECTORS(req->byte_position)
-				% ocf_line_sectors(cache);
+				& ocf_line_sector_mask(cache);
 	}
 
 	if (entry == req->core_line_count - 1) {
 		end_sector = BYTES_TO_SECTORS(req->byte_position +
-				req->byte_length - 1)% ocf_line_sectors(cache);
+				req->byte_length - 1)& ocf_line_sector_mask(cache);
 	}
 
 	/* Handle return value */
@@ -154,24 +317,35 @@ void ocf_engine_update_req_info(struct ocf_cache *cache,
 
 void ocf_engine_traverse(struct ocf_request *req)
 {
+	bool batch = false;
 	uint32_t i;
 	uint64_t core_line;
 
 	struct ocf_cache *cache = req->cache;
-	ocf_core_id_t core_id = req->core_id;
 
 	OCF_DEBUG_TRACE(req->cache);
 
 	ocf_req_clear_info(req);
 	req->info.seq_req = true;
 
+#if OCF_CONFIG_LOOKUP_BATCH
+	/* Super-line lookup of following core lines doesn't walk chains */
+	batch = req->core_line_count > 1 && !ocf_engine_super_line(req);
+	for (i = 0; batch && i < req->core_line_count;
+			i += OCF_CONFIG_LOOKUP_BATCH) {
+		ocf_engine_lookup_req_batch(req, i, OCF_MIN(
+				req->core_line_count - i,
+				(uint32_t)OCF_CONFIG_LOOKUP_BATCH));
+	}
+#endif
+
 	for (i = 0, core_line = req->core_line_first;
 			core_line <= req->core_line_last; core_line++, i++) {
 
 		struct ocf_map_info *entry = &(req->map[i]);
 
-		ocf_engine_lookup_map_entry(cache, entry, core_id,
-				core_line);
+		if (!batch)
+			ocf_engine_lookup_req_entry(req, i, core_line);
 
 		if (entry->status != LOOKUP_HIT) {
 			req->info.seq_req = false;
@@ -207,11 +381,17 @@ int ocf_engine_check(struct ocf_request *req)
 	ocf_req_clear_info(req);
 	req->info.seq_req = true;
 
+	for (i = 0; i < OCF_CONFIG_LOOKUP_BATCH; i++)
+		ocf_engine_prefetch_map_entry(cache, req, i);
+
 	for (i = 0, core_line = req->core_line_first;
 			core_line <= req->core_line_last; core_line++, i++) {
 
 		struct ocf_map_info *entry = &(req->map[i]);
 
+		ocf_engine_prefetch_map_entry(cache, req,
+				i + OCF_CONFIG_LOOKUP_BATCH);
+
 		if (entry->status == LOOKUP_MISS) {
 			req->info.seq_req = false;
 			continue;
@@ -242,37 +422,168 @@ int ocf_engine_check(struct ocf_request *req)
 	return result;
 }
 
-static void ocf_engine_map_cache_line(struct ocf_request *req,
-		uint64_t core_line, unsigned int hash_index,
-		ocf_cache_line_t *cache_line)
+#if OCF_CONFIG_SUPER_LINE_MAX > 0
+/*
+ * Pick free cache line for request entry, so that core lines of the same
+ * super-line go to one aligned group of physical cache lines. Group is found
+ * from cache line of previous entry, from recently started super-lines of
+ * IO class or else new one is started. Caller has to have exclusive metadata
+ * access or free list lock.
+ *
+ * Returns cache line or collision_table_entries if IO class has no
+ * super-lines or place of entry in its group is taken.
+ */
+static ocf_cache_line_t ocf_engine_super_line_pick(struct ocf_request *req,
+		uint32_t idx)
 {
 	struct ocf_cache *cache = req->cache;
-	ocf_part_id_t part_id = req->part_id;
-	ocf_cleaning_t clean_policy_type;
+	struct ocf_user_part *part = &cache->user_parts[req->part_id];
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	uint64_t core_line = req->map[idx].core_line;
+	uint32_t lines = part->super_line;
+	ocf_cache_line_t base = line_entries, phy;
+	struct ocf_part_super_line *recent;
+	uint64_t group;
+	uint32_t slot, i;
+
+	if (!lines)
+		return line_entries;
+
+	slot = core_line % lines;
+	group = core_line / lines;
+
+	if (slot && idx && req->map[idx - 1].coll_idx < line_entries) {
+		phy = ocf_metadata_map_lg2phy(cache, req->map[idx - 1].coll_idx);
+		if (phy % lines == slot - 1)
+			base = phy - (slot - 1);
+	}
 
-	if (cache->device->freelist_part->curr_size == 0) {
-		req->info.eviction_error = 1;
-		return;
+	for (i = 0; base == line_entries && i < OCF_PART_SUPER_RECENT; i++) {
+		recent = &part->super_recent[i];
+		if (recent->group == group && recent->core_id == req->core_id)
+			base = recent->base;
 	}
 
-	*cache_line = cache->device->freelist_part->head;
+	if (base == line_entries) {
+		base = ocf_metadata_free_map_find(cache, lines);
+		if (base == line_entries)
+			return line_entries;
+
+		recent = &part->super_recent[part->super_recent_next];
+		recent->group = group;
+		recent->base = base;
+		recent->core_id = req->core_id;
+		part->super_recent_next = (part->super_recent_next + 1) %
+				OCF_PART_SUPER_RECENT;
+	}
+
+	phy = base + slot;
+	if (phy >= line_entries || !ocf_metadata_free_map_test(cache, phy))
+		return line_entries;
+
+	return ocf_metadata_map_phy2lg(cache, phy);
+}
+#else
+static inline ocf_cache_line_t ocf_engine_super_line_pick(
+		struct ocf_request *req, uint32_t idx)
+{
+	return req->cache->device->collision_table_entries;
+}
+#endif
+
+#if OCF_CONFIG_LOG_SEGMENT_LINES > 0
+/*
+ * Pick next free cache line of log-structured allocation segment of request
+ * queue, starting new segment when current one is used up. Cache lines of
+ * segment may be taken meanwhile from the free list head, so they are
+ * skipped. Caller has to have exclusive metadata access or free list lock.
+ *
+ * Returns cache line or collision_table_entries if no segment is free.
+ */
+static ocf_cache_line_t ocf_engine_log_segment_pick(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_queue_t q = req->io_queue;
+	ocf_cache_line_t phy;
+
+	if (!q)
+		return line_entries;
+
+	while (q->log_segment.next < q->log_segment.end) {
+		phy = q->log_segment.next++;
+		if (phy < line_entries && ocf_metadata_free_map_test(cache, phy))
+			return ocf_metadata_map_phy2lg(cache, phy);
+	}
+
+	phy = ocf_metadata_free_map_find(cache, OCF_CONFIG_LOG_SEGMENT_LINES);
+	if (phy == line_entries) {
+		ocf_segment_cleaner_needed(cache);
+		return line_entries;
+	}
+
+	q->log_segment.next = phy + 1;
+	q->log_segment.end = phy + OCF_CONFIG_LOG_SEGMENT_LINES;
+
+	return ocf_metadata_map_phy2lg(cache, phy);
+}
+#else
+static inline ocf_cache_line_t ocf_engine_log_segment_pick(
+		struct ocf_request *req)
+{
+	return req->cache->device->collision_table_entries;
+}
+#endif
+
+/*
+ * Take cache line from the free list for request entry and assign it to
+ * request partition. Caller has to have exclusive metadata access or free
+ * list lock.
+ */
+static bool ocf_engine_get_free_line(struct ocf_request *req, uint32_t idx)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_cache_line_t *cache_line = &req->map[idx].coll_idx;
+
+	if (cache->device->freelist_part->curr_size == 0)
+		return false;
+
+	*cache_line = ocf_engine_super_line_pick(req, idx);
+	if (*cache_line == cache->device->collision_table_entries)
+		*cache_line = ocf_engine_log_segment_pick(req);
 
 	/* add_to_collision_list changes .next_col and other fields for entry
 	 * so updated last_cache_line_give must be updated before calling it.
 	 */
 
-	ocf_metadata_remove_from_free_list(cache, *cache_line);
+	if (*cache_line == cache->device->collision_table_entries) {
+		ENV_BUG_ON(!ocf_metadata_take_from_free_list(cache,
+				cache_line, 1));
+	} else {
+		ocf_metadata_remove_from_free_list(cache, *cache_line);
+	}
 
-	ocf_metadata_add_to_partition(cache, part_id, *cache_line);
+	ocf_metadata_add_to_partition(cache, req->part_id, *cache_line);
+
+	return true;
+}
+
+static void ocf_engine_map_cache_line(struct ocf_request *req,
+		uint64_t core_line, unsigned int hash_index,
+		ocf_cache_line_t cache_line)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_part_id_t part_id = req->part_id;
+	ocf_cleaning_t clean_policy_type;
 
 	/* Add the block to the corresponding collision list */
 	ocf_metadata_add_to_collision(cache, req->core_id, core_line, hash_index,
-			*cache_line);
+			cache_line);
 
-	ocf_eviction_init_cache_line(cache, *cache_line, part_id);
+	ocf_eviction_init_cache_line(cache, cache_line, part_id);
 
 	/* Update LRU:: Move this node to head of lru list. */
-	ocf_eviction_set_hot_cache_line(cache, *cache_line);
+	ocf_eviction_set_hot_cache_line(cache, cache_line);
 
 	/* Update dirty cache-block list */
 	clean_policy_type = cache->conf_meta->cleaning_policy_type;
@@ -281,7 +592,7 @@ static void ocf_engine_map_cache_line(struct ocf_request *req,
 
 	if (cleaning_policy_ops[clean_policy_type].init_cache_block != NULL)
 		cleaning_policy_ops[clean_policy_type].
-				init_cache_block(cache, *cache_line);
+				init_cache_block(cache, cache_line);
 }
 
 static void ocf_engine_map_hndl_error(struct ocf_cache *cache,
@@ -320,7 +631,6 @@ void ocf_engine_map(struct ocf_request *req)
 	struct ocf_map_info *entry;
 	uint64_t core_line;
 	int status = LOOKUP_MAPPED;
-	ocf_core_id_t core_id = req->core_id;
 
 	if (ocf_engine_unmapped_count(req))
 		status = space_managment_evict_do(cache, req,
@@ -338,22 +648,23 @@ void ocf_engine_map(struct ocf_request *req)
 			core_line <= req->core_line_last; core_line++, i++) {
 		entry = &(req->map[i]);
 
-		ocf_engine_lookup_map_entry(cache, entry, core_id, core_line);
+		ocf_engine_lookup_req_entry(req, i, core_line);
 
 		if (entry->status != LOOKUP_HIT) {
-			ocf_engine_map_cache_line(req, entry->core_line,
-					entry->hash_key, &entry->coll_idx);
-
-			if (req->info.eviction_error) {
+			if (!ocf_engine_get_free_line(req, i)) {
 				/*
 				 * Eviction error (mapping error), need to
 				 * clean, return and do pass through
 				 */
+				req->info.eviction_error = 1;
 				OCF_DEBUG_RQ(req, "Eviction ERROR when mapping");
 				ocf_engine_map_hndl_error(cache, req);
 				break;
 			}
 
+			ocf_engine_map_cache_line(req, entry->core_line,
+					entry->hash_key, entry->coll_idx);
+
 			entry->status = status;
 		}
 
@@ -370,6 +681,387 @@ void ocf_engine_map(struct ocf_request *req)
 			"Yes" : "No");
 }
 
+/*
+ * Take free cache lines for unmapped entries of request one by one under the
+ * free list lock.
+ *
+ * Returns false if there are not enough free cache lines.
+ */
+static bool ocf_engine_get_free_lines_each(struct ocf_request *req,
+		uint32_t count)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *entry;
+	uint32_t i;
+
+	ocf_metadata_freelist_lock(cache);
+
+	if (cache->device->freelist_part->curr_size < count) {
+		ocf_metadata_freelist_unlock(cache);
+		return false;
+	}
+
+	for (i = 0; i < req->core_line_count; i++) {
+		entry = &(req->map[i]);
+
+		if (entry->status != LOOKUP_HIT)
+			ENV_BUG_ON(!ocf_engine_get_free_line(req, i));
+	}
+
+	ocf_metadata_freelist_unlock(cache);
+
+	return true;
+}
+
+#if OCF_CONFIG_QUEUE_FREELIST_BATCH > 0
+/*
+ * Take free cache lines for unmapped entries of request from the free line
+ * cache of its queue and put them on the partition list as one chain. The
+ * free list lock is held only to take missing cache lines and refill queue
+ * cache in batch, and to splice the chain, which takes constant time.
+ *
+ * Returns false if there are not enough free cache lines.
+ */
+static bool ocf_engine_get_free_lines(struct ocf_request *req, uint32_t count)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_queue_t q = req->io_queue;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_cache_line_t first = line_entries, last = line_entries;
+	struct ocf_map_info *entry;
+	bool locked = false;
+	uint32_t i;
+
+	/* Super-line and log segment cache lines are picked from free map,
+	 * not queue cache
+	 */
+	if (ocf_engine_super_line(req) || OCF_CONFIG_LOG_SEGMENT_LINES)
+		return ocf_engine_get_free_lines_each(req, count);
+
+	env_spinlock_lock(&q->freelist_lock);
+
+	if (q->freelist_count < count) {
+		ocf_metadata_freelist_lock(cache);
+		locked = true;
+
+		if (q->freelist_count + cache->device->freelist_part->curr_size
+				< count) {
+			ocf_metadata_freelist_unlock(cache);
+			env_spinlock_unlock(&q->freelist_lock);
+			return false;
+		}
+	}
+
+	for (i = 0; i < req->core_line_count; i++) {
+		entry = &(req->map[i]);
+
+		if (entry->status == LOOKUP_HIT)
+			continue;
+
+		if (q->freelist_count) {
+			entry->coll_idx = q->freelist[--q->freelist_count];
+		} else {
+			ENV_BUG_ON(!ocf_metadata_take_from_free_list(cache,
+					&entry->coll_idx, 1));
+		}
+
+		ocf_metadata_set_partition_info(cache, entry->coll_idx,
+				req->part_id, line_entries, last);
+		if (last == line_entries)
+			first = entry->coll_idx;
+		else
+			ocf_metadata_set_partition_next(cache, last,
+					entry->coll_idx);
+		last = entry->coll_idx;
+	}
+
+	if (!locked)
+		ocf_metadata_freelist_lock(cache);
+
+	if (!q->freelist_count) {
+		q->freelist_count = ocf_metadata_take_from_free_list(cache,
+				q->freelist, OCF_CONFIG_QUEUE_FREELIST_BATCH);
+	}
+
+	ocf_metadata_add_chain_to_partition(cache, req->part_id, first, last,
+			count);
+
+	ocf_metadata_freelist_unlock(cache);
+	env_spinlock_unlock(&q->freelist_lock);
+
+	return true;
+}
+#else
+static inline bool ocf_engine_get_free_lines(struct ocf_request *req,
+		uint32_t count)
+{
+	return ocf_engine_get_free_lines_each(req, count);
+}
+#endif
+
+/*
+ * Map request cache lines from the free list, without eviction. Caller has to
+ * hold hash bucket write locks of the request, so other requests may map
+ * concurrently and the free list is accessed under the free list lock.
+ *
+ * Returns false if there are not enough free cache lines.
+ */
+static bool ocf_engine_map_free(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	uint32_t i, unmapped = 0;
+	struct ocf_map_info *entry;
+	uint64_t core_line;
+
+	for (i = 0, core_line = req->core_line_first;
+			core_line <= req->core_line_last; core_line++, i++) {
+		entry = &(req->map[i]);
+
+		ocf_engine_lookup_req_entry(req, i, core_line);
+
+		if (entry->status != LOOKUP_HIT)
+			unmapped++;
+	}
+
+	if (unmapped && !ocf_engine_get_free_lines(req, unmapped))
+		return false;
+
+	ocf_req_clear_info(req);
+	req->info.seq_req = true;
+
+	OCF_DEBUG_TRACE(req->cache);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		entry = &(req->map[i]);
+
+		if (entry->status != LOOKUP_HIT) {
+			ocf_engine_map_cache_line(req, entry->core_line,
+					entry->hash_key, entry->coll_idx);
+
+			entry->status = LOOKUP_MAPPED;
+		}
+
+		OCF_DEBUG_PARAM(req->cache,
+			"%s, cache line %u, core line = %llu",
+			entry->status == LOOKUP_HIT ? "Hit" : "Map",
+			entry->coll_idx, entry->core_line);
+
+		ocf_engine_update_req_info(cache, req, i);
+	}
+
+	OCF_DEBUG_PARAM(req->cache, "Sequential - %s", req->info.seq_req ?
+			"Yes" : "No");
+
+	return true;
+}
+
+static int ocf_engine_eviction_retry(struct ocf_request *req);
+
+static const struct ocf_io_if _io_if_eviction_retry = {
+	.read = ocf_engine_eviction_retry,
+	.write = ocf_engine_eviction_retry,
+};
+
+/*
+ * Park request until background eviction frees cache lines for it, giving up
+ * waiting for exclusive metadata access. Request is parked at most once, so
+ * that it eventually takes the regular eviction path.
+ *
+ * Returns true if request was parked.
+ */
+static bool ocf_engine_park_req(struct ocf_request *req,
+		int (*lock_clines)(struct ocf_request *req))
+{
+	struct ocf_cache *cache = req->cache;
+
+	if (!OCF_CONFIG_EVICTION_ASYNC || req->evict_parked)
+		return false;
+
+	OCF_DEBUG_RQ(req, "Park for eviction");
+
+	req->evict_parked = true;
+	req->lock_clines = lock_clines;
+
+	/* Keep resume interface, as with _io_if_refresh */
+	ENV_BUG_ON(req->priv);
+	req->priv = (void *)req->io_if;
+
+	env_spinlock_lock(&cache->eviction_waiters.lock);
+	list_add_tail(&req->list, &cache->eviction_waiters.list);
+	cache->eviction_waiters.lines += ocf_engine_unmapped_count(req);
+	env_spinlock_unlock(&cache->eviction_waiters.lock);
+
+	/* Without background eviction retry parked requests right away */
+	if (!ocf_eviction_refill_kick(cache, req->io_queue))
+		ocf_engine_wake_parked(cache);
+
+	return true;
+}
+
+void ocf_engine_wake_parked(struct ocf_cache *cache)
+{
+	struct ocf_request *req, *next;
+	struct list_head list;
+
+	INIT_LIST_HEAD(&list);
+
+	env_spinlock_lock(&cache->eviction_waiters.lock);
+	while (!list_empty(&cache->eviction_waiters.list)) {
+		req = list_first_entry(&cache->eviction_waiters.list,
+				struct ocf_request, list);
+		list_move_tail(&req->list, &list);
+	}
+	cache->eviction_waiters.lines = 0;
+	env_spinlock_unlock(&cache->eviction_waiters.lock);
+
+	list_for_each_entry_safe(req, next, &list, list) {
+		list_del(&req->list);
+		ocf_engine_push_req_front_if(req, &_io_if_eviction_retry,
+				false);
+	}
+}
+
+int ocf_engine_prepare_clines(struct ocf_request *req,
+		int (*lock_clines)(struct ocf_request *req))
+{
+	struct ocf_cache *cache = req->cache;
+	int lock = OCF_LOCK_NOT_ACQUIRED;
+
+	/*- Hash bucket RD access, lookup only -------------------------------*/
+
+	ocf_req_hash_lock_rd(req);
+	ocf_trace_req_stage(req, ocf_event_req_stage_metadata_locked, 0);
+
+	/* Traverse request to cache if there is hit */
+	ocf_engine_traverse(req);
+
+	if (ocf_engine_is_mapped(req)) {
+		/* Request is fully mapped, no need to map */
+		lock = lock_clines(req);
+		ocf_req_hash_unlock_rd(req);
+		return lock;
+	}
+
+	ocf_eviction_ghost_lookup(req);
+
+	if (req->rw == OCF_READ && !ocf_promotion_req_should_promote(req)) {
+		/* Misses are not inserted, serve request like for
+		 * eviction failure
+		 */
+		req->info.eviction_error = true;
+		ocf_req_hash_unlock_rd(req);
+		return lock;
+	}
+
+	if (!ocf_part_pinned_fits(cache, req->part_id,
+			ocf_engine_unmapped_count(req))) {
+		/* Pinned capacity is used up, pinned lines are never
+		 * evicted to make room
+		 */
+		req->info.eviction_error = true;
+		ocf_req_hash_unlock_rd(req);
+		return lock;
+	}
+
+	ocf_req_hash_unlock_rd(req);
+
+	/*- Hash bucket WR access, mapping from free list --------------------*/
+
+	ocf_req_hash_lock_wr(req);
+	ocf_trace_req_stage(req, ocf_event_req_stage_metadata_locked, 1);
+
+	if (ocf_engine_map_free(req)) {
+		lock = lock_clines(req);
+		ocf_req_hash_unlock_wr(req);
+		ocf_eviction_reserve_check(cache, req->io_queue);
+		ocf_segment_cleaner_check(cache, req->io_queue);
+		return lock;
+	}
+
+	ocf_req_hash_unlock_wr(req);
+
+	/*- Metadata WR access, eviction -------------------------------------*/
+
+	if (OCF_METADATA_LOCK_WR_TRY()) {
+		/* Metadata lock is contended, rather than stall behind it
+		 * wait for background eviction
+		 */
+		if (ocf_engine_park_req(req, lock_clines))
+			return OCF_LOCK_NOT_ACQUIRED;
+
+		OCF_METADATA_LOCK_WR();
+	}
+	ocf_trace_req_stage(req, ocf_event_req_stage_metadata_locked, 2);
+
+	/* Now there is exclusive access for metadata. May traverse once
+	 * again. If there are misses need to call eviction. This
+	 * process is called 'mapping'.
+	 */
+	ocf_engine_map(req);
+
+	if (!req->info.eviction_error)
+		lock = lock_clines(req);
+
+	/* Exclusive access is already paid for, apply queued moves of hit
+	 * cache lines to their new partitions
+	 */
+	ocf_part_move_apply(cache);
+
+	OCF_METADATA_UNLOCK_WR();
+
+	ocf_eviction_reserve_check(cache, req->io_queue);
+	ocf_segment_cleaner_check(cache, req->io_queue);
+
+	/*- END Metadata WR access -------------------------------------------*/
+
+	return lock;
+}
+
+/*
+ * Retry preparing cache lines of request woken up after background eviction
+ * and continue it as its engine would
+ */
+static int ocf_engine_eviction_retry(struct ocf_request *req)
+{
+	int lock;
+
+	req->io_if = req->priv;
+	req->priv = NULL;
+
+	/* Get OCF request - increase reference counter */
+	ocf_req_get(req);
+
+	lock = ocf_engine_prepare_clines(req, req->lock_clines);
+
+	if (!req->info.eviction_error) {
+		if (lock >= 0) {
+			if (lock != OCF_LOCK_ACQUIRED) {
+				/* Lock was not acquired, need to wait for resume */
+				OCF_DEBUG_RQ(req, "NO LOCK");
+			} else if (req->rw == OCF_WRITE) {
+				req->io_if->write(req);
+			} else {
+				req->io_if->read(req);
+			}
+		} else {
+			OCF_DEBUG_RQ(req, "LOCK ERROR %d", lock);
+			req->complete(req, lock);
+			ocf_req_put(req);
+		}
+	} else {
+		ocf_req_clear(req);
+		if (req->rw == OCF_WRITE)
+			ocf_get_io_if(ocf_cache_mode_pt)->write(req);
+		else
+			ocf_get_io_if(ocf_cache_mode_pt)->read(req);
+	}
+
+	/* Put OCF request - decrease reference counter */
+	ocf_req_put(req);
+
+	return 0;
+}
+
 static void _ocf_engine_clean_end(void *private_data, int error)
 {
 	struct ocf_request *req = private_data;
@@ -447,7 +1139,7 @@ void ocf_engine_update_block_stats(struct ocf_request *req)
 	ocf_part_id_t part_id = req->part_id;
 	struct ocf_counters_block *blocks;
 
-	blocks = &cache->core[core_id].counters->
+	blocks = &ocf_core_stats(&cache->core[core_id], req->io_queue)->
 			part_counters[part_id].blocks;
 
 	if (req->rw == OCF_READ)
@@ -467,11 +1159,11 @@ void ocf_engine_update_request_stats(struct ocf_request *req)
 
 	switch (req->rw) {
 	case OCF_READ:
-		reqs = &cache->core[core_id].counters->
+		reqs = &ocf_core_stats(&cache->core[core_id], req->io_queue)->
 				part_counters[part_id].read_reqs;
 		break;
 	case OCF_WRITE:
-		reqs = &cache->core[core_id].counters->
+		reqs = &ocf_core_stats(&cache->core[core_id], req->io_queue)->
 				part_counters[part_id].write_reqs;
 		break;
 	default:
@@ -486,53 +1178,119 @@ void ocf_engine_update_request_stats(struct ocf_request *req)
 		env_atomic64_inc(&reqs->partial_miss);
 }
 
+static inline void ocf_engine_update_last_access(ocf_queue_t q)
+{
+	uint32_t now = env_ticks_to_msecs(env_get_tick_count());
+
+	/* Don't dirty cache line of queue if time didn't change */
+	if (env_atomic_read(&q->last_access_ms) != now)
+		env_atomic_set(&q->last_access_ms, now);
+}
+
 void ocf_engine_push_req_back(struct ocf_request *req, bool allow_sync)
 {
-	ocf_cache_t cache = req->cache;
 	ocf_queue_t q = NULL;
+#if OCF_CONFIG_QUEUE_LOCKLESS != 1
 	unsigned long lock_flags = 0;
+#endif
 
 	INIT_LIST_HEAD(&req->list);
 
 	ENV_BUG_ON(!req->io_queue);
 	q = req->io_queue;
 
+	ocf_trace_req_stage(req, ocf_event_req_stage_queued, 0);
+
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+	ocf_queue_push_req_lockless(q, req, false);
+#else
 	env_spinlock_lock_irqsave(&q->io_list_lock, lock_flags);
 
-	list_add_tail(&req->list, &q->io_list);
+	list_add_tail(&req->list, &q->io_list[ocf_req_is_background(req)]);
 	env_atomic_inc(&q->io_no);
 
 	env_spinlock_unlock_irqrestore(&q->io_list_lock, lock_flags);
+#endif
 
 	if (!req->info.internal) {
-		env_atomic_set(&cache->last_access_ms,
-				env_ticks_to_msecs(env_get_tick_count()));
+		ocf_engine_update_last_access(q);
 	}
 
 	ocf_queue_kick(q, allow_sync);
 }
 
+void ocf_engine_push_reqs_back(ocf_queue_t q, struct list_head *reqs)
+{
+	struct ocf_request *req, *tmp;
+	bool external = false;
+	int count = 0;
+#if OCF_CONFIG_QUEUE_LOCKLESS != 1
+	unsigned long lock_flags = 0;
+#endif
+
+	if (list_empty(reqs))
+		return;
+
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+	list_for_each_entry_safe(req, tmp, reqs, list) {
+		ENV_BUG_ON(req->io_queue != q);
+		list_del(&req->list);
+		external |= !req->info.internal;
+		ocf_trace_req_stage(req, ocf_event_req_stage_queued, 0);
+		ocf_queue_push_req_lockless(q, req, false);
+		count++;
+	}
+#else
+	env_spinlock_lock_irqsave(&q->io_list_lock, lock_flags);
+
+	list_for_each_entry_safe(req, tmp, reqs, list) {
+		ENV_BUG_ON(req->io_queue != q);
+		list_del(&req->list);
+		external |= !req->info.internal;
+		ocf_trace_req_stage(req, ocf_event_req_stage_queued, 0);
+		list_add_tail(&req->list,
+				&q->io_list[ocf_req_is_background(req)]);
+		count++;
+	}
+	env_atomic_add(count, &q->io_no);
+
+	env_spinlock_unlock_irqrestore(&q->io_list_lock, lock_flags);
+#endif
+
+	if (external) {
+		ocf_engine_update_last_access(q);
+	}
+
+	ocf_queue_kick(q, true);
+}
+
 void ocf_engine_push_req_front(struct ocf_request *req, bool allow_sync)
 {
-	ocf_cache_t cache = req->cache;
 	ocf_queue_t q = NULL;
+#if OCF_CONFIG_QUEUE_LOCKLESS != 1
 	unsigned long lock_flags = 0;
+#endif
 
 	ENV_BUG_ON(!req->io_queue);
 	INIT_LIST_HEAD(&req->list);
 
 	q = req->io_queue;
 
+	ocf_trace_req_stage(req, ocf_event_req_stage_queued, 0);
+
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+	ocf_queue_push_req_lockless(q, req, true);
+#else
 	env_spinlock_lock_irqsave(&q->io_list_lock, lock_flags);
 
-	list_add(&req->list, &q->io_list);
+	list_add(&req->list, &q->io_list[ocf_req_is_background(req)]);
 	env_atomic_inc(&q->io_no);
 
 	env_spinlock_unlock_irqrestore(&q->io_list_lock, lock_flags);
+#endif
 
 	if (!req->info.internal) {
-		env_atomic_set(&cache->last_access_ms,
-				env_ticks_to_msecs(env_get_tick_count()));
+		ocf_engine_update_last_access(q);
 	}
 
 	ocf_queue_kick(q, allow_sync);
@@ -554,6 +1312,12 @@ void inc_fallback_pt_error_counter(ocf_cache_t cache)
 	if (cache->fallback_pt_error_threshold == OCF_CACHE_FALLBACK_PT_INACTIVE)
 		return;
 
+	/* Once fallback is engaged there is no point in bouncing counter
+	 * cache line between queues on every failed IO
+	 */
+	if (ocf_fallback_pt_is_on(cache))
+		return;
+
 	if (env_atomic_inc_return(&cache->fallback_pt_error_counter) ==
 			cache->fallback_pt_error_threshold) {
 		ocf_cache_log(cache, log_info, "Error threshold reached. "
@@ -561,17 +1325,50 @@ void inc_fallback_pt_error_counter(ocf_cache_t cache)
 	}
 }
 
+/*
+ * Recompute request info of lines whose mapping is known to be unchanged
+ */
+static void _ocf_engine_refresh_info(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	uint32_t i;
+
+	ocf_req_clear_info(req);
+	req->info.seq_req = true;
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (req->map[i].status == LOOKUP_MISS) {
+			req->info.seq_req = false;
+			continue;
+		}
+
+		ocf_engine_update_req_info(cache, req, i);
+	}
+}
+
 static int _ocf_engine_refresh(struct ocf_request *req)
 {
 	struct ocf_cache *cache = req->cache;
-	int result;
+	int result = 0;
 
 	OCF_METADATA_LOCK_RD();
-	/* Check under metadata RD lock */
 
-	result = ocf_engine_check(req);
+	/* No cache line was mapped to or unmapped from request hash buckets
+	 * while it waited for cache line locks, so lookup result still holds
+	 */
+	if (req->hash_gen == ocf_req_hash_gen(req)) {
+		_ocf_engine_refresh_info(req);
+		OCF_METADATA_UNLOCK_RD();
+	} else {
+		OCF_METADATA_UNLOCK_RD();
+
+		ocf_req_hash_lock_rd(req);
+		/* Check under hash bucket RD locks */
 
-	OCF_METADATA_UNLOCK_RD();
+		result = ocf_engine_check(req);
+
+		ocf_req_hash_unlock_rd(req);
+	}
 
 	if (result == 0) {
 
@@ -139,6 +139,34 @@ void ocf_engine_lookup_map_entry(struct ocf_cache *cache,
  */
 void ocf_engine_map(struct ocf_request *req);
 
+/**
+ * @brief Traverse request and map missing cache lines, then lock them
+ *
+ * @note Lookup and mapping from the free list are done under hash bucket
+ * locks of the request only, exclusive metadata access is taken only when
+ * eviction is needed
+ *
+ * @param req OCF request
+ * @param lock_clines Function locking request cache lines, called with
+ * metadata locked once request is mapped
+ *
+ * @note With OCF_CONFIG_EVICTION_ASYNC request needing eviction while
+ * metadata lock is contended may be parked until background eviction frees
+ * cache lines. OCF_LOCK_NOT_ACQUIRED is returned then and request is
+ * continued the same way as after resume.
+ *
+ * @return Result of lock_clines, not valid if req->info.eviction_error is set
+ */
+int ocf_engine_prepare_clines(struct ocf_request *req,
+		int (*lock_clines)(struct ocf_request *req));
+
+/**
+ * @brief Retry requests parked waiting for background eviction
+ *
+ * @param cache OCF cache instance
+ */
+void ocf_engine_wake_parked(struct ocf_cache *cache);
+
 /**
  * @brief Traverse OCF request (lookup cache)
  *
@@ -194,6 +222,15 @@ void ocf_engine_update_request_stats(struct ocf_request *req);
 void ocf_engine_push_req_back(struct ocf_request *req,
 		bool allow_sync);
 
+/**
+ * @brief Push list of OCF requests to the back of OCF thread worker queue
+ *	in single critical section, kicking the queue once
+ *
+ * @param q OCF queue all requests are assigned to
+ * @param reqs List of OCF requests linked through req->list, emptied
+ */
+void ocf_engine_push_reqs_back(ocf_queue_t q, struct list_head *reqs);
+
 /**
  * @brief Push back OCF request to the OCF thread worker queue
  *
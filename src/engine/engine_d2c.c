@@ -24,9 +24,11 @@ static void _ocf_d2c_completion(struct ocf_request *req, int error)
 	if (req->error) {
 		req->info.core_error = 1;
 		if (req->rw == OCF_READ)
-			env_atomic_inc(&core->counters->core_errors.read);
+			env_atomic_inc(&ocf_core_stats(core, req->io_queue)->
+					core_errors.read);
 		else
-			env_atomic_inc(&core->counters->core_errors.write);
+			env_atomic_inc(&ocf_core_stats(core, req->io_queue)->
+					core_errors.write);
 	}
 
 	/* Complete request */
@@ -53,10 +55,10 @@ int ocf_io_d2c(struct ocf_request *req)
 	ocf_engine_update_block_stats(req);
 
 	if (req->rw == OCF_READ) {
-		env_atomic64_inc(&core->counters->
+		env_atomic64_inc(&ocf_core_stats(core, req->io_queue)->
 			part_counters[req->part_id].read_reqs.pass_through);
 	} else {
-		env_atomic64_inc(&core->counters->
+		env_atomic64_inc(&ocf_core_stats(core, req->io_queue)->
 			part_counters[req->part_id].write_reqs.pass_through);
 	}
 
@@ -8,6 +8,7 @@
 #include "engine_common.h"
 #include "engine_discard.h"
 #include "../metadata/metadata.h"
+#include "../metadata/metadata_core_index.h"
 #include "../utils/utils_req.h"
 #include "../utils/utils_io.h"
 #include "../utils/utils_cache_line.h"
@@ -15,6 +16,9 @@
 
 #define OCF_ENGINE_DEBUG 0
 
+/* Number of requests handling steps of single discard concurrently */
+#define OCF_DISCARD_WORKERS 4
+
 #define OCF_ENGINE_DEBUG_IO_NAME "discard"
 #include "engine_debug.h"
 
@@ -121,16 +125,38 @@ static int _ocf_discard_flush_cache(struct ocf_request *req)
 	return 0;
 }
 
-static void _ocf_discard_finish_step(struct ocf_request *req)
+/* Last worker continues with flush of cache and discard of core */
+static void _ocf_discard_worker_done(struct ocf_request *req)
 {
-	req->discard.handled += BYTES_TO_SECTORS(req->byte_length);
+	struct ocf_request *master = req->discard.master;
 
-	if (req->discard.handled < req->discard.nr_sects)
-		req->io_if = &_io_if_discard_step;
-	else if (req->cache->device->init_mode != ocf_init_mode_metadata_volatile)
-		req->io_if = &_io_if_discard_flush_cache;
-	else
-		req->io_if = &_io_if_discard_core;
+	if (req != master)
+		ocf_req_put(req);
+
+	if (env_atomic_dec_return(&master->discard.workers))
+		return;
+
+	if (master->discard.error) {
+		_ocf_discard_complete_req(master, master->discard.error);
+		return;
+	}
+
+	master->discard.handled = master->discard.nr_sects;
+
+	/* Metadata is changed only if any cache line was purged */
+	if (master->discard.purged && master->cache->device->init_mode !=
+			ocf_init_mode_metadata_volatile) {
+		master->io_if = &_io_if_discard_flush_cache;
+	} else {
+		master->io_if = &_io_if_discard_core;
+	}
+
+	ocf_engine_push_req_front(master, true);
+}
+
+static void _ocf_discard_finish_step(struct ocf_request *req)
+{
+	req->io_if = &_io_if_discard_step;
 
 	ocf_engine_push_req_front(req, true);
 }
@@ -150,7 +176,8 @@ static void _ocf_discard_step_complete(struct ocf_request *req, int error)
 
 	if (req->error) {
 		ocf_metadata_error(req->cache);
-		_ocf_discard_complete_req(req, req->error);
+		req->discard.master->discard.error = req->error;
+		_ocf_discard_worker_done(req);
 		return;
 	}
 
@@ -173,6 +200,7 @@ int _ocf_discard_step_do(struct ocf_request *req)
 
 		/* Remove mapped cache lines from metadata */
 		ocf_purge_map_info(req);
+		req->discard.master->discard.purged = true;
 
 		if (req->info.flush_metadata) {
 			/* Request was dirty and need to flush metadata */
@@ -202,24 +230,46 @@ static int _ocf_discard_step(struct ocf_request *req)
 {
 	int lock;
 	struct ocf_cache *cache = req->cache;
+	struct ocf_request *master = req->discard.master;
+	ocf_core_t core = &cache->core[req->core_id];
+	sector_t step_sects = BYTES_TO_SECTORS(MAX_TRIM_RQ_SIZE);
 
 	OCF_DEBUG_TRACE(req->cache);
 
-	req->byte_position = SECTORS_TO_BYTES(req->discard.sector +
-			req->discard.handled);
-	req->byte_length = OCF_MIN(SECTORS_TO_BYTES(req->discard.nr_sects -
-			req->discard.handled), MAX_TRIM_RQ_SIZE);
-	req->core_line_first = ocf_bytes_2_lines(cache, req->byte_position);
-	req->core_line_last =
-		ocf_bytes_2_lines(cache, req->byte_position + req->byte_length - 1);
+	do {
+		/* Take next step of the range, stop once it is all taken or
+		 * discard is aborted
+		 */
+		req->discard.handled = (sector_t)(env_atomic_inc_return(
+				&master->discard.step) - 1) * step_sects;
+		if (req->discard.handled >= req->discard.nr_sects ||
+				master->discard.error) {
+			_ocf_discard_worker_done(req);
+			return 0;
+		}
+
+		req->byte_position = SECTORS_TO_BYTES(req->discard.sector +
+				req->discard.handled);
+		req->byte_length = OCF_MIN(SECTORS_TO_BYTES(
+				req->discard.nr_sects - req->discard.handled),
+				MAX_TRIM_RQ_SIZE);
+		req->core_line_first = ocf_bytes_2_lines(cache,
+				req->byte_position);
+		req->core_line_last = ocf_bytes_2_lines(cache,
+				req->byte_position + req->byte_length - 1);
+
+		/* Steps without mapped core lines need no metadata access */
+	} while (!ocf_core_index_range_mapped(core, req->core_line_first,
+			req->core_line_last));
+
 	req->core_line_count = req->core_line_last - req->core_line_first + 1;
 	req->io_if = &_io_if_discard_step_resume;
 
-	OCF_METADATA_LOCK_RD(); /*- Metadata READ access, No eviction --------*/
-
 	ENV_BUG_ON(env_memset(req->map, sizeof(*req->map) * req->core_line_count,
 			0));
 
+	ocf_req_hash_lock_rd(req); /*- Metadata READ access, No eviction -----*/
+
 	/* Travers to check if request is mapped fully */
 	ocf_engine_traverse(req);
 
@@ -230,7 +280,7 @@ static int _ocf_discard_step(struct ocf_request *req)
 		lock = OCF_LOCK_ACQUIRED;
 	}
 
-	OCF_METADATA_UNLOCK_RD(); /*- END Metadata READ access----------------*/
+	ocf_req_hash_unlock_rd(req); /*- END Metadata READ access-------------*/
 
 	if (lock >= 0) {
 		if (OCF_LOCK_ACQUIRED == lock) {
@@ -250,8 +300,44 @@ static int _ocf_discard_step(struct ocf_request *req)
 	return 0;
 }
 
+static void _ocf_discard_helper_complete(struct ocf_request *req, int error)
+{
+}
+
+/*
+ * Start helper requests which handle steps of master request range
+ * concurrently with it. Each of them has own map of single step.
+ */
+static void _ocf_discard_start_helpers(struct ocf_request *master,
+		uint32_t count)
+{
+	ocf_core_t core = &master->cache->core[master->core_id];
+	struct ocf_request *req;
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		req = ocf_req_new_extended(master->io_queue, core,
+				master->byte_position, MAX_TRIM_RQ_SIZE,
+				OCF_WRITE);
+		if (!req)
+			break;
+
+		req->info.internal = true;
+		req->discard = master->discard;
+		req->complete = _ocf_discard_helper_complete;
+		req->resume = _ocf_discard_on_resume;
+		req->io_if = &_io_if_discard_step;
+
+		env_atomic_inc(&master->discard.workers);
+		ocf_engine_push_req_front(req, true);
+	}
+}
+
 int ocf_discard(struct ocf_request *req)
 {
+	struct ocf_cache *cache = req->cache;
+	uint64_t steps;
+
 	OCF_DEBUG_TRACE(req->cache);
 
 	ocf_io_start(req->io);
@@ -267,7 +353,23 @@ int ocf_discard(struct ocf_request *req)
 	/* Set resume call backs */
 	req->resume = _ocf_discard_on_resume;
 
-	_ocf_discard_step(req);
+	req->discard.master = req;
+	req->discard.error = 0;
+	req->discard.purged = false;
+	env_atomic_set(&req->discard.step, 0);
+	env_atomic_set(&req->discard.workers, 1);
+
+	if (!env_atomic_read(&cache->core_runtime_meta[req->core_id].
+			cached_clines)) {
+		/* Nothing of core is cached, discard core only */
+		_ocf_discard_worker_done(req);
+	} else {
+		steps = OCF_DIV_ROUND_UP((uint64_t)req->discard.nr_sects,
+				BYTES_TO_SECTORS(MAX_TRIM_RQ_SIZE));
+		_ocf_discard_start_helpers(req, OCF_MIN(steps,
+				(uint64_t)OCF_DISCARD_WORKERS) - 1);
+		_ocf_discard_step(req);
+	}
 
 	/* Put OCF request - decrease reference counter */
 	ocf_req_put(req);
@@ -9,9 +9,11 @@
 #include "engine_common.h"
 #include "engine_pt.h"
 #include "engine_wb.h"
+#include "engine_wt.h"
 #include "../utils/utils_req.h"
 #include "../utils/utils_part.h"
 #include "../utils/utils_io.h"
+#include "../utils/utils_ram_tier.h"
 #include "../concurrency/ocf_concurrency.h"
 #include "../metadata/metadata.h"
 
@@ -43,10 +45,12 @@ static void _ocf_read_fast_complete(struct ocf_request *req, int error)
 	if (req->error) {
 		OCF_DEBUG_RQ(req, "ERROR");
 
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				cache_errors.read);
 		ocf_engine_push_req_front_pt(req);
 	} else {
+		ocf_ram_tier_fill(req);
+
 		ocf_req_unlock(req);
 
 		/* Complete request */
@@ -59,8 +63,6 @@ static void _ocf_read_fast_complete(struct ocf_request *req, int error)
 
 static int _ocf_read_fast_do(struct ocf_request *req)
 {
-	struct ocf_cache *cache = req->cache;
-
 	if (ocf_engine_is_miss(req)) {
 		/* It seams that after resume, now request is MISS, do PT */
 		OCF_DEBUG_RQ(req, "Switching to read PT");
@@ -75,14 +77,10 @@ static int _ocf_read_fast_do(struct ocf_request *req)
 	if (req->info.re_part) {
 		OCF_DEBUG_RQ(req, "Re-Part");
 
-		OCF_METADATA_LOCK_WR();
-
 		/* Probably some cache lines are assigned into wrong
 		 * partition. Need to move it to new one
 		 */
-		ocf_part_move(req);
-
-		OCF_METADATA_UNLOCK_WR();
+		ocf_part_move_deferred(req);
 	}
 
 	/* Submit IO */
@@ -107,11 +105,78 @@ static const struct ocf_io_if _io_if_read_fast_resume = {
 		.write = _ocf_read_fast_do,
 };
 
+/*
+ * Look up request and try to lock its cache lines if it is served in fast
+ * path, i.e. it is a hit for read or all its cache lines are mapped for
+ * write. Hash buckets of nested lookup are locked with global metadata lock
+ * already held by caller.
+ */
+static bool _ocf_fast_lookup(struct ocf_request *req, bool nested, int *lock)
+{
+	bool fast;
+
+	/*- Metadata RD access -----------------------------------------------*/
+
+	if (nested)
+		ocf_req_hash_lock_rd_nested(req);
+	else
+		ocf_req_hash_lock_rd(req);
+
+	/* Traverse request to cache if there is hit */
+	ocf_engine_traverse(req);
+
+	if (req->rw == OCF_WRITE)
+		fast = ocf_engine_is_mapped(req);
+	else
+		fast = ocf_engine_is_hit(req);
+
+	if (fast) {
+		ocf_io_start(req->io);
+		*lock = req->rw == OCF_WRITE ? ocf_req_trylock_wr(req) :
+				ocf_req_trylock_rd(req);
+	}
+
+	if (nested)
+		ocf_req_hash_unlock_rd_nested(req);
+	else
+		ocf_req_hash_unlock_rd(req);
+
+	return fast;
+}
+
+/* Perform IO of request found in fast path, once cache lines are locked */
+static void _ocf_fast_start(struct ocf_request *req, int lock)
+{
+	if (lock < 0) {
+		OCF_DEBUG_RQ(req, "LOCK ERROR");
+		req->complete(req, lock);
+		ocf_req_put(req);
+		return;
+	}
+
+	OCF_DEBUG_RQ(req, "Fast path success");
+
+	if (lock != OCF_LOCK_ACQUIRED) {
+		/* Lock was not acquired, need to wait for resume */
+		OCF_DEBUG_RQ(req, "NO LOCK");
+		return;
+	}
+
+	/* Lock was acquired can perform IO */
+	if (req->rw == OCF_WRITE)
+		req->io_if->write(req);
+	else
+		req->io_if->read(req);
+}
+
 int ocf_read_fast(struct ocf_request *req)
 {
 	bool hit;
 	int lock = OCF_LOCK_NOT_ACQUIRED;
-	struct ocf_cache *cache = req->cache;
+
+	/* Hits moved to upper tier need write lock of generic read */
+	if (ocf_core_tier_exclusive(&req->cache->core[req->core_id]))
+		return OCF_FAST_PATH_NO;
 
 	/* Get OCF request - increase reference counter */
 	ocf_req_get(req);
@@ -120,40 +185,11 @@ int ocf_read_fast(struct ocf_request *req)
 	req->resume = ocf_engine_on_resume;
 	req->io_if = &_io_if_read_fast_resume;
 
-	/*- Metadata RD access -----------------------------------------------*/
-
-	OCF_METADATA_LOCK_RD();
-
-	/* Traverse request to cache if there is hit */
-	ocf_engine_traverse(req);
-
-	hit = ocf_engine_is_hit(req);
-	if (hit) {
-		ocf_io_start(req->io);
-		lock = ocf_req_trylock_rd(req);
-	}
-
-	OCF_METADATA_UNLOCK_RD();
-
-	if (hit) {
-		OCF_DEBUG_RQ(req, "Fast path success");
-
-		if (lock >= 0) {
-			if (lock != OCF_LOCK_ACQUIRED) {
-				/* Lock was not acquired, need to wait for resume */
-				OCF_DEBUG_RQ(req, "NO LOCK");
-			} else {
-				/* Lock was acquired can perform IO */
-				_ocf_read_fast_do(req);
-			}
-		} else {
-			OCF_DEBUG_RQ(req, "LOCK ERROR");
-			req->complete(req, lock);
-			ocf_req_put(req);
-		}
-	} else {
+	hit = _ocf_fast_lookup(req, false, &lock);
+	if (hit)
+		_ocf_fast_start(req, lock);
+	else
 		OCF_DEBUG_RQ(req, "Fast path failure");
-	}
 
 	/* Put OCF request - decrease reference counter */
 	ocf_req_put(req);
@@ -177,57 +213,120 @@ static const struct ocf_io_if _io_if_write_fast_resume = {
 		.write = ocf_write_wb_do,
 };
 
-int ocf_write_fast(struct ocf_request *req)
+static const struct ocf_io_if _io_if_write_wt_fast_resume = {
+		.read = ocf_write_wt_do,
+		.write = ocf_write_wt_do,
+};
+
+/*
+ * Write to mapped cache lines in submitter context. Write-back only updates
+ * cache lines, while write-through submits both cache and core writes.
+ */
+static int _ocf_write_fast(struct ocf_request *req,
+		const struct ocf_io_if *io_if)
 {
 	bool mapped;
 	int lock = OCF_LOCK_NOT_ACQUIRED;
-	struct ocf_cache *cache = req->cache;
 
 	/* Get OCF request - increase reference counter */
 	ocf_req_get(req);
 
 	/* Set resume call backs */
 	req->resume = ocf_engine_on_resume;
-	req->io_if = &_io_if_write_fast_resume;
+	req->io_if = io_if;
 
-	/*- Metadata RD access -----------------------------------------------*/
+	mapped = _ocf_fast_lookup(req, false, &lock);
+	if (mapped)
+		_ocf_fast_start(req, lock);
+	else
+		OCF_DEBUG_RQ(req, "Fast path failure");
 
-	OCF_METADATA_LOCK_RD();
+	/* Put OCF request - decrease reference counter */
+	ocf_req_put(req);
 
-	/* Traverse request to cache if there is hit */
-	ocf_engine_traverse(req);
+	return mapped ? OCF_FAST_PATH_YES : OCF_FAST_PATH_NO;
+}
 
-	mapped = ocf_engine_is_mapped(req);
-	if (mapped) {
-		ocf_io_start(req->io);
-		lock = ocf_req_trylock_wr(req);
-	}
+int ocf_write_fast(struct ocf_request *req)
+{
+	return _ocf_write_fast(req, &_io_if_write_fast_resume);
+}
 
-	OCF_METADATA_UNLOCK_RD();
-
-	if (mapped) {
-		if (lock >= 0) {
-			OCF_DEBUG_RQ(req, "Fast path success");
-
-			if (lock != OCF_LOCK_ACQUIRED) {
-				/* Lock was not acquired, need to wait for resume */
-				OCF_DEBUG_RQ(req, "NO LOCK");
-			} else {
-				/* Lock was acquired can perform IO */
-				ocf_write_wb_do(req);
-			}
-		} else {
-			OCF_DEBUG_RQ(req, "Fast path lock failure");
-			req->complete(req, lock);
-			ocf_req_put(req);
-		}
+int ocf_write_wt_fast(struct ocf_request *req)
+{
+	return _ocf_write_fast(req, &_io_if_write_wt_fast_resume);
+}
+
+/*  ____        _       _        ______        _     _____      _   _
+ * |  _ \      | |     | |      |  ____|      | |   |  __ \    | | | |
+ * | |_) | __ _| |_ ___| |__    | |__ __ _ ___| |_  | |__) |_ _| |_| |__
+ * |  _ < / _` | __/ __| '_ \   |  __/ _` / __| __| |  ___/ _` | __| '_ \
+ * | |_) | (_| | || (__| | | |  | | | (_| \__ \ |_  | |  | (_| | |_| | | |
+ * |____/ \__,_|\__\___|_| |_|  |_|  \__,_|___/\__| |_|   \__,_|\__|_| |_|
+ */
+
+int ocf_engine_fast_lookup(struct ocf_request *req,
+		ocf_req_cache_mode_t req_cache_mode, bool *start)
+{
+	const struct ocf_io_if *io_if = req->io_if;
+	int lock = OCF_LOCK_NOT_ACQUIRED;
+	bool fast;
+
+	*start = false;
+
+	if (req->rw == OCF_WRITE) {
+		if (req_cache_mode == ocf_req_cache_mode_wb)
+			req->io_if = &_io_if_write_fast_resume;
+		else if (req_cache_mode == ocf_req_cache_mode_wt)
+			req->io_if = &_io_if_write_wt_fast_resume;
+		else
+			return OCF_FAST_PATH_NO;
 	} else {
+		if (!ocf_cache_mode_is_valid((ocf_cache_mode_t)req_cache_mode) ||
+				req_cache_mode == ocf_req_cache_mode_pt) {
+			return OCF_FAST_PATH_NO;
+		}
+
+		/* Hits moved to upper tier need write lock of generic read */
+		if (ocf_core_tier_exclusive(&req->cache->core[req->core_id]))
+			return OCF_FAST_PATH_NO;
+
+		req->io_if = &_io_if_read_fast_resume;
+	}
+
+	/* Get OCF request - increase reference counter */
+	ocf_req_get(req);
+
+	/* Set resume call backs */
+	req->resume = ocf_engine_on_resume;
+
+	fast = _ocf_fast_lookup(req, true, &lock);
+	if (!fast) {
 		OCF_DEBUG_RQ(req, "Fast path failure");
+
+		/* Request goes to I/O queue as it was prepared */
+		req->io_if = io_if;
+		ocf_req_put(req);
+		return OCF_FAST_PATH_NO;
 	}
 
-	/* Put OCF request - decrease reference counter */
-	ocf_req_put(req);
+	if (lock == OCF_LOCK_NOT_ACQUIRED) {
+		/* Resumed once cache lines are locked */
+		_ocf_fast_start(req, lock);
+		ocf_req_put(req);
+	} else {
+		/* Lock error is reported once metadata lock is released */
+		req->error = lock < 0 ? lock : 0;
+		*start = true;
+	}
 
-	return mapped ? OCF_FAST_PATH_YES : OCF_FAST_PATH_NO;
+	return OCF_FAST_PATH_YES;
+}
+
+void ocf_engine_fast_start(struct ocf_request *req)
+{
+	_ocf_fast_start(req, req->error ?: OCF_LOCK_ACQUIRED);
 
+	/* Put OCF request - decrease reference counter */
+	ocf_req_put(req);
 }
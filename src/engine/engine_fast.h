@@ -8,5 +8,32 @@
 
 int ocf_read_fast(struct ocf_request *req);
 int ocf_write_fast(struct ocf_request *req);
+int ocf_write_wt_fast(struct ocf_request *req);
+
+/**
+ * @brief Look up request of batch in fast path
+ *
+ * Caller holds global metadata lock for shared access, taken once for all
+ * requests of the batch. Request found in fast path with its cache lines
+ * locked is started with ocf_engine_fast_start() once the lock is released,
+ * as its completion may need metadata lock.
+ *
+ * @param req - OCF request prepared to be pushed to I/O queue
+ * @param req_cache_mode - Cache mode request was prepared for
+ * @param start - Set if request has to be started by caller
+ *
+ * @retval OCF_FAST_PATH_YES Request is handled in fast path
+ * @retval OCF_FAST_PATH_NO Request has to be pushed to I/O queue
+ */
+int ocf_engine_fast_lookup(struct ocf_request *req,
+		ocf_req_cache_mode_t req_cache_mode, bool *start);
+
+/**
+ * @brief Start request of batch found in fast path with its cache lines
+ *	locked
+ *
+ * @param req - OCF request
+ */
+void ocf_engine_fast_start(struct ocf_request *req);
 
 #endif /* ENGINE_WI_H_ */
@@ -20,7 +20,7 @@ static void _ocf_invalidate_req(struct ocf_request *req, int error)
 {
 	if (error) {
 		req->error = error;
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				cache_errors.write);
 	}
 
@@ -45,7 +45,13 @@ static int _ocf_invalidate_do(struct ocf_request *req)
 	ENV_BUG_ON(env_atomic_read(&req->req_remaining));
 
 	OCF_METADATA_LOCK_WR();
-	ocf_purge_map_info(req);
+	/* Merged read miss and promoted hit cover dirty sectors they have
+	 * only read
+	 */
+	if (req->info.dirty_merge || req->info.tier_promote)
+		ocf_purge_clean_map_info(req);
+	else
+		ocf_purge_map_info(req);
 	OCF_METADATA_UNLOCK_WR();
 
 	env_atomic_inc(&req->req_remaining);
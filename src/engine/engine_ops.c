@@ -13,6 +13,98 @@
 #define OCF_ENGINE_DEBUG_IO_NAME "ops"
 #include "engine_debug.h"
 
+static int _ocf_engine_ops_submit(struct ocf_request *req);
+
+static const struct ocf_io_if _io_if_ops_submit = {
+	.read = _ocf_engine_ops_submit,
+	.write = _ocf_engine_ops_submit,
+};
+
+void ocf_engine_ops_init(ocf_core_t core)
+{
+	struct ocf_core_flush_group *group = &core->flush_group;
+
+	env_spinlock_init(&group->lock);
+	group->inflight = false;
+	INIT_LIST_HEAD(&group->members);
+	INIT_LIST_HEAD(&group->pending);
+}
+
+static inline uint64_t _ocf_engine_ops_flags(struct ocf_request *req)
+{
+	return req->io ? req->io->flags : 0;
+}
+
+/* Advance generation of cache writes covered by completed flush */
+static void _ocf_engine_ops_update_flushed(ocf_cache_t cache, uint64_t gen)
+{
+	long old;
+
+	do {
+		old = env_atomic64_read(&cache->flush_gen.flushed);
+		if (old >= (long)gen)
+			return;
+	} while (env_atomic64_cmpxchg(&cache->flush_gen.flushed, old,
+			gen) != old);
+}
+
+/*
+ * Complete flush together with requests which joined it and start next
+ * flush for requests which arrived in the meantime. Only requests with the
+ * same flags join single flush.
+ */
+static void _ocf_engine_ops_finish(struct ocf_request *req)
+{
+	struct ocf_core_flush_group *group =
+			&req->cache->core[req->core_id].flush_group;
+	struct ocf_request *iter, *tmp, *next = NULL;
+	struct list_head done;
+
+	INIT_LIST_HEAD(&done);
+
+	if (!req->error)
+		_ocf_engine_ops_update_flushed(req->cache, group->gen);
+
+	env_spinlock_lock(&group->lock);
+
+	while (!list_empty(&group->members))
+		list_move_tail(group->members.next, &done);
+
+	if (!list_empty(&group->pending)) {
+		next = list_first_entry(&group->pending, struct ocf_request,
+				list);
+		list_del(&next->list);
+
+		list_for_each_entry_safe(iter, tmp, &group->pending, list) {
+			if (_ocf_engine_ops_flags(iter) ==
+					_ocf_engine_ops_flags(next)) {
+				list_move_tail(&iter->list, &group->members);
+			}
+		}
+	} else {
+		group->inflight = false;
+	}
+
+	env_spinlock_unlock(&group->lock);
+
+	list_for_each_entry_safe(iter, tmp, &done, list) {
+		list_del(&iter->list);
+		iter->complete(iter, req->error);
+		ocf_req_put(iter);
+	}
+
+	/* Complete requests - both to cache and to core*/
+	req->complete(req, req->error);
+
+	/* Release OCF request */
+	ocf_req_put(req);
+
+	if (next) {
+		next->io_if = &_io_if_ops_submit;
+		ocf_engine_push_req_front(next, true);
+	}
+}
+
 static void _ocf_engine_ops_complete(struct ocf_request *req, int error)
 {
 	if (error)
@@ -28,31 +120,37 @@ static void _ocf_engine_ops_complete(struct ocf_request *req, int error)
 		ocf_engine_error(req, false, "Core operation failure");
 	}
 
-	/* Complete requests - both to cache and to core*/
-	req->complete(req, req->error);
-
-	/* Release OCF request */
-	ocf_req_put(req);
+	_ocf_engine_ops_finish(req);
 }
 
-int ocf_engine_ops(struct ocf_request *req)
+static int _ocf_engine_ops_submit(struct ocf_request *req)
 {
 	struct ocf_cache *cache = req->cache;
-
-	OCF_DEBUG_TRACE(req->cache);
+	struct ocf_core_flush_group *group =
+			&cache->core[req->core_id].flush_group;
+	bool flush_cache;
 
 	/* Get OCF request - increase reference counter */
 	ocf_req_get(req);
 
+	/* Cache volume holds nothing that previous flush didn't make
+	 * durable, unless dirty data or metadata was written since then
+	 */
+	group->gen = env_atomic64_read(&cache->flush_gen.written);
+	flush_cache = group->gen !=
+			env_atomic64_read(&cache->flush_gen.flushed);
+
 	/* IO to the core device and to the cache device */
-	env_atomic_set(&req->req_remaining, 2);
+	env_atomic_set(&req->req_remaining, flush_cache ? 2 : 1);
 
 	/* Submit operation into core device */
 	ocf_submit_volume_req(&cache->core[req->core_id].volume, req,
 			_ocf_engine_ops_complete);
 
-	ocf_submit_cache_reqs(cache, req->map, req, req->rw,
-			1, _ocf_engine_ops_complete);
+	if (flush_cache) {
+		ocf_submit_cache_reqs(cache, req->map, req, req->rw,
+				1, _ocf_engine_ops_complete);
+	}
 
 	/* Put OCF request - decrease reference counter */
 	ocf_req_put(req);
@@ -60,4 +158,24 @@ int ocf_engine_ops(struct ocf_request *req)
 	return 0;
 }
 
+int ocf_engine_ops(struct ocf_request *req)
+{
+	struct ocf_core_flush_group *group =
+			&req->cache->core[req->core_id].flush_group;
 
+	OCF_DEBUG_TRACE(req->cache);
+
+	env_spinlock_lock(&group->lock);
+	if (group->inflight) {
+		/* Flush in progress may have started before data which
+		 * request flushes was written, wait for the next one
+		 */
+		list_add_tail(&req->list, &group->pending);
+		env_spinlock_unlock(&group->lock);
+		return 0;
+	}
+	group->inflight = true;
+	env_spinlock_unlock(&group->lock);
+
+	return _ocf_engine_ops_submit(req);
+}
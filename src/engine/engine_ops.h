@@ -8,4 +8,6 @@
 
 int ocf_engine_ops(struct ocf_request *req);
 
+void ocf_engine_ops_init(ocf_core_t core);
+
 #endif /* __CACHE_ENGINE_OPS_H_ */
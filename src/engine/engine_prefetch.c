@@ -0,0 +1,267 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_ctx_priv.h"
+#include "engine_prefetch.h"
+#include "engine_inv.h"
+#include "engine_bf.h"
+#include "engine_common.h"
+#include "cache_engine.h"
+#include "../concurrency/ocf_concurrency.h"
+#include "../utils/utils_io.h"
+#include "../utils/utils_req.h"
+#include "../utils/utils_cache_line.h"
+#include "../utils/utils_part.h"
+#include "../utils/utils_data.h"
+#include "../metadata/metadata.h"
+
+#define OCF_ENGINE_DEBUG_IO_NAME "prefetch"
+#include "engine_debug.h"
+
+/*
+ * Read-ahead request is internal, it has no OCF IO. It owns its data buffer,
+ * which is freed by backfill once read data is written to cache. Request is
+ * completed once data is read from core or request is dropped, backfill
+ * goes on in background.
+ */
+
+static void _ocf_prefetch_complete(struct ocf_request *req, int error)
+{
+}
+
+static void _ocf_prefetch_drop(struct ocf_request *req, int error)
+{
+	OCF_DEBUG_RQ(req, "Drop");
+
+	req->complete(req, error);
+
+	ocf_req_unlock(req);
+	ocf_req_put(req);
+}
+
+static void _ocf_prefetch_read_complete(struct ocf_request *req, int error)
+{
+	struct ocf_cache *cache = req->cache;
+
+	if (error)
+		req->error = error;
+
+	if (env_atomic_dec_return(&req->req_remaining))
+		return;
+
+	OCF_DEBUG_RQ(req, "Read completion");
+
+	req->complete(req, req->error);
+
+	if (req->error) {
+		env_atomic_inc(&ocf_req_core_stats(req)->core_errors.read);
+
+		ocf_data_put_locked(cache->owner, req->cp_data,
+				BYTES_TO_PAGES(req->byte_length));
+		req->cp_data = NULL;
+		req->data = NULL;
+
+		/* Invalidate metadata */
+		ocf_engine_invalidate(req);
+		return;
+	}
+
+	ocf_engine_backfill(req);
+}
+
+static int _ocf_prefetch_do(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+
+	/* Range could have been accessed meanwhile, don't replace
+	 * data which is already in cache
+	 */
+	if (req->info.hit_no || req->info.dirty_any) {
+		_ocf_prefetch_drop(req, 0);
+		return 0;
+	}
+
+	req->cp_data = ocf_data_get_locked(cache->owner,
+			BYTES_TO_PAGES(req->byte_length));
+	if (!req->cp_data) {
+		_ocf_prefetch_drop(req, -OCF_ERR_NO_MEM);
+		return 0;
+	}
+
+	req->data = req->cp_data;
+
+	OCF_METADATA_LOCK_RD();
+
+	/* Set valid status bits map */
+	ocf_set_valid_map_info(req);
+
+	OCF_METADATA_UNLOCK_RD();
+
+	if (req->info.re_part) {
+		OCF_DEBUG_RQ(req, "Re-Part");
+
+		ocf_part_move_deferred(req);
+	}
+
+	OCF_DEBUG_RQ(req, "Submit");
+
+	env_atomic_set(&req->req_remaining, 1);
+
+	ocf_submit_volume_req(&cache->core[req->core_id].volume, req,
+			_ocf_prefetch_read_complete);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_prefetch_resume = {
+	.read = _ocf_prefetch_do,
+	.write = _ocf_prefetch_do,
+};
+
+static int _ocf_prefetch_lock_clines(struct ocf_request *req)
+{
+	/* Cache insert will be performed - lock for WRITE is required */
+	return ocf_req_trylock_wr(req);
+}
+
+static int _ocf_prefetch(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	int lock;
+
+	/* Warm-up bounds number of its requests by itself */
+	if (!req->info.warm && env_atomic_read(
+			&cache->pending_read_misses_list_blocked)) {
+		req->complete(req, 0);
+		ocf_req_put(req);
+		return 0;
+	}
+
+	/* Skip mapping if any part of range is already cached */
+	ocf_req_hash_lock_rd(req);
+	ocf_engine_traverse(req);
+	ocf_req_hash_unlock_rd(req);
+
+	if (ocf_engine_mapped_count(req)) {
+		req->complete(req, 0);
+		ocf_req_put(req);
+		return 0;
+	}
+
+	/* Get OCF request - increase reference counter */
+	ocf_req_get(req);
+
+	/* Set resume call backs */
+	req->resume = ocf_engine_on_resume;
+	req->io_if = &_io_if_prefetch_resume;
+
+	lock = ocf_engine_prepare_clines(req, _ocf_prefetch_lock_clines);
+
+	if (!req->info.eviction_error) {
+		if (lock >= 0) {
+			if (lock != OCF_LOCK_ACQUIRED) {
+				/* Lock was not acquired, need to wait for resume */
+				OCF_DEBUG_RQ(req, "NO LOCK");
+			} else {
+				/* Lock was acquired can perform IO */
+				_ocf_prefetch_do(req);
+			}
+		} else {
+			OCF_DEBUG_RQ(req, "LOCK ERROR %d", lock);
+			req->complete(req, lock);
+			ocf_req_put(req);
+		}
+	} else {
+		/* Cache lines could not be evicted, range is skipped */
+		ocf_req_clear(req);
+		req->complete(req, 0);
+		ocf_req_put(req);
+	}
+
+	/* Put OCF request - decrease reference counter */
+	ocf_req_put(req);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_prefetch = {
+	.read = _ocf_prefetch,
+	.write = _ocf_prefetch,
+};
+
+/* Read misses of partition are inserted into cache */
+static bool _ocf_prefetch_part_inserts(struct ocf_cache *cache,
+		ocf_part_id_t part_id)
+{
+	ocf_cache_mode_t mode;
+
+	if (ocf_fallback_pt_is_on(cache))
+		return false;
+
+	mode = ocf_part_get_cache_mode(cache, part_id);
+	if (!ocf_cache_mode_is_valid(mode))
+		mode = cache->conf_meta->cache_mode;
+
+	return mode != ocf_cache_mode_pt;
+}
+
+void ocf_engine_prefetch(struct ocf_request *req, uint64_t addr,
+		uint32_t bytes)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_core_t core = &cache->core[req->core_id];
+	struct ocf_request *prefetch;
+
+	if (req->d2c || !_ocf_prefetch_part_inserts(cache, req->part_id))
+		return;
+
+	if (env_atomic_read(&cache->pending_read_misses_list_blocked))
+		return;
+
+	prefetch = ocf_req_new_extended(req->io_queue, core, addr, bytes,
+			OCF_READ);
+	if (!prefetch)
+		return;
+
+	prefetch->info.internal = true;
+	prefetch->part_id = req->part_id;
+	prefetch->complete = _ocf_prefetch_complete;
+	prefetch->io_if = &_io_if_prefetch;
+
+	ocf_engine_push_req_back(prefetch, true);
+}
+
+int ocf_engine_warm(ocf_queue_t queue, ocf_core_t core, uint64_t addr,
+		uint32_t bytes, ocf_part_id_t part_id, ocf_req_end_t complete,
+		void *priv)
+{
+	struct ocf_cache *cache = ocf_core_get_cache(core);
+	struct ocf_request *warm;
+
+	if (!_ocf_prefetch_part_inserts(cache, part_id))
+		return 1;
+
+	warm = ocf_req_new_extended(queue, core, addr, bytes, OCF_READ);
+	if (!warm)
+		return -OCF_ERR_NO_MEM;
+
+	if (warm->d2c) {
+		ocf_req_put(warm);
+		return 1;
+	}
+
+	warm->info.internal = true;
+	warm->info.warm = true;
+	warm->part_id = part_id;
+	warm->priv = priv;
+	warm->complete = complete;
+	warm->io_if = &_io_if_prefetch;
+
+	ocf_engine_push_req_back(warm, true);
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef ENGINE_PREFETCH_H_
+#define ENGINE_PREFETCH_H_
+
+/**
+ * @brief Read ahead core range following sequential read
+ *
+ * @param req Read request continuing sequential stream
+ * @param addr Byte position of range to be read into cache
+ * @param bytes Length of range to be read into cache
+ *
+ * @note Range is read from core and inserted into cache through backfill
+ *	only if none of its cache lines is mapped. Read-ahead is best-effort,
+ *	it is dropped silently if it cannot be done.
+ */
+void ocf_engine_prefetch(struct ocf_request *req, uint64_t addr,
+		uint32_t bytes);
+
+/**
+ * @brief Read core range into cache on behalf of cache warm-up
+ *
+ * @param queue I/O queue on which request is handled
+ * @param core Core of range
+ * @param addr Byte position of range to be read into cache
+ * @param bytes Length of range to be read into cache
+ * @param part_id Partition into which range is inserted
+ * @param complete Completion called once range is read from core or skipped
+ * @param priv Completion context, set as private data of request
+ *
+ * @retval 0 Request was issued, completion will be called
+ * @retval 1 Partition does not insert read misses into cache, range skipped
+ * @retval -OCF_ERR_NO_MEM Request could not be allocated
+ *
+ * @note Unlike read-ahead, warm-up request is not dropped when backfill
+ *	queue is full. It is skipped if any cache line of range is mapped.
+ */
+int ocf_engine_warm(ocf_queue_t queue, ocf_core_t core, uint64_t addr,
+		uint32_t bytes, ocf_part_id_t part_id, ocf_req_end_t complete,
+		void *priv);
+
+#endif /* ENGINE_PREFETCH_H_ */
@@ -28,7 +28,7 @@ static void _ocf_read_pt_complete(struct ocf_request *req, int error)
 
 	if (req->error) {
 		req->info.core_error = 1;
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				core_errors.read);
 	}
 
@@ -76,14 +76,10 @@ int ocf_read_pt_do(struct ocf_request *req)
 	if (req->info.re_part) {
 		OCF_DEBUG_RQ(req, "Re-Part");
 
-		OCF_METADATA_LOCK_WR();
-
 		/* Probably some cache lines are assigned into wrong
 		 * partition. Need to move it to new one
 		 */
-		ocf_part_move(req);
-
-		OCF_METADATA_UNLOCK_WR();
+		ocf_part_move_deferred(req);
 	}
 
 	/* Submit read IO to the core */
@@ -91,7 +87,7 @@ int ocf_read_pt_do(struct ocf_request *req)
 
 	/* Update statistics */
 	ocf_engine_update_block_stats(req);
-	env_atomic64_inc(&cache->core[req->core_id].counters->
+	env_atomic64_inc(&ocf_req_core_stats(req)->
 			part_counters[req->part_id].read_reqs.pass_through);
 
 	/* Put OCF request - decrease reference counter */
@@ -109,7 +105,6 @@ int ocf_read_pt(struct ocf_request *req)
 {
 	bool use_cache = false;
 	int lock = OCF_LOCK_NOT_ACQUIRED;
-	struct ocf_cache *cache = req->cache;
 
 	OCF_DEBUG_TRACE(req->cache);
 
@@ -122,7 +117,7 @@ int ocf_read_pt(struct ocf_request *req)
 	req->resume = ocf_engine_on_resume;
 	req->io_if = &_io_if_pt_resume;
 
-	OCF_METADATA_LOCK_RD(); /*- Metadata RD access -----------------------*/
+	ocf_req_hash_lock_rd(req); /*- Metadata RD access --------------------*/
 
 	/* Traverse request to check if there are mapped cache lines */
 	ocf_engine_traverse(req);
@@ -141,7 +136,7 @@ int ocf_read_pt(struct ocf_request *req)
 		}
 	}
 
-	OCF_METADATA_UNLOCK_RD(); /*- END Metadata RD access -----------------*/
+	ocf_req_hash_unlock_rd(req); /*- END Metadata RD access --------------*/
 
 	if (use_cache) {
 		/*
@@ -16,6 +16,9 @@
 #include "../utils/utils_req.h"
 #include "../utils/utils_cache_line.h"
 #include "../utils/utils_part.h"
+#include "../utils/utils_data.h"
+#include "../utils/utils_ram_tier.h"
+#include "../utils/utils_fill.h"
 #include "../metadata/metadata.h"
 #include "../ocf_def_priv.h"
 
@@ -38,10 +41,16 @@ static void _ocf_read_generic_hit_complete(struct ocf_request *req, int error)
 		OCF_DEBUG_RQ(req, "HIT completion");
 
 		if (req->error) {
-			env_atomic_inc(&req->cache->core[req->core_id].
-				counters->cache_errors.read);
+			env_atomic_inc(&ocf_req_core_stats(req)->
+					cache_errors.read);
 			ocf_engine_push_req_front_pt(req);
+		} else if (req->info.tier_promote) {
+			req->complete(req, req->error);
+
+			/* Data moved to upper tier, drop clean copy */
+			ocf_engine_invalidate(req);
 		} else {
+			ocf_ram_tier_fill(req);
 
 			ocf_req_unlock(req);
 
@@ -78,11 +87,14 @@ static void _ocf_read_generic_miss_complete(struct ocf_request *req, int error)
 			req->complete(req, req->error);
 
 			req->info.core_error = 1;
-			env_atomic_inc(&cache->core[req->core_id].
-					counters->core_errors.read);
+			env_atomic_inc(&ocf_req_core_stats(req)->
+					core_errors.read);
 
-			ctx_data_free(cache->owner, req->cp_data);
-			req->cp_data = NULL;
+			if (req->cp_data) {
+				ocf_data_put_locked(cache->owner, req->cp_data,
+						BYTES_TO_PAGES(req->byte_length));
+				req->cp_data = NULL;
+			}
 
 			/* Invalidate metadata */
 			ocf_engine_invalidate(req);
@@ -90,11 +102,19 @@ static void _ocf_read_generic_miss_complete(struct ocf_request *req, int error)
 			return;
 		}
 
+		/* Zero copy backfill writes request data and completes
+		 * request once it is done
+		 */
+		if (!req->cp_data) {
+			ocf_engine_backfill(req);
+			return;
+		}
+
 		/* Copy pages to copy vec, since this is the one needed
 		 * by the above layer
 		 */
-		ctx_data_cpy(cache->owner, req->cp_data, req->data, 0, 0,
-				req->byte_length);
+		ctx_data_cpy(cache->owner, req->cp_data, req->data, 0,
+				req->data_offset, req->byte_length);
 
 		/* Complete request */
 		req->complete(req, req->error);
@@ -111,32 +131,261 @@ static inline void _ocf_read_generic_submit_hit(struct ocf_request *req)
 		ocf_engine_io_count(req), _ocf_read_generic_hit_complete);
 }
 
-static inline void _ocf_read_generic_submit_miss(struct ocf_request *req)
+/* Allocate buffer for data backfilled after request is completed */
+static int _ocf_read_generic_alloc_cp_data(struct ocf_request *req)
 {
 	struct ocf_cache *cache = req->cache;
-	int ret;
 
-	env_atomic_set(&req->req_remaining, 1);
+	if (cache->backfill.zero_copy)
+		return 0;
 
-	req->cp_data = ctx_data_alloc(cache->owner,
+	req->cp_data = ocf_data_get_locked(cache->owner,
 			BYTES_TO_PAGES(req->byte_length));
 	if (!req->cp_data)
-		goto err_alloc;
+		return -ENOMEM;
 
-	ret = ctx_data_mlock(cache->owner, req->cp_data);
-	if (ret)
-		goto err_alloc;
+	return 0;
+}
+
+static inline void _ocf_read_generic_submit_miss(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+
+	env_atomic_set(&req->req_remaining, 1);
+
+	if (_ocf_read_generic_alloc_cp_data(req)) {
+		_ocf_read_generic_miss_complete(req, -ENOMEM);
+		return;
+	}
 
 	/* Submit read request to core device. */
 	ocf_submit_volume_req(&cache->core[req->core_id].volume, req,
 			_ocf_read_generic_miss_complete);
+}
+
+#if OCF_CONFIG_READ_SPLIT
+static void _ocf_read_generic_merge_complete(struct ocf_request *req,
+		int error)
+{
+	if (error) {
+		env_atomic_inc(&ocf_req_core_stats(req)->cache_errors.read);
+		req->error = error;
+	}
+
+	if (env_atomic_dec_return(&req->req_remaining))
+		return;
+
+	OCF_DEBUG_RQ(req, "MERGE completion");
+
+	env_atomic_set(&req->req_remaining, 1);
+	_ocf_read_generic_miss_complete(req, 0);
+}
+
+/* Read dirty sectors of merged cache lines from cache over core data */
+static void _ocf_read_generic_submit_merge(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *map = req->map;
+	uint8_t start, stop, end;
+	uint32_t i;
+
+	/* Keep request from completing until all IOs are submitted */
+	env_atomic_set(&req->req_remaining, 1);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (!map[i].merge)
+			continue;
+
+		ocf_map_info_sectors(req, i, &start, &stop);
+
+		for (; start <= stop; start = end + 1) {
+			end = ocf_dirty_run_end(cache, map[i].coll_idx, start,
+					stop);
+
+			if (!metadata_test_dirty_one(cache, map[i].coll_idx,
+					start)) {
+				continue;
+			}
 
-	return;
+			env_atomic_inc(&req->req_remaining);
+			ocf_submit_cache_sectors(cache, req, OCF_READ, i,
+					start, end, _ocf_read_generic_merge_complete);
+		}
+	}
 
-err_alloc:
-	_ocf_read_generic_miss_complete(req, -ENOMEM);
+	_ocf_read_generic_merge_complete(req, 0);
 }
 
+static void _ocf_read_generic_split_complete(struct ocf_request *req,
+		int error)
+{
+	struct ocf_cache *cache = req->cache;
+
+	if (error)
+		req->error = error;
+
+	if (env_atomic_dec_return(&req->req_remaining))
+		return;
+
+	OCF_DEBUG_RQ(req, "SPLIT completion");
+
+	if (!req->error && req->info.dirty_merge) {
+		_ocf_read_generic_submit_merge(req);
+		return;
+	}
+
+	env_atomic_set(&req->req_remaining, 1);
+
+	if (!req->error && !req->info.split_read) {
+		/* Some hit lines could not be read from cache, read whole
+		 * request from core and backfill all of it
+		 */
+		ocf_submit_volume_req(&cache->core[req->core_id].volume, req,
+				_ocf_read_generic_miss_complete);
+		return;
+	}
+
+	_ocf_read_generic_miss_complete(req, 0);
+}
+
+static void _ocf_read_generic_split_hit_complete(struct ocf_request *req,
+		int error)
+{
+	if (error) {
+		inc_fallback_pt_error_counter(req->cache);
+		env_atomic_inc(&ocf_req_core_stats(req)->cache_errors.read);
+
+		/* Dirty data can't be read from core instead */
+		if (req->info.dirty_merge)
+			req->error = error;
+		else
+			req->info.split_read = false;
+	}
+
+	_ocf_read_generic_split_complete(req, 0);
+}
+
+/*
+ * Mark cache lines of partial hit which are valid in requested range.
+ * Called before valid bits of the whole request are set.
+ */
+static bool _ocf_read_generic_split_map(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *map = req->map;
+	uint32_t count = req->core_line_count;
+	uint32_t map_idx, hits = 0;
+	uint8_t start_bit, end_bit;
+
+	if (!req->info.hit_no)
+		return false;
+
+	for (map_idx = 0; map_idx < count; map_idx++) {
+		map[map_idx].split_hit = false;
+		map[map_idx].merge = false;
+
+		if (map[map_idx].status != LOOKUP_HIT)
+			continue;
+
+		start_bit = 0;
+		end_bit = ocf_line_end_sector(cache);
+
+		if (map_idx == 0) {
+			start_bit = BYTES_TO_SECTORS(req->byte_position)
+					& ocf_line_sector_mask(cache);
+		}
+
+		if (map_idx == (count - 1)) {
+			end_bit = BYTES_TO_SECTORS(req->byte_position +
+					req->byte_length - 1)
+					& ocf_line_sector_mask(cache);
+		}
+
+		if (metadata_test_valid_sec(cache, map[map_idx].coll_idx,
+				start_bit, end_bit)) {
+			map[map_idx].split_hit = true;
+			hits++;
+		}
+	}
+
+	return hits && hits < count;
+}
+
+/*
+ * Mark cache lines of miss which have dirty sectors. Lines valid in requested
+ * range are read from cache as split hits. Other lines with dirty sectors in
+ * the range are read from core and get dirty sectors from cache on top, and
+ * only their clean sectors are backfilled. Called before valid bits of the
+ * whole request are set.
+ */
+static void _ocf_read_generic_merge_map(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *map = req->map;
+	uint32_t map_idx;
+	uint8_t start, stop;
+
+	for (map_idx = 0; map_idx < req->core_line_count; map_idx++) {
+		map[map_idx].split_hit = false;
+		map[map_idx].merge = false;
+
+		if (map[map_idx].status != LOOKUP_HIT)
+			continue;
+
+		ocf_map_info_sectors(req, map_idx, &start, &stop);
+
+		if (metadata_test_valid_sec(cache, map[map_idx].coll_idx,
+				start, stop)) {
+			map[map_idx].split_hit = true;
+		} else if (metadata_test_dirty_sec(cache,
+				map[map_idx].coll_idx, start, stop)) {
+			map[map_idx].merge = true;
+		}
+	}
+
+	req->info.split_read = true;
+	req->info.dirty_merge = true;
+}
+
+/* Read runs of hit lines from cache and runs of missed lines from core */
+static void _ocf_read_generic_submit_split(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *map = req->map;
+	uint32_t count = req->core_line_count;
+	uint32_t i, run;
+
+	/* Keep request from completing until all IOs are submitted */
+	env_atomic_set(&req->req_remaining, 1);
+
+	if (_ocf_read_generic_alloc_cp_data(req)) {
+		_ocf_read_generic_split_complete(req, -ENOMEM);
+		return;
+	}
+
+	for (i = 0; i < count; i += run) {
+		for (run = 1; i + run < count; run++) {
+			if (map[i + run].split_hit != map[i].split_hit)
+				break;
+		}
+
+		if (map[i].split_hit) {
+			env_atomic_add(run, &req->req_remaining);
+			ocf_submit_cache_lines(cache, req, OCF_READ, i, run,
+					_ocf_read_generic_split_hit_complete);
+		} else {
+			env_atomic_inc(&req->req_remaining);
+			ocf_submit_volume_req_lines(
+					&cache->core[req->core_id].volume,
+					req, i, run,
+					_ocf_read_generic_split_complete);
+		}
+	}
+
+	_ocf_read_generic_split_complete(req, 0);
+}
+#endif
+
 static int _ocf_read_generic_do(struct ocf_request *req)
 {
 	struct ocf_cache *cache = req->cache;
@@ -154,7 +403,7 @@ static int _ocf_read_generic_do(struct ocf_request *req)
 	ocf_req_get(req);
 
 	if (ocf_engine_is_miss(req)) {
-		if (req->info.dirty_any) {
+		if (req->info.dirty_any && !OCF_CONFIG_READ_DIRTY_MERGE) {
 			OCF_METADATA_LOCK_RD();
 
 			/* Request is dirty need to clean request */
@@ -170,6 +419,13 @@ static int _ocf_read_generic_do(struct ocf_request *req)
 
 		OCF_METADATA_LOCK_RD();
 
+#if OCF_CONFIG_READ_SPLIT
+		if (req->info.dirty_any)
+			_ocf_read_generic_merge_map(req);
+		else
+			req->info.split_read = _ocf_read_generic_split_map(req);
+#endif
+
 		/* Set valid status bits map */
 		ocf_set_valid_map_info(req);
 
@@ -179,14 +435,10 @@ static int _ocf_read_generic_do(struct ocf_request *req)
 	if (req->info.re_part) {
 		OCF_DEBUG_RQ(req, "Re-Part");
 
-		OCF_METADATA_LOCK_WR();
-
 		/* Probably some cache lines are assigned into wrong
 		 * partition. Need to move it to new one
 		 */
-		ocf_part_move(req);
-
-		OCF_METADATA_UNLOCK_WR();
+		ocf_part_move_deferred(req);
 	}
 
 	OCF_DEBUG_RQ(req, "Submit");
@@ -194,6 +446,10 @@ static int _ocf_read_generic_do(struct ocf_request *req)
 	/* Submit IO */
 	if (ocf_engine_is_hit(req))
 		_ocf_read_generic_submit_hit(req);
+#if OCF_CONFIG_READ_SPLIT
+	else if (req->info.split_read)
+		_ocf_read_generic_submit_split(req);
+#endif
 	else
 		_ocf_read_generic_submit_miss(req);
 
@@ -212,20 +468,79 @@ static const struct ocf_io_if _io_if_read_generic_resume = {
 		.write = _ocf_read_generic_do,
 };
 
+static int _ocf_read_generic_lock_clines(struct ocf_request *req)
+{
+	ocf_core_t core = &req->cache->core[req->core_id];
+
+	/* Hit read by upper tier is invalidated after read, which needs
+	 * WRITE access just like insert
+	 */
+	req->info.tier_promote = ocf_engine_is_hit(req) &&
+			ocf_core_tier_exclusive(core);
+
+	if (ocf_engine_is_hit(req) && !req->info.tier_promote) {
+		/* There is a hit, lock request for READ access */
+		return ocf_req_trylock_rd(req);
+	}
+
+	/* Miss, some cache lines are not valid and cache insert will be
+	 * performed - lock for WRITE is required
+	 */
+	return ocf_req_trylock_wr(req);
+}
+
+/* Check if read of upper cache tier is hit, to be moved to upper tier */
+static bool _ocf_read_generic_tier_hit(struct ocf_request *req)
+{
+	bool hit;
+
+	ocf_req_hash_lock_rd(req); /*- Metadata RD access --------------------*/
+	ocf_engine_traverse(req);
+	hit = ocf_engine_is_hit(req);
+	ocf_req_hash_unlock_rd(req); /*- END Metadata RD access --------------*/
+
+	ocf_req_clear(req);
+
+	return hit;
+}
+
 int ocf_read_generic(struct ocf_request *req)
 {
-	bool mapped;
-	int lock = OCF_LOCK_NOT_ACQUIRED;
+	int lock;
 	struct ocf_cache *cache = req->cache;
 
 	ocf_io_start(req->io);
 
+	if (!ocf_core_tier_exclusive(&cache->core[req->core_id]) &&
+			ocf_fill_read(req)) {
+		/* Lines are being backfilled, data copied from the fill */
+		OCF_DEBUG_RQ(req, "Hit under fill");
+		ocf_engine_update_request_stats(req);
+		ocf_engine_update_block_stats(req);
+		req->complete(req, 0);
+		ocf_req_put(req);
+		return 0;
+	}
+
 	if (env_atomic_read(&cache->pending_read_misses_list_blocked)) {
 		/* There are conditions to bypass IO */
 		ocf_get_io_if(ocf_cache_mode_pt)->read(req);
 		return 0;
 	}
 
+	if (ocf_part_qos_exceeded(cache, req->part_id)) {
+		/* IO class used up its cache bandwidth, don't backfill */
+		ocf_get_io_if(ocf_cache_mode_pt)->read(req);
+		return 0;
+	}
+
+	if (ocf_core_tier_exclusive(&cache->core[req->core_id]) &&
+			!_ocf_read_generic_tier_hit(req)) {
+		/* Upper tier caches what it reads, don't insert miss here */
+		ocf_get_io_if(ocf_cache_mode_pt)->read(req);
+		return 0;
+	}
+
 	/* Get OCF request - increase reference counter */
 	ocf_req_get(req);
 
@@ -233,61 +548,7 @@ int ocf_read_generic(struct ocf_request *req)
 	req->resume = ocf_engine_on_resume;
 	req->io_if = &_io_if_read_generic_resume;
 
-	/*- Metadata RD access -----------------------------------------------*/
-
-	OCF_METADATA_LOCK_RD();
-
-	/* Traverse request to cache if there is hit */
-	ocf_engine_traverse(req);
-
-	mapped = ocf_engine_is_mapped(req);
-	if (mapped) {
-		/* Request is fully mapped, no need to call eviction */
-		if (ocf_engine_is_hit(req)) {
-			/* There is a hit, lock request for READ access */
-			lock = ocf_req_trylock_rd(req);
-		} else {
-			/* All cache line mapped, but some sectors are not valid
-			 * and cache insert will be performed - lock for
-			 * WRITE is required
-			 */
-			lock = ocf_req_trylock_wr(req);
-		}
-	}
-
-	OCF_METADATA_UNLOCK_RD();
-
-	/*- END Metadata RD access -------------------------------------------*/
-
-	if (!mapped) {
-
-		/*- Metadata WR access ---------------------------------------*/
-
-		OCF_METADATA_LOCK_WR();
-
-		/* Now there is exclusive access for metadata. May traverse once
-		 * again. If there are misses need to call eviction. This
-		 * process is called 'mapping'.
-		 */
-		ocf_engine_map(req);
-
-		if (!req->info.eviction_error) {
-			if (ocf_engine_is_hit(req)) {
-				/* After mapping turns out there is hit,
-				 * so lock OCF request for read access
-				 */
-				lock = ocf_req_trylock_rd(req);
-			} else {
-				/* Miss, new cache lines were mapped,
-				 * need to lock OCF request for write access
-				 */
-				lock = ocf_req_trylock_wr(req);
-			}
-		}
-		OCF_METADATA_UNLOCK_WR();
-
-		/*- END Metadata WR access -----------------------------------*/
-	}
+	lock = ocf_engine_prepare_clines(req, _ocf_read_generic_lock_clines);
 
 	if (!req->info.eviction_error) {
 		if (lock >= 0) {
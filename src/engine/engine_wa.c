@@ -10,6 +10,7 @@
 #include "../utils/utils_req.h"
 #include "../utils/utils_io.h"
 #include "../metadata/metadata.h"
+#include "../concurrency/ocf_concurrency.h"
 
 #define OCF_ENGINE_DEBUG_IO_NAME "wa"
 #include "engine_debug.h"
@@ -24,7 +25,7 @@ static void _ocf_read_wa_complete(struct ocf_request *req, int error)
 
 	if (req->error) {
 		req->info.core_error = 1;
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				core_errors.write);
 	}
 
@@ -46,12 +47,12 @@ int ocf_write_wa(struct ocf_request *req)
 	/* Get OCF request - increase reference counter */
 	ocf_req_get(req);
 
-	OCF_METADATA_LOCK_RD(); /*- Metadata RD access -----------------------*/
+	ocf_req_hash_lock_rd(req); /*- Metadata RD access --------------------*/
 
 	/* Traverse request to check if there are mapped cache lines */
 	ocf_engine_traverse(req);
 
-	OCF_METADATA_UNLOCK_RD(); /*- END Metadata RD access -----------------*/
+	ocf_req_hash_unlock_rd(req); /*- END Metadata RD access --------------*/
 
 	if (ocf_engine_is_hit(req)) {
 		ocf_req_clear(req);
@@ -77,7 +78,7 @@ int ocf_write_wa(struct ocf_request *req)
 
 		/* Update statistics */
 		ocf_engine_update_block_stats(req);
-		env_atomic64_inc(&cache->core[req->core_id].counters->
+		env_atomic64_inc(&ocf_req_core_stats(req)->
 			part_counters[req->part_id].write_reqs.pass_through);
 	}
 
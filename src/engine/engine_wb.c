@@ -56,6 +56,9 @@ static void _ocf_write_wb_io_flush_metadata(struct ocf_request *req, int error)
 	if (req->error)
 		ocf_engine_error(req, true, "Failed to write data to cache");
 
+	/* Dirty data is durable only once cache volume is flushed */
+	ocf_cache_flush_gen_inc(req->cache);
+
 	ocf_req_unlock_wr(req);
 
 	req->complete(req, req->error);
@@ -88,7 +91,7 @@ static const struct ocf_io_if _io_if_wb_flush_metadata = {
 static void _ocf_write_wb_complete(struct ocf_request *req, int error)
 {
 	if (error) {
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				cache_errors.write);
 		req->error |= error;
 	}
@@ -128,14 +131,10 @@ static inline void _ocf_write_wb_submit(struct ocf_request *req)
 	if (req->info.re_part) {
 		OCF_DEBUG_RQ(req, "Re-Part");
 
-		OCF_METADATA_LOCK_WR();
-
 		/* Probably some cache lines are assigned into wrong
 		 * partition. Need to move it to new one
 		 */
-		ocf_part_move(req);
-
-		OCF_METADATA_UNLOCK_WR();
+		ocf_part_move_deferred(req);
 	}
 
 	OCF_DEBUG_RQ(req, "Submit Data");
@@ -168,9 +167,7 @@ int ocf_write_wb_do(struct ocf_request *req)
 
 int ocf_write_wb(struct ocf_request *req)
 {
-	bool mapped;
-	int lock = OCF_LOCK_NOT_ACQUIRED;
-	struct ocf_cache *cache = req->cache;
+	int lock;
 
 	ocf_io_start(req->io);
 
@@ -183,35 +180,7 @@ int ocf_write_wb(struct ocf_request *req)
 
 	/* TODO: Handle fits into dirty */
 
-	OCF_METADATA_LOCK_RD(); /*- Metadata READ access, No eviction --------*/
-
-	/* Travers to check if request is mapped fully */
-	ocf_engine_traverse(req);
-
-	mapped = ocf_engine_is_mapped(req);
-	if (mapped) {
-		/* All cache line are mapped, lock request for WRITE access */
-		lock = ocf_req_trylock_wr(req);
-	}
-
-	OCF_METADATA_UNLOCK_RD(); /*- END Metadata READ access----------------*/
-
-	if (!mapped) {
-		OCF_METADATA_LOCK_WR(); /*- Metadata WR access, eviction -----*/
-
-		/* Now there is exclusive access for metadata. May traverse once
-		 * again. If there are misses need to call eviction. This
-		 * process is called 'mapping'.
-		 */
-		ocf_engine_map(req);
-
-		if (!req->info.eviction_error) {
-			/* Lock request for WRITE access */
-			lock = ocf_req_trylock_wr(req);
-		}
-
-		OCF_METADATA_UNLOCK_WR(); /*- END Metadata WR access ---------*/
-	}
+	lock = ocf_engine_prepare_clines(req, ocf_req_trylock_wr);
 
 	if (!req->info.eviction_error) {
 		if (lock >= 0) {
@@ -5,6 +5,7 @@
 
 #include "ocf/ocf.h"
 #include "../ocf_cache_priv.h"
+#include "../ocf_queue_priv.h"
 #include "engine_wi.h"
 #include "engine_common.h"
 #include "../concurrency/ocf_concurrency.h"
@@ -26,7 +27,7 @@ static const struct ocf_io_if _io_if_wi_flush_metadata = {
 static void _ocf_write_wi_io_flush_metadata(struct ocf_request *req, int error)
 {
 	if (error) {
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				cache_errors.write);
 		req->error |= error;
 	}
@@ -44,31 +45,131 @@ static void _ocf_write_wi_io_flush_metadata(struct ocf_request *req, int error)
 	ocf_req_put(req);
 }
 
+static void _ocf_write_wi_flush_metadata(struct ocf_request *req)
+{
+	env_atomic_set(&req->req_remaining, 1);
+
+	if (req->info.flush_metadata) {
+		/* Request was dirty and need to flush metadata */
+		ocf_metadata_flush_do_asynch(req->cache, req,
+				_ocf_write_wi_io_flush_metadata);
+	}
+
+	_ocf_write_wi_io_flush_metadata(req, 0);
+}
+
+#if OCF_CONFIG_WI_PURGE_BATCH > 0
+static int _ocf_write_wi_purge_batch(struct ocf_request *req);
+
+static const struct ocf_io_if _io_if_wi_purge_batch = {
+		.read = _ocf_write_wi_purge_batch,
+		.write = _ocf_write_wi_purge_batch,
+};
+
+/* Remove mapped cache lines of all requests in single metadata WR section */
+static void _ocf_write_wi_purge_reqs(struct ocf_cache *cache,
+		struct list_head *reqs)
+{
+	struct ocf_request *req, *next;
+
+	OCF_METADATA_LOCK_WR(); /*- Metadata WR access -----------------------*/
+
+	list_for_each_entry(req, reqs, list)
+		ocf_purge_map_info(req);
+
+	OCF_METADATA_UNLOCK_WR(); /*- END Metadata WR access -----------------*/
+
+	list_for_each_entry_safe(req, next, reqs, list) {
+		list_del(&req->list);
+		_ocf_write_wi_flush_metadata(req);
+	}
+}
+
+static void _ocf_write_wi_take_batch(ocf_queue_t q, struct list_head *reqs)
+{
+	while (!list_empty(&q->wi_purge_list))
+		list_move_tail(q->wi_purge_list.next, reqs);
+
+	q->wi_purge_count = 0;
+}
+
+/* Batch leader got its turn in the queue, purge everything gathered so far */
+static int _ocf_write_wi_purge_batch(struct ocf_request *req)
+{
+	ocf_queue_t q = req->io_queue;
+	struct list_head reqs;
+
+	INIT_LIST_HEAD(&reqs);
+	list_add_tail(&req->list, &reqs);
+
+	env_spinlock_lock(&q->wi_purge_lock);
+	_ocf_write_wi_take_batch(q, &reqs);
+	q->wi_purge_leader = false;
+	env_spinlock_unlock(&q->wi_purge_lock);
+
+	_ocf_write_wi_purge_reqs(req->cache, &reqs);
+
+	return 0;
+}
+
+/*
+ * Defer purge of request mapping only clean cache lines. Request keeps its
+ * cache line locks until the batch is applied, so lines cannot be accessed
+ * or remapped meanwhile. First request becomes batch leader and is queued
+ * behind requests already pending, the following ones join its batch.
+ */
+static void _ocf_write_wi_purge_defer(struct ocf_request *req)
+{
+	ocf_queue_t q = req->io_queue;
+	struct list_head reqs;
+	bool leader = false;
+
+	INIT_LIST_HEAD(&reqs);
+
+	env_spinlock_lock(&q->wi_purge_lock);
+	if (!q->wi_purge_leader) {
+		q->wi_purge_leader = true;
+		leader = true;
+	} else {
+		list_add_tail(&req->list, &q->wi_purge_list);
+		if (++q->wi_purge_count >= OCF_CONFIG_WI_PURGE_BATCH)
+			_ocf_write_wi_take_batch(q, &reqs);
+	}
+	env_spinlock_unlock(&q->wi_purge_lock);
+
+	if (leader) {
+		req->io_if = &_io_if_wi_purge_batch;
+		ocf_engine_push_req_back(req, false);
+	} else if (!list_empty(&reqs)) {
+		/* Batch is full, don't wait for the leader */
+		_ocf_write_wi_purge_reqs(req->cache, &reqs);
+	}
+}
+#endif
+
 static int ocf_write_wi_update_and_flush_metadata(struct ocf_request *req)
 {
 	struct ocf_cache *cache = req->cache;
 
-	env_atomic_set(&req->req_remaining, 1); /* One core IO */
-
 	if (ocf_engine_mapped_count(req)) {
 		/* There are mapped cache line, need to remove them */
 
+#if OCF_CONFIG_WI_PURGE_BATCH > 0
+		if (!req->info.dirty_any) {
+			_ocf_write_wi_purge_defer(req);
+			return 0;
+		}
+#endif
+
 		OCF_METADATA_LOCK_WR(); /*- Metadata WR access ---------------*/
 
 		/* Remove mapped cache lines from metadata */
 		ocf_purge_map_info(req);
 
 		OCF_METADATA_UNLOCK_WR(); /*- END Metadata WR access ---------*/
-
-		if (req->info.flush_metadata) {
-			/* Request was dirty and need to flush metadata */
-			ocf_metadata_flush_do_asynch(cache, req,
-					_ocf_write_wi_io_flush_metadata);
-		}
-
 	}
 
-	_ocf_write_wi_io_flush_metadata(req, 0);
+	_ocf_write_wi_flush_metadata(req);
 
 	return 0;
 }
@@ -78,7 +179,7 @@ static void _ocf_write_wi_core_complete(struct ocf_request *req, int error)
 	if (error) {
 		req->error = error;
 		req->info.core_error = 1;
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				core_errors.write);
 	}
 
@@ -116,7 +217,7 @@ static int _ocf_write_wi_do(struct ocf_request *req)
 
 	/* Update statistics */
 	ocf_engine_update_block_stats(req);
-	env_atomic64_inc(&cache->core[req->core_id].counters->
+	env_atomic64_inc(&ocf_req_core_stats(req)->
 			part_counters[req->part_id].write_reqs.pass_through);
 
 	/* Put OCF request - decrease reference counter */
@@ -139,7 +240,6 @@ static const struct ocf_io_if _io_if_wi_resume = {
 int ocf_write_wi(struct ocf_request *req)
 {
 	int lock = OCF_LOCK_NOT_ACQUIRED;
-	struct ocf_cache *cache = req->cache;
 
 	OCF_DEBUG_TRACE(req->cache);
 
@@ -152,7 +252,7 @@ int ocf_write_wi(struct ocf_request *req)
 	req->resume = _ocf_write_wi_on_resume;
 	req->io_if = &_io_if_wi_resume;
 
-	OCF_METADATA_LOCK_RD(); /*- Metadata READ access, No eviction --------*/
+	ocf_req_hash_lock_rd(req); /*- Metadata READ access, No eviction -----*/
 
 	/* Travers to check if request is mapped fully */
 	ocf_engine_traverse(req);
@@ -164,7 +264,7 @@ int ocf_write_wi(struct ocf_request *req)
 		lock = OCF_LOCK_ACQUIRED;
 	}
 
-	OCF_METADATA_UNLOCK_RD(); /*- END Metadata READ access----------------*/
+	ocf_req_hash_unlock_rd(req); /*- END Metadata READ access-------------*/
 
 	if (lock >= 0) {
 		if (lock == OCF_LOCK_ACQUIRED) {
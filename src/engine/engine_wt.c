@@ -48,7 +48,7 @@ static void _ocf_write_wt_cache_complete(struct ocf_request *req, int error)
 {
 	if (error) {
 		req->error = req->error ?: error;
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				cache_errors.write);
 
 		if (req->error)
@@ -63,7 +63,7 @@ static void _ocf_write_wt_core_complete(struct ocf_request *req, int error)
 	if (error) {
 		req->error = error;
 		req->info.core_error = 1;
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				core_errors.write);
 	}
 
@@ -125,18 +125,14 @@ static void _ocf_write_wt_update_bits(struct ocf_request *req)
 	if (req->info.re_part) {
 		OCF_DEBUG_RQ(req, "Re-Part");
 
-		OCF_METADATA_LOCK_WR();
-
 		/* Probably some cache lines are assigned into wrong
 		 * partition. Need to move it to new one
 		 */
-		ocf_part_move(req);
-
-		OCF_METADATA_UNLOCK_WR();
+		ocf_part_move_deferred(req);
 	}
 }
 
-static int _ocf_write_wt_do(struct ocf_request *req)
+int ocf_write_wt_do(struct ocf_request *req)
 {
 	/* Get OCF request - increase reference counter */
 	ocf_req_get(req);
@@ -158,15 +154,13 @@ static int _ocf_write_wt_do(struct ocf_request *req)
 }
 
 static const struct ocf_io_if _io_if_wt_resume = {
-		.read = _ocf_write_wt_do,
-		.write = _ocf_write_wt_do,
+		.read = ocf_write_wt_do,
+		.write = ocf_write_wt_do,
 };
 
 int ocf_write_wt(struct ocf_request *req)
 {
-	bool mapped;
-	int lock = OCF_LOCK_NOT_ACQUIRED;
-	struct ocf_cache *cache = req->cache;
+	int lock;
 
 	ocf_io_start(req->io);
 
@@ -177,35 +171,7 @@ int ocf_write_wt(struct ocf_request *req)
 	req->resume = ocf_engine_on_resume;
 	req->io_if = &_io_if_wt_resume;
 
-	OCF_METADATA_LOCK_RD(); /*- Metadata READ access, No eviction --------*/
-
-	/* Travers to check if request is mapped fully */
-	ocf_engine_traverse(req);
-
-	mapped = ocf_engine_is_mapped(req);
-	if (mapped) {
-		/* All cache line are mapped, lock request for WRITE access */
-		lock = ocf_req_trylock_wr(req);
-	}
-
-	OCF_METADATA_UNLOCK_RD(); /*- END Metadata READ access----------------*/
-
-	if (!mapped) {
-		OCF_METADATA_LOCK_WR(); /*- Metadata WR access, eviction -----*/
-
-		/* Now there is exclusive access for metadata. May traverse once
-		 * again. If there are misses need to call eviction. This
-		 * process is called 'mapping'.
-		 */
-		ocf_engine_map(req);
-
-		if (!req->info.eviction_error) {
-			/* Lock request for WRITE access */
-			lock = ocf_req_trylock_wr(req);
-		}
-
-		OCF_METADATA_UNLOCK_WR(); /*- END Metadata WR access ---------*/
-	}
+	lock = ocf_engine_prepare_clines(req, ocf_req_trylock_wr);
 
 	if (!req->info.eviction_error) {
 		if (lock >= 0) {
@@ -213,7 +179,7 @@ int ocf_write_wt(struct ocf_request *req)
 				/* WR lock was not acquired, need to wait for resume */
 				OCF_DEBUG_RQ(req, "NO LOCK");
 			} else {
-				_ocf_write_wt_do(req);
+				ocf_write_wt_do(req);
 			}
 		} else {
 			OCF_DEBUG_RQ(req, "LOCK ERROR %d\n", lock);
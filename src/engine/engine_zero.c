@@ -50,7 +50,7 @@ static const struct ocf_io_if _io_if_zero_purge = {
 static void _ocf_zero_io_flush_metadata(struct ocf_request *req, int error)
 {
 	if (error) {
-		env_atomic_inc(&req->cache->core[req->core_id].counters->
+		env_atomic_inc(&ocf_req_core_stats(req)->
 				cache_errors.write);
 		req->error = error;
 	}
@@ -87,7 +87,7 @@ static inline void ocf_zero_map_info(struct ocf_request *req)
 		if (map_idx == 0) {
 			/* First */
 			start_bit = BYTES_TO_SECTORS(req->byte_position)
-					% ocf_line_sectors(cache);
+					& ocf_line_sector_mask(cache);
 		}
 
 		if (map_idx == (count - 1)) {
@@ -135,14 +135,12 @@ static const struct ocf_io_if _io_if_ocf_zero_do = {
 /**
  * @note
  *	- Caller has to have metadata write lock
- *	- Core line has to be mapped
+ *	- Core lines have to be mapped and not locked
  */
 void ocf_engine_zero_line(struct ocf_request *req)
 {
 	int lock = OCF_LOCK_NOT_ACQUIRED;
 
-	ENV_BUG_ON(req->core_line_count != 1);
-
 	/* Traverse to check if request is mapped */
 	ocf_engine_traverse(req);
 
@@ -164,3 +162,47 @@ void ocf_engine_zero_line(struct ocf_request *req)
 	}
 }
 
+
+/**
+ * @note
+ *	- Caller has to have metadata write lock
+ *	- Cache lines have to be mapped to core of request and not locked
+ */
+void ocf_engine_zero_lines(struct ocf_request *req,
+		const ocf_cache_line_t *lines, const uint64_t *core_lines)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *entry;
+	int lock = OCF_LOCK_NOT_ACQUIRED;
+	uint32_t i;
+
+	/*
+	 * Lines are not consecutive on core, so instead of traverse fill
+	 * map directly. Request covers whole lines, thus first and last
+	 * map entries are zeroed entirely as well.
+	 */
+	for (i = 0; i < req->core_line_count; i++) {
+		entry = &req->map[i];
+
+		entry->core_id = req->core_id;
+		entry->core_line = core_lines[i];
+		entry->hash_key = ocf_metadata_hash_func(cache, core_lines[i],
+				req->core_id);
+		entry->coll_idx = lines[i];
+		entry->status = LOOKUP_HIT;
+	}
+
+	req->resume = ocf_engine_on_resume;
+	req->io_if = &_io_if_ocf_zero_do;
+
+	lock = ocf_req_trylock_wr(req);
+
+	if (lock >= 0) {
+		ENV_BUG_ON(lock != OCF_LOCK_ACQUIRED);
+		ocf_engine_push_req_front_if(req, &_io_if_ocf_zero_do, true);
+	} else {
+		OCF_DEBUG_RQ(req, "LOCK ERROR %d", lock);
+		req->complete(req, lock);
+		ocf_req_put(req);
+	}
+}
@@ -8,4 +8,19 @@
 
 void ocf_engine_zero_line(struct ocf_request *req);
 
+/**
+ * @brief Zero and purge batch of whole cache lines of one core
+ *
+ * Request has to be allocated with map for given number of lines. Lines
+ * don't have to map consecutive core lines - they are sorted and merged by
+ * physical position on cache device, so that all of them are zeroed with
+ * as few write-zeroes/discard I/Os as possible and single metadata flush.
+ *
+ * @param req - request of core lines are mapped to
+ * @param lines - cache lines to be zeroed
+ * @param core_lines - core lines mapped to cache lines
+ */
+void ocf_engine_zero_lines(struct ocf_request *req,
+		const ocf_cache_line_t *lines, const uint64_t *core_lines);
+
 #endif /* ENGINE_ZERO_H_ */
@@ -0,0 +1,327 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "eviction.h"
+#include "clock.h"
+#include "ops.h"
+#include "../utils/utils_cleaner.h"
+#include "../utils/utils_cache_line.h"
+#include "../concurrency/ocf_concurrency.h"
+#include "../mngt/ocf_mngt_common.h"
+#include "../engine/engine_zero.h"
+#include "../utils/utils_req.h"
+
+/*
+ * CLOCK eviction keeps single referenced byte per cache line instead of LRU
+ * list pointers. Hit only sets it, so there is nothing to relink. Each
+ * partition has a hand sweeping over cache lines of the partition list,
+ * which clears referenced cache lines and evicts the ones not referenced
+ * since the previous sweep. Partitions tracked by counters have no list,
+ * so their hand sweeps over the collision table instead.
+ */
+
+/* Maximum number of collision entries visited per requested cache line */
+#define OCF_CLOCK_SCAN_PER_CLINE 1024
+
+/* Maximum number of dirty cache lines cleaned at once */
+#define OCF_CLOCK_CLEAN_MAX 32
+
+struct evp_clock_clean_ctx {
+	struct ocf_cleaner_attribs attribs;
+	ocf_part_id_t part_id;
+	uint32_t scanned;
+};
+
+/*
+ * Position the hand is resumed from, hand left at cache line moved out of
+ * partition restarts from partition list head. Returns
+ * collision_table_entries if partition is empty.
+ */
+static inline ocf_cache_line_t evp_clock_start(ocf_cache_t cache,
+		ocf_part_id_t part_id, ocf_cache_line_t hand)
+{
+	ocf_cache_line_t entries = cache->device->collision_table_entries;
+
+#if OCF_CONFIG_PARTITION_COUNTERS
+	return hand < entries ? hand : 0;
+#else
+	if (hand < entries &&
+			ocf_metadata_get_partition_id(cache, hand) == part_id) {
+		return hand;
+	}
+
+	return cache->user_parts[part_id].runtime->head;
+#endif
+}
+
+static inline ocf_cache_line_t evp_clock_next(ocf_cache_t cache,
+		ocf_part_id_t part_id, ocf_cache_line_t cline)
+{
+	ocf_cache_line_t entries = cache->device->collision_table_entries;
+
+#if OCF_CONFIG_PARTITION_COUNTERS
+	return ++cline < entries ? cline : 0;
+#else
+	cline = ocf_metadata_get_partition_next(cache, cline);
+
+	return cline != entries ? cline :
+			cache->user_parts[part_id].runtime->head;
+#endif
+}
+
+/* Number of cache lines passed by single revolution of the hand */
+static inline uint32_t evp_clock_revolution(ocf_cache_t cache,
+		ocf_part_id_t part_id)
+{
+#if OCF_CONFIG_PARTITION_COUNTERS
+	return cache->device->collision_table_entries;
+#else
+	return cache->user_parts[part_id].runtime->curr_size;
+#endif
+}
+
+static void evp_clock_set_referenced(ocf_cache_t cache, ocf_cache_line_t cline,
+		uint8_t referenced)
+{
+	union eviction_policy_meta eviction;
+
+	ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+
+	if (eviction.clock.referenced == referenced)
+		return;
+
+	eviction.clock.referenced = referenced;
+	ocf_metadata_set_evicition_policy(cache, cline, &eviction);
+}
+
+void evp_clock_init_cline(ocf_cache_t cache, ocf_cache_line_t cline)
+{
+	union eviction_policy_meta eviction;
+
+	ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+	eviction.clock.referenced = 0;
+	ocf_metadata_set_evicition_policy(cache, cline, &eviction);
+}
+
+/* the caller must hold the metadata lock */
+void evp_clock_rm_cline(ocf_cache_t cache, ocf_cache_line_t cline)
+{
+	evp_clock_set_referenced(cache, cline, 0);
+}
+
+/* the caller must hold the metadata lock */
+void evp_clock_hot_cline(ocf_cache_t cache, ocf_cache_line_t cline)
+{
+	evp_clock_set_referenced(cache, cline, 1);
+}
+
+void evp_clock_init_evp(ocf_cache_t cache, ocf_part_id_t part_id)
+{
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+
+	part->runtime->eviction.policy.clock.hand = 0;
+}
+
+bool evp_clock_can_evict(ocf_cache_t cache)
+{
+	if (env_atomic_read(&cache->pending_eviction_clines) >=
+			OCF_PENDING_EVICTION_LIMIT) {
+		return false;
+	}
+
+	return true;
+}
+
+static void evp_clock_clean_end(void *private_data, int error)
+{
+	env_atomic *cleaning_in_progress = private_data;
+
+	env_atomic_set(cleaning_in_progress, 0);
+}
+
+static int evp_clock_clean_getter(ocf_cache_t cache,
+		void *getter_context, uint32_t item, ocf_cache_line_t *line)
+{
+	struct evp_clock_clean_ctx *ctx = getter_context;
+	uint32_t revolution = evp_clock_revolution(cache, ctx->part_id);
+	ocf_cache_line_t curr_cline;
+
+	curr_cline = evp_clock_start(cache, ctx->part_id,
+			ctx->attribs.getter_item);
+	if (curr_cline == cache->device->collision_table_entries)
+		return -1;
+
+	while (ctx->scanned < revolution) {
+		ctx->scanned++;
+
+		if (ocf_metadata_get_partition_id(cache, curr_cline) !=
+					ctx->part_id ||
+				!metadata_test_dirty(cache, curr_cline) ||
+				ocf_cache_line_is_used(cache, curr_cline)) {
+			curr_cline = evp_clock_next(cache, ctx->part_id,
+					curr_cline);
+			continue;
+		}
+
+		*line = curr_cline;
+		ctx->attribs.getter_item = evp_clock_next(cache, ctx->part_id,
+				curr_cline);
+		return 0;
+	}
+
+	return -1;
+}
+
+static void evp_clock_clean(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, ocf_cache_line_t start, uint32_t count)
+{
+	env_atomic *progress = &cache->cleaning[part_id];
+
+	if (ocf_mngt_is_cache_locked(cache))
+		return;
+
+	if (env_atomic_cmpxchg(progress, 0, 1) == 0) {
+		/* Initialize attributes for cleaner */
+		struct evp_clock_clean_ctx ctx = {
+			.attribs = {
+				.cache_line_lock = true,
+				.do_sort = true,
+
+				.cmpl_context = progress,
+				.cmpl_fn = evp_clock_clean_end,
+
+				.getter = evp_clock_clean_getter,
+				.getter_context = &ctx,
+				.getter_item = start,
+
+				.count = OCF_MIN(count, OCF_CLOCK_CLEAN_MAX),
+
+				.io_queue = io_queue
+			},
+			.part_id = part_id,
+		};
+
+		ocf_cleaner_fire(cache, &ctx.attribs);
+	}
+}
+
+static void evp_clock_zero_line_complete(struct ocf_request *ocf_req,
+		int error)
+{
+	env_atomic_dec(&ocf_req->cache->pending_eviction_clines);
+}
+
+static void evp_clock_zero_line(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_cache_line_t line)
+{
+	struct ocf_request *req;
+	ocf_core_id_t id;
+	uint64_t addr, core_line;
+
+	ocf_metadata_get_core_info(cache, line, &id, &core_line);
+	addr = core_line * ocf_line_size(cache);
+
+	req = ocf_req_new(io_queue, &cache->core[id], addr,
+			ocf_line_size(cache), OCF_WRITE);
+	if (req) {
+		req->info.internal = true;
+		req->complete = evp_clock_zero_line_complete;
+
+		env_atomic_inc(&cache->pending_eviction_clines);
+
+		ocf_engine_zero_line(req);
+	}
+}
+
+/* the caller must hold the metadata lock */
+uint32_t evp_clock_req_clines(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no, ocf_core_id_t core_id)
+{
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+	struct clock_eviction_policy *clock =
+			&part->runtime->eviction.policy.clock;
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
+	union eviction_policy_meta eviction;
+	ocf_cache_line_t hand = clock->hand, cline;
+	ocf_cache_line_t dirty = collision_table_entries;
+	uint64_t scanned, max_scan;
+	uint32_t i = 0;
+
+	if (cline_no == 0)
+		return 0;
+
+	/* Two revolutions are enough to clear and then find any line */
+	max_scan = OCF_MIN(2ULL * evp_clock_revolution(cache, part_id),
+			(uint64_t)cline_no * OCF_CLOCK_SCAN_PER_CLINE);
+
+	for (scanned = 0; i < cline_no && scanned < max_scan; scanned++) {
+		if (!evp_clock_can_evict(cache))
+			break;
+
+		/* Evicted line leaves partition list, so the hand is moved
+		 * past it before it is looked at
+		 */
+		cline = evp_clock_start(cache, part_id, hand);
+		if (cline == collision_table_entries)
+			break;
+		hand = evp_clock_next(cache, part_id, cline);
+
+		if (ocf_metadata_get_partition_id(cache, cline) != part_id)
+			continue;
+
+		if (!metadata_test_valid_any(cache, cline))
+			continue;
+
+		/* Prevent evicting already locked items */
+		if (ocf_cache_line_is_used(cache, cline)) {
+			ocf_eviction_stats_add(cache, part_id, locked_clines, 1);
+			continue;
+		}
+
+		/* Give referenced line second chance */
+		ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+		if (eviction.clock.referenced) {
+			eviction.clock.referenced = 0;
+			ocf_metadata_set_evicition_policy(cache, cline,
+					&eviction);
+			continue;
+		}
+
+		if (metadata_test_dirty(cache, cline)) {
+			/* Remember first dirty line to start cleaning from */
+			if (dirty == collision_table_entries)
+				dirty = cline;
+			continue;
+		}
+
+		ocf_eviction_ghost_add_line(cache, cline);
+
+		if (ocf_volume_is_atomic(&cache->device->volume)) {
+			/* atomic cache, we have to trim cache lines before
+			 * eviction
+			 */
+			evp_clock_zero_line(cache, io_queue, cline);
+
+		} else {
+			set_cache_line_invalid_no_flush(cache, 0,
+					ocf_line_end_sector(cache), cline);
+
+			/* Goto next item. */
+			i++;
+		}
+	}
+
+	clock->hand = hand;
+
+	if (i < cline_no && dirty != collision_table_entries) {
+		ocf_eviction_stats_add(cache, part_id, dirty_fallbacks, 1);
+		ocf_cleaner_emergency(cache);
+		evp_clock_clean(cache, io_queue, part_id, dirty, cline_no - i);
+	}
+
+	/* Return number of clines that were really evicted */
+	return i;
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __EVICTION_CLOCK_H__
+#define __EVICTION_CLOCK_H__
+
+#include "eviction.h"
+#include "clock_structs.h"
+
+void evp_clock_init_cline(struct ocf_cache *cache,
+		ocf_cache_line_t cline);
+void evp_clock_rm_cline(struct ocf_cache *cache, ocf_cache_line_t cline);
+bool evp_clock_can_evict(struct ocf_cache *cache);
+uint32_t evp_clock_req_clines(struct ocf_cache *cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no,
+		ocf_core_id_t core_id);
+void evp_clock_hot_cline(struct ocf_cache *cache, ocf_cache_line_t cline);
+void evp_clock_init_evp(struct ocf_cache *cache, ocf_part_id_t part_id);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __EVICTION_CLOCK_STRUCTS_H__
+
+#define __EVICTION_CLOCK_STRUCTS_H__
+
+struct clock_eviction_policy_meta {
+	/* Cache line was hit since the hand passed it last time */
+	uint8_t referenced;
+} __attribute__((packed));
+
+struct clock_eviction_policy {
+	/* Collision index the hand stopped at */
+	uint32_t hand;
+};
+
+#endif
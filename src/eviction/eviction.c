@@ -5,7 +5,15 @@
 
 #include "eviction.h"
 #include "ops.h"
+#include "../ocf_priv.h"
 #include "../utils/utils_part.h"
+#include "../utils/utils_req.h"
+#include "../engine/engine_common.h"
+#include "../concurrency/ocf_concurrency.h"
+#include "../ocf_trace_priv.h"
+
+/* Maximum number of cache lines evicted at once while refilling reserve */
+#define OCF_EVICTION_RESERVE_BATCH 1024
 
 struct eviction_policy_ops evict_policy_ops[ocf_eviction_max] = {
 	[ocf_eviction_lru] = {
@@ -16,14 +24,45 @@ struct eviction_policy_ops evict_policy_ops[ocf_eviction_max] = {
 		.init_evp = evp_lru_init_evp,
 		.dirty_cline = evp_lru_dirty_cline,
 		.clean_cline = evp_lru_clean_cline,
+		.walk_hot = evp_lru_walk_hot,
 		.name = "lru",
 	},
+	[ocf_eviction_clock] = {
+		.init_cline = evp_clock_init_cline,
+		.rm_cline = evp_clock_rm_cline,
+		.req_clines = evp_clock_req_clines,
+		.hot_cline = evp_clock_hot_cline,
+		.init_evp = evp_clock_init_evp,
+		.name = "clock",
+	},
+	[ocf_eviction_2q] = {
+		.init_cline = evp_2q_init_cline,
+		.rm_cline = evp_2q_rm_cline,
+		.req_clines = evp_2q_req_clines,
+		.hot_cline = evp_2q_hot_cline,
+		.init_evp = evp_2q_init_evp,
+		.walk_hot = evp_2q_walk_hot,
+		.name = "2q",
+	},
+	[ocf_eviction_lru_cost] = {
+		.init_cline = evp_lru_init_cline,
+		.rm_cline = evp_lru_rm_cline,
+		.req_clines = evp_lru_cost_req_clines,
+		.hot_cline = evp_lru_hot_cline,
+		.init_evp = evp_lru_init_evp,
+		.dirty_cline = evp_lru_dirty_cline,
+		.clean_cline = evp_lru_clean_cline,
+		.walk_hot = evp_lru_walk_hot,
+		.name = "lru-cost",
+	},
 };
 
 static uint32_t ocf_evict_calculate(struct ocf_user_part *part,
 		uint32_t to_evict)
 {
-	if (part->runtime->curr_size <= part->config->min_size) {
+	uint32_t min_size = ocf_part_get_evict_min_size(part);
+
+	if (part->runtime->curr_size <= min_size) {
 		/*
 		 * Cannot evict from this partition because current size
 		 * is less than minimum size
@@ -34,8 +73,8 @@ static uint32_t ocf_evict_calculate(struct ocf_user_part *part,
 	if (to_evict < OCF_TO_EVICTION_MIN)
 		to_evict = OCF_TO_EVICTION_MIN;
 
-	if (to_evict > (part->runtime->curr_size - part->config->min_size))
-		to_evict = part->runtime->curr_size - part->config->min_size;
+	if (to_evict > (part->runtime->curr_size - min_size))
+		to_evict = part->runtime->curr_size - min_size;
 
 	return to_evict;
 }
@@ -48,9 +87,10 @@ static inline uint32_t ocf_evict_do(ocf_cache_t cache,
 	struct ocf_user_part *part;
 	struct ocf_user_part *target_part = &cache->user_parts[target_part_id];
 	ocf_part_id_t part_id;
+	uint16_t rank;
 
 	/* For each partition from the lowest priority to highest one */
-	for_each_part(cache, part, part_id) {
+	for_each_evictable_part(cache, part, part_id, rank) {
 
 		if (!ocf_eviction_can_evict(cache))
 			goto out;
@@ -64,10 +104,6 @@ static inline uint32_t ocf_evict_do(ocf_cache_t cache,
 			 */
 			break;
 		}
-		if (!part->config->flags.eviction) {
-			/* It seams that no more partition for eviction */
-			break;
-		}
 		if (part_id == target_part_id) {
 			/* Omit targeted, evict from different first */
 			continue;
@@ -90,7 +126,7 @@ static inline uint32_t ocf_evict_do(ocf_cache_t cache,
 	if (!ocf_eviction_can_evict(cache))
 		goto out;
 
-	if (evicted < evict_cline_no) {
+	if (evicted < evict_cline_no && !ocf_part_is_pinned(target_part)) {
 		/* Now we can evict form targeted partition */
 		to_evict = ocf_evict_calculate(target_part, evict_cline_no);
 		if (to_evict) {
@@ -103,17 +139,41 @@ out:
 	return evicted;
 }
 
+static void ocf_evict_account_time(struct ocf_cache *cache,
+		ocf_part_id_t part_id, uint64_t duration)
+{
+	env_atomic64 *max_time = &cache->eviction_counters[part_id].max_time_ns;
+	long old;
+
+	ocf_eviction_stats_add(cache, part_id, requests, 1);
+	ocf_eviction_stats_add(cache, part_id, time_ns, duration);
+
+	do {
+		old = env_atomic64_read(max_time);
+		if (old >= (long)duration)
+			break;
+	} while (env_atomic64_cmpxchg(max_time, old, duration) != old);
+}
+
 int space_managment_evict_do(struct ocf_cache *cache,
 		struct ocf_request *req, uint32_t evict_cline_no)
 {
+	uint64_t start, duration;
 	uint32_t evicted;
 
 	if (evict_cline_no <= cache->device->freelist_part->curr_size)
 		return LOOKUP_MAPPED;
 
 	evict_cline_no = evict_cline_no - cache->device->freelist_part->curr_size;
+
+	start = env_get_tick_count();
 	evicted = ocf_evict_do(cache, req->io_queue, evict_cline_no,
 			req->core_id, req->part_id);
+	duration = env_ticks_to_nsecs(env_get_tick_count() - start);
+
+	ocf_evict_account_time(cache, req->part_id, duration);
+	ocf_trace_eviction(req, evict_cline_no, evicted, duration);
+	ocf_trace_req_stage(req, ocf_event_req_stage_eviction_done, evicted);
 
 	if (evict_cline_no <= evicted)
 		return LOOKUP_MAPPED;
@@ -121,3 +181,157 @@ int space_managment_evict_do(struct ocf_cache *cache,
 	req->info.eviction_error |= true;
 	return LOOKUP_MISS;
 }
+
+int space_management_free(ocf_cache_t cache, ocf_queue_t io_queue,
+		uint32_t count)
+{
+	uint32_t to_evict, evicted = 0;
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+	uint16_t rank;
+
+	/* For each partition from the lowest priority to highest one */
+	for_each_evictable_part(cache, part, part_id, rank) {
+		if (evicted >= count)
+			break;
+
+		if (!ocf_eviction_can_evict(cache))
+			break;
+
+		to_evict = ocf_evict_calculate(part, count - evicted);
+		if (to_evict == 0)
+			continue;
+
+		evicted += ocf_eviction_need_space(cache, io_queue, part_id,
+				OCF_MIN(to_evict, count - evicted), 0);
+	}
+
+	return evicted;
+}
+
+static inline uint32_t ocf_eviction_reserve_lines(ocf_cache_t cache,
+		uint32_t watermark)
+{
+	return (uint64_t)cache->device->collision_table_entries *
+			watermark / 1000;
+}
+
+static int ocf_eviction_reserve_refill(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	uint32_t target, waiting, free, evicted = 0;
+
+	OCF_METADATA_LOCK_WR();
+
+	/* Make room for requests parked waiting for eviction as well */
+	waiting = cache->eviction_waiters.lines;
+	target = OCF_MAX(ocf_eviction_reserve_lines(cache,
+			OCF_CONFIG_EVICTION_RESERVE_HIGH), waiting);
+
+	free = cache->device->freelist_part->curr_size;
+	if (free < target) {
+		evicted = space_management_free(cache, req->io_queue,
+				OCF_MIN(target - free, OCF_EVICTION_RESERVE_BATCH));
+		free = cache->device->freelist_part->curr_size;
+	}
+
+	OCF_METADATA_UNLOCK_WR();
+
+	if (evicted && free < target) {
+		if (waiting && free >= waiting)
+			ocf_engine_wake_parked(cache);
+
+		/* Let pending I/O in before evicting next batch */
+		ocf_engine_push_req_back(req, false);
+		return 0;
+	}
+
+	/* Requests parked from now on schedule another refill */
+	env_atomic_set(&cache->eviction_reserve_pending, 0);
+	ocf_engine_wake_parked(cache);
+	ocf_req_put(req);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_eviction_reserve = {
+	.read = ocf_eviction_reserve_refill,
+	.write = ocf_eviction_reserve_refill,
+};
+
+bool ocf_eviction_refill_kick(ocf_cache_t cache, ocf_queue_t io_queue)
+{
+	struct ocf_request *req;
+
+	if (env_atomic_cmpxchg(&cache->eviction_reserve_pending, 0, 1))
+		return true;
+
+	req = ocf_req_new(io_queue, NULL, 0, 0, OCF_READ);
+	if (!req) {
+		env_atomic_set(&cache->eviction_reserve_pending, 0);
+		return false;
+	}
+
+	req->info.internal = true;
+	req->io_if = &_io_if_eviction_reserve;
+
+	ocf_engine_push_req_back(req, false);
+
+	return true;
+}
+
+void ocf_eviction_reserve_check(ocf_cache_t cache, ocf_queue_t io_queue)
+{
+	if (!OCF_CONFIG_EVICTION_RESERVE_LOW)
+		return;
+
+	if (cache->device->freelist_part->curr_size >=
+			ocf_eviction_reserve_lines(cache,
+				OCF_CONFIG_EVICTION_RESERVE_LOW)) {
+		return;
+	}
+
+	ocf_eviction_refill_kick(cache, io_queue);
+}
+
+void ocf_eviction_walk_hot(ocf_cache_t cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv)
+{
+	uint8_t type = cache->conf_meta->eviction_policy_type;
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+	ocf_cache_line_t entries = cache->device->collision_table_entries;
+	ocf_cache_line_t line = part->runtime->head;
+	uint32_t i;
+
+	ENV_BUG_ON(type >= ocf_eviction_max);
+
+	if (evict_policy_ops[type].walk_hot) {
+		evict_policy_ops[type].walk_hot(cache, part_id, visit, priv);
+		return;
+	}
+
+	/* Policy keeps no recency order, walk partition list instead */
+	if (line != entries) {
+		for (i = 0; i < part->runtime->curr_size; i++) {
+			if (!visit(cache, line, priv))
+				return;
+
+			line = ocf_metadata_get_partition_next(cache, line);
+		}
+		return;
+	}
+
+	/* Partition tracked by counters has no list, find its cache lines
+	 * by partition id
+	 */
+	for (line = 0, i = 0; line < entries &&
+			i < part->runtime->curr_size; line++) {
+		if (ocf_metadata_get_partition_id(cache, line) != part_id)
+			continue;
+
+		if (!visit(cache, line, priv))
+			return;
+
+		i++;
+	}
+}
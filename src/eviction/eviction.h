@@ -7,24 +7,63 @@
 #define __LAYER_EVICTION_POLICY_H__
 
 #include "ocf/ocf.h"
+
+/* Visitor of cache lines walked by eviction policy, returns false to stop */
+typedef bool (*ocf_eviction_visit_t)(ocf_cache_t cache,
+		ocf_cache_line_t cline, void *priv);
+
 #include "lru.h"
 #include "lru_structs.h"
+#include "clock.h"
+#include "clock_structs.h"
+#include "twoq.h"
+#include "twoq_structs.h"
+#include "ghost.h"
 #include "../ocf_request.h"
 
 #define OCF_TO_EVICTION_MIN 128UL
 #define OCF_PENDING_EVICTION_LIMIT 512UL
 
+/*
+ * Eviction policy lists of each partition are split into shards selected by
+ * cache line index, each shard protected by its own eviction lock
+ */
+static inline uint32_t ocf_eviction_shard_id(ocf_cache_line_t line)
+{
+	return line % OCF_EVICTION_SHARDS;
+}
+
 struct eviction_policy {
 	union {
 		struct lru_eviction_policy lru;
+		struct clock_eviction_policy clock;
+		struct twoq_eviction_policy twoq;
 	} policy;
 };
 
 /* Eviction policy metadata per cache line */
 union eviction_policy_meta {
 	struct lru_eviction_policy_meta lru;
+	struct clock_eviction_policy_meta clock;
+	struct twoq_eviction_policy_meta twoq;
 } __attribute__((packed));
 
+/*
+ * Size of per cache line eviction metadata, only the part of union used by
+ * given policy is kept in metadata
+ */
+static inline uint32_t ocf_eviction_meta_size(ocf_eviction_t type)
+{
+	switch (type) {
+	case ocf_eviction_clock:
+		return sizeof(struct clock_eviction_policy_meta);
+	case ocf_eviction_2q:
+		return sizeof(struct twoq_eviction_policy_meta);
+	default:
+		return sizeof(struct lru_eviction_policy_meta);
+	}
+}
+
 /* the caller must hold the metadata lock for all operations
  *
  * For range operations the caller can:
@@ -50,6 +89,9 @@ struct eviction_policy_ops {
 	void (*clean_cline)(ocf_cache_t cache,
 			ocf_part_id_t part_id,
 			uint32_t cline_no);
+	void (*walk_hot)(ocf_cache_t cache,
+			ocf_part_id_t part_id,
+			ocf_eviction_visit_t visit, void *priv);
 	const char *name;
 };
 
@@ -65,6 +107,35 @@ extern struct eviction_policy_ops evict_policy_ops[ocf_eviction_max];
 int space_managment_evict_do(ocf_cache_t cache,
 		struct ocf_request *req, uint32_t evict_cline_no);
 
-int space_management_free(ocf_cache_t cache, uint32_t count);
+/*
+ * Evicts up to count cache lines from partitions allowing eviction, in
+ * order of their priority, and returns number of evicted cache lines.
+ *
+ * The caller must hold the metadata WR lock.
+ */
+int space_management_free(ocf_cache_t cache, ocf_queue_t io_queue,
+		uint32_t count);
+
+/*
+ * Schedules refill of free cache lines reserve on the given queue if number
+ * of free cache lines dropped below low watermark
+ */
+void ocf_eviction_reserve_check(ocf_cache_t cache, ocf_queue_t io_queue);
+
+/*
+ * Schedules background eviction on the given queue unless it is already
+ * scheduled, freeing enough cache lines for parked requests and up to high
+ * watermark of the reserve. Returns false if it could not be scheduled.
+ */
+bool ocf_eviction_refill_kick(ocf_cache_t cache, ocf_queue_t io_queue);
+
+/**
+ * @brief Visit cache lines of partition from the hottest to the coldest one,
+ *	in order kept by eviction policy
+ *
+ * @note Caller must hold metadata WR lock
+ */
+void ocf_eviction_walk_hot(ocf_cache_t cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv);
 
 #endif
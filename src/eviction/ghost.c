@@ -0,0 +1,249 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "eviction.h"
+#include "ghost.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_request.h"
+#include "../engine/cache_engine.h"
+#include "../metadata/metadata.h"
+#include "../utils/utils_part.h"
+
+/*
+ * Ghost history is a direct-mapped table of 32 bit tags of evicted core
+ * lines, together with id of partition they were evicted from. Colliding
+ * core lines replace each other and entry is consumed by its ghost hit.
+ *
+ * Occupancy targets of all partitions sum up to at most half of the cache,
+ * so that there is always room for partitions which ghosts are not hit.
+ * Once the sum reaches that limit targets are halved, which lets them
+ * follow the recent hit pattern.
+ */
+
+#define GHOST_TABLE_MAX_ENTRIES	(1U << 22)
+#define GHOST_TABLE_MIN_ENTRIES	(1U << 10)
+
+#define GHOST_ENTRY(tag, part_id) ((long)(((uint64_t)(tag) << 32) | \
+		((part_id) + 1)))
+#define GHOST_ENTRY_TAG(entry)	((uint32_t)((uint64_t)(entry) >> 32))
+#define GHOST_ENTRY_PART(entry)	((ocf_part_id_t)(((uint64_t)(entry) & \
+		0xFFFFU) - 1))
+
+static inline uint64_t ghost_hash(ocf_core_id_t core_id, uint64_t core_line)
+{
+	uint64_t z = core_line ^ ((uint64_t)core_id << 48);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+static inline env_atomic64 *ghost_slot(struct ocf_eviction_ghost *ghost,
+		uint64_t hash)
+{
+	return &ghost->table[hash & (ghost->table_entries - 1)];
+}
+
+static void ocf_eviction_ghost_reset(ocf_cache_t cache)
+{
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+	ocf_part_id_t part_id;
+
+	for (part_id = 0; part_id < OCF_IO_CLASS_MAX; part_id++) {
+		env_atomic_set(&cache->user_parts[part_id].ghost_hits, 0);
+		env_atomic_set(&cache->user_parts[part_id].ghost_target, 0);
+	}
+
+	env_atomic_set(&ghost->target_total, 0);
+	env_atomic_set(&ghost->aging, 0);
+	ghost->adaptive = false;
+}
+
+/* Largest power of two not exceeding number of cache lines */
+static uint32_t ocf_eviction_ghost_entries(ocf_cache_line_t lines)
+{
+	uint32_t entries = GHOST_TABLE_MIN_ENTRIES;
+
+	while (entries < GHOST_TABLE_MAX_ENTRIES && entries * 2ULL <= lines)
+		entries *= 2;
+
+	return entries;
+}
+
+size_t ocf_eviction_ghost_size_of(ocf_cache_line_t lines)
+{
+	if (!OCF_CONFIG_EVICTION_GHOST)
+		return 0;
+
+	return sizeof(*((struct ocf_eviction_ghost *)0)->table) *
+			ocf_eviction_ghost_entries(lines);
+}
+
+int ocf_eviction_ghost_attach(ocf_cache_t cache)
+{
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+	uint32_t entries;
+
+	ENV_BUG_ON(ghost->table);
+
+	ocf_eviction_ghost_reset(cache);
+
+	if (!OCF_CONFIG_EVICTION_GHOST)
+		return 0;
+
+	entries = ocf_eviction_ghost_entries(
+			cache->device->collision_table_entries);
+
+	ghost->table = env_vzalloc(sizeof(*ghost->table) * entries);
+	if (!ghost->table) {
+		ocf_cache_log(cache, log_err, "Cannot allocate eviction "
+				"ghost history\n");
+		return -OCF_ERR_NO_MEM;
+	}
+
+	ghost->table_entries = entries;
+
+	return 0;
+}
+
+void ocf_eviction_ghost_detach(ocf_cache_t cache)
+{
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+
+	ocf_eviction_ghost_reset(cache);
+
+	if (!ghost->table)
+		return;
+
+	env_vfree(ghost->table);
+	ghost->table = NULL;
+	ghost->table_entries = 0;
+}
+
+void ocf_eviction_ghost_add(ocf_cache_t cache, ocf_part_id_t part_id,
+		ocf_core_id_t core_id, uint64_t core_line)
+{
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+	uint64_t hash;
+
+	if (!ghost->table)
+		return;
+
+	hash = ghost_hash(core_id, core_line);
+	env_atomic64_set(ghost_slot(ghost, hash),
+			GHOST_ENTRY(hash >> 32, part_id));
+}
+
+void ocf_eviction_ghost_add_line(ocf_cache_t cache, ocf_cache_line_t line)
+{
+	ocf_core_id_t core_id;
+	uint64_t core_line;
+
+	if (!cache->ghost.table)
+		return;
+
+	ocf_metadata_get_core_info(cache, line, &core_id, &core_line);
+	ocf_eviction_ghost_add(cache, ocf_metadata_get_partition_id(cache, line),
+			core_id, core_line);
+}
+
+/* Halve occupancy targets, so that they follow recent ghost hits */
+static void ocf_eviction_ghost_age(ocf_cache_t cache)
+{
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+	int shift;
+
+	if (env_atomic_cmpxchg(&ghost->aging, 0, 1))
+		return;
+
+	for (part_id = 0; part_id < OCF_IO_CLASS_MAX; part_id++) {
+		part = &cache->user_parts[part_id];
+
+		shift = env_atomic_read(&part->ghost_target) / 2;
+		env_atomic_sub(shift, &part->ghost_target);
+		env_atomic_sub(shift, &ghost->target_total);
+
+		ocf_part_evict_update(cache, part);
+	}
+
+	env_atomic_set(&ghost->aging, 0);
+}
+
+static void ocf_eviction_ghost_hit(ocf_cache_t cache, ocf_part_id_t part_id)
+{
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+	int budget = cache->device->collision_table_entries / 2;
+
+	env_atomic_inc(&part->ghost_hits);
+
+	if (!ghost->adaptive)
+		return;
+
+	if (env_atomic_inc_return(&ghost->target_total) > budget) {
+		env_atomic_dec(&ghost->target_total);
+		ocf_eviction_ghost_age(cache);
+		return;
+	}
+
+	env_atomic_inc(&part->ghost_target);
+	ocf_part_evict_update(cache, part);
+}
+
+void ocf_eviction_ghost_lookup(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+	env_atomic64 *slot;
+	uint64_t hash;
+	uint32_t i;
+	long old;
+
+	if (!ghost->table)
+		return;
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (req->map[i].status != LOOKUP_MISS)
+			continue;
+
+		hash = ghost_hash(req->core_id, req->core_line_first + i);
+		slot = ghost_slot(ghost, hash);
+
+		old = env_atomic64_read(slot);
+		if (!old || GHOST_ENTRY_TAG(old) != (uint32_t)(hash >> 32))
+			continue;
+
+		/* Consume entry, so that each eviction is counted once */
+		if (env_atomic64_cmpxchg(slot, old, 0) != old)
+			continue;
+
+		if (GHOST_ENTRY_PART(old) < OCF_IO_CLASS_MAX)
+			ocf_eviction_ghost_hit(cache, GHOST_ENTRY_PART(old));
+	}
+}
+
+void ocf_eviction_ghost_set_adaptive(ocf_cache_t cache, bool adaptive)
+{
+	struct ocf_eviction_ghost *ghost = &cache->ghost;
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+
+	ghost->adaptive = adaptive;
+	if (adaptive)
+		return;
+
+	/* Give back cache lines protected by occupancy targets */
+	for (part_id = 0; part_id < OCF_IO_CLASS_MAX; part_id++) {
+		part = &cache->user_parts[part_id];
+
+		env_atomic_set(&part->ghost_target, 0);
+		ocf_part_evict_update(cache, part);
+	}
+
+	env_atomic_set(&ghost->target_total, 0);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __EVICTION_GHOST_H__
+#define __EVICTION_GHOST_H__
+
+#include "ocf/ocf.h"
+#include "ocf_env.h"
+
+struct ocf_request;
+
+/*
+ * Ghost history remembers core lines recently evicted from each partition.
+ * Miss on a core line found in history is a ghost hit - the line would have
+ * been hit if its partition was bigger. In adaptive mode each ghost hit
+ * raises occupancy target of the partition, which protects that many of its
+ * cache lines from eviction, as partition minimum size does.
+ */
+struct ocf_eviction_ghost {
+	env_atomic64 *table;
+		/*!< Direct-mapped table of evicted core lines */
+
+	uint32_t table_entries;
+
+	bool adaptive;
+		/*!< Occupancy targets follow ghost hits */
+
+	env_atomic target_total;
+		/*!< Sum of occupancy targets of all partitions */
+
+	env_atomic aging;
+};
+
+/**
+ * @brief Allocate ghost history of attached cache
+ *
+ * @param cache - OCF cache instance
+ * @return 0 - Allocation successful, otherwise ERROR
+ */
+int ocf_eviction_ghost_attach(ocf_cache_t cache);
+
+/**
+ * @brief Get memory footprint of ghost history of cache
+ *
+ * @param lines - Number of cache lines
+ * @return Size of ghost history in bytes
+ */
+size_t ocf_eviction_ghost_size_of(ocf_cache_line_t lines);
+
+/**
+ * @brief Free ghost history and reset occupancy targets
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_eviction_ghost_detach(ocf_cache_t cache);
+
+/**
+ * @brief Remember core line evicted from partition
+ *
+ * @note The caller must hold the metadata WR lock
+ */
+void ocf_eviction_ghost_add(ocf_cache_t cache, ocf_part_id_t part_id,
+		ocf_core_id_t core_id, uint64_t core_line);
+
+/**
+ * @brief Remember core line mapped to cache line being evicted
+ *
+ * @note The caller must hold the metadata WR lock
+ */
+void ocf_eviction_ghost_add_line(ocf_cache_t cache, ocf_cache_line_t line);
+
+/**
+ * @brief Account ghost hits of missed core lines of request
+ *
+ * @note The caller must hold hash bucket lock of request
+ */
+void ocf_eviction_ghost_lookup(struct ocf_request *req);
+
+/**
+ * @brief Enable or disable adaptive occupancy targets
+ *
+ * @note The caller must hold the metadata WR lock
+ */
+void ocf_eviction_ghost_set_adaptive(ocf_cache_t cache, bool adaptive);
+
+#endif
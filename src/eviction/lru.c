@@ -12,9 +12,22 @@
 #include "../mngt/ocf_mngt_common.h"
 #include "../engine/engine_zero.h"
 #include "../utils/utils_req.h"
+#include "../utils/utils_sort.h"
 
 #define OCF_EVICTION_MAX_SCAN 1024
 
+/* Maximum number of cache lines evicted in single batch */
+#define OCF_EVICTION_BATCH 32
+
+/* Number of shard tails compared by cost-aware LRU to pick each victim */
+#define OCF_LRU_COST_CANDIDATES 4
+
+struct evp_lru_victim {
+	ocf_cache_line_t cline;
+	ocf_core_id_t core_id;
+	uint64_t core_line;
+};
+
 /* -- Start of LRU functions --*/
 
 /* Returns 1 if the given collision_index is the _head_ of
@@ -28,41 +41,45 @@
 #define is_lru_head(x) (x == collision_table_entries)
 #define is_lru_tail(x) (x == collision_table_entries)
 
-/* Sets the given collision_index as the new _head_ of the LRU list. */
-static inline void update_lru_head(ocf_cache_t cache,
-		int partition_id, unsigned int collision_index,
-		int cline_dirty)
+/* Returns LRU list shard the given collision_index belongs to */
+static inline struct lru_eviction_policy_shard *get_lru_shard(
+		ocf_cache_t cache, int partition_id,
+		unsigned int collision_index)
 {
 	struct ocf_user_part *part = &cache->user_parts[partition_id];
 
+	return &part->runtime->eviction.policy.lru.shard[
+			ocf_eviction_shard_id(collision_index)];
+}
 
+/* Sets the given collision_index as the new _head_ of the LRU list. */
+static inline void update_lru_head(struct lru_eviction_policy_shard *lru,
+		unsigned int collision_index, int cline_dirty)
+{
 	if (cline_dirty)
-		part->runtime->eviction.policy.lru.dirty_head = collision_index;
+		lru->dirty_head = collision_index;
 	else
-		part->runtime->eviction.policy.lru.clean_head = collision_index;
+		lru->clean_head = collision_index;
 }
 
 /* Sets the given collision_index as the new _tail_ of the LRU list. */
-static inline void update_lru_tail(ocf_cache_t cache,
-		int partition_id, unsigned int collision_index,
-		int cline_dirty)
+static inline void update_lru_tail(struct lru_eviction_policy_shard *lru,
+		unsigned int collision_index, int cline_dirty)
 {
-	struct ocf_user_part *part = &cache->user_parts[partition_id];
-
 	if (cline_dirty)
-		part->runtime->eviction.policy.lru.dirty_tail = collision_index;
+		lru->dirty_tail = collision_index;
 	else
-		part->runtime->eviction.policy.lru.clean_tail = collision_index;
+		lru->clean_tail = collision_index;
 }
 
 /* Sets the given collision_index as the new _head_ and _tail_ of
  * the LRU list.
  */
-static inline void update_lru_head_tail(ocf_cache_t cache,
-		int partition_id, unsigned int collision_index, int cline_dirty)
+static inline void update_lru_head_tail(struct lru_eviction_policy_shard *lru,
+		unsigned int collision_index, int cline_dirty)
 {
-	update_lru_head(cache, partition_id, collision_index, cline_dirty);
-	update_lru_tail(cache, partition_id, collision_index, cline_dirty);
+	update_lru_head(lru, collision_index, cline_dirty);
+	update_lru_tail(lru, collision_index, cline_dirty);
 }
 
 /* Adds the given collision_index to the _head_ of the LRU list */
@@ -72,25 +89,30 @@ static void add_lru_head(ocf_cache_t cache, int partition_id,
 	unsigned int curr_head_index;
 	unsigned int collision_table_entries =
 			cache->device->collision_table_entries;
-	struct ocf_user_part *part = &cache->user_parts[partition_id];
+	struct lru_eviction_policy_shard *lru =
+			get_lru_shard(cache, partition_id, collision_index);
 	union eviction_policy_meta eviction;
 
 	ENV_BUG_ON(!(collision_index < collision_table_entries));
 
 	ocf_metadata_get_evicition_policy(cache, collision_index, &eviction);
 
+#if OCF_CONFIG_LRU_PROMOTION_WINDOW > 0
+	eviction.lru.gen = ++lru->gen;
+#endif
+
 	/* First node to be added/ */
-	if ((cline_dirty && !part->runtime->eviction.policy.lru.has_dirty_nodes) ||
-	    (!cline_dirty && !part->runtime->eviction.policy.lru.has_clean_nodes)) {
-		update_lru_head_tail(cache, partition_id, collision_index, cline_dirty);
+	if ((cline_dirty && !lru->has_dirty_nodes) ||
+	    (!cline_dirty && !lru->has_clean_nodes)) {
+		update_lru_head_tail(lru, collision_index, cline_dirty);
 
 		eviction.lru.next = collision_table_entries;
 		eviction.lru.prev = collision_table_entries;
 
 		if (cline_dirty)
-			part->runtime->eviction.policy.lru.has_dirty_nodes = 1;
+			lru->has_dirty_nodes = 1;
 		else
-			part->runtime->eviction.policy.lru.has_clean_nodes = 1;
+			lru->has_clean_nodes = 1;
 
 		ocf_metadata_set_evicition_policy(cache, collision_index,
 				&eviction);
@@ -99,8 +121,8 @@ static void add_lru_head(ocf_cache_t cache, int partition_id,
 
 		/* Not the first node to be added. */
 		curr_head_index = cline_dirty ?
-				part->runtime->eviction.policy.lru.dirty_head :
-				part->runtime->eviction.policy.lru.clean_head;
+				lru->dirty_head :
+				lru->clean_head;
 
 		ENV_BUG_ON(!(curr_head_index < collision_table_entries));
 
@@ -111,7 +133,7 @@ static void add_lru_head(ocf_cache_t cache, int partition_id,
 		eviction.lru.prev = collision_table_entries;
 		eviction_curr.lru.prev = collision_index;
 
-		update_lru_head(cache, partition_id, collision_index, cline_dirty);
+		update_lru_head(lru, collision_index, cline_dirty);
 
 		ocf_metadata_set_evicition_policy(cache, curr_head_index,
 				&eviction_curr);
@@ -127,7 +149,8 @@ static void remove_lru_list(ocf_cache_t cache, int partition_id,
 	int is_clean_head = 0, is_clean_tail = 0, is_dirty_head = 0, is_dirty_tail = 0;
 	uint32_t prev_lru_node, next_lru_node;
 	uint32_t collision_table_entries = cache->device->collision_table_entries;
-	struct ocf_user_part *part = &cache->user_parts[partition_id];
+	struct lru_eviction_policy_shard *lru =
+			get_lru_shard(cache, partition_id, collision_index);
 	union eviction_policy_meta eviction;
 
 	ENV_BUG_ON(!(collision_index < collision_table_entries));
@@ -135,13 +158,13 @@ static void remove_lru_list(ocf_cache_t cache, int partition_id,
 	ocf_metadata_get_evicition_policy(cache, collision_index, &eviction);
 
 	/* Find out if this node is LRU _head_ or LRU _tail_ */
-	if (part->runtime->eviction.policy.lru.clean_head == collision_index)
+	if (lru->clean_head == collision_index)
 		is_clean_head = 1;
-	if (part->runtime->eviction.policy.lru.dirty_head == collision_index)
+	if (lru->dirty_head == collision_index)
 		is_dirty_head = 1;
-	if (part->runtime->eviction.policy.lru.clean_tail == collision_index)
+	if (lru->clean_tail == collision_index)
 		is_clean_tail = 1;
-	if (part->runtime->eviction.policy.lru.dirty_tail == collision_index)
+	if (lru->dirty_tail == collision_index)
 		is_dirty_tail = 1;
 	ENV_BUG_ON((is_clean_tail || is_clean_head) && (is_dirty_tail || is_dirty_head));
 
@@ -156,18 +179,17 @@ static void remove_lru_list(ocf_cache_t cache, int partition_id,
 		eviction.lru.next = collision_table_entries;
 		eviction.lru.prev = collision_table_entries;
 
-		update_lru_head_tail(cache, partition_id, collision_table_entries, cline_dirty);
+		update_lru_head_tail(lru, collision_table_entries, cline_dirty);
 
 		if (cline_dirty)
-			part->runtime->eviction.policy.lru.has_dirty_nodes = 0;
+			lru->has_dirty_nodes = 0;
 		else
-			 part->runtime->eviction.policy.lru.has_clean_nodes = 0;
+			 lru->has_clean_nodes = 0;
 
 		ocf_metadata_set_evicition_policy(cache, collision_index,
 				&eviction);
 
-		update_lru_head_tail(cache, partition_id,
-				collision_table_entries, cline_dirty);
+		update_lru_head_tail(lru, collision_table_entries, cline_dirty);
 	}
 
 	/* Case 2: else if this collision_index is LRU head, but not tail,
@@ -181,7 +203,7 @@ static void remove_lru_list(ocf_cache_t cache, int partition_id,
 		ocf_metadata_get_evicition_policy(cache, next_lru_node,
 				&eviction_next);
 
-		update_lru_head(cache, partition_id, next_lru_node, cline_dirty);
+		update_lru_head(lru, next_lru_node, cline_dirty);
 
 		eviction.lru.next = collision_table_entries;
 		eviction_next.lru.prev = collision_table_entries;
@@ -201,7 +223,7 @@ static void remove_lru_list(ocf_cache_t cache, int partition_id,
 
 		ENV_BUG_ON(!(prev_lru_node < collision_table_entries));
 
-		update_lru_tail(cache, partition_id, prev_lru_node, cline_dirty);
+		update_lru_tail(lru, prev_lru_node, cline_dirty);
 
 		ocf_metadata_get_evicition_policy(cache, prev_lru_node,
 				&eviction_prev);
@@ -307,10 +329,10 @@ static int evp_lru_clean_getter(ocf_cache_t cache,
 }
 
 static void evp_lru_clean(ocf_cache_t cache, ocf_queue_t io_queue,
-		ocf_part_id_t part_id, uint32_t count)
+		ocf_part_id_t part_id, ocf_cache_line_t dirty_tail,
+		uint32_t count)
 {
 	env_atomic *progress = &cache->cleaning[part_id];
-	struct ocf_user_part *part = &cache->user_parts[part_id];
 
 	if (ocf_mngt_is_cache_locked(cache))
 		return;
@@ -326,7 +348,7 @@ static void evp_lru_clean(ocf_cache_t cache, ocf_queue_t io_queue,
 
 			.getter = evp_lru_clean_getter,
 			.getter_context = &attribs,
-			.getter_item = part->runtime->eviction.policy.lru.dirty_tail,
+			.getter_item = dirty_tail,
 
 			.count = count > 32 ? 32 : count,
 
@@ -337,31 +359,112 @@ static void evp_lru_clean(ocf_cache_t cache, ocf_queue_t io_queue,
 	}
 }
 
-static void evp_lru_zero_line_complete(struct ocf_request *ocf_req, int error)
+static void evp_lru_zero_lines_complete(struct ocf_request *ocf_req,
+		int error)
 {
-	env_atomic_dec(&ocf_req->cache->pending_eviction_clines);
+	env_atomic_sub(ocf_req->core_line_count,
+			&ocf_req->cache->pending_eviction_clines);
 }
 
-static void evp_lru_zero_line(ocf_cache_t cache, ocf_queue_t io_queue,
-		ocf_cache_line_t line)
+/*
+ * Zero batch of cache lines of one core. Core lines don't have to be
+ * consecutive, zero engine merges lines by their position on cache device.
+ */
+static void evp_lru_zero_lines(ocf_cache_t cache, ocf_queue_t io_queue,
+		struct evp_lru_victim *victims, uint32_t count)
 {
+	ocf_cache_line_t lines[OCF_EVICTION_BATCH];
+	uint64_t core_lines[OCF_EVICTION_BATCH];
 	struct ocf_request *req;
-	ocf_core_id_t id;
-	uint64_t addr, core_line;
+	uint32_t i;
+
+	ENV_BUG_ON(count > OCF_EVICTION_BATCH);
+
+	req = ocf_req_new_extended(io_queue, &cache->core[victims->core_id],
+			0, ocf_line_size(cache) * count, OCF_WRITE);
+	if (!req)
+		return;
+
+	for (i = 0; i < count; i++) {
+		lines[i] = victims[i].cline;
+		core_lines[i] = victims[i].core_line;
+	}
+
+	req->info.internal = true;
+	req->complete = evp_lru_zero_lines_complete;
+
+	env_atomic_add(count, &cache->pending_eviction_clines);
+
+	ocf_engine_zero_lines(req, lines, core_lines);
+}
+
+static int evp_lru_victim_cmp(const void *a, const void *b)
+{
+	const struct evp_lru_victim *_a = a, *_b = b;
+
+	if (_a->core_id != _b->core_id)
+		return _a->core_id < _b->core_id ? -1 : 1;
+
+	if (_a->core_line != _b->core_line)
+		return _a->core_line < _b->core_line ? -1 : 1;
+
+	return 0;
+}
+
+static uint64_t evp_lru_victim_key(const void *entry, uint32_t key)
+{
+	const struct evp_lru_victim *victim = entry;
+
+	return key ? victim->core_line : victim->core_id;
+}
+
+static void evp_lru_victim_swap(void *a, void *b, int size)
+{
+	struct evp_lru_victim *_a = a, *_b = b, t;
+
+	t = *_a;
+	*_a = *_b;
+	*_b = t;
+}
+
+/*
+ * Evict collected batch of cache lines. On atomic cache victims are sorted
+ * so that lines of each core are trimmed with single request.
+ * Returns number of cache lines evicted synchronously.
+ */
+static uint32_t evp_lru_evict_batch(ocf_cache_t cache, ocf_queue_t io_queue,
+		struct evp_lru_victim *victims, uint32_t victim_no)
+{
+	uint32_t i, run;
 
-	ocf_metadata_get_core_info(cache, line, &id, &core_line);
-	addr = core_line * ocf_line_size(cache);
+	if (!ocf_volume_is_atomic(&cache->device->volume)) {
+		for (i = 0; i < victim_no; i++) {
+			set_cache_line_invalid_no_flush(cache, 0,
+					ocf_line_end_sector(cache),
+					victims[i].cline);
+		}
 
-	req = ocf_req_new(io_queue, &cache->core[id], addr,
-			ocf_line_size(cache), OCF_WRITE);
-	if (req) {
-		req->info.internal = true;
-		req->complete = evp_lru_zero_line_complete;
+		return victim_no;
+	}
+
+	/*
+	 * atomic cache, we have to trim cache lines before eviction. Victims
+	 * are grouped per core, so that each core gets one zero request
+	 * with single metadata flush.
+	 */
+	ocf_sort(victims, victim_no, sizeof(*victims), 2, evp_lru_victim_key,
+			evp_lru_victim_cmp, evp_lru_victim_swap);
 
-		env_atomic_inc(&cache->pending_eviction_clines);
+	for (i = 0; i < victim_no; i += run) {
+		for (run = 1; i + run < victim_no; run++) {
+			if (victims[i + run].core_id != victims[i].core_id)
+				break;
+		}
 
-		ocf_engine_zero_line(req);
+		evp_lru_zero_lines(cache, io_queue, &victims[i], run);
 	}
+
+	return 0;
 }
 
 bool evp_lru_can_evict(ocf_cache_t cache)
@@ -374,74 +477,205 @@ bool evp_lru_can_evict(ocf_cache_t cache)
 	return true;
 }
 
-/* the caller must hold the metadata lock */
-uint32_t evp_lru_req_clines(ocf_cache_t cache, ocf_queue_t io_queue,
-		ocf_part_id_t part_id, uint32_t cline_no, ocf_core_id_t core_id)
+/* Skip cache lines locked by requests, walking towards head of the list */
+static ocf_cache_line_t evp_lru_first_unused(ocf_cache_t cache,
+		ocf_part_id_t part_id, ocf_cache_line_t cline)
 {
-	uint32_t i;
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
+	union eviction_policy_meta eviction;
+	uint32_t locked = 0;
+
+	while (cline != collision_table_entries) {
+		ENV_BUG_ON(cline > collision_table_entries);
+
+		/* Prevent evicting already locked items */
+		if (!ocf_cache_line_is_used(cache, cline))
+			break;
+
+		locked++;
+
+		ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+		cline = eviction.lru.prev;
+	}
+
+	if (locked)
+		ocf_eviction_stats_add(cache, part_id, locked_clines, locked);
+
+	return cline;
+}
+
+/* Cost of refetching cache line is read latency of its core */
+static inline uint64_t evp_lru_line_cost(ocf_cache_t cache,
+		ocf_cache_line_t cline)
+{
+	ocf_core_id_t core_id;
+
+	ocf_metadata_get_core_info(cache, cline, &core_id, NULL);
+
+	return env_atomic64_read(&cache->core[core_id].read_latency);
+}
+
+/*
+ * Compare tail cache lines of OCF_LRU_COST_CANDIDATES shards starting from
+ * the given one, which tail must be valid, and return shard holding the
+ * cheapest of them to refetch
+ */
+static uint32_t evp_lru_cheapest_shard(ocf_cache_t cache,
+		ocf_part_id_t part_id, ocf_cache_line_t *curr, uint32_t shard)
+{
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
+	uint64_t cost, best_cost = evp_lru_line_cost(cache, curr[shard]);
+	uint32_t i, candidate, best = shard;
+
+	for (i = 1; i < OCF_LRU_COST_CANDIDATES && best_cost; i++) {
+		candidate = (shard + i) % OCF_EVICTION_SHARDS;
+
+		curr[candidate] = evp_lru_first_unused(cache, part_id,
+				curr[candidate]);
+		if (curr[candidate] == collision_table_entries)
+			continue;
+
+		cost = evp_lru_line_cost(cache, curr[candidate]);
+		if (cost < best_cost) {
+			best = candidate;
+			best_cost = cost;
+		}
+	}
+
+	return best;
+}
+
+static uint32_t _evp_lru_req_clines(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no, bool cost_aware)
+{
+	uint32_t i, shard, victim_shard, empty, victim_no = 0;
 	ocf_cache_line_t curr_cline, prev_cline;
+	ocf_cache_line_t curr[OCF_EVICTION_SHARDS];
+	struct evp_lru_victim victims[OCF_EVICTION_BATCH];
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
 	struct ocf_user_part *part = &cache->user_parts[part_id];
+	struct lru_eviction_policy *lru = &part->runtime->eviction.policy.lru;
 	union eviction_policy_meta eviction;
 
 	if (cline_no == 0)
 		return 0;
 
-	i =  0;
-	curr_cline = part->runtime->eviction.policy.lru.clean_tail;
-	/* Find cachelines to be evicted. */
-	while (i < cline_no) {
-		ENV_BUG_ON(curr_cline > cache->device->collision_table_entries);
+	for (shard = 0; shard < OCF_EVICTION_SHARDS; shard++)
+		curr[shard] = lru->shard[shard].clean_tail;
 
+	i = 0;
+	empty = 0;
+	shard = lru->evict_shard % OCF_EVICTION_SHARDS;
+
+	/*
+	 * Find cachelines to be evicted, taking one cache line from tail of
+	 * each shard in round-robin manner, until requested number of cache
+	 * lines is evicted or all shards are exhausted.
+	 */
+	while (i + victim_no < cline_no && empty < OCF_EVICTION_SHARDS) {
 		if (!evp_lru_can_evict(cache))
 			break;
 
-		if (curr_cline == cache->device->collision_table_entries)
-			break;
+		curr[shard] = evp_lru_first_unused(cache, part_id, curr[shard]);
 
-		ocf_metadata_get_evicition_policy(cache, curr_cline,
-				&eviction);
-		prev_cline = eviction.lru.prev;
-
-		/* Prevent evicting already locked items */
-		if (ocf_cache_line_is_used(cache, curr_cline)) {
-			curr_cline = prev_cline;
+		if (curr[shard] == collision_table_entries) {
+			empty++;
+			shard = (shard + 1) % OCF_EVICTION_SHARDS;
 			continue;
 		}
 
-		ENV_BUG_ON(metadata_test_dirty(cache, curr_cline));
+		empty = 0;
 
-		if (ocf_volume_is_atomic(&cache->device->volume)) {
-			/* atomic cache, we have to trim cache lines before
-			 * eviction
-			 */
-			evp_lru_zero_line(cache, io_queue, curr_cline);
+		victim_shard = shard;
+		if (cost_aware)
+			victim_shard = evp_lru_cheapest_shard(cache, part_id,
+					curr, shard);
 
-		} else {
-			set_cache_line_invalid_no_flush(cache, 0,
-					ocf_line_end_sector(cache),
-					curr_cline);
+		curr_cline = curr[victim_shard];
 
-			/* Goto next item. */
-			i++;
+		ocf_metadata_get_evicition_policy(cache, curr_cline,
+				&eviction);
+		prev_cline = eviction.lru.prev;
+
+		ENV_BUG_ON(metadata_test_dirty(cache, curr_cline));
+
+		victims[victim_no].cline = curr_cline;
+		ocf_metadata_get_core_info(cache, curr_cline,
+				&victims[victim_no].core_id,
+				&victims[victim_no].core_line);
+		ocf_eviction_ghost_add(cache, part_id,
+				victims[victim_no].core_id,
+				victims[victim_no].core_line);
+
+		if (++victim_no == OCF_EVICTION_BATCH) {
+			i += evp_lru_evict_batch(cache, io_queue, victims,
+					victim_no);
+			victim_no = 0;
 		}
 
-		curr_cline = prev_cline;
+		curr[victim_shard] = prev_cline;
+		shard = (shard + 1) % OCF_EVICTION_SHARDS;
 	}
 
-	if (i < cline_no && part->runtime->eviction.policy.lru.dirty_tail !=
-			cache->device->collision_table_entries) {
-		evp_lru_clean(cache, io_queue, part_id, cline_no - i);
+	if (victim_no)
+		i += evp_lru_evict_batch(cache, io_queue, victims, victim_no);
+
+	lru->evict_shard = shard;
+
+	if (i < cline_no) {
+		/* Clean dirty tail of the next shard having dirty lines */
+		for (empty = 0; empty < OCF_EVICTION_SHARDS; empty++) {
+			shard = (lru->evict_shard + empty) %
+					OCF_EVICTION_SHARDS;
+			if (lru->shard[shard].dirty_tail ==
+					collision_table_entries) {
+				continue;
+			}
+
+			ocf_eviction_stats_add(cache, part_id,
+					dirty_fallbacks, 1);
+			ocf_cleaner_emergency(cache);
+			evp_lru_clean(cache, io_queue, part_id,
+					lru->shard[shard].dirty_tail,
+					cline_no - i);
+			break;
+		}
 	}
 
 	/* Return number of clines that were really evicted */
 	return i;
 }
 
+/* the caller must hold the metadata lock */
+uint32_t evp_lru_req_clines(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no, ocf_core_id_t core_id)
+{
+	return _evp_lru_req_clines(cache, io_queue, part_id, cline_no, false);
+}
+
+/*
+ * Cost-aware variant picks each victim among tails of several shards, all
+ * of them being least recently used lines, preferring the line of core with
+ * the lowest read latency. With equal core latencies it evicts exactly like
+ * plain LRU.
+ *
+ * the caller must hold the metadata lock
+ */
+uint32_t evp_lru_cost_req_clines(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no, ocf_core_id_t core_id)
+{
+	return _evp_lru_req_clines(cache, io_queue, part_id, cline_no, true);
+}
+
 /* the caller must hold the metadata lock */
 void evp_lru_hot_cline(ocf_cache_t cache, ocf_cache_line_t cline)
 {
 	ocf_part_id_t part_id = ocf_metadata_get_partition_id(cache, cline);
-	struct ocf_user_part *part = &cache->user_parts[part_id];
+	struct lru_eviction_policy_shard *lru =
+			get_lru_shard(cache, part_id, cline);
 
 	uint32_t prev_lru_node, next_lru_node;
 	uint32_t collision_table_entries = cache->device->collision_table_entries;
@@ -458,10 +692,17 @@ void evp_lru_hot_cline(ocf_cache_t cache, ocf_cache_line_t cline)
 
 	if ((next_lru_node != collision_table_entries) ||
 	    (prev_lru_node != collision_table_entries) ||
-	    ((part->runtime->eviction.policy.lru.clean_head == cline) &&
-	     (part->runtime->eviction.policy.lru.clean_tail == cline)) ||
-	    ((part->runtime->eviction.policy.lru.dirty_head == cline) &&
-	     (part->runtime->eviction.policy.lru.dirty_tail == cline))) {
+	    ((lru->clean_head == cline) &&
+	     (lru->clean_tail == cline)) ||
+	    ((lru->dirty_head == cline) &&
+	     (lru->dirty_tail == cline))) {
+#if OCF_CONFIG_LRU_PROMOTION_WINDOW > 0
+		/* Line is still close enough to the head, leave it there */
+		if (lru->gen - eviction.lru.gen <
+				OCF_CONFIG_LRU_PROMOTION_WINDOW) {
+			return;
+		}
+#endif
 		remove_lru_list(cache, part_id, cline, cline_dirty);
 	}
 
@@ -474,30 +715,80 @@ void evp_lru_init_evp(ocf_cache_t cache, ocf_part_id_t part_id)
 	unsigned int collision_table_entries =
 			cache->device->collision_table_entries;
 	struct ocf_user_part *part = &cache->user_parts[part_id];
+	struct lru_eviction_policy *lru = &part->runtime->eviction.policy.lru;
+	int i;
+
+	for (i = 0; i < OCF_EVICTION_SHARDS; i++) {
+		lru->shard[i].has_clean_nodes = 0;
+		lru->shard[i].has_dirty_nodes = 0;
+		lru->shard[i].clean_head = collision_table_entries;
+		lru->shard[i].clean_tail = collision_table_entries;
+		lru->shard[i].dirty_head = collision_table_entries;
+		lru->shard[i].dirty_tail = collision_table_entries;
+#if OCF_CONFIG_LRU_PROMOTION_WINDOW > 0
+		lru->shard[i].gen = 0;
+#endif
+	}
 
-	part->runtime->eviction.policy.lru.has_clean_nodes = 0;
-	part->runtime->eviction.policy.lru.has_dirty_nodes = 0;
-	part->runtime->eviction.policy.lru.clean_head = collision_table_entries;
-	part->runtime->eviction.policy.lru.clean_tail = collision_table_entries;
-	part->runtime->eviction.policy.lru.dirty_head = collision_table_entries;
-	part->runtime->eviction.policy.lru.dirty_tail = collision_table_entries;
+	lru->evict_shard = 0;
 }
 
 void evp_lru_clean_cline(ocf_cache_t cache, ocf_part_id_t part_id,
 		uint32_t cline)
 {
-	OCF_METADATA_EVICTION_LOCK();
+	OCF_METADATA_EVICTION_LOCK(cline);
 	remove_lru_list(cache, part_id, cline, 1);
 	add_lru_head(cache, part_id, cline, 0);
-	OCF_METADATA_EVICTION_UNLOCK();
+	OCF_METADATA_EVICTION_UNLOCK(cline);
 }
 
 void evp_lru_dirty_cline(ocf_cache_t cache, ocf_part_id_t part_id,
 		uint32_t cline)
 {
-	OCF_METADATA_EVICTION_LOCK();
+	OCF_METADATA_EVICTION_LOCK(cline);
 	remove_lru_list(cache, part_id, cline, 0);
 	add_lru_head(cache, part_id, cline, 1);
-	OCF_METADATA_EVICTION_UNLOCK();
+	OCF_METADATA_EVICTION_UNLOCK(cline);
 }
 
+/*
+ * Lists of all shards are walked from head in lockstep, so cache lines of
+ * similar recency are visited close to each other
+ */
+void evp_lru_walk_hot(ocf_cache_t cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv)
+{
+	ocf_cache_line_t end = cache->device->collision_table_entries;
+	struct lru_eviction_policy *lru =
+			&cache->user_parts[part_id].runtime->eviction.policy.lru;
+	ocf_cache_line_t cursor[OCF_EVICTION_SHARDS][2];
+	union eviction_policy_meta eviction;
+	bool more = true;
+	int i, j;
+
+	for (i = 0; i < OCF_EVICTION_SHARDS; i++) {
+		cursor[i][0] = lru->shard[i].has_clean_nodes ?
+				lru->shard[i].clean_head : end;
+		cursor[i][1] = lru->shard[i].has_dirty_nodes ?
+				lru->shard[i].dirty_head : end;
+	}
+
+	while (more) {
+		more = false;
+
+		for (i = 0; i < OCF_EVICTION_SHARDS; i++) {
+			for (j = 0; j < 2; j++) {
+				if (cursor[i][j] == end)
+					continue;
+
+				if (!visit(cache, cursor[i][j], priv))
+					return;
+
+				ocf_metadata_get_evicition_policy(cache,
+						cursor[i][j], &eviction);
+				cursor[i][j] = eviction.lru.next;
+				more = true;
+			}
+		}
+	}
+}
@@ -15,9 +15,14 @@ bool evp_lru_can_evict(struct ocf_cache *cache);
 uint32_t evp_lru_req_clines(struct ocf_cache *cache, ocf_queue_t io_queue,
 		ocf_part_id_t part_id, uint32_t cline_no,
 		ocf_core_id_t core_id);
+uint32_t evp_lru_cost_req_clines(struct ocf_cache *cache,
+		ocf_queue_t io_queue, ocf_part_id_t part_id, uint32_t cline_no,
+		ocf_core_id_t core_id);
 void evp_lru_hot_cline(struct ocf_cache *cache, ocf_cache_line_t cline);
 void evp_lru_init_evp(struct ocf_cache *cache, ocf_part_id_t part_id);
 void evp_lru_dirty_cline(struct ocf_cache *cache, ocf_part_id_t part_id, uint32_t cline);
 void evp_lru_clean_cline(struct ocf_cache *cache, ocf_part_id_t part_id, uint32_t cline);
+void evp_lru_walk_hot(struct ocf_cache *cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv);
 
 #endif
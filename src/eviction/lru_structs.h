@@ -6,19 +6,38 @@
 
 #define __EVICTION_LRU_STRUCTS_H__
 
+#include "ocf/ocf_cfg.h"
+
 struct lru_eviction_policy_meta {
 	/* LRU pointers 2*4=8 bytes */
 	uint32_t prev;
 	uint32_t next;
+#if OCF_CONFIG_LRU_PROMOTION_WINDOW > 0
+	/* Shard head generation at the time of last insertion at head */
+	uint32_t gen;
+#endif
 } __attribute__((packed));
 
-struct lru_eviction_policy {
+/* Number of LRU list shards of each partition */
+#define OCF_EVICTION_SHARDS 32
+
+struct lru_eviction_policy_shard {
 	int has_clean_nodes;
 	int has_dirty_nodes;
 	uint32_t dirty_head;
 	uint32_t dirty_tail;
 	uint32_t clean_head;
 	uint32_t clean_tail;
+#if OCF_CONFIG_LRU_PROMOTION_WINDOW > 0
+	/* Number of insertions at head of shard lists */
+	uint32_t gen;
+#endif
+};
+
+struct lru_eviction_policy {
+	struct lru_eviction_policy_shard shard[OCF_EVICTION_SHARDS];
+	/* Shard next eviction round-robin starts from */
+	uint32_t evict_shard;
 };
 
 #endif
@@ -9,6 +9,9 @@
 #include "eviction.h"
 #include "../metadata/metadata.h"
 
+#define ocf_eviction_stats_add(cache, part_id, counter, value) \
+	env_atomic64_add(value, &(cache)->eviction_counters[part_id].counter)
+
 /**
  * @brief Initialize cache line before adding it into eviction
  *
@@ -35,9 +38,9 @@ static inline void ocf_eviction_purge_cache_line(
 	ENV_BUG_ON(type >= ocf_eviction_max);
 
 	if (likely(evict_policy_ops[type].rm_cline)) {
-		OCF_METADATA_EVICTION_LOCK();
+		OCF_METADATA_EVICTION_LOCK(line);
 		evict_policy_ops[type].rm_cline(cache, line);
-		OCF_METADATA_EVICTION_UNLOCK();
+		OCF_METADATA_EVICTION_UNLOCK(line);
 	}
 }
 
@@ -74,6 +77,9 @@ static inline uint32_t ocf_eviction_need_space(struct ocf_cache *cache,
 				part_id, clines, core_id);
 	}
 
+	if (result)
+		ocf_eviction_stats_add(cache, part_id, evicted_clines, result);
+
 	return result;
 }
 
@@ -85,9 +91,9 @@ static inline void ocf_eviction_set_hot_cache_line(
 	ENV_BUG_ON(type >= ocf_eviction_max);
 
 	if (likely(evict_policy_ops[type].hot_cline)) {
-		OCF_METADATA_EVICTION_LOCK();
+		OCF_METADATA_EVICTION_LOCK(line);
 		evict_policy_ops[type].hot_cline(cache, line);
-		OCF_METADATA_EVICTION_UNLOCK();
+		OCF_METADATA_EVICTION_UNLOCK(line);
 	}
 }
 
@@ -99,9 +105,9 @@ static inline void ocf_eviction_initialize(struct ocf_cache *cache,
 	ENV_BUG_ON(type >= ocf_eviction_max);
 
 	if (likely(evict_policy_ops[type].init_evp)) {
-		OCF_METADATA_EVICTION_LOCK();
+		ocf_metadata_eviction_lock_all(cache);
 		evict_policy_ops[type].init_evp(cache, part_id);
-		OCF_METADATA_EVICTION_UNLOCK();
+		ocf_metadata_eviction_unlock_all(cache);
 	}
 }
 
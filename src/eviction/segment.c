@@ -0,0 +1,239 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "eviction.h"
+#include "ops.h"
+#include "segment.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_request.h"
+#include "../engine/engine_common.h"
+#include "../metadata/metadata.h"
+#include "../mngt/ocf_mngt_common.h"
+#include "../concurrency/ocf_concurrency.h"
+#include "../utils/utils_cache_line.h"
+#include "../utils/utils_cleaner.h"
+#include "../utils/utils_part.h"
+#include "../utils/utils_req.h"
+
+#if OCF_CONFIG_LOG_SEGMENT_LINES > 0
+
+/* Number of segments checked by single segment cleaner run */
+#define OCF_SEGMENT_CLEANER_SCAN 64
+
+/* Number of segments worth of free cache lines below which segments mostly
+ * in use are emptied as well, as eviction would drop that many lines anyway
+ */
+#define OCF_SEGMENT_CLEANER_LOW 2
+
+struct ocf_segment_cleaner_ctx {
+	struct ocf_cleaner_attribs attribs;
+	ocf_cache_line_t phy;
+};
+
+/*
+ * Finds segment with most free cache lines among the ones checked, which
+ * costs the least cache lines dropped. Unless cache is short of free cache
+ * lines at least half of the segment has to be free. Returns
+ * collision_table_entries if there is no such segment or if whole free
+ * segment was found, which allocation takes anyway.
+ */
+static ocf_cache_line_t ocf_segment_cleaner_pick(ocf_cache_t cache)
+{
+	ocf_cache_line_t entries = cache->device->collision_table_entries;
+	uint32_t segments = entries / OCF_CONFIG_LOG_SEGMENT_LINES;
+	uint32_t *cursor = &cache->segment_cleaner.cursor;
+	ocf_cache_line_t phy, picked = entries;
+	uint32_t i, free, picked_free = 0;
+
+	if (!segments)
+		return entries;
+
+	if (cache->device->freelist_part->curr_size >=
+			OCF_SEGMENT_CLEANER_LOW * OCF_CONFIG_LOG_SEGMENT_LINES) {
+		picked_free = OCF_CONFIG_LOG_SEGMENT_LINES / 2 - 1;
+	}
+
+	for (i = 0; i < OCF_MIN(segments, OCF_SEGMENT_CLEANER_SCAN); i++) {
+		phy = ((*cursor + i) % segments) * OCF_CONFIG_LOG_SEGMENT_LINES;
+		free = ocf_metadata_free_map_count(cache, phy,
+				OCF_CONFIG_LOG_SEGMENT_LINES);
+
+		if (free == OCF_CONFIG_LOG_SEGMENT_LINES) {
+			picked = entries;
+			break;
+		}
+
+		if (free > picked_free) {
+			picked = phy;
+			picked_free = free;
+		}
+	}
+
+	*cursor = (*cursor + i) % segments;
+
+	return picked;
+}
+
+/* Cache line may be dropped as if it was evicted from its partition */
+static bool ocf_segment_cleaner_can_drop(ocf_cache_t cache,
+		ocf_cache_line_t line)
+{
+	struct ocf_user_part *part;
+
+	if (!metadata_test_valid_any(cache, line))
+		return false;
+
+	if (ocf_cache_line_is_used(cache, line))
+		return false;
+
+	part = &cache->user_parts[ocf_metadata_get_partition_id(cache, line)];
+	if (ocf_part_is_pinned(part))
+		return false;
+
+	return part->runtime->curr_size > ocf_part_get_evict_min_size(part);
+}
+
+static int ocf_segment_cleaner_getter(ocf_cache_t cache,
+		void *getter_context, uint32_t item, ocf_cache_line_t *line)
+{
+	struct ocf_segment_cleaner_ctx *ctx = getter_context;
+	ocf_cache_line_t curr_cline;
+
+	while (ctx->attribs.getter_item < OCF_CONFIG_LOG_SEGMENT_LINES) {
+		curr_cline = ocf_metadata_map_phy2lg(cache,
+				ctx->phy + ctx->attribs.getter_item++);
+
+		if (!ocf_segment_cleaner_can_drop(cache, curr_cline) ||
+				!metadata_test_dirty(cache, curr_cline)) {
+			continue;
+		}
+
+		*line = curr_cline;
+		return 0;
+	}
+
+	return -1;
+}
+
+static void ocf_segment_cleaner_clean_end(void *private_data, int error)
+{
+	ocf_cache_t cache = private_data;
+
+	env_atomic_set(&cache->segment_cleaner.pending, 0);
+}
+
+/* the caller must hold the metadata WR lock */
+static bool ocf_segment_cleaner_clean(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_cache_line_t phy, uint32_t count)
+{
+	struct ocf_segment_cleaner_ctx ctx = {
+		.attribs = {
+			.cache_line_lock = true,
+			.do_sort = true,
+
+			.cmpl_context = cache,
+			.cmpl_fn = ocf_segment_cleaner_clean_end,
+
+			.getter = ocf_segment_cleaner_getter,
+			.getter_context = &ctx,
+			.getter_item = 0,
+
+			.count = count,
+
+			.io_queue = io_queue
+		},
+		.phy = phy,
+	};
+
+	if (ocf_mngt_is_cache_locked(cache))
+		return false;
+
+	ocf_cleaner_fire(cache, &ctx.attribs);
+
+	return true;
+}
+
+static int ocf_segment_cleaner_run(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	ocf_cache_line_t entries = cache->device->collision_table_entries;
+	ocf_cache_line_t phy, line;
+	ocf_part_id_t part_id;
+	uint32_t i, dirty = 0;
+	bool cleaning = false;
+
+	OCF_METADATA_LOCK_WR();
+
+	env_atomic_set(&cache->segment_cleaner.needed, 0);
+
+	phy = ocf_segment_cleaner_pick(cache);
+
+	for (i = 0; phy != entries && i < OCF_CONFIG_LOG_SEGMENT_LINES; i++) {
+		if (ocf_metadata_free_map_test(cache, phy + i))
+			continue;
+
+		line = ocf_metadata_map_phy2lg(cache, phy + i);
+		if (!ocf_segment_cleaner_can_drop(cache, line))
+			continue;
+
+		if (metadata_test_dirty(cache, line)) {
+			dirty++;
+			continue;
+		}
+
+		part_id = ocf_metadata_get_partition_id(cache, line);
+
+		ocf_eviction_ghost_add_line(cache, line);
+		set_cache_line_invalid_no_flush(cache, 0,
+				ocf_line_end_sector(cache), line);
+
+		ocf_eviction_stats_add(cache, part_id, evicted_clines, 1);
+	}
+
+	if (dirty)
+		cleaning = ocf_segment_cleaner_clean(cache, req->io_queue, phy,
+				dirty);
+
+	OCF_METADATA_UNLOCK_WR();
+
+	if (!cleaning)
+		env_atomic_set(&cache->segment_cleaner.pending, 0);
+
+	ocf_req_put(req);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_segment_cleaner = {
+	.read = ocf_segment_cleaner_run,
+	.write = ocf_segment_cleaner_run,
+};
+
+void ocf_segment_cleaner_check(ocf_cache_t cache, ocf_queue_t io_queue)
+{
+	struct ocf_request *req;
+
+	if (!env_atomic_read(&cache->segment_cleaner.needed))
+		return;
+
+	if (ocf_volume_is_atomic(&cache->device->volume))
+		return;
+
+	if (env_atomic_cmpxchg(&cache->segment_cleaner.pending, 0, 1))
+		return;
+
+	req = ocf_req_new(io_queue, NULL, 0, 0, OCF_READ);
+	if (!req) {
+		env_atomic_set(&cache->segment_cleaner.pending, 0);
+		return;
+	}
+
+	req->info.internal = true;
+	req->io_if = &_io_if_segment_cleaner;
+
+	ocf_engine_push_req_back(req, false);
+}
+
+#endif
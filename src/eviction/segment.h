@@ -0,0 +1,52 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __EVICTION_SEGMENT_H__
+#define __EVICTION_SEGMENT_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+
+/*
+ * Segment cleaner makes room for log-structured allocation segments. Once
+ * I/O queue finds no whole free segment to continue with, the cleaner picks
+ * the segment with most free cache lines among the ones it checks, drops its
+ * clean cache lines and starts cleaning of the dirty ones, which are dropped
+ * by one of the next runs. Segments less than half free are picked only once
+ * cache is short of free cache lines, so that cached data isn't dropped
+ * while free space is only fragmented. Not done for atomic cache devices,
+ * which need evicted cache lines zeroed.
+ */
+
+#if OCF_CONFIG_LOG_SEGMENT_LINES > 0
+/**
+ * @brief Note that no free log-structured allocation segment was found
+ *
+ * @param cache - OCF cache instance
+ */
+static inline void ocf_segment_cleaner_needed(ocf_cache_t cache)
+{
+	env_atomic_set(&cache->segment_cleaner.needed, 1);
+}
+
+/**
+ * @brief Schedule segment cleaner run on the given queue if free segment
+ *	was found missing and no run is scheduled or cleaning yet
+ *
+ * @param cache - OCF cache instance
+ * @param io_queue - Queue to run segment cleaner on
+ */
+void ocf_segment_cleaner_check(ocf_cache_t cache, ocf_queue_t io_queue);
+#else
+static inline void ocf_segment_cleaner_needed(ocf_cache_t cache)
+{
+}
+
+static inline void ocf_segment_cleaner_check(ocf_cache_t cache,
+		ocf_queue_t io_queue)
+{
+}
+#endif
+
+#endif
@@ -0,0 +1,483 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "eviction.h"
+#include "twoq.h"
+#include "ops.h"
+#include "../utils/utils_cleaner.h"
+#include "../utils/utils_cache_line.h"
+#include "../concurrency/ocf_concurrency.h"
+#include "../mngt/ocf_mngt_common.h"
+#include "../engine/engine_zero.h"
+#include "../utils/utils_req.h"
+
+/*
+ * 2Q eviction keeps two LRU lists in each shard. Newly inserted cache lines
+ * go to probation list and are moved to protected list when hit again.
+ * Protected list is limited to a part of the shard and its tail is demoted
+ * back to probation list. Eviction takes cache lines from probation lists
+ * first, so a one-time scan over the core only replaces cache lines that
+ * were never hit twice and leaves the working set on protected lists.
+ */
+
+/* Maximum share of shard cache lines kept on protected list (percent) */
+#define OCF_2Q_PROTECTED_PERCENT 75
+
+/* Maximum number of list entries visited per requested cache line */
+#define OCF_2Q_SCAN_PER_CLINE 1024
+
+/* Maximum number of dirty cache lines cleaned at once */
+#define OCF_2Q_CLEAN_MAX 32
+
+static inline struct twoq_eviction_policy *get_2q(ocf_cache_t cache,
+		ocf_part_id_t part_id)
+{
+	return &cache->user_parts[part_id].runtime->eviction.policy.twoq;
+}
+
+static inline struct twoq_eviction_policy_list *get_2q_list(
+		struct twoq_eviction_policy_shard *shard, uint8_t list)
+{
+	ENV_BUG_ON(list == TWOQ_LIST_NONE || list > TWOQ_LISTS);
+
+	return &shard->list[list - 1];
+}
+
+/* Adds the given cache line to the _head_ of the given list */
+static void add_2q_head(ocf_cache_t cache,
+		struct twoq_eviction_policy_shard *shard,
+		ocf_cache_line_t cline, uint8_t list_id)
+{
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
+	struct twoq_eviction_policy_list *list = get_2q_list(shard, list_id);
+	union eviction_policy_meta eviction, eviction_head;
+
+	ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+
+	ENV_BUG_ON(eviction.twoq.list != TWOQ_LIST_NONE);
+
+	eviction.twoq.prev = collision_table_entries;
+	eviction.twoq.next = list->head;
+	eviction.twoq.list = list_id;
+
+	if (list->head != collision_table_entries) {
+		ocf_metadata_get_evicition_policy(cache, list->head,
+				&eviction_head);
+		eviction_head.twoq.prev = cline;
+		ocf_metadata_set_evicition_policy(cache, list->head,
+				&eviction_head);
+	} else {
+		list->tail = cline;
+	}
+
+	list->head = cline;
+	list->count++;
+
+	ocf_metadata_set_evicition_policy(cache, cline, &eviction);
+}
+
+/* Deletes the given cache line from the list it is on */
+static void remove_2q_list(ocf_cache_t cache,
+		struct twoq_eviction_policy_shard *shard,
+		ocf_cache_line_t cline)
+{
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
+	struct twoq_eviction_policy_list *list;
+	union eviction_policy_meta eviction, eviction_near;
+
+	ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+
+	if (eviction.twoq.list == TWOQ_LIST_NONE)
+		return;
+
+	list = get_2q_list(shard, eviction.twoq.list);
+
+	if (eviction.twoq.prev != collision_table_entries) {
+		ocf_metadata_get_evicition_policy(cache, eviction.twoq.prev,
+				&eviction_near);
+		eviction_near.twoq.next = eviction.twoq.next;
+		ocf_metadata_set_evicition_policy(cache, eviction.twoq.prev,
+				&eviction_near);
+	} else {
+		list->head = eviction.twoq.next;
+	}
+
+	if (eviction.twoq.next != collision_table_entries) {
+		ocf_metadata_get_evicition_policy(cache, eviction.twoq.next,
+				&eviction_near);
+		eviction_near.twoq.prev = eviction.twoq.prev;
+		ocf_metadata_set_evicition_policy(cache, eviction.twoq.next,
+				&eviction_near);
+	} else {
+		list->tail = eviction.twoq.prev;
+	}
+
+	ENV_BUG_ON(list->count == 0);
+	list->count--;
+
+	eviction.twoq.prev = collision_table_entries;
+	eviction.twoq.next = collision_table_entries;
+	eviction.twoq.list = TWOQ_LIST_NONE;
+
+	ocf_metadata_set_evicition_policy(cache, cline, &eviction);
+}
+
+/* Demotes protected tail if protected list exceeds its share of shard */
+static void balance_2q_shard(ocf_cache_t cache,
+		struct twoq_eviction_policy_shard *shard)
+{
+	struct twoq_eviction_policy_list *probation =
+			get_2q_list(shard, TWOQ_LIST_PROBATION);
+	struct twoq_eviction_policy_list *protected =
+			get_2q_list(shard, TWOQ_LIST_PROTECTED);
+	ocf_cache_line_t cline = protected->tail;
+	uint64_t total = probation->count + protected->count;
+
+	if (protected->count * 100ULL <= total * OCF_2Q_PROTECTED_PERCENT)
+		return;
+
+	remove_2q_list(cache, shard, cline);
+	add_2q_head(cache, shard, cline, TWOQ_LIST_PROBATION);
+}
+
+void evp_2q_init_cline(ocf_cache_t cache, ocf_cache_line_t cline)
+{
+	union eviction_policy_meta eviction;
+
+	ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+
+	eviction.twoq.prev = cache->device->collision_table_entries;
+	eviction.twoq.next = cache->device->collision_table_entries;
+	eviction.twoq.list = TWOQ_LIST_NONE;
+
+	ocf_metadata_set_evicition_policy(cache, cline, &eviction);
+}
+
+/* the caller must hold the metadata lock */
+void evp_2q_rm_cline(ocf_cache_t cache, ocf_cache_line_t cline)
+{
+	ocf_part_id_t part_id = ocf_metadata_get_partition_id(cache, cline);
+	struct twoq_eviction_policy *twoq = get_2q(cache, part_id);
+
+	remove_2q_list(cache, &twoq->shard[ocf_eviction_shard_id(cline)],
+			cline);
+}
+
+/* the caller must hold the metadata lock */
+void evp_2q_hot_cline(ocf_cache_t cache, ocf_cache_line_t cline)
+{
+	ocf_part_id_t part_id = ocf_metadata_get_partition_id(cache, cline);
+	struct twoq_eviction_policy *twoq = get_2q(cache, part_id);
+	struct twoq_eviction_policy_shard *shard =
+			&twoq->shard[ocf_eviction_shard_id(cline)];
+	union eviction_policy_meta eviction;
+
+	ocf_metadata_get_evicition_policy(cache, cline, &eviction);
+
+	switch (eviction.twoq.list) {
+	case TWOQ_LIST_NONE:
+		add_2q_head(cache, shard, cline, TWOQ_LIST_PROBATION);
+		break;
+
+	case TWOQ_LIST_PROBATION:
+		remove_2q_list(cache, shard, cline);
+		add_2q_head(cache, shard, cline, TWOQ_LIST_PROTECTED);
+		balance_2q_shard(cache, shard);
+		break;
+
+	case TWOQ_LIST_PROTECTED:
+		if (get_2q_list(shard, TWOQ_LIST_PROTECTED)->head == cline)
+			break;
+
+		remove_2q_list(cache, shard, cline);
+		add_2q_head(cache, shard, cline, TWOQ_LIST_PROTECTED);
+		break;
+
+	default:
+		ENV_BUG();
+	}
+}
+
+void evp_2q_init_evp(ocf_cache_t cache, ocf_part_id_t part_id)
+{
+	unsigned int collision_table_entries =
+			cache->device->collision_table_entries;
+	struct twoq_eviction_policy *twoq = get_2q(cache, part_id);
+	int i, j;
+
+	for (i = 0; i < OCF_EVICTION_SHARDS; i++) {
+		for (j = 0; j < TWOQ_LISTS; j++) {
+			twoq->shard[i].list[j].head = collision_table_entries;
+			twoq->shard[i].list[j].tail = collision_table_entries;
+			twoq->shard[i].list[j].count = 0;
+		}
+	}
+
+	twoq->evict_shard = 0;
+}
+
+/*
+ * Protected lists are walked before probation ones, lists of all shards in
+ * lockstep from head
+ */
+void evp_2q_walk_hot(ocf_cache_t cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv)
+{
+	ocf_cache_line_t end = cache->device->collision_table_entries;
+	struct twoq_eviction_policy *twoq = get_2q(cache, part_id);
+	ocf_cache_line_t cursor[OCF_EVICTION_SHARDS];
+	union eviction_policy_meta eviction;
+	uint8_t list_ids[] = { TWOQ_LIST_PROTECTED, TWOQ_LIST_PROBATION };
+	bool more;
+	int i, l;
+
+	for (l = 0; l < ARRAY_SIZE(list_ids); l++) {
+		for (i = 0; i < OCF_EVICTION_SHARDS; i++) {
+			cursor[i] = get_2q_list(&twoq->shard[i],
+					list_ids[l])->head;
+		}
+
+		do {
+			more = false;
+
+			for (i = 0; i < OCF_EVICTION_SHARDS; i++) {
+				if (cursor[i] == end)
+					continue;
+
+				if (!visit(cache, cursor[i], priv))
+					return;
+
+				ocf_metadata_get_evicition_policy(cache,
+						cursor[i], &eviction);
+				cursor[i] = eviction.twoq.next;
+				more = true;
+			}
+		} while (more);
+	}
+}
+
+bool evp_2q_can_evict(ocf_cache_t cache)
+{
+	if (env_atomic_read(&cache->pending_eviction_clines) >=
+			OCF_PENDING_EVICTION_LIMIT) {
+		return false;
+	}
+
+	return true;
+}
+
+static void evp_2q_clean_end(void *private_data, int error)
+{
+	env_atomic *cleaning_in_progress = private_data;
+
+	env_atomic_set(cleaning_in_progress, 0);
+}
+
+static int evp_2q_clean_getter(ocf_cache_t cache,
+		void *getter_context, uint32_t item, ocf_cache_line_t *line)
+{
+	union eviction_policy_meta eviction;
+	struct ocf_cleaner_attribs *attribs = getter_context;
+	ocf_cache_line_t prev_cline, curr_cline = attribs->getter_item;
+
+	while (curr_cline < cache->device->collision_table_entries) {
+		ocf_metadata_get_evicition_policy(cache, curr_cline,
+				&eviction);
+		prev_cline = eviction.twoq.prev;
+
+		/* Lists keep both clean and dirty lines, skip locked items */
+		if (!metadata_test_dirty(cache, curr_cline) ||
+				ocf_cache_line_is_used(cache, curr_cline)) {
+			curr_cline = prev_cline;
+			continue;
+		}
+
+		*line = curr_cline;
+		attribs->getter_item = prev_cline;
+		return 0;
+	}
+
+	return -1;
+}
+
+static void evp_2q_clean(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, ocf_cache_line_t start, uint32_t count)
+{
+	env_atomic *progress = &cache->cleaning[part_id];
+
+	if (ocf_mngt_is_cache_locked(cache))
+		return;
+
+	if (env_atomic_cmpxchg(progress, 0, 1) == 0) {
+		/* Initialize attributes for cleaner */
+		struct ocf_cleaner_attribs attribs = {
+			.cache_line_lock = true,
+			.do_sort = true,
+
+			.cmpl_context = progress,
+			.cmpl_fn = evp_2q_clean_end,
+
+			.getter = evp_2q_clean_getter,
+			.getter_context = &attribs,
+			.getter_item = start,
+
+			.count = OCF_MIN(count, OCF_2Q_CLEAN_MAX),
+
+			.io_queue = io_queue
+		};
+
+		ocf_cleaner_fire(cache, &attribs);
+	}
+}
+
+static void evp_2q_zero_line_complete(struct ocf_request *ocf_req, int error)
+{
+	env_atomic_dec(&ocf_req->cache->pending_eviction_clines);
+}
+
+static void evp_2q_zero_line(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_cache_line_t line)
+{
+	struct ocf_request *req;
+	ocf_core_id_t id;
+	uint64_t addr, core_line;
+
+	ocf_metadata_get_core_info(cache, line, &id, &core_line);
+	addr = core_line * ocf_line_size(cache);
+
+	req = ocf_req_new(io_queue, &cache->core[id], addr,
+			ocf_line_size(cache), OCF_WRITE);
+	if (req) {
+		req->info.internal = true;
+		req->complete = evp_2q_zero_line_complete;
+
+		env_atomic_inc(&cache->pending_eviction_clines);
+
+		ocf_engine_zero_line(req);
+	}
+}
+
+/*
+ * Evict clean cache lines from tails of given list of all shards, taking
+ * one cache line from each shard in round-robin manner
+ */
+static uint32_t evp_2q_evict_list(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, struct twoq_eviction_policy *twoq,
+		uint8_t list_id, uint32_t cline_no, uint64_t *scan_budget,
+		ocf_cache_line_t *dirty)
+{
+	uint32_t collision_table_entries =
+			cache->device->collision_table_entries;
+	ocf_cache_line_t curr[OCF_EVICTION_SHARDS];
+	ocf_cache_line_t curr_cline, prev_cline;
+	union eviction_policy_meta eviction;
+	uint32_t i = 0, shard, empty = 0;
+
+	for (shard = 0; shard < OCF_EVICTION_SHARDS; shard++)
+		curr[shard] = get_2q_list(&twoq->shard[shard], list_id)->tail;
+
+	shard = twoq->evict_shard % OCF_EVICTION_SHARDS;
+
+	while (i < cline_no && empty < OCF_EVICTION_SHARDS && *scan_budget) {
+		if (!evp_2q_can_evict(cache))
+			break;
+
+		curr_cline = curr[shard];
+
+		while (curr_cline != collision_table_entries && *scan_budget) {
+			ENV_BUG_ON(curr_cline > collision_table_entries);
+			(*scan_budget)--;
+
+			/* Prevent evicting already locked items */
+			if (ocf_cache_line_is_used(cache, curr_cline)) {
+				ocf_eviction_stats_add(cache, part_id,
+						locked_clines, 1);
+				goto next;
+			}
+
+			if (!metadata_test_dirty(cache, curr_cline))
+				break;
+
+			/* Remember first dirty line to start cleaning from */
+			if (*dirty == collision_table_entries)
+				*dirty = curr_cline;
+next:
+			ocf_metadata_get_evicition_policy(cache, curr_cline,
+					&eviction);
+			curr_cline = eviction.twoq.prev;
+		}
+
+		if (curr_cline == collision_table_entries || !*scan_budget) {
+			curr[shard] = collision_table_entries;
+			empty++;
+			shard = (shard + 1) % OCF_EVICTION_SHARDS;
+			continue;
+		}
+
+		empty = 0;
+
+		ocf_metadata_get_evicition_policy(cache, curr_cline, &eviction);
+		prev_cline = eviction.twoq.prev;
+
+		ocf_eviction_ghost_add_line(cache, curr_cline);
+
+		if (ocf_volume_is_atomic(&cache->device->volume)) {
+			/* atomic cache, we have to trim cache lines before
+			 * eviction
+			 */
+			evp_2q_zero_line(cache, io_queue, curr_cline);
+
+		} else {
+			set_cache_line_invalid_no_flush(cache, 0,
+					ocf_line_end_sector(cache),
+					curr_cline);
+
+			/* Goto next item. */
+			i++;
+		}
+
+		curr[shard] = prev_cline;
+		shard = (shard + 1) % OCF_EVICTION_SHARDS;
+	}
+
+	twoq->evict_shard = shard;
+
+	return i;
+}
+
+/* the caller must hold the metadata lock */
+uint32_t evp_2q_req_clines(ocf_cache_t cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no, ocf_core_id_t core_id)
+{
+	struct twoq_eviction_policy *twoq = get_2q(cache, part_id);
+	ocf_cache_line_t dirty = cache->device->collision_table_entries;
+	uint64_t scan_budget = (uint64_t)cline_no * OCF_2Q_SCAN_PER_CLINE;
+	uint32_t i;
+
+	if (cline_no == 0)
+		return 0;
+
+	/* Probation lines go first, protected ones only if there is no
+	 * other choice
+	 */
+	i = evp_2q_evict_list(cache, io_queue, part_id, twoq,
+			TWOQ_LIST_PROBATION, cline_no, &scan_budget, &dirty);
+	if (i < cline_no) {
+		i += evp_2q_evict_list(cache, io_queue, part_id, twoq,
+				TWOQ_LIST_PROTECTED, cline_no - i,
+				&scan_budget, &dirty);
+	}
+
+	if (i < cline_no && dirty != cache->device->collision_table_entries) {
+		ocf_eviction_stats_add(cache, part_id, dirty_fallbacks, 1);
+		ocf_cleaner_emergency(cache);
+		evp_2q_clean(cache, io_queue, part_id, dirty, cline_no - i);
+	}
+
+	/* Return number of clines that were really evicted */
+	return i;
+}
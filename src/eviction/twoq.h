@@ -0,0 +1,23 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __EVICTION_TWOQ_H__
+#define __EVICTION_TWOQ_H__
+
+#include "eviction.h"
+#include "twoq_structs.h"
+
+void evp_2q_init_cline(struct ocf_cache *cache,
+		ocf_cache_line_t cline);
+void evp_2q_rm_cline(struct ocf_cache *cache, ocf_cache_line_t cline);
+bool evp_2q_can_evict(struct ocf_cache *cache);
+uint32_t evp_2q_req_clines(struct ocf_cache *cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no,
+		ocf_core_id_t core_id);
+void evp_2q_hot_cline(struct ocf_cache *cache, ocf_cache_line_t cline);
+void evp_2q_init_evp(struct ocf_cache *cache, ocf_part_id_t part_id);
+void evp_2q_walk_hot(struct ocf_cache *cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __EVICTION_TWOQ_STRUCTS_H__
+
+#define __EVICTION_TWOQ_STRUCTS_H__
+
+#include "lru_structs.h"
+
+/* Cache line is not on any list */
+#define TWOQ_LIST_NONE		0
+/* Cache lines hit once since they were inserted */
+#define TWOQ_LIST_PROBATION	1
+/* Cache lines hit again while on probation list */
+#define TWOQ_LIST_PROTECTED	2
+
+#define TWOQ_LISTS		2
+
+struct twoq_eviction_policy_meta {
+	/* List pointers 2*4=8 bytes */
+	uint32_t prev;
+	uint32_t next;
+	/* List cache line is on */
+	uint8_t list;
+} __attribute__((packed));
+
+struct twoq_eviction_policy_list {
+	uint32_t head;
+	uint32_t tail;
+	uint32_t count;
+};
+
+struct twoq_eviction_policy_shard {
+	struct twoq_eviction_policy_list list[TWOQ_LISTS];
+};
+
+struct twoq_eviction_policy {
+	struct twoq_eviction_policy_shard shard[OCF_EVICTION_SHARDS];
+	/* Shard next eviction round-robin starts from */
+	uint32_t evict_shard;
+};
+
+#endif
@@ -53,16 +53,11 @@ int ocf_metadata_init_variable_size(struct ocf_cache *cache, uint64_t device_siz
 			cache_line_size, layout);
 }
 
-void ocf_metadata_init_freelist_partition(struct ocf_cache *cache)
-{
-	OCF_DEBUG_TRACE(cache);
-	cache->metadata.iface.layout_iface->init_freelist(cache);
-}
-
-void ocf_metadata_init_hash_table(struct ocf_cache *cache)
+void ocf_metadata_init_collision(struct ocf_cache *cache,
+		ocf_metadata_end_t cmpl, void *priv)
 {
 	OCF_DEBUG_TRACE(cache);
-	cache->metadata.iface.init_hash_table(cache);
+	cache->metadata.iface.init_collision(cache, cmpl, priv);
 }
 
 void ocf_metadata_deinit(struct ocf_cache *cache)
@@ -89,6 +84,20 @@ size_t ocf_metadata_size_of(struct ocf_cache *cache)
 	return cache->metadata.iface.size_of(cache);
 }
 
+void ocf_metadata_mem_usage(struct ocf_cache *cache,
+		struct ocf_cache_memory_usage *usage)
+{
+	cache->metadata.iface.mem_usage(cache, usage);
+}
+
+int ocf_metadata_size_estimate(struct ocf_cache *cache, uint64_t device_size,
+		ocf_cache_line_size_t line_size, bool atomic,
+		struct ocf_mngt_cache_ram_needed *ram)
+{
+	return cache->metadata.iface.size_estimate(cache, device_size,
+			line_size, atomic, ram);
+}
+
 void ocf_metadata_error(struct ocf_cache *cache)
 {
 	if (cache->device->metadata_error == 0)
@@ -116,6 +125,12 @@ void ocf_metadata_flush_all(ocf_cache_t cache,
 	OCF_METADATA_UNLOCK_WR();
 }
 
+void ocf_metadata_checkpoint(ocf_cache_t cache,
+		ocf_metadata_end_t cmpl, void *priv)
+{
+	cache->metadata.iface.checkpoint(cache, cmpl, priv);
+}
+
 void ocf_metadata_load_all(ocf_cache_t cache,
 		ocf_metadata_end_t cmpl, void *priv)
 {
@@ -279,6 +294,25 @@ static void ocf_metadata_load_properties_cmpl(
 		return;
 	}
 
+	if (!superblock->hash_load_factor ||
+			superblock->hash_load_factor > OCF_HASH_LOAD_FACTOR_MAX) {
+		ocf_log(ctx, log_err, "ERROR: Invalid hash load factor!\n");
+		cmpl(priv, -EINVAL, NULL);
+		return;
+	}
+
+	if ((unsigned)superblock->eviction_policy_type >= ocf_eviction_max) {
+		ocf_log(ctx, log_err, "ERROR: Invalid eviction policy!\n");
+		cmpl(priv, -EINVAL, NULL);
+		return;
+	}
+
+	if (superblock->max_size < OCF_CACHE_SIZE_MIN) {
+		ocf_log(ctx, log_err, "ERROR: Invalid cache device size!\n");
+		cmpl(priv, -EINVAL, NULL);
+		return;
+	}
+
 	if (superblock->clean_shutdown > ocf_metadata_clean_shutdown) {
 		ocf_log(ctx, log_err, "ERROR: Invalid shutdown status!\n");
 		cmpl(priv, -EINVAL, NULL);
@@ -294,6 +328,9 @@ static void ocf_metadata_load_properties_cmpl(
 	properties.line_size = superblock->line_size;
 	properties.layout = superblock->metadata_layout;
 	properties.cache_mode = superblock->cache_mode;
+	properties.hash_load_factor = superblock->hash_load_factor;
+	properties.eviction_policy = superblock->eviction_policy_type;
+	properties.max_size = superblock->max_size;
 	properties.shutdown_status = superblock->clean_shutdown;
 	properties.dirty_flushed = superblock->dirty_flushed;
 
@@ -10,53 +10,62 @@
 #include "../ocf_cache_priv.h"
 #include "../ocf_ctx_priv.h"
 
-static inline void ocf_metadata_eviction_lock(struct ocf_cache *cache)
+static inline void ocf_metadata_eviction_lock(struct ocf_cache *cache,
+		ocf_cache_line_t line)
 {
-	env_spinlock_lock(&cache->metadata.lock.eviction);
+	env_spinlock_lock(&cache->metadata.lock.eviction[
+			ocf_eviction_shard_id(line)].lock);
 }
 
-static inline void ocf_metadata_eviction_unlock(struct ocf_cache *cache)
+static inline void ocf_metadata_eviction_unlock(struct ocf_cache *cache,
+		ocf_cache_line_t line)
 {
-	env_spinlock_unlock(&cache->metadata.lock.eviction);
+	env_spinlock_unlock(&cache->metadata.lock.eviction[
+			ocf_eviction_shard_id(line)].lock);
 }
 
-#define OCF_METADATA_EVICTION_LOCK() \
-		ocf_metadata_eviction_lock(cache)
+static inline void ocf_metadata_eviction_lock_all(struct ocf_cache *cache)
+{
+	int i;
 
-#define OCF_METADATA_EVICTION_UNLOCK() \
-		ocf_metadata_eviction_unlock(cache)
+	for (i = 0; i < OCF_EVICTION_SHARDS; i++)
+		env_spinlock_lock(&cache->metadata.lock.eviction[i].lock);
+}
 
-static inline void ocf_metadata_lock(struct ocf_cache *cache, int rw)
+static inline void ocf_metadata_eviction_unlock_all(struct ocf_cache *cache)
 {
-	if (rw == OCF_METADATA_WR)
-		env_rwsem_down_write(&cache->metadata.lock.collision);
-	else if (rw == OCF_METADATA_RD)
-		env_rwsem_down_read(&cache->metadata.lock.collision);
-	else
-		ENV_BUG();
+	int i;
+
+	for (i = OCF_EVICTION_SHARDS - 1; i >= 0; i--)
+		env_spinlock_unlock(&cache->metadata.lock.eviction[i].lock);
 }
 
+static inline void ocf_metadata_freelist_lock(struct ocf_cache *cache)
+{
+	env_spinlock_lock(&cache->metadata.lock.freelist);
+}
 
-static inline void ocf_metadata_unlock(struct ocf_cache *cache, int rw)
+static inline void ocf_metadata_freelist_unlock(struct ocf_cache *cache)
 {
-	if (rw == OCF_METADATA_WR)
-		env_rwsem_up_write(&cache->metadata.lock.collision);
-	else if (rw == OCF_METADATA_RD)
-		env_rwsem_up_read(&cache->metadata.lock.collision);
-	else
-		ENV_BUG();
+	env_spinlock_unlock(&cache->metadata.lock.freelist);
 }
 
+#define OCF_METADATA_EVICTION_LOCK(line) \
+		ocf_metadata_eviction_lock(cache, line)
+
+#define OCF_METADATA_EVICTION_UNLOCK(line) \
+		ocf_metadata_eviction_unlock(cache, line)
+
 static inline int ocf_metadata_try_lock(struct ocf_cache *cache, int rw)
 {
 	int result = 0;
 
 	if (rw == OCF_METADATA_WR) {
 		result = env_rwsem_down_write_trylock(
-				&cache->metadata.lock.collision);
+				&cache->metadata.lock.global);
 	} else if (rw == OCF_METADATA_RD) {
 		result = env_rwsem_down_read_trylock(
-				&cache->metadata.lock.collision);
+				&cache->metadata.lock.global);
 	} else {
 		ENV_BUG();
 	}
@@ -67,24 +76,87 @@ static inline int ocf_metadata_try_lock(struct ocf_cache *cache, int rw)
 	return 0;
 }
 
+static inline void ocf_metadata_lock(struct ocf_cache *cache, int rw)
+{
+#if OCF_CONFIG_STATS_LOCK
+	uint64_t start;
+
+	if (!ocf_metadata_try_lock(cache, rw))
+		return;
+
+	start = env_get_tick_count();
+#endif
+
+	if (rw == OCF_METADATA_WR)
+		env_rwsem_down_write(&cache->metadata.lock.global);
+	else if (rw == OCF_METADATA_RD)
+		env_rwsem_down_read(&cache->metadata.lock.global);
+	else
+		ENV_BUG();
+
+#if OCF_CONFIG_STATS_LOCK
+	ocf_stats_lock_contended(&cache->lock_counters[rw == OCF_METADATA_WR ?
+			ocf_stats_lock_metadata_wr :
+			ocf_stats_lock_metadata_rd], start);
+#endif
+}
+
+
+static inline void ocf_metadata_unlock(struct ocf_cache *cache, int rw)
+{
+	if (rw == OCF_METADATA_WR)
+		env_rwsem_up_write(&cache->metadata.lock.global);
+	else if (rw == OCF_METADATA_RD)
+		env_rwsem_up_read(&cache->metadata.lock.global);
+	else
+		ENV_BUG();
+}
+
+static inline env_rwlock *ocf_metadata_status_bits_lock_get(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	return &cache->metadata.lock.status[line %
+			OCF_CONFIG_METADATA_STATUS_LOCKS].lock;
+}
+
 static inline void ocf_metadata_status_bits_lock(
-		struct ocf_cache *cache, int rw)
+		struct ocf_cache *cache, ocf_cache_line_t line, int rw)
 {
+	env_rwlock *lock = ocf_metadata_status_bits_lock_get(cache, line);
+#if OCF_CONFIG_STATS_LOCK
+	uint64_t start;
+
+	if (rw == OCF_METADATA_WR && !env_rwlock_write_trylock(lock))
+		return;
+	if (rw == OCF_METADATA_RD && !env_rwlock_read_trylock(lock))
+		return;
+
+	start = env_get_tick_count();
+#endif
+
 	if (rw == OCF_METADATA_WR)
-		env_rwlock_write_lock(&cache->metadata.lock.status);
+		env_rwlock_write_lock(lock);
 	else if (rw == OCF_METADATA_RD)
-		env_rwlock_read_lock(&cache->metadata.lock.status);
+		env_rwlock_read_lock(lock);
 	else
 		ENV_BUG();
+
+#if OCF_CONFIG_STATS_LOCK
+	ocf_stats_lock_contended(&cache->lock_counters[rw == OCF_METADATA_WR ?
+			ocf_stats_lock_status_bits_wr :
+			ocf_stats_lock_status_bits_rd], start);
+#endif
 }
 
 static inline void ocf_metadata_status_bits_unlock(
-		struct ocf_cache *cache, int rw)
+		struct ocf_cache *cache, ocf_cache_line_t line, int rw)
 {
+	env_rwlock *lock = ocf_metadata_status_bits_lock_get(cache, line);
+
 	if (rw == OCF_METADATA_WR)
-		env_rwlock_write_unlock(&cache->metadata.lock.status);
+		env_rwlock_write_unlock(lock);
 	else if (rw == OCF_METADATA_RD)
-		env_rwlock_read_unlock(&cache->metadata.lock.status);
+		env_rwlock_read_unlock(lock);
 	else
 		ENV_BUG();
 }
@@ -107,17 +179,17 @@ static inline void ocf_metadata_status_bits_unlock(
 #define OCF_METADATA_UNLOCK_WR() \
 		ocf_metadata_unlock(cache, OCF_METADATA_WR)
 
-#define OCF_METADATA_BITS_LOCK_RD() \
-		ocf_metadata_status_bits_lock(cache, OCF_METADATA_RD)
+#define OCF_METADATA_BITS_LOCK_RD(line) \
+		ocf_metadata_status_bits_lock(cache, line, OCF_METADATA_RD)
 
-#define OCF_METADATA_BITS_UNLOCK_RD() \
-		ocf_metadata_status_bits_unlock(cache, OCF_METADATA_RD)
+#define OCF_METADATA_BITS_UNLOCK_RD(line) \
+		ocf_metadata_status_bits_unlock(cache, line, OCF_METADATA_RD)
 
-#define OCF_METADATA_BITS_LOCK_WR() \
-		ocf_metadata_status_bits_lock(cache, OCF_METADATA_WR)
+#define OCF_METADATA_BITS_LOCK_WR(line) \
+		ocf_metadata_status_bits_lock(cache, line, OCF_METADATA_WR)
 
-#define OCF_METADATA_BITS_UNLOCK_WR() \
-		ocf_metadata_status_bits_unlock(cache, OCF_METADATA_WR)
+#define OCF_METADATA_BITS_UNLOCK_WR(line) \
+		ocf_metadata_status_bits_unlock(cache, line, OCF_METADATA_WR)
 
 #define OCF_METADATA_FLUSH_LOCK() \
 		ocf_metadata_flush_lock(cache)
@@ -134,6 +206,7 @@ static inline void ocf_metadata_status_bits_unlock(
 #include "metadata_collision.h"
 #include "metadata_core.h"
 #include "metadata_misc.h"
+#include "metadata_hash_inline.h"
 
 #define INVALID 0
 #define VALID 1
@@ -163,18 +236,14 @@ int ocf_metadata_init_variable_size(struct ocf_cache *cache,
 		ocf_metadata_layout_t layout);
 
 /**
- * @brief Initialize collision table
- *
- * @param cache - Cache instance
- */
-void ocf_metadata_init_freelist_partition(struct ocf_cache *cache);
-
-/**
- * @brief Initialize hash table
+ * @brief Initialize hash table, collision table and free list partition
  *
  * @param cache - Cache instance
+ * @param cmpl - Completion callback
+ * @param priv - Completion context
  */
-void ocf_metadata_init_hash_table(struct ocf_cache *cache);
+void ocf_metadata_init_collision(struct ocf_cache *cache,
+		ocf_metadata_end_t cmpl, void *priv);
 
 /**
  * @brief De-Initialize metadata
@@ -198,6 +267,31 @@ void ocf_metadata_deinit_variable_size(struct ocf_cache *cache);
  */
 size_t ocf_metadata_size_of(struct ocf_cache *cache);
 
+/**
+ * @brief Get memory footprint of each metadata segment and of volatile
+ *	metadata outside of segments
+ *
+ * @param cache - Cache instance
+ * @param usage - Memory usage to be filled in
+ */
+void ocf_metadata_mem_usage(struct ocf_cache *cache,
+		struct ocf_cache_memory_usage *usage);
+
+/**
+ * @brief Estimate memory footprint of per cache line metadata for given
+ *	caching device, without allocating it
+ *
+ * @param cache - Cache instance
+ * @param device_size - Size of caching device in bytes
+ * @param line_size - Cache line size
+ * @param atomic - Caching device is atomic volume
+ * @param ram - Per segment memory footprint
+ * @return 0 - Operation success, otherwise error
+ */
+int ocf_metadata_size_estimate(struct ocf_cache *cache, uint64_t device_size,
+		ocf_cache_line_size_t line_size, bool atomic,
+		struct ocf_mngt_cache_ram_needed *ram);
+
 /**
  * @brief Handle metadata error
  *
@@ -232,6 +326,17 @@ ocf_cache_line_t ocf_metadata_get_pages_count(struct ocf_cache *cache);
 void ocf_metadata_flush_all(ocf_cache_t cache,
 		ocf_metadata_end_t cmpl, void *priv);
 
+/**
+ * @brief Write modified pages of per cache line metadata while cache is
+ *	running, without marking shutdown clean
+ *
+ * @param cache - Cache instance
+ * @param cmpl - Completion callback
+ * @param priv - Completion context
+ */
+void ocf_metadata_checkpoint(ocf_cache_t cache,
+		ocf_metadata_end_t cmpl, void *priv);
+
 /**
  * @brief Mark specified cache line to be flushed
  *
@@ -291,11 +396,19 @@ static inline uint64_t ocf_metadata_get_reserved_lba(ocf_cache_t cache)
  * temporary defined in this file.
  */
 
+#if !OCF_CONFIG_METADATA_INLINE
 static inline ocf_cache_line_t
 ocf_metadata_get_hash(struct ocf_cache *cache, ocf_cache_line_t index)
 {
 	return cache->metadata.iface.get_hash(cache, index);
 }
+#endif
+
+static inline void ocf_metadata_prefetch_hash(struct ocf_cache *cache,
+		ocf_cache_line_t index)
+{
+	cache->metadata.iface.prefetch_hash(cache, index);
+}
 
 static inline void ocf_metadata_set_hash(struct ocf_cache *cache,
 		ocf_cache_line_t index, ocf_cache_line_t line)
@@ -315,6 +428,9 @@ struct ocf_metadata_load_properties {
 	ocf_metadata_layout_t layout;
 	ocf_cache_line_size_t line_size;
 	ocf_cache_mode_t cache_mode;
+	uint32_t hash_load_factor;
+	ocf_eviction_t eviction_policy;
+	uint64_t max_size;
 };
 
 typedef void (*ocf_metadata_load_properties_end_t)(void *priv, int error,
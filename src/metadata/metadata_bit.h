@@ -44,6 +44,25 @@ static inline u128 _get_mask_u128(uint8_t start, uint8_t stop)
 	return mask;
 }
 
+/*******************************************************************************
+ * First set bit getter, bits must not be zero
+ ******************************************************************************/
+
+#define _get_first_u8(bits) __builtin_ctzll(bits)
+#define _get_first_u16(bits) __builtin_ctzll(bits)
+#define _get_first_u32(bits) __builtin_ctzll(bits)
+#define _get_first_u64(bits) __builtin_ctzll(bits)
+
+static inline uint8_t _get_first_u128(u128 bits)
+{
+	uint64_t low = bits;
+
+	if (low)
+		return __builtin_ctzll(low);
+
+	return 64 + __builtin_ctzll((uint64_t)(bits >> 64));
+}
+
 #define ocf_metadata_bit_struct(type) \
 struct ocf_metadata_map_##type { \
 	struct ocf_metadata_map map; \
@@ -118,6 +137,7 @@ static bool _ocf_metadata_clear_##what##_##type(struct ocf_cache *cache, \
 	struct ocf_metadata_map_##type *map = raw->mem_pool; \
 \
 	_raw_bug_on(raw, line, sizeof(*map)); \
+	ocf_metadata_raw_mark_modified(raw, line); \
 \
 	map[line].what &= ~mask; \
 \
@@ -143,6 +163,7 @@ static bool _ocf_metadata_set_##what##_##type(struct ocf_cache *cache, \
 	struct ocf_metadata_map_##type *map = raw->mem_pool; \
 \
 	_raw_bug_on(raw, line, sizeof(*map)); \
+	ocf_metadata_raw_mark_modified(raw, line); \
 \
 	result = map[line].what ? true : false; \
 \
@@ -182,6 +203,7 @@ static bool _ocf_metadata_test_and_set_##what##_##type( \
 		} \
 	} \
 \
+	ocf_metadata_raw_mark_modified(raw, line); \
 	map[line].what |= mask; \
 	return test; \
 } \
@@ -217,10 +239,65 @@ static bool _ocf_metadata_test_and_clear_##what##_##type( \
 		} \
 	} \
 \
+	ocf_metadata_raw_mark_modified(raw, line); \
 	map[line].what &= ~mask; \
 	return test; \
 } \
 
+/*
+ * Find first sector at or after start which bit is equal to value. Whole
+ * status word is tested at once. Returns number of sectors if there is none.
+ */
+#define ocf_metadata_bit_find_func(what, type) \
+static uint8_t _ocf_metadata_find_##what##_##type(struct ocf_cache *cache, \
+		ocf_cache_line_t line, uint8_t start, bool value) \
+{ \
+	const uint8_t sectors = sizeof(type) * 8; \
+	type bits; \
+\
+	struct ocf_metadata_hash_ctrl *ctrl = \
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv; \
+\
+	struct ocf_metadata_raw *raw = \
+			&ctrl->raw_desc[metadata_segment_collision]; \
+\
+	const struct ocf_metadata_map_##type *map = raw->mem_pool; \
+\
+	_raw_bug_on(raw, line, sizeof(*map)); \
+\
+	if (start >= sectors) \
+		return sectors; \
+\
+	bits = value ? map[line].what : ~map[line].what; \
+	bits &= _get_mask_##type(start, sectors - 1); \
+\
+	return bits ? _get_first_##type(bits) : sectors; \
+} \
+
+/*
+ * Invalidate sectors which are not dirty. Returns true if any sector is
+ * still valid.
+ */
+#define ocf_metadata_bit_invalidate_clean_func(type) \
+static bool _ocf_metadata_invalidate_clean_##type(struct ocf_cache *cache, \
+		ocf_cache_line_t line) \
+{ \
+	struct ocf_metadata_hash_ctrl *ctrl = \
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv; \
+\
+	struct ocf_metadata_raw *raw = \
+			&ctrl->raw_desc[metadata_segment_collision]; \
+\
+	struct ocf_metadata_map_##type *map = raw->mem_pool; \
+\
+	_raw_bug_on(raw, line, sizeof(*map)); \
+	ocf_metadata_raw_mark_modified(raw, line); \
+\
+	map[line].valid &= map[line].dirty; \
+\
+	return map[line].valid ? true : false; \
+} \
+
 ocf_metadata_bit_struct(u8);
 ocf_metadata_bit_struct(u16);
 ocf_metadata_bit_struct(u32);
@@ -238,3 +315,15 @@ ocf_metadata_bit_func(valid, u16);
 ocf_metadata_bit_func(valid, u32);
 ocf_metadata_bit_func(valid, u64);
 ocf_metadata_bit_func(valid, u128);
+
+ocf_metadata_bit_find_func(dirty, u8);
+ocf_metadata_bit_find_func(dirty, u16);
+ocf_metadata_bit_find_func(dirty, u32);
+ocf_metadata_bit_find_func(dirty, u64);
+ocf_metadata_bit_find_func(dirty, u128);
+
+ocf_metadata_bit_invalidate_clean_func(u8);
+ocf_metadata_bit_invalidate_clean_func(u16);
+ocf_metadata_bit_invalidate_clean_func(u32);
+ocf_metadata_bit_invalidate_clean_func(u64);
+ocf_metadata_bit_invalidate_clean_func(u128);
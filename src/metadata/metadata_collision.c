@@ -5,7 +5,9 @@
 
 #include "ocf/ocf.h"
 #include "metadata.h"
+#include "metadata_core_index.h"
 #include "../utils/utils_cache_line.h"
+#include "../concurrency/ocf_concurrency.h"
 
 /*
  *
@@ -42,6 +44,12 @@ void ocf_metadata_add_to_collision(struct ocf_cache *cache,
 	 * collision table so it contains indexes in collision table
 	 */
 	ocf_metadata_set_hash(cache, hash, cache_line);
+
+	ocf_core_index_add(cache, core_id, core_line);
+
+	ocf_metadata_lookup_filter_add(cache, hash, core_id, core_line);
+
+	ocf_metadata_hash_gen_inc(cache, hash);
 }
 
 /*
@@ -71,6 +79,8 @@ void ocf_metadata_remove_from_collision(struct ocf_cache *cache,
 
 	ocf_metadata_get_core_info(cache, line, &core_id, &core_sector);
 
+	ocf_core_index_remove(cache, core_id, core_sector);
+
 	/* Update hash table, because if it was pointing to the given node it
 	 * must now point to the given's node next
 	 */
@@ -80,9 +90,76 @@ void ocf_metadata_remove_from_collision(struct ocf_cache *cache,
 	if (ocf_metadata_get_hash(cache, hash_father) == line)
 		ocf_metadata_set_hash(cache, hash_father, next_line);
 
+	ocf_metadata_lookup_filter_remove(cache, hash_father, core_id,
+			core_sector);
+
 	ocf_metadata_set_collision_info(cache, line,
 			line_entries, line_entries);
 
 	ocf_metadata_set_core_info(cache, line,
 			OCF_CORE_MAX, ULLONG_MAX);
+
+	ocf_metadata_hash_gen_inc(cache, hash_father);
+}
+
+/*
+ * Returns cache line mapped to given core line or number of collision table
+ * entries if core line is not mapped
+ */
+ocf_cache_line_t ocf_metadata_lookup_collision(struct ocf_cache *cache,
+		ocf_core_id_t core_id, uint64_t core_line)
+{
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_cache_line_t hash, line, next;
+	ocf_core_id_t curr_core_id;
+	uint64_t curr_core_line;
+
+	hash = ocf_metadata_hash_func(cache, core_line, core_id);
+	if (!ocf_metadata_lookup_filter_test(cache, hash, core_id, core_line))
+		return line_entries;
+
+	line = ocf_metadata_get_hash(cache, hash);
+
+	while (line != line_entries) {
+		next = ocf_metadata_get_lookup_info(cache, line, &curr_core_id,
+				&curr_core_line);
+
+		if (curr_core_id == core_id && curr_core_line == core_line)
+			break;
+
+		line = next;
+	}
+
+	return line;
+}
+
+#if OCF_CONFIG_LOOKUP_FILTER
+/*
+ * Lookup filter is kept in sync by collision primitives, but collision table
+ * is set up in bulk when metadata is initialized or loaded, so filter has to
+ * be rebuilt from core info of cache lines afterwards.
+ */
+void ocf_metadata_lookup_filter_rebuild(struct ocf_cache *cache)
+{
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_cache_line_t line;
+	ocf_core_id_t core_id;
+	uint64_t core_line;
+	uint32_t step = 0;
+
+	env_memset(cache->device->lookup_filter, sizeof(uint64_t) *
+			cache->device->hash_table_entries, 0);
+
+	for (line = 0; line < line_entries; line++) {
+		ocf_metadata_get_core_info(cache, line, &core_id, &core_line);
+		if (core_id < OCF_CORE_MAX) {
+			ocf_metadata_lookup_filter_add(cache,
+				ocf_metadata_hash_func(cache, core_line,
+						core_id),
+				core_id, core_line);
+		}
+
+		OCF_COND_RESCHED_DEFAULT(step);
+	}
 }
+#endif
@@ -15,20 +15,36 @@ struct ocf_metadata_list_info {
 		/*!<  Previous cache line in collision list */
 	ocf_cache_line_t next_col;
 		/*!<  Next cache line in collision list*/
+#if !OCF_CONFIG_PARTITION_COUNTERS
 	ocf_cache_line_t partition_prev;
 		/*!<  Previous cache line in the same partition*/
 	ocf_cache_line_t partition_next;
 		/*!<  Next cache line in the same partition*/
+#endif
 	ocf_part_id_t partition_id : 8;
 		/*!<  ID of partition where is assigned this cache line*/
+#if OCF_CONFIG_ZERO_LINES
+	uint8_t zero;
+		/*!<  Valid sectors hold zeroes, not written to cache device */
+#endif
 } __attribute__((packed));
 
 /**
  * @brief Metadata map structure
  */
 
+#if OCF_CONFIG_METADATA_COMPACT
+typedef uint32_t ocf_metadata_core_line_t;
+#else
+typedef uint64_t ocf_metadata_core_line_t;
+#endif
+
+/* Maximum number of core lines, the last one marks not mapped cache line */
+#define OCF_METADATA_CORE_LINES_MAX \
+		((uint64_t)(ocf_metadata_core_line_t)ULLONG_MAX)
+
 struct ocf_metadata_map {
-	uint64_t core_line;
+	ocf_metadata_core_line_t core_line;
 		/*!<  Core line addres on cache mapped by this strcture */
 
 	uint16_t core_id;
@@ -80,11 +96,13 @@ static inline void ocf_metadata_set_collision_prev(
 	cache->metadata.iface.set_collision_prev(cache, line, prev);
 }
 
+#if !OCF_CONFIG_METADATA_INLINE
 static inline ocf_cache_line_t ocf_metadata_get_collision_next(
 		struct ocf_cache *cache, ocf_cache_line_t line)
 {
 	return cache->metadata.iface.get_collision_next(cache, line);
 }
+#endif
 
 static inline ocf_cache_line_t ocf_metadata_get_collision_prev(
 		struct ocf_cache *cache, ocf_cache_line_t line)
@@ -92,6 +110,22 @@ static inline ocf_cache_line_t ocf_metadata_get_collision_prev(
 	return cache->metadata.iface.get_collision_prev(cache, line);
 }
 
+#if !OCF_CONFIG_METADATA_INLINE
+static inline ocf_cache_line_t ocf_metadata_get_lookup_info(
+		struct ocf_cache *cache, ocf_cache_line_t line,
+		ocf_core_id_t *core_id, uint64_t *core_line)
+{
+	return cache->metadata.iface.get_lookup_info(cache, line, core_id,
+			core_line);
+}
+#endif
+
+static inline void ocf_metadata_prefetch_lookup_info(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	cache->metadata.iface.prefetch_lookup_info(cache, line);
+}
+
 void ocf_metadata_add_to_collision(struct ocf_cache *cache,
 		ocf_core_id_t core_id, uint64_t core_line,
 		ocf_cache_line_t hash, ocf_cache_line_t cache_line);
@@ -99,4 +133,7 @@ void ocf_metadata_add_to_collision(struct ocf_cache *cache,
 void ocf_metadata_remove_from_collision(struct ocf_cache *cache,
 		ocf_cache_line_t line, ocf_part_id_t part_id);
 
+ocf_cache_line_t ocf_metadata_lookup_collision(struct ocf_cache *cache,
+		ocf_core_id_t core_id, uint64_t core_line);
+
 #endif /* METADATA_COLLISION_H_ */
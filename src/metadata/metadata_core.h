@@ -14,6 +14,7 @@ static inline void ocf_metadata_set_core_info(struct ocf_cache *cache,
 			core_sector);
 }
 
+#if !OCF_CONFIG_METADATA_INLINE
 static inline void ocf_metadata_get_core_info(struct ocf_cache *cache,
 		ocf_cache_line_t line, ocf_core_id_t *core_id,
 		uint64_t *core_sector)
@@ -21,6 +22,7 @@ static inline void ocf_metadata_get_core_info(struct ocf_cache *cache,
 	cache->metadata.iface.get_core_info(cache, line, core_id,
 			core_sector);
 }
+#endif
 
 static inline void ocf_metadata_get_core_and_part_id(
 		struct ocf_cache *cache, ocf_cache_line_t line,
@@ -30,11 +32,13 @@ static inline void ocf_metadata_get_core_and_part_id(
 			part_id);
 }
 
+#if !OCF_CONFIG_METADATA_INLINE
 static inline ocf_core_id_t ocf_metadata_get_core_id(
 		struct ocf_cache *cache, ocf_cache_line_t line)
 {
 	return cache->metadata.iface.get_core_id(cache, line);
 }
+#endif
 
 static inline uint64_t ocf_metadata_get_core_sector(
 		struct ocf_cache *cache, ocf_cache_line_t line)
@@ -0,0 +1,187 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "metadata.h"
+#include "metadata_core_index.h"
+#include "../ocf_def_priv.h"
+#include "../utils/utils_cache_line.h"
+
+/* Number of core lines summarized by single segment counter */
+#define CORE_INDEX_SEGMENT_LINES	4096
+
+#define CORE_INDEX_WORD_BITS		(sizeof(unsigned long) * 8)
+
+static inline unsigned long *_core_index_word(
+		struct ocf_core_line_index *index, uint64_t core_line)
+{
+	return &index->map[core_line / CORE_INDEX_WORD_BITS];
+}
+
+static inline env_atomic *_core_index_segment(
+		struct ocf_core_line_index *index, uint64_t core_line)
+{
+	return &index->segments[core_line / CORE_INDEX_SEGMENT_LINES];
+}
+
+void ocf_core_index_deinit(ocf_core_t core)
+{
+	struct ocf_core_line_index *index = &core->line_index;
+
+	env_vfree(index->map);
+	env_vfree(index->segments);
+
+	index->map = NULL;
+	index->segments = NULL;
+	index->lines = 0;
+	index->overflow = false;
+}
+
+void ocf_core_index_init(ocf_core_t core)
+{
+	struct ocf_core_line_index *index = &core->line_index;
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	uint64_t lines;
+
+	ocf_core_index_deinit(core);
+
+	if (!OCF_CONFIG_CORE_LINE_INDEX || !core->opened)
+		return;
+
+	lines = ocf_bytes_2_lines_round_up(cache,
+			ocf_volume_get_length(&core->volume));
+	if (!lines)
+		return;
+
+	index->map = env_vzalloc(sizeof(*index->map) *
+			OCF_DIV_ROUND_UP(lines, CORE_INDEX_WORD_BITS));
+	index->segments = env_vzalloc(sizeof(*index->segments) *
+			OCF_DIV_ROUND_UP(lines, CORE_INDEX_SEGMENT_LINES));
+	if (!index->map || !index->segments) {
+		ocf_core_log(core, log_warn, "Cannot allocate index of "
+				"mapped core lines\n");
+		ocf_core_index_deinit(core);
+		return;
+	}
+
+	index->lines = lines;
+}
+
+void ocf_core_index_attach(ocf_cache_t cache)
+{
+	ocf_core_id_t core_id;
+	uint64_t core_line;
+	ocf_cache_line_t line;
+	uint32_t step = 0;
+	bool any = false;
+
+	if (!OCF_CONFIG_CORE_LINE_INDEX)
+		return;
+
+	for (core_id = 0; core_id < OCF_CORE_MAX; core_id++) {
+		if (!env_bit_test(core_id, cache->conf_meta->valid_core_bitmap))
+			continue;
+
+		ocf_core_index_init(&cache->core[core_id]);
+		any |= !!cache->core[core_id].line_index.map;
+	}
+
+	if (!any)
+		return;
+
+	/* Record core lines mapped by loaded metadata */
+	for (line = 0; line < cache->device->collision_table_entries; line++) {
+		ocf_metadata_get_core_info(cache, line, &core_id, &core_line);
+		__ocf_core_index_add(cache, core_id, core_line);
+
+		OCF_COND_RESCHED_DEFAULT(step);
+	}
+}
+
+void ocf_core_index_detach(ocf_cache_t cache)
+{
+	ocf_core_id_t core_id;
+
+	for (core_id = 0; core_id < OCF_CORE_MAX; core_id++)
+		ocf_core_index_deinit(&cache->core[core_id]);
+}
+
+void __ocf_core_index_add(ocf_cache_t cache, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+	struct ocf_core_line_index *index;
+
+	if (core_id >= OCF_CORE_MAX)
+		return;
+
+	index = &cache->core[core_id].line_index;
+	if (!index->map)
+		return;
+
+	if (core_line >= index->lines) {
+		index->overflow = true;
+		return;
+	}
+
+	env_bit_set(core_line % CORE_INDEX_WORD_BITS,
+			_core_index_word(index, core_line));
+	env_atomic_inc(_core_index_segment(index, core_line));
+}
+
+void __ocf_core_index_remove(ocf_cache_t cache, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+	struct ocf_core_line_index *index;
+
+	if (core_id >= OCF_CORE_MAX)
+		return;
+
+	index = &cache->core[core_id].line_index;
+	if (!index->map || core_line >= index->lines)
+		return;
+
+	env_bit_clear(core_line % CORE_INDEX_WORD_BITS,
+			_core_index_word(index, core_line));
+	env_atomic_dec(_core_index_segment(index, core_line));
+}
+
+bool ocf_core_index_next(ocf_core_t core, uint64_t *core_line,
+		uint64_t last)
+{
+	struct ocf_core_line_index *index = &core->line_index;
+	uint64_t line = *core_line;
+	unsigned long *word;
+
+	ENV_BUG_ON(!index->map);
+
+	if (last >= index->lines)
+		last = index->lines - 1;
+
+	while (line <= last) {
+		if (!env_atomic_read(_core_index_segment(index, line))) {
+			line = OCF_DIV_ROUND_UP(line + 1,
+					CORE_INDEX_SEGMENT_LINES) *
+					CORE_INDEX_SEGMENT_LINES;
+			continue;
+		}
+
+		word = _core_index_word(index, line);
+		if (!*(volatile unsigned long *)word) {
+			line = OCF_DIV_ROUND_UP(line + 1,
+					CORE_INDEX_WORD_BITS) *
+					CORE_INDEX_WORD_BITS;
+			continue;
+		}
+
+		if (env_bit_test(line % CORE_INDEX_WORD_BITS, word)) {
+			*core_line = line;
+			return true;
+		}
+
+		line++;
+	}
+
+	return false;
+}
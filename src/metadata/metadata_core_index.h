@@ -0,0 +1,110 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __METADATA_CORE_INDEX_H__
+#define __METADATA_CORE_INDEX_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_core_priv.h"
+
+/**
+ * @brief Build index of mapped core lines of all cores of attached cache
+ *
+ * Indexes of cores which cannot be allocated are disabled and range
+ * operations on these cores fall back to metadata scan.
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_core_index_attach(ocf_cache_t cache);
+
+/**
+ * @brief Free indexes of mapped core lines of all cores
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_core_index_detach(ocf_cache_t cache);
+
+/**
+ * @brief Allocate empty index of core added to attached cache
+ *
+ * @param core - OCF core instance
+ */
+void ocf_core_index_init(ocf_core_t core);
+
+/**
+ * @brief Free index of core
+ *
+ * @param core - OCF core instance
+ */
+void ocf_core_index_deinit(ocf_core_t core);
+
+void __ocf_core_index_add(ocf_cache_t cache, ocf_core_id_t core_id,
+		uint64_t core_line);
+
+void __ocf_core_index_remove(ocf_cache_t cache, ocf_core_id_t core_id,
+		uint64_t core_line);
+
+/**
+ * @brief Record core line mapped to cache line
+ *
+ * @note The caller must hold the metadata WR lock or hash bucket WR lock
+ */
+static inline void ocf_core_index_add(ocf_cache_t cache,
+		ocf_core_id_t core_id, uint64_t core_line)
+{
+	if (OCF_CONFIG_CORE_LINE_INDEX)
+		__ocf_core_index_add(cache, core_id, core_line);
+}
+
+/**
+ * @brief Record core line removed from collision table
+ *
+ * @note The caller must hold the metadata WR lock or hash bucket WR lock
+ */
+static inline void ocf_core_index_remove(ocf_cache_t cache,
+		ocf_core_id_t core_id, uint64_t core_line)
+{
+	if (OCF_CONFIG_CORE_LINE_INDEX)
+		__ocf_core_index_remove(cache, core_id, core_line);
+}
+
+/**
+ * @brief Check if core has usable index of mapped core lines
+ */
+static inline bool ocf_core_index_enabled(ocf_core_t core)
+{
+	return OCF_CONFIG_CORE_LINE_INDEX && core->line_index.map &&
+			!core->line_index.overflow;
+}
+
+/**
+ * @brief Find first mapped core line in range
+ *
+ * @param core - OCF core instance with enabled index
+ * @param[in,out] core_line - first core line of range, on success set to
+ *		first mapped core line found
+ * @param last - last core line of range
+ *
+ * @retval true mapped core line was found
+ * @retval false there is no mapped core line in range
+ */
+bool ocf_core_index_next(ocf_core_t core, uint64_t *core_line,
+		uint64_t last);
+
+/**
+ * @brief Check if any core line of range may be mapped
+ *
+ * @retval false none of core lines is mapped
+ * @retval true some core line is mapped or core has no usable index
+ */
+static inline bool ocf_core_index_range_mapped(ocf_core_t core,
+		uint64_t first, uint64_t last)
+{
+	if (!ocf_core_index_enabled(core))
+		return true;
+
+	return ocf_core_index_next(core, &first, last);
+}
+
+#endif /* __METADATA_CORE_INDEX_H__ */
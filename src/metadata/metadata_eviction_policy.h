@@ -6,12 +6,14 @@
 #ifndef __METADATA_EVICTION_H__
 #define __METADATA_EVICTION_H__
 
+#if !OCF_CONFIG_METADATA_INLINE
 static inline void ocf_metadata_get_evicition_policy(
 		struct ocf_cache *cache, ocf_cache_line_t line,
 		union eviction_policy_meta *eviction)
 {
 	cache->metadata.iface.get_eviction_policy(cache, line, eviction);
 }
+#endif
 
 /*
  * SET
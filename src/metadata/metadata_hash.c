@@ -11,6 +11,10 @@
 #include "../concurrency/ocf_concurrency.h"
 #include "../utils/utils_cache_line.h"
 #include "../utils/utils_pipeline.h"
+#include "../utils/utils_req.h"
+#include "../engine/engine_common.h"
+#include "../ocf_queue_priv.h"
+#include "../ocf_volume_priv.h"
 #include "../ocf_def_priv.h"
 
 #define OCF_METADATA_HASH_DEBUG 0
@@ -54,22 +58,28 @@ static inline size_t ocf_metadata_status_sizeof(
 }
 
 /*
- * Hash metadata control structure
+ * Hash table has power of two entries, at most hash load factor cache lines
+ * per entry on average
  */
-struct ocf_metadata_hash_ctrl {
-	ocf_cache_line_t cachelines;
-	ocf_cache_line_t start_page;
-	ocf_cache_line_t count_pages;
-	uint32_t device_lines;
-	size_t mapping_size;
-	struct ocf_metadata_raw raw_desc[metadata_segment_max];
-};
+static ocf_cache_line_t ocf_metadata_hash_get_hash_entries(
+		struct ocf_cache *cache, ocf_cache_line_t cache_lines)
+{
+	uint32_t load_factor = cache->conf_meta->hash_load_factor ?:
+			OCF_HASH_LOAD_FACTOR_DEFAULT;
+	uint64_t needed = OCF_DIV_ROUND_UP(cache_lines, load_factor);
+	uint64_t entries = 1;
+
+	while (entries < needed && entries < (1ULL << 31))
+		entries <<= 1;
+
+	return entries;
+}
 
 /*
  * get entries for specified metadata hash type
  */
 static ocf_cache_line_t ocf_metadata_hash_get_entires(
-		enum ocf_metadata_segment type,
+		struct ocf_cache *cache, enum ocf_metadata_segment type,
 		ocf_cache_line_t cache_lines)
 {
 	ENV_BUG_ON(type >= metadata_segment_variable_size_start && cache_lines == 0);
@@ -82,8 +92,7 @@ static ocf_cache_line_t ocf_metadata_hash_get_entires(
 		return cache_lines;
 
 	case metadata_segment_hash:
-		return OCF_DIV_ROUND_UP(cache_lines / 4, OCF_HASH_PRIME) *
-				OCF_HASH_PRIME - 1;
+		return ocf_metadata_hash_get_hash_entries(cache, cache_lines);
 
 	case metadata_segment_sb_config:
 		return OCF_DIV_ROUND_UP(sizeof(struct ocf_superblock_config),
@@ -116,7 +125,7 @@ static ocf_cache_line_t ocf_metadata_hash_get_entires(
 /*
  * Get size of particular hash metadata type element
  */
-static int64_t ocf_metadata_hash_get_element_size(
+static int64_t ocf_metadata_hash_get_element_size(struct ocf_cache *cache,
 		enum ocf_metadata_segment type,
 		const struct ocf_cache_line_settings *settings)
 {
@@ -126,11 +135,12 @@ static int64_t ocf_metadata_hash_get_element_size(
 
 	switch (type) {
 	case metadata_segment_eviction:
-		size = sizeof(union eviction_policy_meta);
+		size = ocf_eviction_meta_size(
+				cache->conf_meta->eviction_policy_type);
 		break;
 
 	case metadata_segment_cleaning:
-		size = sizeof(struct cleaning_policy_meta);
+		size = ocf_cleaning_meta_size();
 		break;
 
 	case metadata_segment_collision:
@@ -241,7 +251,8 @@ static int ocf_metadata_hash_calculate_metadata_size(
 
 			/* Setup number of entries */
 			raw->entries
-				= ocf_metadata_hash_get_entires(i, cache_lines);
+				= ocf_metadata_hash_get_entires(cache, i,
+					cache_lines);
 
 			/*
 			 * Setup SSD location and size
@@ -384,6 +395,92 @@ static void ocf_metadata_hash_raw_info(struct ocf_cache *cache,
 #define ocf_metadata_hash_raw_info(cache, ctrl)
 #endif
 
+#if OCF_CONFIG_METADATA_LOOKUP_NODES > 0
+/*
+ * Number of NUMA nodes lookup data is replicated on, no replicas are kept
+ * on single node system
+ */
+static uint32_t ocf_metadata_hash_replicas_count(void)
+{
+	int nodes = env_get_numa_node_count();
+
+	if (nodes <= 1)
+		return 0;
+
+	return OCF_MIN(nodes, OCF_CONFIG_METADATA_LOOKUP_NODES);
+}
+
+static int ocf_metadata_hash_replicas_init(
+		struct ocf_metadata_hash_ctrl *ctrl)
+{
+	struct ocf_metadata_hash_replica *replica;
+	uint32_t i, count = ocf_metadata_hash_replicas_count();
+
+	for (i = 0; i < count; i++) {
+		replica = &ctrl->replicas[i];
+
+		replica->lookup = env_zalloc_node(sizeof(*replica->lookup) *
+				ctrl->cachelines, ENV_MEM_NORMAL, i);
+		replica->hash = env_zalloc_node(sizeof(*replica->hash) *
+				ctrl->raw_desc[metadata_segment_hash].entries,
+				ENV_MEM_NORMAL, i);
+		if (!replica->lookup || !replica->hash)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	ctrl->replicas_count = count;
+
+	return 0;
+}
+
+static void ocf_metadata_hash_replicas_deinit(
+		struct ocf_metadata_hash_ctrl *ctrl)
+{
+	uint32_t i;
+
+	ctrl->replicas_count = 0;
+
+	for (i = 0; i < OCF_CONFIG_METADATA_LOOKUP_NODES; i++) {
+		env_free(ctrl->replicas[i].lookup);
+		env_free(ctrl->replicas[i].hash);
+		ctrl->replicas[i].lookup = NULL;
+		ctrl->replicas[i].hash = NULL;
+	}
+}
+
+static uint64_t ocf_metadata_hash_replicas_size(
+		struct ocf_metadata_hash_ctrl *ctrl, uint32_t count)
+{
+	return count * (sizeof(ctrl->replicas[0].lookup[0]) *
+			ctrl->cachelines + sizeof(ctrl->replicas[0].hash[0]) *
+			ctrl->raw_desc[metadata_segment_hash].entries);
+}
+
+/* Update lookup entry of cache line in all replicas */
+#define ocf_metadata_hash_replicas_set(ctrl, line, field, value) ({ \
+	uint32_t __i; \
+	for (__i = 0; __i < (ctrl)->replicas_count; __i++) \
+		(ctrl)->replicas[__i].lookup[line].field = (value); \
+})
+
+static void ocf_metadata_hash_replicas_set_hash(
+		struct ocf_metadata_hash_ctrl *ctrl, ocf_cache_line_t index,
+		ocf_cache_line_t line)
+{
+	uint32_t i;
+
+	for (i = 0; i < ctrl->replicas_count; i++)
+		ctrl->replicas[i].hash[index] = line;
+}
+#else
+#define ocf_metadata_hash_replicas_count() 0
+#define ocf_metadata_hash_replicas_init(ctrl) 0
+#define ocf_metadata_hash_replicas_deinit(ctrl)
+#define ocf_metadata_hash_replicas_size(ctrl, count) 0
+#define ocf_metadata_hash_replicas_set(ctrl, line, field, value)
+#define ocf_metadata_hash_replicas_set_hash(ctrl, index, line)
+#endif
+
 /*
  * Deinitialize hash metadata interface
  */
@@ -406,6 +503,34 @@ static void ocf_metadata_hash_deinit_variable_size(struct ocf_cache *cache)
 		result |= ocf_metadata_raw_deinit(cache,
 				&(ctrl->raw_desc[i]));
 	}
+
+	if (ctrl->lookup) {
+		env_vfree(ctrl->lookup);
+		ctrl->lookup = NULL;
+	}
+
+	ocf_metadata_hash_replicas_deinit(ctrl);
+
+#if OCF_CONFIG_FREE_MAP
+	if (cache->device->free_map.bits) {
+		env_vfree(cache->device->free_map.bits);
+		cache->device->free_map.bits = NULL;
+	}
+#endif
+
+#if OCF_CONFIG_LOOKUP_FILTER
+	if (cache->device->lookup_filter) {
+		env_vfree(cache->device->lookup_filter);
+		cache->device->lookup_filter = NULL;
+	}
+#endif
+
+#if OCF_CONFIG_TRIM_MIN_LINES > 0
+	if (cache->device->trim.bits) {
+		env_vfree(cache->device->trim.bits);
+		cache->device->trim.bits = NULL;
+	}
+#endif
 }
 
 static inline void ocf_metadata_config_init(struct ocf_cache *cache,
@@ -416,6 +541,7 @@ static inline void ocf_metadata_config_init(struct ocf_cache *cache,
 	ENV_BUG_ON(env_memset(settings, sizeof(*settings), 0));
 
 	settings->size = size;
+	settings->size_shift = __builtin_ctzll(size);
 	settings->sector_count = BYTES_TO_SECTORS(settings->size);
 	settings->sector_start = 0;
 	settings->sector_end = settings->sector_count - 1;
@@ -485,11 +611,11 @@ static int ocf_metadata_hash_init(struct ocf_cache *cache,
 
 		/* Entry size configuration */
 		raw->entry_size
-			= ocf_metadata_hash_get_element_size(i, NULL);
+			= ocf_metadata_hash_get_element_size(cache, i, NULL);
 		raw->entries_in_page = PAGE_SIZE / raw->entry_size;
 
 		/* Setup number of entries */
-		raw->entries = ocf_metadata_hash_get_entires(i, 0);
+		raw->entries = ocf_metadata_hash_get_entires(cache, i, 0);
 
 		/*
 		 * Setup SSD location and size
@@ -523,9 +649,12 @@ static int ocf_metadata_hash_init(struct ocf_cache *cache,
 		cache->core_runtime_meta = METADATA_MEM_POOL(ctrl,
 				metadata_segment_core_runtime);
 
-		env_spinlock_init(&cache->metadata.lock.eviction);
-		env_rwlock_init(&cache->metadata.lock.status);
-		env_rwsem_init(&cache->metadata.lock.collision);
+		for (i = 0; i < OCF_EVICTION_SHARDS; i++)
+			env_spinlock_init(&cache->metadata.lock.eviction[i].lock);
+		for (i = 0; i < OCF_CONFIG_METADATA_STATUS_LOCKS; i++)
+			env_rwlock_init(&cache->metadata.lock.status[i].lock);
+		env_spinlock_init(&cache->metadata.lock.freelist);
+		env_rwsem_init(&cache->metadata.lock.global);
 	}
 
 	return result;
@@ -546,6 +675,7 @@ static int ocf_metadata_hash_init_variable_size(struct ocf_cache *cache,
 	struct ocf_metadata_hash_ctrl *ctrl = NULL;
 	struct ocf_cache_line_settings *settings =
 		(struct ocf_cache_line_settings *)&cache->metadata.settings;
+	bool pmem;
 
 	OCF_DEBUG_TRACE(cache);
 
@@ -564,6 +694,14 @@ static int ocf_metadata_hash_init_variable_size(struct ocf_cache *cache,
 
 	ocf_metadata_hash_init_iface(cache, layout);
 
+	/* Cache volume mapped as persistent memory has metadata stored to it
+	 * instead of written with IOs
+	 */
+	pmem = !!ocf_volume_get_direct_mapping(&cache->device->volume);
+	if (pmem)
+		ocf_cache_log(cache, log_info, "Metadata stored to persistent "
+				"memory mapping of cache device\n");
+
 	/* Initial setup of dynamic size RAW containers */
 	for (i = metadata_segment_variable_size_start;
 			i < metadata_segment_max; i++) {
@@ -576,6 +714,8 @@ static int ocf_metadata_hash_init_variable_size(struct ocf_cache *cache,
 
 		if (cache->device->init_mode == ocf_init_mode_metadata_volatile) {
 			raw->raw_type = metadata_raw_type_volatile;
+		} else if (pmem) {
+			raw->raw_type = metadata_raw_type_pmem;
 		} else if (i == metadata_segment_collision &&
 				ocf_volume_is_atomic(&cache->device->volume)) {
 			raw->raw_type = metadata_raw_type_atomic;
@@ -583,7 +723,8 @@ static int ocf_metadata_hash_init_variable_size(struct ocf_cache *cache,
 
 		/* Entry size configuration */
 		raw->entry_size
-			= ocf_metadata_hash_get_element_size(i, settings);
+			= ocf_metadata_hash_get_element_size(cache, i,
+				settings);
 		raw->entries_in_page = PAGE_SIZE / raw->entry_size;
 	}
 
@@ -608,6 +749,50 @@ static int ocf_metadata_hash_init_variable_size(struct ocf_cache *cache,
 			goto finalize;
 	}
 
+	if (OCF_CONFIG_METADATA_LOOKUP_PACKED) {
+		ctrl->lookup = env_vzalloc(sizeof(*ctrl->lookup) *
+				ctrl->cachelines);
+		if (!ctrl->lookup) {
+			result = -OCF_ERR_NO_MEM;
+			goto finalize;
+		}
+	}
+
+	result = ocf_metadata_hash_replicas_init(ctrl);
+	if (result)
+		goto finalize;
+
+#if OCF_CONFIG_FREE_MAP
+	cache->device->free_map.bits = env_vzalloc(sizeof(uint64_t) *
+			OCF_DIV_ROUND_UP(ctrl->cachelines, 64));
+	if (!cache->device->free_map.bits) {
+		result = -OCF_ERR_NO_MEM;
+		goto finalize;
+	}
+	cache->device->free_map.cursor = 0;
+#endif
+
+#if OCF_CONFIG_LOOKUP_FILTER
+	cache->device->lookup_filter = env_vzalloc(sizeof(uint64_t) *
+			ctrl->raw_desc[metadata_segment_hash].entries);
+	if (!cache->device->lookup_filter) {
+		result = -OCF_ERR_NO_MEM;
+		goto finalize;
+	}
+#endif
+
+#if OCF_CONFIG_TRIM_MIN_LINES > 0
+	cache->device->trim.bits = env_vzalloc(sizeof(uint64_t) *
+			OCF_DIV_ROUND_UP(ctrl->cachelines, 64));
+	if (!cache->device->trim.bits) {
+		result = -OCF_ERR_NO_MEM;
+		goto finalize;
+	}
+	cache->device->trim.cursor = 0;
+	cache->device->trim.count = 0;
+	env_atomic_set(&cache->device->trim.active, 0);
+#endif
+
 	for (i = 0; i < metadata_segment_max; i++) {
 		ocf_cache_log(cache, log_info, "%s offset : %llu kiB\n",
 				ocf_metadata_hash_raw_names[i],
@@ -642,6 +827,7 @@ finalize:
 				metadata_segment_sb_runtime);
 
 		cache->device->collision_table_entries = ctrl->cachelines;
+		cache->device->lines_limit = ctrl->cachelines;
 
 		cache->device->hash_table_entries =
 				ctrl->raw_desc[metadata_segment_hash].entries;
@@ -706,116 +892,259 @@ static inline void _ocf_init_collision_entry(struct ocf_cache *cache,
 /*
  * Default initialization of freelist partition
  */
-static void ocf_metadata_hash_init_freelist_seq(struct ocf_cache *cache)
+static void ocf_metadata_hash_init_freelist_seq(struct ocf_cache *cache,
+		ocf_cache_line_t begin, ocf_cache_line_t end)
 {
 	uint32_t step = 0;
-	unsigned int i = 0;
+	ocf_cache_line_t i;
 	ocf_cache_line_t collision_table_entries =
 			cache->device->collision_table_entries;
 
-	cache->device->freelist_part->head = 0;
-	cache->device->freelist_part->curr_size = cache->device->collision_table_entries;
-
 	/* hash_father is an index in hash_table and it's limited
 	 * to the hash_table_entries
 	 * hash_table_entries is invalid index here.
 	 */
-	_ocf_init_collision_entry(cache, i, 1, collision_table_entries);
-
-	for (i = 1; i < collision_table_entries - 1; i++) {
-		_ocf_init_collision_entry(cache, i, i + 1, i - 1);
+	for (i = begin; i < end; i++) {
+		_ocf_init_collision_entry(cache, i, i + 1,
+				i ? i - 1 : collision_table_entries);
 		OCF_COND_RESCHED_DEFAULT(step);
 	}
 
-	cache->device->freelist_part->tail = i;
-	_ocf_init_collision_entry(cache, i, collision_table_entries, i - 1);
+	if (end == collision_table_entries)
+		cache->device->freelist_part->tail = end - 1;
 }
 
 /*
- * Modified initialization of freelist partition
+ * Modified initialization of freelist partition. Free list goes through
+ * entries with the same offset in consecutive collision pages, then moves
+ * to the next offset. Links of each entry are calculated from its index
+ * alone, so that ranges may be initialized independently.
  */
 static void ocf_metadata_hash_init_freelist_striping(
-		struct ocf_cache *cache)
+		struct ocf_cache *cache, ocf_cache_line_t begin,
+		ocf_cache_line_t end)
 {
 	uint32_t step = 0;
-	unsigned int i, j;
 	ocf_cache_line_t prev, next;
-	ocf_cache_line_t idx, last_page;
+	ocf_cache_line_t idx, offset, tail;
 	ocf_cache_line_t collision_table_entries =
 			cache->device->collision_table_entries;
 	struct ocf_metadata_hash_ctrl *ctrl =
 		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
 	unsigned int entries_in_page =
 		ctrl->raw_desc[metadata_segment_collision].entries_in_page;
-	unsigned int pages =
-		ctrl->raw_desc[metadata_segment_collision].ssd_pages;
 
-	cache->device->freelist_part->head = 0;
-	cache->device->freelist_part->curr_size = cache->device->collision_table_entries;
+	/* Free list ends with last entry of last offset */
+	if (collision_table_entries < entries_in_page) {
+		tail = collision_table_entries - 1;
+	} else {
+		tail = entries_in_page - 1 + entries_in_page *
+			((collision_table_entries - entries_in_page) /
+					entries_in_page);
+	}
 
-	/* Modified initialization procedure */
-	prev = next = collision_table_entries;
-	last_page = pages;
+	for (idx = begin; idx < end; idx++) {
+		offset = idx % entries_in_page;
 
-	for (i = 0; i < pages; i++) {
-		idx = i * entries_in_page;
-		for (j = 0; j < entries_in_page &&
-				idx < collision_table_entries; j++) {
+		if (idx == tail)
+			next = collision_table_entries;
+		else if (idx + entries_in_page < collision_table_entries)
 			next = idx + entries_in_page;
+		else
+			next = offset + 1;
 
-			if (next >= collision_table_entries)
-				next = j + 1;
-
-			_ocf_init_collision_entry(cache, idx, next, prev);
-
-			if (idx >= entries_in_page - 1) {
-				prev = idx - entries_in_page + 1;
-			} else {
-				prev = last_page * entries_in_page + j;
-				if (prev >= collision_table_entries) {
-					prev -= entries_in_page;
-					last_page = pages - 1;
-				}
-			}
-
-			OCF_COND_RESCHED_DEFAULT(step);
-			idx++;
+		if (idx >= entries_in_page) {
+			prev = idx - entries_in_page;
+		} else if (idx == 0) {
+			prev = collision_table_entries;
+		} else {
+			/* Last entry of previous offset */
+			prev = offset - 1 + entries_in_page *
+				((collision_table_entries - offset) /
+						entries_in_page);
 		}
-	}
 
-	if (collision_table_entries < entries_in_page) {
-		idx = collision_table_entries - 1;
-	} else {
-		idx = pages * entries_in_page - 1;
-		if (idx >= collision_table_entries)
-			idx -= entries_in_page;
+		_ocf_init_collision_entry(cache, idx, next, prev);
 
+		OCF_COND_RESCHED_DEFAULT(step);
 	}
 
-	/* Terminate free list */
-	cache->device->freelist_part->tail = idx;
-	ocf_metadata_set_partition_next(cache, idx, collision_table_entries);
+	if (begin <= tail && tail < end)
+		cache->device->freelist_part->tail = tail;
 }
 
-
 /*
- * Initialize hash table
+ * Initialize range of hash table
  */
-static void ocf_metadata_hash_init_hash_table(struct ocf_cache *cache)
+static void ocf_metadata_hash_init_hash_table(struct ocf_cache *cache,
+		ocf_cache_line_t begin, ocf_cache_line_t end)
 {
-	unsigned int i;
-	unsigned int hash_table_entries = cache->device->hash_table_entries;
+	uint32_t step = 0;
+	ocf_cache_line_t i;
 	ocf_cache_line_t invalid_idx = cache->device->collision_table_entries;
 
-	/* Init hash table */
-	for (i = 0; i < hash_table_entries; i++) {
+	for (i = begin; i < end; i++) {
 		/* hash_table contains indexes from collision_table
 		 * thus it shall be initialized in improper values
 		 * from collision_table
 		 **/
 		ocf_metadata_set_hash(cache, i, invalid_idx);
+		OCF_COND_RESCHED_DEFAULT(step);
+	}
+}
+
+/* Number of entries initialized by single job */
+#define OCF_METADATA_HASH_INIT_CHUNK (1 << 20)
+
+/* Maximum number of queues initialization jobs are spread over */
+#define OCF_METADATA_HASH_INIT_QUEUES 64
+
+struct ocf_metadata_hash_init_context;
+
+struct ocf_metadata_hash_init_job {
+	struct ocf_metadata_hash_init_context *context;
+	ocf_cache_line_t begin;
+	ocf_cache_line_t end;
+	bool hash_table;
+};
+
+struct ocf_metadata_hash_init_context {
+	ocf_metadata_end_t cmpl;
+	void *priv;
+	ocf_cache_t cache;
+
+	env_atomic remaining;
+	struct ocf_metadata_hash_init_job jobs[];
+};
+
+static void ocf_metadata_hash_init_job_run(
+		struct ocf_metadata_hash_init_job *job)
+{
+	ocf_cache_t cache = job->context->cache;
+
+	if (job->hash_table) {
+		ocf_metadata_hash_init_hash_table(cache, job->begin, job->end);
+	} else {
+		cache->metadata.iface.layout_iface->init_freelist(cache,
+				job->begin, job->end);
+	}
+}
+
+static void ocf_metadata_hash_init_complete(
+		struct ocf_metadata_hash_init_context *context)
+{
+	if (env_atomic_dec_return(&context->remaining))
+		return;
+
+	context->cmpl(context->priv, 0);
+	env_vfree(context);
+}
+
+static int ocf_metadata_hash_init_job(struct ocf_request *req)
+{
+	struct ocf_metadata_hash_init_job *job = req->priv;
+
+	ocf_metadata_hash_init_job_run(job);
+	ocf_req_put(req);
+
+	ocf_metadata_hash_init_complete(job->context);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_init_job = {
+	.read = ocf_metadata_hash_init_job,
+	.write = ocf_metadata_hash_init_job,
+};
+
+static uint32_t ocf_metadata_hash_init_add_jobs(
+		struct ocf_metadata_hash_init_job *jobs,
+		ocf_cache_line_t entries, bool hash_table)
+{
+	ocf_cache_line_t begin;
+	uint32_t i = 0;
+
+	for (begin = 0; begin < entries;
+			begin += OCF_METADATA_HASH_INIT_CHUNK, i++) {
+		if (jobs) {
+			jobs[i].begin = begin;
+			jobs[i].end = OCF_MIN(entries,
+					begin + OCF_METADATA_HASH_INIT_CHUNK);
+			jobs[i].hash_table = hash_table;
+		}
+	}
+
+	return i;
+}
+
+/*
+ * Initialize hash table and collision table in chunks, executed concurrently
+ * on I/O queues of cache. Free list links of each entry depend only on its
+ * index, so free list is ready once all chunks are done.
+ */
+static void ocf_metadata_hash_init_collision(struct ocf_cache *cache,
+		ocf_metadata_end_t cmpl, void *priv)
+{
+	ocf_cache_line_t collision_table_entries =
+			cache->device->collision_table_entries;
+	ocf_cache_line_t hash_table_entries =
+			cache->device->hash_table_entries;
+	ocf_queue_t queues[OCF_METADATA_HASH_INIT_QUEUES];
+	struct ocf_metadata_hash_init_context *context;
+	struct ocf_request *req;
+	uint32_t jobs_no, queues_no, i;
+
+	jobs_no = ocf_metadata_hash_init_add_jobs(NULL,
+			collision_table_entries, false);
+	jobs_no += ocf_metadata_hash_init_add_jobs(NULL,
+			hash_table_entries, true);
+
+	context = env_vzalloc(sizeof(*context) +
+			jobs_no * sizeof(context->jobs[0]));
+	if (!context) {
+		cmpl(priv, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	context->cmpl = cmpl;
+	context->priv = priv;
+	context->cache = cache;
+
+	i = ocf_metadata_hash_init_add_jobs(context->jobs,
+			collision_table_entries, false);
+	ocf_metadata_hash_init_add_jobs(&context->jobs[i],
+			hash_table_entries, true);
+
+	cache->device->freelist_part->head = 0;
+	cache->device->freelist_part->curr_size = collision_table_entries;
+
+	queues_no = ocf_queue_get_io_queues(cache, queues,
+			OCF_METADATA_HASH_INIT_QUEUES);
+
+	env_atomic_set(&context->remaining, jobs_no + 1);
+
+	for (i = 0; i < jobs_no; i++) {
+		context->jobs[i].context = context;
+
+		req = ocf_req_new(queues[i % queues_no], NULL, 0, 0, OCF_READ);
+		if (!req) {
+			/* Initialize it here then */
+			ocf_metadata_hash_init_job_run(&context->jobs[i]);
+			ocf_metadata_hash_init_complete(context);
+			continue;
+		}
+
+		req->info.internal = true;
+		req->io_if = &_io_if_init_job;
+		req->priv = &context->jobs[i];
+
+		ocf_engine_push_req_back(req, false);
 	}
 
+	for (i = 0; i < queues_no; i++)
+		ocf_queue_put(queues[i]);
+
+	ocf_metadata_hash_init_complete(context);
 }
 
 /*
@@ -873,15 +1202,175 @@ static size_t ocf_metadata_hash_size_of(struct ocf_cache *cache)
 	return size;
 }
 
+static void ocf_metadata_hash_mem_usage(struct ocf_cache *cache,
+		struct ocf_cache_memory_usage *usage)
+{
+	struct ocf_metadata_hash_ctrl *ctrl = cache->metadata.iface_priv;
+	uint32_t i;
+
+	OCF_DEBUG_TRACE(cache);
+
+	ENV_BUG_ON(metadata_segment_max > OCF_CACHE_MEMORY_SEGMENTS_MAX);
+
+	for (i = 0; i < metadata_segment_max; i++) {
+		usage->segments[i].name = ocf_metadata_hash_raw_names[i];
+		usage->segments[i].bytes = ocf_metadata_raw_size_of(cache,
+				&ctrl->raw_desc[i]);
+	}
+	usage->segments_count = metadata_segment_max;
+
+	if (ctrl->lookup)
+		usage->metadata_other += sizeof(*ctrl->lookup) * ctrl->cachelines;
+
+#if OCF_CONFIG_METADATA_LOOKUP_NODES > 0
+	usage->metadata_other += ocf_metadata_hash_replicas_size(ctrl,
+			ctrl->replicas_count);
+#endif
+
+#if OCF_CONFIG_FREE_MAP
+	usage->metadata_other += sizeof(uint64_t) *
+			OCF_DIV_ROUND_UP(ctrl->cachelines, 64);
+#endif
+
+#if OCF_CONFIG_LOOKUP_FILTER
+	usage->metadata_other += sizeof(uint64_t) *
+			ctrl->raw_desc[metadata_segment_hash].entries;
+#endif
+
+#if OCF_CONFIG_TRIM_MIN_LINES > 0
+	usage->metadata_other += sizeof(uint64_t) *
+			OCF_DIV_ROUND_UP(ctrl->cachelines, 64);
+#endif
+}
+
+/*
+ * Run sizing of variable size segments on a scratch control structure, the
+ * same way init_variable_size does, without allocating the segments
+ */
+static int ocf_metadata_hash_size_estimate(struct ocf_cache *cache,
+		uint64_t device_size, ocf_cache_line_size_t line_size,
+		bool atomic, struct ocf_mngt_cache_ram_needed *ram)
+{
+	struct ocf_metadata_hash_ctrl *ctrl = cache->metadata.iface_priv;
+	struct ocf_metadata_hash_ctrl *tmp;
+	struct ocf_cache_line_settings settings;
+	struct ocf_metadata_raw *raw;
+	uint64_t *segment_size;
+	uint32_t i;
+	int result = 0;
+
+	OCF_DEBUG_TRACE(cache);
+
+	if (!ctrl)
+		return -OCF_ERR_INVAL;
+
+	tmp = env_vzalloc(sizeof(*tmp));
+	if (!tmp)
+		return -OCF_ERR_NO_MEM;
+
+	for (i = 0; i < metadata_segment_fixed_size_max; i++) {
+		tmp->count_pages += ocf_metadata_raw_size_on_ssd(cache,
+				&ctrl->raw_desc[i]);
+	}
+
+	tmp->device_lines = device_size / line_size;
+	ocf_metadata_config_init(cache, &settings, line_size);
+
+	for (i = metadata_segment_variable_size_start;
+			i < metadata_segment_max; i++) {
+		raw = &tmp->raw_desc[i];
+
+		raw->metadata_segment = i;
+		raw->raw_type = metadata_raw_type_ram;
+		if (i == metadata_segment_collision && atomic)
+			raw->raw_type = metadata_raw_type_atomic;
+
+		raw->entry_size = ocf_metadata_hash_get_element_size(cache, i,
+				&settings);
+		raw->entries_in_page = PAGE_SIZE / raw->entry_size;
+	}
+
+	if (ocf_metadata_hash_calculate_metadata_size(cache, tmp, &settings)) {
+		result = -OCF_ERR_START_CACHE_FAIL;
+		goto out;
+	}
+
+	ENV_BUG_ON(env_memset(ram, sizeof(*ram), 0));
+
+	ram->cache_lines = tmp->cachelines;
+
+	for (i = metadata_segment_variable_size_start;
+			i < metadata_segment_max; i++) {
+		switch (i) {
+		case metadata_segment_cleaning:
+			segment_size = &ram->cleaning;
+			break;
+		case metadata_segment_eviction:
+			segment_size = &ram->eviction;
+			break;
+		case metadata_segment_collision:
+			segment_size = &ram->collision;
+			break;
+		case metadata_segment_list_info:
+			segment_size = &ram->list_info;
+			break;
+		case metadata_segment_hash:
+			segment_size = &ram->hash;
+			break;
+		default:
+			segment_size = &ram->other;
+			break;
+		}
+
+		*segment_size += ocf_metadata_raw_size_of_estimate(cache,
+				&tmp->raw_desc[i]);
+	}
+
+	if (OCF_CONFIG_METADATA_LOOKUP_PACKED)
+		ram->other += sizeof(*tmp->lookup) * tmp->cachelines;
+
+	ram->other += ocf_metadata_hash_replicas_size(tmp,
+			ocf_metadata_hash_replicas_count());
+
+#if OCF_CONFIG_FREE_MAP
+	ram->other += sizeof(uint64_t) * OCF_DIV_ROUND_UP(tmp->cachelines, 64);
+#endif
+
+#if OCF_CONFIG_LOOKUP_FILTER
+	ram->other += sizeof(uint64_t) *
+			tmp->raw_desc[metadata_segment_hash].entries;
+#endif
+
+#if OCF_CONFIG_TRIM_MIN_LINES > 0
+	ram->other += sizeof(uint64_t) * OCF_DIV_ROUND_UP(tmp->cachelines, 64);
+#endif
+
+out:
+	env_vfree(tmp);
+	return result;
+}
+
 /*******************************************************************************
  * Super Block
  ******************************************************************************/
 
+struct ocf_metadata_hash_context;
+
+struct ocf_metadata_hash_crc_job {
+	struct ocf_metadata_hash_context *context;
+	int segment;
+};
+
 struct ocf_metadata_hash_context {
 	ocf_metadata_end_t cmpl;
 	void *priv;
 	ocf_pipeline_t pipeline;
 	ocf_cache_t cache;
+
+	/* Segments processed concurrently */
+	env_atomic remaining;
+	env_atomic error;
+	struct ocf_metadata_hash_crc_job crc_jobs[metadata_segment_max];
 };
 
 static void ocf_metadata_hash_generic_complete(void *priv, int error)
@@ -921,7 +1410,7 @@ static void ocf_medatata_hash_check_crc_sb_config(ocf_pipeline_t pipeline,
 	ctrl = (struct ocf_metadata_hash_ctrl *)cache->metadata.iface_priv;
 	sb_config = METADATA_MEM_POOL(ctrl, metadata_segment_sb_config);
 
-	crc = env_crc32(0, (void *)sb_config,
+	crc = METADATA_CRC(0, (void *)sb_config,
 			offsetof(struct ocf_superblock_config, checksum));
 
 	if (crc != sb_config->checksum[segment]) {
@@ -936,31 +1425,164 @@ static void ocf_medatata_hash_check_crc_sb_config(ocf_pipeline_t pipeline,
 	ocf_pipeline_next(pipeline);
 }
 
+static int ocf_metadata_hash_check_crc_segment(ocf_cache_t cache,
+		int segment)
+{
+	struct ocf_metadata_hash_ctrl *ctrl;
+	struct ocf_superblock_config *sb_config;
+	uint32_t crc;
+
+	ctrl = (struct ocf_metadata_hash_ctrl *)cache->metadata.iface_priv;
+	sb_config = METADATA_MEM_POOL(ctrl, metadata_segment_sb_config);
+
+	crc = ocf_metadata_raw_checksum(cache, &(ctrl->raw_desc[segment]));
+
+	if (crc != sb_config->checksum[segment]) {
+		/* Checksum does not match */
+		ocf_cache_log(cache, log_err,
+				"Loading %s ERROR, invalid checksum",
+				ocf_metadata_hash_raw_names[segment]);
+		return -OCF_ERR_INVAL;
+	}
+
+	return 0;
+}
+
 static void ocf_medatata_hash_check_crc(ocf_pipeline_t pipeline,
 		void *priv, ocf_pipeline_arg_t arg)
 {
 	struct ocf_metadata_hash_context *context = priv;
 	int segment = ocf_pipeline_arg_get_int(arg);
+	int result;
+
+	result = ocf_metadata_hash_check_crc_segment(context->cache, segment);
+	if (result) {
+		ocf_pipeline_finish(pipeline, result);
+		return;
+	}
+
+	ocf_pipeline_next(pipeline);
+}
+
+/*
+ * Completion of single segment processed concurrently with others. Step
+ * issuing segments holds one reference until all of them are issued.
+ */
+static void ocf_metadata_hash_segments_complete(void *priv, int error)
+{
+	struct ocf_metadata_hash_context *context = priv;
+
+	if (error)
+		env_atomic_cmpxchg(&context->error, 0, error);
+
+	if (env_atomic_dec_return(&context->remaining))
+		return;
+
+	error = env_atomic_read(&context->error);
+	if (error)
+		ocf_pipeline_finish(context->pipeline, error);
+	else
+		ocf_pipeline_next(context->pipeline);
+}
+
+/*
+ * Load all segments from list at once, so that their IOs are queued to
+ * cache device together
+ */
+static void ocf_medatata_hash_load_segments(ocf_pipeline_t pipeline,
+		void *priv, ocf_pipeline_arg_t arg)
+{
+	struct ocf_metadata_hash_context *context = priv;
+	ocf_pipeline_arg_t segments = ocf_pipeline_arg_get_ptr(arg);
 	struct ocf_metadata_hash_ctrl *ctrl;
-	struct ocf_superblock_config *sb_config;
 	ocf_cache_t cache = context->cache;
-	uint32_t crc;
+	int segment;
+
+	ctrl = (struct ocf_metadata_hash_ctrl *)cache->metadata.iface_priv;
+
+	env_atomic_set(&context->remaining, 1);
+	env_atomic_set(&context->error, 0);
+
+	for (; segments->type != ocf_pipeline_arg_terminator; segments++) {
+		segment = ocf_pipeline_arg_get_int(segments);
+
+		env_atomic_inc(&context->remaining);
+		ocf_metadata_raw_load_all(cache, &ctrl->raw_desc[segment],
+				ocf_metadata_hash_segments_complete, context);
+	}
+
+	ocf_metadata_hash_segments_complete(context, 0);
+}
+
+static int ocf_metadata_hash_check_crc_job(struct ocf_request *req)
+{
+	struct ocf_metadata_hash_crc_job *job = req->priv;
+	int result;
+
+	result = ocf_metadata_hash_check_crc_segment(req->cache, job->segment);
+	ocf_req_put(req);
+
+	ocf_metadata_hash_segments_complete(job->context, result);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_check_crc = {
+	.read = ocf_metadata_hash_check_crc_job,
+	.write = ocf_metadata_hash_check_crc_job,
+};
+
+/*
+ * Checksum segments from list on I/O queues of cache, one segment per
+ * queue, so that they are calculated in parallel
+ */
+static void ocf_medatata_hash_check_crc_segments(ocf_pipeline_t pipeline,
+		void *priv, ocf_pipeline_arg_t arg)
+{
+	struct ocf_metadata_hash_context *context = priv;
+	ocf_pipeline_arg_t segments = ocf_pipeline_arg_get_ptr(arg);
+	ocf_cache_t cache = context->cache;
+	ocf_queue_t queues[metadata_segment_max];
+	struct ocf_metadata_hash_crc_job *job;
+	struct ocf_request *req;
+	uint32_t queues_no, i;
+
+	queues_no = ocf_queue_get_io_queues(cache, queues,
+			metadata_segment_max);
+
+	env_atomic_set(&context->remaining, 1);
+	env_atomic_set(&context->error, 0);
 
-	ctrl = (struct ocf_metadata_hash_ctrl *)cache->metadata.iface_priv;
-	sb_config = METADATA_MEM_POOL(ctrl, metadata_segment_sb_config);
+	for (i = 0; segments->type != ocf_pipeline_arg_terminator;
+			segments++, i++) {
+		ENV_BUG_ON(i >= metadata_segment_max);
 
-	crc = ocf_metadata_raw_checksum(cache, &(ctrl->raw_desc[segment]));
+		job = &context->crc_jobs[i];
+		job->context = context;
+		job->segment = ocf_pipeline_arg_get_int(segments);
 
-	if (crc != sb_config->checksum[segment]) {
-		/* Checksum does not match */
-		ocf_cache_log(cache, log_err,
-				"Loading %s ERROR, invalid checksum",
-				ocf_metadata_hash_raw_names[segment]);
-		ocf_pipeline_finish(pipeline, -OCF_ERR_INVAL);
-		return;
+		env_atomic_inc(&context->remaining);
+
+		req = ocf_req_new(queues[i % queues_no], NULL, 0, 0, OCF_READ);
+		if (!req) {
+			/* Checksum it here then */
+			ocf_metadata_hash_segments_complete(context,
+					ocf_metadata_hash_check_crc_segment(
+						cache, job->segment));
+			continue;
+		}
+
+		req->info.internal = true;
+		req->io_if = &_io_if_check_crc;
+		req->priv = job;
+
+		ocf_engine_push_req_back(req, false);
 	}
 
-	ocf_pipeline_next(pipeline);
+	for (i = 0; i < queues_no; i++)
+		ocf_queue_put(queues[i]);
+
+	ocf_metadata_hash_segments_complete(context, 0);
 }
 
 static void ocf_medatata_hash_load_superblock_post(ocf_pipeline_t pipeline,
@@ -1123,7 +1745,7 @@ static void ocf_medatata_hash_calculate_crc_sb_config(ocf_pipeline_t pipeline,
 	ctrl = (struct ocf_metadata_hash_ctrl *)cache->metadata.iface_priv;
 	sb_config = METADATA_MEM_POOL(ctrl, metadata_segment_sb_config);
 
-	sb_config->checksum[metadata_segment_sb_config] = env_crc32(0,
+	sb_config->checksum[metadata_segment_sb_config] = METADATA_CRC(0,
 			(void *)sb_config,
 			offsetof(struct ocf_superblock_config, checksum));
 
@@ -1387,6 +2009,71 @@ static void ocf_metadata_hash_flush_all(ocf_cache_t cache,
 	ocf_pipeline_next(pipeline);
 }
 
+static void ocf_metadata_hash_checkpoint_finish(ocf_pipeline_t pipeline,
+		void *priv, int error)
+{
+	struct ocf_metadata_hash_context *context = priv;
+	ocf_cache_t cache = context->cache;
+
+	/* Pages not written stay modified until next flush */
+	if (error)
+		ocf_cache_log(cache, log_warn, "Metadata checkpoint failed\n");
+
+	context->cmpl(context->priv, error);
+	ocf_pipeline_destroy(pipeline);
+}
+
+struct ocf_pipeline_arg ocf_metadata_hash_checkpoint_args[] = {
+	OCF_PL_ARG_INT(metadata_segment_cleaning),
+	OCF_PL_ARG_INT(metadata_segment_eviction),
+	OCF_PL_ARG_INT(metadata_segment_collision),
+	OCF_PL_ARG_INT(metadata_segment_list_info),
+	OCF_PL_ARG_INT(metadata_segment_hash),
+	OCF_PL_ARG_TERMINATOR(),
+};
+
+struct ocf_pipeline_properties ocf_metadata_hash_checkpoint_pipeline_props = {
+	.priv_size = sizeof(struct ocf_metadata_hash_context),
+	.finish = ocf_metadata_hash_checkpoint_finish,
+	.steps = {
+		OCF_PL_STEP_FOREACH(ocf_medatata_hash_flush_segment,
+				ocf_metadata_hash_checkpoint_args),
+		OCF_PL_STEP_TERMINATOR(),
+	},
+};
+
+/*
+ * Write pages of per cache line metadata modified since they were last
+ * written. Superblock, checksums and shutdown status are left as they are,
+ * so cache is still recovered after crash and checksums are calculated by
+ * flush of all metadata on stop.
+ */
+static void ocf_metadata_hash_checkpoint(ocf_cache_t cache,
+		ocf_metadata_end_t cmpl, void *priv)
+{
+	struct ocf_metadata_hash_context *context;
+	ocf_pipeline_t pipeline;
+	int result;
+
+	OCF_DEBUG_TRACE(cache);
+
+	result = ocf_pipeline_create(&pipeline, cache,
+			&ocf_metadata_hash_checkpoint_pipeline_props);
+	if (result) {
+		cmpl(priv, result);
+		return;
+	}
+
+	context = ocf_pipeline_get_priv(pipeline);
+
+	context->cmpl = cmpl;
+	context->priv = priv;
+	context->pipeline = pipeline;
+	context->cache = cache;
+
+	ocf_pipeline_next(pipeline);
+}
+
 /*
  * Flush specified cache line
  */
@@ -1441,6 +2128,62 @@ static void ocf_metadata_hash_flush_do_asynch(struct ocf_cache *cache,
 	}
 }
 
+/*
+ * Fill lookup copy of collision table and lookup replicas from loaded
+ * metadata
+ */
+static void ocf_metadata_hash_lookup_rebuild(ocf_cache_t cache)
+{
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	struct ocf_metadata_hash_lookup_entry entry;
+	const struct ocf_metadata_list_info *info;
+	const struct ocf_metadata_map *collision;
+	ocf_cache_line_t line, index;
+	unsigned char step = 0;
+
+	if (!ctrl->lookup && !ocf_metadata_hash_replicas_count())
+		return;
+
+	for (line = 0; line < ctrl->cachelines; line++) {
+		collision = ocf_metadata_raw_rd_access(cache,
+				&(ctrl->raw_desc[metadata_segment_collision]),
+				line, ctrl->mapping_size);
+		info = ocf_metadata_raw_rd_access(cache,
+				&(ctrl->raw_desc[metadata_segment_list_info]),
+				line, sizeof(*info));
+
+		entry.core_id = collision ? collision->core_id : OCF_CORE_MAX;
+		entry.core_line = collision ?
+				_ocf_metadata_hash_core_line(collision) :
+				ULLONG_MAX;
+		entry.next = info ? info->next_col : ctrl->cachelines;
+
+		if (ctrl->lookup)
+			ctrl->lookup[line] = entry;
+		ocf_metadata_hash_replicas_set(ctrl, line, core_id,
+				entry.core_id);
+		ocf_metadata_hash_replicas_set(ctrl, line, core_line,
+				entry.core_line);
+		ocf_metadata_hash_replicas_set(ctrl, line, next, entry.next);
+
+		OCF_COND_RESCHED(step, 128);
+	}
+
+	for (index = 0; ocf_metadata_hash_replicas_count() &&
+			index < ctrl->raw_desc[metadata_segment_hash].entries;
+			index++) {
+		if (ocf_metadata_raw_get(cache,
+				&(ctrl->raw_desc[metadata_segment_hash]),
+				index, &line, sizeof(line))) {
+			line = ctrl->cachelines;
+		}
+		ocf_metadata_hash_replicas_set_hash(ctrl, index, line);
+
+		OCF_COND_RESCHED(step, 128);
+	}
+}
+
 static void ocf_metadata_hash_load_all_finish(ocf_pipeline_t pipeline,
 		void *priv, int error)
 {
@@ -1453,6 +2196,8 @@ static void ocf_metadata_hash_load_all_finish(ocf_pipeline_t pipeline,
 		goto out;
 	}
 
+	ocf_metadata_hash_lookup_rebuild(cache);
+
 	ocf_cache_log(cache, log_info, "Done loading cache state\n");
 
 out:
@@ -1474,9 +2219,9 @@ struct ocf_pipeline_properties ocf_metadata_hash_load_all_pipeline_props = {
 	.priv_size = sizeof(struct ocf_metadata_hash_context),
 	.finish = ocf_metadata_hash_load_all_finish,
 	.steps = {
-		OCF_PL_STEP_FOREACH(ocf_medatata_hash_load_segment,
+		OCF_PL_STEP_ARG_PTR(ocf_medatata_hash_load_segments,
 				ocf_metadata_hash_load_all_args),
-		OCF_PL_STEP_FOREACH(ocf_medatata_hash_check_crc,
+		OCF_PL_STEP_ARG_PTR(ocf_medatata_hash_check_crc_segments,
 				ocf_metadata_hash_load_all_args),
 		OCF_PL_STEP_TERMINATOR(),
 	},
@@ -1537,8 +2282,7 @@ static void _recovery_rebuild_cline_metadata(struct ocf_cache *cache,
 			part_counters[part_id].cached_clines);
 
 	if (metadata_test_dirty(cache, cache_line)) {
-		env_atomic_inc(&cache->core_runtime_meta[core_id].
-				dirty_clines);
+		ocf_cache_core_dirty_inc(cache, core_id);
 		env_atomic_inc(&cache->core_runtime_meta[core_id].
 				part_counters[part_id].dirty_clines);
 		env_atomic64_cmpxchg(&cache->core_runtime_meta[core_id].
@@ -1546,20 +2290,6 @@ static void _recovery_rebuild_cline_metadata(struct ocf_cache *cache,
 	}
 }
 
-static void _recovery_invalidate_clean_sec(struct ocf_cache *cache,
-		ocf_cache_line_t cline)
-{
-	uint8_t i;
-
-	for (i = ocf_line_start_sector(cache);
-	     i <= ocf_line_end_sector(cache); i++) {
-		if (!metadata_test_dirty_one(cache, cline, i)) {
-			/* Invalidate clear sectors */
-			metadata_clear_valid_sec_one(cache, cline, i);
-		}
-	}
-}
-
 static void _recovery_reset_cline_metadata(struct ocf_cache *cache,
 		ocf_cache_line_t cline)
 {
@@ -1599,8 +2329,10 @@ static void _recovery_rebuild_metadata(ocf_pipeline_t pipeline,
 			/* Rebuild metadata for mapped cache line */
 			_recovery_rebuild_cline_metadata(cache, core_id,
 					core_line, cline);
-			if (dirty_only)
-				_recovery_invalidate_clean_sec(cache, cline);
+			if (dirty_only) {
+				/* Invalidate clear sectors */
+				metadata_invalidate_clean(cache, cline);
+			}
 		} else {
 			/* Reset metadata for not mapped or clean cache line */
 			_recovery_reset_cline_metadata(cache, cline);
@@ -1646,8 +2378,24 @@ ocf_metadata_hash_load_recovery_legacy_pl_props = {
 	},
 };
 
+/*
+ * Collision segment was written by checkpoint of idle cache, so clean cache
+ * lines mapped in it still hold data of their core lines
+ */
+struct ocf_pipeline_properties
+ocf_metadata_hash_load_recovery_checkpoint_pl_props = {
+	.priv_size = sizeof(struct ocf_metadata_hash_context),
+	.finish = ocf_metadata_hash_load_recovery_legacy_finish,
+	.steps = {
+		OCF_PL_STEP_ARG_INT(ocf_medatata_hash_load_segment,
+				metadata_segment_collision),
+		OCF_PL_STEP_ARG_INT(_recovery_rebuild_metadata, false),
+		OCF_PL_STEP_TERMINATOR(),
+	},
+};
+
 static void _ocf_metadata_hash_load_recovery_legacy(ocf_cache_t cache,
-		ocf_metadata_end_t cmpl, void *priv)
+		bool checkpoint, ocf_metadata_end_t cmpl, void *priv)
 {
 	struct ocf_metadata_hash_context *context;
 	ocf_pipeline_t pipeline;
@@ -1655,7 +2403,13 @@ static void _ocf_metadata_hash_load_recovery_legacy(ocf_cache_t cache,
 
 	OCF_DEBUG_TRACE(cache);
 
-	result = ocf_pipeline_create(&pipeline, cache,
+	if (checkpoint) {
+		ocf_cache_log(cache, log_info, "Restoring clean cache lines "
+				"from metadata checkpoint\n");
+	}
+
+	result = ocf_pipeline_create(&pipeline, cache, checkpoint ?
+			&ocf_metadata_hash_load_recovery_checkpoint_pl_props :
 			&ocf_metadata_hash_load_recovery_legacy_pl_props);
 	if (result) {
 		cmpl(priv, result);
@@ -1719,7 +2473,7 @@ static int ocf_metadata_hash_load_atomic_metadata_drain(void *priv,
 
 		line = (sector_addr + i) / ocf_line_sectors(cache);
 		line = ocf_metadata_map_phy2lg(cache, line);
-		pos = (sector_addr + i) % ocf_line_sectors(cache);
+		pos = (sector_addr + i) & ocf_line_sector_mask(cache);
 		core_seq_no = meta.core_seq_no;
 		core_line = meta.core_line;
 
@@ -1827,12 +2581,19 @@ static void _ocf_metadata_hash_load_recovery_atomic(ocf_cache_t cache,
 static void ocf_metadata_hash_load_recovery(ocf_cache_t cache,
 		ocf_metadata_end_t cmpl, void *priv)
 {
+	bool checkpoint = cache->conf_meta->checkpoint_valid;
+
 	OCF_DEBUG_TRACE(cache);
 
-	if (ocf_volume_is_atomic(&cache->device->volume))
+	/* Next superblock written marks checkpoint invalid */
+	cache->conf_meta->checkpoint_valid = 0;
+
+	if (ocf_volume_is_atomic(&cache->device->volume)) {
 		_ocf_metadata_hash_load_recovery_atomic(cache, cmpl, priv);
-	else
-		_ocf_metadata_hash_load_recovery_legacy(cache, cmpl, priv);
+	} else {
+		_ocf_metadata_hash_load_recovery_legacy(cache, checkpoint,
+				cmpl, priv);
+	}
 }
 
 /*******************************************************************************
@@ -1853,7 +2614,7 @@ static void ocf_metadata_hash_get_core_info(struct ocf_cache *cache,
 		if (core_id)
 			*core_id = collision->core_id;
 		if (core_sector)
-			*core_sector = collision->core_line;
+			*core_sector = _ocf_metadata_hash_core_line(collision);
 	} else {
 		ocf_metadata_error(cache);
 
@@ -1881,7 +2642,16 @@ static void ocf_metadata_hash_set_core_info(struct ocf_cache *cache,
 		collisioin->core_line = core_sector;
 	} else {
 		ocf_metadata_error(cache);
+		return;
+	}
+
+	if (ctrl->lookup) {
+		ctrl->lookup[line].core_id = core_id;
+		ctrl->lookup[line].core_line = core_sector;
 	}
+
+	ocf_metadata_hash_replicas_set(ctrl, line, core_id, core_id);
+	ocf_metadata_hash_replicas_set(ctrl, line, core_line, core_sector);
 }
 
 static ocf_core_id_t ocf_metadata_hash_get_core_id(
@@ -1914,7 +2684,7 @@ static uint64_t ocf_metadata_hash_get_core_sector(
 			ctrl->mapping_size);
 
 	if (collision)
-		return collision->core_line;
+		return _ocf_metadata_hash_core_line(collision);
 
 	ocf_metadata_error(cache);
 	return ULLONG_MAX;
@@ -1985,6 +2755,11 @@ static ocf_cache_line_t ocf_metadata_hash_get_hash(
 	int result = 0;
 	struct ocf_metadata_hash_ctrl *ctrl
 		= (struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	const struct ocf_metadata_hash_replica *replica =
+		ocf_metadata_hash_replica(ctrl);
+
+	if (replica)
+		return replica->hash[index];
 
 	result = ocf_metadata_raw_get(cache,
 			&(ctrl->raw_desc[metadata_segment_hash]), index,
@@ -1996,6 +2771,30 @@ static ocf_cache_line_t ocf_metadata_hash_get_hash(
 	return line;
 }
 
+/*
+ * Hash Table - Prefetch
+ */
+static void ocf_metadata_hash_prefetch_hash(struct ocf_cache *cache,
+		ocf_cache_line_t index)
+{
+	const void *entry;
+	struct ocf_metadata_hash_ctrl *ctrl
+		= (struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	const struct ocf_metadata_hash_replica *replica =
+		ocf_metadata_hash_replica(ctrl);
+
+	if (replica) {
+		env_prefetch(&replica->hash[index]);
+		return;
+	}
+
+	entry = ocf_metadata_raw_rd_access(cache,
+			&(ctrl->raw_desc[metadata_segment_hash]), index,
+			sizeof(ocf_cache_line_t));
+	if (entry)
+		env_prefetch(entry);
+}
+
 /*
  * Hash Table - Set
  */
@@ -2010,8 +2809,12 @@ static void ocf_metadata_hash_set_hash(struct ocf_cache *cache,
 			&(ctrl->raw_desc[metadata_segment_hash]), index,
 			&line, sizeof(line));
 
-	if (result)
+	if (result) {
 		ocf_metadata_error(cache);
+		return;
+	}
+
+	ocf_metadata_hash_replicas_set_hash(ctrl, index, line);
 }
 
 /*
@@ -2040,10 +2843,12 @@ static void ocf_metadata_hash_get_cleaning_policy(
 	int result = 0;
 	struct ocf_metadata_hash_ctrl *ctrl
 		= (struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	struct ocf_metadata_raw *raw =
+			&ctrl->raw_desc[metadata_segment_cleaning];
 
-	result = ocf_metadata_raw_get(cache,
-			&(ctrl->raw_desc[metadata_segment_cleaning]), line,
-			cleaning_policy, sizeof(*cleaning_policy));
+	/* Entry holds only the part of union used by policies built in */
+	result = ocf_metadata_raw_get(cache, raw, line, cleaning_policy,
+			raw->entry_size);
 
 	if (result)
 		ocf_metadata_error(cache);
@@ -2059,10 +2864,12 @@ static void ocf_metadata_hash_set_cleaning_policy(
 	int result = 0;
 	struct ocf_metadata_hash_ctrl *ctrl
 		= (struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	struct ocf_metadata_raw *raw =
+			&ctrl->raw_desc[metadata_segment_cleaning];
 
-	result = ocf_metadata_raw_set(cache,
-			&(ctrl->raw_desc[metadata_segment_cleaning]), line,
-			cleaning_policy, sizeof(*cleaning_policy));
+	/* Entry holds only the part of union used by policies built in */
+	result = ocf_metadata_raw_set(cache, raw, line, cleaning_policy,
+			raw->entry_size);
 
 	if (result)
 		ocf_metadata_error(cache);
@@ -2085,7 +2892,8 @@ static void ocf_metadata_hash_get_eviction_policy(
 
 	result = ocf_metadata_raw_get(cache,
 			&(ctrl->raw_desc[metadata_segment_eviction]), line,
-			eviction_policy, sizeof(*eviction_policy));
+			eviction_policy,
+			ctrl->raw_desc[metadata_segment_eviction].entry_size);
 
 	if (result)
 		ocf_metadata_error(cache);
@@ -2104,7 +2912,8 @@ static void ocf_metadata_hash_set_eviction_policy(
 
 	result = ocf_metadata_raw_set(cache,
 			&(ctrl->raw_desc[metadata_segment_eviction]), line,
-			eviction_policy, sizeof(*eviction_policy));
+			eviction_policy,
+			ctrl->raw_desc[metadata_segment_eviction].entry_size);
 
 	if (result)
 		ocf_metadata_error(cache);
@@ -2201,7 +3010,13 @@ static void ocf_metadata_hash_set_collision_info(
 		info->prev_col = prev;
 	} else {
 		ocf_metadata_error(cache);
+		return;
 	}
+
+	if (ctrl->lookup)
+		ctrl->lookup[line].next = next;
+
+	ocf_metadata_hash_replicas_set(ctrl, line, next, next);
 }
 
 static void ocf_metadata_hash_set_collision_next(
@@ -2216,10 +3031,17 @@ static void ocf_metadata_hash_set_collision_next(
 			&(ctrl->raw_desc[metadata_segment_list_info]), line,
 			sizeof(*info));
 
-	if (info)
-		info->next_col = next;
-	else
+	if (!info) {
 		ocf_metadata_error(cache);
+		return;
+	}
+
+	info->next_col = next;
+
+	if (ctrl->lookup)
+		ctrl->lookup[line].next = next;
+
+	ocf_metadata_hash_replicas_set(ctrl, line, next, next);
 }
 
 static void ocf_metadata_hash_set_collision_prev(
@@ -2285,6 +3107,64 @@ static ocf_cache_line_t ocf_metadata_hash_get_collision_next(
 	return cache->device->collision_table_entries;
 }
 
+static ocf_cache_line_t ocf_metadata_hash_get_lookup_info(
+		struct ocf_cache *cache, ocf_cache_line_t line,
+		ocf_core_id_t *core_id, uint64_t *core_line)
+{
+	const struct ocf_metadata_hash_lookup_entry *entry;
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	const struct ocf_metadata_hash_replica *replica =
+		ocf_metadata_hash_replica(ctrl);
+
+	if (replica) {
+		entry = &replica->lookup[line];
+	} else if (ctrl->lookup) {
+		entry = &ctrl->lookup[line];
+	} else {
+		ocf_metadata_hash_get_core_info(cache, line, core_id,
+				core_line);
+		return ocf_metadata_hash_get_collision_next(cache, line);
+	}
+
+	*core_id = entry->core_id;
+	*core_line = entry->core_line;
+
+	return entry->next;
+}
+
+static void ocf_metadata_hash_prefetch_lookup_info(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	const void *collision, *info;
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	const struct ocf_metadata_hash_replica *replica =
+		ocf_metadata_hash_replica(ctrl);
+
+	if (replica) {
+		env_prefetch(&replica->lookup[line]);
+		return;
+	}
+
+	if (ctrl->lookup) {
+		env_prefetch(&ctrl->lookup[line]);
+		return;
+	}
+
+	collision = ocf_metadata_raw_rd_access(cache,
+			&(ctrl->raw_desc[metadata_segment_collision]), line,
+			ctrl->mapping_size);
+	if (collision)
+		env_prefetch(collision);
+
+	info = ocf_metadata_raw_rd_access(cache,
+			&(ctrl->raw_desc[metadata_segment_list_info]), line,
+			sizeof(struct ocf_metadata_list_info));
+	if (info)
+		env_prefetch(info);
+}
+
 static ocf_cache_line_t ocf_metadata_hash_get_collision_prev(
 		struct ocf_cache *cache, ocf_cache_line_t line)
 {
@@ -2324,6 +3204,20 @@ static ocf_part_id_t ocf_metadata_hash_get_partition_id(
 	return PARTITION_DEFAULT;
 }
 
+#if OCF_CONFIG_PARTITION_COUNTERS
+/* Cache lines are not linked into partition lists */
+static ocf_cache_line_t ocf_metadata_hash_get_partition_next(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	return cache->device->collision_table_entries;
+}
+
+static ocf_cache_line_t ocf_metadata_hash_get_partition_prev(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	return cache->device->collision_table_entries;
+}
+#else
 static ocf_cache_line_t ocf_metadata_hash_get_partition_next(
 		struct ocf_cache *cache, ocf_cache_line_t line)
 {
@@ -2359,6 +3253,7 @@ static ocf_cache_line_t ocf_metadata_hash_get_partition_prev(
 	ocf_metadata_error(cache);
 	return PARTITION_DEFAULT;
 }
+#endif
 
 static void ocf_metadata_hash_get_partition_info(
 		struct ocf_cache *cache, ocf_cache_line_t line,
@@ -2376,10 +3271,17 @@ static void ocf_metadata_hash_get_partition_info(
 	if (info) {
 		if (part_id)
 			*part_id = info->partition_id;
+#if OCF_CONFIG_PARTITION_COUNTERS
+		if (next_line)
+			*next_line = cache->device->collision_table_entries;
+		if (prev_line)
+			*prev_line = cache->device->collision_table_entries;
+#else
 		if (next_line)
 			*next_line = info->partition_next;
 		if (prev_line)
 			*prev_line = info->partition_prev;
+#endif
 	} else {
 		ocf_metadata_error(cache);
 		if (part_id)
@@ -2391,6 +3293,19 @@ static void ocf_metadata_hash_get_partition_info(
 	}
 }
 
+#if OCF_CONFIG_PARTITION_COUNTERS
+static void ocf_metadata_hash_set_partition_next(
+		struct ocf_cache *cache, ocf_cache_line_t line,
+		ocf_cache_line_t next_line)
+{
+}
+
+static void ocf_metadata_hash_set_partition_prev(
+		struct ocf_cache *cache, ocf_cache_line_t line,
+		ocf_cache_line_t prev_line)
+{
+}
+#else
 static void ocf_metadata_hash_set_partition_next(
 		struct ocf_cache *cache, ocf_cache_line_t line,
 		ocf_cache_line_t next_line)
@@ -2426,6 +3341,7 @@ static void ocf_metadata_hash_set_partition_prev(
 	else
 		ocf_metadata_error(cache);
 }
+#endif
 
 static void ocf_metadata_hash_set_partition_info(
 		struct ocf_cache *cache, ocf_cache_line_t line,
@@ -2442,13 +3358,52 @@ static void ocf_metadata_hash_set_partition_info(
 
 	if (info) {
 		info->partition_id = part_id;
+#if !OCF_CONFIG_PARTITION_COUNTERS
 		info->partition_next = next_line;
 		info->partition_prev = prev_line;
+#endif
 	} else {
 		ocf_metadata_error(cache);
 	}
 }
 
+#if OCF_CONFIG_ZERO_LINES
+static bool ocf_metadata_hash_get_zero(struct ocf_cache *cache,
+		ocf_cache_line_t line)
+{
+	const struct ocf_metadata_list_info *info;
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+
+	info = ocf_metadata_raw_rd_access(cache,
+			&(ctrl->raw_desc[metadata_segment_list_info]), line,
+			sizeof(*info));
+
+	if (info)
+		return info->zero;
+
+	ocf_metadata_error(cache);
+	return false;
+}
+
+static void ocf_metadata_hash_set_zero(struct ocf_cache *cache,
+		ocf_cache_line_t line, bool zero)
+{
+	struct ocf_metadata_list_info *info;
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+
+	info = ocf_metadata_raw_wr_access(cache,
+			&(ctrl->raw_desc[metadata_segment_list_info]), line,
+			sizeof(*info));
+
+	if (info)
+		info->zero = zero;
+	else
+		ocf_metadata_error(cache);
+}
+#endif
+
 /*******************************************************************************
  * Hash Metadata interface definition
  ******************************************************************************/
@@ -2458,17 +3413,20 @@ static const struct ocf_metadata_iface metadata_hash_iface = {
 	.deinit = ocf_metadata_hash_deinit,
 	.init_variable_size = ocf_metadata_hash_init_variable_size,
 	.deinit_variable_size = ocf_metadata_hash_deinit_variable_size,
-	.init_hash_table = ocf_metadata_hash_init_hash_table,
+	.init_collision = ocf_metadata_hash_init_collision,
 
 	.layout_iface = NULL,
 	.pages = ocf_metadata_hash_pages,
 	.cachelines = ocf_metadata_hash_cachelines,
 	.size_of = ocf_metadata_hash_size_of,
+	.mem_usage = ocf_metadata_hash_mem_usage,
+	.size_estimate = ocf_metadata_hash_size_estimate,
 
 	/*
 	 * Load all, flushing all, etc...
 	 */
 	.flush_all = ocf_metadata_hash_flush_all,
+	.checkpoint = ocf_metadata_hash_checkpoint,
 	.flush_mark = ocf_metadata_hash_flush_mark,
 	.flush_do_asynch = ocf_metadata_hash_flush_do_asynch,
 	.load_all = ocf_metadata_hash_load_all,
@@ -2509,6 +3467,8 @@ static const struct ocf_metadata_iface metadata_hash_iface = {
 	.set_collision_next = ocf_metadata_hash_set_collision_next,
 	.set_collision_prev = ocf_metadata_hash_set_collision_prev,
 	.get_collision_next = ocf_metadata_hash_get_collision_next,
+	.get_lookup_info = ocf_metadata_hash_get_lookup_info,
+	.prefetch_lookup_info = ocf_metadata_hash_prefetch_lookup_info,
 	.get_collision_prev = ocf_metadata_hash_get_collision_prev,
 
 	/*
@@ -2521,6 +3481,10 @@ static const struct ocf_metadata_iface metadata_hash_iface = {
 	.set_partition_next = ocf_metadata_hash_set_partition_next,
 	.set_partition_prev = ocf_metadata_hash_set_partition_prev,
 	.set_partition_info = ocf_metadata_hash_set_partition_info,
+#if OCF_CONFIG_ZERO_LINES
+	.get_zero = ocf_metadata_hash_get_zero,
+	.set_zero = ocf_metadata_hash_set_zero,
+#endif
 
 	/*
 	 * Hash Table
@@ -2528,6 +3492,7 @@ static const struct ocf_metadata_iface metadata_hash_iface = {
 	.get_hash = ocf_metadata_hash_get_hash,
 	.set_hash = ocf_metadata_hash_set_hash,
 	.entries_hash = ocf_metadata_hash_entries_hash,
+	.prefetch_hash = ocf_metadata_hash_prefetch_hash,
 
 	/*
 	 * Cleaning Policy
@@ -2593,6 +3558,9 @@ static void ocf_metadata_hash_init_iface(struct ocf_cache *cache,
 		iface->test_and_set_valid = _ocf_metadata_test_and_set_valid_u8;
 		iface->test_and_clear_valid =
 				_ocf_metadata_test_and_clear_valid_u8;
+		iface->find_dirty = _ocf_metadata_find_dirty_u8;
+		iface->invalidate_clean =
+				_ocf_metadata_invalidate_clean_u8;
 		break;
 
 	case ocf_cache_line_size_8:
@@ -2612,6 +3580,9 @@ static void ocf_metadata_hash_init_iface(struct ocf_cache *cache,
 				_ocf_metadata_test_and_set_valid_u16;
 		iface->test_and_clear_valid =
 				_ocf_metadata_test_and_clear_valid_u16;
+		iface->find_dirty = _ocf_metadata_find_dirty_u16;
+		iface->invalidate_clean =
+				_ocf_metadata_invalidate_clean_u16;
 		break;
 
 	case ocf_cache_line_size_16:
@@ -2631,6 +3602,9 @@ static void ocf_metadata_hash_init_iface(struct ocf_cache *cache,
 				_ocf_metadata_test_and_set_valid_u32;
 		iface->test_and_clear_valid =
 				_ocf_metadata_test_and_clear_valid_u32;
+		iface->find_dirty = _ocf_metadata_find_dirty_u32;
+		iface->invalidate_clean =
+				_ocf_metadata_invalidate_clean_u32;
 		break;
 	case ocf_cache_line_size_32:
 		iface->test_dirty = _ocf_metadata_test_dirty_u64;
@@ -2649,6 +3623,9 @@ static void ocf_metadata_hash_init_iface(struct ocf_cache *cache,
 				_ocf_metadata_test_and_set_valid_u64;
 		iface->test_and_clear_valid =
 				_ocf_metadata_test_and_clear_valid_u64;
+		iface->find_dirty = _ocf_metadata_find_dirty_u64;
+		iface->invalidate_clean =
+				_ocf_metadata_invalidate_clean_u64;
 		break;
 
 	case ocf_cache_line_size_64:
@@ -2668,6 +3645,9 @@ static void ocf_metadata_hash_init_iface(struct ocf_cache *cache,
 				_ocf_metadata_test_and_set_valid_u128;
 		iface->test_and_clear_valid =
 				_ocf_metadata_test_and_clear_valid_u128;
+		iface->find_dirty = _ocf_metadata_find_dirty_u128;
+		iface->invalidate_clean =
+				_ocf_metadata_invalidate_clean_u128;
 		break;
 
 	default:
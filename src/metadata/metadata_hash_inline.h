@@ -0,0 +1,227 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __METADATA_HASH_INLINE_H__
+#define __METADATA_HASH_INLINE_H__
+
+#include "metadata_raw.h"
+
+/*
+ * Core line of collision entry, with reserved value of compact format
+ * extended to ULLONG_MAX
+ */
+static inline uint64_t _ocf_metadata_hash_core_line(
+		const struct ocf_metadata_map *collision)
+{
+	if (collision->core_line == OCF_METADATA_CORE_LINES_MAX)
+		return ULLONG_MAX;
+
+	return collision->core_line;
+}
+
+/*
+ * Packed copy of collision entry fields used by lookup
+ */
+struct ocf_metadata_hash_lookup_entry {
+	uint64_t core_line;
+	ocf_cache_line_t next;
+	ocf_core_id_t core_id;
+};
+
+/*
+ * Lookup data replicated on NUMA node
+ */
+struct ocf_metadata_hash_replica {
+	struct ocf_metadata_hash_lookup_entry *lookup;
+	ocf_cache_line_t *hash;
+};
+
+/*
+ * Hash metadata control structure
+ */
+struct ocf_metadata_hash_ctrl {
+	ocf_cache_line_t cachelines;
+	ocf_cache_line_t start_page;
+	ocf_cache_line_t count_pages;
+	uint32_t device_lines;
+	size_t mapping_size;
+	struct ocf_metadata_raw raw_desc[metadata_segment_max];
+	struct ocf_metadata_hash_lookup_entry *lookup;
+		/*!< Volatile lookup copy of collision table, kept in sync by
+		 * collision and core info setters
+		 */
+#if OCF_CONFIG_METADATA_LOOKUP_NODES > 0
+	struct ocf_metadata_hash_replica replicas[
+			OCF_CONFIG_METADATA_LOOKUP_NODES];
+		/*!< Copies of lookup data placed on NUMA nodes, kept in sync
+		 * by hash, collision and core info setters
+		 */
+	uint32_t replicas_count;
+#endif
+};
+
+/*
+ * Replica of lookup data placed on NUMA node of calling CPU, NULL if there
+ * is none
+ */
+static inline const struct ocf_metadata_hash_replica *
+ocf_metadata_hash_replica(struct ocf_metadata_hash_ctrl *ctrl)
+{
+#if OCF_CONFIG_METADATA_LOOKUP_NODES > 0
+	uint32_t node = env_get_numa_node();
+
+	if (node < ctrl->replicas_count)
+		return &ctrl->replicas[node];
+#endif
+
+	return NULL;
+}
+
+#if OCF_CONFIG_METADATA_INLINE
+/*
+ * Accessors of hash layout read on I/O path, bound at compile time instead
+ * of going through metadata interface. Entries of RAW containers keeping
+ * them in RAM are read in place, other containers are still accessed through
+ * metadata interface.
+ */
+
+static inline const void *ocf_metadata_hash_rd_direct(struct ocf_cache *cache,
+		enum ocf_metadata_segment segment, ocf_cache_line_t line)
+{
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	struct ocf_metadata_raw *raw = &ctrl->raw_desc[segment];
+
+	if (unlikely(!raw->rd_direct))
+		return NULL;
+
+	return raw->mem_pool + (uint64_t)raw->entry_size * line;
+}
+
+static inline ocf_cache_line_t
+ocf_metadata_get_hash(struct ocf_cache *cache, ocf_cache_line_t index)
+{
+	const struct ocf_metadata_hash_replica *replica =
+		ocf_metadata_hash_replica(cache->metadata.iface_priv);
+	const ocf_cache_line_t *entry;
+
+	if (replica)
+		return replica->hash[index];
+
+	entry = ocf_metadata_hash_rd_direct(cache, metadata_segment_hash,
+			index);
+	if (unlikely(!entry))
+		return cache->metadata.iface.get_hash(cache, index);
+
+	return *entry;
+}
+
+static inline ocf_cache_line_t ocf_metadata_get_collision_next(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	const struct ocf_metadata_list_info *info;
+
+	info = ocf_metadata_hash_rd_direct(cache, metadata_segment_list_info,
+			line);
+	if (unlikely(!info))
+		return cache->metadata.iface.get_collision_next(cache, line);
+
+	return info->next_col;
+}
+
+static inline void ocf_metadata_get_core_info(struct ocf_cache *cache,
+		ocf_cache_line_t line, ocf_core_id_t *core_id,
+		uint64_t *core_sector)
+{
+	const struct ocf_metadata_map *collision;
+
+	collision = ocf_metadata_hash_rd_direct(cache,
+			metadata_segment_collision, line);
+	if (unlikely(!collision)) {
+		cache->metadata.iface.get_core_info(cache, line, core_id,
+				core_sector);
+		return;
+	}
+
+	if (core_id)
+		*core_id = collision->core_id;
+	if (core_sector)
+		*core_sector = _ocf_metadata_hash_core_line(collision);
+}
+
+static inline ocf_core_id_t ocf_metadata_get_core_id(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	const struct ocf_metadata_map *collision;
+
+	collision = ocf_metadata_hash_rd_direct(cache,
+			metadata_segment_collision, line);
+	if (unlikely(!collision))
+		return cache->metadata.iface.get_core_id(cache, line);
+
+	return collision->core_id;
+}
+
+static inline ocf_cache_line_t ocf_metadata_get_lookup_info(
+		struct ocf_cache *cache, ocf_cache_line_t line,
+		ocf_core_id_t *core_id, uint64_t *core_line)
+{
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	const struct ocf_metadata_hash_replica *replica =
+		ocf_metadata_hash_replica(ctrl);
+	const struct ocf_metadata_hash_lookup_entry *entry;
+
+	if (replica) {
+		entry = &replica->lookup[line];
+	} else if (ctrl->lookup) {
+		entry = &ctrl->lookup[line];
+	} else {
+		ocf_metadata_get_core_info(cache, line, core_id, core_line);
+		return ocf_metadata_get_collision_next(cache, line);
+	}
+
+	*core_id = entry->core_id;
+	*core_line = entry->core_line;
+
+	return entry->next;
+}
+
+static inline ocf_part_id_t ocf_metadata_get_partition_id(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	const struct ocf_metadata_list_info *info;
+
+	info = ocf_metadata_hash_rd_direct(cache, metadata_segment_list_info,
+			line);
+	if (unlikely(!info))
+		return cache->metadata.iface.get_partition_id(cache, line);
+
+	return info->partition_id;
+}
+
+static inline void ocf_metadata_get_evicition_policy(
+		struct ocf_cache *cache, ocf_cache_line_t line,
+		union eviction_policy_meta *eviction)
+{
+	struct ocf_metadata_hash_ctrl *ctrl =
+		(struct ocf_metadata_hash_ctrl *) cache->metadata.iface_priv;
+	const union eviction_policy_meta *entry;
+
+	entry = ocf_metadata_hash_rd_direct(cache, metadata_segment_eviction,
+			line);
+	if (unlikely(!entry)) {
+		cache->metadata.iface.get_eviction_policy(cache, line,
+				eviction);
+		return;
+	}
+
+	/* Entry keeps only the part of union used by eviction policy */
+	env_memcpy(eviction, sizeof(*eviction), entry,
+			ctrl->raw_desc[metadata_segment_eviction].entry_size);
+}
+#endif
+
+#endif /* __METADATA_HASH_INLINE_H__ */
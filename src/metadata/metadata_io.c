@@ -44,9 +44,50 @@ static struct ocf_io_if meta_restart_if = {
 /*
  * Get max pages for IO
  */
-static uint32_t metadata_io_max_page(ocf_cache_t cache)
+uint32_t metadata_io_max_page(ocf_cache_t cache)
 {
-	return ocf_volume_get_max_io_size(&cache->device->volume) / PAGE_SIZE;
+	uint32_t max_page = ocf_volume_get_max_io_size(
+			&cache->device->volume) / PAGE_SIZE;
+
+	if (OCF_CONFIG_METADATA_IO_MAX_PAGES)
+		max_page = OCF_MIN(max_page, OCF_CONFIG_METADATA_IO_MAX_PAGES);
+
+	return max_page;
+}
+
+/* Atomic metadata reads in flight */
+#define METADATA_IO_ATOMIC_QD 32
+
+/* Limit of atomic metadata buffer of each read */
+#define METADATA_IO_ATOMIC_PAGES 16
+
+static int metadata_io_read_i_atomic_issue(struct ocf_request *req);
+
+static struct ocf_io_if meta_atomic_if = {
+		.read = metadata_io_read_i_atomic_issue,
+		.write = metadata_io_read_i_atomic_issue
+};
+
+/*
+ * Called once slot has nothing more to read, last one completes the scan
+ */
+static void metadata_io_read_i_atomic_put(
+		struct metadata_io_request_atomic_asynch *a_req)
+{
+	ocf_cache_t cache = a_req->cache;
+	uint32_t i;
+
+	if (env_atomic_dec_return(&a_req->req_active))
+		return;
+
+	OCF_DEBUG_MSG(cache, "Asynchronous atomic read completed");
+
+	for (i = 0; i < OCF_MIN(a_req->chunks, METADATA_IO_ATOMIC_QD); i++)
+		ctx_data_free(cache->owner, a_req->reqs[i].data);
+
+	a_req->on_complete(cache, a_req->context, a_req->error);
+
+	env_vfree(a_req);
 }
 
 /*
@@ -54,119 +95,214 @@ static uint32_t metadata_io_max_page(ocf_cache_t cache)
  */
 static void metadata_io_read_i_atomic_end(struct ocf_io *io, int error)
 {
-	struct metadata_io_request_atomic *meta_atom_req = io->priv1;
+	struct metadata_io_request_atomic *request = io->priv1;
+	struct metadata_io_request_atomic_asynch *a_req = request->asynch;
+	ocf_cache_t cache = a_req->cache;
+
+	OCF_DEBUG_TRACE(cache);
+
+	ocf_io_put(io);
+
+	if (!error && !a_req->error) {
+		ctx_data_seek(cache->owner, request->data,
+				ctx_data_seek_begin, 0);
+		error = a_req->on_drain(a_req->context, request->sector,
+				request->count, request->data);
+	}
+
+	if (error) {
+		a_req->error |= error;
+		metadata_io_read_i_atomic_put(a_req);
+		return;
+	}
+
+	/* Issue next chunk from queue, not to recurse on synchronous IO */
+	ocf_engine_push_req_back(&request->fl_req, false);
+}
+
+/*
+ * Read next chunk of atomic metadata into slot
+ */
+static int metadata_io_read_i_atomic_issue(struct ocf_request *req)
+{
+	struct metadata_io_request_atomic *request = req->priv;
+	struct metadata_io_request_atomic_asynch *a_req = request->asynch;
+	ocf_cache_t cache = a_req->cache;
+	uint32_t chunk = env_atomic_inc_return(&a_req->chunk) - 1;
+	struct ocf_io *io;
+	int result;
 
-	OCF_DEBUG_TRACE(ocf_volume_get_cache(io->volume));
+	if (a_req->error || chunk >= a_req->chunks) {
+		metadata_io_read_i_atomic_put(a_req);
+		return 0;
+	}
+
+	request->sector = (uint64_t)chunk * a_req->chunk_sectors;
+	request->count = OCF_MIN((uint64_t)a_req->chunk_sectors,
+			a_req->sectors - request->sector);
+
+	/* Reset position in data buffer */
+	ctx_data_seek(cache->owner, request->data, ctx_data_seek_begin, 0);
 
-	meta_atom_req->error |= error;
-	env_completion_complete(&meta_atom_req->complete);
+	/* Allocate new IO */
+	io = ocf_new_cache_io(cache);
+	if (!io) {
+		result = -OCF_ERR_NO_MEM;
+		goto err;
+	}
+
+	/* Setup IO */
+	ocf_io_configure(io,
+			cache->device->metadata_offset +
+				SECTORS_TO_BYTES(request->sector),
+			SECTORS_TO_BYTES(request->count),
+			OCF_READ, 0, 0);
+	ocf_io_set_cmpl(io, request, NULL, metadata_io_read_i_atomic_end);
+	result = ocf_io_set_data(io, request->data, 0);
+	if (result) {
+		ocf_io_put(io);
+		goto err;
+	}
+
+	/* Submit IO */
+	ocf_volume_submit_metadata(io);
+
+	return 0;
+
+err:
+	a_req->error |= result;
+	metadata_io_read_i_atomic_put(a_req);
+	return 0;
 }
 
 /*
  * Iterative read request
- * TODO: Make this function asynchronous to enable async recovery
- *       in atomic mode.
  */
 int metadata_io_read_i_atomic(ocf_cache_t cache, ocf_queue_t queue,
 		void *context, ocf_metadata_atomic_io_event_t drain_hndl,
 		ocf_metadata_io_end_t compl_hndl)
 {
-	uint64_t i;
-	uint64_t max_sectors_count = PAGE_SIZE / OCF_ATOMIC_METADATA_SIZE;
+	struct metadata_io_request_atomic_asynch *a_req;
+	struct metadata_io_request_atomic *request;
 	uint64_t io_sectors_count = cache->device->collision_table_entries *
 					ocf_line_sectors(cache);
-	uint64_t count, curr_count;
-	int result = 0;
-	struct ocf_io *io;
-	ctx_data_t *data;
-	struct metadata_io_request_atomic meta_atom_req;
-	unsigned char step = 0;
+	uint64_t chunk_sectors;
+	uint32_t chunks, qd, pages, i;
 
 	OCF_DEBUG_TRACE(cache);
 
-	/* Allocate one 4k page for metadata*/
-	data = ctx_data_alloc(cache->owner, 1);
-	if (!data)
+	/*
+	 * Read as much as buffer and cache volume allow at once, in whole
+	 * cache lines so that each one is drained by single callback
+	 */
+	chunk_sectors = OCF_MIN(PAGES_TO_BYTES(METADATA_IO_ATOMIC_PAGES) /
+			OCF_ATOMIC_METADATA_SIZE,
+			BYTES_TO_SECTORS(ocf_volume_get_max_io_size(
+			&cache->device->volume)));
+	chunk_sectors -= chunk_sectors % ocf_line_sectors(cache);
+	chunk_sectors = OCF_MAX(chunk_sectors, ocf_line_sectors(cache));
+
+	chunks = OCF_DIV_ROUND_UP(io_sectors_count, chunk_sectors);
+	qd = OCF_MIN(chunks, METADATA_IO_ATOMIC_QD);
+	pages = OCF_DIV_ROUND_UP(chunk_sectors * OCF_ATOMIC_METADATA_SIZE,
+			PAGE_SIZE);
+
+	if (!chunks) {
+		compl_hndl(cache, context, 0);
+		return 0;
+	}
+
+	a_req = env_vzalloc(sizeof(*a_req) + qd * sizeof(a_req->reqs[0]));
+	if (!a_req)
 		return -OCF_ERR_NO_MEM;
 
-	count = io_sectors_count;
-	for (i = 0; i < io_sectors_count; i += curr_count) {
-		/* Get sectors count of this IO iteration */
-		curr_count = OCF_MIN(max_sectors_count, count);
+	a_req->cache = cache;
+	a_req->context = context;
+	a_req->on_drain = drain_hndl;
+	a_req->on_complete = compl_hndl;
+	a_req->sectors = io_sectors_count;
+	a_req->chunk_sectors = chunk_sectors;
+	a_req->chunks = chunks;
+	env_atomic_set(&a_req->req_active, qd);
+
+	for (i = 0; i < qd; i++) {
+		request = &a_req->reqs[i];
+
+		request->asynch = a_req;
+		request->fl_req.io_if = &meta_atomic_if;
+		request->fl_req.io_queue = queue;
+		request->fl_req.cache = cache;
+		request->fl_req.priv = request;
+		request->fl_req.info.internal = true;
+		request->fl_req.rw = OCF_READ;
 
-		env_completion_init(&meta_atom_req.complete);
-		meta_atom_req.error = 0;
+		/*
+		 * We don't want allocate map for this request in
+		 * threads.
+		 */
+		request->fl_req.map = LIST_POISON1;
 
-		/* Reset position in data buffer */
-		ctx_data_seek(cache->owner, data, ctx_data_seek_begin, 0);
+		request->data = ctx_data_alloc(cache->owner, pages);
+		if (!request->data)
+			goto err;
+	}
 
-		/* Allocate new IO */
-		io = ocf_new_cache_io(cache);
-		if (!io) {
-			result = -OCF_ERR_NO_MEM;
-			break;
-		}
+	OCF_DEBUG_PARAM(cache, "Chunks = %u, sectors = %llu",
+			chunks, (unsigned long long)chunk_sectors);
 
-		/* Setup IO */
-		ocf_io_configure(io,
-				cache->device->metadata_offset +
-					SECTORS_TO_BYTES(i),
-				SECTORS_TO_BYTES(curr_count),
-				OCF_READ, 0, 0);
-		ocf_io_set_cmpl(io, &meta_atom_req, NULL,
-				metadata_io_read_i_atomic_end);
-		result = ocf_io_set_data(io, data, 0);
-		if (result) {
-			ocf_io_put(io);
-			break;
-		}
+	/* Let cache volume batch IOs of this request */
+	ocf_volume_plug(&cache->device->volume);
 
-		/* Submit IO */
-		ocf_volume_submit_metadata(io);
-		ocf_io_put(io);
+	for (i = 0; i < qd; i++)
+		metadata_io_read_i_atomic_issue(&a_req->reqs[i].fl_req);
 
-		/* Wait for completion of IO */
-		env_completion_wait(&meta_atom_req.complete);
+	ocf_volume_unplug(&cache->device->volume);
 
-		/* Check for error */
-		if (meta_atom_req.error) {
-			result = meta_atom_req.error;
-			break;
-		}
+	return 0;
 
-		result |= drain_hndl(cache, i, curr_count, data);
-		if (result)
-			break;
+err:
+	while (i--)
+		ctx_data_free(cache->owner, a_req->reqs[i].data);
+	env_vfree(a_req);
 
-		count -= curr_count;
+	return -OCF_ERR_NO_MEM;
+}
 
-		OCF_COND_RESCHED(step, 128);
-	}
+/*
+ * End IO of request together with requests merged into it
+ */
+static void metadata_io_req_end_merged(struct metadata_io_request *request,
+		int error)
+{
+	struct metadata_io_request *curr, *temp;
 
-	/* Memory free */
-	ctx_data_free(cache->owner, data);
+	metadata_updater_io_done(request->cache);
 
-	compl_hndl(cache, context, result);
+	list_for_each_entry_safe(curr, temp, &request->merged, merged) {
+		list_del(&curr->merged);
+		metadata_io_i_asynch_end(curr, error);
+	}
 
-	return 0;
+	metadata_io_i_asynch_end(request, error);
 }
 
 static void metadata_io_i_asynch_cmpl(struct ocf_io *io, int error)
 {
 	struct metadata_io_request *request = io->priv1;
 
-	metadata_io_i_asynch_end(request, error);
+	metadata_io_req_end_merged(request, error);
 
 	ocf_io_put(io);
 }
 
-static void metadata_io_req_fill(struct metadata_io_request *meta_io_req)
+static void metadata_io_req_fill(struct metadata_io_request *meta_io_req,
+		ctx_data_t *data)
 {
 	ocf_cache_t cache = meta_io_req->cache;
 	int i;
 
 	for (i = 0; i < meta_io_req->count; i++) {
-		meta_io_req->on_meta_fill(cache, meta_io_req->data,
+		meta_io_req->on_meta_fill(cache, data,
 			meta_io_req->page + i, meta_io_req->context);
 	}
 }
@@ -182,37 +318,77 @@ static void metadata_io_req_drain(struct metadata_io_request *meta_io_req)
 	}
 }
 
+/*
+ * Write pages of requests merged by metadata updater with one IO, using
+ * buffer of first of them large enough for all
+ */
+static int ocf_restart_meta_io_merged(struct metadata_io_request *meta_io_req,
+		uint32_t *count)
+{
+	ocf_cache_t cache = meta_io_req->cache;
+	struct metadata_io_request *curr;
+	ctx_data_t *data;
+
+	*count = meta_io_req->count;
+	list_for_each_entry(curr, &meta_io_req->merged, merged)
+		*count += curr->count;
+
+	data = ctx_data_alloc(cache->owner, *count);
+	if (!data)
+		return -OCF_ERR_NO_MEM;
+
+	ctx_data_free(cache->owner, meta_io_req->data);
+	meta_io_req->data = data;
+
+	OCF_METADATA_LOCK_RD();
+	metadata_io_req_fill(meta_io_req, data);
+	list_for_each_entry(curr, &meta_io_req->merged, merged)
+		metadata_io_req_fill(curr, data);
+	OCF_METADATA_UNLOCK_RD();
+
+	return 0;
+}
+
 static int ocf_restart_meta_io(struct ocf_request *req)
 {
 	struct metadata_io_request *meta_io_req = req->priv;
 	ocf_cache_t cache = req->cache;
+	uint32_t count = meta_io_req->count;
 	struct ocf_io *io;
 	int ret;
 
 	cache = req->cache;
 
-	/* Fill with the latest metadata. */
-	OCF_METADATA_LOCK_RD();
-	metadata_io_req_fill(meta_io_req);
-	OCF_METADATA_UNLOCK_RD();
+	if (!list_empty(&meta_io_req->merged)) {
+		ret = ocf_restart_meta_io_merged(meta_io_req, &count);
+		if (ret) {
+			metadata_io_req_end_merged(meta_io_req, ret);
+			return 0;
+		}
+	} else if (req->rw == OCF_WRITE) {
+		/* Fill with the latest metadata. */
+		OCF_METADATA_LOCK_RD();
+		metadata_io_req_fill(meta_io_req, meta_io_req->data);
+		OCF_METADATA_UNLOCK_RD();
+	}
 
 	io = ocf_new_cache_io(cache);
 	if (!io) {
-		metadata_io_i_asynch_end(meta_io_req, -OCF_ERR_NO_MEM);
+		metadata_io_req_end_merged(meta_io_req, -OCF_ERR_NO_MEM);
 		return 0;
 	}
 
 	/* Setup IO */
 	ocf_io_configure(io,
 			PAGES_TO_BYTES(meta_io_req->page),
-			PAGES_TO_BYTES(meta_io_req->count),
-			OCF_WRITE, 0, 0);
+			PAGES_TO_BYTES(count),
+			req->rw, 0, 0);
 
 	ocf_io_set_cmpl(io, meta_io_req, NULL, metadata_io_i_asynch_cmpl);
 	ret = ocf_io_set_data(io, meta_io_req->data, 0);
 	if (ret) {
 		ocf_io_put(io);
-		metadata_io_i_asynch_end(meta_io_req, ret);
+		metadata_io_req_end_merged(meta_io_req, ret);
 		return ret;
 	}
 	ocf_volume_submit_io(io);
@@ -253,7 +429,7 @@ static void metadata_io_i_asynch_end(struct metadata_io_request *request,
 	request->data = NULL;
 
 	if (env_atomic_dec_return(&a_req->req_remaining)) {
-		env_atomic_set(&request->finished, 1);
+		metadata_updater_finish(cache, request);
 		ocf_metadata_updater_kick(cache);
 		return;
 	}
@@ -267,7 +443,7 @@ static void metadata_io_i_asynch_end(struct metadata_io_request *request,
 	 * If it's last request, we mark is as finished
 	 * after calling IO end callback
 	 */
-	env_atomic_set(&request->finished, 1);
+	metadata_updater_finish(cache, request);
 	ocf_metadata_updater_kick(cache);
 }
 
@@ -326,12 +502,14 @@ static int metadata_io_i_asynch(ocf_cache_t cache, ocf_queue_t queue, int dir,
 	/* IO Requests initialization */
 	for (i = 0; i < io_count; i++) {
 		env_atomic_set(&(a_req->reqs[i].req_remaining), 1);
-		env_atomic_set(&(a_req->reqs[i].finished), 0);
 		a_req->reqs[i].asynch = a_req;
 	}
 
 	OCF_DEBUG_PARAM(cache, "IO count = %u", io_count);
 
+	/* Let cache volume batch IOs of this request */
+	ocf_volume_plug(&cache->device->volume);
+
 	i = 0;
 	written = 0;
 	while (count) {
@@ -362,6 +540,7 @@ static int metadata_io_i_asynch(ocf_cache_t cache, ocf_queue_t queue, int dir,
 		a_req->reqs[i].fl_req.map = LIST_POISON1;
 
 		INIT_LIST_HEAD(&a_req->reqs[i].list);
+		INIT_LIST_HEAD(&a_req->reqs[i].merged);
 
 		a_req->reqs[i].data = ctx_data_alloc(cache->owner, curr_count);
 		if (!a_req->reqs[i].data) {
@@ -377,12 +556,15 @@ static int metadata_io_i_asynch(ocf_cache_t cache, ocf_queue_t queue, int dir,
 			io = ocf_new_cache_io(cache);
 			if (!io) {
 				error = -OCF_ERR_NO_MEM;
+				metadata_updater_io_done(cache);
 				metadata_io_req_error(cache, a_req, i, error);
 				break;
 			}
 
-			if (dir == OCF_WRITE)
-				metadata_io_req_fill(&a_req->reqs[i]);
+			if (dir == OCF_WRITE) {
+				metadata_io_req_fill(&a_req->reqs[i],
+						a_req->reqs[i].data);
+			}
 
 			/* Setup IO */
 			ocf_io_configure(io,
@@ -395,6 +577,7 @@ static int metadata_io_i_asynch(ocf_cache_t cache, ocf_queue_t queue, int dir,
 			error = ocf_io_set_data(io, a_req->reqs[i].data, 0);
 			if (error) {
 				ocf_io_put(io);
+				metadata_updater_io_done(cache);
 				metadata_io_req_error(cache, a_req, i, error);
 				break;
 			}
@@ -407,6 +590,8 @@ static int metadata_io_i_asynch(ocf_cache_t cache, ocf_queue_t queue, int dir,
 		i++;
 	}
 
+	ocf_volume_unplug(&cache->device->volume);
+
 	if (error == 0) {
 		/* No error, return 0 that indicates operation successful */
 		return 0;
@@ -39,6 +39,20 @@ typedef int (*ocf_metadata_io_event_t)(ocf_cache_t cache,
 typedef void (*ocf_metadata_io_end_t)(ocf_cache_t cache,
 		void *context, int error);
 
+/**
+ * @brief Metadata read end callback
+ *
+ * @param cache Cache instance
+ * @param sector_addr Begin sector of metadata
+ * @param sector_no Number of sectors
+ * @param data Data environment buffer with atomic metadata
+ *
+ * @retval 0 Success
+ * @retval Non-zero Error which will bee finally returned to the caller
+ */
+typedef int (*ocf_metadata_atomic_io_event_t)(void *priv, uint64_t sector_addr,
+		uint32_t sector_no, ctx_data_t *data);
+
 struct metadata_io_request_asynch;
 
 /*
@@ -55,18 +69,44 @@ struct metadata_io_request {
 	ctx_data_t *data;
 	int error;
 	struct metadata_io_request_asynch *asynch;
-	env_atomic finished;
 
 	struct ocf_request fl_req;
 	struct list_head list;
+	struct list_head finished_list;
+	struct list_head merged;
+		/*!< Requests written with the same IO as this one */
 };
 
+struct metadata_io_request_atomic_asynch;
+
 /*
- * IO request context
+ * Atomic metadata read slot, reads next chunk of cache device each time its
+ * previous one is drained
  */
 struct metadata_io_request_atomic {
-	env_completion complete;
+	struct metadata_io_request_atomic_asynch *asynch;
+	ctx_data_t *data;
+	uint64_t sector;
+	uint32_t count;
+
+	struct ocf_request fl_req;
+};
+
+/*
+ * Asynchronous atomic metadata read context
+ */
+struct metadata_io_request_atomic_asynch {
+	ocf_cache_t cache;
+	void *context;
+	ocf_metadata_atomic_io_event_t on_drain;
+	ocf_metadata_io_end_t on_complete;
+	uint64_t sectors;
+	uint32_t chunk_sectors;
+	uint32_t chunks;
+	env_atomic chunk;
+	env_atomic req_active;
 	int error;
+	struct metadata_io_request_atomic reqs[];
 };
 
 /*
@@ -85,22 +125,21 @@ struct metadata_io_request_asynch {
 };
 
 /**
- * @brief Metadata read end callback
+ * @brief Get max number of pages of single metadata IO
  *
- * @param cache Cache instance
- * @param sector_addr Begin sector of metadata
- * @param sector_no Number of sectors
- * @param data Data environment buffer with atomic metadata
+ * @param cache - Cache instance
  *
- * @retval 0 Success
- * @retval Non-zero Error which will bee finally returned to the caller
+ * @return Max pages count
  */
-typedef int (*ocf_metadata_atomic_io_event_t)(void *priv, uint64_t sector_addr,
-		uint32_t sector_no, ctx_data_t *data);
+uint32_t metadata_io_max_page(ocf_cache_t cache);
 
 /**
  * @brief Iterative asynchronous read atomic metadata
  *
+ * Cache device is read in chunks of whole cache lines, with several chunks
+ * in flight. Drain callback is called from IO completion context, so drains
+ * of different chunks may run in parallel.
+ *
  * @param cache - Cache instance
  * @param queue - Queue to be used for IO
  * @param context - Read context
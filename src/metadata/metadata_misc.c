@@ -5,8 +5,12 @@
 
 #include "ocf/ocf.h"
 #include "metadata.h"
+#include "metadata_core_index.h"
 #include "../utils/utils_cache_line.h"
 
+typedef void (*_ocf_metadata_actor_t)(struct ocf_cache *cache,
+		ocf_cache_line_t cache_line, void *priv);
+
 static bool _is_cache_line_acting(struct ocf_cache *cache,
 		uint32_t cache_line, ocf_core_id_t core_id,
 		uint64_t start_line, uint64_t end_line)
@@ -31,20 +35,45 @@ static bool _is_cache_line_acting(struct ocf_cache *cache,
 	return true;
 }
 
-/*
- * Iterates over cache lines that belong to the core device with
- * core ID = core_id  whose core byte addresses are in the range
- * [start_byte, end_byte] and applies actor(cache, cache_line) to all
- * matching cache lines
- *
- * set partition_id to PARTITION_INVALID to not care about partition_id
- *
- * METADATA lock must be held before calling this function
- */
-int ocf_metadata_actor(struct ocf_cache *cache,
+/* Visit mapped core lines of range found in index of core */
+static int _ocf_metadata_actor_indexed(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_core_id_t core_id,
+		uint64_t start_line, uint64_t end_line,
+		_ocf_metadata_actor_t actor, void *priv)
+{
+	ocf_core_t core = &cache->core[core_id];
+	uint64_t core_line = start_line;
+	uint32_t step = 0;
+	ocf_cache_line_t i;
+	int ret = 0;
+
+	while (ocf_core_index_next(core, &core_line, end_line)) {
+		i = ocf_metadata_lookup_collision(cache, core_id, core_line);
+
+		if (i != cache->device->collision_table_entries &&
+				(part_id == PARTITION_INVALID ||
+				ocf_metadata_get_partition_id(cache, i) ==
+				part_id)) {
+			if (ocf_cache_line_is_used(cache, i))
+				ret = -EAGAIN;
+			else
+				actor(cache, i, priv);
+		}
+
+		if (core_line == end_line)
+			break;
+		core_line++;
+
+		OCF_COND_RESCHED_DEFAULT(step);
+	}
+
+	return ret;
+}
+
+static int _ocf_metadata_actor(struct ocf_cache *cache,
 		ocf_part_id_t part_id, ocf_core_id_t core_id,
 		uint64_t start_byte, uint64_t end_byte,
-		ocf_metadata_actor_t actor)
+		_ocf_metadata_actor_t actor, void *priv)
 {
 	uint32_t step = 0;
 	ocf_cache_line_t i, next_i;
@@ -54,7 +83,13 @@ int ocf_metadata_actor(struct ocf_cache *cache,
 	start_line = ocf_bytes_2_lines(cache, start_byte);
 	end_line = ocf_bytes_2_lines(cache, end_byte);
 
-	if (part_id != PARTITION_INVALID) {
+	if (core_id != OCF_CORE_ID_INVALID &&
+			ocf_core_index_enabled(&cache->core[core_id])) {
+		return _ocf_metadata_actor_indexed(cache, part_id, core_id,
+				start_line, end_line, actor, priv);
+	}
+
+	if (part_id != PARTITION_INVALID && !OCF_CONFIG_PARTITION_COUNTERS) {
 		for (i = cache->user_parts[part_id].runtime->head;
 				i != cache->device->collision_table_entries;
 				i = next_i) {
@@ -65,19 +100,23 @@ int ocf_metadata_actor(struct ocf_cache *cache,
 				if (ocf_cache_line_is_used(cache, i))
 					ret = -EAGAIN;
 				else
-					actor(cache, i);
+					actor(cache, i, priv);
 			}
 
 			OCF_COND_RESCHED_DEFAULT(step);
 		}
 	} else {
+		/* Partitions not linked into lists are found by partition id */
 		for (i = 0; i < cache->device->collision_table_entries; ++i) {
-			if (_is_cache_line_acting(cache, i, core_id,
+			if ((part_id == PARTITION_INVALID ||
+					ocf_metadata_get_partition_id(cache, i) ==
+					part_id) &&
+					_is_cache_line_acting(cache, i, core_id,
 					start_line, end_line)) {
 				if (ocf_cache_line_is_used(cache, i))
 					ret = -EAGAIN;
 				else
-					actor(cache, i);
+					actor(cache, i, priv);
 			}
 
 			OCF_COND_RESCHED_DEFAULT(step);
@@ -87,6 +126,33 @@ int ocf_metadata_actor(struct ocf_cache *cache,
 	return ret;
 }
 
+static void _ocf_metadata_actor_call(struct ocf_cache *cache,
+		ocf_cache_line_t cache_line, void *priv)
+{
+	ocf_metadata_actor_t *actor = priv;
+
+	(*actor)(cache, cache_line);
+}
+
+/*
+ * Iterates over cache lines that belong to the core device with
+ * core ID = core_id  whose core byte addresses are in the range
+ * [start_byte, end_byte] and applies actor(cache, cache_line) to all
+ * matching cache lines
+ *
+ * set partition_id to PARTITION_INVALID to not care about partition_id
+ *
+ * METADATA lock must be held before calling this function
+ */
+int ocf_metadata_actor(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_core_id_t core_id,
+		uint64_t start_byte, uint64_t end_byte,
+		ocf_metadata_actor_t actor)
+{
+	return _ocf_metadata_actor(cache, part_id, core_id, start_byte,
+			end_byte, _ocf_metadata_actor_call, &actor);
+}
+
 /* the caller must hold the relevant cache block concurrency reader lock
  * and the metadata lock
  */
@@ -103,11 +169,34 @@ void ocf_metadata_sparse_cache_line(struct ocf_cache *cache,
 	ocf_metadata_add_to_free_list(cache, cache_line);
 }
 
+/*
+ * Same as ocf_metadata_sparse_cache_line() for group of cache lines, which
+ * are put on free list at once
+ */
+void ocf_metadata_sparse_cache_lines(struct ocf_cache *cache,
+		const ocf_cache_line_t *lines, uint32_t count)
+{
+	ocf_part_id_t partition_id;
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		partition_id = ocf_metadata_get_partition_id(cache, lines[i]);
+
+		ocf_metadata_remove_from_collision(cache, lines[i],
+				partition_id);
+
+		ocf_metadata_remove_from_partition(cache, partition_id,
+				lines[i]);
+	}
+
+	ocf_metadata_add_lines_to_free_list(cache, lines, count);
+}
+
 static void _ocf_metadata_sparse_cache_line(struct ocf_cache *cache,
-		uint32_t cache_line)
+		uint32_t cache_line, void *priv)
 {
-	set_cache_line_invalid_no_flush(cache, 0, ocf_line_end_sector(cache),
-			cache_line);
+	set_cache_line_invalid_no_flush_batch(cache, 0,
+			ocf_line_end_sector(cache), cache_line, priv);
 
 	/*
 	 * This is especially for removing inactive core
@@ -121,6 +210,15 @@ static void _ocf_metadata_sparse_cache_line(struct ocf_cache *cache,
 int ocf_metadata_sparse_range(struct ocf_cache *cache, int core_id,
 			  uint64_t start_byte, uint64_t end_byte)
 {
-	return ocf_metadata_actor(cache, PARTITION_INVALID, core_id,
-		start_byte, end_byte, _ocf_metadata_sparse_cache_line);
+	struct ocf_invalidate_batch batch;
+	int ret;
+
+	ocf_invalidate_batch_init(&batch);
+
+	ret = _ocf_metadata_actor(cache, PARTITION_INVALID, core_id,
+		start_byte, end_byte, _ocf_metadata_sparse_cache_line, &batch);
+
+	ocf_invalidate_batch_flush(cache, &batch);
+
+	return ret;
 }
@@ -7,25 +7,116 @@
 #define __METADATA_MISC_H__
 
 /*
- * Hash function needs number that has no common factors with both number
- * of cores and number of entries in metadata hash container (hash lists).
- * This can be easily achived by picking prime which is bigger than maximum
- * number of cores and ensuring that count of hash table entries is not
- * divisible by this number. Let's choose 4099, which is smallest prime
- * greater than OCF_CORE_MAX (which is 4096).
+ * Number of hash table entries is power of two, so that bucket is selected
+ * with mask instead of division. Core line and core id are combined and
+ * mixed with 64-bit finalizer (as in xxhash/murmur3), which spreads strided
+ * core lines and lines of different cores over all bits used for the mask.
+ * Core id is shifted above bits used by realistic core line numbers.
  */
-#define OCF_HASH_PRIME 4099
+#define OCF_HASH_CORE_ID_SHIFT 48
+
+static inline uint64_t ocf_metadata_hash_key(uint64_t core_line_num,
+		ocf_core_id_t core_id)
+{
+	uint64_t key = core_line_num ^
+			((uint64_t)core_id << OCF_HASH_CORE_ID_SHIFT);
+
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+
+	return key;
+}
 
 static inline ocf_cache_line_t ocf_metadata_hash_func(ocf_cache_t cache,
 		uint64_t core_line_num, ocf_core_id_t core_id)
 {
-	return (ocf_cache_line_t) ((core_line_num * OCF_HASH_PRIME + core_id) %
-			cache->device->hash_table_entries);
+	return (ocf_cache_line_t) (ocf_metadata_hash_key(core_line_num,
+			core_id) & (cache->device->hash_table_entries - 1));
 }
 
+#if OCF_CONFIG_LOOKUP_FILTER
+/*
+ * Lookup filter keeps 16 four bit counters per hash bucket, counting core
+ * lines in bucket chain by fingerprint taken from top bits of hash key, which
+ * are not used to select bucket. Core line whose counter is zero is not
+ * mapped, so its lookup doesn't have to walk the chain. Counter which
+ * reached its maximum is never decremented. Filter of bucket is protected by
+ * bucket lock.
+ */
+#define OCF_LOOKUP_FILTER_SHIFT(core_line, core_id) \
+	((ocf_metadata_hash_key(core_line, core_id) >> 60) * 4)
+
+#define OCF_LOOKUP_FILTER_MAX 0xfULL
+
+static inline bool ocf_metadata_lookup_filter_test(struct ocf_cache *cache,
+		ocf_cache_line_t hash, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+	return (cache->device->lookup_filter[hash] >>
+			OCF_LOOKUP_FILTER_SHIFT(core_line, core_id)) &
+			OCF_LOOKUP_FILTER_MAX;
+}
+
+static inline void ocf_metadata_lookup_filter_add(struct ocf_cache *cache,
+		ocf_cache_line_t hash, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+	uint64_t *filter = &cache->device->lookup_filter[hash];
+	uint32_t shift = OCF_LOOKUP_FILTER_SHIFT(core_line, core_id);
+
+	if (((*filter >> shift) & OCF_LOOKUP_FILTER_MAX) !=
+			OCF_LOOKUP_FILTER_MAX) {
+		*filter += 1ULL << shift;
+	}
+}
+
+static inline void ocf_metadata_lookup_filter_remove(struct ocf_cache *cache,
+		ocf_cache_line_t hash, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+	uint64_t *filter = &cache->device->lookup_filter[hash];
+	uint32_t shift = OCF_LOOKUP_FILTER_SHIFT(core_line, core_id);
+	uint64_t count = (*filter >> shift) & OCF_LOOKUP_FILTER_MAX;
+
+	if (count && count != OCF_LOOKUP_FILTER_MAX)
+		*filter -= 1ULL << shift;
+}
+
+void ocf_metadata_lookup_filter_rebuild(struct ocf_cache *cache);
+#else
+static inline bool ocf_metadata_lookup_filter_test(struct ocf_cache *cache,
+		ocf_cache_line_t hash, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+	return true;
+}
+
+static inline void ocf_metadata_lookup_filter_add(struct ocf_cache *cache,
+		ocf_cache_line_t hash, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+}
+
+static inline void ocf_metadata_lookup_filter_remove(struct ocf_cache *cache,
+		ocf_cache_line_t hash, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+}
+
+static inline void ocf_metadata_lookup_filter_rebuild(struct ocf_cache *cache)
+{
+}
+#endif
+
 void ocf_metadata_sparse_cache_line(struct ocf_cache *cache,
 		ocf_cache_line_t cache_line);
 
+void ocf_metadata_sparse_cache_lines(struct ocf_cache *cache,
+		const ocf_cache_line_t *lines, uint32_t count);
+
 int ocf_metadata_sparse_range(struct ocf_cache *cache, int core_id,
 			uint64_t start_byte, uint64_t end_byte);
 
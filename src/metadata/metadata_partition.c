@@ -6,16 +6,294 @@
 #include "ocf/ocf.h"
 #include "metadata.h"
 #include "../utils/utils_part.h"
+#include "../utils/utils_trim.h"
 
-/* Sets the given collision_index as the new _head_ of the Partition list. */
-static void update_partition_head(struct ocf_cache *cache,
-		ocf_part_id_t part_id, ocf_cache_line_t line)
+#if OCF_CONFIG_FREE_MAP
+static inline void ocf_free_map_set(struct ocf_cache *cache,
+		ocf_cache_line_t line)
 {
-	struct ocf_user_part *part = &cache->user_parts[part_id];
+	ocf_cache_line_t phy = ocf_metadata_map_lg2phy(cache, line);
 
-	part->runtime->head = line;
+	cache->device->free_map.bits[phy / 64] |= 1ULL << (phy % 64);
+}
+
+static inline void ocf_free_map_clear(struct ocf_cache *cache,
+		ocf_cache_line_t line)
+{
+	ocf_cache_line_t phy = ocf_metadata_map_lg2phy(cache, line);
+
+	cache->device->free_map.bits[phy / 64] &= ~(1ULL << (phy % 64));
+	ocf_trim_unmark(cache, phy);
+}
+
+#if OCF_CONFIG_PARTITION_COUNTERS
+/*
+ * Free list is the free map itself, while free list size is set up in bulk
+ * when metadata is initialized or loaded, so map is rebuilt from cache lines
+ * which are not mapped and are within cache capacity. Free list emptied on
+ * purpose, e.g. by background discard, stays empty.
+ */
+void ocf_metadata_free_map_rebuild(struct ocf_cache *cache)
+{
+	struct ocf_part *free_list = cache->device->freelist_part;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_cache_line_t line, phy;
+	uint32_t step = 0;
+
+	env_memset(cache->device->free_map.bits, sizeof(uint64_t) *
+			OCF_DIV_ROUND_UP(line_entries, 64), 0);
+	cache->device->free_map.cursor = 0;
+
+	if (free_list->curr_size) {
+		free_list->curr_size = 0;
+
+		for (line = 0; line < line_entries; line++) {
+			phy = ocf_metadata_map_lg2phy(cache, line);
+			if (phy < cache->device->lines_limit &&
+					ocf_metadata_get_core_id(cache, line) ==
+					OCF_CORE_MAX) {
+				ocf_free_map_set(cache, line);
+				free_list->curr_size++;
+			}
+			OCF_COND_RESCHED_DEFAULT(step);
+		}
+	}
+
+	ocf_trim_reset(cache);
 }
+#else
+/*
+ * Free map is kept in sync by free list primitives, but free list is set up
+ * in bulk when metadata is initialized or loaded, so map has to be rebuilt
+ * from the list afterwards.
+ */
+void ocf_metadata_free_map_rebuild(struct ocf_cache *cache)
+{
+	struct ocf_part *free_list = cache->device->freelist_part;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_cache_line_t line = free_list->head;
+	uint32_t i;
+
+	env_memset(cache->device->free_map.bits, sizeof(uint64_t) *
+			OCF_DIV_ROUND_UP(line_entries, 64), 0);
+	cache->device->free_map.cursor = 0;
+
+	for (i = 0; i < free_list->curr_size; i++) {
+		ENV_BUG_ON(line >= line_entries);
+
+		ocf_free_map_set(cache, line);
+		ocf_metadata_get_partition_info(cache, line, NULL, &line, NULL);
+	}
+
+	ocf_trim_reset(cache);
+}
+#endif
+
+bool ocf_metadata_free_map_test(struct ocf_cache *cache,
+		ocf_cache_line_t phy)
+{
+	return cache->device->free_map.bits[phy / 64] & (1ULL << (phy % 64));
+}
+
+/* Number of bitmap words or whole word groups checked by single free
+ * super-line or log segment search
+ */
+#define OCF_FREE_MAP_SCAN_WORDS 64
+
+/*
+ * Finds group of free physical cache lines spanning whole bitmap words,
+ * starting at word aligned to the group size
+ */
+static ocf_cache_line_t ocf_metadata_free_map_find_words(
+		struct ocf_cache *cache, uint32_t lines)
+{
+	struct ocf_cache_device *device = cache->device;
+	uint32_t words = OCF_DIV_ROUND_UP(device->collision_table_entries, 64);
+	uint32_t group = lines / 64, groups = words / group;
+	uint32_t i, g, w;
+
+	if (!groups)
+		return device->collision_table_entries;
+
+	for (i = 0; i < OCF_MIN(groups, OCF_FREE_MAP_SCAN_WORDS); i++) {
+		g = (device->free_map.cursor / group + i) % groups;
+
+		for (w = g * group; w < (g + 1) * group; w++) {
+			if (device->free_map.bits[w] != ~0ULL)
+				break;
+		}
+
+		if (w == (g + 1) * group) {
+			device->free_map.cursor = g * group;
+			return g * lines;
+		}
+	}
+
+	device->free_map.cursor = ((device->free_map.cursor / group + i) %
+			groups) * group;
+
+	return device->collision_table_entries;
+}
+
+/*
+ * Finds aligned group of free physical cache lines, size of group being power
+ * of two. Search starts where previous one ended and is bounded, so it may
+ * miss free groups on fragmented cache.
+ *
+ * Returns first physical cache line of group or collision_table_entries
+ * if none was found.
+ */
+ocf_cache_line_t ocf_metadata_free_map_find(struct ocf_cache *cache,
+		uint32_t lines)
+{
+	struct ocf_cache_device *device = cache->device;
+	uint32_t words = OCF_DIV_ROUND_UP(device->collision_table_entries, 64);
+	uint64_t aligned, run;
+	uint32_t i, s, w;
+
+	if (!words)
+		return device->collision_table_entries;
+
+	if (lines > 64)
+		return ocf_metadata_free_map_find_words(cache, lines);
+
+	/* Bits at positions which are multiples of lines */
+	aligned = lines == 64 ? 1 : ~0ULL / ((1ULL << lines) - 1);
+
+	for (i = 0; i < OCF_MIN(words, OCF_FREE_MAP_SCAN_WORDS); i++) {
+		w = (device->free_map.cursor + i) % words;
 
+		/* Bit stays set if it starts run of lines set bits */
+		run = device->free_map.bits[w];
+		for (s = 1; s < lines && run; s *= 2)
+			run &= run >> s;
+
+		run &= aligned;
+		if (run) {
+			device->free_map.cursor = w;
+			return w * 64 + __builtin_ctzll(run);
+		}
+	}
+
+	device->free_map.cursor = (device->free_map.cursor + i) % words;
+
+	return device->collision_table_entries;
+}
+
+/*
+ * Counts free cache lines in aligned group of physical cache lines, size of
+ * group being power of two
+ */
+uint32_t ocf_metadata_free_map_count(struct ocf_cache *cache,
+		ocf_cache_line_t phy, uint32_t lines)
+{
+	uint64_t *bits = cache->device->free_map.bits;
+	uint32_t w, count = 0;
+
+	if (lines < 64) {
+		return __builtin_popcountll((bits[phy / 64] >> (phy % 64)) &
+				((1ULL << lines) - 1));
+	}
+
+	for (w = phy / 64; w < (phy + lines) / 64; w++)
+		count += __builtin_popcountll(bits[w]);
+
+	return count;
+}
+#else
+#define ocf_free_map_set(cache, line)
+#define ocf_free_map_clear(cache, line)
+#endif
+
+#if OCF_CONFIG_PARTITION_COUNTERS
+/*
+ * Free list is kept only in free map and its size, cache lines on free list
+ * are not linked.
+ */
+void ocf_metadata_remove_from_free_list(struct ocf_cache *cache,
+		ocf_cache_line_t cline)
+{
+	struct ocf_part *free_list = cache->device->freelist_part;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+
+	ENV_BUG_ON(cline >= line_entries);
+	ENV_BUG_ON(!free_list->curr_size);
+
+	ocf_metadata_set_partition_info(cache, cline, PARTITION_INVALID,
+			line_entries, line_entries);
+
+	free_list->curr_size--;
+	ocf_free_map_clear(cache, cline);
+}
+
+void ocf_metadata_add_to_free_list(struct ocf_cache *cache,
+		ocf_cache_line_t line)
+{
+	struct ocf_part *free_list = cache->device->freelist_part;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_cache_line_t phy;
+
+	ENV_BUG_ON(line >= line_entries);
+
+	ocf_metadata_set_partition_info(cache, line, PARTITION_INVALID,
+			line_entries, line_entries);
+
+	/* Cache line beyond cache capacity is retired */
+	phy = ocf_metadata_map_lg2phy(cache, line);
+	if (phy >= cache->device->lines_limit)
+		return;
+
+	free_list->curr_size++;
+	ocf_free_map_set(cache, line);
+	ocf_trim_mark(cache, phy);
+}
+
+void ocf_metadata_add_lines_to_free_list(struct ocf_cache *cache,
+		const ocf_cache_line_t *lines, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+		ocf_metadata_add_to_free_list(cache, lines[i]);
+}
+
+/*
+ * Takes up to count free cache lines in physical order, starting at the word
+ * of free map where previous search ended.
+ *
+ * Returns number of cache lines taken.
+ */
+uint32_t ocf_metadata_take_from_free_list(struct ocf_cache *cache,
+		ocf_cache_line_t *lines, uint32_t count)
+{
+	struct ocf_cache_device *device = cache->device;
+	struct ocf_part *free_list = device->freelist_part;
+	uint32_t words = OCF_DIV_ROUND_UP(device->collision_table_entries, 64);
+	uint32_t w = device->free_map.cursor;
+	uint64_t free;
+	uint32_t i;
+
+	count = OCF_MIN(count, free_list->curr_size);
+
+	for (i = 0; i < count; ) {
+		free = device->free_map.bits[w];
+		if (!free) {
+			w = (w + 1) % words;
+			continue;
+		}
+
+		lines[i] = ocf_metadata_map_phy2lg(cache,
+				w * 64 + __builtin_ctzll(free));
+		ocf_free_map_clear(cache, lines[i]);
+		i++;
+	}
+
+	device->free_map.cursor = w;
+	free_list->curr_size -= count;
+
+	return count;
+}
+#else
 void ocf_metadata_remove_from_free_list(struct ocf_cache *cache,
 		ocf_cache_line_t cline)
 {
@@ -75,6 +353,7 @@ void ocf_metadata_remove_from_free_list(struct ocf_cache *cache,
 	}
 
 	free_list->curr_size--;
+	ocf_free_map_clear(cache, cline);
 }
 
 void ocf_metadata_add_to_free_list(struct ocf_cache *cache,
@@ -87,6 +366,14 @@ void ocf_metadata_add_to_free_list(struct ocf_cache *cache,
 
 	ENV_BUG_ON(line >= line_entries);
 
+	if (ocf_metadata_map_lg2phy(cache, line) >=
+			cache->device->lines_limit) {
+		/* Cache line is beyond cache capacity, retire it */
+		ocf_metadata_set_partition_info(cache, line, invalid_part_id,
+				line_entries, line_entries);
+		return;
+	}
+
 	if (free_list->curr_size == 0) {
 		free_list->head = line;
 		free_list->tail = line;
@@ -106,8 +393,183 @@ void ocf_metadata_add_to_free_list(struct ocf_cache *cache,
 	}
 
 	free_list->curr_size++;
+	ocf_free_map_set(cache, line);
+	ocf_trim_mark(cache, ocf_metadata_map_lg2phy(cache, line));
+}
+
+/*
+ * Adds cache lines to the tail of free list at once. Cache lines are linked
+ * to each other as they go, each link is written once, and free list is
+ * updated only after the whole chain is spliced onto it.
+ */
+void ocf_metadata_add_lines_to_free_list(struct ocf_cache *cache,
+		const ocf_cache_line_t *lines, uint32_t count)
+{
+	struct ocf_part *free_list = cache->device->freelist_part;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_part_id_t invalid_part_id = PARTITION_INVALID;
+	ocf_cache_line_t prev, last = line_entries;
+	ocf_cache_line_t line, phy;
+	uint32_t added = 0;
+	uint32_t i;
+
+	prev = free_list->curr_size ? free_list->tail : line_entries;
+
+	for (i = 0; i < count; i++) {
+		line = lines[i];
+
+		ENV_BUG_ON(line >= line_entries);
+
+		phy = ocf_metadata_map_lg2phy(cache, line);
+
+		/* Cache line is beyond cache capacity, retire it */
+		if (phy >= cache->device->lines_limit) {
+			ocf_metadata_set_partition_info(cache, line,
+					invalid_part_id, line_entries,
+					line_entries);
+			continue;
+		}
+
+		if (last != line_entries) {
+			ocf_metadata_set_partition_info(cache, last,
+					invalid_part_id, line, prev);
+			prev = last;
+		} else if (prev != line_entries) {
+			ocf_metadata_set_partition_next(cache, prev, line);
+		} else {
+			free_list->head = line;
+		}
+
+		last = line;
+		added++;
+
+		ocf_free_map_set(cache, line);
+		ocf_trim_mark(cache, phy);
+	}
+
+	if (!added)
+		return;
+
+	ocf_metadata_set_partition_info(cache, last, invalid_part_id,
+			line_entries, prev);
+
+	free_list->tail = last;
+	free_list->curr_size += added;
+}
+
+/*
+ * Takes up to count cache lines from the head of free list at once. Links of
+ * taken cache lines are left stale, they have to be set when cache lines are
+ * put on a list again.
+ *
+ * Returns number of cache lines taken.
+ */
+uint32_t ocf_metadata_take_from_free_list(struct ocf_cache *cache,
+		ocf_cache_line_t *lines, uint32_t count)
+{
+	struct ocf_part *free_list = cache->device->freelist_part;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	ocf_cache_line_t line = free_list->head;
+	uint32_t i;
+
+	count = OCF_MIN(count, free_list->curr_size);
+
+	for (i = 0; i < count; i++) {
+		ENV_BUG_ON(line >= line_entries);
+
+		lines[i] = line;
+		ocf_free_map_clear(cache, line);
+		ocf_metadata_get_partition_info(cache, line, NULL, &line, NULL);
+	}
+
+	if (count == free_list->curr_size) {
+		free_list->head = line_entries;
+		free_list->tail = line_entries;
+	} else if (count) {
+		free_list->head = line;
+		ocf_metadata_set_partition_prev(cache, line, line_entries);
+	}
+
+	free_list->curr_size -= count;
+
+	return count;
+}
+#endif
+
+#if OCF_CONFIG_PARTITION_COUNTERS
+/*
+ * Partition membership is kept only in partition id of cache line, partition
+ * list head stays empty and only occupancy counter of partition is updated.
+ */
+static void ocf_metadata_partition_grow(struct ocf_cache *cache,
+		ocf_part_id_t part_id, uint32_t count)
+{
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+
+	if (!part->runtime->curr_size && !ocf_part_is_valid(part)) {
+		/* Partition becomes not empty, and is not valid
+		 * update list of partitions
+		 */
+		ocf_part_sort(cache);
+	}
+
+	part->runtime->curr_size += count;
+	ocf_part_evict_update(cache, part);
+}
+
+void ocf_metadata_add_to_partition(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_cache_line_t line)
+{
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+
+	ENV_BUG_ON(!(line < line_entries));
+
+	ocf_metadata_set_partition_info(cache, line, part_id,
+			line_entries, line_entries);
+
+	ocf_metadata_partition_grow(cache, part_id, 1);
 }
 
+/* Cache lines of the chain have to be already assigned to the partition */
+void ocf_metadata_add_chain_to_partition(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_cache_line_t first,
+		ocf_cache_line_t last, uint32_t count)
+{
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+
+	ENV_BUG_ON(!(first < line_entries));
+	ENV_BUG_ON(!(last < line_entries));
+
+	ocf_metadata_partition_grow(cache, part_id, count);
+}
+
+void ocf_metadata_remove_from_partition(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_cache_line_t line)
+{
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+
+	ENV_BUG_ON(!(line < cache->device->collision_table_entries));
+	ENV_BUG_ON(!part->runtime->curr_size);
+
+	if (part->runtime->curr_size == 1 && !ocf_part_is_valid(part)) {
+		/* Partition becomes empty, and is not valid
+		 * update list of partitions
+		 */
+		ocf_part_sort(cache);
+	}
+
+	part->runtime->curr_size--;
+	ocf_part_evict_update(cache, part);
+}
+#else
+/* Sets the given collision_index as the new _head_ of the Partition list. */
+static void update_partition_head(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_cache_line_t line)
+{
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+
+	part->runtime->head = line;
+}
 
 /* Adds the given collision_index to the _head_ of the Partition list */
 void ocf_metadata_add_to_partition(struct ocf_cache *cache,
@@ -148,6 +610,50 @@ void ocf_metadata_add_to_partition(struct ocf_cache *cache,
 	}
 
 	part->runtime->curr_size++;
+	ocf_part_evict_update(cache, part);
+}
+
+/*
+ * Adds chain of cache lines to the _head_ of the Partition list at once.
+ * Cache lines of the chain have to be already linked to each other and
+ * assigned to the partition, with no previous node of the first one.
+ */
+void ocf_metadata_add_chain_to_partition(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_cache_line_t first,
+		ocf_cache_line_t last, uint32_t count)
+{
+	ocf_cache_line_t line_head;
+	ocf_cache_line_t line_entries = cache->device->collision_table_entries;
+	struct ocf_user_part *part = &cache->user_parts[part_id];
+
+	ENV_BUG_ON(!(first < line_entries));
+	ENV_BUG_ON(!(last < line_entries));
+
+	if (!part->runtime->curr_size) {
+		ocf_metadata_set_partition_next(cache, last, line_entries);
+
+		update_partition_head(cache, part_id, first);
+
+		if (!ocf_part_is_valid(part)) {
+			/* Partition becomes empty, and is not valid
+			 * update list of partitions
+			 */
+			ocf_part_sort(cache);
+		}
+	} else {
+		line_head = part->runtime->head;
+
+		ENV_BUG_ON(!(line_head < line_entries));
+
+		ocf_metadata_set_partition_next(cache, last, line_head);
+
+		ocf_metadata_set_partition_prev(cache, line_head, last);
+
+		update_partition_head(cache, part_id, first);
+	}
+
+	part->runtime->curr_size += count;
+	ocf_part_evict_update(cache, part);
 }
 
 /* Deletes the node with the given collision_index from the Partition list */
@@ -224,4 +730,6 @@ void ocf_metadata_remove_from_partition(struct ocf_cache *cache,
 	}
 
 	part->runtime->curr_size--;
+	ocf_part_evict_update(cache, part);
 }
+#endif
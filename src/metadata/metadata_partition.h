@@ -13,11 +13,13 @@
 #define PARTITION_INVALID		((ocf_part_id_t)-1)
 #define PARTITION_SIZE_MAX		((ocf_cache_line_t)-1)
 
+#if !OCF_CONFIG_METADATA_INLINE
 static inline ocf_part_id_t ocf_metadata_get_partition_id(
 		struct ocf_cache *cache, ocf_cache_line_t line)
 {
 	return cache->metadata.iface.get_partition_id(cache, line);
 }
+#endif
 
 static inline ocf_cache_line_t ocf_metadata_get_partition_next(
 		struct ocf_cache *cache, ocf_cache_line_t line)
@@ -63,15 +65,57 @@ static inline void ocf_metadata_set_partition_info(
 			next_line, prev_line);
 }
 
+#if OCF_CONFIG_ZERO_LINES
+/* Valid sectors of zero line hold zeroes, cache device data is not used */
+static inline bool ocf_metadata_get_zero(struct ocf_cache *cache,
+		ocf_cache_line_t line)
+{
+	return cache->metadata.iface.get_zero(cache, line);
+}
+
+static inline void ocf_metadata_set_zero(struct ocf_cache *cache,
+		ocf_cache_line_t line, bool zero)
+{
+	cache->metadata.iface.set_zero(cache, line, zero);
+}
+#endif
+
 void ocf_metadata_add_to_free_list(struct ocf_cache *cache,
 		ocf_cache_line_t cline);
 
+void ocf_metadata_add_lines_to_free_list(struct ocf_cache *cache,
+		const ocf_cache_line_t *lines, uint32_t count);
+
 void ocf_metadata_remove_from_free_list(struct ocf_cache *cache,
 		ocf_cache_line_t cline);
 
+uint32_t ocf_metadata_take_from_free_list(struct ocf_cache *cache,
+		ocf_cache_line_t *lines, uint32_t count);
+
+#if OCF_CONFIG_FREE_MAP
+void ocf_metadata_free_map_rebuild(struct ocf_cache *cache);
+
+bool ocf_metadata_free_map_test(struct ocf_cache *cache,
+		ocf_cache_line_t phy);
+
+ocf_cache_line_t ocf_metadata_free_map_find(struct ocf_cache *cache,
+		uint32_t lines);
+
+uint32_t ocf_metadata_free_map_count(struct ocf_cache *cache,
+		ocf_cache_line_t phy, uint32_t lines);
+#else
+static inline void ocf_metadata_free_map_rebuild(struct ocf_cache *cache)
+{
+}
+#endif
+
 void ocf_metadata_add_to_partition(struct ocf_cache *cache,
 		ocf_part_id_t part_id, ocf_cache_line_t line);
 
+void ocf_metadata_add_chain_to_partition(struct ocf_cache *cache,
+		ocf_part_id_t part_id, ocf_cache_line_t first,
+		ocf_cache_line_t last, uint32_t count);
+
 void ocf_metadata_remove_from_partition(struct ocf_cache *cache,
 		ocf_part_id_t part_id, ocf_cache_line_t line);
 
@@ -39,11 +39,98 @@ struct ocf_user_part_runtime {
         struct cleaning_policy cleaning;
 };
 
+#define OCF_PART_SUPER_RECENT 4
+
+struct ocf_part_super_line {
+        uint64_t group;
+        ocf_cache_line_t base;
+        ocf_core_id_t core_id;
+};
+
+/*
+ * Token bucket limiting cache device bandwidth used by partition for
+ * backfill and cleaning
+ */
+struct ocf_part_qos {
+        uint64_t rate;
+                /*!< Bytes per second, 0 if partition is not limited */
+
+        uint64_t burst;
+                /*!< Most bytes that can be accumulated in bucket */
+
+        env_atomic64 tokens;
+                /*!< Bytes available, negative once bucket is overdrawn */
+
+        env_atomic64 refill_ticks;
+                /*!< Time of last refill */
+};
+
 struct ocf_user_part {
         struct ocf_user_part_config *config;
         struct ocf_user_part_runtime *runtime;
 
         struct ocf_lst_entry lst_valid;
+
+        uint16_t evict_rank;
+                /*!< Position of partition in eviction plan */
+
+        env_atomic ghost_hits;
+                /*!< Misses of core lines recently evicted from partition */
+
+        env_atomic ghost_target;
+                /*!< Occupancy target set from ghost hits in adaptive mode */
+
+        uint8_t dirty_high;
+                /*!< Dirty ratio at which cleaning goes full speed, in
+                 * percent of partition size, 0 if watermarks are disabled
+                 */
+
+        uint8_t dirty_low;
+                /*!< Dirty ratio at which cleaning starts ramping up */
+
+        struct ocf_part_qos qos;
+
+#if OCF_CONFIG_SUPER_LINE_MAX > 0
+        uint8_t super_line;
+                /*!< Number of cache lines in super-line, 0 if disabled */
+
+        uint8_t super_recent_next;
+        struct ocf_part_super_line super_recent[OCF_PART_SUPER_RECENT];
+                /*!< Recently started super-lines, so that requests
+                 * continuing core line group of previous request map it to
+                 * the same group of cache lines
+                 */
+#endif
+};
+
+/*
+ * Snapshot of IO class configuration needed to route I/O, published as a
+ * whole by ocf_part_class_map_publish()
+ */
+struct ocf_part_class_map {
+        ocf_part_id_t part_id[OCF_IO_CLASS_MAX];
+                /*!< Partition of each IO class */
+
+        ocf_cache_mode_t cache_mode[OCF_IO_CLASS_MAX];
+                /*!< Cache mode of each partition */
+};
+
+#define OCF_PART_EVICT_RANK_NONE (OCF_IO_CLASS_MAX + 1)
+
+#define OCF_PART_EVICT_MAP_BITS (sizeof(unsigned long) * 8)
+#define OCF_PART_EVICT_MAP_WORDS ((OCF_PART_EVICT_RANK_NONE + \
+                OCF_PART_EVICT_MAP_BITS - 1) / OCF_PART_EVICT_MAP_BITS)
+
+/*
+ * Eviction plan keeps partitions in order of eviction, as sorted on
+ * partition list, and a bitmap telling which of them have cache lines above
+ * minimum size. Bitmap is updated as partitions grow and shrink, so looking
+ * for eviction candidates doesn't touch partitions having nothing to evict.
+ */
+struct ocf_part_evict_plan {
+        ocf_part_id_t order[OCF_PART_EVICT_RANK_NONE];
+        unsigned long evictable[OCF_PART_EVICT_MAP_WORDS];
+        uint16_t count;
 };
 
 
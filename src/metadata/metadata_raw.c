@@ -8,6 +8,7 @@
 #include "metadata_raw.h"
 #include "metadata_io.h"
 #include "metadata_raw_atomic.h"
+#include "../utils/utils_sort.h"
 #include "../ocf_def_priv.h"
 
 #define OCF_METADATA_RAW_DEBUG 0
@@ -69,6 +70,66 @@ static bool _raw_ssd_page_is_valid(struct ocf_metadata_raw *raw, uint32_t page)
 
 
 
+static int _raw_ram_flush_combine_init(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw);
+
+static void _raw_ram_flush_combine_deinit(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw);
+
+#define RAW_RAM_HUGE_POOL_MIN	(2 * MiB)
+
+#define _RAW_RAM_MODIFIED_MAP_SIZE(raw) \
+		(OCF_DIV_ROUND_UP((raw)->ssd_pages, 8 * sizeof(unsigned long)) * \
+		sizeof(unsigned long))
+
+/* Per cache line metadata is accessed only through RAW interface, so its
+ * modified pages can be tracked
+ */
+static inline bool _raw_ram_tracks_modified(struct ocf_metadata_raw *raw)
+{
+	return OCF_CONFIG_METADATA_FLUSH_MODIFIED_ONLY &&
+			raw->raw_type != metadata_raw_type_volatile &&
+			raw->raw_type != metadata_raw_type_pmem &&
+			raw->metadata_segment >=
+				metadata_segment_variable_size_start;
+}
+
+static void *_raw_ram_mem_pool_alloc(struct ocf_metadata_raw *raw,
+		size_t size)
+{
+	void *mem_pool = NULL;
+
+	if ((OCF_CONFIG_METADATA_HUGE_PAGES ||
+			OCF_CONFIG_METADATA_NUMA_INTERLEAVE) &&
+			size >= RAW_RAM_HUGE_POOL_MIN) {
+		mem_pool = env_vzalloc_huge(size);
+	}
+
+	/* Huge pages are faulted in lazily, so placement still applies */
+	if (OCF_CONFIG_METADATA_NUMA_INTERLEAVE && mem_pool)
+		env_numa_interleave(mem_pool, size);
+
+	raw->mem_pool_huge = !!mem_pool;
+	if (!mem_pool)
+		mem_pool = env_vzalloc(size);
+
+	return mem_pool;
+}
+
+static void _raw_ram_mem_pool_free(struct ocf_metadata_raw *raw)
+{
+	if (!raw->mem_pool)
+		return;
+
+	if (raw->mem_pool_huge)
+		env_vfree_huge(raw->mem_pool, raw->mem_pool_limit);
+	else
+		env_vfree(raw->mem_pool);
+
+	raw->mem_pool = NULL;
+	raw->mem_pool_huge = false;
+}
+
 /*
  * RAM Implementation - De-Initialize
  */
@@ -77,9 +138,13 @@ static int _raw_ram_deinit(ocf_cache_t cache,
 {
 	OCF_DEBUG_TRACE(cache);
 
-	if (raw->mem_pool) {
-		env_vfree(raw->mem_pool);
-		raw->mem_pool = NULL;
+	_raw_ram_mem_pool_free(raw);
+
+	_raw_ram_flush_combine_deinit(cache, raw);
+
+	if (raw->modified_map) {
+		env_vfree(raw->modified_map);
+		raw->modified_map = NULL;
 	}
 
 	return 0;
@@ -99,10 +164,32 @@ static int _raw_ram_init(ocf_cache_t cache,
 	mem_pool_size = raw->ssd_pages;
 	mem_pool_size *= PAGE_SIZE;
 	raw->mem_pool_limit = mem_pool_size;
-	raw->mem_pool = env_vzalloc(mem_pool_size);
+	raw->mem_pool = _raw_ram_mem_pool_alloc(raw, mem_pool_size);
 	if (!raw->mem_pool)
 		return -ENOMEM;
 
+	/* Content of device is not known yet, so all pages are initially
+	 * modified
+	 */
+	if (_raw_ram_tracks_modified(raw)) {
+		raw->modified_map = env_vmalloc(_RAW_RAM_MODIFIED_MAP_SIZE(raw));
+		if (!raw->modified_map) {
+			_raw_ram_mem_pool_free(raw);
+			return -ENOMEM;
+		}
+		ENV_BUG_ON(env_memset(raw->modified_map,
+				_RAW_RAM_MODIFIED_MAP_SIZE(raw), 0xff));
+	}
+
+	/* Only RAM container flushes pages of particular requests */
+	if (raw->raw_type != metadata_raw_type_ram)
+		return 0;
+
+	if (_raw_ram_flush_combine_init(cache, raw)) {
+		_raw_ram_deinit(cache, raw);
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
@@ -117,6 +204,15 @@ static size_t _raw_ram_size_of(ocf_cache_t cache,
 	size = raw->ssd_pages;
 	size *= PAGE_SIZE;
 
+	if (_raw_ram_tracks_modified(raw))
+		size += _RAW_RAM_MODIFIED_MAP_SIZE(raw);
+
+	/* Map of pages pending in combined flush */
+	if (OCF_CONFIG_METADATA_FLUSH_COMBINE_PAGES &&
+			raw->raw_type == metadata_raw_type_ram) {
+		size += _RAW_RAM_MODIFIED_MAP_SIZE(raw);
+	}
+
 	return size;
 }
 
@@ -142,7 +238,7 @@ static uint32_t _raw_ram_checksum(ocf_cache_t cache,
 	uint32_t crc = 0;
 
 	for (i = 0; i < raw->ssd_pages; i++) {
-		crc = env_crc32(crc, raw->mem_pool + PAGE_SIZE * i, PAGE_SIZE);
+		crc = METADATA_CRC(crc, raw->mem_pool + PAGE_SIZE * i, PAGE_SIZE);
 		OCF_COND_RESCHED(step, 10000);
 	}
 
@@ -182,6 +278,8 @@ static void *_raw_ram_wr_access(ocf_cache_t cache,
 {
 	ENV_BUG_ON(!_raw_is_valid(raw, line, size));
 
+	ocf_metadata_raw_mark_modified(raw, line);
+
 	return _RAW_RAM_ADDR(raw, line);
 }
 
@@ -194,6 +292,8 @@ static int _raw_ram_set(ocf_cache_t cache,
 {
 	ENV_BUG_ON(!_raw_is_valid(raw, line, size));
 
+	ocf_metadata_raw_mark_modified(raw, line);
+
 	return _RAW_RAM_SET(raw, line, data);
 }
 
@@ -234,6 +334,13 @@ static void _raw_ram_load_all_complete(ocf_cache_t cache,
 		void *priv, int error)
 {
 	struct _raw_ram_load_all_context *context = priv;
+	struct ocf_metadata_raw *raw = context->raw;
+
+	/* Memory matches device now */
+	if (!error && raw->modified_map) {
+		ENV_BUG_ON(env_memset(raw->modified_map,
+				_RAW_RAM_MODIFIED_MAP_SIZE(raw), 0));
+	}
 
 	context->cmpl(context->priv, error);
 	env_vfree(context);
@@ -271,8 +378,23 @@ struct _raw_ram_flush_all_context {
 	struct ocf_metadata_raw *raw;
 	ocf_metadata_end_t cmpl;
 	void *priv;
+	env_atomic remaining;
+		/*!< Ranges of modified pages being written */
+	int error;
 };
 
+/*
+ * Range of modified pages written by flush of all pages
+ */
+struct _raw_ram_flush_all_range {
+	struct _raw_ram_flush_all_context *context;
+	uint32_t first;
+	uint32_t count;
+};
+
+/* Unmodified pages between modified ones written anyway to save IOs */
+#define RAW_RAM_FLUSH_MODIFIED_GAP	16
+
 /*
  * RAM Implementation - Flush IO callback - Fill page
  */
@@ -308,6 +430,125 @@ static void _raw_ram_flush_all_complete(ocf_cache_t cache,
 	env_vfree(context);
 }
 
+static int _raw_ram_flush_all_range_fill(ocf_cache_t cache,
+		ctx_data_t *data, uint32_t page, void *priv)
+{
+	struct _raw_ram_flush_all_range *range = priv;
+
+	return _raw_ram_flush_all_fill(cache, data, page, range->context);
+}
+
+static void _raw_ram_flush_all_range_put(
+		struct _raw_ram_flush_all_context *context)
+{
+	if (!env_atomic_dec_and_test(&context->remaining))
+		return;
+
+	context->cmpl(context->priv, context->error);
+	env_vfree(context);
+}
+
+static void _raw_ram_flush_all_range_complete(ocf_cache_t cache,
+		void *priv, int error)
+{
+	struct _raw_ram_flush_all_range *range = priv;
+	struct _raw_ram_flush_all_context *context = range->context;
+	struct ocf_metadata_raw *raw = context->raw;
+	uint32_t i;
+
+	if (error) {
+		/* Pages have to be written again by next flush */
+		for (i = range->first; i < range->first + range->count; i++)
+			env_bit_set(i, raw->modified_map);
+		context->error = error;
+	}
+
+	env_vfree(range);
+	_raw_ram_flush_all_range_put(context);
+}
+
+static int _raw_ram_flush_all_range(ocf_cache_t cache,
+		struct _raw_ram_flush_all_context *context,
+		uint32_t first, uint32_t count)
+{
+	struct ocf_metadata_raw *raw = context->raw;
+	struct _raw_ram_flush_all_range *range;
+	uint32_t i;
+	int result;
+
+	range = env_vmalloc(sizeof(*range));
+	if (!range)
+		return -OCF_ERR_NO_MEM;
+
+	range->context = context;
+	range->first = first;
+	range->count = count;
+
+	/* Modification during write marks page again */
+	for (i = first; i < first + count; i++)
+		env_bit_clear(i, raw->modified_map);
+
+	env_atomic_inc(&context->remaining);
+
+	result = metadata_io_write_i_asynch(cache, cache->mngt_queue, range,
+			raw->ssd_pages_offset + first, count,
+			_raw_ram_flush_all_range_fill,
+			_raw_ram_flush_all_range_complete);
+	if (result)
+		_raw_ram_flush_all_range_complete(cache, range, result);
+
+	return 0;
+}
+
+/*
+ * Write only modified pages, coalescing ranges separated by short runs of
+ * unmodified pages
+ */
+static void _raw_ram_flush_all_modified(ocf_cache_t cache,
+		struct _raw_ram_flush_all_context *context)
+{
+	struct ocf_metadata_raw *raw = context->raw;
+	uint32_t page, first = 0, last = 0, written = 0;
+	bool in_range = false;
+	int result = 0;
+
+	env_atomic_set(&context->remaining, 1);
+	context->error = 0;
+
+	for (page = 0; page < raw->ssd_pages && !result; page++) {
+		if (!env_bit_test(page, raw->modified_map))
+			continue;
+
+		if (in_range && page - last <= RAW_RAM_FLUSH_MODIFIED_GAP) {
+			last = page;
+			continue;
+		}
+
+		if (in_range) {
+			result = _raw_ram_flush_all_range(cache, context,
+					first, last - first + 1);
+			written += last - first + 1;
+		}
+
+		first = last = page;
+		in_range = true;
+	}
+
+	if (in_range && !result) {
+		result = _raw_ram_flush_all_range(cache, context, first,
+				last - first + 1);
+		written += last - first + 1;
+	}
+
+	OCF_DEBUG_PARAM(cache, "Modified pages written = %u of %" ENV_PRIu64,
+			written, raw->ssd_pages);
+
+	if (result)
+		context->error = result;
+
+	_raw_ram_flush_all_range_put(context);
+}
+
 /*
  * RAM Implementation - Flush all elements
  */
@@ -329,6 +570,11 @@ static void _raw_ram_flush_all(ocf_cache_t cache, struct ocf_metadata_raw *raw,
 	context->cmpl = cmpl;
 	context->priv = priv;
 
+	if (raw->modified_map) {
+		_raw_ram_flush_all_modified(cache, context);
+		return;
+	}
+
 	result = metadata_io_write_i_asynch(cache, cache->mngt_queue, context,
 			raw->ssd_pages_offset, raw->ssd_pages,
 			_raw_ram_flush_all_fill, _raw_ram_flush_all_complete);
@@ -358,6 +604,36 @@ struct _raw_ram_flush_ctx {
 	ocf_req_end_t complete;
 	env_atomic flush_req_cnt;
 	int error;
+	struct list_head list;
+		/*!< Entry of combined write batch waiters */
+};
+
+/*
+ * Combined write batch. Pages marked by all waiters are written once, after
+ * waiters updated their metadata, and waiters are completed when all pages
+ * are on the cache device.
+ */
+struct raw_ram_flush_batch {
+	struct ocf_metadata_raw *raw;
+	struct list_head waiters;
+	uint32_t *pages;
+	uint32_t pages_no;
+	env_atomic flush_req_cnt;
+	int error;
+};
+
+/*
+ * At most one batch is written at a time. Requests flushing meanwhile join
+ * the pending batch, so that page dirtied by many of them is written once.
+ */
+struct raw_ram_flush_combine {
+	env_spinlock lock;
+	bool in_flight;
+	uint32_t pending;
+		/*!< Index of batch collecting pages */
+	unsigned long *pending_map;
+		/*!< Pages already added to pending batch */
+	struct raw_ram_flush_batch batch[2];
 };
 
 static void _raw_ram_flush_do_asynch_io_complete(ocf_cache_t cache,
@@ -375,6 +651,8 @@ static void _raw_ram_flush_do_asynch_io_complete(ocf_cache_t cache,
 
 	OCF_DEBUG_MSG(cache, "Asynchronous flushing complete");
 
+	ocf_cache_flush_gen_inc(cache);
+
 	/* Call metadata flush completed call back */
 	ctx->req->error |= ctx->error;
 	ctx->complete(ctx->req, ctx->error);
@@ -382,23 +660,13 @@ static void _raw_ram_flush_do_asynch_io_complete(ocf_cache_t cache,
 	env_free(ctx);
 }
 
-/*
- * RAM Implementation - Flush IO callback - Fill page
- */
-static int _raw_ram_flush_do_asynch_fill(ocf_cache_t cache,
-		ctx_data_t *data, uint32_t page, void *context)
+static void _raw_ram_flush_fill_page(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw, ctx_data_t *data, uint32_t page)
 {
 	ocf_cache_line_t line;
 	uint32_t raw_page;
-	struct _raw_ram_flush_ctx *ctx = context;
-	struct ocf_metadata_raw *raw = NULL;
 	uint64_t size;
 
-	ENV_BUG_ON(!ctx);
-
-	raw = ctx->raw;
-	ENV_BUG_ON(!raw);
-
 	size = raw->entry_size * raw->entries_in_page;
 	ENV_BUG_ON(size > PAGE_SIZE);
 
@@ -409,6 +677,20 @@ static int _raw_ram_flush_do_asynch_fill(ocf_cache_t cache,
 
 	ctx_data_wr_check(cache->owner, data, _RAW_RAM_ADDR(raw, line), size);
 	ctx_data_zero_check(cache->owner, data, PAGE_SIZE - size);
+}
+
+/*
+ * RAM Implementation - Flush IO callback - Fill page
+ */
+static int _raw_ram_flush_do_asynch_fill(ocf_cache_t cache,
+		ctx_data_t *data, uint32_t page, void *context)
+{
+	struct _raw_ram_flush_ctx *ctx = context;
+
+	ENV_BUG_ON(!ctx);
+	ENV_BUG_ON(!ctx->raw);
+
+	_raw_ram_flush_fill_page(cache, ctx->raw, data, page);
 
 	return 0;
 }
@@ -417,6 +699,11 @@ static int _raw_ram_flush_do_asynch_fill(ocf_cache_t cache,
  * RAM RAM Implementation - Do Flush
  */
 
+uint64_t _raw_ram_flush_do_page_key(const void *item, uint32_t key)
+{
+	return *(uint32_t *)item;
+}
+
 int _raw_ram_flush_do_page_cmp(const void *item1, const void *item2)
 {
 	uint32_t *page1 = (uint32_t *)item1;
@@ -449,17 +736,287 @@ static void __raw_ram_flush_do_asynch_add_pages(struct ocf_request *req,
 	*pages_to_flush = j;
 }
 
+/*
+ * Sort pages and write each run of consecutive pages with single metadata
+ * IO. Each IO takes reference on flush_req_cnt.
+ */
+static int __raw_ram_flush_do_asynch_write(ocf_cache_t cache,
+		ocf_queue_t queue, struct ocf_metadata_raw *raw,
+		uint32_t *pages_tab, int pages_to_flush, void *context,
+		env_atomic *flush_req_cnt, ocf_metadata_io_event_t fill,
+		ocf_metadata_io_end_t complete)
+{
+	uint32_t start_page = 0;
+	uint32_t count = 0;
+	int result = 0, i;
+
+	ocf_sort(pages_tab, pages_to_flush, sizeof(*pages_tab), 1,
+			_raw_ram_flush_do_page_key, _raw_ram_flush_do_page_cmp,
+			NULL);
+
+	i = 0;
+	while (i < pages_to_flush) {
+		start_page = pages_tab[i];
+		count = 1;
+
+		while (true) {
+			if ((i + 1) >= pages_to_flush)
+				break;
+
+			if (pages_tab[i] == pages_tab[i + 1]) {
+				i++;
+				continue;
+			}
+
+			if ((pages_tab[i] + 1) != pages_tab[i + 1])
+				break;
+
+			i++;
+			count++;
+		}
+
+
+		env_atomic_inc(flush_req_cnt);
+
+		result  |= metadata_io_write_i_asynch(cache, queue, context,
+				raw->ssd_pages_offset + start_page, count,
+				fill, complete);
+
+		if (result)
+			break;
+
+		i++;
+	}
+
+	return result;
+}
+
+#if OCF_CONFIG_METADATA_FLUSH_COMBINE_PAGES
+static int _raw_ram_flush_combine_init(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw)
+{
+	struct raw_ram_flush_combine *fc;
+	int i;
+
+	fc = env_vzalloc(sizeof(*fc));
+	if (!fc)
+		return -ENOMEM;
+
+	fc->pending_map = env_vzalloc(OCF_DIV_ROUND_UP(raw->ssd_pages,
+			sizeof(unsigned long) * 8) * sizeof(unsigned long));
+	if (!fc->pending_map)
+		goto err;
+
+	for (i = 0; i < 2; i++) {
+		fc->batch[i].raw = raw;
+		INIT_LIST_HEAD(&fc->batch[i].waiters);
+		fc->batch[i].pages = env_vzalloc(sizeof(uint32_t) *
+				OCF_CONFIG_METADATA_FLUSH_COMBINE_PAGES);
+		if (!fc->batch[i].pages)
+			goto err;
+	}
+
+	env_spinlock_init(&fc->lock);
+	raw->flush_combine = fc;
+
+	return 0;
+
+err:
+	env_vfree(fc->batch[0].pages);
+	env_vfree(fc->batch[1].pages);
+	env_vfree(fc->pending_map);
+	env_vfree(fc);
+	return -ENOMEM;
+}
+
+static void _raw_ram_flush_combine_deinit(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw)
+{
+	struct raw_ram_flush_combine *fc = raw->flush_combine;
+
+	if (!fc)
+		return;
+
+	ENV_BUG_ON(fc->in_flight);
+
+	env_vfree(fc->batch[0].pages);
+	env_vfree(fc->batch[1].pages);
+	env_vfree(fc->pending_map);
+	env_vfree(fc);
+	raw->flush_combine = NULL;
+}
+
+/*
+ * Swap batches, pending batch is going to be written. The caller must hold
+ * combine lock.
+ */
+static struct raw_ram_flush_batch *_raw_ram_flush_combine_take(
+		struct raw_ram_flush_combine *fc)
+{
+	struct raw_ram_flush_batch *batch = &fc->batch[fc->pending];
+	uint32_t i;
+
+	for (i = 0; i < batch->pages_no; i++)
+		env_bit_clear(batch->pages[i], fc->pending_map);
+
+	fc->pending ^= 1;
+	fc->in_flight = true;
+
+	return batch;
+}
+
+static void _raw_ram_flush_batch_issue(ocf_cache_t cache,
+		ocf_queue_t queue, struct raw_ram_flush_batch *batch);
+
+static void _raw_ram_flush_batch_io_complete(ocf_cache_t cache,
+		void *context, int error)
+{
+	struct raw_ram_flush_batch *batch = context;
+	struct raw_ram_flush_combine *fc = batch->raw->flush_combine;
+	struct _raw_ram_flush_ctx *ctx, *tmp;
+	struct list_head waiters;
+	ocf_queue_t queue;
+
+	if (error) {
+		batch->error = error;
+		ocf_metadata_error(cache);
+	}
+
+	if (env_atomic_dec_return(&batch->flush_req_cnt))
+		return;
+
+	OCF_DEBUG_MSG(cache, "Combined flushing complete");
+
+	ocf_cache_flush_gen_inc(cache);
+
+	INIT_LIST_HEAD(&waiters);
+	list_for_each_entry_safe(ctx, tmp, &batch->waiters, list)
+		list_move_tail(&ctx->list, &waiters);
+	error = batch->error;
+	batch->error = 0;
+	batch->pages_no = 0;
+
+	/* Write next batch if any request joined it meanwhile */
+	env_spinlock_lock(&fc->lock);
+	if (list_empty(&fc->batch[fc->pending].waiters)) {
+		fc->in_flight = false;
+		batch = NULL;
+	} else {
+		batch = _raw_ram_flush_combine_take(fc);
+		ctx = list_first_entry(&batch->waiters,
+				struct _raw_ram_flush_ctx, list);
+		queue = ctx->req->io_queue;
+	}
+	env_spinlock_unlock(&fc->lock);
+
+	list_for_each_entry_safe(ctx, tmp, &waiters, list) {
+		list_del(&ctx->list);
+		ctx->req->error |= error;
+		ctx->complete(ctx->req, error);
+		env_free(ctx);
+	}
+
+	if (batch)
+		_raw_ram_flush_batch_issue(cache, queue, batch);
+}
+
+static int _raw_ram_flush_batch_fill(ocf_cache_t cache,
+		ctx_data_t *data, uint32_t page, void *context)
+{
+	struct raw_ram_flush_batch *batch = context;
+
+	_raw_ram_flush_fill_page(cache, batch->raw, data, page);
+
+	return 0;
+}
+
+static void _raw_ram_flush_batch_issue(ocf_cache_t cache,
+		ocf_queue_t queue, struct raw_ram_flush_batch *batch)
+{
+	int result;
+
+	env_atomic_set(&batch->flush_req_cnt, 1);
+
+	result = __raw_ram_flush_do_asynch_write(cache, queue, batch->raw,
+			batch->pages, batch->pages_no, batch,
+			&batch->flush_req_cnt, _raw_ram_flush_batch_fill,
+			_raw_ram_flush_batch_io_complete);
+
+	_raw_ram_flush_batch_io_complete(cache, batch, result);
+}
+
+/*
+ * Add pages of request to pending batch and start writing it, unless other
+ * batch is being written. Returns -ENOSPC if pages don't fit into batch.
+ */
+static int _raw_ram_flush_combine(ocf_cache_t cache,
+		struct ocf_request *req, struct _raw_ram_flush_ctx *ctx,
+		uint32_t *pages_tab, int pages_to_flush)
+{
+	struct raw_ram_flush_combine *fc = ctx->raw->flush_combine;
+	struct raw_ram_flush_batch *batch;
+	int i;
+
+	env_spinlock_lock(&fc->lock);
+
+	batch = &fc->batch[fc->pending];
+	if (batch->pages_no + pages_to_flush >
+			OCF_CONFIG_METADATA_FLUSH_COMBINE_PAGES) {
+		env_spinlock_unlock(&fc->lock);
+		return -ENOSPC;
+	}
+
+	for (i = 0; i < pages_to_flush; i++) {
+		if (env_bit_test(pages_tab[i], fc->pending_map))
+			continue;
+
+		env_bit_set(pages_tab[i], fc->pending_map);
+		batch->pages[batch->pages_no++] = pages_tab[i];
+	}
+
+	list_add_tail(&ctx->list, &batch->waiters);
+
+	if (fc->in_flight)
+		batch = NULL;
+	else
+		batch = _raw_ram_flush_combine_take(fc);
+
+	env_spinlock_unlock(&fc->lock);
+
+	if (batch)
+		_raw_ram_flush_batch_issue(cache, req->io_queue, batch);
+
+	return 0;
+}
+#else
+static int _raw_ram_flush_combine_init(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw)
+{
+	return 0;
+}
+
+static void _raw_ram_flush_combine_deinit(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw)
+{
+}
+
+static inline int _raw_ram_flush_combine(ocf_cache_t cache,
+		struct ocf_request *req, struct _raw_ram_flush_ctx *ctx,
+		uint32_t *pages_tab, int pages_to_flush)
+{
+	return -ENOSPC;
+}
+#endif
+
 static int _raw_ram_flush_do_asynch(ocf_cache_t cache,
 		struct ocf_request *req, struct ocf_metadata_raw *raw,
 		ocf_req_end_t complete)
 {
-	int result = 0, i;
+	int result = 0;
 	uint32_t __pages_tab[MAX_STACK_TAB_SIZE];
 	uint32_t *pages_tab;
 	int line_no = req->core_line_count;
 	int pages_to_flush;
-	uint32_t start_page = 0;
-	uint32_t count = 0;
 	struct _raw_ram_flush_ctx *ctx;
 
 	ENV_BUG_ON(!complete);
@@ -501,46 +1058,18 @@ static int _raw_ram_flush_do_asynch(ocf_cache_t cache,
 	__raw_ram_flush_do_asynch_add_pages(req, pages_tab, raw,
 			&pages_to_flush);
 
-	env_sort(pages_tab, pages_to_flush, sizeof(*pages_tab),
-			_raw_ram_flush_do_page_cmp, NULL);
-
-	i = 0;
-	while (i < pages_to_flush) {
-		start_page = pages_tab[i];
-		count = 1;
-
-		while (true) {
-			if ((i + 1) >= pages_to_flush)
-				break;
-
-			if (pages_tab[i] == pages_tab[i + 1]) {
-				i++;
-				continue;
-			}
-
-			if ((pages_tab[i] + 1) != pages_tab[i + 1])
-				break;
-
-			i++;
-			count++;
-		}
-
-
-		env_atomic_inc(&ctx->flush_req_cnt);
-
-		result  |= metadata_io_write_i_asynch(cache, req->io_queue, ctx,
-				raw->ssd_pages_offset + start_page, count,
+	if (!raw->flush_combine || _raw_ram_flush_combine(cache, req, ctx,
+			pages_tab, pages_to_flush)) {
+		/* Write pages of this request on its own */
+		result = __raw_ram_flush_do_asynch_write(cache, req->io_queue,
+				raw, pages_tab, pages_to_flush, ctx,
+				&ctx->flush_req_cnt,
 				_raw_ram_flush_do_asynch_fill,
 				_raw_ram_flush_do_asynch_io_complete);
 
-		if (result)
-			break;
-
-		i++;
+		_raw_ram_flush_do_asynch_io_complete(cache, ctx, result);
 	}
 
-	_raw_ram_flush_do_asynch_io_complete(cache, ctx, result);
-
 	if (line_no > MAX_STACK_TAB_SIZE)
 		env_free(pages_tab);
 
@@ -552,6 +1081,7 @@ static int _raw_ram_flush_do_asynch(ocf_cache_t cache,
  ******************************************************************************/
 #include "metadata_raw_dynamic.h"
 #include "metadata_raw_volatile.h"
+#include "metadata_raw_pmem.h"
 
 static const struct raw_iface IRAW[metadata_raw_type_max] = {
 	[metadata_raw_type_ram] = {
@@ -614,6 +1144,21 @@ static const struct raw_iface IRAW[metadata_raw_type_max] = {
 		.flush_mark		= raw_atomic_flush_mark,
 		.flush_do_asynch	= raw_atomic_flush_do_asynch,
 	},
+	[metadata_raw_type_pmem] = {
+		.init			= _raw_ram_init,
+		.deinit			= _raw_ram_deinit,
+		.size_of		= _raw_ram_size_of,
+		.size_on_ssd		= raw_pmem_size_on_ssd,
+		.checksum		= _raw_ram_checksum,
+		.get			= _raw_ram_get,
+		.set			= _raw_ram_set,
+		.rd_access		= _raw_ram_rd_access,
+		.wr_access		= _raw_ram_wr_access,
+		.load_all		= raw_pmem_load_all,
+		.flush_all		= raw_pmem_flush_all,
+		.flush_mark		= raw_pmem_flush_mark,
+		.flush_do_asynch	= raw_pmem_flush_do_asynch,
+	},
 };
 
 /*******************************************************************************
@@ -627,6 +1172,11 @@ int ocf_metadata_raw_init(ocf_cache_t cache,
 	ENV_BUG_ON(raw->raw_type >= metadata_raw_type_max);
 
 	raw->iface = &(IRAW[raw->raw_type]);
+	raw->rd_direct = raw->raw_type == metadata_raw_type_ram ||
+			raw->raw_type == metadata_raw_type_volatile ||
+			raw->raw_type == metadata_raw_type_atomic ||
+			raw->raw_type == metadata_raw_type_pmem;
+
 	return raw->iface->init(cache, raw);
 }
 
@@ -644,6 +1194,15 @@ int ocf_metadata_raw_deinit(ocf_cache_t cache,
 	return result;
 }
 
+size_t ocf_metadata_raw_size_of_estimate(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw)
+{
+	ENV_BUG_ON(raw->raw_type < metadata_raw_type_min);
+	ENV_BUG_ON(raw->raw_type >= metadata_raw_type_max);
+
+	return IRAW[raw->raw_type].size_of(cache, raw);
+}
+
 size_t ocf_metadata_raw_size_on_ssd(ocf_cache_t cache,
                 struct ocf_metadata_raw* raw)
 {
@@ -38,10 +38,18 @@ enum ocf_metadata_raw_type {
 	 */
 	metadata_raw_type_atomic,
 
+	/**
+	 * @brief Implementation keeping entries in place in persistent memory
+	 * mapping of cache volume, without metadata IO
+	 */
+	metadata_raw_type_pmem,
+
 	metadata_raw_type_max, /*!<  MAX */
 	metadata_raw_type_min = metadata_raw_type_ram /*!<  MAX */
 };
 
+struct raw_ram_flush_combine;
+
 /**
  * @brief RAW instance descriptor
  */
@@ -74,7 +82,19 @@ struct ocf_metadata_raw {
 
 	size_t mem_pool_limit; /*! Current memory pool size (limit) */
 
+	bool mem_pool_huge; /*!< Memory pool is backed by huge pages */
+
+	bool rd_direct; /*!< Entries are read in place from memory pool */
+
 	void *priv; /*!< Private data - context */
+
+	struct raw_ram_flush_combine *flush_combine;
+		/*!< Combined flushing of dirty pages, NULL if disabled */
+
+	unsigned long *modified_map;
+		/*!< Pages modified since last load or flush of all pages,
+		 * NULL if not tracked
+		 */
 };
 
 /**
@@ -172,6 +192,16 @@ static inline size_t ocf_metadata_raw_size_of(ocf_cache_t cache,
 	return raw->iface->size_of(cache, raw);
 }
 
+/**
+ * @brief Get memory footprint RAW instance would have once initialized
+ *
+ * @param cache Cache instance
+ * @param raw RAW descriptor with type, entries and SSD pages set up
+ * @return Memory footprint
+ */
+size_t ocf_metadata_raw_size_of_estimate(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw);
+
 /**
  * @brief Get SSD footprint
  *
@@ -332,8 +362,28 @@ static inline void _raw_bug_on(struct ocf_metadata_raw *raw,
 	ENV_BUG_ON(!_raw_is_valid(raw, line, size));
 }
 
+/*
+ * Remember that page of entry has to be written by next flush of all pages
+ */
+static inline void ocf_metadata_raw_mark_modified(
+		struct ocf_metadata_raw *raw, ocf_cache_line_t line)
+{
+	uint32_t page;
+
+	if (!raw->modified_map)
+		return;
+
+	page = line / raw->entries_in_page;
+
+	/* Avoid atomic write when page is already marked */
+	if (!env_bit_test(page, raw->modified_map))
+		env_bit_set(page, raw->modified_map);
+}
+
 #define MAX_STACK_TAB_SIZE 32
 
+uint64_t _raw_ram_flush_do_page_key(const void *item, uint32_t key);
+
 int _raw_ram_flush_do_page_cmp(const void *item1, const void *item2);
 
 #endif /* METADATA_RAW_H_ */
@@ -10,6 +10,7 @@
 #include "metadata_raw_atomic.h"
 #include "../utils/utils_io.h"
 #include "../utils/utils_cache_line.h"
+#include "../utils/utils_sort.h"
 #include "../ocf_def_priv.h"
 
 #define OCF_METADATA_RAW_ATOMIC_DEBUG 0
@@ -220,8 +221,9 @@ int raw_atomic_flush_do_asynch(struct ocf_cache *cache, struct ocf_request *req,
 
 	}
 
-	env_sort(clines_tab, clines_to_flush, sizeof(*clines_tab),
-			_raw_ram_flush_do_page_cmp, NULL);
+	ocf_sort(clines_tab, clines_to_flush, sizeof(*clines_tab), 1,
+			_raw_ram_flush_do_page_key, _raw_ram_flush_do_page_cmp,
+			NULL);
 
 	i = 0;
 	while (i < clines_to_flush) {
@@ -209,7 +209,7 @@ uint32_t raw_dynamic_checksum(ocf_cache_t cache,
 
 	for (i = 0; i < raw->ssd_pages; i++) {
 		if (ctrl->pages[i])
-			crc = env_crc32(crc, ctrl->pages[i], PAGE_SIZE);
+			crc = METADATA_CRC(crc, ctrl->pages[i], PAGE_SIZE);
 		OCF_COND_RESCHED(step, 10000);
 	}
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "metadata.h"
+#include "metadata_hash.h"
+#include "metadata_raw.h"
+#include "metadata_raw_pmem.h"
+#include "../ocf_volume_priv.h"
+
+/*
+ * Entries are accessed in DRAM pool of RAM container and stored to persistent
+ * memory mapping of cache volume only when RAM container would write them to
+ * cache volume. Updates of metadata are therefore never durable before data
+ * IO of request completes, regardless of CPU cache evictions. Mapping uses
+ * the same page layout as RAM container writes to SSD, so metadata stays
+ * compatible with loading by RAM container.
+ */
+#define _RAW_PMEM_ADDR(mapping, raw, line) \
+	((mapping) + PAGE_SIZE * ((uint64_t)(line) / raw->entries_in_page) \
+	+ (uint64_t)raw->entry_size * ((line) % raw->entries_in_page))
+
+#define _RAW_PMEM_RAM_ADDR(raw, line) \
+	(raw->mem_pool + (uint64_t)raw->entry_size * (line))
+
+static void *_raw_pmem_mapping(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw)
+{
+	void *mapping = ocf_volume_get_direct_mapping(&cache->device->volume);
+
+	ENV_BUG_ON(!mapping);
+
+	return mapping + raw->ssd_pages_offset * PAGE_SIZE;
+}
+
+/*
+ * Store part of entry to persistent memory and make it durable
+ */
+static void _raw_pmem_store(void *mapping, struct ocf_metadata_raw *raw,
+		ocf_cache_line_t line, uint32_t offset, uint32_t size)
+{
+	void *dst = _RAW_PMEM_ADDR(mapping, raw, line) + offset;
+
+	ENV_BUG_ON(env_memcpy(dst, size,
+			_RAW_PMEM_RAM_ADDR(raw, line) + offset, size));
+	env_pmem_persist(dst, size);
+}
+
+/*
+ * RAW PMEM Implementation - Size on SSD
+ */
+uint32_t raw_pmem_size_on_ssd(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw)
+{
+	const size_t alignment = 128 * KiB / PAGE_SIZE;
+
+	return OCF_DIV_ROUND_UP(raw->ssd_pages, alignment) * alignment;
+}
+
+/*
+ * RAW PMEM Implementation - Load all metadata elements
+ */
+void raw_pmem_load_all(ocf_cache_t cache, struct ocf_metadata_raw *raw,
+		ocf_metadata_end_t cmpl, void *priv)
+{
+	void *mapping = _raw_pmem_mapping(cache, raw);
+	uint32_t size = raw->entry_size * raw->entries_in_page;
+	uint32_t step = 0;
+	uint64_t i;
+
+	for (i = 0; i < raw->ssd_pages; i++) {
+		ENV_BUG_ON(env_memcpy(
+				_RAW_PMEM_RAM_ADDR(raw, i * raw->entries_in_page),
+				size, mapping + PAGE_SIZE * i, size));
+		OCF_COND_RESCHED(step, 10000);
+	}
+
+	cmpl(priv, 0);
+}
+
+/*
+ * RAW PMEM Implementation - Flush all elements
+ */
+void raw_pmem_flush_all(ocf_cache_t cache, struct ocf_metadata_raw *raw,
+		ocf_metadata_end_t cmpl, void *priv)
+{
+	void *mapping = _raw_pmem_mapping(cache, raw);
+	uint32_t size = raw->entry_size * raw->entries_in_page;
+	uint32_t step = 0;
+	uint64_t i;
+
+	for (i = 0; i < raw->ssd_pages; i++) {
+		ENV_BUG_ON(env_memcpy(mapping + PAGE_SIZE * i, size,
+				_RAW_PMEM_RAM_ADDR(raw, i * raw->entries_in_page),
+				size));
+		OCF_COND_RESCHED(step, 10000);
+	}
+
+	env_pmem_persist(mapping, raw->ssd_pages * PAGE_SIZE);
+	cmpl(priv, 0);
+}
+
+/*
+ * RAW PMEM Implementation - Mark to Flush
+ */
+void raw_pmem_flush_mark(ocf_cache_t cache, struct ocf_request *req,
+		uint32_t map_idx, int to_state, uint8_t start, uint8_t stop)
+{
+	if (to_state == DIRTY || to_state == CLEAN) {
+		req->map[map_idx].flush = true;
+		req->info.flush_metadata = true;
+	}
+}
+
+/*
+ * RAW PMEM Implementation - Do Flush
+ *
+ * Only entries of the request are stored, so entries modified by requests
+ * still in flight are not made durable with them. Mapping part of entry is
+ * made durable before its status, so entry torn by power failure carries
+ * either status of previous mapping, which was clean when line was remapped,
+ * or status bits of this request, whose data is already on cache volume.
+ * Request completes synchronously without any metadata IO.
+ */
+int raw_pmem_flush_do_asynch(ocf_cache_t cache, struct ocf_request *req,
+		struct ocf_metadata_raw *raw, ocf_req_end_t complete)
+{
+	void *mapping = _raw_pmem_mapping(cache, raw);
+	uint32_t map_size = sizeof(struct ocf_metadata_map);
+	struct ocf_map_info *map;
+	uint32_t i;
+
+	ENV_BUG_ON(raw->entry_size < map_size);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		map = &req->map[i];
+		if (!map->flush)
+			continue;
+
+		_raw_pmem_store(mapping, raw, map->coll_idx, 0, map_size);
+		_raw_pmem_store(mapping, raw, map->coll_idx, map_size,
+				raw->entry_size - map_size);
+	}
+
+	complete(req, 0);
+
+	return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright(c) 2012-2018 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __METADATA_RAW_PMEM_H__
+#define __METADATA_RAW_PMEM_H__
+
+/*
+ * RAW PMEM Implementation - Size on SSD
+ */
+uint32_t raw_pmem_size_on_ssd(ocf_cache_t cache,
+		struct ocf_metadata_raw *raw);
+
+/*
+ * RAW PMEM Implementation - Load all metadata elements
+ */
+void raw_pmem_load_all(ocf_cache_t cache, struct ocf_metadata_raw *raw,
+		ocf_metadata_end_t cmpl, void *priv);
+
+/*
+ * RAW PMEM Implementation - Flush all elements
+ */
+void raw_pmem_flush_all(ocf_cache_t cache, struct ocf_metadata_raw *raw,
+		ocf_metadata_end_t cmpl, void *priv);
+
+/*
+ * RAW PMEM Implementation - Mark to Flush
+ */
+void raw_pmem_flush_mark(ocf_cache_t cache, struct ocf_request *req,
+		uint32_t map_idx, int to_state, uint8_t start, uint8_t stop);
+
+/*
+ * RAW PMEM Implementation - Do Flush
+ */
+int raw_pmem_flush_do_asynch(ocf_cache_t cache, struct ocf_request *req,
+		struct ocf_metadata_raw *raw, ocf_req_end_t complete);
+
+#endif /* __METADATA_RAW_PMEM_H__ */
@@ -14,7 +14,7 @@
 static inline void metadata_init_status_bits(struct ocf_cache *cache,
 		ocf_cache_line_t line)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 
 	cache->metadata.iface.clear_dirty(cache, line,
 			cache->metadata.settings.sector_start,
@@ -23,7 +23,7 @@ static inline void metadata_init_status_bits(struct ocf_cache *cache,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end);
 
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline bool metadata_test_dirty_all(struct ocf_cache *cache,
@@ -31,11 +31,11 @@ static inline bool metadata_test_dirty_all(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_dirty(cache, line,
 		cache->metadata.settings.sector_start,
 		cache->metadata.settings.sector_end, true);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -45,11 +45,11 @@ static inline bool metadata_test_dirty(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_dirty(cache, line,
 		cache->metadata.settings.sector_start,
 		cache->metadata.settings.sector_end, false);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -57,21 +57,21 @@ static inline bool metadata_test_dirty(struct ocf_cache *cache,
 static inline void metadata_set_dirty(struct ocf_cache *cache,
 		ocf_cache_line_t line)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.set_dirty(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline void metadata_clear_dirty(struct ocf_cache *cache,
 		ocf_cache_line_t line)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.clear_dirty(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline bool metadata_test_and_clear_dirty(
@@ -79,11 +79,11 @@ static inline bool metadata_test_and_clear_dirty(
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	test =	cache->metadata.iface.test_and_clear_dirty(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end, false);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return test;
 }
@@ -93,11 +93,11 @@ static inline bool metadata_test_and_set_dirty(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	test =	cache->metadata.iface.test_and_set_dirty(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end, false);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return test;
 }
@@ -111,10 +111,10 @@ static inline bool metadata_test_dirty_sec(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_dirty(cache, line,
 			start, stop, false);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -124,10 +124,10 @@ static inline bool metadata_test_dirty_all_sec(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_dirty(cache, line,
 			start, stop, true);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -143,9 +143,9 @@ static inline bool metadata_test_dirty_out_sec(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_out_dirty(cache, line, start, stop);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -153,33 +153,49 @@ static inline bool metadata_test_dirty_out_sec(struct ocf_cache *cache,
 static inline void metadata_set_dirty_sec(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t start, uint8_t stop)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.set_dirty(cache, line, start, stop);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline void metadata_clear_dirty_sec(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t start, uint8_t stop)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.clear_dirty(cache, line, start, stop);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline void metadata_set_dirty_sec_one(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t pos)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.set_dirty(cache, line, pos, pos);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline void metadata_clear_dirty_sec_one(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t pos)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.clear_dirty(cache, line, pos, pos);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
+}
+
+/*
+ * Find first sector at or after start which dirty bit is equal to dirty,
+ * returns number of sectors in cache line if there is none
+ */
+static inline uint8_t metadata_find_dirty_sec(struct ocf_cache *cache,
+		ocf_cache_line_t line, uint8_t start, bool dirty)
+{
+	uint8_t pos;
+
+	OCF_METADATA_BITS_LOCK_RD(line);
+	pos = cache->metadata.iface.find_dirty(cache, line, start, dirty);
+	OCF_METADATA_BITS_UNLOCK_RD(line);
+
+	return pos;
 }
 
 static inline bool metadata_test_and_clear_dirty_sec(
@@ -188,10 +204,10 @@ static inline bool metadata_test_and_clear_dirty_sec(
 {
 	bool test = false;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	test = cache->metadata.iface.test_and_clear_dirty(cache, line,
 			start, stop, false);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return test;
 }
@@ -208,7 +224,7 @@ static inline bool metadata_clear_dirty_sec_changed(
 {
 	bool was_dirty, is_dirty = false;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 
 	was_dirty = cache->metadata.iface.test_dirty(cache, line,
 			cache->metadata.settings.sector_start,
@@ -220,7 +236,7 @@ static inline bool metadata_clear_dirty_sec_changed(
 				start, stop);
 	}
 
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return was_dirty && !is_dirty;
 }
@@ -237,9 +253,9 @@ static inline bool metadata_set_dirty_sec_changed(
 {
 	bool was_dirty;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	was_dirty = cache->metadata.iface.set_dirty(cache, line, start, stop);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return !was_dirty;
 }
@@ -253,11 +269,11 @@ static inline bool metadata_test_valid_any(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_valid(cache, line,
 		cache->metadata.settings.sector_start,
 		cache->metadata.settings.sector_end, false);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -267,11 +283,11 @@ static inline bool metadata_test_valid(struct ocf_cache *cache,
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_valid(cache, line,
 		cache->metadata.settings.sector_start,
 		cache->metadata.settings.sector_end, true);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -279,21 +295,21 @@ static inline bool metadata_test_valid(struct ocf_cache *cache,
 static inline void metadata_set_valid(struct ocf_cache *cache,
 		ocf_cache_line_t line)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.set_valid(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline void metadata_clear_valid(struct ocf_cache *cache,
 		ocf_cache_line_t line)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.clear_valid(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline bool metadata_test_and_clear_valid(
@@ -301,11 +317,11 @@ static inline bool metadata_test_and_clear_valid(
 {
 	bool test = false;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	test =	cache->metadata.iface.test_and_clear_valid(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end, true);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return test;
 }
@@ -315,11 +331,11 @@ static inline bool metadata_test_and_set_valid(struct ocf_cache *cache,
 {
 	bool test = false;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	test =	cache->metadata.iface.test_and_set_valid(cache, line,
 			cache->metadata.settings.sector_start,
 			cache->metadata.settings.sector_end, true);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return test;
 }
@@ -328,15 +344,32 @@ static inline bool metadata_test_and_set_valid(struct ocf_cache *cache,
  * Valid - Sector Implementation
  ******************************************************************************/
 
+/*
+ * Invalidate sectors which are not dirty
+ *
+ * @return true if any sector of cache line remained valid
+ */
+static inline bool metadata_invalidate_clean(struct ocf_cache *cache,
+		ocf_cache_line_t line)
+{
+	bool is_valid;
+
+	OCF_METADATA_BITS_LOCK_WR(line);
+	is_valid = cache->metadata.iface.invalidate_clean(cache, line);
+	OCF_METADATA_BITS_UNLOCK_WR(line);
+
+	return is_valid;
+}
+
 static inline bool metadata_test_valid_sec(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t start, uint8_t stop)
 {
 	bool test;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_valid(cache, line,
 			start, stop, true);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -347,10 +380,10 @@ static inline bool metadata_test_valid_any_out_sec(
 {
 	bool test = false;
 
-	OCF_METADATA_BITS_LOCK_RD();
+	OCF_METADATA_BITS_LOCK_RD(line);
 	test = cache->metadata.iface.test_out_valid(cache, line,
 			start, stop);
-	OCF_METADATA_BITS_UNLOCK_RD();
+	OCF_METADATA_BITS_UNLOCK_RD(line);
 
 	return test;
 }
@@ -374,10 +407,10 @@ static inline bool metadata_set_valid_sec_changed(
 {
 	bool was_any_valid;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	was_any_valid = cache->metadata.iface.set_valid(cache, line,
 			start, stop);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return !was_any_valid;
 }
@@ -385,25 +418,25 @@ static inline bool metadata_set_valid_sec_changed(
 static inline void metadata_clear_valid_sec(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t start, uint8_t stop)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.clear_valid(cache, line, start, stop);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline void metadata_clear_valid_sec_one(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t pos)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.clear_valid(cache, line, pos, pos);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 
 static inline void metadata_set_valid_sec_one(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t pos)
 {
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 	cache->metadata.iface.set_valid(cache, line, pos, pos);
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 }
 /*
  * Marks given cache line's bits as invalid
@@ -418,7 +451,7 @@ static inline bool metadata_clear_valid_sec_changed(
 {
 	bool was_any_valid;
 
-	OCF_METADATA_BITS_LOCK_WR();
+	OCF_METADATA_BITS_LOCK_WR(line);
 
 	was_any_valid = cache->metadata.iface.test_valid(cache, line,
 			cache->metadata.settings.sector_start,
@@ -427,7 +460,7 @@ static inline bool metadata_clear_valid_sec_changed(
 	*is_valid = cache->metadata.iface.clear_valid(cache, line,
 			start, stop);
 
-	OCF_METADATA_BITS_UNLOCK_WR();
+	OCF_METADATA_BITS_UNLOCK_WR(line);
 
 	return was_any_valid && !*is_valid;
 }
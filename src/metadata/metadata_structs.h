@@ -31,12 +31,15 @@ enum ocf_metadata_shutdown_status {
 struct ocf_metadata_layout_iface {
 
 	/**
-	 * @brief Initialize freelist partition
+	 * @brief Initialize range of collision entries as free list nodes
 	 *
 	 * @param cache - Cache instance
+	 * @param begin - First collision entry of range
+	 * @param end - Collision entry following the range
 	 */
 
-	void (*init_freelist)(struct ocf_cache *cache);
+	void (*init_freelist)(struct ocf_cache *cache,
+			ocf_cache_line_t begin, ocf_cache_line_t end);
 
 	/**
 	 * This function is mapping collision index to appropriate cache line
@@ -114,11 +117,14 @@ struct ocf_metadata_iface {
 	const struct ocf_metadata_layout_iface *layout_iface;
 
 	/**
-	 * @brief Initialize hash table
+	 * @brief Initialize hash table, collision table and free list
 	 *
-	 * @param cache - Cache instance
+	 * @param[in] cache - Cache instance
+	 * @param[in] cmpl - Completion callback
+	 * @param[in] priv - Completion callback context
 	 */
-	void (*init_hash_table)(struct ocf_cache *cache);
+	void (*init_collision)(struct ocf_cache *cache,
+			ocf_metadata_end_t cmpl, void *priv);
 
 	/**
 	 * @brief De-Initialize metadata
@@ -142,6 +148,31 @@ struct ocf_metadata_iface {
 	 */
 	size_t (*size_of)(struct ocf_cache *cache);
 
+	/**
+	 * @brief Get memory footprint of each metadata segment and of
+	 *	volatile metadata outside of segments
+	 *
+	 * @param cache - Cache instance
+	 * @param usage - Memory usage to be filled in
+	 */
+	void (*mem_usage)(struct ocf_cache *cache,
+			struct ocf_cache_memory_usage *usage);
+
+	/**
+	 * @brief Estimate memory footprint of per cache line metadata
+	 *	without allocating it
+	 *
+	 * @param cache - Cache instance
+	 * @param device_size - Size of caching device in bytes
+	 * @param line_size - Cache line size
+	 * @param atomic - Caching device is atomic volume
+	 * @param ram - Per segment memory footprint
+	 * @return 0 - Operation success, otherwise error
+	 */
+	int (*size_estimate)(struct ocf_cache *cache, uint64_t device_size,
+			ocf_cache_line_size_t line_size, bool atomic,
+			struct ocf_mngt_cache_ram_needed *ram);
+
 	/**
 	 * @brief Get amount of pages required for metadata
 	 *
@@ -188,6 +219,17 @@ struct ocf_metadata_iface {
 	void (*flush_all)(ocf_cache_t cache,
 			ocf_metadata_end_t cmpl, void *priv);
 
+	/**
+	 * @brief Write modified pages of per cache line metadata, leaving
+	 *	shutdown status dirty
+	 *
+	 * @param[in] cache - Cache instance
+	 * @param[in] cmpl - Completion callback
+	 * @param[in] priv - Completion callback context
+	 */
+	void (*checkpoint)(ocf_cache_t cache,
+			ocf_metadata_end_t cmpl, void *priv);
+
 	/**
 	 * @brief Mark specified cache line to be flushed
 	 *
@@ -303,6 +345,14 @@ struct ocf_metadata_iface {
 	 */
 	ocf_cache_line_t (*entries_hash)(struct ocf_cache *cache);
 
+	/**
+	 * @brief Prefetch hash table value for specified index
+	 *
+	 * @param[in] cache - Cache instance
+	 * @param[in] index - Hash table index
+	 */
+	void (*prefetch_hash)(struct ocf_cache *cache, ocf_cache_line_t index);
+
 	/* TODO Provide documentation below */
 	void (*set_core_info)(struct ocf_cache *cache,
 			ocf_cache_line_t line, ocf_core_id_t core_id,
@@ -345,6 +395,28 @@ struct ocf_metadata_iface {
 	ocf_cache_line_t (*get_collision_prev)(struct ocf_cache *cache,
 					ocf_cache_line_t line);
 
+	/**
+	 * @brief Get fields of collision entry used by hash chain lookup
+	 *
+	 * @param[in] cache - Cache instance
+	 * @param[in] line - Cache line
+	 * @param[out] core_id - Core id of cache line
+	 * @param[out] core_line - Core line mapped to cache line
+	 * @return Next cache line in hash chain
+	 */
+	ocf_cache_line_t (*get_lookup_info)(struct ocf_cache *cache,
+			ocf_cache_line_t line, ocf_core_id_t *core_id,
+			uint64_t *core_line);
+
+	/**
+	 * @brief Prefetch fields of collision entry used by hash chain lookup
+	 *
+	 * @param[in] cache - Cache instance
+	 * @param[in] line - Cache line
+	 */
+	void (*prefetch_lookup_info)(struct ocf_cache *cache,
+			ocf_cache_line_t line);
+
 	ocf_part_id_t (*get_partition_id)(struct ocf_cache *cache,
 			ocf_cache_line_t line);
 
@@ -369,6 +441,13 @@ struct ocf_metadata_iface {
 			ocf_cache_line_t line, ocf_part_id_t part_id,
 			ocf_cache_line_t next_line, ocf_cache_line_t prev_line);
 
+#if OCF_CONFIG_ZERO_LINES
+	bool (*get_zero)(struct ocf_cache *cache, ocf_cache_line_t line);
+
+	void (*set_zero)(struct ocf_cache *cache, ocf_cache_line_t line,
+			bool zero);
+#endif
+
 	const struct ocf_metadata_status*
 	(*rd_status_access)(struct ocf_cache *cache,
 			ocf_cache_line_t line);
@@ -413,15 +492,41 @@ struct ocf_metadata_iface {
 
 	bool (*test_and_clear_valid)(struct ocf_cache *cache,
 		ocf_cache_line_t line, uint8_t start, uint8_t stop, bool all);
+
+	uint8_t (*find_dirty)(struct ocf_cache *cache,
+		ocf_cache_line_t line, uint8_t start, bool dirty);
+
+	bool (*invalidate_clean)(struct ocf_cache *cache,
+		ocf_cache_line_t line);
 };
 
 struct ocf_cache_line_settings {
 	ocf_cache_line_size_t size;
+	uint8_t size_shift;
+		/*!< Cache line size is power of two, bytes are converted to
+		 * cache lines with shifts
+		 */
 	uint64_t sector_count;
 	uint64_t sector_start;
 	uint64_t sector_end;
 };
 
+/**
+ * @brief Status bits lock, aligned so that neighbouring locks don't share
+ * a CPU cache line
+ */
+struct ocf_metadata_status_lock {
+	env_rwlock lock;
+} __attribute__((aligned(64)));
+
+/**
+ * @brief Eviction policy shard lock, aligned so that neighbouring locks
+ * don't share a CPU cache line
+ */
+struct ocf_metadata_eviction_lock {
+	env_spinlock lock;
+} __attribute__((aligned(64)));
+
 /**
  * @brief Metadata control structure
  */
@@ -438,10 +543,19 @@ struct ocf_metadata {
 	bool is_volatile;
 		/*!< true if metadata used in volatile mode (RAM only) */
 
-	struct {
-		env_rwsem collision; /*!< lock for collision table */
-		env_rwlock status; /*!< Fast lock for status bits */
-		env_spinlock eviction; /*!< Fast lock for eviction policy */
+	struct ocf_metadata_lock {
+		env_rwsem global; /*!< global metadata lock */
+		env_rwsem *hash; /*!< hash bucket locks (striped) */
+		env_atomic *hash_gen;
+			/*!< Mapping generations of hash bucket lock stripes */
+		struct ocf_metadata_status_lock
+				status[OCF_CONFIG_METADATA_STATUS_LOCKS];
+			/*!< Fast locks for status bits, striped by cache line */
+		struct ocf_metadata_eviction_lock
+				eviction[OCF_EVICTION_SHARDS];
+			/*!< Fast locks for eviction policy shards */
+		env_spinlock freelist;
+			/*!< Fast lock for free list and partition lists */
 	} lock;
 };
 
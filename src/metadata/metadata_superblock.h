@@ -44,6 +44,19 @@ struct ocf_superblock_config {
 
 	struct ocf_user_part_config user_parts[OCF_IO_CLASS_MAX + 1];
 
+	/* Average number of cache lines per hash table entry */
+	uint32_t hash_load_factor;
+
+	/* Cache device size metadata is sized for */
+	uint64_t max_size;
+
+	/* Number of cache lines in use, see ocf_mngt_cache_resize() */
+	ocf_cache_line_t lines_limit;
+
+	/* Per cache line metadata was written by checkpoint of idle cache,
+	 * see utils_checkpoint.h. Kept 0 in memory otherwise */
+	uint8_t checkpoint_valid;
+
 	/*
 	 * Checksum for each metadata region.
 	 * This field has to be the last one!
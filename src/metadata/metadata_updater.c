@@ -17,11 +17,18 @@ int ocf_metadata_updater_init(ocf_cache_t cache)
 {
 	ocf_metadata_updater_t mu = &cache->metadata_updater;
 	struct ocf_metadata_io_syncher *syncher = &mu->syncher;
+	uint32_t i;
 
-	INIT_LIST_HEAD(&syncher->in_progress_head);
+	for (i = 0; i < METADATA_UPDATER_BUCKETS; i++)
+		INIT_LIST_HEAD(&syncher->in_progress[i]);
 	INIT_LIST_HEAD(&syncher->pending_head);
+	syncher->max_count = 0;
+	env_atomic_set(&syncher->in_flight, 0);
 	env_mutex_init(&syncher->lock);
 
+	INIT_LIST_HEAD(&syncher->finished_head);
+	env_spinlock_init(&syncher->finished_lock);
+
 	return ctx_metadata_updater_init(cache->owner, mu);
 }
 
@@ -53,30 +60,73 @@ ocf_cache_t ocf_metadata_updater_get_cache(ocf_metadata_updater_t mu)
 	return container_of(mu, struct ocf_cache, metadata_updater);
 }
 
-static int _metadata_updater_iterate_in_progress(ocf_cache_t cache,
-		struct metadata_io_request *new_req)
+static inline struct list_head *_metadata_updater_bucket(
+		struct ocf_metadata_io_syncher *syncher, uint32_t chunk)
+{
+	return &syncher->in_progress[chunk & (METADATA_UPDATER_BUCKETS - 1)];
+}
+
+/*
+ * Free requests which IO has finished, so that their pages don't block
+ * following requests any more
+ */
+static void _metadata_updater_put_finished(ocf_cache_t cache)
 {
 	struct metadata_io_request_asynch *a_req;
 	struct ocf_metadata_io_syncher *syncher =
 		&cache->metadata_updater.syncher;
 	struct metadata_io_request *curr, *temp;
+	struct list_head finished;
 
-	list_for_each_entry_safe(curr, temp, &syncher->in_progress_head, list) {
-		if (env_atomic_read(&curr->finished)) {
-			a_req = curr->asynch;
-			ENV_BUG_ON(!a_req);
+	INIT_LIST_HEAD(&finished);
 
-			list_del(&curr->list);
+	env_spinlock_lock(&syncher->finished_lock);
+	list_for_each_entry_safe(curr, temp, &syncher->finished_head,
+			finished_list) {
+		list_move_tail(&curr->finished_list, &finished);
+	}
+	env_spinlock_unlock(&syncher->finished_lock);
 
-			if (env_atomic_dec_return(&a_req->req_active) == 0) {
-				OCF_REALLOC_DEINIT(&a_req->reqs,
-						&a_req->reqs_limit);
-				env_free(a_req);
-			}
-			continue;
+	list_for_each_entry_safe(curr, temp, &finished, finished_list) {
+		a_req = curr->asynch;
+		ENV_BUG_ON(!a_req);
+
+		list_del(&curr->finished_list);
+		list_del(&curr->list);
+
+		if (env_atomic_dec_return(&a_req->req_active) == 0) {
+			OCF_REALLOC_DEINIT(&a_req->reqs,
+					&a_req->reqs_limit);
+			env_free(a_req);
 		}
-		if (new_req) {
-			/* If request specified, check if overlap occurs. */
+	}
+}
+
+/*
+ * Request may overlap only in-progress requests starting in chunks from
+ * (page - max_count) up to its last page, so only their buckets are
+ * checked.
+ */
+static int _metadata_updater_check_in_progress(ocf_cache_t cache,
+		struct metadata_io_request *new_req)
+{
+	struct ocf_metadata_io_syncher *syncher =
+		&cache->metadata_updater.syncher;
+	struct metadata_io_request *curr;
+	uint32_t first, last, chunk;
+
+	first = new_req->page > syncher->max_count ?
+			new_req->page - syncher->max_count : 0;
+	first /= METADATA_UPDATER_CHUNK_PAGES;
+	last = (new_req->page + new_req->count - 1) /
+			METADATA_UPDATER_CHUNK_PAGES;
+
+	if (last - first >= METADATA_UPDATER_BUCKETS)
+		last = first + METADATA_UPDATER_BUCKETS - 1;
+
+	for (chunk = first; chunk <= last; chunk++) {
+		list_for_each_entry(curr, _metadata_updater_bucket(syncher,
+				chunk), list) {
 			if (ocf_io_overlaps(new_req->page, new_req->count,
 					curr->page, curr->count)) {
 				return 1;
@@ -87,6 +137,37 @@ static int _metadata_updater_iterate_in_progress(ocf_cache_t cache,
 	return 0;
 }
 
+static void _metadata_updater_add_in_progress(ocf_cache_t cache,
+		struct metadata_io_request *req)
+{
+	struct ocf_metadata_io_syncher *syncher =
+		&cache->metadata_updater.syncher;
+
+	list_add_tail(&req->list, _metadata_updater_bucket(syncher,
+			req->page / METADATA_UPDATER_CHUNK_PAGES));
+}
+
+static inline bool _metadata_updater_queue_full(
+		struct ocf_metadata_io_syncher *syncher)
+{
+	return OCF_CONFIG_METADATA_IO_QD && env_atomic_read(
+			&syncher->in_flight) >= OCF_CONFIG_METADATA_IO_QD;
+}
+
+/*
+ * Check if pending request continues write of previous one started in the
+ * same run, so that both can be written with single IO
+ */
+static inline bool _metadata_updater_can_merge(
+		struct metadata_io_request *prev, uint32_t prev_count,
+		struct metadata_io_request *req, uint32_t max_count)
+{
+	return prev && prev->fl_req.rw == OCF_WRITE &&
+			req->fl_req.rw == OCF_WRITE &&
+			prev->page + prev_count == req->page &&
+			prev_count + req->count <= max_count;
+}
+
 int metadata_updater_check_overlaps(ocf_cache_t cache,
                 struct metadata_io_request *req)
 {
@@ -96,57 +177,110 @@ int metadata_updater_check_overlaps(ocf_cache_t cache,
 
 	env_mutex_lock(&syncher->lock);
 
-	ret = _metadata_updater_iterate_in_progress(cache, req);
+	if (req->count > syncher->max_count)
+		syncher->max_count = req->count;
+
+	_metadata_updater_put_finished(cache);
+	ret = _metadata_updater_check_in_progress(cache, req);
+	if (ret == 0 && _metadata_updater_queue_full(syncher))
+		ret = 1;
 
 	/* Either add it to in-progress list or pending list for deferred
 	 * execution.
 	 */
-	if (ret == 0)
-		list_add_tail(&req->list, &syncher->in_progress_head);
-	else
+	if (ret == 0) {
+		_metadata_updater_add_in_progress(cache, req);
+		env_atomic_inc(&syncher->in_flight);
+	} else {
 		list_add_tail(&req->list, &syncher->pending_head);
+	}
 
 	env_mutex_unlock(&syncher->lock);
 
 	return ret;
 }
 
+void metadata_updater_finish(ocf_cache_t cache,
+		struct metadata_io_request *req)
+{
+	struct ocf_metadata_io_syncher *syncher =
+		&cache->metadata_updater.syncher;
+
+	env_spinlock_lock(&syncher->finished_lock);
+	list_add_tail(&req->finished_list, &syncher->finished_head);
+	env_spinlock_unlock(&syncher->finished_lock);
+}
+
+/*
+ * Account completion of metadata IO, caller kicks updater afterwards to
+ * start requests waiting for queue depth
+ */
+void metadata_updater_io_done(ocf_cache_t cache)
+{
+	env_atomic_dec(&cache->metadata_updater.syncher.in_flight);
+}
+
 uint32_t ocf_metadata_updater_run(ocf_metadata_updater_t mu)
 {
-	struct metadata_io_request *curr, *temp;
+	struct metadata_io_request *curr, *temp, *prev = NULL;
 	struct ocf_metadata_io_syncher *syncher;
+	struct list_head ready;
+	uint32_t max_count = 0, prev_count = 0;
 	ocf_cache_t cache;
-	int ret;
 
 	OCF_CHECK_NULL(mu);
 
 	cache = ocf_metadata_updater_get_cache(mu);
 	syncher = &cache->metadata_updater.syncher;
 
+	INIT_LIST_HEAD(&ready);
+
 	env_mutex_lock(&syncher->lock);
-	if (list_empty(&syncher->pending_head)) {
-		/*
-		 * If pending list is empty, we iterate over in progress
-		 * list to free memory used by finished requests.
-		 */
-		_metadata_updater_iterate_in_progress(cache, NULL);
-		env_mutex_unlock(&syncher->lock);
-		env_cond_resched();
-		return 0;
-	}
+
+	_metadata_updater_put_finished(cache);
+
+	/* Updater kicked by completion of the last metadata IO may run after
+	 * cache device is detached, there is nothing pending then
+	 */
+	if (!list_empty(&syncher->pending_head))
+		max_count = metadata_io_max_page(cache);
+
+	/* Collect all pending requests which don't overlap in-progress ones
+	 * and kick them at once, as many as queue depth allows. Writes of
+	 * contiguous pages are merged into IO of the first of them.
+	 */
 	list_for_each_entry_safe(curr, temp, &syncher->pending_head, list) {
-		ret = _metadata_updater_iterate_in_progress(cache, curr);
-		if (ret == 0) {
-			/* Move to in-progress list and kick the workers */
-			list_move_tail(&curr->list, &syncher->in_progress_head);
+		if (_metadata_updater_check_in_progress(cache, curr))
+			continue;
+
+		if (_metadata_updater_can_merge(prev, prev_count, curr,
+				max_count)) {
+			list_del(&curr->list);
+			_metadata_updater_add_in_progress(cache, curr);
+			list_add_tail(&curr->merged, &prev->merged);
+			prev_count += curr->count;
+			continue;
 		}
-		env_mutex_unlock(&syncher->lock);
-		if (ret == 0)
-			ocf_engine_push_req_front(&curr->fl_req, true);
-		env_cond_resched();
-		env_mutex_lock(&syncher->lock);
+
+		if (_metadata_updater_queue_full(syncher))
+			break;
+
+		list_del(&curr->list);
+		_metadata_updater_add_in_progress(cache, curr);
+		env_atomic_inc(&syncher->in_flight);
+		list_add_tail(&curr->finished_list, &ready);
+		prev = curr;
+		prev_count = curr->count;
 	}
+
 	env_mutex_unlock(&syncher->lock);
 
+	list_for_each_entry_safe(curr, temp, &ready, finished_list) {
+		list_del(&curr->finished_list);
+		ocf_engine_push_req_front(&curr->fl_req, true);
+	}
+
+	env_cond_resched();
+
 	return 0;
 }
@@ -9,12 +9,26 @@
 #include "../ocf_def_priv.h"
 #include "metadata_io.h"
 
+/* Number of pages covered by single in-progress hash bucket */
+#define METADATA_UPDATER_CHUNK_PAGES	32
+
+/* Number of in-progress hash buckets, must be power of 2 */
+#define METADATA_UPDATER_BUCKETS	256
+
 struct ocf_metadata_updater {
 	/* Metadata flush synchronizer context */
 	struct ocf_metadata_io_syncher {
-		struct list_head in_progress_head;
+		struct list_head in_progress[METADATA_UPDATER_BUCKETS];
+			/*!< In-progress requests hashed by chunk of first page */
 		struct list_head pending_head;
+		uint32_t max_count;
+			/*!< Largest page count of request seen so far */
+		env_atomic in_flight;
+			/*!< Metadata IOs submitted and not completed yet */
 		env_mutex lock;
+
+		struct list_head finished_head;
+		env_spinlock finished_lock;
 	} syncher;
 
 	void *priv;
@@ -24,6 +38,11 @@ struct ocf_metadata_updater {
 int metadata_updater_check_overlaps(ocf_cache_t cache,
                 struct metadata_io_request *req);
 
+void metadata_updater_finish(ocf_cache_t cache,
+		struct metadata_io_request *req);
+
+void metadata_updater_io_done(ocf_cache_t cache);
+
 int ocf_metadata_updater_init(struct ocf_cache *cache);
 
 void ocf_metadata_updater_kick(struct ocf_cache *cache);
@@ -10,19 +10,32 @@
 #include "../ocf_core_priv.h"
 #include "../ocf_queue_priv.h"
 #include "../metadata/metadata.h"
+#include "../metadata/metadata_core_index.h"
 #include "../engine/cache_engine.h"
+#include "../engine/engine_ops.h"
+#include "../engine/engine_common.h"
 #include "../utils/utils_part.h"
 #include "../utils/utils_cache_line.h"
 #include "../utils/utils_device.h"
 #include "../utils/utils_io.h"
 #include "../utils/utils_cache_line.h"
 #include "../utils/utils_pipeline.h"
+#include "../utils/utils_cleaner.h"
 #include "../utils/utils_refcnt.h"
+#include "../utils/utils_req.h"
+#include "../utils/utils_ram_tier.h"
+#include "../utils/utils_fill.h"
+#include "../utils/utils_zero.h"
+#include "../utils/utils_checkpoint.h"
+#include "../utils/utils_trim.h"
+#include "../utils/utils_compress.h"
+#include "../utils/utils_dedup.h"
 #include "../ocf_utils.h"
 #include "../concurrency/ocf_concurrency.h"
 #include "../eviction/ops.h"
 #include "../ocf_ctx_priv.h"
 #include "../cleaning/cleaning.h"
+#include "../promotion/promotion.h"
 
 #define OCF_ASSERT_PLUGGED(cache) ENV_BUG_ON(!(cache)->device)
 
@@ -92,6 +105,12 @@ struct ocf_cachemng_init_params {
 
 		ocf_cache_mode_t cache_mode;
 		/*!< cache mode */
+
+		uint32_t hash_load_factor;
+		/*!< Average number of cache lines per hash table entry */
+
+		ocf_eviction_t eviction_policy;
+		/*!< Eviction policy, which sizes its per cache line metadata */
 	} metadata;
 };
 
@@ -130,12 +149,20 @@ struct ocf_cache_attach_context {
 		bool cleaner_started : 1;
 			/*!< Cleaner has been started */
 
+		bool bg_discard : 1;
+			/*!< Cache device is to be discarded in background */
+
 		bool cores_opened : 1;
 			/*!< underlying cores are opened (happens only during
 			 * load or recovery
 			 */
 
 		bool concurrency_inited : 1;
+		bool promotion_attached : 1;
+		bool ghost_attached : 1;
+		bool ram_tier_attached : 1;
+		bool fill_attached : 1;
+		bool zero_lines_attached : 1;
 	} flags;
 
 	struct {
@@ -148,6 +175,9 @@ struct ocf_cache_attach_context {
 		ocf_cache_mode_t cache_mode;
 		/*!< cache mode */
 
+		uint64_t max_size;
+		/*!< cache device size metadata is sized for */
+
 		enum ocf_metadata_shutdown_status shutdown_status;
 		/*!< dirty or clean */
 
@@ -186,18 +216,6 @@ static ocf_cache_id_t _ocf_mngt_cache_find_free_id(ocf_ctx_t owner)
 	return OCF_CACHE_ID_INVALID;
 }
 
-static void __init_hash_table(ocf_cache_t cache)
-{
-	/* Initialize hash table*/
-	ocf_metadata_init_hash_table(cache);
-}
-
-static void __init_freelist(ocf_cache_t cache)
-{
-	/* Initialize free list partition*/
-	ocf_metadata_init_freelist_partition(cache);
-}
-
 static void __init_partitions(ocf_cache_t cache)
 {
 	ocf_part_id_t i_part;
@@ -234,7 +252,7 @@ static void __init_partitions_attached(ocf_cache_t cache)
 
 static void __init_cleaning_policy(ocf_cache_t cache)
 {
-	ocf_cleaning_t cleaning_policy = ocf_cleaning_default;
+	ocf_cleaning_t cleaning_policy = ocf_cleaning_get_default();
 	int i;
 
 	OCF_ASSERT_PLUGGED(cache);
@@ -244,7 +262,7 @@ static void __init_cleaning_policy(ocf_cache_t cache)
 			cleaning_policy_ops[i].setup(cache);
 	}
 
-	cache->conf_meta->cleaning_policy_type = ocf_cleaning_default;
+	cache->conf_meta->cleaning_policy_type = cleaning_policy;
 	if (cleaning_policy_ops[cleaning_policy].initialize)
 		cleaning_policy_ops[cleaning_policy].initialize(cache, 1);
 }
@@ -287,8 +305,7 @@ static void __reset_stats(ocf_cache_t cache)
 	for (core_id = 0; core_id < OCF_CORE_MAX; core_id++) {
 		env_atomic_set(&cache->core_runtime_meta[core_id].
 				cached_clines, 0);
-		env_atomic_set(&cache->core_runtime_meta[core_id].
-				dirty_clines, 0);
+		ocf_cache_core_dirty_reset(cache, core_id);
 		env_atomic64_set(&cache->core_runtime_meta[core_id].
 				dirty_since, 0);
 
@@ -306,19 +323,16 @@ static void init_attached_data_structures(ocf_cache_t cache,
 {
 	/* Lock to ensure consistency */
 	OCF_METADATA_LOCK_WR();
-	__init_hash_table(cache);
-	__init_freelist(cache);
+	/* Eviction policy has to be set before partitions are initialized */
+	__init_eviction_policy(cache, eviction_policy);
 	__init_partitions_attached(cache);
 	__init_cleaning_policy(cache);
-	__init_eviction_policy(cache, eviction_policy);
 	OCF_METADATA_UNLOCK_WR();
 }
 
 static void init_attached_data_structures_recovery(ocf_cache_t cache)
 {
 	OCF_METADATA_LOCK_WR();
-	__init_hash_table(cache);
-	__init_freelist(cache);
 	__init_partitions_attached(cache);
 	__reset_stats(cache);
 	__init_metadata_version(cache);
@@ -347,6 +361,9 @@ static void _ocf_mngt_close_all_uninitialized_cores(
 
 		env_free(cache->core[i].counters);
 		cache->core[i].counters = NULL;
+		ocf_core_index_deinit(&cache->core[i]);
+		ocf_core_mrc_deinit(&cache->core[i]);
+		ocf_core_pinned_deinit(&cache->core[i]);
 
 		env_bit_clear(i, cache->conf_meta->valid_core_bitmap);
 	}
@@ -354,18 +371,173 @@ static void _ocf_mngt_close_all_uninitialized_cores(
 	cache->conf_meta->core_count = 0;
 }
 
+/* Maximal number of core volumes opened concurrently on cache load */
+#define OCF_MNGT_CORE_OPEN_JOBS 32
+
+typedef void (*_ocf_mngt_add_cores_end_t)(
+		struct ocf_cache_attach_context *context, int error);
+
+struct ocf_mngt_add_cores_context {
+	struct ocf_cache_attach_context *attach;
+	_ocf_mngt_add_cores_end_t cmpl;
+
+	/* Cores not found in pool, opened by jobs */
+	ocf_core_id_t to_open[OCF_CORE_MAX];
+	uint32_t to_open_no;
+	env_atomic next;
+
+	/* Open result, indexed by core id */
+	int result[OCF_CORE_MAX];
+	bool opening[OCF_CORE_MAX];
+
+	env_atomic remaining;
+};
+
+/*
+ * Finish adding cores once all of them are opened. Results are reported in
+ * core id order, as if cores were opened one by one.
+ */
+static void _ocf_mngt_init_instance_add_cores_finish(
+		struct ocf_mngt_add_cores_context *add_context)
+{
+	struct ocf_cache_attach_context *context = add_context->attach;
+	_ocf_mngt_add_cores_end_t cmpl = add_context->cmpl;
+	ocf_cache_t cache = context->cache;
+	uint64_t hd_lines = 0;
+	int ret, i;
+
+	for (i = 0; i < OCF_CORE_MAX; i++) {
+		ocf_core_t core = &cache->core[i];
+
+		if (!env_bit_test(i, cache->conf_meta->valid_core_bitmap))
+			continue;
+
+		if (add_context->opening[i]) {
+			ret = add_context->result[i];
+			if (ret == -OCF_ERR_NOT_OPEN_EXC) {
+				ocf_cache_log(cache, log_warn,
+						"Cannot open core %u. "
+						"Cache is busy", i);
+			} else if (ret) {
+				ocf_cache_log(cache, log_warn,
+						"Cannot open core %u", i);
+			} else {
+				core->opened = true;
+			}
+		}
+
+		if (ocf_mngt_core_init_front_volume(core))
+			goto err;
+
+		core->counters =
+			env_zalloc(sizeof(*core->counters) *
+				OCF_STATS_SHARDS, ENV_MEM_NORMAL);
+		if (!core->counters)
+			goto err;
+
+		if (!core->opened) {
+			env_bit_set(ocf_cache_state_incomplete,
+					&cache->cache_state);
+			cache->ocf_core_inactive_count++;
+			ocf_cache_log(cache, log_warn,
+					"Cannot find core %u in pool"
+					", core added as inactive\n", i);
+			continue;
+		}
+
+		hd_lines = ocf_bytes_2_lines(cache,
+				ocf_volume_get_length(
+				&cache->core[i].volume));
+
+		if (hd_lines) {
+			ocf_cache_log(cache, log_info,
+				"Disk lines = %" ENV_PRIu64 "\n", hd_lines);
+		}
+	}
+
+	env_vfree(add_context);
+
+	context->flags.cores_opened = true;
+	cmpl(context, 0);
+	return;
+
+err:
+	env_vfree(add_context);
+
+	_ocf_mngt_close_all_uninitialized_cores(cache);
+
+	cmpl(context, -OCF_ERR_START_CACHE_FAIL);
+}
+
+static void _ocf_mngt_init_instance_add_cores_complete(
+		struct ocf_mngt_add_cores_context *add_context)
+{
+	if (env_atomic_dec_return(&add_context->remaining))
+		return;
+
+	_ocf_mngt_init_instance_add_cores_finish(add_context);
+}
+
+/*
+ * Open next core waiting for it, returns false if there are none left
+ */
+static bool _ocf_mngt_init_instance_open_next_core(
+		struct ocf_mngt_add_cores_context *add_context)
+{
+	ocf_cache_t cache = add_context->attach->cache;
+	uint32_t next = env_atomic_inc_return(&add_context->next) - 1;
+	ocf_core_id_t core_id;
+
+	if (next >= add_context->to_open_no)
+		return false;
+
+	core_id = add_context->to_open[next];
+	add_context->result[core_id] = ocf_volume_open(
+			&cache->core[core_id].volume, NULL);
+
+	return true;
+}
+
+static int _ocf_mngt_init_instance_open_core_job(struct ocf_request *req)
+{
+	struct ocf_mngt_add_cores_context *add_context = req->priv;
+
+	if (_ocf_mngt_init_instance_open_next_core(add_context)) {
+		/* Give way to other requests before opening next core */
+		ocf_engine_push_req_back(req, false);
+		return 0;
+	}
+
+	ocf_req_put(req);
+	_ocf_mngt_init_instance_add_cores_complete(add_context);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_open_core_job = {
+	.read = _ocf_mngt_init_instance_open_core_job,
+	.write = _ocf_mngt_init_instance_open_core_job,
+};
+
 /**
  * @brief routine loading metadata from cache device
  *  - attempts to open all the underlying cores
+ *
+ * Cores which are not in core pool are opened concurrently by up to
+ * OCF_MNGT_CORE_OPEN_JOBS jobs executed on I/O queues of cache.
  */
-static int _ocf_mngt_init_instance_add_cores(
-		struct ocf_cache_attach_context *context)
+static void _ocf_mngt_init_instance_add_cores(
+		struct ocf_cache_attach_context *context,
+		_ocf_mngt_add_cores_end_t cmpl)
 {
 	ocf_cache_t cache = context->cache;
+	struct ocf_mngt_add_cores_context *add_context;
+	ocf_queue_t queues[OCF_MNGT_CORE_OPEN_JOBS];
+	struct ocf_request *req;
 	/* FIXME: This is temporary hack. Remove after storing name it meta. */
 	char core_name[OCF_CORE_NAME_SIZE];
+	uint32_t jobs_no, queues_no;
 	int ret = -1, i;
-	uint64_t hd_lines = 0;
 
 	OCF_ASSERT_PLUGGED(cache);
 
@@ -373,9 +545,19 @@ static int _ocf_mngt_init_instance_add_cores(
 	    ocf_metadata_get_cachelines_count(cache)) {
 		ocf_cache_log(cache, log_err,
 				"ERROR: Cache device size mismatch!\n");
-		return -OCF_ERR_START_CACHE_FAIL;
+		cmpl(context, -OCF_ERR_START_CACHE_FAIL);
+		return;
 	}
 
+	add_context = env_vzalloc(sizeof(*add_context));
+	if (!add_context) {
+		cmpl(context, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	add_context->attach = context;
+	add_context->cmpl = cmpl;
+
 	/* Count value will be re-calculated on the basis of 'added' flag */
 	cache->conf_meta->core_count = 0;
 
@@ -412,58 +594,56 @@ static int _ocf_mngt_init_instance_add_cores(
 			ocf_cache_log(cache, log_info,
 					"Attached core %u from pool\n", i);
 		} else {
-			ret = ocf_volume_open(&core->volume, NULL);
-			if (ret == -OCF_ERR_NOT_OPEN_EXC) {
-				ocf_cache_log(cache, log_warn,
-						"Cannot open core %u. "
-						"Cache is busy", i);
-			} else if (ret) {
-				ocf_cache_log(cache, log_warn,
-						"Cannot open core %u", i);
-			} else {
-				core->opened = true;
-			}
+			add_context->to_open[add_context->to_open_no++] = i;
+			add_context->opening[i] = true;
 		}
 
 		env_bit_set(i, cache->conf_meta->valid_core_bitmap);
 		cache->conf_meta->core_count++;
 		core->volume.cache = cache;
+	}
 
-		if (ocf_mngt_core_init_front_volume(core))
-			goto err;
+	jobs_no = OCF_MIN(add_context->to_open_no, OCF_MNGT_CORE_OPEN_JOBS);
+	if (!jobs_no) {
+		_ocf_mngt_init_instance_add_cores_finish(add_context);
+		return;
+	}
 
-		core->counters =
-			env_zalloc(sizeof(*core->counters), ENV_MEM_NORMAL);
-		if (!core->counters)
-			goto err;
+	queues_no = ocf_queue_get_io_queues(cache, queues, jobs_no);
+	jobs_no = OCF_MIN(jobs_no, queues_no);
 
-		if (!core->opened) {
-			env_bit_set(ocf_cache_state_incomplete,
-					&cache->cache_state);
-			cache->ocf_core_inactive_count++;
-			ocf_cache_log(cache, log_warn,
-					"Cannot find core %u in pool"
-					", core added as inactive\n", i);
+	env_atomic_set(&add_context->remaining, jobs_no + 1);
+
+	for (i = 0; i < jobs_no; i++) {
+		req = ocf_req_new(queues[i], NULL, 0, 0, OCF_READ);
+		if (!req) {
+			/* Open cores here then */
+			while (_ocf_mngt_init_instance_open_next_core(
+					add_context))
+				;
+			_ocf_mngt_init_instance_add_cores_complete(add_context);
 			continue;
 		}
 
-		hd_lines = ocf_bytes_2_lines(cache,
-				ocf_volume_get_length(
-				&cache->core[i].volume));
+		req->info.internal = true;
+		req->io_if = &_io_if_open_core_job;
+		req->priv = add_context;
 
-		if (hd_lines) {
-			ocf_cache_log(cache, log_info,
-				"Disk lines = %" ENV_PRIu64 "\n", hd_lines);
-		}
+		ocf_engine_push_req_back(req, false);
 	}
 
-	context->flags.cores_opened = true;
-	return 0;
+	for (i = 0; i < queues_no; i++)
+		ocf_queue_put(queues[i]);
+
+	_ocf_mngt_init_instance_add_cores_complete(add_context);
+	return;
 
 err:
+	env_vfree(add_context);
+
 	_ocf_mngt_close_all_uninitialized_cores(cache);
 
-	return -OCF_ERR_START_CACHE_FAIL;
+	cmpl(context, -OCF_ERR_START_CACHE_FAIL);
 }
 
 void _ocf_mngt_init_instance_load_complete(void *priv, int error)
@@ -480,6 +660,8 @@ void _ocf_mngt_init_instance_load_complete(void *priv, int error)
 		return;
 	}
 
+	ocf_core_index_attach(cache);
+
 	cleaning_policy = cache->conf_meta->cleaning_policy_type;
 	if (!cleaning_policy_ops[cleaning_policy].initialize)
 		goto out;
@@ -508,11 +690,17 @@ static void _ocf_mngt_init_instance_clean_load(
 /**
  * handle recovery variant
  */
-static void _ocf_mngt_init_instance_recovery(
-		struct ocf_cache_attach_context *context)
+static void _ocf_mngt_init_instance_recovery_init_complete(void *priv,
+		int error)
 {
+	struct ocf_cache_attach_context *context = priv;
 	ocf_cache_t cache = context->cache;
 
+	if (error) {
+		ocf_pipeline_finish(context->pipeline, error);
+		return;
+	}
+
 	init_attached_data_structures_recovery(cache);
 
 	ocf_cache_log(cache, log_warn,
@@ -524,17 +712,18 @@ static void _ocf_mngt_init_instance_recovery(
 			_ocf_mngt_init_instance_load_complete, context);
 }
 
-static void _ocf_mngt_init_instance_load(
+static void _ocf_mngt_init_instance_recovery(
 		struct ocf_cache_attach_context *context)
 {
-	ocf_cache_t cache = context->cache;
-	int ret;
-
-	OCF_ASSERT_PLUGGED(cache);
+	ocf_metadata_init_collision(context->cache,
+			_ocf_mngt_init_instance_recovery_init_complete, context);
+}
 
-	ret = _ocf_mngt_init_instance_add_cores(context);
-	if (ret) {
-		ocf_pipeline_finish(context->pipeline, ret);
+static void _ocf_mngt_init_instance_load_cores_added(
+		struct ocf_cache_attach_context *context, int error)
+{
+	if (error) {
+		ocf_pipeline_finish(context->pipeline, error);
 		return;
 	}
 
@@ -544,6 +733,15 @@ static void _ocf_mngt_init_instance_load(
 		_ocf_mngt_init_instance_recovery(context);
 }
 
+static void _ocf_mngt_init_instance_load(
+		struct ocf_cache_attach_context *context)
+{
+	OCF_ASSERT_PLUGGED(context->cache);
+
+	_ocf_mngt_init_instance_add_cores(context,
+			_ocf_mngt_init_instance_load_cores_added);
+}
+
 /**
  * @brief allocate memory for new cache, add it to cache queue, set initial
  * values and running state
@@ -569,9 +767,6 @@ static int _ocf_mngt_init_new_cache(struct ocf_cachemng_init_params *params)
 	/* Copy all required initialization parameters */
 	cache->cache_id = params->id;
 
-	env_atomic_set(&(cache->last_access_ms),
-			env_ticks_to_msecs(env_get_tick_count()));
-
 	env_bit_set(ocf_cache_state_initializing, &cache->cache_state);
 
 	params->cache = cache;
@@ -700,14 +895,23 @@ static int _ocf_mngt_init_prepare_cache(struct ocf_cachemng_init_params *param,
 
 	cache->backfill.max_queue_size = cfg->backfill.max_queue_size;
 	cache->backfill.queue_unblock_size = cfg->backfill.queue_unblock_size;
+	cache->backfill.zero_copy = cfg->backfill.zero_copy;
+	cache->backfill.latency_target_us = cfg->backfill.latency_target_us;
+	env_atomic_set(&cache->backfill.queue_limit,
+			cfg->backfill.max_queue_size);
+	env_atomic64_set(&cache->backfill.write_latency, 0);
 
 	env_rwsem_down_write(&cache->lock); /* Lock cache during setup */
 	param->flags.cache_locked = true;
 
 	cache->pt_unaligned_io = cfg->pt_unaligned_io;
 	cache->use_submit_io_fast = cfg->use_submit_io_fast;
+	cache->flush_queue_depth = OCF_CACHE_FLUSH_QUEUE_DEPTH_DEFAULT;
+	cache->debug_stats = OCF_CONFIG_DEBUG_STATS;
+	ocf_cleaner_setup(cache, cfg->cleaner_instances);
 
 	cache->eviction_policy_init = cfg->eviction_policy;
+	ocf_promotion_setup(cache, cfg->promotion_policy);
 	cache->metadata.is_volatile = cfg->metadata_volatile;
 
 out:
@@ -906,7 +1110,8 @@ static void _ocf_mngt_test_volume(ocf_pipeline_t pipeline,
 
 	cache->device->volume.features.discard_zeroes = 1;
 
-	if (!context->cfg.perform_test) {
+	if (!context->cfg.perform_test ||
+			cache->device->volume.type->properties->caps.tested) {
 		ocf_pipeline_next(pipeline);
 		return;
 	}
@@ -966,6 +1171,11 @@ static void _ocf_mngt_attach_load_properties_end(void *priv, int error,
 		context->metadata.line_size = properties->line_size;
 		cache->conf_meta->metadata_layout = properties->layout;
 		cache->conf_meta->cache_mode = properties->cache_mode;
+		cache->conf_meta->hash_load_factor =
+				properties->hash_load_factor;
+		cache->conf_meta->eviction_policy_type =
+				properties->eviction_policy;
+		context->metadata.max_size = properties->max_size;
 	}
 
 	ocf_pipeline_next(context->pipeline);
@@ -982,6 +1192,10 @@ static void _ocf_mngt_attach_load_properties(ocf_pipeline_t pipeline,
 	context->metadata.shutdown_status = ocf_metadata_clean_shutdown;
 	context->metadata.dirty_flushed = DIRTY_FLUSHED;
 	context->metadata.line_size = context->cfg.cache_line_size;
+	context->metadata.max_size = OCF_MAX(context->volume_size,
+			context->cfg.max_size);
+	/* Policy of previously attached device might have been loaded */
+	cache->conf_meta->eviction_policy_type = cache->eviction_policy_init;
 
 	if (cache->device->init_mode == ocf_init_mode_metadata_volatile) {
 		ocf_pipeline_next(context->pipeline);
@@ -1012,7 +1226,7 @@ static void _ocf_mngt_attach_prepare_metadata(ocf_pipeline_t pipeline,
 	/*
 	 * Initialize variable size metadata segments
 	 */
-	if (ocf_metadata_init_variable_size(cache, context->volume_size,
+	if (ocf_metadata_init_variable_size(cache, context->metadata.max_size,
 			context->metadata.line_size,
 			cache->conf_meta->metadata_layout)) {
 		ocf_pipeline_finish(context->pipeline,
@@ -1020,6 +1234,8 @@ static void _ocf_mngt_attach_prepare_metadata(ocf_pipeline_t pipeline,
 		return;
 	}
 
+	cache->conf_meta->max_size = context->metadata.max_size;
+
 	ocf_cache_log(cache, log_debug, "Cache attached\n");
 	context->flags.attached_metadata_inited = true;
 
@@ -1038,6 +1254,67 @@ static void _ocf_mngt_attach_prepare_metadata(ocf_pipeline_t pipeline,
 
 	context->flags.concurrency_inited = 1;
 
+	ret = ocf_promotion_attach(cache);
+	if (ret) {
+		ocf_pipeline_finish(context->pipeline, ret);
+		return;
+	}
+
+	context->flags.promotion_attached = 1;
+
+	ret = ocf_eviction_ghost_attach(cache);
+	if (ret) {
+		ocf_pipeline_finish(context->pipeline, ret);
+		return;
+	}
+
+	context->flags.ghost_attached = 1;
+
+	ret = ocf_ram_tier_attach(cache);
+	if (ret) {
+		ocf_pipeline_finish(context->pipeline, ret);
+		return;
+	}
+
+	context->flags.ram_tier_attached = 1;
+
+	ret = ocf_fill_attach(cache);
+	if (ret) {
+		ocf_pipeline_finish(context->pipeline, ret);
+		return;
+	}
+
+	context->flags.fill_attached = 1;
+
+	ret = ocf_zero_lines_attach(cache);
+	if (ret) {
+		ocf_pipeline_finish(context->pipeline, ret);
+		return;
+	}
+
+	context->flags.zero_lines_attached = 1;
+
+	ocf_pipeline_next(context->pipeline);
+}
+
+static void _ocf_mngt_init_instance_init_complete(void *priv, int error)
+{
+	struct ocf_cache_attach_context *context = priv;
+	ocf_cache_t cache = context->cache;
+
+	if (error) {
+		ocf_pipeline_finish(context->pipeline, error);
+		return;
+	}
+
+	init_attached_data_structures(cache, cache->eviction_policy_init);
+	ocf_core_index_attach(cache);
+
+	/* In initial cache state there is no dirty data, so all dirty data is
+	   considered to be flushed
+	 */
+	cache->conf_meta->dirty_flushed = true;
+
 	ocf_pipeline_next(context->pipeline);
 }
 
@@ -1069,44 +1346,39 @@ static void _ocf_mngt_init_instance_init(struct ocf_cache_attach_context *contex
 		}
 	}
 
-	init_attached_data_structures(cache, cache->eviction_policy_init);
-
-	/* In initial cache state there is no dirty data, so all dirty data is
-	   considered to be flushed
-	 */
-	cache->conf_meta->dirty_flushed = true;
-
-	ocf_pipeline_next(context->pipeline);
+	ocf_metadata_init_collision(cache, _ocf_mngt_init_instance_init_complete,
+			context);
 }
 
-uint64_t _ocf_mngt_calculate_ram_needed(ocf_cache_t cache,
-		ocf_volume_t cache_volume)
+static int _ocf_mngt_calculate_ram_needed(ocf_cache_t cache,
+		ocf_volume_t cache_volume, ocf_cache_line_size_t line_size,
+		uint64_t max_size, struct ocf_mngt_cache_ram_needed *ram)
 {
-	ocf_cache_line_size_t line_size = ocf_line_size(cache);
-	uint64_t volume_size = ocf_volume_get_length(cache_volume);
-	uint64_t const_data_size;
-	uint64_t cache_line_no;
-	uint64_t data_per_line;
-	uint64_t min_free_ram;
-
-	/* Superblock + per core metadata */
-	const_data_size = 50 * MiB;
+	uint64_t volume_size = OCF_MAX(ocf_volume_get_length(cache_volume),
+			max_size);
+	int result;
 
-	/* Cache metadata */
-	cache_line_no = volume_size / line_size;
-	data_per_line = (52 + (2 * (line_size / KiB / 4)));
+	result = ocf_metadata_size_estimate(cache, volume_size, line_size,
+			ocf_volume_is_atomic(cache_volume), ram);
+	if (result)
+		return result;
 
-	min_free_ram = const_data_size + cache_line_no * data_per_line;
+	ram->concurrency = ocf_cache_concurrency_size_for(ram->cache_lines);
+	ram->other += ocf_eviction_ghost_size_of(ram->cache_lines);
+	ram->other += ocf_promotion_size_of(cache, ram->cache_lines);
 
-	/* 110% of calculated value */
-	min_free_ram = (11 * min_free_ram) / 10;
+	ram->total = ram->cleaning + ram->eviction + ram->collision +
+			ram->list_info + ram->hash + ram->concurrency +
+			ram->other;
 
-	return min_free_ram;
+	return 0;
 }
 
-int ocf_mngt_get_ram_needed(ocf_cache_t cache,
-		struct ocf_mngt_cache_device_config *cfg, uint64_t *ram_needed)
+int ocf_mngt_get_ram_needed_detail(ocf_cache_t cache,
+		struct ocf_mngt_cache_device_config *cfg,
+		struct ocf_mngt_cache_ram_needed *ram_needed)
 {
+	ocf_cache_line_size_t line_size;
 	struct ocf_volume volume;
 	ocf_volume_type_t type;
 	int result;
@@ -1115,12 +1387,15 @@ int ocf_mngt_get_ram_needed(ocf_cache_t cache,
 	OCF_CHECK_NULL(cfg);
 	OCF_CHECK_NULL(ram_needed);
 
+	line_size = cfg->cache_line_size ?: ocf_line_size(cache);
+	if (!ocf_cache_line_size_is_valid(line_size))
+		return -OCF_ERR_INVALID_CACHE_LINE_SIZE;
+
 	type = ocf_ctx_get_volume_type(cache->owner, cfg->volume_type);
 	if (!type)
 		return -OCF_ERR_INVAL_VOLUME_TYPE;
 
-	result = ocf_volume_init(&cache->device->volume, type,
-			&cfg->uuid, false);
+	result = ocf_volume_init(&volume, type, &cfg->uuid, false);
 	if (result)
 		return result;
 
@@ -1130,11 +1405,29 @@ int ocf_mngt_get_ram_needed(ocf_cache_t cache,
 		return result;
 	}
 
-	*ram_needed = _ocf_mngt_calculate_ram_needed(cache, &volume);
+	result = _ocf_mngt_calculate_ram_needed(cache, &volume, line_size,
+			cfg->max_size, ram_needed);
 
 	ocf_volume_close(&volume);
 	ocf_volume_deinit(&volume);
 
+	return result;
+}
+
+int ocf_mngt_get_ram_needed(ocf_cache_t cache,
+		struct ocf_mngt_cache_device_config *cfg, uint64_t *ram_needed)
+{
+	struct ocf_mngt_cache_ram_needed ram;
+	int result;
+
+	OCF_CHECK_NULL(ram_needed);
+
+	result = ocf_mngt_get_ram_needed_detail(cache, cfg, &ram);
+	if (result)
+		return result;
+
+	*ram_needed = ram.total;
+
 	return 0;
 }
 
@@ -1189,6 +1482,21 @@ static void _ocf_mngt_attach_handle_error(
 	if (context->flags.device_opened)
 		ocf_volume_close(&cache->device->volume);
 
+	if (context->flags.ram_tier_attached)
+		ocf_ram_tier_detach(cache);
+
+	if (context->flags.fill_attached)
+		ocf_fill_detach(cache);
+
+	if (context->flags.zero_lines_attached)
+		ocf_zero_lines_detach(cache);
+
+	if (context->flags.ghost_attached)
+		ocf_eviction_ghost_detach(cache);
+
+	if (context->flags.promotion_attached)
+		ocf_promotion_detach(cache);
+
 	if (context->flags.concurrency_inited)
 		ocf_concurrency_deinit(cache);
 
@@ -1209,6 +1517,9 @@ static int _ocf_mngt_cache_init(ocf_cache_t cache,
 	 */
 	cache->conf_meta->cache_mode = params->metadata.cache_mode;
 	cache->conf_meta->metadata_layout = params->metadata.layout;
+	cache->conf_meta->hash_load_factor = params->metadata.hash_load_factor;
+	cache->conf_meta->eviction_policy_type =
+			params->metadata.eviction_policy;
 
 	for (i = 0; i < OCF_IO_CLASS_MAX + 1; ++i) {
 		cache->user_parts[i].config =
@@ -1216,6 +1527,26 @@ static int _ocf_mngt_cache_init(ocf_cache_t cache,
 	}
 
 	INIT_LIST_HEAD(&cache->io_queues);
+	env_rwlock_init(&cache->io_queues_lock);
+
+	env_spinlock_init(&cache->eviction_waiters.lock);
+	INIT_LIST_HEAD(&cache->eviction_waiters.list);
+
+	ocf_checkpoint_init(cache);
+
+#if OCF_CONFIG_PART_MOVE_BATCH > 0
+	env_spinlock_init(&cache->part_moves.lock);
+#endif
+
+#if OCF_CONFIG_STATS_WINDOW > 0
+	env_spinlock_init(&cache->stats_window.lock);
+#endif
+
+	for (i = 0; i < OCF_CORE_MAX; i++) {
+		ocf_seq_cutoff_init(&cache->core[i]);
+		ocf_cleaner_core_init(&cache->core[i]);
+		ocf_engine_ops_init(&cache->core[i]);
+	}
 
 	/* Init Partitions */
 	ocf_part_init(cache);
@@ -1241,6 +1572,9 @@ static int _ocf_mngt_cache_start(ocf_ctx_t ctx, ocf_cache_t *cache,
 	params.metadata.cache_mode = cfg->cache_mode;
 	params.metadata.layout = cfg->metadata_layout;
 	params.metadata.line_size = cfg->cache_line_size;
+	params.metadata.hash_load_factor = cfg->hash_load_factor ?:
+			OCF_HASH_LOAD_FACTOR_DEFAULT;
+	params.metadata.eviction_policy = cfg->eviction_policy;
 	params.metadata_volatile = cfg->metadata_volatile;
 	params.locked = cfg->locked;
 
@@ -1344,11 +1678,20 @@ static void _ocf_mngt_attach_check_ram(ocf_pipeline_t pipeline,
 {
 	struct ocf_cache_attach_context *context = priv;
 	ocf_cache_t cache = context->cache;
+	struct ocf_mngt_cache_ram_needed ram;
 	uint64_t min_free_ram;
 	uint64_t free_ram;
+	int result;
 
-	min_free_ram = _ocf_mngt_calculate_ram_needed(cache,
-			&cache->device->volume);
+	result = _ocf_mngt_calculate_ram_needed(cache, &cache->device->volume,
+			context->cfg.cache_line_size ?: ocf_line_size(cache),
+			context->cfg.max_size, &ram);
+	if (result) {
+		ocf_pipeline_finish(pipeline, result);
+		return;
+	}
+
+	min_free_ram = ram.total;
 
 	free_ram = env_get_free_memory();
 
@@ -1360,6 +1703,7 @@ static void _ocf_mngt_attach_check_ram(ocf_pipeline_t pipeline,
 		ocf_cache_log(cache, log_err, "Needed RAM: %" ENV_PRIu64 " B\n",
 				min_free_ram);
 		ocf_pipeline_finish(pipeline, -OCF_ERR_NO_FREE_RAM);
+		return;
 	}
 
 	ocf_pipeline_next(pipeline);
@@ -1433,7 +1777,126 @@ static void _ocf_mngt_attach_clean_pol(ocf_pipeline_t pipeline,
 		}
 	}
 
-	ocf_pipeline_next(context->pipeline);
+	ocf_pipeline_next(context->pipeline);
+}
+
+/* Number of cache lines which fit on cache volume after metadata */
+static ocf_cache_line_t _ocf_mngt_cache_lines_fit(ocf_cache_t cache)
+{
+	uint64_t length = ocf_volume_get_length(&cache->device->volume);
+	uint64_t lines = 0;
+
+	if (length > cache->device->metadata_offset) {
+		lines = (length - cache->device->metadata_offset) /
+				ocf_line_size(cache);
+	}
+
+	return OCF_MIN(lines,
+			(uint64_t)cache->device->collision_table_entries);
+}
+
+/* Put cache lines retired while capacity was lower back on free list */
+static void _ocf_mngt_cache_grow(ocf_cache_t cache, ocf_cache_line_t limit)
+{
+	ocf_cache_line_t phy, line, old_limit = cache->device->lines_limit;
+
+	/* Lines below limit are put on free list instead of being retired */
+	cache->device->lines_limit = limit;
+
+	for (phy = old_limit; phy < limit; phy++) {
+		line = ocf_metadata_map_phy2lg(cache, phy);
+		if (ocf_metadata_get_core_id(cache, line) != OCF_CORE_MAX) {
+			/* Still in use, goes to free list once evicted */
+			continue;
+		}
+
+		ocf_metadata_add_to_free_list(cache, line);
+	}
+}
+
+/*
+ * Take free cache lines above limit off free list and evict clean ones which
+ * are not used by requests. Remaining lines get retired once evicted.
+ * Returns number of cache lines left retiring.
+ */
+static uint32_t _ocf_mngt_cache_shrink(ocf_cache_t cache,
+		ocf_cache_line_t limit)
+{
+	bool atomic = ocf_volume_is_atomic(&cache->device->volume);
+	ocf_cache_line_t phy, line, old_limit = cache->device->lines_limit;
+	uint32_t retiring = 0;
+
+	/* Lines held by queues have to be on free list to be found there */
+	ocf_queue_freelist_drain_all_locked(cache);
+
+	cache->device->lines_limit = limit;
+
+	for (phy = limit; phy < old_limit; phy++) {
+		line = ocf_metadata_map_phy2lg(cache, phy);
+		if (ocf_metadata_get_core_id(cache, line) == OCF_CORE_MAX) {
+			/* Putting line back beyond limit retires it */
+			ocf_metadata_remove_from_free_list(cache, line);
+			ocf_metadata_add_to_free_list(cache, line);
+			continue;
+		}
+
+		/* Atomic cache lines have to be trimmed on eviction */
+		if (atomic || metadata_test_dirty(cache, line) ||
+				ocf_cache_line_is_used(cache, line)) {
+			retiring++;
+			continue;
+		}
+
+		set_cache_line_invalid_no_flush(cache, 0,
+				ocf_line_end_sector(cache), line);
+	}
+
+	return retiring;
+}
+
+/*
+ * Limit cache lines in use to capacity stored in metadata, or to cache volume
+ * size if cache is initialized. Metadata may be sized for larger cache device,
+ * in which case lines above the limit are retired until cache is resized.
+ */
+static void _ocf_mngt_attach_capacity(ocf_pipeline_t pipeline,
+		void *priv, ocf_pipeline_arg_t arg)
+{
+	struct ocf_cache_attach_context *context = priv;
+	ocf_cache_t cache = context->cache;
+	ocf_cache_line_t limit = _ocf_mngt_cache_lines_fit(cache);
+	uint32_t retiring = 0;
+
+	if (cache->device->init_mode == ocf_init_mode_load) {
+		if (cache->conf_meta->lines_limit > limit) {
+			ocf_cache_log(cache, log_err, "Cache device is smaller "
+					"than cache capacity\n");
+			ocf_pipeline_finish(context->pipeline,
+					-OCF_ERR_START_CACHE_FAIL);
+			return;
+		}
+		limit = cache->conf_meta->lines_limit;
+	}
+
+	if (cache->device->init_mode == ocf_init_mode_load &&
+			context->metadata.shutdown_status ==
+					ocf_metadata_clean_shutdown) {
+		/* Lines above limit are off loaded free list already */
+		cache->device->lines_limit = limit;
+	} else if (limit < cache->device->lines_limit) {
+		OCF_METADATA_LOCK_WR();
+		retiring = _ocf_mngt_cache_shrink(cache, limit);
+		OCF_METADATA_UNLOCK_WR();
+	}
+
+	cache->conf_meta->lines_limit = limit;
+
+	if (retiring) {
+		ocf_cache_log(cache, log_info, "%u cache lines above capacity "
+				"will be released once evicted\n", retiring);
+	}
+
+	ocf_pipeline_next(pipeline);
 }
 
 static void _ocf_mngt_attach_flush_metadata_complete(void *priv, int error)
@@ -1506,6 +1969,14 @@ static void _ocf_mngt_attach_discard(ocf_pipeline_t pipeline,
 		return;
 	}
 
+	if (context->cfg.discard_in_background &&
+			!ocf_volume_is_atomic(&cache->device->volume)) {
+		/* Discarded after attach, see _ocf_mngt_attach_bg_discard() */
+		context->flags.bg_discard = true;
+		ocf_pipeline_next(context->pipeline);
+		return;
+	}
+
 	if (!discard && ocf_volume_is_atomic(&cache->device->volume)) {
 		/* discard doesn't zero data - need to explicitly write zeros */
 		ocf_submit_write_zeros(&cache->device->volume, addr, length,
@@ -1568,6 +2039,159 @@ static void _ocf_mngt_attach_shutdown_status(ocf_pipeline_t pipeline,
 		_ocf_mngt_attach_shutdown_status_complete, context);
 }
 
+/* Size of cache device range discarded in background at once */
+#define OCF_MNGT_BG_DISCARD_CHUNK (256 * MiB)
+
+static void _ocf_mngt_bg_discard_release(ocf_cache_t cache,
+		ocf_cache_line_t end)
+{
+	struct ocf_cache_device *device = cache->device;
+	ocf_cache_line_t phy;
+
+	OCF_METADATA_LOCK_WR();
+	for (phy = device->bg_discard.released; phy < end; phy++) {
+		ocf_metadata_add_to_free_list(cache,
+				ocf_metadata_map_phy2lg(cache, phy));
+		ocf_trim_unmark(cache, phy);
+	}
+	OCF_METADATA_UNLOCK_WR();
+
+	device->bg_discard.released = end;
+}
+
+static void _ocf_mngt_bg_discard_complete(void *priv, int error)
+{
+	struct ocf_request *req = priv;
+
+	if (error)
+		req->cache->device->bg_discard.error = error;
+
+	ocf_engine_push_req_back(req, false);
+}
+
+static int _ocf_mngt_bg_discard_step(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_cache_device *device = cache->device;
+	uint64_t line_size = ocf_line_size(cache);
+	ocf_cache_line_t released;
+
+	/* Range submitted in previous step is discarded by now */
+	_ocf_mngt_bg_discard_release(cache, device->bg_discard.submitted);
+
+	if (device->bg_discard.submitted == device->bg_discard.end ||
+			device->bg_discard.error ||
+			env_atomic_read(&device->bg_discard.cancel)) {
+		_ocf_mngt_bg_discard_release(cache, device->bg_discard.end);
+
+		if (device->bg_discard.error) {
+			ocf_cache_log(cache, log_warn, "Discarding cache device "
+					"in background failed\n");
+		} else if (device->bg_discard.submitted !=
+				device->bg_discard.end) {
+			ocf_cache_log(cache, log_info, "Discarding cache device "
+					"in background interrupted\n");
+		} else {
+			ocf_cache_log(cache, log_info, "Cache device discarded "
+					"in background\n");
+		}
+
+		ocf_req_put(req);
+		return 0;
+	}
+
+	released = device->bg_discard.released;
+	device->bg_discard.submitted = OCF_MIN(device->bg_discard.end,
+			released + OCF_MNGT_BG_DISCARD_CHUNK / line_size);
+
+	ocf_submit_volume_discard(&device->volume,
+			device->metadata_offset + released * line_size,
+			(device->bg_discard.submitted - released) * line_size,
+			_ocf_mngt_bg_discard_complete, req);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_bg_discard = {
+	.read = _ocf_mngt_bg_discard_step,
+	.write = _ocf_mngt_bg_discard_step,
+};
+
+/*
+ * Take all cache lines off free list, so that no I/O is mapped to a range
+ * which is not discarded yet. Has to be done before cache is marked attached.
+ */
+static void _ocf_mngt_attach_bg_discard_prepare(ocf_cache_t cache)
+{
+	struct ocf_cache_device *device = cache->device;
+	ocf_cache_line_t entries = device->collision_table_entries;
+
+	device->bg_discard.released = 0;
+	device->bg_discard.submitted = 0;
+	device->bg_discard.end = device->lines_limit;
+	device->bg_discard.error = 0;
+	env_atomic_set(&device->bg_discard.cancel, 0);
+
+	OCF_METADATA_LOCK_WR();
+	device->freelist_part->head = entries;
+	device->freelist_part->tail = entries;
+	device->freelist_part->curr_size = 0;
+	OCF_METADATA_UNLOCK_WR();
+}
+
+/*
+ * Discard cache device range by range on I/O queue, putting cache lines on
+ * free list as their range gets discarded. Until then misses are serviced in
+ * pass-through, as there are no free cache lines to map them to. Request is
+ * allocated with cache attached, so it holds back detach and stop, which
+ * interrupt it with _ocf_mngt_cache_bg_discard_cancel().
+ */
+static void _ocf_mngt_attach_bg_discard(ocf_cache_t cache)
+{
+	struct ocf_request *req = NULL;
+	ocf_queue_t queue, io_queue = NULL;
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+	list_for_each_entry(queue, &cache->io_queues, list) {
+		if (queue == cache->mngt_queue)
+			continue;
+
+		/* Queue may be already on its way to be freed */
+		if (env_atomic_add_unless(&queue->ref_count, 1, 0)) {
+			io_queue = queue;
+			break;
+		}
+	}
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+
+	if (io_queue) {
+		req = ocf_req_new(io_queue, NULL, 0, 0, OCF_READ);
+		ocf_queue_put(io_queue);
+	}
+
+	if (!req) {
+		ocf_cache_log(cache, log_warn, "Cannot discard cache device "
+				"in background\n");
+		_ocf_mngt_bg_discard_release(cache,
+				cache->device->bg_discard.end);
+		return;
+	}
+
+	req->info.internal = true;
+	req->io_if = &_io_if_bg_discard;
+
+	ocf_cache_log(cache, log_info, "Discarding cache device "
+			"in background\n");
+
+	ocf_engine_push_req_back(req, false);
+}
+
+static void _ocf_mngt_cache_bg_discard_cancel(ocf_cache_t cache)
+{
+	if (cache->device)
+		env_atomic_set(&cache->device->bg_discard.cancel, 1);
+}
+
 static void _ocf_mngt_attach_post_init(ocf_pipeline_t pipeline,
 		void *priv, ocf_pipeline_arg_t arg)
 {
@@ -1586,10 +2210,24 @@ static void _ocf_mngt_attach_post_init(ocf_pipeline_t pipeline,
 		context->flags.cleaner_started = true;
 	}
 
-	env_waitqueue_init(&cache->pending_cache_wq);
+	if (context->flags.bg_discard)
+		_ocf_mngt_attach_bg_discard_prepare(cache);
+
+	ocf_metadata_free_map_rebuild(cache);
+
+	ocf_metadata_lookup_filter_rebuild(cache);
 
 	env_atomic_set(&cache->attached, 1);
 
+	if (context->flags.bg_discard)
+		_ocf_mngt_attach_bg_discard(cache);
+
+	/* Build eviction plan from partition sizes set up on attach */
+	ocf_part_sort(cache);
+
+	/* IO class configuration may have been loaded from cache device */
+	ocf_part_class_map_publish(cache);
+
 	ocf_pipeline_next(context->pipeline);
 }
 
@@ -1619,6 +2257,7 @@ struct ocf_pipeline_properties _ocf_mngt_cache_attach_pipeline_properties = {
 		OCF_PL_STEP(_ocf_mngt_attach_load_superblock),
 		OCF_PL_STEP(_ocf_mngt_attach_init_instance),
 		OCF_PL_STEP(_ocf_mngt_attach_clean_pol),
+		OCF_PL_STEP(_ocf_mngt_attach_capacity),
 		OCF_PL_STEP(_ocf_mngt_attach_flush_metadata),
 		OCF_PL_STEP(_ocf_mngt_attach_discard),
 		OCF_PL_STEP(_ocf_mngt_attach_flush),
@@ -1699,6 +2338,11 @@ static int _ocf_mngt_cache_validate_cfg(struct ocf_mngt_cache_config *cfg)
 		return -OCF_ERR_INVAL;
 	}
 
+	if (cfg->promotion_policy >= ocf_promotion_max ||
+			cfg->promotion_policy < 0) {
+		return -OCF_ERR_INVAL;
+	}
+
 	if (!ocf_cache_line_size_is_valid(cfg->cache_line_size))
 		return -OCF_ERR_INVALID_CACHE_LINE_SIZE;
 
@@ -1707,6 +2351,12 @@ static int _ocf_mngt_cache_validate_cfg(struct ocf_mngt_cache_config *cfg)
 		return -OCF_ERR_INVAL;
 	}
 
+	if (cfg->cleaner_instances > OCF_CLEANER_INSTANCES_MAX)
+		return -OCF_ERR_INVAL;
+
+	if (cfg->hash_load_factor > OCF_HASH_LOAD_FACTOR_MAX)
+		return -OCF_ERR_INVAL;
+
 	return 0;
 }
 
@@ -1837,6 +2487,11 @@ static void _ocf_mngt_cache_unplug_complete(void *priv, int error)
 	ocf_volume_close(&cache->device->volume);
 
 	ocf_metadata_deinit_variable_size(cache);
+	ocf_ram_tier_detach(cache);
+	ocf_fill_detach(cache);
+	ocf_zero_lines_detach(cache);
+	ocf_eviction_ghost_detach(cache);
+	ocf_promotion_detach(cache);
 	ocf_concurrency_deinit(cache);
 
 	ocf_volume_deinit(&cache->device->volume);
@@ -1887,6 +2542,11 @@ static void _ocf_mngt_cache_unplug(ocf_cache_t cache, bool stop,
 
 	__deinit_cleaning_policy(cache);
 
+	/* Free cache lines held by I/O queues go back to free list, so that
+	 * flushed free list is complete and queues don't keep stale lines
+	 */
+	ocf_queue_freelist_drain_all(cache);
+
 	if (ocf_mngt_cache_is_dirty(cache)) {
 		ENV_BUG_ON(!stop);
 
@@ -1983,15 +2643,27 @@ struct ocf_mngt_cache_stop_context {
 	int error;
 };
 
+static void ocf_mngt_cache_stop_wait_io_complete(void *priv)
+{
+	struct ocf_mngt_cache_stop_context *context = priv;
+
+	ocf_refcnt_unfreeze(&context->cache->pending_requests);
+
+	ocf_pipeline_next(context->pipeline);
+}
+
 static void ocf_mngt_cache_stop_wait_io(ocf_pipeline_t pipeline,
 		void *priv, ocf_pipeline_arg_t arg)
 {
 	struct ocf_mngt_cache_stop_context *context = priv;
 	ocf_cache_t cache = context->cache;
 
-	/* TODO: Make this asynchronous! */
-	ocf_cache_wait_for_io_finish(cache);
-	ocf_pipeline_next(pipeline);
+	_ocf_mngt_cache_bg_discard_cancel(cache);
+
+	/* Pipeline continues once in-flight requests complete */
+	ocf_refcnt_freeze(&cache->pending_requests);
+	ocf_refcnt_register_zero_cb(&cache->pending_requests,
+			ocf_mngt_cache_stop_wait_io_complete, context);
 }
 
 static void ocf_mngt_cache_stop_remove_cores(ocf_pipeline_t pipeline,
@@ -2226,6 +2898,10 @@ static int _cache_mng_set_cache_mode(ocf_cache_t cache, ocf_cache_mode_t mode)
 
 	cache->conf_meta->cache_mode = mode;
 
+	/* Dirty data is kept again */
+	if (mode == ocf_cache_mode_wb)
+		ocf_cleaner_drain_stop(cache);
+
 	if (ocf_cache_mode_wb == mode_old) {
 		int i;
 
@@ -2270,6 +2946,109 @@ int ocf_mngt_cache_set_mode(ocf_cache_t cache, ocf_cache_mode_t mode)
 	return result;
 }
 
+int ocf_mngt_cache_set_mode_drain(ocf_cache_t cache, ocf_cache_mode_t mode,
+		uint32_t rate)
+{
+	int result;
+
+	OCF_CHECK_NULL(cache);
+
+	if (!ocf_cache_mode_is_valid(mode)) {
+		ocf_cache_log(cache, log_err, "Cache mode %u is invalid\n",
+				mode);
+		return -OCF_ERR_INVAL;
+	}
+
+	if (cache->conf_meta->cleaning_policy_type == ocf_cleaning_nop &&
+			mode != ocf_cache_mode_wb &&
+			ocf_mngt_cache_is_dirty(cache)) {
+		ocf_cache_log(cache, log_err, "Cleaning policy nop can't "
+				"drain dirty data\n");
+		return -OCF_ERR_INVAL;
+	}
+
+	result = ocf_mngt_cache_set_mode(cache, mode);
+	if (result || mode == ocf_cache_mode_wb)
+		return result;
+
+	ocf_cleaner_drain_start(cache, rate);
+
+	if (!cache->cleaner.drain.dirty_initial) {
+		ocf_cleaner_drain_stop(cache);
+		return 0;
+	}
+
+	ocf_cache_log(cache, log_info, "Draining %" ENV_PRIu64 " dirty cache "
+			"lines in background\n",
+			cache->cleaner.drain.dirty_initial);
+
+	return 0;
+}
+
+int ocf_mngt_cache_get_drain_status(ocf_cache_t cache,
+		struct ocf_mngt_cache_drain_status *status)
+{
+	struct ocf_cleaner_drain *drain;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(status);
+
+	drain = &cache->cleaner.drain;
+
+	status->active = env_atomic_read(&drain->active);
+	status->rate = drain->rate;
+	status->dirty_initial = drain->dirty_initial;
+	status->dirty = status->active ? ocf_cleaner_drain_dirty(cache) : 0;
+
+	return 0;
+}
+
+int ocf_mngt_cache_resize(ocf_cache_t cache, uint64_t size)
+{
+	uint64_t lines;
+	uint32_t retiring = 0;
+
+	OCF_CHECK_NULL(cache);
+
+	if (!ocf_cache_is_device_attached(cache)) {
+		ocf_cache_log(cache, log_err, "Cannot resize cache - "
+				"cache device is detached\n");
+		return -OCF_ERR_INVAL;
+	}
+
+	lines = ocf_bytes_2_lines(cache, size);
+	if (size < OCF_CACHE_SIZE_MIN ||
+			lines > _ocf_mngt_cache_lines_fit(cache)) {
+		ocf_cache_log(cache, log_err, "Cannot resize cache - "
+				"size %" ENV_PRIu64 " is invalid\n", size);
+		return -OCF_ERR_INVAL;
+	}
+
+	if (cache->device->bg_discard.released !=
+			cache->device->bg_discard.end) {
+		ocf_cache_log(cache, log_err, "Cannot resize cache - "
+				"cache device is being discarded\n");
+		return -OCF_ERR_CACHE_IN_USE;
+	}
+
+	OCF_METADATA_LOCK_WR();
+	if (lines > cache->device->lines_limit)
+		_ocf_mngt_cache_grow(cache, lines);
+	else
+		retiring = _ocf_mngt_cache_shrink(cache, lines);
+	cache->conf_meta->lines_limit = lines;
+	OCF_METADATA_UNLOCK_WR();
+
+	ocf_cache_log(cache, log_info, "Cache resized to %" ENV_PRIu64
+			" cache lines\n", lines);
+	if (retiring) {
+		ocf_cache_log(cache, log_info, "%u cache lines above capacity "
+				"will be released once evicted\n", retiring);
+	}
+
+	return 0;
+}
+
 int ocf_mngt_cache_reset_fallback_pt_error_counter(ocf_cache_t cache)
 {
 	OCF_CHECK_NULL(cache);
@@ -2324,6 +3103,120 @@ int ocf_mngt_cache_get_fallback_pt_error_threshold(ocf_cache_t cache,
 	return 0;
 }
 
+int ocf_mngt_cache_set_flush_queue_depth(ocf_cache_t cache,
+		uint32_t queue_depth)
+{
+	OCF_CHECK_NULL(cache);
+
+	if (queue_depth < OCF_CACHE_FLUSH_QUEUE_DEPTH_MIN ||
+			queue_depth > OCF_CACHE_FLUSH_QUEUE_DEPTH_MAX) {
+		return -OCF_ERR_INVAL;
+	}
+
+	cache->flush_queue_depth = queue_depth;
+
+	ocf_cache_log(cache, log_info, "Flush queue depth set to %u\n",
+			queue_depth);
+
+	return 0;
+}
+
+int ocf_mngt_cache_get_flush_queue_depth(ocf_cache_t cache,
+		uint32_t *queue_depth)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(queue_depth);
+
+	*queue_depth = cache->flush_queue_depth;
+
+	return 0;
+}
+
+int ocf_mngt_cache_set_debug_stats(ocf_cache_t cache, bool enable)
+{
+	OCF_CHECK_NULL(cache);
+
+	if (cache->debug_stats == enable)
+		return 0;
+
+	cache->debug_stats = enable;
+
+	ocf_cache_log(cache, log_info, "Debug statistics %s\n",
+			enable ? "enabled" : "disabled");
+
+	return 0;
+}
+
+int ocf_mngt_cache_get_debug_stats(ocf_cache_t cache, bool *enabled)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(enabled);
+
+	*enabled = cache->debug_stats;
+
+	return 0;
+}
+
+int ocf_mngt_cache_set_compress_estimate(ocf_cache_t cache, bool enable)
+{
+	int result;
+
+	OCF_CHECK_NULL(cache);
+
+	if (enable) {
+		result = ocf_compress_est_init(cache);
+		if (result)
+			return result;
+	}
+
+	cache->compress_est_enabled = enable;
+
+	ocf_cache_log(cache, log_info, "Compressibility estimation %s\n",
+			enable ? "enabled" : "disabled");
+
+	return 0;
+}
+
+int ocf_mngt_cache_get_compress_estimate(ocf_cache_t cache, bool *enabled)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(enabled);
+
+	*enabled = cache->compress_est_enabled;
+
+	return 0;
+}
+
+int ocf_mngt_cache_set_dedup_estimate(ocf_cache_t cache, bool enable)
+{
+	int result;
+
+	OCF_CHECK_NULL(cache);
+
+	if (enable) {
+		result = ocf_dedup_est_init(cache);
+		if (result)
+			return result;
+	}
+
+	cache->dedup_est_enabled = enable;
+
+	ocf_cache_log(cache, log_info, "Deduplication estimation %s\n",
+			enable ? "enabled" : "disabled");
+
+	return 0;
+}
+
+int ocf_mngt_cache_get_dedup_estimate(ocf_cache_t cache, bool *enabled)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(enabled);
+
+	*enabled = cache->dedup_est_enabled;
+
+	return 0;
+}
+
 struct ocf_mngt_cache_detach_context {
 	ocf_mngt_cache_detach_end_t cmpl;
 	void *priv;
@@ -2354,6 +3247,16 @@ static void ocf_mngt_cache_detach_flush(ocf_pipeline_t pipeline,
 			context);
 }
 
+static void ocf_mngt_cache_detach_wait_pending_cmpl(void *priv)
+{
+	struct ocf_mngt_cache_detach_context *context = priv;
+
+	/* Requests started from now on see cache detached */
+	ocf_refcnt_unfreeze(&context->cache->pending_cache_requests);
+
+	ocf_pipeline_next(context->pipeline);
+}
+
 static void ocf_mngt_cache_detach_wait_pending(ocf_pipeline_t pipeline,
 		void *priv, ocf_pipeline_arg_t arg)
 {
@@ -2362,11 +3265,11 @@ static void ocf_mngt_cache_detach_wait_pending(ocf_pipeline_t pipeline,
 
 	env_atomic_set(&cache->attached, 0);
 
-	/* FIXME: This should be asynchronous! */
-	env_waitqueue_wait(cache->pending_cache_wq,
-			!env_atomic_read(&cache->pending_cache_requests));
+	_ocf_mngt_cache_bg_discard_cancel(cache);
 
-	ocf_pipeline_next(context->pipeline);
+	ocf_refcnt_freeze(&cache->pending_cache_requests);
+	ocf_refcnt_register_zero_cb(&cache->pending_cache_requests,
+			ocf_mngt_cache_detach_wait_pending_cmpl, context);
 }
 
 static void ocf_mngt_cache_detach_update_metadata(ocf_pipeline_t pipeline,
@@ -2387,6 +3290,9 @@ static void ocf_mngt_cache_detach_update_metadata(ocf_pipeline_t pipeline,
 		j++;
 	}
 
+	ocf_core_index_detach(cache);
+	ocf_part_move_drop(cache);
+
 	ocf_pipeline_next(context->pipeline);
 }
 
@@ -2484,3 +3390,50 @@ void ocf_mngt_cache_detach(ocf_cache_t cache,
 
 	ocf_pipeline_next(pipeline);
 }
+
+ocf_promotion_t ocf_mngt_cache_promotion_get_policy(ocf_cache_t cache)
+{
+	OCF_CHECK_NULL(cache);
+
+	return cache->promotion.type;
+}
+
+int ocf_mngt_cache_promotion_set_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t param_value)
+{
+	ocf_promotion_t type;
+	int ret;
+
+	OCF_CHECK_NULL(cache);
+
+	type = cache->promotion.type;
+
+	if (!promotion_policy_ops[type].set_param)
+		return -OCF_ERR_INVAL;
+
+	ocf_metadata_lock(cache, OCF_METADATA_WR);
+
+	ret = promotion_policy_ops[type].set_param(cache, param_id,
+			param_value);
+
+	ocf_metadata_unlock(cache, OCF_METADATA_WR);
+
+	return ret;
+}
+
+int ocf_mngt_cache_promotion_get_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t *param_value)
+{
+	ocf_promotion_t type;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(param_value);
+
+	type = cache->promotion.type;
+
+	if (!promotion_policy_ops[type].get_param)
+		return -OCF_ERR_INVAL;
+
+	return promotion_policy_ops[type].get_param(cache, param_id,
+			param_value);
+}
@@ -8,9 +8,12 @@
 #include "../ocf_priv.h"
 #include "../ocf_ctx_priv.h"
 #include "../metadata/metadata.h"
+#include "../metadata/metadata_core_index.h"
 #include "../engine/cache_engine.h"
 #include "../utils/utils_req.h"
 #include "../utils/utils_device.h"
+#include "../utils/utils_compress.h"
+#include "../utils/utils_dedup.h"
 #include "../eviction/ops.h"
 #include "../ocf_logger_priv.h"
 #include "../ocf_queue_priv.h"
@@ -107,6 +110,9 @@ void cache_mng_core_remove_from_cache(struct ocf_cache *cache, int core_id)
 {
 	env_free(cache->core[core_id].counters);
 	cache->core[core_id].counters = NULL;
+	ocf_core_index_deinit(&cache->core[core_id]);
+	ocf_core_mrc_deinit(&cache->core[core_id]);
+	ocf_core_pinned_deinit(&cache->core[core_id]);
 	env_bit_clear(core_id, cache->conf_meta->valid_core_bitmap);
 
 	if (!cache->core[core_id].opened &&
@@ -122,6 +128,8 @@ void ocf_mngt_cache_put(ocf_cache_t cache)
 	OCF_CHECK_NULL(cache);
 
 	if (env_atomic_dec_return(&cache->ref_count) == 0) {
+		ocf_compress_est_deinit(cache);
+		ocf_dedup_est_deinit(cache);
 		ocf_metadata_deinit(cache);
 		env_vfree(cache);
 	}
@@ -8,9 +8,14 @@
 #include "ocf_mngt_core_priv.h"
 #include "../ocf_priv.h"
 #include "../metadata/metadata.h"
+#include "../metadata/metadata_core_index.h"
 #include "../engine/cache_engine.h"
 #include "../utils/utils_device.h"
 #include "../utils/utils_pipeline.h"
+#include "../utils/utils_cleaner.h"
+#include "../utils/utils_mode_advisor.h"
+#include "../utils/utils_mrc.h"
+#include "../utils/utils_part.h"
 #include "../ocf_stats_priv.h"
 #include "../ocf_def_priv.h"
 
@@ -22,6 +27,15 @@ static ocf_seq_no_t _ocf_mngt_get_core_seq_no(ocf_cache_t cache)
 	return ++cache->conf_meta->curr_core_seq_no;
 }
 
+/* Core lines of the core have to fit in collision metadata */
+static int _ocf_mngt_core_check_size(uint64_t length)
+{
+	if (length / ocf_cache_line_size_min >= OCF_METADATA_CORE_LINES_MAX)
+		return -OCF_ERR_CORE_SIZE_EXCEEDED;
+
+	return 0;
+}
+
 static int _ocf_mngt_cache_try_add_core(ocf_cache_t cache, ocf_core_t *core,
 		struct ocf_mngt_core_config *cfg)
 {
@@ -47,6 +61,10 @@ static int _ocf_mngt_cache_try_add_core(ocf_cache_t cache, ocf_core_t *core,
 		goto error_after_open;
 	}
 
+	result = _ocf_mngt_core_check_size(ocf_volume_get_length(volume));
+	if (result)
+		goto error_after_open;
+
 	tmp_core->opened = true;
 
 	if (!(--cache->ocf_core_inactive_count))
@@ -103,6 +121,7 @@ static void _ocf_mngt_cache_add_core_handle_error(
 
 		env_free(core->counters);
 		core->counters = NULL;
+		ocf_core_index_deinit(core);
 	}
 
 	if (context->flags.clean_pol_added) {
@@ -199,6 +218,12 @@ static void _ocf_mngt_cache_add_core(ocf_cache_t cache,
 		ocf_pipeline_finish(context->pipeline, -OCF_ERR_CORE_NOT_AVAIL);
 		return;
 	}
+
+	result = _ocf_mngt_core_check_size(length);
+	if (result) {
+		ocf_pipeline_finish(context->pipeline, result);
+		return;
+	}
 	cache->core_conf_meta[cfg->core_id].length = length;
 
 	clean_type = cache->conf_meta->cleaning_policy_type;
@@ -215,7 +240,8 @@ static void _ocf_mngt_cache_add_core(ocf_cache_t cache,
 
 	/* When adding new core to cache, allocate stat counters */
 	core->counters =
-		env_zalloc(sizeof(*core->counters), ENV_MEM_NORMAL);
+		env_zalloc(sizeof(*core->counters) *
+			OCF_STATS_SHARDS, ENV_MEM_NORMAL);
 	if (!core->counters) {
 		ocf_pipeline_finish(context->pipeline, -OCF_ERR_NO_MEM);
 		return;
@@ -226,16 +252,26 @@ static void _ocf_mngt_cache_add_core(ocf_cache_t cache,
 	ocf_core_stats_initialize(core);
 	env_atomic_set(&cache->core_runtime_meta[cfg->core_id].
 			cached_clines, 0);
-	env_atomic_set(&cache->core_runtime_meta[cfg->core_id].
-			dirty_clines, 0);
+	ocf_cache_core_dirty_reset(cache, cfg->core_id);
 	env_atomic64_set(&cache->core_runtime_meta[cfg->core_id].
 			dirty_since, 0);
+	env_atomic64_set(&core->read_latency, 0);
+	core->prefetch_lines = 0;
+	core->write_combine = false;
+	core->tier_policy = ocf_tier_default;
+	core->mode_advisor.policy = ocf_mode_advisor_default;
+	core->mode_advisor.allowed_modes = 0;
+	ocf_cleaner_core_set_limits(core, 0, 0);
+	core->flush_cursor.valid = false;
 
 	/* In metadata mark data this core was added into cache */
 	env_bit_set(cfg->core_id, cache->conf_meta->valid_core_bitmap);
 	cache->core_conf_meta[cfg->core_id].added = true;
 	core->opened = true;
 
+	if (ocf_cache_is_device_attached(cache))
+		ocf_core_index_init(core);
+
 	/* Set default cache parameters for sequential */
 	cache->core_conf_meta[cfg->core_id].seq_cutoff_policy =
 		ocf_seq_cutoff_policy_default;
@@ -941,3 +977,256 @@ int ocf_mngt_core_get_seq_cutoff_policy(ocf_core_t core,
 
 	return 0;
 }
+
+int ocf_mngt_core_set_prefetch_lines(ocf_core_t core, uint32_t lines)
+{
+	OCF_CHECK_NULL(core);
+
+	if (lines > OCF_CORE_PREFETCH_LINES_MAX)
+		return -OCF_ERR_INVAL;
+
+	core->prefetch_lines = lines;
+
+	ocf_core_log(core, log_info, "Read-ahead set to %u cache lines\n",
+			lines);
+
+	return 0;
+}
+
+int ocf_mngt_core_get_prefetch_lines(ocf_core_t core, uint32_t *lines)
+{
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(lines);
+
+	*lines = core->prefetch_lines;
+
+	return 0;
+}
+
+int ocf_mngt_core_set_write_combining(ocf_core_t core, bool enable)
+{
+	OCF_CHECK_NULL(core);
+
+	core->write_combine = enable;
+
+	ocf_core_log(core, log_info, "Write combining %s\n",
+			enable ? "enabled" : "disabled");
+
+	return 0;
+}
+
+int ocf_mngt_core_get_write_combining(ocf_core_t core, bool *enabled)
+{
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(enabled);
+
+	*enabled = core->write_combine;
+
+	return 0;
+}
+
+int ocf_mngt_core_set_writeback_limits(ocf_core_t core,
+		const struct ocf_mngt_core_writeback_limits *limits)
+{
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(limits);
+
+	if (limits->max_io_size && limits->max_io_size <
+			ocf_cache_get_line_size(ocf_core_get_cache(core))) {
+		return -OCF_ERR_INVAL;
+	}
+
+	ocf_cleaner_core_set_limits(core, limits->max_inflight,
+			limits->max_io_size);
+
+	ocf_core_log(core, log_info, "Write-back limits set to %u in-flight "
+			"writes, %u bytes per write\n", limits->max_inflight,
+			limits->max_io_size);
+
+	return 0;
+}
+
+int ocf_mngt_core_get_writeback_limits(ocf_core_t core,
+		struct ocf_mngt_core_writeback_limits *limits)
+{
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(limits);
+
+	limits->max_inflight = core->writeback.max_inflight;
+	limits->max_io_size = core->writeback.max_io_size;
+
+	return 0;
+}
+
+static const char *_ocf_tier_policy_names[ocf_tier_max] = {
+	[ocf_tier_inclusive] = "inclusive",
+	[ocf_tier_exclusive] = "exclusive",
+};
+
+int ocf_mngt_core_set_tier_policy(ocf_core_t core, ocf_tier_policy_t policy)
+{
+	OCF_CHECK_NULL(core);
+
+	if (policy < 0 || policy >= ocf_tier_max)
+		return -OCF_ERR_INVAL;
+
+	core->tier_policy = policy;
+
+	ocf_core_log(core, log_info, "Tier policy set to %s\n",
+			_ocf_tier_policy_names[policy]);
+
+	return 0;
+}
+
+int ocf_mngt_core_get_tier_policy(ocf_core_t core,
+		ocf_tier_policy_t *policy)
+{
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(policy);
+
+	*policy = core->tier_policy;
+
+	return 0;
+}
+
+static const char *_ocf_mode_advisor_names[ocf_mode_advisor_max] = {
+	[ocf_mode_advisor_off] = "off",
+	[ocf_mode_advisor_recommend] = "recommend",
+	[ocf_mode_advisor_apply] = "apply",
+};
+
+int ocf_mngt_core_set_mode_advisor(ocf_core_t core,
+		const struct ocf_mngt_core_mode_advisor *cfg)
+{
+	const uint32_t modes = (1 << ocf_cache_mode_wt) |
+			(1 << ocf_cache_mode_wb) | (1 << ocf_cache_mode_wa) |
+			(1 << ocf_cache_mode_wi);
+
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(cfg);
+
+	if (cfg->policy < 0 || cfg->policy >= ocf_mode_advisor_max)
+		return -OCF_ERR_INVAL;
+
+	if (cfg->allowed_modes & ~modes)
+		return -OCF_ERR_INVAL;
+
+	/* Advised mode is not applied while advisor restarts */
+	core->mode_advisor.policy = ocf_mode_advisor_off;
+	core->mode_advisor.allowed_modes = cfg->allowed_modes;
+	ocf_mode_advisor_reset(core);
+	core->mode_advisor.policy = cfg->policy;
+
+	ocf_core_log(core, log_info, "Cache mode advisor set to %s\n",
+			_ocf_mode_advisor_names[cfg->policy]);
+
+	return 0;
+}
+
+int ocf_mngt_core_get_mode_advisor(ocf_core_t core,
+		struct ocf_mngt_core_mode_advisor *cfg)
+{
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(cfg);
+
+	cfg->policy = core->mode_advisor.policy;
+	cfg->allowed_modes = core->mode_advisor.allowed_modes;
+
+	return 0;
+}
+
+int ocf_mngt_core_set_pinned_ranges(ocf_core_t core,
+		const struct ocf_mngt_core_pinned_range *ranges,
+		uint32_t count)
+{
+	struct ocf_core_pinned_map *map;
+	ocf_cache_t cache;
+	uint32_t version, i;
+
+	OCF_CHECK_NULL(core);
+
+	if (count > OCF_CORE_PINNED_RANGES_MAX || (count && !ranges))
+		return -OCF_ERR_INVAL;
+
+	cache = ocf_core_get_cache(core);
+
+	for (i = 0; i < count; i++) {
+		if (ranges[i].io_class >= OCF_IO_CLASS_MAX ||
+				ocf_part_get_prio(cache, ranges[i].io_class) !=
+					OCF_IO_CLASS_PRIO_PINNED) {
+			ocf_core_log(core, log_err, "IO class %u of pinned "
+					"range is not pinned\n",
+					ranges[i].io_class);
+			return -OCF_ERR_INVAL;
+		}
+	}
+
+	if (!core->pinned) {
+		if (!count)
+			return 0;
+
+		core->pinned = env_zalloc(sizeof(*core->pinned), ENV_MEM_NORMAL);
+		if (!core->pinned)
+			return -OCF_ERR_NO_MEM;
+	}
+
+	version = env_atomic_read(&core->pinned->version);
+	map = &core->pinned->maps[(version + 1) & 1];
+
+	for (i = 0; i < count; i++)
+		map->ranges[i] = ranges[i];
+	map->count = count;
+
+	/* Atomic increment is a full barrier, map is complete first */
+	env_atomic_inc(&core->pinned->version);
+
+	ocf_core_log(core, log_info, "Pinned ranges set to %u ranges\n",
+			count);
+
+	return 0;
+}
+
+int ocf_mngt_core_get_pinned_ranges(ocf_core_t core,
+		struct ocf_mngt_core_pinned_range *ranges, uint32_t *count)
+{
+	const struct ocf_core_pinned_map *map;
+	uint32_t i;
+
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(ranges);
+	OCF_CHECK_NULL(count);
+
+	*count = 0;
+
+	if (!core->pinned)
+		return 0;
+
+	map = &core->pinned->maps[env_atomic_read(&core->pinned->version) & 1];
+
+	for (i = 0; i < map->count; i++)
+		ranges[i] = map->ranges[i];
+	*count = map->count;
+
+	return 0;
+}
+
+int ocf_mngt_core_set_mrc(ocf_core_t core, bool enable)
+{
+	OCF_CHECK_NULL(core);
+
+	if (enable) {
+		if (!core->mrc)
+			core->mrc = ocf_mrc_init(OCF_CONFIG_MRC_SAMPLES);
+		if (!core->mrc)
+			return -OCF_ERR_NO_MEM;
+
+		ocf_mrc_reset(core->mrc);
+	}
+
+	core->mrc_enabled = enable;
+
+	ocf_core_log(core, log_info, "Miss ratio curve estimation %s\n",
+			enable ? "enabled" : "disabled");
+
+	return 0;
+}
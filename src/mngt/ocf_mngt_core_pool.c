@@ -10,10 +10,28 @@
 #include "../ocf_core_priv.h"
 #include "../ocf_ctx_priv.h"
 
+/*
+ * Volumes are matched on uuid string, so only its part up to terminating
+ * zero is hashed
+ */
+static struct list_head *ocf_mngt_core_pool_bucket(ocf_ctx_t ctx,
+		ocf_uuid_t uuid)
+{
+	size_t len = env_strnlen(uuid->data, uuid->size);
+	uint32_t hash = env_crc32(0, uuid->data, len);
+
+	return &ctx->core_pool.core_pool_hash[hash % OCF_CORE_POOL_HASH_SIZE];
+}
+
 void ocf_mngt_core_pool_init(ocf_ctx_t ctx)
 {
+	int i;
+
 	OCF_CHECK_NULL(ctx);
 	INIT_LIST_HEAD(&ctx->core_pool.core_pool_head);
+
+	for (i = 0; i < OCF_CORE_POOL_HASH_SIZE; i++)
+		INIT_LIST_HEAD(&ctx->core_pool.core_pool_hash[i]);
 }
 
 int ocf_mngt_core_pool_get_count(ocf_ctx_t ctx)
@@ -46,6 +64,8 @@ int ocf_mngt_core_pool_add(ocf_ctx_t ctx, ocf_uuid_t uuid, uint8_t type)
 
 	env_mutex_lock(&ctx->lock);
 	list_add(&volume->core_pool_item, &ctx->core_pool.core_pool_head);
+	list_add(&volume->core_pool_hash_item,
+			ocf_mngt_core_pool_bucket(ctx, &volume->uuid));
 	ctx->core_pool.core_pool_count++;
 	env_mutex_unlock(&ctx->lock);
 	return result;
@@ -80,8 +100,8 @@ ocf_volume_t ocf_mngt_core_pool_lookup(ocf_ctx_t ctx, ocf_uuid_t uuid,
 	OCF_CHECK_NULL(uuid);
 	OCF_CHECK_NULL(uuid->data);
 
-	list_for_each_entry(svolume, &ctx->core_pool.core_pool_head,
-			core_pool_item) {
+	list_for_each_entry(svolume, ocf_mngt_core_pool_bucket(ctx, uuid),
+			core_pool_hash_item) {
 		if (svolume->type == type && !env_strncmp(svolume->uuid.data,
 			uuid->data, OCF_MIN(svolume->uuid.size, uuid->size))) {
 			return svolume;
@@ -98,6 +118,7 @@ void ocf_mngt_core_pool_remove(ocf_ctx_t ctx, ocf_volume_t volume)
 	env_mutex_lock(&ctx->lock);
 	ctx->core_pool.core_pool_count--;
 	list_del(&volume->core_pool_item);
+	list_del(&volume->core_pool_hash_item);
 	env_mutex_unlock(&ctx->lock);
 	ocf_volume_destroy(volume);
 }
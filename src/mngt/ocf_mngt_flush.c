@@ -7,11 +7,13 @@
 #include "ocf_mngt_common.h"
 #include "../ocf_priv.h"
 #include "../metadata/metadata.h"
+#include "../metadata/metadata_core_index.h"
 #include "../cleaning/cleaning.h"
 #include "../engine/cache_engine.h"
 #include "../engine/engine_common.h"
 #include "../utils/utils_cleaner.h"
 #include "../utils/utils_cache_line.h"
+#include "../utils/utils_core.h"
 #include "../utils/utils_part.h"
 #include "../utils/utils_pipeline.h"
 #include "../utils/utils_refcnt.h"
@@ -74,6 +76,17 @@ struct ocf_mngt_cache_flush_context
 		uint64_t core_id;
 	} purge;
 
+	/* partial flush limits */
+	struct {
+		bool enabled;
+		/* cache lines which may be flushed, 0 means no limit */
+		uint64_t lines;
+		/* dirty cache lines at which flush stops, 0 means no limit */
+		uint64_t dirty_lines;
+		/* cache lines submitted for flushing so far */
+		env_atomic64 issued;
+	} limit;
+
 	/* context for flush containers logic */
 	struct flush_containers_context fcs;
 };
@@ -109,11 +122,11 @@ static void _ocf_mngt_end_flush(ocf_cache_t cache)
 
 bool ocf_mngt_cache_is_dirty(ocf_cache_t cache)
 {
-	uint32_t i;
+	ocf_core_id_t i;
 
 	OCF_CHECK_NULL(cache);
 
-	for (i = 0; i < OCF_CORE_MAX; ++i) {
+	for_each_dirty_core(cache, i) {
 		if (!cache->core_conf_meta[i].added)
 			continue;
 
@@ -127,6 +140,222 @@ bool ocf_mngt_cache_is_dirty(ocf_cache_t cache)
 }
 
 /************************FLUSH CORE CODE**************************************/
+/*
+ * Cores with more dirty cache lines than that are flushed in streaming mode.
+ * Instead of collecting all dirty lines up front, flush container collects
+ * and sorts bounded batch of them, scanning limited window of collision
+ * table at once, and flushes the batch before collecting next one.
+ */
+#define OCF_MNG_FLUSH_STREAM_LINES	(1U << 18)
+#define OCF_MNG_FLUSH_STREAM_WINDOW	(1U << 22)
+
+static inline bool _ocf_mngt_line_to_flush(ocf_cache_t cache,
+		ocf_cache_line_t line)
+{
+	if (!metadata_test_valid_any(cache, line))
+		return false;
+
+	if (!metadata_test_dirty(cache, line))
+		return false;
+
+	return !ocf_cache_line_is_used(cache, line);
+}
+
+/* Flush of core interrupted earlier is streamed from position it stopped */
+static inline bool _ocf_mngt_flush_resumable(ocf_cache_t cache,
+		ocf_core_id_t core_id)
+{
+	ocf_core_t core = &cache->core[core_id];
+
+	return core->flush_cursor.valid && core->flush_cursor.indexed ==
+			ocf_core_index_enabled(core);
+}
+
+static int _ocf_mngt_flush_stream_init(ocf_cache_t cache,
+		struct flush_container *fc)
+{
+	ocf_core_t core = &cache->core[fc->core_id];
+
+	fc->flush_data = env_vmalloc(OCF_MNG_FLUSH_STREAM_LINES *
+			sizeof(*fc->flush_data));
+	if (!fc->flush_data)
+		return -OCF_ERR_NO_MEM;
+
+	fc->stream = true;
+	fc->count = 0;
+	fc->indexed = ocf_core_index_enabled(core);
+	fc->wrapped = false;
+
+	fc->resume = 0;
+	if (_ocf_mngt_flush_resumable(cache, fc->core_id)) {
+		fc->resume = core->flush_cursor.position;
+		if (!fc->indexed) {
+			fc->resume = OCF_MIN(fc->resume, (uint64_t)cache->
+					device->collision_table_entries);
+		}
+		ocf_core_log(core, log_info, "Resuming interrupted flush\n");
+	}
+
+	fc->scan = fc->indexed ? 0 : fc->resume;
+	fc->core_scan = fc->indexed ? fc->resume : 0;
+	fc->batch = fc->resume;
+
+	return 0;
+}
+
+static inline uint64_t _ocf_mngt_flush_stream_pos(struct flush_container *fc)
+{
+	return fc->indexed ? fc->core_scan : fc->scan;
+}
+
+static inline bool _ocf_mngt_flush_stream_scanned(struct flush_container *fc)
+{
+	if (fc->indexed)
+		return fc->core_scan == ULLONG_MAX;
+
+	return fc->scan == (fc->wrapped ? fc->resume :
+			fc->cache->device->collision_table_entries);
+}
+
+/* Remember where stream of unfinished flush stopped, forget it otherwise */
+static void _ocf_mngt_flush_stream_save(struct flush_container *fc,
+		bool unfinished)
+{
+	ocf_core_t core = &fc->cache->core[fc->core_id];
+
+	if (!fc->stream || !unfinished) {
+		core->flush_cursor.valid = false;
+		return;
+	}
+
+	core->flush_cursor.position = fc->batch;
+	core->flush_cursor.indexed = fc->indexed;
+	core->flush_cursor.valid = true;
+}
+
+static void _ocf_mngt_flush_stream_add(struct flush_container *fc,
+		ocf_cache_line_t line, uint64_t core_line)
+{
+	fc->flush_data[fc->count].cache_line = line;
+	fc->flush_data[fc->count].core_line = core_line;
+	fc->flush_data[fc->count].core_id = fc->core_id;
+	fc->count++;
+}
+
+/* Scan next window of collision table for dirty lines of the core */
+static void _ocf_mngt_flush_stream_scan(struct flush_container *fc)
+{
+	ocf_cache_t cache = fc->cache;
+	uint32_t entries = cache->device->collision_table_entries;
+	uint64_t core_line;
+	ocf_core_id_t core_id;
+	uint32_t end;
+
+	end = OCF_MIN((uint64_t)fc->scan + OCF_MNG_FLUSH_STREAM_WINDOW,
+			fc->wrapped ? fc->resume : (uint64_t)entries);
+
+	for (; fc->scan < end && fc->count < OCF_MNG_FLUSH_STREAM_LINES;
+			fc->scan++) {
+		ocf_metadata_get_core_info(cache, fc->scan, &core_id,
+				&core_line);
+
+		if (core_id != fc->core_id)
+			continue;
+
+		if (!_ocf_mngt_line_to_flush(cache, fc->scan))
+			continue;
+
+		_ocf_mngt_flush_stream_add(fc, fc->scan, core_line);
+	}
+}
+
+/* Look up next window of mapped core lines of the core in its index */
+static void _ocf_mngt_flush_stream_scan_index(struct flush_container *fc)
+{
+	ocf_cache_t cache = fc->cache;
+	ocf_core_t core = &cache->core[fc->core_id];
+	uint64_t last = fc->wrapped ? fc->resume - 1 : ULLONG_MAX;
+	ocf_cache_line_t line;
+	uint32_t visited;
+
+	for (visited = 0; visited < OCF_MNG_FLUSH_STREAM_WINDOW &&
+			fc->count < OCF_MNG_FLUSH_STREAM_LINES; visited++) {
+		if (fc->core_scan > last ||
+				!ocf_core_index_next(core, &fc->core_scan, last)) {
+			fc->core_scan = ULLONG_MAX;
+			break;
+		}
+
+		line = ocf_metadata_lookup_collision(cache, fc->core_id,
+				fc->core_scan);
+
+		if (line != cache->device->collision_table_entries &&
+				_ocf_mngt_line_to_flush(cache, line)) {
+			_ocf_mngt_flush_stream_add(fc, line, fc->core_scan);
+		}
+
+		fc->core_scan++;
+	}
+}
+
+/* Collect next batch of dirty lines of streamed container */
+static void _ocf_mngt_flush_stream_fill(struct flush_container *fc)
+{
+	fc->count = 0;
+	fc->iter = 0;
+
+	/* Resumed stream continues with lines before resume position */
+	if (_ocf_mngt_flush_stream_scanned(fc)) {
+		fc->wrapped = true;
+		fc->scan = 0;
+		fc->core_scan = 0;
+	}
+
+	fc->batch = _ocf_mngt_flush_stream_pos(fc);
+
+	if (fc->indexed)
+		_ocf_mngt_flush_stream_scan_index(fc);
+	else
+		_ocf_mngt_flush_stream_scan(fc);
+
+	ocf_cleaner_sort_sectors(fc->flush_data, fc->count);
+}
+
+static inline bool _ocf_mngt_flush_stream_end(struct flush_container *fc)
+{
+	if (!fc->stream)
+		return true;
+
+	return _ocf_mngt_flush_stream_scanned(fc) &&
+			(fc->wrapped || !fc->resume);
+}
+
+/* Collect dirty lines of core visiting its mapped core lines in index */
+static uint32_t _ocf_mngt_get_sectors_indexed(ocf_cache_t cache,
+		ocf_core_id_t core_id, struct flush_data *p, uint32_t dirty)
+{
+	ocf_core_t core = &cache->core[core_id];
+	uint64_t core_line = 0;
+	ocf_cache_line_t line;
+	uint32_t j = 0;
+
+	while (j < dirty && ocf_core_index_next(core, &core_line, ULLONG_MAX)) {
+		line = ocf_metadata_lookup_collision(cache, core_id, core_line);
+
+		if (line != cache->device->collision_table_entries &&
+				_ocf_mngt_line_to_flush(cache, line)) {
+			p[j].cache_line = line;
+			p[j].core_line = core_line;
+			p[j].core_id = core_id;
+			j++;
+		}
+
+		core_line++;
+	}
+
+	return j;
+}
+
 /* Returns:
  * 0 if OK and tbl & num is filled:
  * * tbl - table with sectors&cacheline
@@ -155,19 +384,18 @@ static int _ocf_mngt_get_sectors(struct ocf_cache *cache, int core_id,
 	if (!p)
 		return -OCF_ERR_NO_MEM;
 
+	if (ocf_core_index_enabled(&cache->core[core_id])) {
+		j = _ocf_mngt_get_sectors_indexed(cache, core_id, p, dirty);
+		goto out;
+	}
+
 	for (i = 0, j = 0; i < cache->device->collision_table_entries; i++) {
 		ocf_metadata_get_core_info(cache, i, &i_core_id, &core_line);
 
 		if (i_core_id != core_id)
 			continue;
 
-		if (!metadata_test_valid_any(cache, i))
-			continue;
-
-		if (!metadata_test_dirty(cache, i))
-			continue;
-
-		if (ocf_cache_line_is_used(cache, i))
+		if (!_ocf_mngt_line_to_flush(cache, i))
 			continue;
 
 		/* It's core_id cacheline and it's valid and it's dirty! */
@@ -180,6 +408,7 @@ static int _ocf_mngt_get_sectors(struct ocf_cache *cache, int core_id,
 			break;
 	}
 
+out:
 	ocf_core_log(&cache->core[core_id], log_debug,
 			"%u dirty cache lines to clean\n", j);
 
@@ -204,7 +433,7 @@ static int _ocf_mngt_get_flush_containers(ocf_cache_t cache,
 	uint32_t num;
 	uint64_t core_line;
 	ocf_core_id_t core_id;
-	uint32_t i, j, dirty = 0;
+	uint32_t i, j, dirty = 0, stream = 0;
 	int step = 0;
 
 	/*
@@ -238,9 +467,16 @@ static int _ocf_mngt_get_flush_containers(ocf_cache_t cache,
 		/* Check for dirty blocks */
 		fc[j].count = env_atomic_read(&cache->
 				core_runtime_meta[i].dirty_clines);
-		dirty += fc[j].count;
 
-		if (fc[j].count) {
+		if (fc[j].count > OCF_MNG_FLUSH_STREAM_LINES ||
+				(fc[j].count && _ocf_mngt_flush_resumable(
+					cache, i))) {
+			/* Dirty lines are collected while flushing */
+			if (!_ocf_mngt_flush_stream_init(cache, &fc[j]))
+				stream++;
+			fc[j].count = 0;
+		} else if (fc[j].count) {
+			dirty += fc[j].count;
 			fc[j].flush_data = env_vmalloc(fc[j].count *
 					sizeof(*fc[j].flush_data));
 		}
@@ -249,26 +485,23 @@ static int _ocf_mngt_get_flush_containers(ocf_cache_t cache,
 			break;
 	}
 
-	if (!dirty) {
+	if (!dirty && !stream) {
 		env_vfree(core_revmap);
 		env_vfree(fc);
 		*fcnum = 0;
 		return 0;
 	}
 
-	for (i = 0, j = 0; i < cache->device->collision_table_entries; i++) {
+	for (i = 0, j = 0; dirty && i < cache->device->collision_table_entries;
+			i++) {
 		ocf_metadata_get_core_info(cache, i, &core_id, &core_line);
 
-		if (!metadata_test_valid_any(cache, i))
-			continue;
-
-		if (!metadata_test_dirty(cache, i))
-			continue;
-
-		if (ocf_cache_line_is_used(cache, i))
+		if (!_ocf_mngt_line_to_flush(cache, i))
 			continue;
 
 		curr = &fc[core_revmap[core_id]];
+		if (curr->stream)
+			continue;
 
 		ENV_BUG_ON(curr->iter >= curr->count);
 
@@ -307,8 +540,10 @@ static void _ocf_mngt_free_flush_containers(struct flush_container *fctbl,
 {
 	int i;
 
-	for (i = 0; i < num; i++)
+	for (i = 0; i < num; i++) {
 		env_vfree(fctbl[i].flush_data);
+		env_free(fctbl[i].portions);
+	}
 	env_vfree(fctbl);
 }
 
@@ -320,17 +555,18 @@ static void _ocf_mngt_free_flush_containers(struct flush_container *fctbl,
 #define OCF_MNG_FLUSH_MIN (4*MiB / ocf_line_size(cache))
 #define OCF_MNG_FLUSH_MAX (100*MiB / ocf_line_size(cache))
 
-static void _ocf_mngt_flush_portion(struct flush_container *fc)
+/* Adjust portion size to what previous portion managed to flush in second */
+static void _ocf_mngt_flush_portion_adjust(struct flush_container *fc,
+		struct flush_portion *portion)
 {
 	ocf_cache_t cache = fc->cache;
 	uint64_t flush_portion_div;
-	uint32_t curr_count;
 
-	flush_portion_div = env_ticks_to_msecs(fc->ticks2 - fc->ticks1);
+	flush_portion_div = env_ticks_to_msecs(portion->ticks2 - portion->ticks1);
 	if (unlikely(!flush_portion_div))
 		flush_portion_div = 1;
 
-	fc->flush_portion = fc->flush_portion * 1000 / flush_portion_div;
+	fc->flush_portion = (uint64_t)portion->count * 1000 / flush_portion_div;
 	fc->flush_portion &= ~0x3ffULL;
 
 	/* regardless those calculations, limit flush portion to be
@@ -338,28 +574,100 @@ static void _ocf_mngt_flush_portion(struct flush_container *fc)
 	 */
 	fc->flush_portion = OCF_MIN(fc->flush_portion, OCF_MNG_FLUSH_MAX);
 	fc->flush_portion = OCF_MAX(fc->flush_portion, OCF_MNG_FLUSH_MIN);
+}
+
+static uint64_t _ocf_mngt_flush_dirty_lines(ocf_cache_t cache)
+{
+	uint64_t dirty = 0;
+	ocf_core_id_t i;
+
+	for_each_dirty_core(cache, i) {
+		dirty += env_atomic_read(&cache->core_runtime_meta[i].
+				dirty_clines);
+	}
+
+	return dirty;
+}
+
+/* Partial flush has no more lines to flush once its limits are met */
+static uint32_t _ocf_mngt_flush_limit_take(
+		struct ocf_mngt_cache_flush_context *context, uint32_t count)
+{
+	uint64_t issued;
+
+	if (!context->limit.enabled)
+		return count;
+
+	if (context->limit.dirty_lines && _ocf_mngt_flush_dirty_lines(
+			context->cache) <= context->limit.dirty_lines) {
+		return 0;
+	}
+
+	if (!context->limit.lines)
+		return count;
 
-	curr_count = OCF_MIN(fc->count - fc->iter, fc->flush_portion);
+	do {
+		issued = env_atomic64_read(&context->limit.issued);
+		if (issued >= context->limit.lines)
+			return 0;
 
-	ocf_cleaner_do_flush_data_async(fc->cache,
-			&fc->flush_data[fc->iter],
-			curr_count, &fc->attribs);
+		count = OCF_MIN((uint64_t)count,
+				context->limit.lines - issued);
+	} while (env_atomic64_cmpxchg(&context->limit.issued, issued,
+			issued + count) != issued);
 
-	fc->iter += curr_count;
+	return count;
+}
+
+static inline bool _ocf_mngt_flush_limit_met(
+		struct ocf_mngt_cache_flush_context *context)
+{
+	if (!context->limit.enabled)
+		return false;
+
+	if (context->limit.lines && env_atomic64_read(
+			&context->limit.issued) >= context->limit.lines) {
+		return true;
+	}
+
+	return context->limit.dirty_lines && _ocf_mngt_flush_dirty_lines(
+			context->cache) <= context->limit.dirty_lines;
+}
+
+static void _ocf_mngt_flush_portion(struct flush_container *fc,
+		struct flush_portion *portion, uint32_t count)
+{
+	struct flush_data *flush_data = &fc->flush_data[fc->iter];
+
+	portion->count = count;
+	portion->ticks1 = env_get_tick_count();
+	fc->iter += portion->count;
+
+	fc->attribs.cmpl_context = portion;
+
+	ocf_cleaner_do_flush_data_async(fc->cache, flush_data,
+			portion->count, &fc->attribs);
+}
+
+static void _ocf_mngt_flush_container_kick(struct flush_container *fc,
+		bool allow_sync)
+{
+	ocf_engine_push_req_front(fc->req, allow_sync);
 }
 
 static void _ocf_mngt_flush_portion_end(void *private_data, int error)
 {
-	struct flush_container *fc = private_data;
+	struct flush_portion *portion = private_data;
+	struct flush_container *fc = portion->fc;
 	struct ocf_mngt_cache_flush_context *context = fc->context;
 	struct flush_containers_context *fsc = &context->fcs;
 	ocf_cache_t cache = context->cache;
 	ocf_core_t core = &cache->core[fc->core_id];
-	bool first_interrupt;
+	bool first_interrupt, kick;
 
-	env_atomic_set(&core->flushed, fc->iter);
+	env_atomic_add(portion->count, &core->flushed);
 
-	fc->ticks2 = env_get_tick_count();
+	portion->ticks2 = env_get_tick_count();
 
 	env_atomic_cmpxchg(&fsc->error, 0, error);
 
@@ -381,25 +689,119 @@ static void _ocf_mngt_flush_portion_end(void *private_data, int error)
 		}
 	}
 
-	if (env_atomic_read(&fsc->error) || fc->iter == fc->count) {
-		ocf_req_put(fc->req);
-		fc->end(context);
-		return;
+	env_spinlock_lock(&fc->lock);
+	portion->busy = false;
+	fc->inflight--;
+	kick = !fc->scheduled;
+	fc->scheduled = true;
+	env_spinlock_unlock(&fc->lock);
+
+	if (kick)
+		_ocf_mngt_flush_container_kick(fc, false);
+}
+
+static struct flush_portion *_ocf_mngt_flush_get_portion(
+		struct flush_container *fc)
+{
+	struct flush_portion *portion = NULL;
+	uint32_t i;
+
+	env_spinlock_lock(&fc->lock);
+	for (i = 0; i < fc->queue_depth; i++) {
+		if (fc->portions[i].busy)
+			continue;
+
+		portion = &fc->portions[i];
+		portion->busy = true;
+		fc->inflight++;
+		break;
 	}
+	env_spinlock_unlock(&fc->lock);
 
-	ocf_engine_push_req_front(fc->req, false);
+	return portion;
 }
 
+static void _ocf_mngt_flush_put_portion(struct flush_container *fc,
+		struct flush_portion *portion)
+{
+	env_spinlock_lock(&fc->lock);
+	portion->busy = false;
+	fc->inflight--;
+	env_spinlock_unlock(&fc->lock);
+}
 
+/*
+ * Keep up to queue depth portions of container in flight. Step is scheduled
+ * again by completion of each portion. Container is done once all portions
+ * completed and no step is scheduled, as only then nothing refers to it.
+ */
 static int _ofc_flush_container_step(struct ocf_request *req)
 {
 	struct flush_container *fc = req->priv;
+	struct ocf_mngt_cache_flush_context *context = fc->context;
 	ocf_cache_t cache = fc->cache;
+	struct flush_portion *portion;
+	bool filled = false, limited = false, drained, done, kick = false;
+	uint32_t count;
+
+	env_spinlock_lock(&fc->lock);
+	fc->scheduled = false;
+	env_spinlock_unlock(&fc->lock);
 
 	ocf_metadata_lock(cache, OCF_METADATA_WR);
-	_ocf_mngt_flush_portion(fc);
+	while (!env_atomic_read(&context->fcs.error)) {
+		if (fc->iter == fc->count) {
+			/* Single window of collision table per step */
+			if (filled || _ocf_mngt_flush_stream_end(fc))
+				break;
+
+			_ocf_mngt_flush_stream_fill(fc);
+			filled = true;
+			continue;
+		}
+
+		portion = _ocf_mngt_flush_get_portion(fc);
+		if (!portion)
+			break;
+
+		if (portion->count)
+			_ocf_mngt_flush_portion_adjust(fc, portion);
+
+		count = _ocf_mngt_flush_limit_take(context, OCF_MIN(
+				fc->count - fc->iter, fc->flush_portion));
+		if (!count) {
+			_ocf_mngt_flush_put_portion(fc, portion);
+			limited = true;
+			break;
+		}
+
+		_ocf_mngt_flush_portion(fc, portion, count);
+	}
 	ocf_metadata_unlock(cache, OCF_METADATA_WR);
 
+	drained = env_atomic_read(&context->fcs.error) || limited ||
+		(fc->iter == fc->count && _ocf_mngt_flush_stream_end(fc));
+
+	env_spinlock_lock(&fc->lock);
+	done = drained && !fc->inflight && !fc->scheduled;
+	if (!drained && !fc->inflight && !fc->scheduled) {
+		/* Nothing in flight to reschedule us, continue scanning */
+		fc->scheduled = true;
+		kick = true;
+	}
+	env_spinlock_unlock(&fc->lock);
+
+	if (kick)
+		_ocf_mngt_flush_container_kick(fc, false);
+
+	if (done) {
+		_ocf_mngt_flush_stream_save(fc,
+				env_atomic_read(&context->fcs.error) ||
+				_ocf_mngt_flush_limit_met(context));
+		ocf_req_put(fc->req);
+		fc->end(context);
+	}
+
 	return 0;
 }
 
@@ -415,13 +817,25 @@ static void _ocf_mngt_flush_container(
 	ocf_cache_t cache = context->cache;
 	struct ocf_request *req;
 	int error = 0;
+	uint32_t i;
 
-	if (!fc->count)
+	if (!fc->count && !fc->stream)
 		goto finish;
 
 	fc->end = end;
 	fc->context = context;
 
+	fc->queue_depth = cache->flush_queue_depth;
+	fc->portions = env_zalloc(sizeof(*fc->portions) * fc->queue_depth,
+			ENV_MEM_NORMAL);
+	if (!fc->portions) {
+		error = OCF_ERR_NO_MEM;
+		goto finish;
+	}
+
+	for (i = 0; i < fc->queue_depth; i++)
+		fc->portions[i].fc = fc;
+
 	req = ocf_req_new(cache->mngt_queue, NULL, 0, 0, 0);
 	if (!req) {
 		error = OCF_ERR_NO_MEM;
@@ -434,15 +848,18 @@ static void _ocf_mngt_flush_container(
 
 	fc->req = req;
 	fc->attribs.cache_line_lock = true;
-	fc->attribs.cmpl_context = fc;
 	fc->attribs.cmpl_fn = _ocf_mngt_flush_portion_end;
 	fc->attribs.io_queue = cache->mngt_queue;
 	fc->cache = cache;
 	fc->flush_portion = OCF_MNG_FLUSH_MIN;
-	fc->ticks1 = 0;
-	fc->ticks2 = UINT_MAX;
 
-	ocf_engine_push_req_front(fc->req, true);
+	env_spinlock_init(&fc->lock);
+	fc->inflight = 0;
+	fc->scheduled = true;
+
+	env_atomic_set(&cache->core[fc->core_id].flushed, 0);
+
+	_ocf_mngt_flush_container_kick(fc, true);
 	return;
 
 finish:
@@ -504,6 +921,7 @@ static void _ocf_mngt_flush_core(
 	ocf_core_t core = context->core;
 	ocf_core_id_t core_id = ocf_core_get_id(core);
 	struct flush_container *fc;
+	uint32_t dirty;
 	int ret;
 
 	fc = env_vzalloc(sizeof(*fc));
@@ -514,8 +932,17 @@ static void _ocf_mngt_flush_core(
 
 	ocf_metadata_lock(cache, OCF_METADATA_WR);
 
-	ret = _ocf_mngt_get_sectors(cache, core_id,
-			&fc->flush_data, &fc->count);
+	fc->core_id = core_id;
+
+	dirty = env_atomic_read(&cache->core_runtime_meta[core_id].
+			dirty_clines);
+	if (dirty > OCF_MNG_FLUSH_STREAM_LINES || (dirty &&
+			_ocf_mngt_flush_resumable(cache, core_id))) {
+		ret = _ocf_mngt_flush_stream_init(cache, fc);
+	} else {
+		ret = _ocf_mngt_get_sectors(cache, core_id,
+				&fc->flush_data, &fc->count);
+	}
 	if (ret) {
 		ocf_core_log(core, log_err, "Flushing operation aborted, "
 				"no memory\n");
@@ -524,7 +951,6 @@ static void _ocf_mngt_flush_core(
 		return;
 	}
 
-	fc->core_id = core_id;
 	fc->iter = 0;
 
 	_ocf_mngt_flush_containers(context, fc, 1, complete);
@@ -616,7 +1042,8 @@ static void _ocf_mngt_flush_finish(ocf_pipeline_t pipeline, void *priv,
 		switch(context->op) {
 		case flush_cache:
 		case purge_cache:
-			ENV_BUG_ON(ocf_mngt_cache_is_dirty(cache));
+			ENV_BUG_ON(!context->limit.enabled &&
+					ocf_mngt_cache_is_dirty(cache));
 			break;
 		case flush_core:
 		case purge_core:
@@ -659,15 +1086,14 @@ static struct ocf_pipeline_properties _ocf_mngt_cache_flush_pipeline_properties
 	},
 };
 
-void ocf_mngt_cache_flush(ocf_cache_t cache, bool interruption,
-		ocf_mngt_cache_flush_end_t cmpl, void *priv)
+static void _ocf_mngt_cache_flush_start(ocf_cache_t cache,
+		const struct ocf_mngt_cache_flush_limits *limits,
+		bool interruption, ocf_mngt_cache_flush_end_t cmpl, void *priv)
 {
 	ocf_pipeline_t pipeline;
 	struct ocf_mngt_cache_flush_context *context;
 	int result = 0;
 
-	OCF_CHECK_NULL(cache);
-
 	if (!ocf_cache_is_device_attached(cache)) {
 		ocf_cache_log(cache, log_err, "Cannot flush cache - "
 				"cache device is detached\n");
@@ -704,9 +1130,41 @@ void ocf_mngt_cache_flush(ocf_cache_t cache, bool interruption,
 	context->allow_interruption = interruption;
 	context->op = flush_cache;
 
+	if (limits) {
+		context->limit.enabled = true;
+		context->limit.lines = OCF_DIV_ROUND_UP(limits->max_bytes,
+				ocf_line_size(cache));
+		context->limit.dirty_lines = (uint64_t)limits->dirty_ratio *
+				cache->device->collision_table_entries / 100;
+		env_atomic64_set(&context->limit.issued, 0);
+	}
+
 	ocf_pipeline_next(context->pipeline);
 }
 
+void ocf_mngt_cache_flush(ocf_cache_t cache, bool interruption,
+		ocf_mngt_cache_flush_end_t cmpl, void *priv)
+{
+	OCF_CHECK_NULL(cache);
+
+	_ocf_mngt_cache_flush_start(cache, NULL, interruption, cmpl, priv);
+}
+
+void ocf_mngt_cache_flush_partial(ocf_cache_t cache,
+		const struct ocf_mngt_cache_flush_limits *limits,
+		bool interruption, ocf_mngt_cache_flush_end_t cmpl, void *priv)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(limits);
+
+	if (limits->dirty_ratio > 100) {
+		cmpl(cache, priv, -OCF_ERR_INVAL);
+		return;
+	}
+
+	_ocf_mngt_cache_flush_start(cache, limits, interruption, cmpl, priv);
+}
+
 static void _ocf_mngt_flush_core_complete(
 		struct ocf_mngt_cache_flush_context *context, int error)
 {
@@ -945,6 +1403,12 @@ int ocf_mngt_cache_cleaning_set_policy(ocf_cache_t cache, ocf_cleaning_t type)
 	if (type < 0 || type >= ocf_cleaning_max)
 		return -OCF_ERR_INVAL;
 
+	if (!ocf_cleaning_is_built(type)) {
+		ocf_cache_log(cache, log_err, "Cleaning policy %s is not "
+				"built in\n", cleaning_policy_ops[type].name);
+		return -OCF_ERR_INVAL;
+	}
+
 	old_type = cache->conf_meta->cleaning_policy_type;
 
 	if (type == old_type) {
@@ -953,6 +1417,11 @@ int ocf_mngt_cache_cleaning_set_policy(ocf_cache_t cache, ocf_cleaning_t type)
 		return 0;
 	}
 
+	/* Runs of old policy must not outlive its context */
+	ret = ocf_cleaner_wait_for_finish(cache, 60 * 1000);
+	if (ret)
+		return ret;
+
 	ocf_metadata_lock(cache, OCF_METADATA_WR);
 
 	if (cleaning_policy_ops[old_type].deinitialize)
@@ -1013,6 +1482,38 @@ int ocf_mngt_cache_cleaning_set_param(ocf_cache_t cache, ocf_cleaning_t type,
 	return ret;
 }
 
+int ocf_mngt_cache_cleaning_set_latency_target(ocf_cache_t cache,
+		uint32_t target_us)
+{
+	OCF_CHECK_NULL(cache);
+
+	if (target_us > OCF_CLEANER_LATENCY_TARGET_MAX_US)
+		return -OCF_ERR_INVAL;
+
+	ocf_cleaner_throttle_set_target(cache, target_us);
+
+	if (target_us) {
+		ocf_cache_log(cache, log_info, "Cleaner throttled to user IO "
+				"latency of %u us\n", target_us);
+	} else {
+		ocf_cache_log(cache, log_info, "Cleaner throttling "
+				"disabled\n");
+	}
+
+	return 0;
+}
+
+int ocf_mngt_cache_cleaning_get_latency_target(ocf_cache_t cache,
+		uint32_t *target_us)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(target_us);
+
+	*target_us = cache->cleaner.throttle.target_us;
+
+	return 0;
+}
+
 int ocf_mngt_cache_cleaning_get_param(ocf_cache_t cache, ocf_cleaning_t type,
 		uint32_t param_id, uint32_t *param_value)
 {
@@ -9,6 +9,7 @@
 #include "../metadata/metadata.h"
 #include "../engine/cache_engine.h"
 #include "../utils/utils_part.h"
+#include "../utils/utils_cache_line.h"
 #include "../eviction/ops.h"
 #include "ocf_env.h"
 
@@ -66,6 +67,8 @@ int ocf_mngt_add_partition_to_cache(struct ocf_cache *cache,
 
 	cache->user_parts[part_id].config->flags.added = 1;
 
+	ocf_part_class_map_publish(cache);
+
 	return 0;
 }
 
@@ -303,9 +306,236 @@ out_edit:
 					old_config, sizeof(&cache->user_parts)));
 	}
 
+	/* I/O picks up new configuration at once, without metadata lock */
+	ocf_part_class_map_publish(cache);
+
 out_cpy:
 	OCF_METADATA_UNLOCK_WR();
 	env_free(old_config);
 
 	return result;
 }
+
+int ocf_mngt_cache_io_classes_set_adaptive(ocf_cache_t cache, bool enable)
+{
+	OCF_CHECK_NULL(cache);
+
+	if (!ocf_cache_is_device_attached(cache))
+		return -OCF_ERR_INVAL;
+
+	if (!cache->ghost.table) {
+		ocf_cache_log(cache, log_err, "Adaptive IO classes require "
+				"eviction ghost history\n");
+		return -OCF_ERR_INVAL;
+	}
+
+	OCF_METADATA_LOCK_WR();
+	ocf_eviction_ghost_set_adaptive(cache, enable);
+	OCF_METADATA_UNLOCK_WR();
+
+	ocf_cache_log(cache, log_info, "Adaptive IO classes %s\n",
+			enable ? "enabled" : "disabled");
+
+	return 0;
+}
+
+bool ocf_mngt_cache_io_classes_get_adaptive(ocf_cache_t cache)
+{
+	OCF_CHECK_NULL(cache);
+
+	return cache->ghost.adaptive;
+}
+
+int ocf_mngt_cache_io_class_set_dirty_watermarks(ocf_cache_t cache,
+		uint32_t io_class, uint8_t high, uint8_t low)
+{
+	struct ocf_user_part *part;
+
+	OCF_CHECK_NULL(cache);
+
+	if (io_class >= OCF_IO_CLASS_MAX)
+		return -OCF_ERR_INVAL;
+
+	if (high > 100 || (high && low >= high))
+		return -OCF_ERR_INVAL;
+
+	part = &cache->user_parts[io_class];
+
+	OCF_METADATA_LOCK_WR();
+	part->dirty_high = high;
+	part->dirty_low = high ? low : 0;
+	OCF_METADATA_UNLOCK_WR();
+
+	if (high) {
+		ocf_cache_log(cache, log_info, "IO class %u dirty watermarks "
+				"set to %u%%/%u%%\n", io_class, low, high);
+	} else {
+		ocf_cache_log(cache, log_info, "IO class %u dirty watermarks "
+				"disabled\n", io_class);
+	}
+
+	return 0;
+}
+
+int ocf_mngt_cache_io_class_get_dirty_watermarks(ocf_cache_t cache,
+		uint32_t io_class, uint8_t *high, uint8_t *low)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(high);
+	OCF_CHECK_NULL(low);
+
+	if (io_class >= OCF_IO_CLASS_MAX)
+		return -OCF_ERR_INVAL;
+
+	*high = cache->user_parts[io_class].dirty_high;
+	*low = cache->user_parts[io_class].dirty_low;
+
+	return 0;
+}
+
+int ocf_mngt_cache_io_class_set_qos(ocf_cache_t cache,
+		uint32_t io_class, uint64_t rate, uint64_t burst)
+{
+	struct ocf_part_qos *qos;
+
+	OCF_CHECK_NULL(cache);
+
+	if (io_class >= OCF_IO_CLASS_MAX)
+		return -OCF_ERR_INVAL;
+
+	/* Keep refill computation within 64 bits */
+	if (rate > OCF_IO_CLASS_QOS_RATE_MAX || burst > OCF_IO_CLASS_QOS_RATE_MAX)
+		return -OCF_ERR_INVAL;
+
+	qos = &cache->user_parts[io_class].qos;
+
+	OCF_METADATA_LOCK_WR();
+	qos->rate = rate;
+	qos->burst = rate ? (burst ?: rate) : 0;
+	env_atomic64_set(&qos->tokens, qos->burst);
+	env_atomic64_set(&qos->refill_ticks, env_get_tick_count());
+	OCF_METADATA_UNLOCK_WR();
+
+	if (rate) {
+		ocf_cache_log(cache, log_info, "IO class %u cache bandwidth "
+				"limited to %llu B/s, burst %llu B\n", io_class,
+				(unsigned long long)rate,
+				(unsigned long long)qos->burst);
+	} else {
+		ocf_cache_log(cache, log_info, "IO class %u cache bandwidth "
+				"limit disabled\n", io_class);
+	}
+
+	return 0;
+}
+
+int ocf_mngt_cache_io_class_get_qos(ocf_cache_t cache,
+		uint32_t io_class, uint64_t *rate, uint64_t *burst)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(rate);
+	OCF_CHECK_NULL(burst);
+
+	if (io_class >= OCF_IO_CLASS_MAX)
+		return -OCF_ERR_INVAL;
+
+	*rate = cache->user_parts[io_class].qos.rate;
+	*burst = cache->user_parts[io_class].qos.burst;
+
+	return 0;
+}
+
+int ocf_mngt_cache_io_class_set_super_line(ocf_cache_t cache,
+		uint32_t io_class, uint32_t size)
+{
+#if OCF_CONFIG_SUPER_LINE_MAX > 0
+	struct ocf_user_part *part;
+	uint32_t lines;
+
+	OCF_CHECK_NULL(cache);
+
+	if (io_class >= OCF_IO_CLASS_MAX)
+		return -OCF_ERR_INVAL;
+
+	lines = size / ocf_line_size(cache);
+	if (size % ocf_line_size(cache) || lines > OCF_CONFIG_SUPER_LINE_MAX ||
+			(lines & (lines - 1))) {
+		ocf_cache_log(cache, log_err, "Invalid super-line size %u\n",
+				size);
+		return -OCF_ERR_INVAL;
+	}
+
+	part = &cache->user_parts[io_class];
+
+	OCF_METADATA_LOCK_WR();
+	part->super_line = lines > 1 ? lines : 0;
+	part->super_recent_next = 0;
+	ENV_BUG_ON(env_memset(part->super_recent,
+			sizeof(part->super_recent), 0));
+	OCF_METADATA_UNLOCK_WR();
+
+	if (part->super_line) {
+		ocf_cache_log(cache, log_info, "IO class %u super-line set to "
+				"%u cache lines\n", io_class, lines);
+	} else {
+		ocf_cache_log(cache, log_info, "IO class %u super-line "
+				"disabled\n", io_class);
+	}
+
+	return 0;
+#else
+	OCF_CHECK_NULL(cache);
+
+	if (size) {
+		ocf_cache_log(cache, log_err, "Super-lines are not supported, "
+				"OCF built without OCF_CONFIG_SUPER_LINE_MAX\n");
+		return -OCF_ERR_INVAL;
+	}
+
+	return io_class < OCF_IO_CLASS_MAX ? 0 : -OCF_ERR_INVAL;
+#endif
+}
+
+int ocf_mngt_cache_io_class_get_super_line(ocf_cache_t cache,
+		uint32_t io_class, uint32_t *size)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(size);
+
+	if (io_class >= OCF_IO_CLASS_MAX)
+		return -OCF_ERR_INVAL;
+
+#if OCF_CONFIG_SUPER_LINE_MAX > 0
+	*size = cache->user_parts[io_class].super_line * ocf_line_size(cache);
+#else
+	*size = 0;
+#endif
+
+	return 0;
+}
+
+int ocf_mngt_cache_set_pinned_max(ocf_cache_t cache, uint32_t lines)
+{
+	OCF_CHECK_NULL(cache);
+
+	cache->pinned_max = lines;
+
+	if (lines) {
+		ocf_cache_log(cache, log_info, "Pinned capacity set to %u "
+				"cache lines\n", lines);
+	} else {
+		ocf_cache_log(cache, log_info, "Pinned capacity not limited\n");
+	}
+
+	return 0;
+}
+
+int ocf_mngt_cache_get_pinned_max(ocf_cache_t cache, uint32_t *lines)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(lines);
+
+	*lines = cache->pinned_max;
+
+	return 0;
+}
@@ -0,0 +1,442 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "ocf_mngt_common.h"
+#include "../ocf_priv.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_core_priv.h"
+#include "../ocf_request.h"
+#include "../engine/engine_prefetch.h"
+#include "../eviction/eviction.h"
+#include "../metadata/metadata.h"
+#include "../utils/utils_cache_line.h"
+#include "../utils/utils_core.h"
+#include "../utils/utils_part.h"
+
+/* Default size of warm-up core read */
+#define OCF_WARM_IO_SIZE_DEFAULT	(1 * MiB)
+
+/* Largest warm-up core read */
+#define OCF_WARM_IO_SIZE_MAX		(16 * MiB)
+
+/* Default number of warm-up core reads in flight */
+#define OCF_WARM_QUEUE_DEPTH_DEFAULT	4
+
+/* Largest number of warm-up core reads in flight */
+#define OCF_WARM_QUEUE_DEPTH_MAX	256
+
+struct ocf_mngt_core_warm_context {
+	ocf_core_t core;
+
+	ocf_mngt_core_warm_end_t cmpl;
+	void *priv;
+
+	env_spinlock lock;
+
+	uint32_t range;
+		/*!< Range being read */
+
+	uint64_t pos;
+		/*!< Byte position in core of next read */
+
+	uint32_t refs;
+		/*!< Number of reads in flight and issuer, warm-up is completed
+		 * when it drops to zero
+		 */
+
+	int error;
+		/*!< First error, no more reads are issued once it is set */
+
+	uint32_t io_size;
+	uint32_t queue_depth;
+
+	uint32_t count;
+	struct ocf_mngt_core_warm_range ranges[];
+};
+
+/* Takes next read of warm-up, returns false if all ranges were read */
+static bool _ocf_mngt_core_warm_next(
+		struct ocf_mngt_core_warm_context *context, uint64_t *addr,
+		uint32_t *bytes, ocf_part_id_t *part_id)
+{
+	struct ocf_mngt_core_warm_range *range;
+	uint64_t end;
+
+	for (; context->range < context->count; context->range++) {
+		range = &context->ranges[context->range];
+
+		if (context->pos < range->addr)
+			context->pos = range->addr;
+		if (context->pos >= range->addr + range->bytes)
+			continue;
+
+		/* Reads after first one of range are aligned to read size */
+		end = (context->pos / context->io_size + 1) * context->io_size;
+		end = OCF_MIN(end, range->addr + range->bytes);
+
+		*addr = context->pos;
+		*bytes = end - context->pos;
+		*part_id = ocf_part_class2id(ocf_core_get_cache(context->core),
+				range->io_class);
+
+		context->pos = end;
+		return true;
+	}
+
+	return false;
+}
+
+static void _ocf_mngt_core_warm_complete(struct ocf_request *req, int error);
+
+/*
+ * Issues reads until queue depth is reached. Caller holds reference of
+ * context, which is dropped before return. Each read in flight holds its own
+ * reference, which is passed to issuer once read completes.
+ */
+static void _ocf_mngt_core_warm_issue(
+		struct ocf_mngt_core_warm_context *context)
+{
+	ocf_cache_t cache = ocf_core_get_cache(context->core);
+	ocf_part_id_t part_id;
+	uint64_t addr;
+	uint32_t bytes;
+	bool finish;
+	int result;
+
+	env_spinlock_lock(&context->lock);
+
+	while (!context->error && context->refs <= context->queue_depth &&
+			_ocf_mngt_core_warm_next(context, &addr, &bytes,
+					&part_id)) {
+		context->refs++;
+		env_spinlock_unlock(&context->lock);
+
+		result = ocf_engine_warm(cache->mngt_queue, context->core,
+				addr, bytes, part_id,
+				_ocf_mngt_core_warm_complete, context);
+
+		env_spinlock_lock(&context->lock);
+		if (result) {
+			context->refs--;
+			if (result < 0 && !context->error)
+				context->error = result;
+		}
+	}
+
+	finish = !--context->refs;
+	env_spinlock_unlock(&context->lock);
+
+	if (!finish)
+		return;
+
+	if (context->error)
+		ocf_core_log(context->core, log_err, "Warm-up failed\n");
+	else
+		ocf_core_log(context->core, log_info, "Warm-up completed\n");
+
+	context->cmpl(context->core, context->priv, context->error);
+	env_vfree(context);
+}
+
+static void _ocf_mngt_core_warm_complete(struct ocf_request *req, int error)
+{
+	struct ocf_mngt_core_warm_context *context = req->priv;
+
+	if (error) {
+		env_spinlock_lock(&context->lock);
+		if (!context->error)
+			context->error = error;
+		env_spinlock_unlock(&context->lock);
+	}
+
+	_ocf_mngt_core_warm_issue(context);
+}
+
+void ocf_mngt_core_warm(ocf_core_t core,
+		const struct ocf_mngt_core_warm_config *cfg,
+		ocf_mngt_core_warm_end_t cmpl, void *priv)
+{
+	struct ocf_mngt_core_warm_context *context;
+	ocf_cache_t cache;
+	uint64_t length;
+	uint32_t i;
+
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(cfg);
+
+	cache = ocf_core_get_cache(core);
+
+	if (!ocf_cache_is_device_attached(cache)) {
+		ocf_core_log(core, log_err, "Cannot warm core - "
+				"cache device is detached\n");
+		cmpl(core, priv, -OCF_ERR_INVAL);
+		return;
+	}
+
+	if (!cache->mngt_queue) {
+		ocf_core_log(core, log_err,
+				"Cannot warm core - no management queue set\n");
+		cmpl(core, priv, -OCF_ERR_INVAL);
+		return;
+	}
+
+	if ((cfg->count && !cfg->ranges) ||
+			cfg->io_size > OCF_WARM_IO_SIZE_MAX ||
+			cfg->queue_depth > OCF_WARM_QUEUE_DEPTH_MAX) {
+		cmpl(core, priv, -OCF_ERR_INVAL);
+		return;
+	}
+
+	context = env_vzalloc(sizeof(*context) +
+			sizeof(context->ranges[0]) * cfg->count);
+	if (!context) {
+		cmpl(core, priv, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	context->core = core;
+	context->cmpl = cmpl;
+	context->priv = priv;
+	context->io_size = cfg->io_size ?: OCF_WARM_IO_SIZE_DEFAULT;
+	context->io_size = OCF_MAX(context->io_size - context->io_size %
+			ocf_line_size(cache), (uint32_t)ocf_line_size(cache));
+	context->queue_depth = cfg->queue_depth ?:
+			OCF_WARM_QUEUE_DEPTH_DEFAULT;
+	context->count = cfg->count;
+	context->refs = 1;
+	env_spinlock_init(&context->lock);
+
+	/* Ranges are clipped to core size */
+	length = ocf_volume_get_length(&core->volume);
+	for (i = 0; i < cfg->count; i++) {
+		context->ranges[i].addr = OCF_MIN(cfg->ranges[i].addr, length);
+		context->ranges[i].bytes = OCF_MIN(cfg->ranges[i].bytes,
+				length - context->ranges[i].addr);
+		context->ranges[i].io_class = cfg->ranges[i].io_class;
+	}
+
+	ocf_core_log(core, log_info, "Warming up %u ranges\n", cfg->count);
+
+	_ocf_mngt_core_warm_issue(context);
+}
+
+struct ocf_mngt_hot_set_export_context {
+	struct ocf_mngt_hot_range *ranges;
+	uint32_t max;
+	uint32_t count;
+
+	uint32_t io_class;
+		/*!< IO class of partition being walked */
+};
+
+/* Extends last exported range by cache line or exports new range */
+static bool _ocf_mngt_hot_set_export_line(ocf_cache_t cache,
+		ocf_cache_line_t line, void *priv)
+{
+	struct ocf_mngt_hot_set_export_context *context = priv;
+	uint64_t line_size = ocf_line_size(cache);
+	struct ocf_mngt_hot_range *range;
+	ocf_core_id_t core_id;
+	uint64_t core_line, addr;
+
+	ocf_metadata_get_core_info(cache, line, &core_id, &core_line);
+	addr = core_line * line_size;
+
+	if (context->count) {
+		range = &context->ranges[context->count - 1];
+
+		if (range->core_id == core_id &&
+				range->io_class == context->io_class) {
+			if (range->addr + range->bytes == addr) {
+				range->bytes += line_size;
+				return true;
+			}
+			if (addr + line_size == range->addr) {
+				range->addr = addr;
+				range->bytes += line_size;
+				return true;
+			}
+		}
+	}
+
+	if (context->count == context->max)
+		return false;
+
+	range = &context->ranges[context->count++];
+	range->core_id = core_id;
+	range->addr = addr;
+	range->bytes = line_size;
+	range->io_class = context->io_class;
+
+	return true;
+}
+
+int ocf_mngt_cache_hot_set_export(ocf_cache_t cache,
+		struct ocf_mngt_hot_range *ranges, uint32_t *count)
+{
+	struct ocf_mngt_hot_set_export_context context = { };
+	ocf_part_id_t part_ids[OCF_IO_CLASS_MAX + 1];
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+	uint32_t parts = 0;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(count);
+
+	if (*count && !ranges)
+		return -OCF_ERR_INVAL;
+
+	if (!ocf_cache_is_device_attached(cache)) {
+		ocf_cache_log(cache, log_err, "Cannot export hot set - "
+				"cache device is detached\n");
+		return -OCF_ERR_INVAL;
+	}
+
+	context.ranges = ranges;
+	context.max = *count;
+
+	OCF_METADATA_LOCK_WR();
+
+	/* Partitions are sorted in eviction order, export them reversed */
+	for_each_part(cache, part, part_id)
+		part_ids[parts++] = part_id;
+
+	while (parts && context.count < context.max) {
+		context.io_class = part_ids[--parts];
+		ocf_eviction_walk_hot(cache, context.io_class,
+				_ocf_mngt_hot_set_export_line, &context);
+	}
+
+	OCF_METADATA_UNLOCK_WR();
+
+	*count = context.count;
+
+	ocf_cache_log(cache, log_info, "Exported hot set of %u ranges\n",
+			context.count);
+
+	return 0;
+}
+
+struct ocf_mngt_hot_set_import_context {
+	ocf_cache_t cache;
+
+	ocf_mngt_cache_hot_set_import_end_t cmpl;
+	void *priv;
+
+	env_spinlock lock;
+
+	uint32_t refs;
+		/*!< Number of core warm-ups in flight and issuer */
+
+	int error;
+		/*!< First error of core warm-ups */
+};
+
+static void _ocf_mngt_hot_set_import_put(
+		struct ocf_mngt_hot_set_import_context *context)
+{
+	bool finish;
+
+	env_spinlock_lock(&context->lock);
+	finish = !--context->refs;
+	env_spinlock_unlock(&context->lock);
+
+	if (!finish)
+		return;
+
+	if (context->error)
+		ocf_cache_log(context->cache, log_err, "Hot set import failed\n");
+	else
+		ocf_cache_log(context->cache, log_info, "Hot set imported\n");
+
+	context->cmpl(context->cache, context->priv, context->error);
+	env_vfree(context);
+}
+
+static void _ocf_mngt_hot_set_import_core_end(ocf_core_t core, void *priv,
+		int error)
+{
+	struct ocf_mngt_hot_set_import_context *context = priv;
+
+	if (error) {
+		env_spinlock_lock(&context->lock);
+		if (!context->error)
+			context->error = error;
+		env_spinlock_unlock(&context->lock);
+	}
+
+	_ocf_mngt_hot_set_import_put(context);
+}
+
+void ocf_mngt_cache_hot_set_import(ocf_cache_t cache,
+		const struct ocf_mngt_hot_range *ranges, uint32_t count,
+		ocf_mngt_cache_hot_set_import_end_t cmpl, void *priv)
+{
+	struct ocf_mngt_hot_set_import_context *context;
+	struct ocf_mngt_core_warm_config cfg = { };
+	struct ocf_mngt_core_warm_range *warm;
+	ocf_core_id_t core_id;
+	uint32_t i;
+
+	OCF_CHECK_NULL(cache);
+
+	if (count && !ranges) {
+		cmpl(cache, priv, -OCF_ERR_INVAL);
+		return;
+	}
+
+	context = env_vzalloc(sizeof(*context));
+	if (!context) {
+		cmpl(cache, priv, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	warm = env_vmalloc(sizeof(*warm) * OCF_MAX(count, 1U));
+	if (!warm) {
+		env_vfree(context);
+		cmpl(cache, priv, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	context->cache = cache;
+	context->cmpl = cmpl;
+	context->priv = priv;
+	context->refs = 1;
+	env_spinlock_init(&context->lock);
+
+	ocf_cache_log(cache, log_info, "Importing hot set of %u ranges\n",
+			count);
+
+	/* Warm-up copies ranges, so buffer is reused for each core */
+	for_each_core(cache, core_id) {
+		cfg.count = 0;
+		for (i = 0; i < count; i++) {
+			if (ranges[i].core_id != core_id)
+				continue;
+
+			warm[cfg.count].addr = ranges[i].addr;
+			warm[cfg.count].bytes = ranges[i].bytes;
+			warm[cfg.count].io_class = ranges[i].io_class;
+			cfg.count++;
+		}
+
+		if (!cfg.count)
+			continue;
+
+		cfg.ranges = warm;
+
+		env_spinlock_lock(&context->lock);
+		context->refs++;
+		env_spinlock_unlock(&context->lock);
+
+		ocf_mngt_core_warm(&cache->core[core_id], &cfg,
+				_ocf_mngt_hot_set_import_core_end, context);
+	}
+
+	env_vfree(warm);
+
+	_ocf_mngt_hot_set_import_put(context);
+}
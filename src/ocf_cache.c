@@ -9,8 +9,13 @@
 #include "utils/utils_cache_line.h"
 #include "utils/utils_req.h"
 #include "utils/utils_part.h"
+#include "utils/utils_core.h"
+#include "concurrency/ocf_concurrency.h"
+#include "cleaning/cleaning.h"
+#include "promotion/promotion.h"
 #include "ocf_priv.h"
 #include "ocf_cache_priv.h"
+#include "ocf_trace_priv.h"
 
 ocf_volume_t ocf_cache_get_volume(ocf_cache_t cache)
 {
@@ -75,7 +80,7 @@ bool ocf_cache_has_pending_requests(ocf_cache_t cache)
 
 /*
  * This is temporary workaround allowing to check if cleaning triggered
- * by eviction policy is running on the cache. This information is needed
+ * by eviction policy or cleaner run is in progress on the cache. This information is needed
  * to remove core from cache properly.
  *
  * TODO: Replace this with asynchronous notification to which remove/detach
@@ -89,6 +94,9 @@ bool ocf_cache_has_pending_cleaning(ocf_cache_t cache)
 
 	OCF_CHECK_NULL(cache);
 
+	if (ocf_cleaner_is_active(cache))
+		return true;
+
 	OCF_METADATA_LOCK_RD();
 	for_each_part(cache, curr_part, part_id) {
 		if (env_atomic_read(&cache->cleaning[part_id])) {
@@ -140,7 +148,7 @@ int ocf_cache_get_info(ocf_cache_t cache, struct ocf_cache_info *info)
 	if (info->attached) {
 		info->volume_type = ocf_ctx_get_volume_type_id(cache->owner,
 				cache->device->volume.type);
-		info->size = cache->conf_meta->cachelines;
+		info->size = cache->device->lines_limit;
 	}
 	info->core_count = cache->conf_meta->core_count;
 
@@ -221,6 +229,63 @@ int ocf_cache_get_info(ocf_cache_t cache, struct ocf_cache_info *info)
 	return 0;
 }
 
+int ocf_cache_get_memory_usage(ocf_cache_t cache,
+		struct ocf_cache_memory_usage *usage)
+{
+	ocf_cleaning_t cleaning_policy;
+	ocf_queue_t queue;
+	uint32_t i;
+
+	OCF_CHECK_NULL(cache);
+
+	if (!usage)
+		return -OCF_ERR_INVAL;
+
+	ENV_BUG_ON(env_memset(usage, sizeof(*usage), 0));
+
+	if (ocf_cache_is_device_attached(cache)) {
+		ocf_metadata_mem_usage(cache, usage);
+		usage->concurrency = ocf_cache_concurrency_size_of(cache);
+		ocf_cache_concurrency_waiters_usage(cache,
+				&usage->waiters_allocs, &usage->waiters);
+
+		cleaning_policy = cache->conf_meta->cleaning_policy_type;
+		if (cleaning_policy_ops[cleaning_policy].size_of) {
+			usage->cleaning =
+				cleaning_policy_ops[cleaning_policy].size_of(
+						cache);
+		}
+
+		usage->promotion = ocf_promotion_size_of(cache,
+				cache->device->collision_table_entries);
+	}
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+	list_for_each_entry(queue, &cache->io_queues, list) {
+		if (queue->trace_ring)
+			usage->trace += sizeof(*queue->trace_ring);
+	}
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+
+	for_each_core(cache, i) {
+		if (cache->core[i].counters) {
+			usage->stats += sizeof(*cache->core[i].counters) *
+					OCF_STATS_SHARDS;
+		}
+	}
+
+	for (i = 0; i < usage->segments_count; i++)
+		usage->total += usage->segments[i].bytes;
+
+	usage->total += usage->metadata_other + usage->concurrency +
+			usage->waiters + usage->cleaning + usage->promotion +
+			usage->trace + usage->stats;
+
+	ocf_req_allocator_mem_usage(cache->owner, usage);
+
+	return 0;
+}
+
 const struct ocf_volume_uuid *ocf_cache_get_uuid(ocf_cache_t cache)
 {
 	if (!ocf_cache_is_device_attached(cache))
@@ -17,6 +17,7 @@
 #include "utils/utils_refcnt.h"
 #include "ocf_stats_priv.h"
 #include "cleaning/cleaning.h"
+#include "promotion/promotion.h"
 #include "ocf_logger_priv.h"
 #include "ocf/ocf_trace.h"
 
@@ -33,7 +34,11 @@ struct ocf_trace {
 	/* Telemetry context */
 	void *trace_ctx;
 
-	env_atomic64 trace_seq_ref;
+	/* Events are stored in trace rings of I/O queues */
+	bool trace_ring;
+
+	/* Push request stage events */
+	bool req_stages;
 };
 
 struct ocf_metadata_uuid {
@@ -140,6 +145,57 @@ struct ocf_cache_device {
 	enum ocf_mngt_cache_init_mode init_mode;
 
 	struct ocf_superblock_runtime *runtime_meta;
+
+	/* Physical cache lines at and above limit are kept off free list,
+	 * see ocf_mngt_cache_resize()
+	 */
+	ocf_cache_line_t lines_limit;
+
+#if OCF_CONFIG_FREE_MAP
+	/* Bitmap of physical cache lines which are on free list and word of
+	 * bitmap where search for free super-line or log segment starts,
+	 * protected by free list lock
+	 */
+	struct {
+		uint64_t *bits;
+		uint32_t cursor;
+	} free_map;
+#endif
+
+#if OCF_CONFIG_LOOKUP_FILTER
+	/* Counting filter of core lines mapped in each hash bucket, see
+	 * ocf_metadata_lookup_filter_test()
+	 */
+	uint64_t *lookup_filter;
+#endif
+
+#if OCF_CONFIG_TRIM_MIN_LINES > 0
+	/* Bitmap of physical cache lines put on free list since they were
+	 * discarded and line where search for run of them starts, protected
+	 * by free list lock. Lines from 'start' up to 'end' are off free list
+	 * while being discarded by trim request.
+	 */
+	struct {
+		uint64_t *bits;
+		uint32_t cursor;
+		ocf_cache_line_t count;
+		ocf_cache_line_t start;
+		ocf_cache_line_t end;
+		env_atomic active;
+	} trim;
+#endif
+
+	/* Discard of cache device in background after attach. Physical cache
+	 * lines below 'released' are on free list, lines up to 'submitted'
+	 * are being discarded and the rest waits for its turn.
+	 */
+	struct {
+		ocf_cache_line_t released;
+		ocf_cache_line_t submitted;
+		ocf_cache_line_t end;
+		env_atomic cancel;
+		int error;
+	} bg_discard;
 };
 
 struct ocf_cache {
@@ -160,32 +216,149 @@ struct ocf_cache {
 	struct ocf_lst lst_part;
 	struct ocf_user_part user_parts[OCF_IO_CLASS_MAX + 1];
 
+	/* Two snapshots of IO class mapping, the one selected by parity of
+	 * version is current. Previous snapshot is overwritten only by next
+	 * reconfiguration, which gives lock-free readers time to finish.
+	 */
+	struct {
+		struct ocf_part_class_map maps[2];
+		env_atomic version;
+	} class_map;
+	struct ocf_part_evict_plan part_evict;
+	env_atomic part_sort_gen;
+		/*!< Bumped on every resort of partitions, so that orderings
+		 * derived from their configuration can be cached
+		 */
+	uint32_t pinned_max;
+		/*!< Pinned capacity in cache lines, 0 if not limited */
+	struct ocf_counters_eviction eviction_counters[OCF_IO_CLASS_MAX + 1];
+	struct ocf_counters_cleaner cleaner_counters;
+#if OCF_CONFIG_STATS_LOCK
+	struct ocf_counters_lock lock_counters[ocf_stats_lock_max];
+#endif
+#if OCF_CONFIG_STATS_WINDOW > 0
+	struct ocf_stats_window stats_window;
+#endif
+	struct {
+		env_atomic busy;
+		uint64_t last_ticks;
+	} mode_advisor;
+		/*!< Interval of cache mode advisors of cores */
+
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0
+	/* Background checkpoint of modified metadata pages */
+	struct {
+		env_atomic in_progress;
+		uint64_t last_ticks;
+
+		/* References of I/Os which may change cached data, frozen
+		 * while checkpoint is written or valid */
+		struct ocf_refcnt io;
+
+		env_spinlock lock;
+		enum ocf_checkpoint_state {
+			ocf_checkpoint_idle,
+			ocf_checkpoint_writing,
+			ocf_checkpoint_arming,
+			ocf_checkpoint_armed,
+			ocf_checkpoint_disarming,
+		} state;
+
+		/* I/Os held until checkpoint is invalidated */
+		struct list_head held;
+
+		ocf_metadata_end_t cmpl;
+		void *priv;
+	} checkpoint;
+#endif
+
 	struct ocf_metadata metadata;
 
 	ocf_eviction_t eviction_policy_init;
 
+	struct promotion_policy promotion;
+
+	struct ocf_eviction_ghost ghost;
+
+	struct ocf_ram_tier *ram_tier;
+		/*!< Copies of hot cache lines, NULL if disabled */
+
+	struct ocf_fill_table *fill;
+		/*!< In-flight backfills served to reads, NULL if disabled */
+
+#if OCF_CONFIG_ZERO_LINES
+	struct {
+		ctx_data_t *data;
+			/*!< Cache line of zeroes, source of zero line reads */
+
+		bool detect;
+			/*!< Zero writes are kept as zero lines */
+	} zero_lines;
+#endif
+
 	int cache_id;
 
 	char name[OCF_CACHE_NAME_SIZE];
 
-	env_atomic pending_requests;
+	/* Requests in flight, sharded by I/O queue */
+	struct ocf_refcnt pending_requests;
 
-	env_atomic pending_cache_requests;
-	env_waitqueue pending_cache_wq;
+	/* Requests in flight which may access cache device */
+	struct ocf_refcnt pending_cache_requests;
 
 	struct ocf_refcnt dirty;
 
 	uint32_t fallback_pt_error_threshold;
 	env_atomic fallback_pt_error_counter;
 
+	uint32_t flush_queue_depth;
+
 	env_atomic pending_read_misses_list_blocked;
 	env_atomic pending_read_misses_list_count;
 
-	env_atomic last_access_ms;
-
 	env_atomic pending_eviction_clines;
 
+	/* Free cache lines reserve refill is scheduled */
+	env_atomic eviction_reserve_pending;
+
+	/* Requests parked until background eviction frees cache lines */
+	struct {
+		env_spinlock lock;
+		struct list_head list;
+		uint32_t lines;
+	} eviction_waiters;
+
+#if OCF_CONFIG_LOG_SEGMENT_LINES > 0
+	/* No free log-structured allocation segment was found, segment
+	 * cleaner run is scheduled or cleaning it started is in progress,
+	 * and segment it checks next, protected by metadata WR lock
+	 */
+	struct {
+		env_atomic needed;
+		env_atomic pending;
+		uint32_t cursor;
+	} segment_cleaner;
+#endif
+
+#if OCF_CONFIG_PART_MOVE_BATCH > 0
+	/* Partition moves of hit cache lines waiting for metadata WR
+	 * section, see ocf_part_move_deferred()
+	 */
+	struct {
+		env_spinlock lock;
+		uint32_t count;
+		struct ocf_part_move_entry {
+			uint64_t core_line;
+			ocf_cache_line_t line;
+			ocf_core_id_t core_id;
+			ocf_part_id_t part_id;
+		} entries[OCF_CONFIG_PART_MOVE_BATCH];
+	} part_moves;
+#endif
+
 	struct list_head io_queues;
+	env_rwlock io_queues_lock;
+	uint32_t io_queues_next_id;
 	ocf_queue_t mngt_queue;
 
 	uint16_t ocf_core_inactive_count;
@@ -193,14 +366,31 @@ struct ocf_cache {
 	struct ocf_core_meta_config *core_conf_meta;
 	struct ocf_core_meta_runtime *core_runtime_meta;
 
+	unsigned long dirty_core_bitmap[OCF_CORE_MAX /
+			(8 * sizeof(unsigned long))];
+		/*!< Cores which may have dirty cache lines. Bit is set when
+		 * core gets its first dirty line and cleared when last one is
+		 * cleaned. It may be left set spuriously by racing updates, so
+		 * dirty lines counter of core still has to be checked.
+		 */
+
 	env_atomic flush_in_progress;
 
+	struct {
+		env_atomic64 written;
+			/*!< Completed cache writes which need cache volume
+			 * flush to become durable
+			 */
+		env_atomic64 flushed;
+			/*!< Value of written covered by completed flush */
+	} flush_gen;
+
 	/* 1 if cache device attached, 0 otherwise */
 	env_atomic attached;
 
 	env_atomic cleaning[OCF_IO_CLASS_MAX];
 
-	struct ocf_cleaner cleaner;
+	struct ocf_cleaners cleaner;
 	struct ocf_metadata_updater metadata_updater;
 
 	env_rwsem lock;
@@ -214,17 +404,105 @@ struct ocf_cache {
 	struct {
 		uint32_t max_queue_size;
 		uint32_t queue_unblock_size;
+		bool zero_copy;
+		uint32_t latency_target_us;
+		env_atomic queue_limit;
+			/*!< Current limit of pending backfills */
+		env_atomic64 write_latency;
+			/*!< Moving average of backfill write latency in ns */
 	} backfill;
 
 	bool pt_unaligned_io;
 
 	bool use_submit_io_fast;
 
+	/* Collect I/O size and alignment histograms of cores */
+	bool debug_stats;
+
+	/* Compressibility estimator, allocated when enabled first time */
+	struct ocf_compress_est *compress_est;
+	bool compress_est_enabled;
+
+	/* Deduplication estimator, allocated when enabled first time */
+	struct ocf_dedup_est *dedup_est;
+	bool dedup_est_enabled;
+
 	struct ocf_trace trace;
 
 	void *priv;
 };
 
+/*
+ * Record completion of cache volume write of dirty data or metadata, which
+ * is durable only after following flush of cache volume
+ */
+static inline void ocf_cache_flush_gen_inc(ocf_cache_t cache)
+{
+	env_atomic64_inc(&cache->flush_gen.written);
+}
+
+/* Account dirty cache line of core */
+static inline void ocf_cache_core_dirty_inc(ocf_cache_t cache,
+		ocf_core_id_t core_id)
+{
+	if (env_atomic_inc_return(&cache->core_runtime_meta[core_id].
+			dirty_clines) == 1) {
+		env_bit_set(core_id, cache->dirty_core_bitmap);
+	}
+}
+
+/*
+ * Account cleaned cache line of core. Returns true if it was the last dirty
+ * one. Bit is set again when core got dirty meanwhile, as clear could have
+ * overtaken set done on its behalf.
+ */
+static inline bool ocf_cache_core_dirty_dec(ocf_cache_t cache,
+		ocf_core_id_t core_id)
+{
+	env_atomic *dirty = &cache->core_runtime_meta[core_id].dirty_clines;
+
+	if (!env_atomic_dec_and_test(dirty))
+		return false;
+
+	env_bit_clear(core_id, cache->dirty_core_bitmap);
+	if (env_atomic_read(dirty))
+		env_bit_set(core_id, cache->dirty_core_bitmap);
+
+	return true;
+}
+
+/* Reset dirty cache lines counter of core */
+static inline void ocf_cache_core_dirty_reset(ocf_cache_t cache,
+		ocf_core_id_t core_id)
+{
+	env_atomic_set(&cache->core_runtime_meta[core_id].dirty_clines, 0);
+	env_bit_clear(core_id, cache->dirty_core_bitmap);
+}
+
+/* Find first core starting from given id which may have dirty lines */
+static inline ocf_core_id_t ocf_cache_dirty_core_next(ocf_cache_t cache,
+		uint32_t core_id)
+{
+	const uint32_t bits = 8 * sizeof(unsigned long);
+	unsigned long word;
+
+	while (core_id < OCF_CORE_MAX) {
+		word = cache->dirty_core_bitmap[core_id / bits] >>
+				(core_id % bits);
+		if (!word) {
+			core_id = (core_id / bits + 1) * bits;
+			continue;
+		}
+
+		if (word & 1)
+			return core_id;
+
+		core_id++;
+	}
+
+	return OCF_CORE_MAX;
+}
+
 #define ocf_cache_log_prefix(cache, lvl, prefix, fmt, ...) \
 	ocf_log_prefix(ocf_cache_get_ctx(cache), lvl, "%s" prefix, \
 			fmt, ocf_cache_get_name(cache), ##__VA_ARGS__)
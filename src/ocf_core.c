@@ -8,16 +8,17 @@
 #include "ocf_core_priv.h"
 #include "ocf_io_priv.h"
 #include "metadata/metadata.h"
+#include "metadata/metadata_core_index.h"
 #include "engine/cache_engine.h"
+#include "engine/engine_fast.h"
 #include "utils/utils_req.h"
 #include "utils/utils_part.h"
 #include "utils/utils_device.h"
+#include "utils/utils_cache_line.h"
+#include "utils/utils_checkpoint.h"
 #include "ocf_request.h"
 #include "ocf_trace_priv.h"
-
-struct ocf_core_volume {
-	ocf_core_t core;
-};
+#include "utils/utils_mrc.h"
 
 ocf_cache_t ocf_core_get_cache(ocf_core_t core)
 {
@@ -113,6 +114,16 @@ ocf_seq_cutoff_policy ocf_core_get_seq_cutoff_policy(ocf_core_t core)
 	return cache->core_conf_meta[core_id].seq_cutoff_policy;
 }
 
+ocf_cache_mode_t ocf_core_get_advised_mode(ocf_core_t core)
+{
+	OCF_CHECK_NULL(core);
+
+	if (core->mode_advisor.policy == ocf_mode_advisor_off)
+		return ocf_cache_mode_none;
+
+	return env_atomic_read(&core->mode_advisor.mode);
+}
+
 int ocf_core_visit(ocf_cache_t cache, ocf_core_visitor_t visitor, void *cntx,
 		bool only_opened)
 {
@@ -141,33 +152,26 @@ int ocf_core_visit(ocf_cache_t cache, ocf_core_visitor_t visitor, void *cntx,
 
 /* *** HELPER FUNCTIONS *** */
 
-static inline struct ocf_core_io *ocf_io_to_core_io(struct ocf_io *io)
-{
-	return ocf_io_get_priv(io);
-}
-
-static inline ocf_core_t ocf_volume_to_core(ocf_volume_t volume)
+static inline int ocf_io_set_dirty(ocf_cache_t cache, struct ocf_io *io)
 {
-	struct ocf_core_volume *core_volume = ocf_volume_get_priv(volume);
-
-	return core_volume->core;
-}
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
 
-static inline int ocf_io_set_dirty(ocf_cache_t cache,
-		struct ocf_core_io *core_io)
-{
-	core_io->dirty = ocf_refcnt_inc(&cache->dirty);
+	core_io->dirty = ocf_refcnt_inc_shard(&cache->dirty,
+			io->io_queue->id);
 	return core_io->dirty ? 0 : -EBUSY;
 }
 
-static inline void dec_counter_if_req_was_dirty(struct ocf_core_io *core_io,
-		ocf_cache_t cache)
+static inline void dec_io_counters(struct ocf_io *io, ocf_cache_t cache)
 {
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+
+	ocf_checkpoint_put_io(cache, io);
+
 	if (!core_io->dirty)
 		return;
 
 	core_io->dirty = 0;
-	ocf_refcnt_dec(&cache->dirty);
+	ocf_refcnt_dec_shard(&cache->dirty, io->io_queue->id);
 }
 
 static inline int ocf_core_validate_io(struct ocf_io *io)
@@ -202,19 +206,411 @@ static inline int ocf_core_validate_io(struct ocf_io *io)
 static void ocf_req_complete(struct ocf_request *req, int error)
 {
 	/* Log trace */
-	ocf_trace_io_cmpl(ocf_io_to_core_io(req->io), req->cache);
+	ocf_trace_io_cmpl(req->io, req->cache);
+
+	if (req->submit_ticks)
+		ocf_cleaner_throttle_io_done(req->cache, req->submit_ticks);
+
+	ocf_core_stats_latency_update(req);
 
 	/* Complete IO */
 	ocf_io_end(req->io, error);
 
-	dec_counter_if_req_was_dirty(ocf_io_to_core_io(req->io), req->cache);
+	dec_io_counters(req->io, req->cache);
 
 	/* Invalidate OCF IO, it is not valid after completion */
 	ocf_io_put(req->io);
 	req->io = NULL;
 }
 
-void ocf_core_submit_io_mode(struct ocf_io *io, ocf_cache_mode_t cache_mode)
+static void ocf_core_forward_io_complete(struct ocf_io *vol_io, int error)
+{
+	struct ocf_io *io = vol_io->priv1;
+	ocf_core_t core = ocf_volume_to_core(io->volume);
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	ocf_queue_t queue = io->io_queue;
+
+	if (error && io->dir == OCF_READ)
+		env_atomic_inc(&ocf_core_stats(core, queue)->core_errors.read);
+	else if (error)
+		env_atomic_inc(&ocf_core_stats(core, queue)->core_errors.write);
+
+	ocf_trace_io_cmpl(io, cache);
+
+	ocf_io_end(io, error);
+
+	dec_io_counters(io, cache);
+
+	ocf_io_put(io);
+	ocf_io_put(vol_io);
+
+	ocf_refcnt_dec_shard(&cache->pending_requests, queue->id);
+}
+
+/*
+ * Forward IO straight to core volume, without request. Core volume IO
+ * shares data, queue and flags of the IO, which is completed in place once
+ * core volume IO is done. Returns false if IO has to go through request
+ * based engine.
+ */
+static bool ocf_core_forward_io(ocf_core_t core, struct ocf_io *io)
+{
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	ocf_queue_t queue = io->io_queue;
+	struct ocf_counters_core *stats;
+	struct ocf_counters_part *part;
+	struct ocf_io *vol_io;
+
+	vol_io = ocf_volume_new_io(&core->volume);
+	if (!vol_io)
+		return false;
+
+	ocf_io_configure(vol_io, io->addr, io->bytes, io->dir, io->io_class,
+			io->flags);
+	ocf_io_set_queue(vol_io, queue);
+	ocf_io_set_cmpl(vol_io, io, NULL, ocf_core_forward_io_complete);
+	if (ocf_io_set_data(vol_io, core_io->data, 0)) {
+		ocf_io_put(vol_io);
+		return false;
+	}
+
+	ocf_refcnt_inc_shard_force(&cache->pending_requests, queue->id);
+
+	ocf_seq_cutoff_update_io(core, io);
+
+	ocf_core_update_stats(core, io);
+
+	stats = ocf_core_stats(core, queue);
+	part = &stats->part_counters[ocf_part_class2id(cache, io->io_class)];
+	if (io->dir == OCF_WRITE) {
+		ocf_trace_io(io, ocf_event_operation_wr, cache);
+		env_atomic64_add(io->bytes, &part->blocks.write_bytes);
+		env_atomic64_add(io->bytes, &stats->core_blocks.write_bytes);
+		env_atomic64_inc(&part->write_reqs.pass_through);
+	} else {
+		ocf_trace_io(io, ocf_event_operation_rd, cache);
+		env_atomic64_add(io->bytes, &part->blocks.read_bytes);
+		env_atomic64_add(io->bytes, &stats->core_blocks.read_bytes);
+		env_atomic64_inc(&part->read_reqs.pass_through);
+	}
+
+	ocf_io_get(io);
+	ocf_volume_submit_io(vol_io);
+
+	return true;
+}
+
+/*
+ * Pass-through IO of core range without any mapped cache line has nothing
+ * to invalidate or clean, so it is forwarded to core volume without
+ * metadata access. Returns false if IO has to go through pass-through
+ * engine.
+ */
+static bool ocf_core_submit_pt_bypass(ocf_core_t core, struct ocf_io *io)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	ocf_queue_t queue = io->io_queue;
+	bool mapped;
+
+	if (!ocf_core_index_enabled(core) || queue == cache->mngt_queue)
+		return false;
+
+	/* Read ahead is driven by requests */
+	if (io->dir == OCF_READ && core->prefetch_lines)
+		return false;
+
+	/* Index is freed on detach only after cache requests are done */
+	if (!env_atomic_read(&cache->attached) ||
+			!ocf_refcnt_inc_shard(&cache->pending_cache_requests,
+				queue->id)) {
+		return false;
+	}
+
+	mapped = !env_atomic_read(&cache->attached) ||
+		ocf_core_index_range_mapped(core,
+				ocf_bytes_2_lines(cache, io->addr),
+				ocf_bytes_2_lines(cache, io->addr + io->bytes - 1));
+
+	ocf_refcnt_dec_shard(&cache->pending_cache_requests, queue->id);
+
+	if (mapped)
+		return false;
+
+	return ocf_core_forward_io(core, io);
+}
+
+/*
+ * With cache device detached every IO would be served by D2C engine, so it
+ * is forwarded to core volume without allocating request. Management queue
+ * IOs keep using requests, as they are not accounted in pending requests.
+ */
+static bool ocf_core_submit_d2c_bypass(ocf_core_t core, struct ocf_io *io)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+
+	if (env_atomic_read(&cache->attached) ||
+			io->io_queue == cache->mngt_queue) {
+		return false;
+	}
+
+	return ocf_core_forward_io(core, io);
+}
+
+/*
+ * Allocate and set up request of IO, ready to be pushed to I/O queue.
+ * Returns NULL if IO was already completed.
+ */
+void ocf_core_mrc_deinit(ocf_core_t core)
+{
+	core->mrc_enabled = false;
+
+	if (core->mrc) {
+		ocf_mrc_deinit(core->mrc);
+		core->mrc = NULL;
+	}
+}
+
+void ocf_core_pinned_deinit(ocf_core_t core)
+{
+	env_free(core->pinned);
+	core->pinned = NULL;
+}
+
+/* Assign IO overlapping pinned range of core to IO class of the range */
+static inline void ocf_core_pin_io(ocf_core_t core, struct ocf_io *io)
+{
+	const struct ocf_core_pinned_map *map;
+	const struct ocf_mngt_core_pinned_range *range;
+	uint32_t i;
+
+	if (likely(!core->pinned))
+		return;
+
+	map = &core->pinned->maps[env_atomic_read(&core->pinned->version) & 1];
+
+	for (i = 0; i < map->count; i++) {
+		range = &map->ranges[i];
+		if (io->addr < range->addr + range->bytes &&
+				range->addr < io->addr + io->bytes) {
+			io->io_class = range->io_class;
+			return;
+		}
+	}
+}
+
+static inline void ocf_core_mrc_update(ocf_core_t core,
+		struct ocf_request *req)
+{
+	uint64_t line;
+
+	if (!core->mrc_enabled)
+		return;
+
+	for (line = req->core_line_first; line <= req->core_line_last; line++)
+		ocf_mrc_access(core->mrc, line);
+}
+
+#if OCF_CONFIG_SPLIT_IO_BYTES
+static void ocf_core_split_complete(struct ocf_request *req, int error)
+{
+	struct ocf_io *io = req->io;
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+
+	ocf_core_stats_latency_update(req);
+
+	if (error)
+		env_atomic_cmpxchg(&core_io->split_error, 0, error);
+
+	req->io = NULL;
+
+	/* IO completes with the last of its requests */
+	if (env_atomic_dec_return(&core_io->split_remaining))
+		return;
+
+	ocf_trace_io_cmpl(io, req->cache);
+
+	if (req->submit_ticks)
+		ocf_cleaner_throttle_io_done(req->cache, req->submit_ticks);
+
+	ocf_io_end(io, env_atomic_read(&core_io->split_error));
+
+	dec_io_counters(io, req->cache);
+
+	ocf_io_put(io);
+}
+
+static void ocf_core_split_put_reqs(struct list_head *reqs)
+{
+	struct ocf_request *req, *tmp;
+
+	list_for_each_entry_safe(req, tmp, reqs, list) {
+		list_del(&req->list);
+		ocf_req_put(req);
+	}
+}
+
+/*
+ * Split IO larger than OCF_CONFIG_SPLIT_IO_BYTES into requests aligned to
+ * split size and push them to I/O queue together. Returns false if IO has
+ * to be handled with single request.
+ */
+static bool ocf_core_split_io(ocf_core_t core, struct ocf_io *io,
+		ocf_req_cache_mode_t req_cache_mode)
+{
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	uint64_t line_size = ocf_line_size(cache);
+	uint64_t split, addr, end, submit_ticks = 0;
+	struct ocf_request *req;
+	struct list_head reqs;
+	uint32_t count = 0;
+	int ret;
+
+	split = OCF_MAX(OCF_CONFIG_SPLIT_IO_BYTES / line_size, 1ULL) *
+			line_size;
+	if (io->bytes <= split)
+		return false;
+
+	if (cache->cleaner.throttle.target_us)
+		submit_ticks = env_get_tick_count();
+
+	INIT_LIST_HEAD(&reqs);
+
+	for (addr = io->addr; addr < io->addr + io->bytes; addr = end) {
+		end = OCF_MIN((addr / split + 1) * split, io->addr + io->bytes);
+
+		req = ocf_req_new(io->io_queue, core, addr, end - addr,
+				io->dir);
+		if (!req) {
+			/* Let single request try its luck */
+			ocf_core_split_put_reqs(&reqs);
+			return false;
+		}
+
+		list_add_tail(&req->list, &reqs);
+		count++;
+
+		req->part_id = ocf_part_class2id(cache, io->io_class);
+		req->data = core_io->data;
+		req->data_offset = addr - io->addr;
+		req->complete = ocf_core_split_complete;
+		req->io = io;
+		req->submit_ticks = submit_ticks;
+
+		ret = ocf_engine_prepare_req(req, req->d2c ?
+				ocf_req_cache_mode_d2c : req_cache_mode);
+		if (ret) {
+			ocf_core_split_put_reqs(&reqs);
+			dec_io_counters(io, cache);
+			io->end(io, ret);
+			return true;
+		}
+	}
+
+	list_for_each_entry(req, &reqs, list) {
+		ocf_seq_cutoff_update(core, req);
+		ocf_core_mrc_update(core, req);
+	}
+
+	ocf_core_update_stats(core, io);
+
+	if (io->dir == OCF_WRITE)
+		ocf_trace_io(io, ocf_event_operation_wr, cache);
+	else if (io->dir == OCF_READ)
+		ocf_trace_io(io, ocf_event_operation_rd, cache);
+
+	core_io->req = NULL;
+	env_atomic_set(&core_io->split_remaining, count);
+	env_atomic_set(&core_io->split_error, 0);
+
+	ocf_io_get(io);
+	ocf_engine_push_reqs_back(io->io_queue, &reqs);
+
+	return true;
+}
+#else
+static inline bool ocf_core_split_io(ocf_core_t core, struct ocf_io *io,
+		ocf_req_cache_mode_t req_cache_mode)
+{
+	return false;
+}
+#endif
+
+/* Request of IO, embedded in the IO if it spans few cache lines */
+static struct ocf_request *ocf_core_io_req_new(struct ocf_io *io,
+		ocf_core_t core, bool extended)
+{
+#if OCF_CONFIG_CORE_IO_EMBEDDED_LINES
+	struct ocf_request *req;
+
+	req = ocf_req_new_embedded(io, core, ocf_io_to_core_io(io)->req_mem,
+			OCF_CONFIG_CORE_IO_EMBEDDED_LINES);
+	if (req)
+		return req;
+#endif
+
+	if (extended) {
+		return ocf_req_new_extended(io->io_queue, core, io->addr,
+				io->bytes, io->dir);
+	}
+
+	return ocf_req_new(io->io_queue, core, io->addr, io->bytes, io->dir);
+}
+
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0
+static void ocf_core_resume_io(struct ocf_io *io)
+{
+	ocf_core_submit_io_mode(io, ocf_io_to_core_io(io)->cache_mode);
+}
+#endif
+
+/*
+ * Take metadata checkpoint reference of IO, or hold IO until checkpoint is
+ * invalidated. Returns false if IO is held.
+ */
+static inline bool ocf_core_checkpoint_get(ocf_cache_t cache,
+		struct ocf_io *io, ocf_cache_mode_t cache_mode)
+{
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0
+	ocf_io_to_core_io(io)->cache_mode = cache_mode;
+
+	return ocf_checkpoint_get_io(cache, io, ocf_core_resume_io);
+#else
+	return true;
+#endif
+}
+
+/* State of IOs submitted in single batch */
+struct ocf_core_batch {
+	ocf_core_t core;
+	/*!< Core of IO class whose cache mode was resolved */
+
+	uint32_t io_class;
+
+	ocf_cache_mode_t class_mode;
+	/*!< Cache mode of IO class, resolved once per batch */
+};
+
+/* Get cache mode of IO, resolving mode of its IO class once per batch */
+static ocf_cache_mode_t ocf_core_get_io_cache_mode(ocf_cache_t cache,
+		ocf_core_t core, struct ocf_io *io, struct ocf_core_batch *batch)
+{
+	if (!batch)
+		return ocf_get_effective_cache_mode(cache, core, io);
+
+	if (batch->core != core || batch->io_class != io->io_class) {
+		batch->core = core;
+		batch->io_class = io->io_class;
+		batch->class_mode = ocf_get_class_cache_mode(cache, core,
+				io->io_class);
+	}
+
+	return ocf_get_io_cache_mode(cache, core, io, batch->class_mode);
+}
+
+static struct ocf_request *ocf_core_prepare_req(struct ocf_io *io,
+		ocf_cache_mode_t cache_mode, struct ocf_core_batch *batch)
 {
 	struct ocf_core_io *core_io;
 	ocf_req_cache_mode_t req_cache_mode;
@@ -227,7 +623,7 @@ void ocf_core_submit_io_mode(struct ocf_io *io, ocf_cache_mode_t cache_mode)
 	ret = ocf_core_validate_io(io);
 	if (ret < 0) {
 		io->end(io, -EINVAL);
-		return;
+		return NULL;
 	}
 
 	core_io = ocf_io_to_core_io(io);
@@ -235,31 +631,46 @@ void ocf_core_submit_io_mode(struct ocf_io *io, ocf_cache_mode_t cache_mode)
 	core = ocf_volume_to_core(io->volume);
 	cache = ocf_core_get_cache(core);
 
-	ocf_trace_init_io(core_io, cache);
+	ocf_core_pin_io(core, io);
 
 	if (unlikely(!env_bit_test(ocf_cache_state_running,
 					&cache->cache_state))) {
 		ocf_io_end(io, -EIO);
-		return;
+		return NULL;
 	}
 
+	if (!ocf_core_checkpoint_get(cache, io, cache_mode))
+		return NULL;
+
+	if (ocf_core_submit_d2c_bypass(core, io))
+		return NULL;
+
 	/* TODO: instead of casting ocf_cache_mode_t to ocf_req_cache_mode_t
 	   we can resolve IO interface here and get rid of the latter. */
 	req_cache_mode = cache_mode;
 
-	if (cache_mode == ocf_cache_mode_none)
-		req_cache_mode = ocf_get_effective_cache_mode(cache, core, io);
+	if (cache_mode == ocf_cache_mode_none) {
+		req_cache_mode = ocf_core_get_io_cache_mode(cache, core, io,
+				batch);
+	}
 	if (req_cache_mode == ocf_req_cache_mode_wb &&
-			ocf_io_set_dirty(cache, core_io)) {
+			ocf_io_set_dirty(cache, io)) {
 		req_cache_mode = ocf_req_cache_mode_wt;
 	}
 
-	core_io->req = ocf_req_new(io->io_queue, core, io->addr, io->bytes,
-			io->dir);
+	if (req_cache_mode == ocf_req_cache_mode_pt &&
+			ocf_core_submit_pt_bypass(core, io)) {
+		return NULL;
+	}
+
+	if (ocf_core_split_io(core, io, req_cache_mode))
+		return NULL;
+
+	core_io->req = ocf_core_io_req_new(io, core, false);
 	if (!core_io->req) {
-		dec_counter_if_req_was_dirty(core_io, cache);
+		dec_io_counters(io, cache);
 		io->end(io, -ENOMEM);
-		return;
+		return NULL;
 	}
 
 	if (core_io->req->d2c)
@@ -269,23 +680,318 @@ void ocf_core_submit_io_mode(struct ocf_io *io, ocf_cache_mode_t cache_mode)
 	core_io->req->data = core_io->data;
 	core_io->req->complete = ocf_req_complete;
 	core_io->req->io = io;
+	core_io->batch_mode = req_cache_mode;
+
+	if (cache->cleaner.throttle.target_us)
+		core_io->req->submit_ticks = env_get_tick_count();
 
 	ocf_seq_cutoff_update(core, core_io->req);
 
+	ocf_core_mrc_update(core, core_io->req);
+
 	ocf_core_update_stats(core, io);
 
 	if (io->dir == OCF_WRITE)
-		ocf_trace_io(core_io, ocf_event_operation_wr, cache);
+		ocf_trace_io(io, ocf_event_operation_wr, cache);
 	else if (io->dir == OCF_READ)
-		ocf_trace_io(core_io, ocf_event_operation_rd, cache);
+		ocf_trace_io(io, ocf_event_operation_rd, cache);
 
 	ocf_io_get(io);
-	ret = ocf_engine_hndl_req(core_io->req, req_cache_mode);
+	ret = ocf_engine_prepare_req(core_io->req, req_cache_mode);
 	if (ret) {
-		dec_counter_if_req_was_dirty(core_io, cache);
+		dec_io_counters(io, cache);
 		ocf_req_put(core_io->req);
 		io->end(io, ret);
+		return NULL;
+	}
+
+	return core_io->req;
+}
+
+void ocf_core_submit_io_mode(struct ocf_io *io, ocf_cache_mode_t cache_mode)
+{
+	struct ocf_request *req;
+
+	/* Till OCF engine is not synchronous fully need to push OCF request
+	 * to into OCF workers
+	 */
+	req = ocf_core_prepare_req(io, cache_mode, NULL);
+	if (req)
+		ocf_engine_push_req_back(req, true);
+}
+
+static void ocf_core_write_combine_complete(struct ocf_request *req,
+		int error)
+{
+	struct ocf_core_write_combine *combine =
+			ocf_io_to_core_io(req->io)->combine;
+	struct ocf_io *io;
+	uint32_t i;
+
+	if (req->submit_ticks)
+		ocf_cleaner_throttle_io_done(req->cache, req->submit_ticks);
+
+	ocf_core_stats_latency_update(req);
+
+	for (i = 0; i < combine->count; i++) {
+		io = combine->ios[i];
+
+		ocf_trace_io_cmpl(io, req->cache);
+
+		ocf_io_end(io, error);
+
+		dec_io_counters(io, req->cache);
+
+		ocf_io_put(io);
+	}
+
+	ctx_data_free(req->cache->owner, combine->data);
+	env_free(combine);
+
+	req->data = NULL;
+	req->io = NULL;
+}
+
+/* Check if IO may be combined with write request of preceding IOs */
+static bool ocf_core_write_combinable(struct ocf_io *prev, struct ocf_io *io,
+		uint32_t count, uint32_t bytes, struct ocf_core_batch *batch)
+{
+	ocf_core_t core;
+	ocf_cache_t cache;
+
+	if (count >= OCF_CORE_WRITE_COMBINE_MAX_IOS)
+		return false;
+
+	if (ocf_core_validate_io(io) || io->dir != OCF_WRITE)
+		return false;
+
+	if (bytes + io->bytes > OCF_CORE_WRITE_COMBINE_MAX_BYTES)
+		return false;
+
+	core = ocf_volume_to_core(io->volume);
+	ocf_core_pin_io(core, io);
+
+	if (prev) {
+		if (io->volume != prev->volume ||
+				io->io_queue != prev->io_queue ||
+				io->io_class != prev->io_class ||
+				io->flags != prev->flags ||
+				io->addr != prev->addr + prev->bytes) {
+			return false;
+		}
+	}
+
+	if (!core->write_combine)
+		return false;
+
+	cache = ocf_core_get_cache(core);
+
+	return ocf_core_get_io_cache_mode(cache, core, io, batch) ==
+			ocf_cache_mode_wb;
+}
+
+/*
+ * Allocate single write-back request of contiguous IOs, ready to be pushed
+ * to I/O queue. Returns NULL if IOs have to be submitted separately.
+ */
+static struct ocf_request *ocf_core_prepare_combined_req(struct ocf_io **ios,
+		uint32_t count, uint32_t bytes)
+{
+	struct ocf_core_write_combine *combine;
+	struct ocf_io *io = ios[0];
+	ocf_core_t core = ocf_volume_to_core(io->volume);
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	struct ocf_core_io *core_io;
+	struct ocf_request *req;
+	uint32_t i, offset;
+
+	if (unlikely(!env_bit_test(ocf_cache_state_running,
+					&cache->cache_state))) {
+		return NULL;
 	}
+
+	combine = env_malloc(sizeof(*combine), ENV_MEM_NOIO);
+	if (!combine)
+		return NULL;
+
+	combine->data = ctx_data_alloc(cache->owner, BYTES_TO_PAGES(bytes));
+	if (!combine->data)
+		goto err_data;
+
+	req = ocf_req_new(io->io_queue, core, io->addr, bytes, OCF_WRITE);
+	if (!req)
+		goto err_req;
+
+	if (req->d2c)
+		goto err_mode;
+
+	for (i = 0; i < count; i++) {
+		if (!ocf_checkpoint_try_get_io(cache, ios[i]))
+			goto err_dirty;
+		if (ocf_io_set_dirty(cache, ios[i])) {
+			dec_io_counters(ios[i], cache);
+			goto err_dirty;
+		}
+	}
+
+	for (i = 0, offset = 0; i < count; i++) {
+		io = ios[i];
+		core_io = ocf_io_to_core_io(io);
+
+		ctx_data_cpy(cache->owner, combine->data, core_io->data,
+				offset, 0, io->bytes);
+		offset += io->bytes;
+
+		core_io->req = req;
+
+		ocf_core_update_stats(core, io);
+		ocf_trace_io(io, ocf_event_operation_wr, cache);
+
+		ocf_io_get(io);
+		combine->ios[i] = io;
+	}
+
+	combine->count = count;
+	ocf_io_to_core_io(ios[0])->combine = combine;
+
+	req->part_id = ocf_part_class2id(cache, ios[0]->io_class);
+	req->data = combine->data;
+	req->complete = ocf_core_write_combine_complete;
+	req->io = ios[0];
+	ocf_io_to_core_io(ios[0])->batch_mode = ocf_req_cache_mode_wb;
+
+	if (cache->cleaner.throttle.target_us)
+		req->submit_ticks = env_get_tick_count();
+
+	ocf_seq_cutoff_update(core, req);
+
+	ocf_core_mrc_update(core, req);
+
+	ENV_BUG_ON(ocf_engine_prepare_req(req, ocf_req_cache_mode_wb));
+
+	return req;
+
+err_dirty:
+	while (i--)
+		dec_io_counters(ios[i], cache);
+err_mode:
+	ocf_req_put(req);
+err_req:
+	ctx_data_free(cache->owner, combine->data);
+err_data:
+	env_free(combine);
+	return NULL;
+}
+
+/* Get number of IOs combined by next write request, 1 if none */
+static uint32_t ocf_core_write_combine_count(struct ocf_io **ios,
+		uint32_t count, uint32_t *bytes, struct ocf_core_batch *batch)
+{
+	uint32_t i;
+
+	*bytes = 0;
+
+	for (i = 0; i < count; i++) {
+		if (!ocf_core_write_combinable(i ? ios[i - 1] : NULL, ios[i],
+				i, *bytes, batch)) {
+			break;
+		}
+
+		*bytes += ios[i]->bytes;
+	}
+
+	return OCF_MAX(i, 1U);
+}
+
+/*
+ * Look up requests of batch in fast path, with global metadata lock of cache
+ * taken once for all of them, and start the ones found once it's released.
+ * Requests which need slow path are left on the list.
+ */
+static void ocf_core_submit_batch_fast(struct list_head *reqs)
+{
+	struct ocf_request *req, *tmp;
+	struct list_head started, *prev;
+	ocf_cache_t cache = NULL;
+	bool start;
+	int ret;
+
+	INIT_LIST_HEAD(&started);
+
+	list_for_each_entry_safe(req, tmp, reqs, list) {
+		if (req->cache != cache) {
+			if (cache)
+				ocf_metadata_unlock(cache, OCF_METADATA_RD);
+			cache = req->cache;
+			ocf_metadata_lock(cache, OCF_METADATA_RD);
+		}
+
+		/* Request waiting for cache line locks is pushed to I/O queue
+		 * once they are granted, so it is taken off the list first
+		 */
+		prev = req->list.prev;
+		list_del(&req->list);
+
+		ret = ocf_engine_fast_lookup(req,
+				ocf_io_to_core_io(req->io)->batch_mode, &start);
+		if (ret == OCF_FAST_PATH_NO)
+			list_add(&req->list, prev);
+		else if (start)
+			list_add_tail(&req->list, &started);
+	}
+
+	if (cache)
+		ocf_metadata_unlock(cache, OCF_METADATA_RD);
+
+	list_for_each_entry_safe(req, tmp, &started, list) {
+		list_del(&req->list);
+		ocf_engine_fast_start(req);
+	}
+}
+
+void ocf_core_submit_io_batch(struct ocf_io **ios, uint32_t count)
+{
+	struct ocf_core_batch batch = { .core = NULL };
+	struct ocf_request *req;
+	struct list_head reqs, run;
+	ocf_queue_t queue = NULL;
+	uint32_t i, n, bytes;
+
+	OCF_CHECK_NULL(ios);
+
+	INIT_LIST_HEAD(&reqs);
+	INIT_LIST_HEAD(&run);
+
+	for (i = 0; i < count; i += n) {
+		n = ocf_core_write_combine_count(ios + i, count - i, &bytes,
+				&batch);
+
+		req = n > 1 ? ocf_core_prepare_combined_req(ios + i, n, bytes) :
+				NULL;
+		if (!req) {
+			/* Submit IOs separately */
+			n = 1;
+			req = ocf_core_prepare_req(ios[i], ocf_cache_mode_none,
+					&batch);
+		}
+		if (req)
+			list_add_tail(&req->list, &reqs);
+	}
+
+	ocf_core_submit_batch_fast(&reqs);
+
+	/* Requests are pushed together, per run of the same queue */
+	while (!list_empty(&reqs)) {
+		req = list_first_entry(&reqs, struct ocf_request, list);
+		if (queue && queue != req->io_queue)
+			ocf_engine_push_reqs_back(queue, &run);
+
+		queue = req->io_queue;
+		list_move_tail(&req->list, &run);
+	}
+
+	if (queue)
+		ocf_engine_push_reqs_back(queue, &run);
 }
 
 int ocf_core_submit_io_fast(struct ocf_io *io)
@@ -296,6 +1002,7 @@ int ocf_core_submit_io_fast(struct ocf_io *io)
 	struct ocf_request *req;
 	ocf_core_t core;
 	ocf_cache_t cache;
+	bool traced;
 	int fast;
 	int ret;
 
@@ -310,46 +1017,63 @@ int ocf_core_submit_io_fast(struct ocf_io *io)
 	core = ocf_volume_to_core(io->volume);
 	cache = ocf_core_get_cache(core);
 
+	ocf_core_pin_io(core, io);
+
 	if (unlikely(!env_bit_test(ocf_cache_state_running,
 			&cache->cache_state))) {
 		ocf_io_end(io, -EIO);
 		return 0;
 	}
 
+	/* IO held until metadata checkpoint is invalidated goes slow path */
+	if (!ocf_checkpoint_try_get_io(cache, io))
+		return -EIO;
+
 	req_cache_mode = ocf_get_effective_cache_mode(cache, core, io);
 	if (req_cache_mode == ocf_req_cache_mode_wb &&
-			ocf_io_set_dirty(cache, core_io)) {
+			ocf_io_set_dirty(cache, io)) {
 		req_cache_mode = ocf_req_cache_mode_wt;
 	}
 
 	switch (req_cache_mode) {
 	case ocf_req_cache_mode_pt:
+		dec_io_counters(io, cache);
 		return -EIO;
 	case ocf_req_cache_mode_wb:
 		req_cache_mode = ocf_req_cache_mode_fast;
 		break;
+	case ocf_req_cache_mode_wt:
+		if (cache->use_submit_io_fast)
+			break;
+
+		/* Writes to mapped cache lines go to both devices directly */
+		req_cache_mode = io->dir == OCF_WRITE ?
+				ocf_req_cache_mode_fast_wt :
+				ocf_req_cache_mode_fast;
+		break;
 	default:
 		if (cache->use_submit_io_fast)
 			break;
-		if (io->dir == OCF_WRITE)
+		if (io->dir == OCF_WRITE) {
+			dec_io_counters(io, cache);
 			return -EIO;
+		}
 
 		req_cache_mode = ocf_req_cache_mode_fast;
 	}
 
-	core_io->req = ocf_req_new_extended(io->io_queue, core,
-			io->addr, io->bytes, io->dir);
+	core_io->req = ocf_core_io_req_new(io, core, true);
 	// We need additional pointer to req in case completion arrives before
 	// we leave this function and core_io is freed
 	req = core_io->req;
 
 	if (!req) {
-		dec_counter_if_req_was_dirty(core_io, cache);
+		dec_io_counters(io, cache);
 		io->end(io, -ENOMEM);
 		return 0;
 	}
 	if (req->d2c) {
-		dec_counter_if_req_was_dirty(core_io, cache);
+		dec_io_counters(io, cache);
 		ocf_req_put(req);
 		return -EIO;
 	}
@@ -359,25 +1083,35 @@ int ocf_core_submit_io_fast(struct ocf_io *io)
 	req->complete = ocf_req_complete;
 	req->io = io;
 
+	if (cache->cleaner.throttle.target_us)
+		req->submit_ticks = env_get_tick_count();
+
 	ocf_core_update_stats(core, io);
 
-	if (cache->trace.trace_callback) {
-		if (io->dir == OCF_WRITE)
-			ocf_trace_prep_io_event(&trace_event, core_io, ocf_event_operation_wr);
-		else if (io->dir == OCF_READ)
-			ocf_trace_prep_io_event(&trace_event, core_io, ocf_event_operation_rd);
+	/* Event is pushed once request is known to be handled in fast path,
+	 * but IO has to be tagged before it may complete
+	 */
+	traced = ocf_trace_enabled(cache);
+	if (traced) {
+		ocf_trace_prep_io_event(&trace_event, io, io->dir == OCF_WRITE ?
+				ocf_event_operation_wr :
+				ocf_event_operation_rd);
 	}
 
 	ocf_io_get(io);
 
 	fast = ocf_engine_hndl_fast_req(req, req_cache_mode);
 	if (fast != OCF_FAST_PATH_NO) {
-		ocf_trace_push(io->io_queue, &trace_event, sizeof(trace_event));
+		if (traced) {
+			ocf_trace_push(io->io_queue, &trace_event,
+					sizeof(trace_event));
+		}
 		ocf_seq_cutoff_update(core, req);
+		ocf_core_mrc_update(core, req);
 		return 0;
 	}
 
-	dec_counter_if_req_was_dirty(core_io, cache);
+	dec_io_counters(io, cache);
 
 	ocf_io_put(io);
 	ocf_req_put(req);
@@ -426,7 +1160,7 @@ static void ocf_core_volume_submit_flush(struct ocf_io *io)
 	core_io->req->io = io;
 	core_io->req->data = core_io->data;
 
-	ocf_trace_io(core_io, ocf_event_operation_flush, cache);
+	ocf_trace_io(io, ocf_event_operation_flush, cache);
 	ocf_io_get(io);
 	ocf_engine_hndl_ops_req(core_io->req);
 }
@@ -457,9 +1191,13 @@ static void ocf_core_volume_submit_discard(struct ocf_io *io)
 		return;
 	}
 
+	if (!ocf_checkpoint_get_io(cache, io, ocf_core_volume_submit_discard))
+		return;
+
 	core_io->req = ocf_req_new_discard(io->io_queue, core,
 			io->addr, io->bytes, OCF_WRITE);
 	if (!core_io->req) {
+		dec_io_counters(io, cache);
 		ocf_io_end(io, -ENOMEM);
 		return;
 	}
@@ -468,7 +1206,7 @@ static void ocf_core_volume_submit_discard(struct ocf_io *io)
 	core_io->req->io = io;
 	core_io->req->data = core_io->data;
 
-	ocf_trace_io(core_io, ocf_event_operation_discard, cache);
+	ocf_trace_io(io, ocf_event_operation_discard, cache);
 	ocf_io_get(io);
 	ocf_engine_hndl_discard_req(core_io->req);
 }
@@ -533,9 +1271,17 @@ static ctx_data_t *ocf_core_io_get_data(struct ocf_io *io)
 	return core_io->data;
 }
 
+#if OCF_CONFIG_CORE_IO_EMBEDDED_LINES
+#define OCF_CORE_IO_EMBEDDED_REQ_SIZE \
+	OCF_REQ_EMBEDDED_SIZE(OCF_CONFIG_CORE_IO_EMBEDDED_LINES)
+#else
+#define OCF_CORE_IO_EMBEDDED_REQ_SIZE 0
+#endif
+
 const struct ocf_volume_properties ocf_core_volume_properties = {
 	.name = "OCF Core",
-	.io_priv_size = sizeof(struct ocf_core_io),
+	.io_priv_size = sizeof(struct ocf_core_io) +
+			OCF_CORE_IO_EMBEDDED_REQ_SIZE,
 	.volume_priv_size = sizeof(struct ocf_core_volume),
 	.caps = {
 		.atomic_writes = 0,
@@ -10,6 +10,9 @@
 #include "ocf_env.h"
 #include "ocf_ctx_priv.h"
 #include "ocf_volume_priv.h"
+#include "ocf_queue_priv.h"
+#include "ocf_stats_priv.h"
+#include "engine/cache_engine.h"
 
 #define ocf_core_log_prefix(core, lvl, prefix, fmt, ...) \
 	ocf_cache_log_prefix(ocf_core_get_cache(core), lvl, ".%s" prefix, \
@@ -18,6 +21,19 @@
 #define ocf_core_log(core, lvl, fmt, ...) \
 	ocf_core_log_prefix(core, lvl, ": ", fmt, ##__VA_ARGS__)
 
+/* Limits of IOs combined into single write request */
+#define OCF_CORE_WRITE_COMBINE_MAX_IOS		32
+#define OCF_CORE_WRITE_COMBINE_MAX_BYTES	(128 * KiB)
+
+struct ocf_core_write_combine {
+	ctx_data_t *data;
+	/*!< Data of all combined IOs, owned by request */
+
+	uint32_t count;
+
+	struct ocf_io *ios[OCF_CORE_WRITE_COMBINE_MAX_IOS];
+};
+
 struct ocf_core_io {
 	bool dirty;
 	/*!< Indicates if io leaves dirty data  */
@@ -25,11 +41,184 @@ struct ocf_core_io {
 	struct ocf_request *req;
 	ctx_data_t *data;
 
+	struct ocf_core_write_combine *combine;
+	/*!< Set in first IO of combined write request */
+
+	env_atomic split_remaining;
+	/*!< Requests of split IO left to be completed */
+
+	env_atomic split_error;
+	/*!< First error of requests of split IO */
+
 	log_sid_t sid;
 	/*!< Sequence ID */
 
 	uint64_t timestamp;
 	/*!< Timestamp */
+
+	ocf_req_cache_mode_t batch_mode;
+	/*!< Cache mode request of io submitted in batch was prepared for */
+
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0
+	bool checkpoint;
+	/*!< Indicates if io holds metadata checkpoint reference */
+
+	struct list_head held;
+	/*!< Entry of IOs held until metadata checkpoint is invalidated */
+
+	void (*resume)(struct ocf_io *io);
+	/*!< Submission function of held io */
+
+	ocf_cache_mode_t cache_mode;
+	/*!< Cache mode io was submitted with */
+#endif
+
+#if OCF_CONFIG_CORE_IO_EMBEDDED_LINES
+	uint64_t req_mem[];
+	/*!< Memory of request embedded in IO */
+#endif
+};
+
+struct ocf_core_volume {
+	ocf_core_t core;
+};
+
+static inline struct ocf_core_io *ocf_io_to_core_io(struct ocf_io *io)
+{
+	return ocf_io_get_priv(io);
+}
+
+static inline ocf_core_t ocf_volume_to_core(ocf_volume_t volume)
+{
+	struct ocf_core_volume *core_volume = ocf_volume_get_priv(volume);
+
+	return core_volume->core;
+}
+
+/* Number of sequential cutoff stream table shards, selected by I/O queue */
+#define OCF_SEQ_CUTOFF_SHARDS 4
+
+/* Number of sequential streams tracked by each shard */
+#define OCF_SEQ_CUTOFF_SHARD_STREAMS 4
+
+struct ocf_seq_cutoff_stream {
+	uint64_t last;
+	/*!< Byte position following last I/O of the stream */
+
+	uint64_t bytes;
+	/*!< Number of bytes accessed sequentially */
+
+	uint64_t prefetch;
+	/*!< Byte position up to which stream was read ahead */
+
+	uint32_t stamp;
+	/*!< Last access stamp, least recently used stream is replaced */
+
+	int rw;
+	/*!< Direction of the stream */
+};
+
+struct ocf_seq_cutoff_shard {
+	env_spinlock lock;
+
+	uint32_t stamp;
+
+	struct ocf_seq_cutoff_stream streams[OCF_SEQ_CUTOFF_SHARD_STREAMS];
+} __attribute__((aligned(64)));
+
+/*
+ * Write-back limits of core volume honoured by cleaner. Cleaning requests
+ * which would exceed allowed number of in-flight core writes wait on the
+ * list and are resumed as core writes complete.
+ */
+struct ocf_core_writeback {
+	env_spinlock lock;
+
+	struct list_head waiters;
+
+	env_atomic inflight;
+
+	/* Maximum number of in-flight cleaner writes, 0 means no limit */
+	uint32_t max_inflight;
+
+	/* Maximum size of cleaner write in bytes, 0 means volume limit */
+	uint32_t max_io_size;
+};
+
+/*
+ * Index of core lines mapped to cache lines, kept for each core of attached
+ * cache. It holds bit per core line and number of mapped lines of each
+ * segment, so that range operations visit mapped lines in core line order,
+ * skipping unmapped segments, instead of scanning the whole collision table
+ * or looking up each core line of the range.
+ */
+struct ocf_core_line_index {
+	unsigned long *map;
+		/*!< Bit per core line, set when core line is mapped */
+
+	env_atomic *segments;
+		/*!< Number of mapped core lines of each segment */
+
+	uint64_t lines;
+		/*!< Number of core lines covered by index */
+
+	bool overflow;
+		/*!< Core line beyond index was mapped, index is not used */
+};
+
+/*
+ * Pinned ranges of core, read lock-free on submission. Ranges are set in
+ * map which is not current one and published by version bump.
+ */
+struct ocf_core_pinned_map {
+	uint32_t count;
+	struct ocf_mngt_core_pinned_range ranges[OCF_CORE_PINNED_RANGES_MAX];
+};
+
+struct ocf_core_pinned {
+	struct ocf_core_pinned_map maps[2];
+	env_atomic version;
+};
+
+/*
+ * Flushes of core are aggregated - flush arriving while flush of the core is
+ * in progress waits for it and is issued together with all flushes which
+ * arrived in the meantime.
+ */
+struct ocf_core_flush_group {
+	env_spinlock lock;
+
+	bool inflight;
+	/*!< Flush of cache and core volume is in progress */
+
+	struct list_head members;
+	/*!< Requests completed by flush in progress, except its own one */
+
+	struct list_head pending;
+	/*!< Requests waiting for next flush */
+
+	uint64_t gen;
+	/*!< Cache writes generation at start of flush in progress */
+};
+
+/*
+ * Cache mode advisor of core. Counters of previous interval and picked mode
+ * are updated only by interval close, advised mode is read by IO path.
+ */
+struct ocf_core_mode_advisor {
+	ocf_mode_advisor_t policy;
+
+	uint32_t allowed_modes;
+	/*!< Bit mask of cache modes which may be advised */
+
+	env_atomic mode;
+	/*!< Advised cache mode, ocf_cache_mode_none until picked */
+
+	ocf_cache_mode_t pick;
+	/*!< Mode picked in last interval */
+
+	uint64_t reads, read_hits, writes, write_hits;
+	/*!< Request counters at start of interval */
 };
 
 struct ocf_core {
@@ -38,22 +227,78 @@ struct ocf_core {
 	struct ocf_volume front_volume;
 	struct ocf_volume volume;
 
+	struct ocf_seq_cutoff_shard seq_cutoff[OCF_SEQ_CUTOFF_SHARDS];
+
+	struct ocf_core_flush_group flush_group;
+
+	struct ocf_core_writeback writeback;
+
+	/* Stream position of interrupted flush, next flush resumes from it */
 	struct {
-		uint64_t last;
-		uint64_t bytes;
-		int rw;
-	} seq_cutoff;
+		uint64_t position;
+		bool indexed;
+		bool valid;
+	} flush_cursor;
 
 	env_atomic flushed;
 
+	/* Moving average of read latency in ns - cost of refetching line */
+	env_atomic64 read_latency;
+
+	/* Number of cache lines read ahead of sequential read stream */
+	uint32_t prefetch_lines;
+
+	/* Combine contiguous write-back writes submitted in batch */
+	bool write_combine;
+
+	/* Policy of core served as lower tier of another cache */
+	ocf_tier_policy_t tier_policy;
+
+	/* Cache mode advised from IO statistics */
+	struct ocf_core_mode_advisor mode_advisor;
+
+	/* Miss ratio curve estimator, allocated when enabled first time */
+	struct ocf_mrc *mrc;
+	bool mrc_enabled;
+
+	/* Pinned ranges, allocated when set first time */
+	struct ocf_core_pinned *pinned;
+
+	/* Mapped core lines, maintained while cache is attached */
+	struct ocf_core_line_index line_index;
+
 	/* This bit means that object is open*/
 	uint32_t opened : 1;
 
+	/* Statistics counters, OCF_STATS_SHARDS copies */
 	struct ocf_counters_core *counters;
 };
 
+/* Statistics counters shard of core updated on given I/O queue */
+static inline struct ocf_counters_core *ocf_core_stats(ocf_core_t core,
+		ocf_queue_t queue)
+{
+	return &core->counters[queue->id % OCF_STATS_SHARDS];
+}
+
+/* Statistics counters shard of request core */
+#define ocf_req_core_stats(req) \
+	ocf_core_stats(&(req)->cache->core[(req)->core_id], (req)->io_queue)
+
 bool ocf_core_is_valid(ocf_cache_t cache, ocf_core_id_t id);
 
+/* Lines read through core are moved to upper cache tier */
+static inline bool ocf_core_tier_exclusive(ocf_core_t core)
+{
+	return core->tier_policy == ocf_tier_exclusive;
+}
+
+/* Free miss ratio curve estimator of removed core */
+void ocf_core_mrc_deinit(ocf_core_t core);
+
+/* Free pinned ranges of removed core */
+void ocf_core_pinned_deinit(ocf_core_t core);
+
 int ocf_core_volume_type_init(ocf_ctx_t ctx);
 
 void ocf_core_volume_type_deinit(ocf_ctx_t ctx);
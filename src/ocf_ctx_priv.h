@@ -12,6 +12,9 @@
 
 #define OCF_VOLUME_TYPE_MAX 8
 
+/* Number of buckets of core pool hash index */
+#define OCF_CORE_POOL_HASH_SIZE 1024
+
 /**
  * @brief OCF main control structure
  */
@@ -25,11 +28,14 @@ struct ocf_ctx {
 	struct {
 		struct list_head core_pool_head;
 		int core_pool_count;
+		/* Pooled volumes hashed on uuid */
+		struct list_head core_pool_hash[OCF_CORE_POOL_HASH_SIZE];
 	} core_pool;
 
 	struct {
 		struct ocf_req_allocator *req;
 		env_allocator *core_io_allocator;
+		struct ocf_data_pool *data_pool;
 	} resources;
 };
 
@@ -136,6 +142,12 @@ static inline void ctx_data_secure_erase(ocf_ctx_t ctx, ctx_data_t *dst)
 	return ctx->ops->data.secure_erase(dst);
 }
 
+static inline bool ctx_data_is_zero(ocf_ctx_t ctx, ctx_data_t *src,
+		uint64_t from, uint64_t bytes)
+{
+	return ctx->ops->data.is_zero(src, from, bytes);
+}
+
 static inline int ctx_cleaner_init(ocf_ctx_t ctx, ocf_cleaner_t cleaner)
 {
 	return ctx->ops->cleaner.init(cleaner);
@@ -146,6 +158,12 @@ static inline void ctx_cleaner_stop(ocf_ctx_t ctx, ocf_cleaner_t cleaner)
 	ctx->ops->cleaner.stop(cleaner);
 }
 
+static inline void ctx_cleaner_kick(ocf_ctx_t ctx, ocf_cleaner_t cleaner)
+{
+	if (ctx->ops->cleaner.kick)
+		ctx->ops->cleaner.kick(cleaner);
+}
+
 static inline int ctx_metadata_updater_init(ocf_ctx_t ctx,
 		ocf_metadata_updater_t mu)
 {
@@ -36,8 +36,36 @@
 		__x < __y ? __x : __y;		\
 	})
 
-#define METADATA_VERSION() ((OCF_VERSION_MAIN << 16) + \
-		(OCF_VERSION_MAJOR << 8) + OCF_VERSION_MINOR)
+/* Version of metadata hash function and hash table sizing */
+#define METADATA_HASH_VERSION 1
+
+/* Version of superblock and cache line metadata layout, bumped whenever
+ * field is added to or changed in either of them */
+#define METADATA_LAYOUT_VERSION 5
+
+/* Checksum algorithm, compact format, zero lines, hash function, cleaning
+ * metadata size, metadata layout, cache line metadata without partition
+ * links and LRU generation stamps of eviction metadata and partition runtime
+ * are part of metadata version, so that metadata checksummed with the other
+ * algorithm, in the other format, hashed the other way or laid out
+ * differently is not loaded. Main version takes the low two bits of its
+ * nibble only, to make room for layout options. */
+#define METADATA_VERSION() (((uint32_t)OCF_CONFIG_ZERO_LINES << 31) + \
+		((OCF_CONFIG_CLEANING_POLICIES ^ 0x7) << 28) + \
+		(METADATA_HASH_VERSION << 26) + \
+		(OCF_CONFIG_METADATA_COMPACT << 25) + \
+		(OCF_CONFIG_METADATA_CRC32C << 24) + \
+		(METADATA_LAYOUT_VERSION << 20) + \
+		(OCF_CONFIG_PARTITION_COUNTERS << 19) + \
+		((OCF_CONFIG_LRU_PROMOTION_WINDOW > 0) << 18) + \
+		((OCF_VERSION_MAIN & 0x3) << 16) + (OCF_VERSION_MAJOR << 8) + \
+		OCF_VERSION_MINOR)
+
+#if OCF_CONFIG_METADATA_CRC32C
+#define METADATA_CRC(crc, data, len) env_crc32c(crc, data, len)
+#else
+#define METADATA_CRC(crc, data, len) env_crc32(crc, data, len)
+#endif
 
 /* call conditional reschedule every 'iterations' calls */
 #define OCF_COND_RESCHED(cnt, iterations) \
@@ -6,6 +6,9 @@
 #include "ocf/ocf.h"
 #include "ocf_io_priv.h"
 #include "ocf_volume_priv.h"
+#include "ocf_cache_priv.h"
+#include "ocf_queue_priv.h"
+#include "utils/utils_io.h"
 
 /*
  * This is io allocator dedicated for bottom devices.
@@ -69,6 +72,11 @@ struct ocf_io *ocf_io_new(ocf_volume_t volume)
 	return io;
 }
 
+struct ocf_io *ocf_io_from_priv(void *priv)
+{
+	return priv - sizeof(struct ocf_io);
+}
+
 /*
  * IO external API
  */
@@ -95,3 +103,37 @@ void ocf_io_put(struct ocf_io *io)
 	env_allocator_del(io->volume->type->allocator,
 			(void *)io - sizeof(struct ocf_io_meta));
 }
+
+#if OCF_CONFIG_QUEUE_CMPL_STEERING
+bool ocf_io_steer_cmpl(struct ocf_io *io, int error)
+{
+	struct ocf_io_meta *io_meta = ocf_io_get_meta(io);
+	ocf_queue_t q = io->io_queue;
+
+	if (io_meta->cmpl_steered || !q)
+		return false;
+
+	io_meta->cmpl_steered = true;
+	io_meta->cmpl_error = error;
+
+	ocf_queue_push_cmpl(q, io_meta);
+
+	return true;
+}
+#endif
+
+void ocf_io_end_batch(struct ocf_io **ios, const int *errors, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; ) {
+		/* Runs are merged once IOs are completed on their queue */
+		if (ocf_io_steer_cmpl(ios[i], errors ? errors[i] : 0)) {
+			i++;
+			continue;
+		}
+
+		i += ocf_io_end_run(ios + i, errors ? errors + i : NULL,
+				count - i);
+	}
+}
@@ -38,6 +38,10 @@ int ocf_cache_io_class_get_info(ocf_cache_t cache, uint32_t io_class,
 			cache->user_parts[part_id].runtime->curr_size : 0;
 	info->min_size = cache->user_parts[part_id].config->min_size;
 	info->max_size = cache->user_parts[part_id].config->max_size;
+	info->ghost_hits = env_atomic_read(
+			&cache->user_parts[part_id].ghost_hits);
+	info->target_size = env_atomic_read(
+			&cache->user_parts[part_id].ghost_target);
 
 	info->eviction_policy_type = cache->conf_meta->eviction_policy_type;
 	info->cleaning_policy_type = cache->conf_meta->cleaning_policy_type;
@@ -12,6 +12,13 @@
 struct ocf_io_meta {
 	env_atomic ref_count;
 	struct ocf_request *req;
+#if OCF_CONFIG_QUEUE_CMPL_STEERING
+	/* Next completion on stack of I/O queue */
+	struct ocf_io_meta *cmpl_next;
+	/* Completion status saved until IO is completed on I/O queue */
+	int cmpl_error;
+	bool cmpl_steered;
+#endif
 };
 
 env_allocator *ocf_io_allocator_create(uint32_t size, const char *name);
@@ -20,6 +27,44 @@ void ocf_io_allocator_destroy(env_allocator *allocator);
 
 struct ocf_io *ocf_io_new(ocf_volume_t volume);
 
+void *ocf_io_get_meta(struct ocf_io *io);
+
+struct ocf_io *ocf_io_from_priv(void *priv);
+
+#if OCF_CONFIG_QUEUE_CMPL_STEERING
+/**
+ * @brief Hand IO completion over to I/O queue of IO
+ *
+ * @param io - Completed IO
+ * @param error - Completion status
+ *
+ * @retval true - IO will be completed again by queue runner
+ * @retval false - IO has to be completed by caller, as it was already
+ *	steered or it has no I/O queue
+ */
+bool ocf_io_steer_cmpl(struct ocf_io *io, int error);
+
+/**
+ * @brief Check if IO is being completed by queue runner after steering
+ */
+static inline bool ocf_io_cmpl_steered(struct ocf_io *io)
+{
+	struct ocf_io_meta *io_meta = ocf_io_get_meta(io);
+
+	return io_meta->cmpl_steered;
+}
+#else
+static inline bool ocf_io_steer_cmpl(struct ocf_io *io, int error)
+{
+	return false;
+}
+
+static inline bool ocf_io_cmpl_steered(struct ocf_io *io)
+{
+	return false;
+}
+#endif
+
 static inline void ocf_io_start(struct ocf_io *io)
 {
 	/*
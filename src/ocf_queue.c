@@ -7,28 +7,334 @@
 #include "ocf_priv.h"
 #include "ocf_queue_priv.h"
 #include "ocf_cache_priv.h"
+#include "ocf_io_priv.h"
 #include "ocf_ctx_priv.h"
 #include "ocf_request.h"
+#include "utils/utils_log.h"
+#include "utils/utils_req.h"
 #include "mngt/ocf_mngt_common.h"
 #include "engine/cache_engine.h"
 #include "ocf_def_priv.h"
+#include "ocf_trace_priv.h"
+#include "metadata/metadata.h"
 
 static void ocf_init_queue(ocf_queue_t q)
 {
 	env_atomic_set(&q->io_no, 0);
 	env_spinlock_init(&q->io_list_lock);
-	INIT_LIST_HEAD(&q->io_list);
+	INIT_LIST_HEAD(&q->io_list[OCF_QUEUE_PRIO_FG]);
+	INIT_LIST_HEAD(&q->io_list[OCF_QUEUE_PRIO_BG]);
+	q->fg_streak = 0;
 	env_atomic_set(&q->ref_count, 1);
+	env_atomic_set(&q->last_access_ms,
+			env_ticks_to_msecs(env_get_tick_count()));
+	env_atomic_set(&q->polling, 0);
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+	env_atomic64_set(&q->io_stack_back[OCF_QUEUE_PRIO_FG], 0);
+	env_atomic64_set(&q->io_stack_back[OCF_QUEUE_PRIO_BG], 0);
+	env_atomic64_set(&q->io_stack_front[OCF_QUEUE_PRIO_FG], 0);
+	env_atomic64_set(&q->io_stack_front[OCF_QUEUE_PRIO_BG], 0);
+#endif
+#if OCF_CONFIG_QUEUE_FREELIST_BATCH > 0
+	env_spinlock_init(&q->freelist_lock);
+#endif
+#if OCF_CONFIG_QUEUE_CMPL_STEERING
+	env_atomic64_set(&q->cmpl_stack, 0);
+#endif
+#if OCF_CONFIG_WI_PURGE_BATCH > 0
+	env_spinlock_init(&q->wi_purge_lock);
+	INIT_LIST_HEAD(&q->wi_purge_list);
+#endif
+#if OCF_CONFIG_LOG_RING > 0
+	env_spinlock_init(&q->log_lock);
+#endif
+#if OCF_CONFIG_QUEUE_REQ_CACHE > 0
+	{
+		int i;
+
+		env_spinlock_init(&q->req_cache_lock);
+		for (i = 0; i < OCF_QUEUE_REQ_CLASSES; i++)
+			INIT_LIST_HEAD(&q->req_cache[i]);
+	}
+#endif
 }
 
-int ocf_queue_create(ocf_cache_t cache, ocf_queue_t *queue,
-		const struct ocf_queue_ops *ops)
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+/*
+ * Lock-free queue keeps pushed requests of each priority class on two LIFO
+ * stacks linked through req->list.next. Consumer detaches whole stack at
+ * once, so there is no ABA problem, and moves detached requests to io_list
+ * of the class, which is private to the consumer.
+ */
+#define _STACK_PTR(req) ((long)(uintptr_t)(req))
+#define _STACK_REQ(val) ((struct ocf_request *)(uintptr_t)(val))
+
+static void _ocf_queue_stack_push(env_atomic64 *top, struct ocf_request *req)
+{
+	long old;
+
+	do {
+		old = env_atomic64_read(top);
+		req->list.next = old ? &_STACK_REQ(old)->list : NULL;
+	} while (env_atomic64_cmpxchg(top, old, _STACK_PTR(req)) != old);
+}
+
+static struct ocf_request *_ocf_queue_stack_detach(env_atomic64 *top)
+{
+	long old;
+
+	do {
+		old = env_atomic64_read(top);
+		if (!old)
+			return NULL;
+	} while (env_atomic64_cmpxchg(top, old, 0) != old);
+
+	return _STACK_REQ(old);
+}
+
+static inline struct ocf_request *_ocf_queue_stack_next(
+		struct ocf_request *req)
+{
+	return req->list.next ?
+		list_entry(req->list.next, struct ocf_request, list) : NULL;
+}
+
+void ocf_queue_push_req_lockless(ocf_queue_t q, struct ocf_request *req,
+		bool front)
+{
+	/* Account request before it is visible, so that queue runner doesn't
+	 * stop while request is being pushed
+	 */
+	int prio = ocf_req_is_background(req);
+
+	env_atomic_inc(&q->io_no);
+
+	_ocf_queue_stack_push(front ? &q->io_stack_front[prio] :
+			&q->io_stack_back[prio], req);
+}
+
+static void _ocf_queue_drain_stacks(ocf_queue_t q, int prio)
+{
+	struct list_head *list = &q->io_list[prio];
+	struct ocf_request *req, *next;
+	struct list_head *pos;
+
+	/* Newest front request goes first, as with list_add() */
+	req = _ocf_queue_stack_detach(&q->io_stack_front[prio]);
+	for (pos = list; req; req = next) {
+		next = _ocf_queue_stack_next(req);
+		list_add(&req->list, pos);
+		pos = &req->list;
+	}
+
+	if (list_empty(list)) {
+		/* Reverse back requests into FIFO order */
+		req = _ocf_queue_stack_detach(&q->io_stack_back[prio]);
+		for (; req; req = next) {
+			next = _ocf_queue_stack_next(req);
+			list_add(&req->list, list);
+		}
+	}
+}
+
+struct ocf_request *ocf_queue_pop_req_lockless(ocf_queue_t q)
+{
+	struct ocf_request *req;
+	struct list_head *list;
+
+	_ocf_queue_drain_stacks(q, OCF_QUEUE_PRIO_FG);
+	_ocf_queue_drain_stacks(q, OCF_QUEUE_PRIO_BG);
+
+	list = ocf_queue_pick_list(q);
+	if (!list)
+		return NULL;
+
+	req = list_first_entry(list, struct ocf_request, list);
+	list_del(&req->list);
+
+	env_atomic_dec(&q->io_no);
+
+	return req;
+}
+#endif
+
+#if OCF_CONFIG_QUEUE_CMPL_STEERING
+/* Number of steered IOs completed with single ocf_io_end_batch() call */
+#define OCF_QUEUE_CMPL_BATCH 32
+
+#define _CMPL_PTR(io_meta) ((long)(uintptr_t)(io_meta))
+#define _CMPL_META(val) ((struct ocf_io_meta *)(uintptr_t)(val))
+#define _CMPL_IO(io_meta) \
+	((struct ocf_io *)((void *)(io_meta) + sizeof(struct ocf_io_meta)))
+
+void ocf_queue_push_cmpl(ocf_queue_t q, struct ocf_io_meta *io_meta)
+{
+	long old;
+
+	/* Account completion before it is visible, as with requests */
+	env_atomic_inc(&q->io_no);
+
+	do {
+		old = env_atomic64_read(&q->cmpl_stack);
+		io_meta->cmpl_next = _CMPL_META(old);
+	} while (env_atomic64_cmpxchg(&q->cmpl_stack, old,
+			_CMPL_PTR(io_meta)) != old);
+
+	/* Completion has to run on the queue runner, never synchronously */
+	ocf_queue_kick(q, false);
+}
+
+/*
+ * Complete all IOs steered to the queue so far. Stack is detached at once
+ * and reversed, so that IOs are completed in order they were steered and
+ * runs of the same request meet in ocf_io_end_batch().
+ */
+static void ocf_queue_run_cmpls(ocf_queue_t q)
+{
+	struct ocf_io *ios[OCF_QUEUE_CMPL_BATCH];
+	int errors[OCF_QUEUE_CMPL_BATCH];
+	struct ocf_io_meta *io_meta, *next, *fifo = NULL;
+	uint32_t count = 0;
+	long old;
+
+	if (!env_atomic64_read(&q->cmpl_stack))
+		return;
+
+	do {
+		old = env_atomic64_read(&q->cmpl_stack);
+	} while (env_atomic64_cmpxchg(&q->cmpl_stack, old, 0) != old);
+
+	for (io_meta = _CMPL_META(old); io_meta; io_meta = next) {
+		next = io_meta->cmpl_next;
+		io_meta->cmpl_next = fifo;
+		fifo = io_meta;
+	}
+
+	for (io_meta = fifo; io_meta; io_meta = next) {
+		next = io_meta->cmpl_next;
+
+		ios[count] = _CMPL_IO(io_meta);
+		errors[count] = io_meta->cmpl_error;
+		env_atomic_dec(&q->io_no);
+
+		if (++count == OCF_QUEUE_CMPL_BATCH) {
+			ocf_io_end_batch(ios, errors, count);
+			count = 0;
+		}
+	}
+
+	if (count)
+		ocf_io_end_batch(ios, errors, count);
+}
+#else
+static inline void ocf_queue_run_cmpls(ocf_queue_t q)
+{
+}
+#endif
+
+#if OCF_CONFIG_QUEUE_FREELIST_BATCH > 0
+/* Caller has to hold metadata lock */
+static void _ocf_queue_freelist_drain(ocf_queue_t q)
+{
+	ocf_cache_t cache = q->cache;
+
+	env_spinlock_lock(&q->freelist_lock);
+	if (q->freelist_count) {
+		ocf_metadata_freelist_lock(cache);
+		while (q->freelist_count) {
+			ocf_metadata_add_to_free_list(cache,
+					q->freelist[--q->freelist_count]);
+		}
+		ocf_metadata_freelist_unlock(cache);
+	}
+	env_spinlock_unlock(&q->freelist_lock);
+}
+
+void ocf_queue_freelist_drain(ocf_queue_t q)
+{
+	ocf_cache_t cache = q->cache;
+
+	/* Queue caches cache lines only while cache device is attached, and
+	 * they are drained before it is unplugged
+	 */
+	if (!q->freelist_count)
+		return;
+
+	OCF_METADATA_LOCK_RD();
+	_ocf_queue_freelist_drain(q);
+	OCF_METADATA_UNLOCK_RD();
+}
+
+void ocf_queue_freelist_drain_all_locked(ocf_cache_t cache)
+{
+	ocf_queue_t q;
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+	list_for_each_entry(q, &cache->io_queues, list)
+		_ocf_queue_freelist_drain(q);
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+}
+
+void ocf_queue_freelist_drain_all(ocf_cache_t cache)
+{
+	OCF_METADATA_LOCK_WR();
+	ocf_queue_freelist_drain_all_locked(cache);
+	OCF_METADATA_UNLOCK_WR();
+}
+#endif
+
+uint32_t ocf_queue_get_idle_ms(ocf_cache_t cache)
+{
+	uint32_t now = env_ticks_to_msecs(env_get_tick_count());
+	uint32_t idle = ~0U;
+	ocf_queue_t queue;
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+	list_for_each_entry(queue, &cache->io_queues, list) {
+		idle = OCF_MIN(idle, now - (uint32_t)env_atomic_read(
+				&queue->last_access_ms));
+	}
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+
+	return idle;
+}
+
+uint32_t ocf_queue_get_io_queues(ocf_cache_t cache, ocf_queue_t *queues,
+		uint32_t max)
+{
+	ocf_queue_t queue;
+	uint32_t queues_no = 0;
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+	list_for_each_entry(queue, &cache->io_queues, list) {
+		if (queues_no == max)
+			break;
+
+		if (queue == cache->mngt_queue)
+			continue;
+
+		/* Queue may be already on its way to be freed */
+		if (env_atomic_add_unless(&queue->ref_count, 1, 0))
+			queues[queues_no++] = queue;
+	}
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+
+	if (!queues_no) {
+		ocf_queue_get(cache->mngt_queue);
+		queues[queues_no++] = cache->mngt_queue;
+	}
+
+	return queues_no;
+}
+
+int ocf_queue_create_node(ocf_cache_t cache, ocf_queue_t *queue,
+		const struct ocf_queue_ops *ops, int node)
 {
 	ocf_queue_t tmp_queue;
 
 	OCF_CHECK_NULL(cache);
 
-	tmp_queue = env_zalloc(sizeof(*tmp_queue), ENV_MEM_NORMAL);
+	tmp_queue = env_zalloc_node(sizeof(*tmp_queue), ENV_MEM_NORMAL, node);
 	if (!tmp_queue)
 		return -ENOMEM;
 
@@ -37,7 +343,99 @@ int ocf_queue_create(ocf_cache_t cache, ocf_queue_t *queue,
 
 	tmp_queue->ops = ops;
 
+	if (cache->trace.trace_ring && ocf_trace_ring_init(tmp_queue)) {
+		env_free(tmp_queue);
+		return -ENOMEM;
+	}
+
+	env_rwlock_write_lock(&cache->io_queues_lock);
+	tmp_queue->id = cache->io_queues_next_id++;
 	list_add(&tmp_queue->list, &cache->io_queues);
+	env_rwlock_write_unlock(&cache->io_queues_lock);
+
+	*queue = tmp_queue;
+
+	return 0;
+}
+
+int ocf_queue_create(ocf_cache_t cache, ocf_queue_t *queue,
+		const struct ocf_queue_ops *ops)
+{
+	return ocf_queue_create_node(cache, queue, ops, -1);
+}
+
+int ocf_queue_create_shared(ocf_ctx_t ctx, ocf_queue_t *queue,
+		const struct ocf_queue_ops *ops, int node)
+{
+	ocf_queue_t tmp_queue;
+
+	OCF_CHECK_NULL(ctx);
+
+	tmp_queue = env_zalloc_node(sizeof(*tmp_queue), ENV_MEM_NORMAL, node);
+	if (!tmp_queue)
+		return -ENOMEM;
+
+	ocf_init_queue(tmp_queue);
+	INIT_LIST_HEAD(&tmp_queue->shared.members);
+	env_spinlock_init(&tmp_queue->shared.lock);
+
+	tmp_queue->ops = ops;
+
+	*queue = tmp_queue;
+
+	return 0;
+}
+
+/* Member queue is kicked and stopped through its shared queue */
+static void _ocf_queue_member_kick(ocf_queue_t q)
+{
+	ocf_queue_kick(q->shared.owner, false);
+}
+
+static void _ocf_queue_member_kick_sync(ocf_queue_t q)
+{
+	ocf_queue_kick(q->shared.owner, true);
+}
+
+static void _ocf_queue_member_stop(ocf_queue_t q)
+{
+	ocf_queue_t owner = q->shared.owner;
+
+	env_spinlock_lock(&owner->shared.lock);
+	list_del(&q->shared.entry);
+	env_spinlock_unlock(&owner->shared.lock);
+
+	ocf_queue_put(owner);
+}
+
+static const struct ocf_queue_ops _ocf_queue_member_ops = {
+	.kick = _ocf_queue_member_kick,
+	.kick_sync = _ocf_queue_member_kick_sync,
+	.stop = _ocf_queue_member_stop,
+};
+
+int ocf_queue_create_on_shared(ocf_cache_t cache, ocf_queue_t *queue,
+		ocf_queue_t shared)
+{
+	ocf_queue_t tmp_queue;
+	int result;
+
+	OCF_CHECK_NULL(shared);
+
+	if (!ocf_queue_is_shared(shared))
+		return -OCF_ERR_INVAL;
+
+	result = ocf_queue_create_node(cache, &tmp_queue,
+			&_ocf_queue_member_ops, -1);
+	if (result)
+		return result;
+
+	ocf_queue_get(shared);
+	tmp_queue->shared.owner = shared;
+
+	env_spinlock_lock(&shared->shared.lock);
+	list_add_tail(&tmp_queue->shared.entry, &shared->shared.members);
+	env_spinlock_unlock(&shared->shared.lock);
 
 	*queue = tmp_queue;
 
@@ -56,8 +454,21 @@ void ocf_queue_put(ocf_queue_t queue)
 	OCF_CHECK_NULL(queue);
 
 	if (env_atomic_dec_return(&queue->ref_count) == 0) {
+		if (ocf_queue_is_shared(queue)) {
+			/* Members hold reference, so there are none left */
+			queue->ops->stop(queue);
+			env_free(queue);
+			return;
+		}
+
+		ocf_queue_freelist_drain(queue);
+		ocf_log_ring_flush(queue);
+		env_rwlock_write_lock(&queue->cache->io_queues_lock);
 		list_del(&queue->list);
+		env_rwlock_write_unlock(&queue->cache->io_queues_lock);
 		queue->ops->stop(queue);
+		ocf_req_cache_drain(queue);
+		ocf_trace_ring_deinit(queue);
 		env_free(queue);
 	}
 }
@@ -74,6 +485,81 @@ void ocf_io_handle(struct ocf_io *io, void *opaque)
 		req->io_if->read(req);
 }
 
+static void ocf_queue_handle_req(struct ocf_request *io_req)
+{
+	if (io_req->io && io_req->io->handle)
+		io_req->io->handle(io_req->io, io_req);
+	else
+		ocf_io_handle(io_req->io, io_req);
+}
+
+/* Number of requests of member processed in row by shared queue */
+#define OCF_QUEUE_SHARED_BATCH 16
+
+/*
+ * Take reference of the first member with pending requests and move it to
+ * the end of members list, so that members are served in round robin.
+ */
+static ocf_queue_t _ocf_queue_shared_next(ocf_queue_t q)
+{
+	ocf_queue_t member, found = NULL;
+
+	env_spinlock_lock(&q->shared.lock);
+	list_for_each_entry(member, &q->shared.members, shared.entry) {
+		/* Queue may be already on its way to be freed */
+		if (env_atomic_read(&member->io_no) > 0 &&
+				env_atomic_add_unless(&member->ref_count,
+						1, 0)) {
+			found = member;
+			break;
+		}
+	}
+
+	if (found)
+		list_move_tail(&found->shared.entry, &q->shared.members);
+	env_spinlock_unlock(&q->shared.lock);
+
+	return found;
+}
+
+static uint32_t _ocf_queue_pending(ocf_queue_t q)
+{
+	ocf_queue_t member;
+	uint32_t pending = 0;
+
+	if (!ocf_queue_is_shared(q))
+		return env_atomic_read(&q->io_no);
+
+	env_spinlock_lock(&q->shared.lock);
+	list_for_each_entry(member, &q->shared.members, shared.entry)
+		pending += env_atomic_read(&member->io_no);
+	env_spinlock_unlock(&q->shared.lock);
+
+	return pending;
+}
+
+static void ocf_queue_run_shared(ocf_queue_t q, uint32_t batch)
+{
+	unsigned char step = 0;
+	ocf_queue_t member;
+	uint32_t i;
+
+	/* Members are run unlocked, as request completion may put them */
+	while ((member = _ocf_queue_shared_next(q))) {
+		for (i = 0; i < batch && env_atomic_read(&member->io_no) > 0;
+				i++) {
+			ocf_queue_run_single(member);
+		}
+
+		ocf_queue_put(member);
+
+		if (batch == 1)
+			break;
+
+		OCF_COND_RESCHED(step, 8);
+	}
+}
+
 void ocf_queue_run_single(ocf_queue_t q)
 {
 	struct ocf_request *io_req = NULL;
@@ -81,17 +567,71 @@ void ocf_queue_run_single(ocf_queue_t q)
 
 	OCF_CHECK_NULL(q);
 
+	if (ocf_queue_is_shared(q)) {
+		ocf_queue_run_shared(q, 1);
+		return;
+	}
+
 	cache = q->cache;
 
+	ocf_queue_run_cmpls(q);
+
 	io_req = ocf_engine_pop_req(cache, q);
 
 	if (!io_req)
 		return;
 
-	if (io_req->io && io_req->io->handle)
-		io_req->io->handle(io_req->io, io_req);
-	else
-		ocf_io_handle(io_req->io, io_req);
+	ocf_queue_handle_req(io_req);
+}
+
+/*
+ * Take single request from the most loaded sibling queue and process it.
+ * Request keeps its io_queue, so it is resumed and completed on the queue
+ * it was submitted to. The last pending request of a queue is left for
+ * its owner.
+ */
+static bool ocf_queue_steal_single(ocf_queue_t q)
+{
+	ocf_cache_t cache = q->cache;
+	struct ocf_request *io_req = NULL;
+	ocf_queue_t sibling, victim = NULL;
+	int io_no, victim_io_no = 1;
+
+	if (q == cache->mngt_queue)
+		return false;
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+
+	list_for_each_entry(sibling, &cache->io_queues, list) {
+		if (sibling == q || sibling == cache->mngt_queue)
+			continue;
+
+		io_no = env_atomic_read(&sibling->io_no);
+		if (io_no > victim_io_no) {
+			victim = sibling;
+			victim_io_no = io_no;
+		}
+	}
+
+	/* Queue may be already on its way to be freed */
+	if (victim && !env_atomic_add_unless(&victim->ref_count, 1, 0))
+		victim = NULL;
+
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+
+	if (!victim)
+		return false;
+
+	/* Request may be completed when popping it, so do it unlocked */
+	io_req = ocf_engine_pop_req(cache, victim);
+	ocf_queue_put(victim);
+
+	if (!io_req)
+		return false;
+
+	ocf_queue_handle_req(io_req);
+
+	return true;
 }
 
 void ocf_queue_run(ocf_queue_t q)
@@ -100,13 +640,98 @@ void ocf_queue_run(ocf_queue_t q)
 
 	OCF_CHECK_NULL(q);
 
-	while (env_atomic_read(&q->io_no) > 0) {
-		ocf_queue_run_single(q);
+	if (ocf_queue_is_shared(q)) {
+		ocf_queue_run_shared(q, OCF_QUEUE_SHARED_BATCH);
+		return;
+	}
+
+	do {
+		while (env_atomic_read(&q->io_no) > 0) {
+			ocf_queue_run_single(q);
+
+			OCF_COND_RESCHED(step, 128);
+		}
+	} while (q->work_stealing && ocf_queue_steal_single(q));
+}
+
+/* Lower bound of adaptive busy-poll time */
+#define OCF_QUEUE_POLL_MIN_NS 1000
+
+/*
+ * Busy-poll time doubles each time request arrives while polling and halves
+ * each time polling ends with queue still empty, so that sparse load
+ * quickly falls back to sleeping.
+ */
+void ocf_queue_run_polled(ocf_queue_t q)
+{
+	uint64_t start;
+	bool found;
+
+	OCF_CHECK_NULL(q);
+
+	if (!q->poll_max_ns) {
+		ocf_queue_run(q);
+		return;
+	}
+
+	env_atomic_set(&q->polling, 1);
+
+	while (true) {
+		ocf_queue_run(q);
+
+		found = false;
+		start = env_get_tick_count();
+		do {
+			if (_ocf_queue_pending(q) > 0) {
+				found = true;
+				break;
+			}
+			env_cpu_relax();
+		} while (env_ticks_to_nsecs(env_get_tick_count() - start) <
+				q->poll_ns);
+
+		if (found) {
+			q->poll_ns = OCF_MIN(q->poll_ns * 2, q->poll_max_ns);
+			continue;
+		}
+
+		q->poll_ns = OCF_MAX(q->poll_ns / 2,
+				OCF_MIN(q->poll_max_ns, OCF_QUEUE_POLL_MIN_NS));
 
-		OCF_COND_RESCHED(step, 128);
+		/* Reenable kicks, then pick up request pushed meanwhile */
+		env_atomic_cmpxchg(&q->polling, 1, 0);
+		if (!_ocf_queue_pending(q))
+			break;
+
+		env_atomic_set(&q->polling, 1);
 	}
 }
 
+void ocf_queue_set_poll(ocf_queue_t q, uint32_t max_poll_us)
+{
+	OCF_CHECK_NULL(q);
+
+	q->poll_max_ns = (uint64_t)max_poll_us * 1000;
+	q->poll_ns = q->poll_max_ns;
+}
+
+int ocf_queue_set_work_stealing(ocf_queue_t q, bool enable)
+{
+	OCF_CHECK_NULL(q);
+
+	/* Lock-free queues allow single consumer only */
+	if (OCF_CONFIG_QUEUE_LOCKLESS && enable)
+		return -ENOTSUP;
+
+	/* Shared queue has no siblings, its members may steal instead */
+	if (ocf_queue_is_shared(q))
+		return -ENOTSUP;
+
+	q->work_stealing = enable;
+
+	return 0;
+}
+
 void ocf_queue_set_priv(ocf_queue_t q, void *priv)
 {
 	OCF_CHECK_NULL(q);
@@ -122,7 +747,7 @@ void *ocf_queue_get_priv(ocf_queue_t q)
 uint32_t ocf_queue_pending_io(ocf_queue_t q)
 {
 	OCF_CHECK_NULL(q);
-	return env_atomic_read(&q->io_no);
+	return _ocf_queue_pending(q);
 }
 
 ocf_cache_t ocf_queue_get_cache(ocf_queue_t q)
@@ -7,32 +7,301 @@
 #define OCF_QUEUE_PRIV_H_
 
 #include "ocf_env.h"
+#include "ocf/ocf_cfg.h"
+
+struct ocf_trace_ring;
+
+/* Message of I/O error path, logged with position of its first occurrence */
+struct ocf_log_ring_entry {
+	const char *msg;
+	uint64_t sector;
+	uint32_t bytes;
+	uint32_t count;
+	uint16_t core_id;
+};
+
+/* Number of request size classes, see ocf_req_size */
+#define OCF_QUEUE_REQ_CLASSES 8
+
+/* Priority classes of queued requests, see ocf_req_is_background */
+#define OCF_QUEUE_PRIO_FG 0
+#define OCF_QUEUE_PRIO_BG 1
+#define OCF_QUEUE_PRIO_CLASSES 2
 
 struct ocf_queue {
 	ocf_cache_t cache;
 
+	/* Sequence number of queue within cache */
+	uint32_t id;
+
 	env_atomic io_no;
 
 	env_atomic ref_count;
 
-	struct list_head io_list;
+	/* Time of last user request queued, in milliseconds. Kept per queue,
+	 * so that I/O path doesn't store to cache line shared by all queues.
+	 */
+	env_atomic last_access_ms;
+
+	/* Queued requests of each priority class */
+	struct list_head io_list[OCF_QUEUE_PRIO_CLASSES];
 	env_spinlock io_list_lock;
 
+	/* Foreground requests taken in row while background ones were
+	 * pending, protected the same way as io_list
+	 */
+	uint32_t fg_streak;
+
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+	/* Requests pushed to the back of the queue, LIFO stacks drained into
+	 * io_list by the queue consumer
+	 */
+	env_atomic64 io_stack_back[OCF_QUEUE_PRIO_CLASSES];
+
+	/* Requests pushed to the front of the queue, taken by the consumer
+	 * before io_list
+	 */
+	env_atomic64 io_stack_front[OCF_QUEUE_PRIO_CLASSES];
+#endif
+
+#if OCF_CONFIG_QUEUE_CMPL_STEERING
+	/* IO completions handed over to the queue, LIFO stack linked through
+	 * IO meta, accounted in io_no
+	 */
+	env_atomic64 cmpl_stack;
+#endif
+
+#if OCF_CONFIG_QUEUE_REQ_CACHE > 0
+	/* Freed requests kept for reuse, per request size class. Requests
+	 * may be freed in any context, so the lists are protected by lock
+	 * private to the queue.
+	 */
+	env_spinlock req_cache_lock;
+	struct list_head req_cache[OCF_QUEUE_REQ_CLASSES];
+	uint32_t req_cache_count[OCF_QUEUE_REQ_CLASSES];
+#endif
+
+#if OCF_CONFIG_WI_PURGE_BATCH > 0
+	/* Write-invalidate requests of clean cache lines waiting for purge
+	 * of their mapping by the batch leader, which is queued separately
+	 */
+	env_spinlock wi_purge_lock;
+	struct list_head wi_purge_list;
+	uint32_t wi_purge_count;
+	bool wi_purge_leader;
+#endif
+
+#if OCF_CONFIG_QUEUE_FREELIST_BATCH > 0
+	/* Free cache lines taken in batch from the cache free list for misses
+	 * mapped on this queue, protected by lock private to the queue
+	 */
+	env_spinlock freelist_lock;
+	ocf_cache_line_t freelist[OCF_CONFIG_QUEUE_FREELIST_BATCH];
+	uint32_t freelist_count;
+#endif
+
+#if OCF_CONFIG_LOG_SEGMENT_LINES > 0
+	/* Next and end physical cache line of log-structured allocation
+	 * segment of this queue, protected by free list lock
+	 */
+	struct {
+		ocf_cache_line_t next;
+		ocf_cache_line_t end;
+	} log_segment;
+#endif
+
+#if OCF_CONFIG_LOG_RING > 0
+	/* Messages of I/O error paths waiting to be logged, I/O may fail in
+	 * any context, so they are protected by lock private to the queue
+	 */
+	env_spinlock log_lock;
+	struct ocf_log_ring_entry log_ring[OCF_CONFIG_LOG_RING];
+	uint32_t log_count;
+	uint32_t log_dropped;
+#endif
+
 	/* Tracing reference counter */
 	env_atomic64 trace_ref_cntr;
 
 	/* Tracing stop request */
 	env_atomic trace_stop;
 
+	/* Ring of traced events drained by adapter, allocated once tracing
+	 * to rings is started
+	 */
+	struct ocf_trace_ring *trace_ring;
+
+	/* Sequence number of events traced on queue */
+	env_atomic64 trace_seq;
+
 	struct list_head list;
 
+	/* Process requests of sibling queues when this queue is empty */
+	bool work_stealing;
+
+	/* Context-level queue with no cache of its own serves I/O queues of
+	 * several caches, which forward their kicks to it
+	 */
+	struct {
+		/* I/O queues served, valid in shared queue */
+		struct list_head members;
+		env_spinlock lock;
+
+		/* Shared queue serving I/O queue, NULL if queue runs itself */
+		ocf_queue_t owner;
+
+		/* Entry on members list of owner */
+		struct list_head entry;
+	} shared;
+
+	/* Set while ocf_queue_run_polled() is polling queue, kicks are not
+	 * delivered then
+	 */
+	env_atomic polling;
+
+	/* Current and maximal busy-poll time */
+	uint64_t poll_ns;
+	uint64_t poll_max_ns;
+
 	const struct ocf_queue_ops *ops;
 
 	void *priv;
 };
 
+/*
+ * Pick list to take next request from - background one once per
+ * OCF_CONFIG_QUEUE_BG_WEIGHT foreground requests, or when there are no
+ * foreground requests. Returns NULL if queue is empty.
+ */
+static inline struct list_head *ocf_queue_pick_list(ocf_queue_t q)
+{
+	struct list_head *fg = &q->io_list[OCF_QUEUE_PRIO_FG];
+	struct list_head *bg = &q->io_list[OCF_QUEUE_PRIO_BG];
+
+	if (list_empty(bg)) {
+		q->fg_streak = 0;
+		return list_empty(fg) ? NULL : fg;
+	}
+
+	if (list_empty(fg) || q->fg_streak >= OCF_CONFIG_QUEUE_BG_WEIGHT) {
+		q->fg_streak = 0;
+		return bg;
+	}
+
+	q->fg_streak++;
+
+	return fg;
+}
+
+#if OCF_CONFIG_QUEUE_LOCKLESS == 1
+struct ocf_request;
+
+/**
+ * @brief Push request to lock-free queue
+ *
+ * @param q - I/O queue
+ * @param req - OCF request
+ * @param front - Insert request at the front of the queue
+ */
+void ocf_queue_push_req_lockless(ocf_queue_t q, struct ocf_request *req,
+		bool front);
+
+/**
+ * @brief Pop request from lock-free queue, single consumer only
+ *
+ * @param q - I/O queue
+ *
+ * @retval OCF request or NULL if queue is empty
+ */
+struct ocf_request *ocf_queue_pop_req_lockless(ocf_queue_t q);
+#endif
+
+#if OCF_CONFIG_QUEUE_CMPL_STEERING
+struct ocf_io_meta;
+
+/**
+ * @brief Push IO completion to be processed by queue runner and kick queue
+ *
+ * @param q - I/O queue
+ * @param io_meta - Meta of completed IO
+ */
+void ocf_queue_push_cmpl(ocf_queue_t q, struct ocf_io_meta *io_meta);
+#endif
+
+#if OCF_CONFIG_QUEUE_FREELIST_BATCH > 0
+/**
+ * @brief Return free cache lines held by queue to the cache free list
+ *
+ * @param q - I/O queue
+ */
+void ocf_queue_freelist_drain(ocf_queue_t q);
+
+/**
+ * @brief Return free cache lines held by all I/O queues of cache to the
+ *	cache free list
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_queue_freelist_drain_all(ocf_cache_t cache);
+
+/**
+ * @brief Same as ocf_queue_freelist_drain_all(), for caller holding metadata
+ *	write lock
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_queue_freelist_drain_all_locked(ocf_cache_t cache);
+#else
+static inline void ocf_queue_freelist_drain(ocf_queue_t q)
+{
+}
+
+static inline void ocf_queue_freelist_drain_all_locked(ocf_cache_t cache)
+{
+}
+
+static inline void ocf_queue_freelist_drain_all(ocf_cache_t cache)
+{
+}
+#endif
+
+/**
+ * @brief Take reference of up to max I/O queues of cache, other than
+ *	management queue, or of management queue if there are none
+ *
+ * @param cache - OCF cache instance
+ * @param queues - Array to store queues in
+ * @param max - Maximal number of queues to take
+ *
+ * @retval Number of queues taken
+ */
+/**
+ * @brief Get time elapsed since last user request was queued on any queue
+ *
+ * @param cache - cache instance
+ *
+ * @return Idle time in milliseconds
+ */
+uint32_t ocf_queue_get_idle_ms(ocf_cache_t cache);
+
+uint32_t ocf_queue_get_io_queues(ocf_cache_t cache, ocf_queue_t *queues,
+		uint32_t max);
+
+/* Shared queue has no cache, its members belong to caches */
+static inline bool ocf_queue_is_shared(ocf_queue_t queue)
+{
+	return !queue->cache;
+}
+
 static inline void ocf_queue_kick(ocf_queue_t queue, bool allow_sync)
 {
+	/* Polling runner will find request by itself. Request is accounted
+	 * in io_no with full barrier before queue is kicked, which pairs with
+	 * polling flag being cleared in ocf_queue_run_polled().
+	 */
+	if (env_atomic_read(&queue->polling))
+		return;
+
 	if (allow_sync && queue->ops->kick_sync)
 		queue->ops->kick_sync(queue);
 	else
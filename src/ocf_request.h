@@ -42,8 +42,31 @@ struct ocf_req_info {
 	uint32_t cleaner_cache_line_lock : 1;
 	/*!< Cleaner flag - acquire cache line lock */
 
+	uint32_t cleaner_pooled_data : 1;
+	/*!< Cleaner flag - data buffer comes from cleaner pool */
+
 	uint32_t internal : 1;
 	/**!< this is an internal request */
+
+	uint32_t split_read : 1;
+	/*!< Partial hit is read from cache and core separately, only cache
+	 * lines read from core are backfilled
+	 */
+
+	uint32_t dirty_merge : 1;
+	/*!< Miss of cache lines with dirty sectors is merged from core and
+	 * cache, only clean sectors may be invalidated on error
+	 */
+
+	uint32_t tier_promote : 1;
+	/*!< Hit is read by upper cache tier, clean sectors are invalidated
+	 * once data is read
+	 */
+
+	uint32_t warm : 1;
+	/*!< Read-ahead issued by cache warm-up, not dropped when backfill
+	 * queue is full
+	 */
 };
 
 struct ocf_map_info {
@@ -76,6 +99,17 @@ struct ocf_map_info {
 	uint16_t flush : 1;
 	/*!< This bit indicates if cache line need to be flushed */
 
+	uint16_t split_hit : 1;
+	/*!< Cache line is read from cache by split read */
+
+	uint16_t merge : 1;
+	/*!< Cache line read from core gets its dirty sectors from cache */
+
+#if OCF_CONFIG_ZERO_LINES
+	uint16_t zero : 1;
+	/*!< Zero line is cleaned with write-zeroes to core */
+#endif
+
 	uint8_t start_flush;
 	/*!< If req need flush, contain first sector of range to flush */
 
@@ -95,6 +129,23 @@ struct ocf_req_discard_info {
 
 	sector_t handled;
 		/*!< Number of processed sector during discard operation */
+
+	struct ocf_request *master;
+		/*!< Request which range is discarded, steps of the range are
+		 * handled by master and helper requests concurrently
+		 */
+
+	env_atomic step;
+		/*!< Next step to be handled, valid in master */
+
+	env_atomic workers;
+		/*!< Number of requests handling steps, valid in master */
+
+	int error;
+		/*!< Error which aborts discard, valid in master */
+
+	bool purged;
+		/*!< Cache lines were removed from metadata, valid in master */
 };
 
 /**
@@ -112,6 +163,16 @@ struct ocf_request {
 	 * map left to be locked
 	 */
 
+	void *lock_waiters;
+	/*!< Cache line lock waiters of request, allocated at once for all
+	 * cache lines while request waits for cache line locks
+	 */
+
+	void *lock_range;
+	/*!< Range lock covering all cache lines of request, NULL if cache
+	 * lines are locked one by one
+	 */
+
 	env_atomic req_remaining;
 	/*!< In case of IO this field indicates how many IO left to
 	 * accomplish IO
@@ -129,6 +190,9 @@ struct ocf_request {
 	void (*resume)(struct ocf_request *req);
 	/*!< OCF request resume callback */
 
+	int (*lock_clines)(struct ocf_request *req);
+	/*!< Cache lines lock callback of request parked for eviction */
+
 	ocf_core_id_t core_id;
 	/*!< This file indicates core id of request */
 
@@ -147,6 +211,12 @@ struct ocf_request {
 	ctx_data_t *cp_data;
 	/*!< Copy of request data */
 
+	uint32_t data_offset;
+	/*!< Offset of request data in data, for requests split from IO */
+
+	struct ocf_fill_entry *fill;
+	/*!< Entries of in-flight backfill of cp_data, NULL if not registered */
+
 	uint64_t byte_position;
 	/*!< LBA byte position of request in code domain */
 
@@ -156,6 +226,31 @@ struct ocf_request {
 	uint64_t core_line_last;
 	/*! Last core line */
 
+	uint64_t core_submit_ticks;
+	/*!< Tick count at which read was submitted to core device */
+
+	uint64_t submit_ticks;
+	/*!< Tick count at which user IO was submitted, 0 if not measured */
+
+	uint64_t backfill_ticks;
+	/*!< Tick count at which backfill was submitted, 0 if not measured */
+
+#if OCF_CONFIG_STATS_LATENCY || OCF_CONFIG_STATS_LOCK
+	uint64_t lock_ticks;
+	/*!< Tick count at which request started waiting for cache lines */
+#endif
+
+	uint64_t trace_sid;
+	/*!< Sequence ID of traced IO event of request, 0 if not traced */
+
+#if OCF_CONFIG_STATS_LATENCY
+	uint64_t start_ticks;
+	/*!< Tick count at which request was created */
+
+	uint64_t lock_wait_ticks;
+	/*!< Total ticks request spent waiting for cache line locks */
+#endif
+
 	uint32_t byte_length;
 	/*!< Byte length of OCF reuqest */
 
@@ -165,6 +260,15 @@ struct ocf_request {
 	uint32_t alloc_core_line_count;
 	/*! Core line count for which request was initially allocated */
 
+	uint32_t cleaner_pool_lines;
+	/*!< Cache line count of data buffer taken from cleaner pool */
+
+	uint32_t cleaner_resume_line;
+	/*!< Map entry from which cleaner resumes writes to core */
+
+	uint16_t cleaner_resume_sector;
+	/*!< Sector of map entry from which cleaner resumes writes to core */
+
 	ocf_queue_t io_queue;
 	/*!< I/O queue handle for which request should be submitted */
 
@@ -183,6 +287,18 @@ struct ocf_request {
 	uint8_t d2c;
 	/**!< request affects metadata cachelines (is not direct-to-core) */
 
+	uint8_t evict_parked;
+	/*!< Request was already parked waiting for background eviction */
+
+	uint8_t background;
+	/*!< Request is background work of user IO which is already completed */
+
+	uint8_t mngt;
+	/*!< Request runs steps of management pipeline, queued ahead of I/O */
+
+	uint32_t hash_gen;
+	/*!< Mapping generation of request hash buckets when locking lines */
+
 	uint8_t master_io_req_type;
 	/*!< Core device request context type */
 
@@ -192,6 +308,11 @@ struct ocf_request {
 	struct ocf_io *io;
 	/*!< OCF IO associated with request */
 
+	struct ocf_io *owner_io;
+	/*!< IO which request is embedded in, NULL if request was allocated
+	 * on its own
+	 */
+
 	struct ocf_req_discard_info discard;
 
 	struct ocf_map_info *map;
@@ -201,4 +322,15 @@ struct ocf_request {
 
 typedef void (*ocf_req_end_t)(struct ocf_request *req, int error);
 
+/*
+ * Request is queued behind foreground ones, see OCF_CONFIG_QUEUE_BG_WEIGHT.
+ * Management pipeline steps are internal, but user waits for them, so they
+ * are foreground.
+ */
+static inline bool ocf_req_is_background(struct ocf_request *req)
+{
+	return OCF_CONFIG_QUEUE_BG_WEIGHT && !req->mngt &&
+			(req->info.internal || req->background);
+}
+
 #endif
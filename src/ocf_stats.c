@@ -10,23 +10,14 @@
 #include "utils/utils_part.h"
 #include "utils/utils_cache_line.h"
 #include "utils/utils_core.h"
+#include "utils/utils_mrc.h"
+#include "utils/utils_compress.h"
+#include "utils/utils_dedup.h"
 
-#ifdef OCF_DEBUG_STATS
 static void ocf_stats_debug_init(struct ocf_counters_debug *stats)
 {
-	int i;
-
-	for (i = 0; i < IO_PACKET_NO; i++) {
-		env_atomic64_set(&stats->read_size[i], 0);
-		env_atomic64_set(&stats->write_size[i], 0);
-	}
-
-	for (i = 0; i < IO_ALIGN_NO; i++) {
-		env_atomic64_set(&stats->read_align[i], 0);
-		env_atomic64_set(&stats->write_align[i], 0);
-	}
+	ENV_BUG_ON(env_memset(stats, sizeof(*stats), 0));
 }
-#endif
 
 static void ocf_stats_req_init(struct ocf_counters_req *stats)
 {
@@ -42,12 +33,41 @@ static void ocf_stats_block_init(struct ocf_counters_block *stats)
 	env_atomic64_set(&stats->write_bytes, 0);
 }
 
+#if OCF_CONFIG_STATS_LATENCY
+static void ocf_stats_latency_init(struct ocf_counters_latency *stats)
+{
+	int i;
+
+	env_atomic64_set(&stats->count, 0);
+	env_atomic64_set(&stats->total_ns, 0);
+
+	for (i = 0; i < OCF_STATS_LATENCY_BUCKETS; i++)
+		env_atomic64_set(&stats->buckets[i], 0);
+}
+#endif
+
+static void ocf_stats_cleaning_init(struct ocf_counters_cleaning *stats)
+{
+	int i;
+
+	env_atomic64_set(&stats->cleaned_clines, 0);
+	env_atomic64_set(&stats->write_bytes, 0);
+	env_atomic64_set(&stats->busy_clines, 0);
+
+	for (i = 0; i < OCF_STATS_CLEANING_IO_SIZES; i++)
+		env_atomic64_set(&stats->io_size[i], 0);
+}
+
 static void ocf_stats_part_init(struct ocf_counters_part *stats)
 {
 	ocf_stats_req_init(&stats->read_reqs);
 	ocf_stats_req_init(&stats->write_reqs);
 
 	ocf_stats_block_init(&stats->blocks);
+	ocf_stats_cleaning_init(&stats->cleaning);
+#if OCF_CONFIG_STATS_LATENCY
+	ocf_stats_latency_init(&stats->latency);
+#endif
 }
 
 static void ocf_stats_error_init(struct ocf_counters_error *stats)
@@ -72,29 +92,60 @@ static void ocf_stats_error_init(struct ocf_counters_error *stats)
 void ocf_core_stats_initialize(ocf_core_t core)
 {
 	struct ocf_counters_core *exp_obj_stats;
-	int i;
+	int i, shard;
 
 	OCF_CHECK_NULL(core);
 
-	exp_obj_stats = core->counters;
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		exp_obj_stats = &core->counters[shard];
 
-	ocf_stats_block_init(&exp_obj_stats->core_blocks);
-	ocf_stats_block_init(&exp_obj_stats->cache_blocks);
+		ocf_stats_block_init(&exp_obj_stats->core_blocks);
+		ocf_stats_block_init(&exp_obj_stats->cache_blocks);
 
-	ocf_stats_error_init(&exp_obj_stats->cache_errors);
-	ocf_stats_error_init(&exp_obj_stats->core_errors);
+		ocf_stats_error_init(&exp_obj_stats->cache_errors);
+		ocf_stats_error_init(&exp_obj_stats->core_errors);
 
-	for (i = 0; i != OCF_IO_CLASS_MAX; i++)
-		ocf_stats_part_init(&exp_obj_stats->part_counters[i]);
+		for (i = 0; i != OCF_IO_CLASS_MAX; i++)
+			ocf_stats_part_init(&exp_obj_stats->part_counters[i]);
 
-#ifdef OCF_DEBUG_STATS
-	ocf_stats_debug_init(&exp_obj_stats->debug_stats);
+#if OCF_CONFIG_STATS_LATENCY
+		for (i = 0; i != ocf_stats_latency_max; i++)
+			ocf_stats_latency_init(&exp_obj_stats->latency[i]);
 #endif
+
+		ocf_stats_debug_init(&exp_obj_stats->debug_stats);
+	}
+}
+
+static void ocf_stats_eviction_init(struct ocf_counters_eviction *stats)
+{
+	env_atomic64_set(&stats->evicted_clines, 0);
+	env_atomic64_set(&stats->locked_clines, 0);
+	env_atomic64_set(&stats->dirty_fallbacks, 0);
+	env_atomic64_set(&stats->requests, 0);
+	env_atomic64_set(&stats->time_ns, 0);
+	env_atomic64_set(&stats->max_time_ns, 0);
 }
 
 void ocf_core_stats_initialize_all(ocf_cache_t cache)
 {
 	ocf_core_id_t id;
+	int i;
+
+	for (i = 0; i != OCF_IO_CLASS_MAX + 1; i++)
+		ocf_stats_eviction_init(&cache->eviction_counters[i]);
+
+	env_atomic64_set(&cache->cleaner_counters.runs, 0);
+	env_atomic64_set(&cache->cleaner_counters.postponed_runs, 0);
+	env_atomic64_set(&cache->cleaner_counters.time_ns, 0);
+	env_atomic64_set(&cache->cleaner_counters.max_time_ns, 0);
+
+#if OCF_CONFIG_STATS_LOCK
+	for (i = 0; i != ocf_stats_lock_max; i++) {
+		env_atomic64_set(&cache->lock_counters[i].contended, 0);
+		env_atomic64_set(&cache->lock_counters[i].wait_ns, 0);
+	}
+#endif
 
 	for (id = 0; id < OCF_CORE_MAX; id++) {
 		if (!env_bit_test(id, cache->conf_meta->valid_core_bitmap))
@@ -104,15 +155,6 @@ void ocf_core_stats_initialize_all(ocf_cache_t cache)
 	}
 }
 
-static void copy_req_stats(struct ocf_stats_req *dest,
-		const struct ocf_counters_req *from)
-{
-	dest->partial_miss = env_atomic64_read(&from->partial_miss);
-	dest->full_miss = env_atomic64_read(&from->full_miss);
-	dest->total = env_atomic64_read(&from->total);
-	dest->pass_through = env_atomic64_read(&from->pass_through);
-}
-
 static void accum_req_stats(struct ocf_stats_req *dest,
 		const struct ocf_counters_req *from)
 {
@@ -122,11 +164,28 @@ static void accum_req_stats(struct ocf_stats_req *dest,
 	dest->pass_through += env_atomic64_read(&from->pass_through);
 }
 
-static void copy_block_stats(struct ocf_stats_block *dest,
-		const struct ocf_counters_block *from)
+static void copy_eviction_stats(struct ocf_stats_eviction *dest,
+		const struct ocf_counters_eviction *from)
+{
+	dest->evicted_clines = env_atomic64_read(&from->evicted_clines);
+	dest->locked_clines = env_atomic64_read(&from->locked_clines);
+	dest->dirty_fallbacks = env_atomic64_read(&from->dirty_fallbacks);
+	dest->requests = env_atomic64_read(&from->requests);
+	dest->time_ns = env_atomic64_read(&from->time_ns);
+	dest->max_time_ns = env_atomic64_read(&from->max_time_ns);
+}
+
+static void accum_cleaning_stats(struct ocf_stats_cleaning *dest,
+		const struct ocf_counters_cleaning *from)
 {
-	dest->read = env_atomic64_read(&from->read_bytes);
-	dest->write = env_atomic64_read(&from->write_bytes);
+	int i;
+
+	dest->cleaned_clines += env_atomic64_read(&from->cleaned_clines);
+	dest->write_bytes += env_atomic64_read(&from->write_bytes);
+	dest->busy_clines += env_atomic64_read(&from->busy_clines);
+
+	for (i = 0; i < OCF_STATS_CLEANING_IO_SIZES; i++)
+		dest->io_size[i] += env_atomic64_read(&from->io_size[i]);
 }
 
 static void accum_block_stats(struct ocf_stats_block *dest,
@@ -136,29 +195,84 @@ static void accum_block_stats(struct ocf_stats_block *dest,
 	dest->write += env_atomic64_read(&from->write_bytes);
 }
 
-static void copy_error_stats(struct ocf_stats_error *dest,
+static void accum_error_stats(struct ocf_stats_error *dest,
 		const struct ocf_counters_error *from)
 {
-	dest->read = env_atomic_read(&from->read);
-	dest->write = env_atomic_read(&from->write);
+	dest->read += env_atomic_read(&from->read);
+	dest->write += env_atomic_read(&from->write);
 }
 
-#ifdef OCF_DEBUG_STATS
-static void copy_debug_stats(struct ocf_stats_core_debug *dest,
+static void accum_debug_stats(struct ocf_stats_core_debug *dest,
 		const struct ocf_counters_debug *from)
 {
 	int i;
 
 	for (i = 0; i < IO_PACKET_NO; i++) {
-		dest->read_size[i] = env_atomic64_read(&from->read_size[i]);
-		dest->write_size[i] = env_atomic64_read(&from->write_size[i]);
+		dest->read_size[i] += from->read_size[i];
+		dest->write_size[i] += from->write_size[i];
 	}
 
 	for (i = 0; i < IO_ALIGN_NO; i++) {
-		dest->read_align[i] = env_atomic64_read(&from->read_align[i]);
-		dest->write_align[i] = env_atomic64_read(&from->write_align[i]);
+		dest->read_align[i] += from->read_align[i];
+		dest->write_align[i] += from->write_align[i];
 	}
 }
+
+#if OCF_CONFIG_STATS_LATENCY
+static void ocf_stats_latency_add(struct ocf_counters_latency *stats,
+		uint64_t ns)
+{
+	uint64_t us = ns / 1000;
+	int idx = 0;
+
+	while (us > 1 && idx < OCF_STATS_LATENCY_BUCKETS - 1) {
+		us >>= 1;
+		idx++;
+	}
+
+	env_atomic64_inc(&stats->count);
+	env_atomic64_add(ns, &stats->total_ns);
+	env_atomic64_inc(&stats->buckets[idx]);
+}
+
+void ocf_core_stats_latency_update(struct ocf_request *req)
+{
+	struct ocf_counters_core *stats = ocf_req_core_stats(req);
+	bool hit = req->info.hit_no == req->core_line_count;
+	uint64_t ns;
+	int type;
+
+	ns = env_ticks_to_nsecs(env_get_tick_count() - req->start_ticks);
+
+	if (req->rw == OCF_WRITE) {
+		type = hit ? ocf_stats_latency_write_hit :
+				ocf_stats_latency_write_miss;
+	} else {
+		type = hit ? ocf_stats_latency_read_hit :
+				ocf_stats_latency_read_miss;
+	}
+
+	ocf_stats_latency_add(&stats->latency[type], ns);
+	ocf_stats_latency_add(&stats->part_counters[req->part_id].latency, ns);
+
+	if (req->lock_wait_ticks) {
+		ocf_stats_latency_add(&stats->latency[
+				ocf_stats_latency_lock_wait],
+				env_ticks_to_nsecs(req->lock_wait_ticks));
+	}
+}
+
+void ocf_core_stats_latency_accum(struct ocf_stats_latency_hist *dest,
+		const struct ocf_counters_latency *from)
+{
+	int i;
+
+	dest->count += env_atomic64_read(&from->count);
+	dest->total_ns += env_atomic64_read(&from->total_ns);
+
+	for (i = 0; i < OCF_STATS_LATENCY_BUCKETS; i++)
+		dest->buckets[i] += env_atomic64_read(&from->buckets[i]);
+}
 #endif
 
 int ocf_core_io_class_get_stats(ocf_core_t core, ocf_part_id_t part_id,
@@ -169,6 +283,7 @@ int ocf_core_io_class_get_stats(ocf_core_t core, ocf_part_id_t part_id,
 	uint32_t cache_occupancy_total = 0;
 	struct ocf_counters_part *part_stat;
 	ocf_core_id_t core_id;
+	int shard;
 
 	OCF_CHECK_NULL(core);
 	OCF_CHECK_NULL(stats);
@@ -187,8 +302,6 @@ int ocf_core_io_class_get_stats(ocf_core_t core, ocf_part_id_t part_id,
 				&cache->core_runtime_meta[i].cached_clines);
 	}
 
-	part_stat = &core->counters->part_counters[part_id];
-
 	stats->occupancy_clines = env_atomic_read(&cache->
 		core_runtime_meta[core_id].part_counters[part_id].
 			cached_clines);
@@ -196,13 +309,23 @@ int ocf_core_io_class_get_stats(ocf_core_t core, ocf_part_id_t part_id,
 		core_runtime_meta[core_id].part_counters[part_id].
 			dirty_clines);
 
-	stats->free_clines = cache->conf_meta->cachelines -
-			cache_occupancy_total;
+	stats->free_clines = cache->device->lines_limit -
+			OCF_MIN(cache->device->lines_limit,
+					cache_occupancy_total);
+
+	ENV_BUG_ON(env_memset(&stats->read_reqs, sizeof(stats->read_reqs), 0));
+	ENV_BUG_ON(env_memset(&stats->write_reqs,
+			sizeof(stats->write_reqs), 0));
+	ENV_BUG_ON(env_memset(&stats->blocks, sizeof(stats->blocks), 0));
 
-	copy_req_stats(&stats->read_reqs, &part_stat->read_reqs);
-	copy_req_stats(&stats->write_reqs, &part_stat->write_reqs);
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		part_stat = &core->counters[shard].part_counters[part_id];
 
-	copy_block_stats(&stats->blocks, &part_stat->blocks);
+		accum_req_stats(&stats->read_reqs, &part_stat->read_reqs);
+		accum_req_stats(&stats->write_reqs, &part_stat->write_reqs);
+
+		accum_block_stats(&stats->blocks, &part_stat->blocks);
+	}
 
 	return 0;
 }
@@ -214,6 +337,249 @@ static uint32_t _calc_dirty_for(uint64_t dirty_since)
 		: 0;
 }
 
+int ocf_cache_io_class_get_eviction_stats(ocf_cache_t cache,
+		ocf_part_id_t part_id, struct ocf_stats_eviction *stats)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(stats);
+
+	if (part_id < OCF_IO_CLASS_ID_MIN || part_id > OCF_IO_CLASS_ID_MAX)
+		return -OCF_ERR_INVAL;
+
+	if (!ocf_part_is_valid(&cache->user_parts[part_id]))
+		return -OCF_ERR_IO_CLASS_NOT_EXIST;
+
+	copy_eviction_stats(stats, &cache->eviction_counters[part_id]);
+
+	return 0;
+}
+
+static void accum_core_cleaning_stats(ocf_core_t core, ocf_part_id_t part_id,
+		struct ocf_stats_cleaning *stats)
+{
+	int shard;
+
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		accum_cleaning_stats(stats, &core->counters[shard].
+				part_counters[part_id].cleaning);
+	}
+}
+
+int ocf_core_io_class_get_cleaning_stats(ocf_core_t core,
+		ocf_part_id_t part_id, struct ocf_stats_cleaning *stats)
+{
+	ocf_cache_t cache;
+
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(stats);
+
+	if (part_id < OCF_IO_CLASS_ID_MIN || part_id > OCF_IO_CLASS_ID_MAX)
+		return -OCF_ERR_INVAL;
+
+	cache = ocf_core_get_cache(core);
+
+	if (!ocf_part_is_valid(&cache->user_parts[part_id]))
+		return -OCF_ERR_IO_CLASS_NOT_EXIST;
+
+	ENV_BUG_ON(env_memset(stats, sizeof(*stats), 0));
+
+	accum_core_cleaning_stats(core, part_id, stats);
+
+	return 0;
+}
+
+int ocf_core_get_cleaning_stats(ocf_core_t core,
+		struct ocf_stats_cleaning *stats)
+{
+	ocf_part_id_t part_id;
+
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(stats);
+
+	ENV_BUG_ON(env_memset(stats, sizeof(*stats), 0));
+
+	for (part_id = 0; part_id != OCF_IO_CLASS_MAX; part_id++)
+		accum_core_cleaning_stats(core, part_id, stats);
+
+	return 0;
+}
+
+int ocf_cache_io_class_get_cleaning_stats(ocf_cache_t cache,
+		ocf_part_id_t part_id, struct ocf_stats_cleaning *stats)
+{
+	ocf_core_id_t core_id;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(stats);
+
+	if (part_id < OCF_IO_CLASS_ID_MIN || part_id > OCF_IO_CLASS_ID_MAX)
+		return -OCF_ERR_INVAL;
+
+	if (!ocf_part_is_valid(&cache->user_parts[part_id]))
+		return -OCF_ERR_IO_CLASS_NOT_EXIST;
+
+	ENV_BUG_ON(env_memset(stats, sizeof(*stats), 0));
+
+	for_each_core(cache, core_id)
+		accum_core_cleaning_stats(&cache->core[core_id], part_id, stats);
+
+	return 0;
+}
+
+int ocf_cache_get_cleaner_stats(ocf_cache_t cache,
+		struct ocf_stats_cleaner *stats)
+{
+	struct ocf_counters_cleaner *counters;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(stats);
+
+	counters = &cache->cleaner_counters;
+
+	stats->runs = env_atomic64_read(&counters->runs);
+	stats->postponed_runs = env_atomic64_read(&counters->postponed_runs);
+	stats->time_ns = env_atomic64_read(&counters->time_ns);
+	stats->max_time_ns = env_atomic64_read(&counters->max_time_ns);
+
+	return 0;
+}
+
+#if OCF_CONFIG_STATS_WINDOW > 0
+/* Counter which went backwards was reset, so whole value is the increase */
+static inline uint64_t _ocf_stats_window_delta(uint64_t curr, uint64_t prev)
+{
+	return curr >= prev ? curr - prev : curr;
+}
+
+static void _ocf_stats_window_accum(const struct ocf_counters_req *from,
+		uint64_t *hits, uint64_t *misses)
+{
+	uint64_t miss = env_atomic64_read(&from->partial_miss) +
+			env_atomic64_read(&from->full_miss);
+
+	*hits += env_atomic64_read(&from->total) - miss;
+	*misses += miss;
+}
+
+void ocf_stats_window_tick(ocf_cache_t cache)
+{
+	struct ocf_stats_window *window = &cache->stats_window;
+	struct ocf_stats_window_part *wpart;
+	struct ocf_stats_interval *sample;
+	struct ocf_counters_part *counters;
+	uint64_t hits[OCF_IO_CLASS_MAX] = { 0 };
+	uint64_t misses[OCF_IO_CLASS_MAX] = { 0 };
+	uint64_t dirty[OCF_IO_CLASS_MAX] = { 0 };
+	uint64_t now, duration_ms, evicted;
+	ocf_core_id_t core_id;
+	ocf_core_t core;
+	int shard, part;
+
+	now = env_get_tick_count();
+	duration_ms = env_ticks_to_msecs(now - window->last_ticks);
+	if (window->last_ticks &&
+			duration_ms < OCF_CONFIG_STATS_WINDOW_INTERVAL_MS) {
+		return;
+	}
+
+	/* Cleaner instances run concurrently, one closes the interval */
+	if (env_atomic_cmpxchg(&window->busy, 0, 1))
+		return;
+
+	for_each_core(cache, core_id) {
+		core = &cache->core[core_id];
+
+		for (part = 0; part < OCF_IO_CLASS_MAX; part++) {
+			dirty[part] += env_atomic_read(&cache->
+					core_runtime_meta[core_id].
+					part_counters[part].dirty_clines);
+
+			for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+				counters = &core->counters[shard].
+						part_counters[part];
+
+				_ocf_stats_window_accum(&counters->read_reqs,
+						&hits[part], &misses[part]);
+				_ocf_stats_window_accum(&counters->write_reqs,
+						&hits[part], &misses[part]);
+			}
+		}
+	}
+
+	env_spinlock_lock(&window->lock);
+
+	for (part = 0; part < OCF_IO_CLASS_MAX; part++) {
+		wpart = &window->parts[part];
+		sample = &wpart->samples[window->head];
+		evicted = env_atomic64_read(
+				&cache->eviction_counters[part].evicted_clines);
+
+		sample->duration_ms = duration_ms;
+		sample->hits = _ocf_stats_window_delta(hits[part], wpart->hits);
+		sample->misses = _ocf_stats_window_delta(misses[part],
+				wpart->misses);
+		sample->evicted_clines = _ocf_stats_window_delta(evicted,
+				wpart->evicted_clines);
+		sample->occupancy_clines =
+				cache->user_parts[part].runtime->curr_size;
+		sample->dirty_clines = dirty[part];
+
+		wpart->hits = hits[part];
+		wpart->misses = misses[part];
+		wpart->evicted_clines = evicted;
+	}
+
+	/* First tick only sets baseline of cumulative counters */
+	if (window->last_ticks) {
+		window->head = (window->head + 1) % OCF_CONFIG_STATS_WINDOW;
+		window->count = OCF_MIN(window->count + 1,
+				OCF_CONFIG_STATS_WINDOW);
+	}
+	window->last_ticks = now;
+
+	env_spinlock_unlock(&window->lock);
+
+	env_atomic_set(&window->busy, 0);
+}
+#endif
+
+int ocf_cache_io_class_get_stats_window(ocf_cache_t cache,
+		ocf_part_id_t part_id, struct ocf_stats_interval *samples,
+		uint32_t *count)
+{
+#if OCF_CONFIG_STATS_WINDOW > 0
+	struct ocf_stats_window *window;
+	uint32_t i, idx;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(samples);
+	OCF_CHECK_NULL(count);
+
+	if (part_id < OCF_IO_CLASS_ID_MIN || part_id > OCF_IO_CLASS_ID_MAX)
+		return -OCF_ERR_INVAL;
+
+	if (!ocf_part_is_valid(&cache->user_parts[part_id]))
+		return -OCF_ERR_IO_CLASS_NOT_EXIST;
+
+	window = &cache->stats_window;
+
+	env_spinlock_lock(&window->lock);
+
+	*count = OCF_MIN(*count, window->count);
+	for (i = 0, idx = window->head; i < *count; i++) {
+		idx = (idx + OCF_CONFIG_STATS_WINDOW - 1) %
+				OCF_CONFIG_STATS_WINDOW;
+		samples[i] = window->parts[part_id].samples[idx];
+	}
+
+	env_spinlock_unlock(&window->lock);
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
 int ocf_core_get_stats(ocf_core_t core, struct ocf_stats_core *stats)
 {
 	uint32_t i;
@@ -221,6 +587,7 @@ int ocf_core_get_stats(ocf_core_t core, struct ocf_stats_core *stats)
 	ocf_cache_t cache;
 	struct ocf_counters_core *core_stats = NULL;
 	struct ocf_counters_part *curr = NULL;
+	int shard;
 
 	OCF_CHECK_NULL(core);
 
@@ -230,8 +597,6 @@ int ocf_core_get_stats(ocf_core_t core, struct ocf_stats_core *stats)
 	if (!stats)
 		return -OCF_ERR_INVAL;
 
-	core_stats = core->counters;
-
 	ENV_BUG_ON(env_memset(stats, sizeof(*stats), 0));
 
 	stats->core_size_bytes = ocf_volume_get_length(
@@ -244,29 +609,35 @@ int ocf_core_get_stats(ocf_core_t core, struct ocf_stats_core *stats)
 
 	env_atomic_read(&cache->core_runtime_meta[core_id].cached_clines);
 
-	copy_block_stats(&stats->core_volume, &core_stats->core_blocks);
-	copy_block_stats(&stats->cache_volume, &core_stats->cache_blocks);
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		core_stats = &core->counters[shard];
 
-	copy_error_stats(&stats->core_errors,
-			&core_stats->core_errors);
-	copy_error_stats(&stats->cache_errors,
-			&core_stats->cache_errors);
+		accum_block_stats(&stats->core_volume,
+				&core_stats->core_blocks);
+		accum_block_stats(&stats->cache_volume,
+				&core_stats->cache_blocks);
 
-#ifdef OCF_DEBUG_STATS
-	copy_debug_stats(&stats->debug_stat,
-			&core_stats->debug_stats);
-#endif
+		accum_error_stats(&stats->core_errors,
+				&core_stats->core_errors);
+		accum_error_stats(&stats->cache_errors,
+				&core_stats->cache_errors);
 
-	for (i = 0; i != OCF_IO_CLASS_MAX; i++) {
-		curr = &core_stats->part_counters[i];
+		accum_debug_stats(&stats->debug_stat,
+				&core_stats->debug_stats);
 
-		accum_req_stats(&stats->read_reqs,
-				&curr->read_reqs);
-		accum_req_stats(&stats->write_reqs,
-				&curr->write_reqs);
+		for (i = 0; i != OCF_IO_CLASS_MAX; i++) {
+			curr = &core_stats->part_counters[i];
 
-		accum_block_stats(&stats->core, &curr->blocks);
+			accum_req_stats(&stats->read_reqs,
+					&curr->read_reqs);
+			accum_req_stats(&stats->write_reqs,
+					&curr->write_reqs);
+
+			accum_block_stats(&stats->core, &curr->blocks);
+		}
+	}
 
+	for (i = 0; i != OCF_IO_CLASS_MAX; i++) {
 		stats->cache_occupancy += env_atomic_read(&cache->
 				core_runtime_meta[core_id].part_counters[i].
 						cached_clines);
@@ -283,7 +654,217 @@ int ocf_core_get_stats(ocf_core_t core, struct ocf_stats_core *stats)
 	return 0;
 }
 
-#ifdef OCF_DEBUG_STATS
+int ocf_core_get_mrc(ocf_core_t core, struct ocf_stats_mrc *mrc)
+{
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(mrc);
+
+	if (!core->mrc)
+		return -OCF_ERR_INVAL;
+
+	ocf_mrc_get(core->mrc, mrc);
+
+	return 0;
+}
+
+int ocf_cache_get_compress_stats(ocf_cache_t cache,
+		struct ocf_stats_compress *stats)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(stats);
+
+	if (!cache->compress_est)
+		return -OCF_ERR_INVAL;
+
+	ocf_compress_est_get(cache, stats);
+
+	return 0;
+}
+
+int ocf_cache_get_dedup_stats(ocf_cache_t cache,
+		struct ocf_stats_dedup *stats)
+{
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(stats);
+
+	if (!cache->dedup_est)
+		return -OCF_ERR_INVAL;
+
+	ocf_dedup_est_get(cache, stats);
+
+	return 0;
+}
+
+uint32_t ocf_stats_snapshot_size(uint32_t core_count)
+{
+	return sizeof(struct ocf_stats_snapshot) +
+			core_count * sizeof(struct ocf_stats_snapshot_core);
+}
+
+static void ocf_stats_snapshot_core(ocf_core_t core,
+		struct ocf_stats_snapshot_core *stats)
+{
+	ocf_cache_t cache = ocf_core_get_cache(core);
+	ocf_core_id_t core_id = ocf_core_get_id(core);
+	struct ocf_counters_core *core_stats;
+	struct ocf_counters_part *curr;
+	int shard, i;
+
+	ENV_BUG_ON(env_memset(stats, sizeof(*stats), 0));
+
+	stats->core_id = core_id;
+	stats->cache_occupancy = env_atomic_read(
+			&cache->core_runtime_meta[core_id].cached_clines);
+	stats->dirty = env_atomic_read(
+			&cache->core_runtime_meta[core_id].dirty_clines);
+
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		core_stats = &core->counters[shard];
+
+		accum_block_stats(&stats->core_volume,
+				&core_stats->core_blocks);
+		accum_block_stats(&stats->cache_volume,
+				&core_stats->cache_blocks);
+
+		accum_error_stats(&stats->core_errors,
+				&core_stats->core_errors);
+		accum_error_stats(&stats->cache_errors,
+				&core_stats->cache_errors);
+
+		for (i = 0; i != OCF_IO_CLASS_MAX; i++) {
+			curr = &core_stats->part_counters[i];
+
+			accum_req_stats(&stats->read_reqs, &curr->read_reqs);
+			accum_req_stats(&stats->write_reqs, &curr->write_reqs);
+
+			accum_block_stats(&stats->core, &curr->blocks);
+		}
+	}
+}
+
+int ocf_cache_get_stats_snapshot(ocf_cache_t cache,
+		struct ocf_stats_snapshot *snapshot)
+{
+	uint32_t max, count = 0;
+	ocf_core_id_t id;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(snapshot);
+
+	if (snapshot->version != OCF_STATS_SNAPSHOT_VERSION)
+		return -OCF_ERR_INVAL;
+
+	if (snapshot->size < ocf_stats_snapshot_size(0))
+		return -ENOSPC;
+
+	max = (snapshot->size - ocf_stats_snapshot_size(0)) /
+			sizeof(snapshot->cores[0]);
+
+	snapshot->timestamp_ns = env_ticks_to_nsecs(env_get_tick_count());
+
+	for_each_core(cache, id) {
+		if (count == max)
+			return -ENOSPC;
+
+		ocf_stats_snapshot_core(&cache->core[id],
+				&snapshot->cores[count++]);
+	}
+
+	snapshot->core_count = count;
+
+	return 0;
+}
+
+/* Counter which went backwards was reset, so whole value is the increase */
+#define _ocf_stats_delta(d, c, p) \
+	((d) = (c) >= (p) ? (c) - (p) : (c))
+
+static void ocf_stats_req_delta(struct ocf_stats_req *d,
+		const struct ocf_stats_req *c, const struct ocf_stats_req *p)
+{
+	_ocf_stats_delta(d->partial_miss, c->partial_miss, p->partial_miss);
+	_ocf_stats_delta(d->full_miss, c->full_miss, p->full_miss);
+	_ocf_stats_delta(d->total, c->total, p->total);
+	_ocf_stats_delta(d->pass_through, c->pass_through, p->pass_through);
+}
+
+static void ocf_stats_block_delta(struct ocf_stats_block *d,
+		const struct ocf_stats_block *c,
+		const struct ocf_stats_block *p)
+{
+	_ocf_stats_delta(d->read, c->read, p->read);
+	_ocf_stats_delta(d->write, c->write, p->write);
+}
+
+static void ocf_stats_error_delta(struct ocf_stats_error *d,
+		const struct ocf_stats_error *c,
+		const struct ocf_stats_error *p)
+{
+	_ocf_stats_delta(d->read, c->read, p->read);
+	_ocf_stats_delta(d->write, c->write, p->write);
+}
+
+int ocf_stats_snapshot_delta(const struct ocf_stats_snapshot *prev,
+		const struct ocf_stats_snapshot *curr,
+		struct ocf_stats_snapshot *delta)
+{
+	const struct ocf_stats_snapshot_core *c, *p;
+	struct ocf_stats_snapshot_core *d;
+	uint32_t i, j = 0;
+
+	OCF_CHECK_NULL(prev);
+	OCF_CHECK_NULL(curr);
+	OCF_CHECK_NULL(delta);
+
+	if (prev->version != OCF_STATS_SNAPSHOT_VERSION ||
+			curr->version != OCF_STATS_SNAPSHOT_VERSION ||
+			delta->version != OCF_STATS_SNAPSHOT_VERSION) {
+		return -OCF_ERR_INVAL;
+	}
+
+	if (delta->size < ocf_stats_snapshot_size(curr->core_count))
+		return -ENOSPC;
+
+	delta->timestamp_ns = curr->timestamp_ns - prev->timestamp_ns;
+	delta->core_count = curr->core_count;
+
+	/* Both snapshots are sorted by core id */
+	for (i = 0; i < curr->core_count; i++) {
+		c = &curr->cores[i];
+		d = &delta->cores[i];
+
+		while (j < prev->core_count &&
+				prev->cores[j].core_id < c->core_id) {
+			j++;
+		}
+
+		*d = *c;
+
+		if (j == prev->core_count ||
+				prev->cores[j].core_id != c->core_id) {
+			continue;
+		}
+
+		p = &prev->cores[j];
+
+		ocf_stats_req_delta(&d->read_reqs, &c->read_reqs, &p->read_reqs);
+		ocf_stats_req_delta(&d->write_reqs, &c->write_reqs,
+				&p->write_reqs);
+
+		ocf_stats_block_delta(&d->cache_volume, &c->cache_volume,
+				&p->cache_volume);
+		ocf_stats_block_delta(&d->core_volume, &c->core_volume,
+				&p->core_volume);
+		ocf_stats_block_delta(&d->core, &c->core, &p->core);
+
+		ocf_stats_error_delta(&d->cache_errors, &c->cache_errors,
+				&p->cache_errors);
+		ocf_stats_error_delta(&d->core_errors, &c->core_errors,
+				&p->core_errors);
+	}
+
+	return 0;
+}
 
 #define IO_ALIGNMENT_SIZE (IO_ALIGN_NO)
 #define IO_PACKET_SIZE ((IO_PACKET_NO) - 1)
@@ -296,12 +877,15 @@ static int to_align_idx(uint64_t off)
 {
 	int i;
 
-	for (i = IO_ALIGNMENT_SIZE - 1; i >= 0; i--) {
+	for (i = IO_ALIGNMENT_SIZE - 1; i > 0; i--) {
 		if (off % io_alignment[i] == 0)
 			return i;
 	}
 
-	return IO_ALIGNMENT_SIZE;
+	/* Offsets not aligned to sector are accounted with the smallest
+	 * alignment
+	 */
+	return 0;
 }
 
 static uint32_t io_packet_size[IO_PACKET_SIZE] = {
@@ -326,31 +910,20 @@ static int to_packet_idx(uint32_t len)
 void ocf_core_update_stats(ocf_core_t core, struct ocf_io *io)
 {
 	struct ocf_counters_debug *stats;
-	int idx;
 
 	OCF_CHECK_NULL(core);
 	OCF_CHECK_NULL(io);
 
-	core_id = ocf_core_get_id(core);
-	cache = ocf_core_get_cache(core);
-
-	stats = &core->counters->debug_stats;
+	if (likely(!ocf_core_get_cache(core)->debug_stats))
+		return;
 
-	idx = to_packet_idx(io->bytes);
-	if (io->dir == OCF_WRITE)
-		env_atomic64_inc(&stats->write_size[idx]);
-	else
-		env_atomic64_inc(&stats->read_size[idx]);
+	stats = &ocf_core_stats(core, io->io_queue)->debug_stats;
 
-	idx = to_align_idx(io->addr);
-	if (io->dir == OCF_WRITE)
-		env_atomic64_inc(&stats->write_align[idx]);
-	else
-		env_atomic64_inc(&stats->read_align[idx]);
+	if (io->dir == OCF_WRITE) {
+		stats->write_size[to_packet_idx(io->bytes)]++;
+		stats->write_align[to_align_idx(io->addr)]++;
+	} else {
+		stats->read_size[to_packet_idx(io->bytes)]++;
+		stats->read_align[to_align_idx(io->addr)]++;
+	}
 }
-
-#else
-
-void ocf_core_update_stats(ocf_core_t core, struct ocf_io *io) {}
-
-#endif
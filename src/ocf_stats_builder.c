@@ -172,7 +172,7 @@ int ocf_stats_collect_core(ocf_core_t core,
 
 	cache = ocf_core_get_cache(core);
 	cache_line_size = ocf_cache_get_line_size(cache);
-	cache_size = cache->conf_meta->cachelines;
+	cache_size = cache->device->lines_limit;
 	cache_occupancy = _get_cache_occupancy(cache);
 
 	_ocf_stats_zero(usage);
@@ -288,8 +288,10 @@ int ocf_stats_collect_cache(ocf_cache_t cache,
 			_lines4k(info.occupancy, cache_line_size),
 			_lines4k(info.size, cache_line_size));
 
+		/* Lines retiring after shrink may exceed cache size */
 		_set(&usage->free,
-			_lines4k(info.size - info.occupancy, cache_line_size),
+			_lines4k(info.size - OCF_MIN(info.size, info.occupancy),
+					cache_line_size),
 			_lines4k(info.size, cache_line_size));
 
 		_set(&usage->clean,
@@ -312,3 +314,135 @@ int ocf_stats_collect_cache(ocf_cache_t cache,
 
 	return 0;
 }
+
+int ocf_stats_collect_core_latency(ocf_core_t core,
+		struct ocf_stats_latency *latency)
+{
+#if OCF_CONFIG_STATS_LATENCY
+	int shard, i;
+
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(latency);
+
+	ENV_BUG_ON(env_memset(latency, sizeof(*latency), 0));
+
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		for (i = 0; i < ocf_stats_latency_max; i++) {
+			ocf_core_stats_latency_accum(&latency->hist[i],
+					&core->counters[shard].latency[i]);
+		}
+	}
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+int ocf_stats_collect_part_latency(ocf_core_t core, ocf_part_id_t part_id,
+		struct ocf_stats_latency_hist *hist)
+{
+#if OCF_CONFIG_STATS_LATENCY
+	ocf_cache_t cache;
+	int shard;
+
+	OCF_CHECK_NULL(core);
+	OCF_CHECK_NULL(hist);
+
+	if (part_id < OCF_IO_CLASS_ID_MIN || part_id > OCF_IO_CLASS_ID_MAX)
+		return -OCF_ERR_INVAL;
+
+	cache = ocf_core_get_cache(core);
+
+	if (!ocf_part_is_valid(&cache->user_parts[part_id]))
+		return -OCF_ERR_IO_CLASS_NOT_EXIST;
+
+	ENV_BUG_ON(env_memset(hist, sizeof(*hist), 0));
+
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		ocf_core_stats_latency_accum(hist, &core->counters[shard].
+				part_counters[part_id].latency);
+	}
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+int ocf_stats_collect_locks(ocf_cache_t cache, struct ocf_stats_locks *locks)
+{
+#if OCF_CONFIG_STATS_LOCK
+	int i;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(locks);
+
+	ENV_BUG_ON(env_memset(locks, sizeof(*locks), 0));
+
+	for (i = 0; i < ocf_stats_lock_max; i++) {
+		locks->lock[i].contended = env_atomic64_read(
+				&cache->lock_counters[i].contended);
+		locks->lock[i].wait_ns = env_atomic64_read(
+				&cache->lock_counters[i].wait_ns);
+	}
+
+	if (ocf_cache_is_device_attached(cache)) {
+		locks->cache_line_waiters =
+				ocf_cache_concurrency_waiters_total(cache);
+		locks->suspended = ocf_cache_concurrency_suspended_no(cache);
+	}
+
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+/* Hash table entries walked under single metadata lock */
+#define OCF_STATS_HASH_CHUNK (64 * 1024)
+
+int ocf_stats_collect_hash(ocf_cache_t cache, struct ocf_stats_hash *hash)
+{
+	ocf_cache_line_t entry, end, line, invalid;
+	uint32_t len;
+
+	OCF_CHECK_NULL(cache);
+	OCF_CHECK_NULL(hash);
+
+	if (!ocf_cache_is_device_attached(cache))
+		return -OCF_ERR_INVAL;
+
+	ENV_BUG_ON(env_memset(hash, sizeof(*hash), 0));
+
+	hash->entries = cache->device->hash_table_entries;
+	hash->load_factor = cache->conf_meta->hash_load_factor;
+	invalid = cache->device->collision_table_entries;
+
+	for (entry = 0; entry < hash->entries; entry = end) {
+		end = OCF_MIN(entry + OCF_STATS_HASH_CHUNK, hash->entries);
+
+		OCF_METADATA_LOCK_WR();
+		for (; entry < end; entry++) {
+			len = 0;
+			line = ocf_metadata_get_hash(cache, entry);
+			while (line != invalid && len < invalid) {
+				len++;
+				line = ocf_metadata_get_collision_next(cache,
+						line);
+			}
+
+			if (len)
+				hash->used++;
+			hash->lines += len;
+			hash->max_chain = OCF_MAX(hash->max_chain, len);
+			hash->chains[OCF_MIN(len,
+					OCF_STATS_HASH_CHAIN_HIST - 1)]++;
+		}
+		OCF_METADATA_UNLOCK_WR();
+
+		env_cond_resched();
+	}
+
+	return 0;
+}
@@ -23,6 +23,27 @@ struct ocf_counters_req {
 	env_atomic64 pass_through;
 };
 
+#if OCF_CONFIG_STATS_LATENCY
+/**
+ * latency histogram, see struct ocf_stats_latency_hist.
+ */
+struct ocf_counters_latency {
+	env_atomic64 count;
+	env_atomic64 total_ns;
+	env_atomic64 buckets[OCF_STATS_LATENCY_BUCKETS];
+};
+#endif
+
+/**
+ * cleaning statistics of io class, see struct ocf_stats_cleaning.
+ */
+struct ocf_counters_cleaning {
+	env_atomic64 cleaned_clines;
+	env_atomic64 write_bytes;
+	env_atomic64 io_size[OCF_STATS_CLEANING_IO_SIZES];
+	env_atomic64 busy_clines;
+};
+
 /**
  * statistics appropriate for given io class.
  */
@@ -31,18 +52,97 @@ struct ocf_counters_part {
 	struct ocf_counters_req write_reqs;
 
 	struct ocf_counters_block blocks;
+
+	struct ocf_counters_cleaning cleaning;
+#if OCF_CONFIG_STATS_LATENCY
+	struct ocf_counters_latency latency;
+#endif
 };
 
-#ifdef OCF_DEBUG_STATS
-struct ocf_counters_debug {
-	env_atomic64 write_size[IO_PACKET_NO];
-	env_atomic64 read_size[IO_PACKET_NO];
+/**
+ * statistics of cleaner runs, common to all instances.
+ */
+struct ocf_counters_cleaner {
+	env_atomic64 runs;
+	env_atomic64 postponed_runs;
+	env_atomic64 time_ns;
+	env_atomic64 max_time_ns;
+};
+
+/**
+ * eviction statistics of io class, common to all cores.
+ */
+struct ocf_counters_eviction {
+	env_atomic64 evicted_clines;
+	env_atomic64 locked_clines;
+	env_atomic64 dirty_fallbacks;
+	env_atomic64 requests;
+	env_atomic64 time_ns;
+	env_atomic64 max_time_ns;
+};
+
+#if OCF_CONFIG_STATS_LOCK
+/**
+ * contention statistics of lock type, common to all cores.
+ */
+struct ocf_counters_lock {
+	env_atomic64 contended;
+	env_atomic64 wait_ns;
+} __attribute__((aligned(64)));
 
-	env_atomic64 read_align[IO_ALIGN_NO];
-	env_atomic64 write_align[IO_ALIGN_NO];
+/* Account acquisition of lock which had to wait since start_ticks */
+static inline void ocf_stats_lock_contended(struct ocf_counters_lock *stats,
+		uint64_t start_ticks)
+{
+	env_atomic64_inc(&stats->contended);
+	env_atomic64_add(env_ticks_to_nsecs(env_get_tick_count() -
+			start_ticks), &stats->wait_ns);
+}
+#endif
+
+#if OCF_CONFIG_STATS_WINDOW > 0
+/**
+ * recent intervals of io class, common to all cores.
+ */
+struct ocf_stats_window_part {
+	/* Cumulative counters at the end of last interval */
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evicted_clines;
+
+	struct ocf_stats_interval samples[OCF_CONFIG_STATS_WINDOW];
+};
+
+struct ocf_stats_window {
+	env_atomic busy;
+	env_spinlock lock;
+	uint64_t last_ticks;
+	uint32_t head;
+	uint32_t count;
+	struct ocf_stats_window_part parts[OCF_IO_CLASS_MAX];
 };
 #endif
 
+/*
+ * Debug statistics are not atomic. Shard is updated only by I/O queues
+ * mapped to it and loss of single increment on concurrent update is not
+ * worth atomic operation on each I/O.
+ */
+struct ocf_counters_debug {
+	uint64_t write_size[IO_PACKET_NO];
+	uint64_t read_size[IO_PACKET_NO];
+
+	uint64_t read_align[IO_ALIGN_NO];
+	uint64_t write_align[IO_ALIGN_NO];
+};
+
+/* Number of per core statistics counters shards, selected by I/O queue */
+#define OCF_STATS_SHARDS 8
+
+/**
+ * statistics of core updated by I/O queues of single shard. Shards are
+ * summed up when statistics are read.
+ */
 struct ocf_counters_core {
 	struct ocf_counters_block core_blocks;
 	struct ocf_counters_block cache_blocks;
@@ -51,9 +151,30 @@ struct ocf_counters_core {
 	struct ocf_counters_error cache_errors;
 
 	struct ocf_counters_part part_counters[OCF_IO_CLASS_MAX];
-#ifdef OCF_DEBUG_STATS
+#if OCF_CONFIG_STATS_LATENCY
+	struct ocf_counters_latency latency[ocf_stats_latency_max];
+#endif
 	struct ocf_counters_debug debug_stats;
+} __attribute__((aligned(64)));
+
+struct ocf_request;
+
+/* Close statistics window interval if it has elapsed */
+#if OCF_CONFIG_STATS_WINDOW > 0
+void ocf_stats_window_tick(ocf_cache_t cache);
+#else
+static inline void ocf_stats_window_tick(ocf_cache_t cache) {}
+#endif
+
+/* Account latency of completed user request in core statistics */
+#if OCF_CONFIG_STATS_LATENCY
+void ocf_core_stats_latency_update(struct ocf_request *req);
+
+/* Add latency counters of single shard to histogram */
+void ocf_core_stats_latency_accum(struct ocf_stats_latency_hist *dest,
+		const struct ocf_counters_latency *from);
+#else
+static inline void ocf_core_stats_latency_update(struct ocf_request *req) {}
 #endif
-};
 
 #endif
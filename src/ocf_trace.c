@@ -21,10 +21,9 @@ static int _ocf_core_desc(ocf_core_t core, void  *ctx)
 	struct ocf_event_core_desc core_desc;
 	struct core_trace_visitor_ctx *visitor_ctx =
 			(struct core_trace_visitor_ctx *) ctx;
-	ocf_cache_t cache = visitor_ctx->cache;
 
 	ocf_event_init_hdr(&core_desc.hdr, ocf_event_type_core_desc,
-			ocf_trace_seq_id(cache),
+			ocf_trace_seq_id(visitor_ctx->io_queue),
 			env_ticks_to_nsecs(env_get_tick_count()),
 			sizeof(core_desc));
 	core_desc.id = ocf_core_get_id(core);
@@ -44,7 +43,7 @@ static int _ocf_trace_cache_info(ocf_cache_t cache, ocf_queue_t io_queue)
 	struct core_trace_visitor_ctx visitor_ctx;
 
 	ocf_event_init_hdr(&cache_desc.hdr, ocf_event_type_cache_desc,
-			ocf_trace_seq_id(cache),
+			ocf_trace_seq_id(io_queue),
 			env_ticks_to_nsecs(env_get_tick_count()),
 			sizeof(cache_desc));
 
@@ -84,7 +83,7 @@ int ocf_mngt_start_trace(ocf_cache_t cache, void *trace_ctx,
 	if (!trace_callback)
 		return -EINVAL;
 
-	if (cache->trace.trace_callback) {
+	if (ocf_trace_enabled(cache)) {
 		ocf_cache_log(cache, log_err,
 				"Tracing already started for cache %u\n",
 				ocf_cache_get_id(cache));
@@ -113,12 +112,137 @@ int ocf_mngt_start_trace(ocf_cache_t cache, void *trace_ctx,
 	return result;
 }
 
+int ocf_trace_ring_init(ocf_queue_t queue)
+{
+	struct ocf_trace_ring *ring;
+	uint32_t i;
+
+	if (queue->trace_ring)
+		return 0;
+
+	ring = env_vzalloc(sizeof(*ring));
+	if (!ring)
+		return -OCF_ERR_NO_MEM;
+
+	for (i = 0; i < OCF_CONFIG_TRACE_RING_SIZE; i++)
+		env_atomic64_set(&ring->slots[i].seq, i);
+
+	queue->trace_ring = ring;
+
+	return 0;
+}
+
+void ocf_trace_ring_deinit(ocf_queue_t queue)
+{
+	env_vfree(queue->trace_ring);
+	queue->trace_ring = NULL;
+}
+
+int ocf_mngt_start_trace_ring(ocf_cache_t cache)
+{
+	ocf_queue_t queue;
+	int result = 0;
+
+	OCF_CHECK_NULL(cache);
+
+	if (ocf_trace_enabled(cache)) {
+		ocf_cache_log(cache, log_err,
+				"Tracing already started for cache %u\n",
+				ocf_cache_get_id(cache));
+		return -EINVAL;
+	}
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+	list_for_each_entry(queue, &cache->io_queues, list) {
+		result = ocf_trace_ring_init(queue);
+		if (result)
+			break;
+	}
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+
+	if (result)
+		return result;
+
+	cache->trace.trace_ring = true;
+
+	list_for_each_entry(queue, &cache->io_queues, list) {
+		result = _ocf_trace_cache_info(cache, queue);
+		if (result) {
+			cache->trace.trace_ring = false;
+			return result;
+		}
+	}
+
+	ocf_cache_log(cache, log_info, "Tracing to rings started for cache "
+			"%u\n", ocf_cache_get_id(cache));
+
+	return 0;
+}
+
+uint32_t ocf_trace_ring_drain(ocf_queue_t queue, void *buf, uint32_t size)
+{
+	struct ocf_trace_ring *ring;
+	struct ocf_trace_ring_slot *slot;
+	uint32_t copied = 0;
+
+	OCF_CHECK_NULL(queue);
+
+	ring = queue->trace_ring;
+	if (!ring)
+		return 0;
+
+	while (true) {
+		slot = &ring->slots[ring->head &
+				(OCF_CONFIG_TRACE_RING_SIZE - 1)];
+		if (env_atomic64_read(&slot->seq) != ring->head + 1)
+			break;
+
+		if (copied + slot->size > size)
+			break;
+
+		ENV_BUG_ON(env_memcpy(buf + copied, size - copied,
+				&slot->event, slot->size));
+		copied += slot->size;
+
+		/* Slot is free for next lap of producers */
+		env_atomic64_add(OCF_CONFIG_TRACE_RING_SIZE - 1, &slot->seq);
+		ring->head++;
+	}
+
+	return copied;
+}
+
+uint64_t ocf_trace_ring_dropped(ocf_queue_t queue)
+{
+	OCF_CHECK_NULL(queue);
+
+	if (!queue->trace_ring)
+		return 0;
+
+	return env_atomic64_read(&queue->trace_ring->dropped);
+}
+
+void ocf_mngt_trace_req_stages(ocf_cache_t cache, bool enable)
+{
+	OCF_CHECK_NULL(cache);
+
+	cache->trace.req_stages = enable;
+}
+
 int ocf_mngt_stop_trace(ocf_cache_t cache)
 {
 	ocf_queue_t queue;
 
 	OCF_CHECK_NULL(cache);
 
+	if (cache->trace.trace_ring) {
+		/* Rings are kept with queues, so that adapter can drain the
+		 * rest of events
+		 */
+		cache->trace.trace_ring = false;
+		return 0;
+	}
+
 	if (!cache->trace.trace_callback) {
 		ocf_cache_log(cache, log_err,
 				"Tracing not started for cache %u\n",
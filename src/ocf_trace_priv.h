@@ -14,6 +14,49 @@
 #include "ocf_core_priv.h"
 #include "ocf_queue_priv.h"
 
+/*
+ * Trace ring is bounded MPSC queue of fixed size slots. Slot sequence tells
+ * its state: equal to position when free for producer, position + 1 when
+ * holding event for consumer. Producers which find ring full drop event.
+ */
+union ocf_trace_ring_event {
+	struct ocf_event_hdr hdr;
+	struct ocf_event_cache_desc cache_desc;
+	struct ocf_event_core_desc core_desc;
+	struct ocf_event_io io;
+	struct ocf_event_io_cmpl io_cmpl;
+	struct ocf_event_eviction eviction;
+	struct ocf_event_req_stage req_stage;
+};
+
+struct ocf_trace_ring_slot {
+	env_atomic64 seq;
+	uint32_t size;
+	union ocf_trace_ring_event event;
+};
+
+struct ocf_trace_ring {
+	/* Position of next slot to be taken by producer */
+	env_atomic64 tail;
+
+	/* Position of next slot to be drained, consumer only */
+	uint64_t head;
+
+	/* Number of events dropped due to ring being full */
+	env_atomic64 dropped;
+
+	struct ocf_trace_ring_slot slots[OCF_CONFIG_TRACE_RING_SIZE];
+};
+
+int ocf_trace_ring_init(ocf_queue_t queue);
+
+void ocf_trace_ring_deinit(ocf_queue_t queue);
+
+static inline bool ocf_trace_enabled(ocf_cache_t cache)
+{
+	return cache->trace.trace_callback || cache->trace.trace_ring;
+}
+
 static inline bool ocf_is_trace_ongoing(ocf_cache_t cache)
 {
 	ocf_queue_t q;
@@ -35,35 +78,72 @@ static inline void ocf_event_init_hdr(struct ocf_event_hdr *hdr,
 	hdr->size = size;
 }
 
-static inline uint64_t ocf_trace_seq_id(ocf_cache_t cache)
+/* Events are numbered per queue, so that queues don't share counter */
+static inline uint64_t ocf_trace_seq_id(ocf_queue_t queue)
 {
-	return env_atomic64_inc_return(&cache->trace.trace_seq_ref);
+	return env_atomic64_inc_return(&queue->trace_seq);
 }
 
-static inline void ocf_trace_init_io(struct ocf_core_io *io, ocf_cache_t cache)
+/*
+ * IO is tagged with sequence ID and timestamp only once its event is
+ * traced, so untraced IO doesn't pay for reading clock and counter.
+ */
+static inline void ocf_trace_prep_io_event(struct ocf_event_io *ev,
+		struct ocf_io *io, ocf_event_operation_t op)
 {
-	io->timestamp = env_ticks_to_nsecs(env_get_tick_count());
-	io->sid = ocf_trace_seq_id(cache);
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+
+	core_io->timestamp = env_ticks_to_nsecs(env_get_tick_count());
+	core_io->sid = ocf_trace_seq_id(io->io_queue);
+
+	ocf_event_init_hdr(&ev->hdr, ocf_event_type_io, core_io->sid,
+		core_io->timestamp, sizeof(*ev));
+
+	ev->addr = io->addr;
+	ev->len = io->bytes;
+	ev->operation = op;
+	ev->core_id = ocf_core_get_id(ocf_volume_to_core(io->volume));
+	ev->io_class = io->io_class;
+
+	/* Later stage events of request refer to this one. IO forwarded
+	 * to core has no request.
+	 */
+	if (core_io->req)
+		core_io->req->trace_sid = core_io->sid;
 }
 
-static inline void ocf_trace_prep_io_event(struct ocf_event_io *ev,
-		struct ocf_core_io *io, ocf_event_operation_t op)
+static inline void ocf_trace_ring_push(struct ocf_trace_ring *ring,
+		const void *trace, uint32_t size)
 {
-	struct ocf_request *rq = io->req;
+	struct ocf_trace_ring_slot *slot;
+	long pos, seq;
 
-	ocf_event_init_hdr(&ev->hdr, ocf_event_type_io, io->sid,
-		io->timestamp, sizeof(*ev));
+	ENV_BUG_ON(size > sizeof(slot->event));
 
-	ev->addr = rq->byte_position;
-	if (op == ocf_event_operation_discard)
-		ev->len = rq->discard.nr_sects << ENV_SECTOR_SHIFT;
-	else
-		ev->len = rq->byte_length;
+	pos = env_atomic64_read(&ring->tail);
+	while (true) {
+		slot = &ring->slots[pos & (OCF_CONFIG_TRACE_RING_SIZE - 1)];
+		seq = env_atomic64_read(&slot->seq);
 
-	ev->operation = op;
-	ev->core_id = rq->core_id;
+		if (seq == pos) {
+			if (env_atomic64_cmpxchg(&ring->tail, pos, pos + 1) ==
+					pos) {
+				break;
+			}
+		} else if (seq < pos) {
+			/* Consumer didn't drain previous lap of the ring */
+			env_atomic64_inc(&ring->dropped);
+			return;
+		}
+
+		pos = env_atomic64_read(&ring->tail);
+	}
 
-	ev->io_class = rq->io->io_class;
+	ENV_BUG_ON(env_memcpy(&slot->event, sizeof(slot->event), trace, size));
+	slot->size = size;
+
+	/* Publish event to consumer, full barrier orders copy before it */
+	env_atomic64_inc(&slot->seq);
 }
 
 static inline void ocf_trace_push(ocf_queue_t queue, void *trace, uint32_t size)
@@ -76,6 +156,13 @@ static inline void ocf_trace_push(ocf_queue_t queue, void *trace, uint32_t size)
 
 	cache = ocf_queue_get_cache(queue);
 
+	if (cache->trace.trace_ring) {
+		/* Ring lives as long as queue, no reference is needed */
+		if (queue->trace_ring)
+			ocf_trace_ring_push(queue->trace_ring, trace, size);
+		return;
+	}
+
 	if (cache->trace.trace_callback == NULL)
 		return;
 
@@ -103,37 +190,84 @@ static inline void ocf_trace_push(ocf_queue_t queue, void *trace, uint32_t size)
 	env_atomic64_dec(&queue->trace_ref_cntr);
 }
 
-static inline void ocf_trace_io(struct ocf_core_io *io, ocf_event_operation_t dir, ocf_cache_t cache)
+static inline void ocf_trace_io(struct ocf_io *io, ocf_event_operation_t dir,
+		ocf_cache_t cache)
 {
 	struct ocf_event_io ev;
-	struct ocf_request *rq;
 
-	if (!cache->trace.trace_callback)
+	if (likely(!ocf_trace_enabled(cache)))
 		return;
 
-	rq  = io->req;
 	ocf_trace_prep_io_event(&ev, io, dir);
 
-	ocf_trace_push(rq->io_queue, &ev, sizeof(ev));
+	ocf_trace_push(io->io_queue, &ev, sizeof(ev));
 }
 
-static inline void ocf_trace_io_cmpl(struct ocf_core_io *io, ocf_cache_t cache)
+static inline void ocf_trace_io_cmpl(struct ocf_io *io, ocf_cache_t cache)
 {
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
 	struct ocf_event_io_cmpl ev;
-	struct ocf_request *rq;
 
-	if (!cache->trace.trace_callback)
+	if (likely(!ocf_trace_enabled(cache)))
+		return;
+
+	/* IO submitted before tracing was started has no IO event */
+	if (!core_io->sid)
 		return;
 
-	rq = io->req;
 	ocf_event_init_hdr(&ev.hdr, ocf_event_type_io_cmpl,
-			ocf_trace_seq_id(cache),
+			ocf_trace_seq_id(io->io_queue),
+			env_ticks_to_nsecs(env_get_tick_count()),
+			sizeof(ev));
+	ev.rsid = core_io->sid;
+	ev.is_hit = core_io->req ? ocf_engine_is_hit(core_io->req) : false;
+
+	ocf_trace_push(io->io_queue, &ev, sizeof(ev));
+}
+
+static inline void ocf_trace_eviction(struct ocf_request *req,
+		uint32_t requested, uint32_t evicted, uint64_t duration)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_event_eviction ev;
+
+	if (!ocf_trace_enabled(cache))
+		return;
+
+	ocf_event_init_hdr(&ev.hdr, ocf_event_type_eviction,
+			ocf_trace_seq_id(req->io_queue),
+			env_ticks_to_nsecs(env_get_tick_count()),
+			sizeof(ev));
+	ev.core_id = req->core_id;
+	ev.io_class = req->part_id;
+	ev.requested = requested;
+	ev.evicted = evicted;
+	ev.duration = duration;
+
+	ocf_trace_push(req->io_queue, &ev, sizeof(ev));
+}
+
+static inline void ocf_trace_req_stage(struct ocf_request *req,
+		ocf_event_req_stage_t stage, uint32_t value)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_event_req_stage ev;
+
+	if (likely(!cache->trace.req_stages) || !req->trace_sid)
+		return;
+
+	if (!ocf_trace_enabled(cache))
+		return;
+
+	ocf_event_init_hdr(&ev.hdr, ocf_event_type_req_stage,
+			ocf_trace_seq_id(req->io_queue),
 			env_ticks_to_nsecs(env_get_tick_count()),
 			sizeof(ev));
-	ev.rsid = io->sid;
-	ev.is_hit = ocf_engine_is_hit(rq);
+	ev.rsid = req->trace_sid;
+	ev.stage = stage;
+	ev.value = value;
 
-	ocf_trace_push(rq->io_queue, &ev, sizeof(ev));
+	ocf_trace_push(req->io_queue, &ev, sizeof(ev));
 }
 
 #endif /* __OCF_TRACE_PRIV_H__ */
@@ -6,6 +6,7 @@
 #include "ocf/ocf.h"
 #include "ocf_cache_priv.h"
 #include "utils/utils_req.h"
+#include "utils/utils_data.h"
 #include "ocf_utils.h"
 #include "ocf_ctx_priv.h"
 
@@ -23,6 +24,10 @@ int ocf_utils_init(struct ocf_ctx *ocf_ctx)
 	if (!ocf_ctx->resources.core_io_allocator)
 		goto ocf_utils_init_ERROR;
 
+	result = ocf_data_pool_init(ocf_ctx);
+	if (result)
+		goto ocf_utils_init_ERROR;
+
 	return 0;
 
 ocf_utils_init_ERROR:
@@ -34,6 +39,8 @@ ocf_utils_init_ERROR:
 
 void ocf_utils_deinit(struct ocf_ctx *ocf_ctx)
 {
+	ocf_data_pool_deinit(ocf_ctx);
+
 	ocf_req_allocator_deinit(ocf_ctx);
 
 	if (ocf_ctx->resources.core_io_allocator) {
@@ -22,6 +22,7 @@ struct ocf_volume {
 	void *priv;
 	ocf_cache_t cache;
 	struct list_head core_pool_item;
+	struct list_head core_pool_hash_item;
 	struct {
 		unsigned discard_zeroes:1;
 			/* true if reading discarded pages returns 0 */
@@ -52,4 +53,27 @@ static inline void ocf_volume_submit_write_zeroes(struct ocf_io *io)
 	io->volume->type->properties->ops.submit_write_zeroes(io);
 }
 
+static inline void ocf_volume_plug(ocf_volume_t volume)
+{
+	if (volume->type->properties->ops.plug)
+		volume->type->properties->ops.plug(volume);
+}
+
+static inline void ocf_volume_unplug(ocf_volume_t volume)
+{
+	if (volume->type->properties->ops.unplug)
+		volume->type->properties->ops.unplug(volume);
+}
+
+static inline void *ocf_volume_get_direct_mapping(ocf_volume_t volume)
+{
+	if (!volume->opened)
+		return NULL;
+
+	if (!volume->type->properties->ops.get_direct_mapping)
+		return NULL;
+
+	return volume->type->properties->ops.get_direct_mapping(volume);
+}
+
 #endif  /*__OCF_VOLUME_PRIV_H__ */
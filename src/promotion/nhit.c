@@ -0,0 +1,217 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "nhit.h"
+#include "promotion.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_request.h"
+#include "../engine/cache_engine.h"
+#include "promotion_priv.h"
+
+/*
+ * NHIT promotion counts misses of core lines in a direct-mapped table and
+ * inserts a core line into cache only after it was missed insertion_threshold
+ * times within the current window. Window advances each time number of
+ * recorded misses reaches table size, so entries not touched during the
+ * current and previous window are considered expired. Colliding core lines
+ * simply replace each other, which only delays their insertion.
+ *
+ * Each table entry holds 32 bit tag, 16 bit window stamp and 8 bit counter.
+ */
+
+#define NHIT_TABLE_MAX_ENTRIES	(1U << 22)
+#define NHIT_TABLE_MIN_ENTRIES	(1U << 10)
+
+#define NHIT_COUNT_MAX		0xFFU
+#define NHIT_STAMP_MASK		0xFFFFU
+
+#define NHIT_ENTRY(tag, stamp, count) ((long)(((uint64_t)(tag) << 32) | \
+		((uint64_t)((stamp) & NHIT_STAMP_MASK) << 8) | (count)))
+#define NHIT_ENTRY_TAG(entry)	((uint32_t)((uint64_t)(entry) >> 32))
+#define NHIT_ENTRY_STAMP(entry)	(((uint64_t)(entry) >> 8) & NHIT_STAMP_MASK)
+#define NHIT_ENTRY_COUNT(entry)	((uint32_t)((uint64_t)(entry) & NHIT_COUNT_MAX))
+
+static inline struct nhit_promotion_policy *nhit_policy(ocf_cache_t cache)
+{
+	return &cache->promotion.policy.nhit;
+}
+
+static inline uint64_t nhit_hash(ocf_core_id_t core_id, uint64_t core_line)
+{
+	uint64_t z = core_line ^ ((uint64_t)core_id << 48);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+/* Record miss of core line, returns number of misses within window */
+static uint32_t nhit_record_miss(struct nhit_promotion_policy *nhit,
+		ocf_core_id_t core_id, uint64_t core_line)
+{
+	uint64_t hash = nhit_hash(core_id, core_line);
+	env_atomic64 *slot = &nhit->table[hash & (nhit->table_entries - 1)];
+	uint32_t tag = hash >> 32;
+	uint64_t stamp;
+	uint32_t count;
+	long old, new;
+
+	stamp = env_atomic64_inc_return(&nhit->misses) / nhit->table_entries;
+
+	old = env_atomic64_read(slot);
+
+	if (NHIT_ENTRY_TAG(old) == tag && NHIT_ENTRY_COUNT(old) &&
+			((stamp - NHIT_ENTRY_STAMP(old)) & NHIT_STAMP_MASK) <= 1) {
+		count = OCF_MIN(NHIT_ENTRY_COUNT(old) + 1, NHIT_COUNT_MAX);
+	} else {
+		count = 1;
+	}
+
+	new = NHIT_ENTRY(tag, stamp, count);
+
+	/* Lost update only delays insertion, no need to retry */
+	env_atomic64_cmpxchg(slot, old, new);
+
+	return count;
+}
+
+void nhit_setup(ocf_cache_t cache)
+{
+	struct nhit_promotion_policy *nhit = nhit_policy(cache);
+
+	nhit->insertion_threshold = OCF_NHIT_DEFAULT_INSERTION_THRESHOLD;
+	nhit->trigger_threshold = OCF_NHIT_DEFAULT_TRIGGER_THRESHOLD;
+	nhit->table = NULL;
+	nhit->table_entries = 0;
+	env_atomic64_set(&nhit->misses, 0);
+}
+
+/* Largest power of two not exceeding number of cache lines */
+static uint32_t nhit_table_entries(ocf_cache_line_t lines)
+{
+	uint32_t entries = NHIT_TABLE_MIN_ENTRIES;
+
+	while (entries < NHIT_TABLE_MAX_ENTRIES && entries * 2ULL <= lines)
+		entries *= 2;
+
+	return entries;
+}
+
+size_t nhit_size_of(ocf_cache_line_t lines)
+{
+	return sizeof(*((struct nhit_promotion_policy *)0)->table) *
+			nhit_table_entries(lines);
+}
+
+int nhit_attach(ocf_cache_t cache)
+{
+	struct nhit_promotion_policy *nhit = nhit_policy(cache);
+	uint32_t entries;
+
+	ENV_BUG_ON(nhit->table);
+
+	entries = nhit_table_entries(cache->device->collision_table_entries);
+
+	nhit->table = env_vzalloc(sizeof(*nhit->table) * entries);
+	if (!nhit->table) {
+		ocf_cache_log(cache, log_err, "Cannot allocate promotion "
+				"policy table\n");
+		return -OCF_ERR_NO_MEM;
+	}
+
+	nhit->table_entries = entries;
+	env_atomic64_set(&nhit->misses, 0);
+
+	return 0;
+}
+
+void nhit_detach(ocf_cache_t cache)
+{
+	struct nhit_promotion_policy *nhit = nhit_policy(cache);
+
+	if (!nhit->table)
+		return;
+
+	env_vfree(nhit->table);
+	nhit->table = NULL;
+	nhit->table_entries = 0;
+}
+
+int nhit_set_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t param_value)
+{
+	struct nhit_promotion_policy *nhit = nhit_policy(cache);
+
+	switch (param_id) {
+	case ocf_nhit_insertion_threshold:
+		OCF_PROMOTION_CHECK_PARAM(cache, param_value,
+				OCF_NHIT_MIN_INSERTION_THRESHOLD,
+				OCF_NHIT_MAX_INSERTION_THRESHOLD,
+				"insertion_threshold");
+		nhit->insertion_threshold = param_value;
+		break;
+	case ocf_nhit_trigger_threshold:
+		OCF_PROMOTION_CHECK_PARAM(cache, param_value,
+				OCF_NHIT_MIN_TRIGGER_THRESHOLD,
+				OCF_NHIT_MAX_TRIGGER_THRESHOLD,
+				"trigger_threshold");
+		nhit->trigger_threshold = param_value;
+		break;
+	default:
+		return -OCF_ERR_INVAL;
+	}
+
+	return 0;
+}
+
+int nhit_get_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t *param_value)
+{
+	struct nhit_promotion_policy *nhit = nhit_policy(cache);
+
+	switch (param_id) {
+	case ocf_nhit_insertion_threshold:
+		*param_value = nhit->insertion_threshold;
+		break;
+	case ocf_nhit_trigger_threshold:
+		*param_value = nhit->trigger_threshold;
+		break;
+	default:
+		return -OCF_ERR_INVAL;
+	}
+
+	return 0;
+}
+
+bool nhit_req_should_promote(ocf_cache_t cache, struct ocf_request *req)
+{
+	struct nhit_promotion_policy *nhit = nhit_policy(cache);
+	uint64_t entries = cache->device->collision_table_entries;
+	uint64_t occupied = entries - cache->device->freelist_part->curr_size;
+	bool result = true;
+	uint32_t i;
+
+	if (!nhit->table)
+		return true;
+
+	/* Fill the cache before being picky about what goes into it */
+	if (occupied * 100 < entries * nhit->trigger_threshold)
+		return true;
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (req->map[i].status == LOOKUP_HIT)
+			continue;
+
+		/* Record all missed lines, so that next miss counts them */
+		if (nhit_record_miss(nhit, req->core_id,
+				req->core_line_first + i) <
+				nhit->insertion_threshold) {
+			result = false;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __PROMOTION_NHIT_H__
+#define __PROMOTION_NHIT_H__
+
+#include "ocf/ocf.h"
+#include "nhit_structs.h"
+
+struct ocf_request;
+
+void nhit_setup(ocf_cache_t cache);
+int nhit_attach(ocf_cache_t cache);
+size_t nhit_size_of(ocf_cache_line_t lines);
+void nhit_detach(ocf_cache_t cache);
+int nhit_set_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t param_value);
+int nhit_get_param(ocf_cache_t cache, uint32_t param_id,
+		uint32_t *param_value);
+bool nhit_req_should_promote(ocf_cache_t cache, struct ocf_request *req);
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __PROMOTION_NHIT_STRUCTS_H__
+#define __PROMOTION_NHIT_STRUCTS_H__
+
+struct nhit_promotion_policy {
+	uint32_t insertion_threshold;
+	uint32_t trigger_threshold;
+
+	/* Table of recently missed core lines, allocated on attach */
+	env_atomic64 *table;
+	uint32_t table_entries;
+
+	/* Number of misses recorded, determines current window */
+	env_atomic64 misses;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "promotion.h"
+#include "nhit.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_request.h"
+
+struct promotion_policy_ops promotion_policy_ops[ocf_promotion_max] = {
+	[ocf_promotion_always] = {
+		.name = "always",
+	},
+	[ocf_promotion_nhit] = {
+		.setup = nhit_setup,
+		.attach = nhit_attach,
+		.size_of = nhit_size_of,
+		.detach = nhit_detach,
+		.set_param = nhit_set_param,
+		.get_param = nhit_get_param,
+		.req_should_promote = nhit_req_should_promote,
+		.name = "nhit",
+	},
+};
+
+void ocf_promotion_setup(ocf_cache_t cache, ocf_promotion_t type)
+{
+	ENV_BUG_ON(type < 0 || type >= ocf_promotion_max);
+
+	cache->promotion.type = type;
+
+	if (promotion_policy_ops[type].setup)
+		promotion_policy_ops[type].setup(cache);
+}
+
+size_t ocf_promotion_size_of(ocf_cache_t cache, ocf_cache_line_t lines)
+{
+	ocf_promotion_t type = cache->promotion.type;
+
+	if (promotion_policy_ops[type].size_of)
+		return promotion_policy_ops[type].size_of(lines);
+
+	return 0;
+}
+
+int ocf_promotion_attach(ocf_cache_t cache)
+{
+	ocf_promotion_t type = cache->promotion.type;
+
+	if (promotion_policy_ops[type].attach)
+		return promotion_policy_ops[type].attach(cache);
+
+	return 0;
+}
+
+void ocf_promotion_detach(ocf_cache_t cache)
+{
+	ocf_promotion_t type = cache->promotion.type;
+
+	if (promotion_policy_ops[type].detach)
+		promotion_policy_ops[type].detach(cache);
+}
+
+bool ocf_promotion_req_should_promote(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	ocf_promotion_t type = cache->promotion.type;
+
+	if (promotion_policy_ops[type].req_should_promote)
+		return promotion_policy_ops[type].req_should_promote(cache, req);
+
+	return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+#ifndef __LAYER_PROMOTION_POLICY_H__
+#define __LAYER_PROMOTION_POLICY_H__
+
+#include "ocf/ocf.h"
+#include "ocf_env.h"
+#include "nhit_structs.h"
+
+struct ocf_request;
+
+struct promotion_policy {
+	ocf_promotion_t type;
+	union {
+		struct nhit_promotion_policy nhit;
+	} policy;
+};
+
+/*
+ * Promotion policy decides whether missed core lines are inserted into
+ * cache. Requests which are not promoted are served by pass-through.
+ */
+struct promotion_policy_ops {
+	void (*setup)(ocf_cache_t cache);
+	int (*attach)(ocf_cache_t cache);
+	size_t (*size_of)(ocf_cache_line_t lines);
+	void (*detach)(ocf_cache_t cache);
+	int (*set_param)(ocf_cache_t cache, uint32_t param_id,
+			uint32_t param_value);
+	int (*get_param)(ocf_cache_t cache, uint32_t param_id,
+			uint32_t *param_value);
+	bool (*req_should_promote)(ocf_cache_t cache,
+			struct ocf_request *req);
+	const char *name;
+};
+
+extern struct promotion_policy_ops promotion_policy_ops[ocf_promotion_max];
+
+/**
+ * @brief Select promotion policy of cache and set its default parameters
+ *
+ * @param cache - OCF cache instance
+ * @param type - Promotion policy type
+ */
+void ocf_promotion_setup(ocf_cache_t cache, ocf_promotion_t type);
+
+/**
+ * @brief Allocate promotion policy runtime data of attached cache
+ *
+ * @param cache - OCF cache instance
+ * @return 0 - Initialization successful, otherwise ERROR
+ */
+int ocf_promotion_attach(ocf_cache_t cache);
+
+/**
+ * @brief Get memory footprint of promotion policy runtime data allocated on
+ *	attach
+ *
+ * @param cache - OCF cache instance
+ * @param lines - Number of cache lines of cache device
+ * @return Size of runtime data in bytes
+ */
+size_t ocf_promotion_size_of(ocf_cache_t cache, ocf_cache_line_t lines);
+
+/**
+ * @brief Free promotion policy runtime data of attached cache
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_promotion_detach(ocf_cache_t cache);
+
+/**
+ * @brief Check if missed core lines of request should be inserted
+ *
+ * @note Called with hash buckets of request locked
+ *
+ * @param req - OCF request
+ * @return true - map missed core lines, false - serve request from core
+ */
+bool ocf_promotion_req_should_promote(struct ocf_request *req);
+
+#endif
@@ -4,6 +4,7 @@
  */
 
 #include "utils_cache_line.h"
+#include "utils_ram_tier.h"
 
 static inline void ocf_cleaning_set_hot_cache_line(struct ocf_cache *cache,
 		ocf_cache_line_t line)
@@ -18,14 +19,27 @@ static inline void ocf_cleaning_set_hot_cache_line(struct ocf_cache *cache,
 	}
 }
 
+void ocf_invalidate_batch_flush(struct ocf_cache *cache,
+		struct ocf_invalidate_batch *batch)
+{
+	if (!batch->count)
+		return;
+
+	ocf_metadata_sparse_cache_lines(cache, batch->lines, batch->count);
+	batch->count = 0;
+}
+
 static void __set_cache_line_invalid(struct ocf_cache *cache, uint8_t start_bit,
 		uint8_t end_bit, ocf_cache_line_t line,
-		ocf_core_id_t core_id, ocf_part_id_t part_id)
+		ocf_core_id_t core_id, ocf_part_id_t part_id,
+		struct ocf_invalidate_batch *batch)
 {
 	bool is_valid;
 
 	ENV_BUG_ON(core_id >= OCF_CORE_MAX);
 
+	ocf_ram_tier_drop(cache, line);
+
 	if (metadata_clear_valid_sec_changed(cache, line, start_bit, end_bit,
 			&is_valid)) {
 		/*
@@ -43,12 +57,21 @@ static void __set_cache_line_invalid(struct ocf_cache *cache, uint8_t start_bit,
 	 */
 	if (!is_valid && !ocf_cache_line_are_waiters(cache, line)) {
 		ocf_purge_eviction_policy(cache, line);
-		ocf_metadata_sparse_cache_line(cache, line);
+
+		if (!batch) {
+			ocf_metadata_sparse_cache_line(cache, line);
+			return;
+		}
+
+		batch->lines[batch->count++] = line;
+		if (batch->count == OCF_INVALIDATE_BATCH)
+			ocf_invalidate_batch_flush(cache, batch);
 	}
 }
 
 void set_cache_line_invalid(struct ocf_cache *cache, uint8_t start_bit,
-		uint8_t end_bit, struct ocf_request *req, uint32_t map_idx)
+		uint8_t end_bit, struct ocf_request *req, uint32_t map_idx,
+		struct ocf_invalidate_batch *batch)
 {
 	ocf_cache_line_t line = req->map[map_idx].coll_idx;
 	ocf_part_id_t part_id;
@@ -60,14 +83,15 @@ void set_cache_line_invalid(struct ocf_cache *cache, uint8_t start_bit,
 	core_id = req->core_id;
 
 	__set_cache_line_invalid(cache, start_bit, end_bit, line, core_id,
-			part_id);
+			part_id, batch);
 
 	ocf_metadata_flush_mark(cache, req, map_idx, INVALID, start_bit,
 			end_bit);
 }
 
-void set_cache_line_invalid_no_flush(struct ocf_cache *cache, uint8_t start_bit,
-		uint8_t end_bit, ocf_cache_line_t line)
+void set_cache_line_invalid_no_flush_batch(struct ocf_cache *cache,
+		uint8_t start_bit, uint8_t end_bit, ocf_cache_line_t line,
+		struct ocf_invalidate_batch *batch)
 {
 	ocf_part_id_t part_id;
 	ocf_core_id_t core_id;
@@ -75,7 +99,14 @@ void set_cache_line_invalid_no_flush(struct ocf_cache *cache, uint8_t start_bit,
 	ocf_metadata_get_core_and_part_id(cache, line, &core_id, &part_id);
 
 	__set_cache_line_invalid(cache, start_bit, end_bit, line, core_id,
-			part_id);
+			part_id, batch);
+}
+
+void set_cache_line_invalid_no_flush(struct ocf_cache *cache, uint8_t start_bit,
+		uint8_t end_bit, ocf_cache_line_t line)
+{
+	set_cache_line_invalid_no_flush_batch(cache, start_bit, end_bit, line,
+			NULL);
 }
 
 void set_cache_line_valid(struct ocf_cache *cache, uint8_t start_bit,
@@ -113,8 +144,7 @@ void set_cache_line_clean(struct ocf_cache *cache, uint8_t start_bit,
 		 * Update the number of dirty cached data for that
 		 * core object
 		 */
-		if (env_atomic_dec_and_test(&cache->core_runtime_meta[core_id].
-				dirty_clines)) {
+		if (ocf_cache_core_dirty_dec(cache, core_id)) {
 			/*
 			 * If this is last dirty cline reset dirty
 			 * timestamp
@@ -159,7 +189,7 @@ void set_cache_line_dirty(struct ocf_cache *cache, uint8_t start_bit,
 		 * Update the number of dirty cached data for that
 		 * core object
 		 */
-		env_atomic_inc(&cache->core_runtime_meta[core_id].dirty_clines);
+		ocf_cache_core_dirty_inc(cache, core_id);
 
 		/*
 		 * increment dirty clines statistic for given cline
@@ -35,6 +35,12 @@ static inline uint64_t ocf_line_sectors(struct ocf_cache *cache)
 	return cache->metadata.settings.sector_count;
 }
 
+/* Mask of sector offset within cache line */
+static inline uint64_t ocf_line_sector_mask(struct ocf_cache *cache)
+{
+	return cache->metadata.settings.sector_count - 1;
+}
+
 static inline uint64_t ocf_line_end_sector(struct ocf_cache *cache)
 {
 	return cache->metadata.settings.sector_end;
@@ -45,30 +51,69 @@ static inline uint64_t ocf_line_start_sector(struct ocf_cache *cache)
 	return cache->metadata.settings.sector_start;
 }
 
+static inline uint8_t ocf_line_size_shift(struct ocf_cache *cache)
+{
+	return cache->metadata.settings.size_shift;
+}
+
 static inline uint64_t ocf_bytes_round_lines(struct ocf_cache *cache,
 		uint64_t bytes)
 {
-	return (bytes + ocf_line_size(cache) - 1) / ocf_line_size(cache);
+	return (bytes + ocf_line_size(cache) - 1) >> ocf_line_size_shift(cache);
 }
 
 static inline uint64_t ocf_bytes_2_lines(struct ocf_cache *cache,
 		uint64_t bytes)
 {
-	return bytes / ocf_line_size(cache);
+	return bytes >> ocf_line_size_shift(cache);
 }
 
 static inline uint64_t ocf_bytes_2_lines_round_up(
 		struct ocf_cache *cache, uint64_t bytes)
 {
-	return OCF_DIV_ROUND_UP(bytes, ocf_line_size(cache));
+	return ocf_bytes_round_lines(cache, bytes);
 }
 
 static inline uint64_t ocf_lines_2_bytes(struct ocf_cache *cache,
 		uint64_t lines)
 {
-	return lines * ocf_line_size(cache);
+	return lines << ocf_line_size_shift(cache);
+}
+
+/* Byte offset within cache line */
+static inline uint64_t ocf_bytes_line_offset(struct ocf_cache *cache,
+		uint64_t bytes)
+{
+	return bytes & (ocf_line_size(cache) - 1);
 }
 
+/* Number of invalidated cache lines removed from lists at once */
+#define OCF_INVALIDATE_BATCH 32
+
+/**
+ * @brief Cache lines left with no valid sectors, which are removed from
+ *	collision and partition lists and put on free list together
+ */
+struct ocf_invalidate_batch {
+	uint32_t count;
+	ocf_cache_line_t lines[OCF_INVALIDATE_BATCH];
+};
+
+static inline void ocf_invalidate_batch_init(
+		struct ocf_invalidate_batch *batch)
+{
+	batch->count = 0;
+}
+
+/**
+ * @brief Remove cache lines of batch from lists and put them on free list
+ *
+ * @note Caller must hold metadata lock exclusively since cache lines were
+ *	added to batch
+ */
+void ocf_invalidate_batch_flush(struct ocf_cache *cache,
+		struct ocf_invalidate_batch *batch);
+
 /**
  * @brief Set cache line invalid
  *
@@ -77,9 +122,12 @@ static inline uint64_t ocf_lines_2_bytes(struct ocf_cache *cache,
  * @param end_bit End bit of cache line for which state will be set
  * @param req OCF request
  * @param map_idx Array index to map containing cache line to invalid
+ * @param batch Batch collecting cache lines to be removed, NULL to remove
+ *	cache line at once
  */
 void set_cache_line_invalid(struct ocf_cache *cache, uint8_t start_bit,
-		uint8_t end_bit, struct ocf_request *req, uint32_t map_idx);
+		uint8_t end_bit, struct ocf_request *req, uint32_t map_idx,
+		struct ocf_invalidate_batch *batch);
 
 
 /**
@@ -93,6 +141,20 @@ void set_cache_line_invalid(struct ocf_cache *cache, uint8_t start_bit,
 void set_cache_line_invalid_no_flush(struct ocf_cache *cache, uint8_t start_bit,
 		uint8_t end_bit, ocf_cache_line_t line);
 
+/**
+ * @brief Set cache line invalid without flush, removing it from lists
+ *	together with other cache lines of batch
+ *
+ * @param cache Cache instance
+ * @param start_bit Start bit of cache line for which state will be set
+ * @param end_bit End bit of cache line for which state will be set
+ * @param line Cache line to invalid
+ * @param batch Batch collecting cache lines to be removed
+ */
+void set_cache_line_invalid_no_flush_batch(struct ocf_cache *cache,
+		uint8_t start_bit, uint8_t end_bit, ocf_cache_line_t line,
+		struct ocf_invalidate_batch *batch);
+
 /**
  * @brief Set cache line valid
  *
@@ -171,12 +233,12 @@ static inline void ocf_purge_eviction_policy(struct ocf_cache *cache,
  */
 static inline void _ocf_purge_cache_line_sec(struct ocf_cache *cache,
 		uint8_t start, uint8_t stop, struct ocf_request *req,
-		uint32_t map_idx)
+		uint32_t map_idx, struct ocf_invalidate_batch *batch)
 {
 
 	set_cache_line_clean(cache, start, stop, req, map_idx);
 
-	set_cache_line_invalid(cache, start, stop, req, map_idx);
+	set_cache_line_invalid(cache, start, stop, req, map_idx, batch);
 }
 
 /**
@@ -193,6 +255,9 @@ static inline void ocf_purge_map_info(struct ocf_request *req)
 	struct ocf_map_info *map = req->map;
 	struct ocf_cache *cache = req->cache;
 	uint32_t count = req->core_line_count;
+	struct ocf_invalidate_batch batch;
+
+	ocf_invalidate_batch_init(&batch);
 
 	/* Purge range on the basis of map info
 	 *
@@ -212,7 +277,7 @@ static inline void ocf_purge_map_info(struct ocf_request *req)
 			/* First */
 
 			start_bit = BYTES_TO_SECTORS(req->byte_position)
-					% ocf_line_sectors(cache);
+					& ocf_line_sector_mask(cache);
 
 		}
 
@@ -225,8 +290,100 @@ static inline void ocf_purge_map_info(struct ocf_request *req)
 		}
 
 		_ocf_purge_cache_line_sec(cache, start_bit, end_bit, req,
-				map_idx);
+				map_idx, &batch);
+	}
+
+	ocf_invalidate_batch_flush(cache, &batch);
+}
+
+/**
+ * @brief Get range of sectors of map entry cache line covered by request
+ *
+ * @param req - OCF request
+ * @param map_idx - Array index of map entry
+ * @param start - First sector of range
+ * @param stop - Last sector of range
+ */
+static inline void ocf_map_info_sectors(struct ocf_request *req,
+		uint32_t map_idx, uint8_t *start, uint8_t *stop)
+{
+	struct ocf_cache *cache = req->cache;
+
+	*start = 0;
+	*stop = ocf_line_end_sector(cache);
+
+	if (map_idx == 0) {
+		*start = BYTES_TO_SECTORS(req->byte_position)
+				& ocf_line_sector_mask(cache);
 	}
+
+	if (map_idx == req->core_line_count - 1) {
+		*stop = BYTES_TO_SECTORS(req->byte_position +
+				req->byte_length - 1) & ocf_line_sector_mask(cache);
+	}
+}
+
+/**
+ * @brief Find end of run of sectors with the same dirty status
+ *
+ * @param cache - Cache instance
+ * @param line - Cache line
+ * @param start - First sector of run
+ * @param stop - Last sector which may belong to run
+ *
+ * @retval Last sector of run
+ */
+static inline uint8_t ocf_dirty_run_end(struct ocf_cache *cache,
+		ocf_cache_line_t line, uint8_t start, uint8_t stop)
+{
+	bool dirty = metadata_test_dirty_one(cache, line, start);
+	uint8_t end;
+
+	for (end = start; end < stop; end++) {
+		if (metadata_test_dirty_one(cache, line, end + 1) != dirty)
+			break;
+	}
+
+	return end;
+}
+
+/**
+ * @brief Purge clean sectors of request range, keeping dirty ones
+ *
+ * Used instead of ocf_purge_map_info() on error of request which covers
+ * dirty sectors it didn't write, so that they are not lost.
+ *
+ * @param req - OCF request to purge
+ */
+static inline void ocf_purge_clean_map_info(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *map = req->map;
+	struct ocf_invalidate_batch batch;
+	uint32_t map_idx;
+	uint8_t start, stop, end;
+
+	ocf_invalidate_batch_init(&batch);
+
+	for (map_idx = 0; map_idx < req->core_line_count; map_idx++) {
+		if (map[map_idx].status == LOOKUP_MISS)
+			continue;
+
+		ocf_map_info_sectors(req, map_idx, &start, &stop);
+
+		for (; start <= stop; start = end + 1) {
+			end = ocf_dirty_run_end(cache, map[map_idx].coll_idx,
+					start, stop);
+
+			if (!metadata_test_dirty_one(cache,
+					map[map_idx].coll_idx, start)) {
+				_ocf_purge_cache_line_sec(cache, start, end,
+						req, map_idx, &batch);
+			}
+		}
+	}
+
+	ocf_invalidate_batch_flush(cache, &batch);
 }
 
 static inline void ocf_set_valid_map_info(struct ocf_request *req)
@@ -255,7 +412,7 @@ static inline void ocf_set_valid_map_info(struct ocf_request *req)
 			/* First */
 
 			start_bit = BYTES_TO_SECTORS(req->byte_position)
-					% ocf_line_sectors(cache);
+					& ocf_line_sector_mask(cache);
 		}
 
 		if (map_idx == (count - 1)) {
@@ -263,7 +420,7 @@ static inline void ocf_set_valid_map_info(struct ocf_request *req)
 
 			end_bit = BYTES_TO_SECTORS(req->byte_position +
 					req->byte_length - 1)
-					% ocf_line_sectors(cache);
+					& ocf_line_sector_mask(cache);
 		}
 
 		set_cache_line_valid(cache, start_bit, end_bit, req, map_idx);
@@ -293,7 +450,7 @@ static inline void ocf_set_dirty_map_info(struct ocf_request *req)
 			/* First */
 
 			start_bit = BYTES_TO_SECTORS(req->byte_position)
-					% ocf_line_sectors(cache);
+					& ocf_line_sector_mask(cache);
 		}
 
 		if (map_idx == (count - 1)) {
@@ -331,7 +488,7 @@ static inline void ocf_set_clean_map_info(struct ocf_request *req)
 			/* First */
 
 			start_bit = BYTES_TO_SECTORS(req->byte_position)
-					% ocf_line_sectors(cache);
+					& ocf_line_sector_mask(cache);
 		}
 
 		if (map_idx == (count - 1)) {
@@ -0,0 +1,234 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_core_priv.h"
+#include "../ocf_io_priv.h"
+#include "../metadata/metadata.h"
+#include "../metadata/metadata_superblock.h"
+#include "utils_checkpoint.h"
+
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0
+
+void ocf_checkpoint_init(ocf_cache_t cache)
+{
+	env_spinlock_init(&cache->checkpoint.lock);
+	INIT_LIST_HEAD(&cache->checkpoint.held);
+	cache->checkpoint.state = ocf_checkpoint_idle;
+}
+
+/* Caller holds checkpoint lock */
+static void _ocf_checkpoint_open(ocf_cache_t cache)
+{
+	cache->checkpoint.state = ocf_checkpoint_idle;
+	ocf_refcnt_unfreeze(&cache->checkpoint.io);
+}
+
+static void _ocf_checkpoint_disarmed(void *priv, int error)
+{
+	ocf_cache_t cache = priv;
+	struct ocf_core_io *core_io, *next;
+	struct list_head held;
+
+	INIT_LIST_HEAD(&held);
+
+	env_spinlock_lock(&cache->checkpoint.lock);
+	while (!list_empty(&cache->checkpoint.held)) {
+		core_io = list_first_entry(&cache->checkpoint.held,
+				struct ocf_core_io, held);
+		list_move_tail(&core_io->held, &held);
+	}
+	if (error)
+		cache->checkpoint.state = ocf_checkpoint_armed;
+	else
+		_ocf_checkpoint_open(cache);
+	env_spinlock_unlock(&cache->checkpoint.lock);
+
+	if (error) {
+		ocf_cache_log(cache, log_err,
+				"Cannot invalidate metadata checkpoint\n");
+	}
+
+	list_for_each_entry_safe(core_io, next, &held, held) {
+		list_del(&core_io->held);
+		if (error)
+			ocf_io_end(ocf_io_from_priv(core_io), -EIO);
+		else
+			core_io->resume(ocf_io_from_priv(core_io));
+	}
+
+	ocf_refcnt_dec_shard(&cache->pending_requests, 0);
+}
+
+/*
+ * Write superblock with checkpoint marked invalid, which is how it is kept
+ * in memory once it was marked valid. Cache stop waits for it as for
+ * pending request.
+ */
+static void _ocf_checkpoint_disarm(ocf_cache_t cache)
+{
+	ocf_refcnt_inc_shard_force(&cache->pending_requests, 0);
+	ocf_metadata_flush_superblock(cache, _ocf_checkpoint_disarmed, cache);
+}
+
+/*
+ * Called once I/O or background write is refused with checkpoint reference.
+ * Checkpoint being written won't be marked valid, so it is given up. Valid
+ * checkpoint is invalidated. I/O is held meanwhile, if given.
+ *
+ * Returns true if reference is to be refused until checkpoint is
+ * invalidated.
+ */
+static bool _ocf_checkpoint_refused(ocf_cache_t cache,
+		struct ocf_core_io *core_io)
+{
+	bool disarm = false;
+
+	env_spinlock_lock(&cache->checkpoint.lock);
+
+	switch (cache->checkpoint.state) {
+	case ocf_checkpoint_writing:
+		_ocf_checkpoint_open(cache);
+		/* fallthrough */
+	case ocf_checkpoint_idle:
+		env_spinlock_unlock(&cache->checkpoint.lock);
+		return false;
+	case ocf_checkpoint_armed:
+		cache->checkpoint.state = ocf_checkpoint_disarming;
+		disarm = true;
+		break;
+	default:
+		break;
+	}
+
+	if (core_io)
+		list_add_tail(&core_io->held, &cache->checkpoint.held);
+
+	env_spinlock_unlock(&cache->checkpoint.lock);
+
+	if (disarm)
+		_ocf_checkpoint_disarm(cache);
+
+	return true;
+}
+
+bool ocf_checkpoint_get(ocf_cache_t cache, uint32_t id)
+{
+	while (!ocf_refcnt_inc_shard(&cache->checkpoint.io, id)) {
+		if (_ocf_checkpoint_refused(cache, NULL))
+			return false;
+	}
+
+	return true;
+}
+
+void ocf_checkpoint_put(ocf_cache_t cache, uint32_t id)
+{
+	ocf_refcnt_dec_shard(&cache->checkpoint.io, id);
+}
+
+bool ocf_checkpoint_get_io(ocf_cache_t cache, struct ocf_io *io,
+		ocf_checkpoint_resume_t resume)
+{
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+
+	core_io->resume = resume;
+
+	while (!ocf_checkpoint_try_get_io(cache, io)) {
+		if (_ocf_checkpoint_refused(cache, core_io))
+			return false;
+	}
+
+	return true;
+}
+
+static void _ocf_checkpoint_armed(void *priv, int error)
+{
+	ocf_cache_t cache = priv;
+	bool disarm;
+
+	/* Any later superblock write invalidates checkpoint */
+	cache->conf_meta->checkpoint_valid = 0;
+
+	/* Superblock might have been written partially */
+	if (error) {
+		ocf_cache_log(cache, log_warn,
+				"Marking metadata checkpoint valid failed\n");
+	}
+
+	env_spinlock_lock(&cache->checkpoint.lock);
+	disarm = !list_empty(&cache->checkpoint.held);
+	cache->checkpoint.state = disarm ? ocf_checkpoint_disarming :
+			ocf_checkpoint_armed;
+	env_spinlock_unlock(&cache->checkpoint.lock);
+
+	if (disarm)
+		_ocf_checkpoint_disarm(cache);
+
+	cache->checkpoint.cmpl(cache->checkpoint.priv, error);
+}
+
+static void _ocf_checkpoint_written(void *priv, int error)
+{
+	ocf_cache_t cache = priv;
+
+	env_spinlock_lock(&cache->checkpoint.lock);
+
+	if (cache->checkpoint.state != ocf_checkpoint_writing) {
+		env_spinlock_unlock(&cache->checkpoint.lock);
+		cache->checkpoint.cmpl(cache->checkpoint.priv, error);
+		return;
+	}
+
+	/* Requests not submitted by I/O, e.g. cleaning, are still running */
+	if (error || ocf_refcnt_read(&cache->pending_requests)) {
+		_ocf_checkpoint_open(cache);
+		env_spinlock_unlock(&cache->checkpoint.lock);
+		cache->checkpoint.cmpl(cache->checkpoint.priv, error);
+		return;
+	}
+
+	cache->checkpoint.state = ocf_checkpoint_arming;
+	env_spinlock_unlock(&cache->checkpoint.lock);
+
+	cache->conf_meta->checkpoint_valid = 1;
+	ocf_metadata_flush_superblock(cache, _ocf_checkpoint_armed, cache);
+}
+
+/*
+ * Reference counter is frozen before pages are written, so that first I/O
+ * submitted meanwhile gives up marking them valid. Requests still running
+ * once counter is frozen, including ones outliving completed I/O, like
+ * backfill, leave checkpoint unmarked as well.
+ */
+void ocf_checkpoint_write(ocf_cache_t cache, ocf_metadata_end_t cmpl,
+		void *priv)
+{
+	cache->checkpoint.cmpl = cmpl;
+	cache->checkpoint.priv = priv;
+
+	env_spinlock_lock(&cache->checkpoint.lock);
+	if (cache->checkpoint.state == ocf_checkpoint_armed) {
+		/* Nothing changed since checkpoint was marked valid */
+		env_spinlock_unlock(&cache->checkpoint.lock);
+		cmpl(priv, 0);
+		return;
+	}
+
+	if (cache->checkpoint.state == ocf_checkpoint_idle) {
+		cache->checkpoint.state = ocf_checkpoint_writing;
+		ocf_refcnt_freeze(&cache->checkpoint.io);
+		if (ocf_refcnt_read(&cache->checkpoint.io) ||
+				ocf_refcnt_read(&cache->pending_requests)) {
+			_ocf_checkpoint_open(cache);
+		}
+	}
+	env_spinlock_unlock(&cache->checkpoint.lock);
+
+	ocf_metadata_checkpoint(cache, _ocf_checkpoint_written, cache);
+}
+
+#endif
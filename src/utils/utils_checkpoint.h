@@ -0,0 +1,153 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_CHECKPOINT_H__
+#define __UTILS_CHECKPOINT_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_core_priv.h"
+#include "../metadata/metadata.h"
+
+/**
+ * @file utils_checkpoint.h
+ * @brief Metadata checkpoint restored on recovery
+ *
+ * Modified pages of per cache line metadata are written in background. If
+ * no I/O was in flight or submitted while they were written, checkpoint is
+ * marked valid in superblock, so that recovery after dirty shutdown restores
+ * clean cache lines from it instead of dropping them. First I/O submitted
+ * afterwards is held until superblock marking checkpoint invalid is written,
+ * as any I/O may change data of cache lines or core. Checkpoint is
+ * therefore restored only if cache was idle since it was written.
+ *
+ * I/Os and background writes of cache device hold checkpoint reference until
+ * they are done, and counter is frozen while checkpoint is written or valid.
+ */
+
+typedef void (*ocf_checkpoint_resume_t)(struct ocf_io *io);
+
+#if OCF_CONFIG_METADATA_CHECKPOINT_INTERVAL > 0
+/**
+ * @brief Initialize checkpoint state of cache
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_checkpoint_init(ocf_cache_t cache);
+
+/**
+ * @brief Write modified metadata pages and mark them valid checkpoint if
+ *	cache was idle meanwhile
+ *
+ * @param cache - OCF cache instance
+ * @param cmpl - Completion callback
+ * @param priv - Completion context
+ */
+void ocf_checkpoint_write(ocf_cache_t cache, ocf_metadata_end_t cmpl,
+		void *priv);
+
+/**
+ * @brief Take checkpoint reference of background write of cache device
+ *
+ * Checkpoint marked valid is invalidated in background, and caller retries
+ * later.
+ *
+ * @param cache - OCF cache instance
+ * @param id - Reference shard, e.g. I/O queue id
+ *
+ * @retval true Reference taken
+ * @retval false Checkpoint is written or valid
+ */
+bool ocf_checkpoint_get(ocf_cache_t cache, uint32_t id);
+
+/**
+ * @brief Drop checkpoint reference of background write of cache device
+ *
+ * @param cache - OCF cache instance
+ * @param id - Reference shard the reference was taken on
+ */
+void ocf_checkpoint_put(ocf_cache_t cache, uint32_t id);
+
+/**
+ * @brief Take checkpoint reference of I/O or hold I/O until checkpoint is
+ *	invalidated
+ *
+ * @param cache - OCF cache instance
+ * @param io - I/O submitted to core
+ * @param resume - Submission function called for held I/O
+ *
+ * @retval true Reference taken, I/O may be submitted
+ * @retval false I/O is held and will be resumed
+ */
+bool ocf_checkpoint_get_io(ocf_cache_t cache, struct ocf_io *io,
+		ocf_checkpoint_resume_t resume);
+
+/**
+ * @brief Take checkpoint reference of I/O without holding it
+ *
+ * @param cache - OCF cache instance
+ * @param io - I/O submitted to core
+ *
+ * @retval true Reference taken
+ * @retval false Checkpoint is written or valid
+ */
+static inline bool ocf_checkpoint_try_get_io(ocf_cache_t cache,
+		struct ocf_io *io)
+{
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+
+	core_io->checkpoint = ocf_refcnt_inc_shard(&cache->checkpoint.io,
+			io->io_queue->id);
+	return core_io->checkpoint;
+}
+
+/**
+ * @brief Drop checkpoint reference of I/O, if it holds one
+ *
+ * @param cache - OCF cache instance
+ * @param io - I/O submitted to core
+ */
+static inline void ocf_checkpoint_put_io(ocf_cache_t cache, struct ocf_io *io)
+{
+	struct ocf_core_io *core_io = ocf_io_to_core_io(io);
+
+	if (!core_io->checkpoint)
+		return;
+
+	core_io->checkpoint = false;
+	ocf_refcnt_dec_shard(&cache->checkpoint.io, io->io_queue->id);
+}
+#else
+static inline void ocf_checkpoint_init(ocf_cache_t cache)
+{
+}
+
+static inline bool ocf_checkpoint_get(ocf_cache_t cache, uint32_t id)
+{
+	return true;
+}
+
+static inline void ocf_checkpoint_put(ocf_cache_t cache, uint32_t id)
+{
+}
+
+static inline bool ocf_checkpoint_get_io(ocf_cache_t cache, struct ocf_io *io,
+		ocf_checkpoint_resume_t resume)
+{
+	return true;
+}
+
+static inline bool ocf_checkpoint_try_get_io(ocf_cache_t cache,
+		struct ocf_io *io)
+{
+	return true;
+}
+
+static inline void ocf_checkpoint_put_io(ocf_cache_t cache, struct ocf_io *io)
+{
+}
+#endif
+
+#endif /* __UTILS_CHECKPOINT_H__ */
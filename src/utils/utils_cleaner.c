@@ -11,6 +11,8 @@
 #include "utils_req.h"
 #include "utils_io.h"
 #include "utils_cache_line.h"
+#include "utils_sort.h"
+#include "utils_part.h"
 
 #define OCF_UTILS_CLEANER_DEBUG 0
 
@@ -31,6 +33,122 @@
 #define OCF_DEBUG_PARAM(cache, format, ...)
 #endif
 
+/* Max number of cache lines of single cleaning request */
+#define OCF_CLEANER_REQ_MAX_LINES	128
+
+static ctx_data_t *_ocf_cleaner_data_alloc(struct ocf_cache *cache,
+		uint32_t count)
+{
+	ctx_data_t *data;
+
+	data = ctx_data_alloc(cache->owner,
+			ocf_line_size(cache) / PAGE_SIZE * count);
+	if (!data)
+		return NULL;
+
+	if (ctx_data_mlock(cache->owner, data)) {
+		ctx_data_free(cache->owner, data);
+		return NULL;
+	}
+
+	return data;
+}
+
+static void _ocf_cleaner_data_free(struct ocf_cache *cache, ctx_data_t *data)
+{
+	ctx_data_secure_erase(cache->owner, data);
+	ctx_data_munlock(cache->owner, data);
+	ctx_data_free(cache->owner, data);
+}
+
+void ocf_cleaner_pool_set_batch(ocf_cache_t cache, uint32_t batch)
+{
+	struct ocf_cleaner_pool *pool = &cache->cleaner.pool;
+	ctx_data_t *drop[OCF_CLEANER_POOL_SIZE_MAX];
+	uint32_t lines, capacity, i, count = 0;
+
+	lines = OCF_MIN(batch, (uint32_t)OCF_CLEANER_REQ_MAX_LINES);
+	capacity = lines ? OCF_DIV_ROUND_UP(batch, lines) *
+			cache->cleaner.count : 0;
+	capacity = OCF_MIN(capacity, (uint32_t)OCF_CLEANER_POOL_SIZE_MAX);
+
+	env_spinlock_lock(&pool->lock);
+
+	if (pool->lines == lines && pool->capacity == capacity) {
+		env_spinlock_unlock(&pool->lock);
+		return;
+	}
+
+	/* Buffers of different size can't be reused */
+	if (pool->lines != lines) {
+		while (pool->count)
+			drop[count++] = pool->data[--pool->count];
+	}
+
+	while (pool->count > capacity)
+		drop[count++] = pool->data[--pool->count];
+
+	pool->lines = lines;
+	pool->capacity = capacity;
+
+	env_spinlock_unlock(&pool->lock);
+
+	for (i = 0; i < count; i++)
+		_ocf_cleaner_data_free(cache, drop[i]);
+}
+
+void ocf_cleaner_pool_drain(ocf_cache_t cache)
+{
+	ocf_cleaner_pool_set_batch(cache, 0);
+}
+
+/*
+ * Take data buffer from pool, or allocate new one of pooled size so that
+ * it can be returned to pool
+ */
+static ctx_data_t *_ocf_cleaner_data_get(struct ocf_request *req,
+		uint32_t count)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_cleaner_pool *pool = &cache->cleaner.pool;
+	ctx_data_t *data = NULL;
+	uint32_t lines;
+
+	env_spinlock_lock(&pool->lock);
+	lines = pool->lines;
+	if (count <= lines && pool->count)
+		data = pool->data[--pool->count];
+	env_spinlock_unlock(&pool->lock);
+
+	if (count <= lines) {
+		req->info.cleaner_pooled_data = true;
+		req->cleaner_pool_lines = lines;
+		return data ?: _ocf_cleaner_data_alloc(cache, lines);
+	}
+
+	return _ocf_cleaner_data_alloc(cache, count);
+}
+
+static void _ocf_cleaner_data_put(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_cleaner_pool *pool = &cache->cleaner.pool;
+	bool pooled = false;
+
+	if (req->info.cleaner_pooled_data) {
+		env_spinlock_lock(&pool->lock);
+		if (pool->lines == req->cleaner_pool_lines &&
+				pool->count < pool->capacity) {
+			pool->data[pool->count++] = req->data;
+			pooled = true;
+		}
+		env_spinlock_unlock(&pool->lock);
+	}
+
+	if (!pooled)
+		_ocf_cleaner_data_free(cache, req->data);
+}
+
 /*
  * Allocate cleaning request
  */
@@ -39,7 +157,6 @@ static struct ocf_request *_ocf_cleaner_alloc_req(struct ocf_cache *cache,
 {
 	struct ocf_request *req = ocf_req_new_extended(attribs->io_queue, NULL,
 			0, count * ocf_line_size(cache), OCF_READ);
-	int ret;
 
 	if (!req)
 		return NULL;
@@ -47,21 +164,13 @@ static struct ocf_request *_ocf_cleaner_alloc_req(struct ocf_cache *cache,
 	req->info.internal = true;
 	req->info.cleaner_cache_line_lock = attribs->cache_line_lock;
 
-	/* Allocate pages for cleaning IO */
-	req->data = ctx_data_alloc(cache->owner,
-			ocf_line_size(cache) / PAGE_SIZE * count);
+	/* Get pages for cleaning IO */
+	req->data = _ocf_cleaner_data_get(req, count);
 	if (!req->data) {
 		ocf_req_put(req);
 		return NULL;
 	}
 
-	ret = ctx_data_mlock(cache->owner, req->data);
-	if (ret) {
-		ctx_data_free(cache->owner, req->data);
-		ocf_req_put(req);
-		return NULL;
-	}
-
 	return req;
 }
 
@@ -140,9 +249,7 @@ static void _ocf_cleaner_dealloc_req(struct ocf_request *req)
 		ENV_BUG();
 	}
 
-	ctx_data_secure_erase(req->cache->owner, req->data);
-	ctx_data_munlock(req->cache->owner, req->data);
-	ctx_data_free(req->cache->owner, req->data);
+	_ocf_cleaner_data_put(req);
 	ocf_req_put(req);
 }
 
@@ -221,18 +328,29 @@ static void _ocf_cleaner_cache_line_unlock(struct ocf_request *req)
 	}
 }
 
-static bool _ocf_cleaner_sector_is_dirty(struct ocf_cache *cache,
-		ocf_cache_line_t line, uint8_t sector)
+/*
+ * Find next range of dirty sectors of cache line, starting at or after
+ * sector *begin. Returns false if there is none.
+ */
+static bool _ocf_cleaner_dirty_range(struct ocf_cache *cache,
+		ocf_cache_line_t line, uint64_t *begin, uint64_t *end)
 {
-	bool dirty = metadata_test_dirty_one(cache, line, sector);
-	bool valid = metadata_test_valid_one(cache, line, sector);
+	uint64_t i, sectors = ocf_line_sectors(cache);
 
-	if (!valid && dirty) {
-		/* not valid but dirty - IMPROPER STATE!!! */
-		ENV_BUG();
-	}
+	if (*begin >= sectors)
+		return false;
+
+	i = metadata_find_dirty_sec(cache, line, *begin, true);
+	if (i >= sectors)
+		return false;
+
+	*begin = i;
+	*end = metadata_find_dirty_sec(cache, line, i, false);
 
-	return valid ? dirty : false;
+	/* not valid but dirty - IMPROPER STATE!!! */
+	ENV_BUG_ON(!metadata_test_valid_sec(cache, line, *begin, *end - 1));
+
+	return true;
 }
 
 static void _ocf_cleaner_finish_req(struct ocf_request *req)
@@ -290,6 +408,31 @@ static const struct ocf_io_if _io_if_flush_cache = {
 	.write = _ocf_cleaner_fire_flush_cache,
 };
 
+/* Cleaning statistics of IO class of core, updated on queue of request */
+static struct ocf_counters_cleaning *_ocf_cleaner_stats(
+		struct ocf_request *req, ocf_core_id_t core_id,
+		ocf_part_id_t part_id)
+{
+	return &ocf_core_stats(&req->cache->core[core_id], req->io_queue)->
+			part_counters[part_id].cleaning;
+}
+
+/* Account core write of cleaning in I/O size distribution */
+static void _ocf_cleaner_account_write(struct ocf_counters_cleaning *stats,
+		uint64_t bytes)
+{
+	uint64_t size = 4 * KiB;
+	int idx = 0;
+
+	while (bytes > size && idx < OCF_STATS_CLEANING_IO_SIZES - 1) {
+		size <<= 1;
+		idx++;
+	}
+
+	env_atomic64_add(bytes, &stats->write_bytes);
+	env_atomic64_inc(&stats->io_size[idx]);
+}
+
 static void _ocf_cleaner_metadata_io_end(struct ocf_request *req, int error)
 {
 	if (error) {
@@ -335,6 +478,9 @@ static int _ocf_cleaner_update_metadata(struct ocf_request *req)
 
 		set_cache_line_clean(cache, 0, ocf_line_end_sector(cache), req,
 				i);
+
+		env_atomic64_inc(&_ocf_cleaner_stats(req, req->core_id,
+				req->part_id)->cleaned_clines);
 	}
 
 	ocf_metadata_flush_do_asynch(cache, req, _ocf_cleaner_metadata_io_end);
@@ -455,125 +601,355 @@ static void _ocf_cleaner_core_io_end(struct ocf_request *req)
 	ocf_engine_push_req_front(req, true);
 }
 
+/*
+ * Take slot of in-flight core write. If core has no free slot, request is
+ * added to waiters of core and resumed once one of core writes completes.
+ */
+static bool _ocf_cleaner_core_slot_get(ocf_core_t core,
+		struct ocf_request *req)
+{
+	struct ocf_core_writeback *wb = &core->writeback;
+	bool taken = true;
+
+	env_spinlock_lock(&wb->lock);
+	if (wb->max_inflight && env_atomic_read(&wb->inflight) >=
+			wb->max_inflight) {
+		list_add_tail(&req->list, &wb->waiters);
+		taken = false;
+	} else {
+		env_atomic_inc(&wb->inflight);
+	}
+	env_spinlock_unlock(&wb->lock);
+
+	return taken;
+}
+
+static void _ocf_cleaner_core_slot_put(ocf_core_t core)
+{
+	struct ocf_core_writeback *wb = &core->writeback;
+	struct ocf_request *req = NULL;
+
+	env_spinlock_lock(&wb->lock);
+	env_atomic_dec(&wb->inflight);
+	if (!list_empty(&wb->waiters)) {
+		req = list_first_entry(&wb->waiters, struct ocf_request, list);
+		list_del(&req->list);
+	}
+	env_spinlock_unlock(&wb->lock);
+
+	if (req)
+		ocf_engine_push_req_front(req, true);
+}
+
+void ocf_cleaner_core_init(ocf_core_t core)
+{
+	struct ocf_core_writeback *wb = &core->writeback;
+
+	env_spinlock_init(&wb->lock);
+	INIT_LIST_HEAD(&wb->waiters);
+	env_atomic_set(&wb->inflight, 0);
+	wb->max_inflight = 0;
+	wb->max_io_size = 0;
+}
+
+void ocf_cleaner_core_set_limits(ocf_core_t core, uint32_t max_inflight,
+		uint32_t max_io_size)
+{
+	struct ocf_core_writeback *wb = &core->writeback;
+	struct list_head waiters;
+	struct ocf_request *req, *tmp;
+
+	INIT_LIST_HEAD(&waiters);
+
+	env_spinlock_lock(&wb->lock);
+	wb->max_inflight = max_inflight;
+	wb->max_io_size = max_io_size;
+	/* Waiters recheck new limit */
+	list_for_each_entry_safe(req, tmp, &wb->waiters, list)
+		list_move_tail(&req->list, &waiters);
+	env_spinlock_unlock(&wb->lock);
+
+	list_for_each_entry_safe(req, tmp, &waiters, list) {
+		list_del(&req->list);
+		ocf_engine_push_req_front(req, true);
+	}
+}
+
+#if OCF_CONFIG_ZERO_LINES
+/*
+ * Dirty sectors of zero line are not read from cache. They are written to
+ * core with write-zeroes, or with zeroes copied to request data if core
+ * volume doesn't support it.
+ */
+static bool _ocf_cleaner_zero_line(struct ocf_request *req,
+		struct ocf_map_info *iter)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_volume_t volume = &cache->core[iter->core_id].volume;
+
+	iter->zero = false;
+
+	if (!ocf_metadata_get_zero(cache, iter->coll_idx))
+		return false;
+
+	if (volume->type->properties->ops.submit_write_zeroes) {
+		iter->zero = true;
+	} else {
+		ctx_data_cpy(cache->owner, req->data, cache->zero_lines.data,
+				ocf_line_size(cache) * iter->hash_key, 0,
+				ocf_line_size(cache));
+	}
+
+	return true;
+}
+
+static inline bool _ocf_cleaner_map_zero(struct ocf_map_info *iter)
+{
+	return iter->zero;
+}
+#else
+static inline bool _ocf_cleaner_zero_line(struct ocf_request *req,
+		struct ocf_map_info *iter)
+{
+	return false;
+}
+
+static inline bool _ocf_cleaner_map_zero(struct ocf_map_info *iter)
+{
+	return false;
+}
+#endif
+
 static void _ocf_cleaner_core_io_cmpl(struct ocf_io *io, int error)
 {
 	struct ocf_map_info *map = io->priv1;
 	struct ocf_request *req = io->priv2;
+	ocf_core_t core = &req->cache->core[map->core_id];
+	uint64_t i, lines;
 
 	if (error) {
-		map->invalid |= 1;
+		/* Core write may span several cache lines */
+		lines = (io->addr + io->bytes - 1) / ocf_line_size(req->cache) -
+				map->core_line + 1;
+		for (i = 0; i < lines; i++)
+			map[i].invalid |= 1;
+
 		_ocf_cleaner_set_error(req);
-		env_atomic_inc(&req->cache->core[map->core_id].counters->
-				core_errors.write);
+		env_atomic_inc(&ocf_core_stats(core,
+				req->io_queue)->core_errors.write);
 	}
 
-	_ocf_cleaner_core_io_end(req);
-
 	ocf_io_put(io);
+
+	_ocf_cleaner_core_slot_put(core);
+	_ocf_cleaner_core_io_end(req);
 }
 
-static void _ocf_cleaner_core_io_for_dirty_range(struct ocf_request *req,
-		struct ocf_map_info *iter, uint64_t begin, uint64_t end)
+/*
+ * Dirty sectors range to be written to core. It starts at given sector of
+ * first cache line and may span consecutive entries of request map, which
+ * are contiguous both on core and in request data.
+ */
+struct ocf_cleaner_core_range {
+	struct ocf_map_info *first;
+	uint64_t begin;
+	uint64_t count;
+	uint64_t max_count;
+};
+
+/*
+ * Returns false if request waits for free slot of core write. Request is
+ * resumed from the range then and must not be accessed by caller anymore.
+ */
+static bool _ocf_cleaner_core_io_for_dirty_range(struct ocf_request *req,
+		struct ocf_cleaner_core_range *range)
 {
 	uint64_t addr, offset;
 	int err;
 	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *iter = range->first;
+	ocf_core_t core = &cache->core[iter->core_id];
 	struct ocf_io *io;
 	struct ocf_counters_block *core_stats =
-		&cache->core[iter->core_id].counters->core_blocks;
+		&ocf_core_stats(core, req->io_queue)->core_blocks;
 	ocf_part_id_t part_id = ocf_metadata_get_partition_id(cache,
 			iter->coll_idx);
+	uint64_t i, lines;
+
+	req->cleaner_resume_line = iter - req->map;
+	req->cleaner_resume_sector = range->begin;
+
+	if (!_ocf_cleaner_core_slot_get(core, req))
+		return false;
 
 	io = ocf_new_core_io(cache, iter->core_id);
 	if (!io)
 		goto error;
 
 	addr = (ocf_line_size(cache) * iter->core_line)
-			+ SECTORS_TO_BYTES(begin);
+			+ SECTORS_TO_BYTES(range->begin);
 	offset = (ocf_line_size(cache) * iter->hash_key)
-			+ SECTORS_TO_BYTES(begin);
+			+ SECTORS_TO_BYTES(range->begin);
 
-	ocf_io_configure(io, addr, SECTORS_TO_BYTES(end - begin), OCF_WRITE,
+	ocf_io_configure(io, addr, SECTORS_TO_BYTES(range->count), OCF_WRITE,
 			part_id, 0);
 	ocf_io_set_queue(io, req->io_queue);
-	err = ocf_io_set_data(io, req->data, offset);
-	if (err) {
-		ocf_io_put(io);
-		goto error;
+	if (!_ocf_cleaner_map_zero(iter)) {
+		err = ocf_io_set_data(io, req->data, offset);
+		if (err) {
+			ocf_io_put(io);
+			goto error;
+		}
 	}
 
 	ocf_io_set_cmpl(io, iter, req, _ocf_cleaner_core_io_cmpl);
 
-	env_atomic64_add(SECTORS_TO_BYTES(end - begin), &core_stats->write_bytes);
+	env_atomic64_add(SECTORS_TO_BYTES(range->count),
+			&core_stats->write_bytes);
+	_ocf_cleaner_account_write(_ocf_cleaner_stats(req, iter->core_id,
+			part_id), SECTORS_TO_BYTES(range->count));
 
 	OCF_DEBUG_PARAM(req->cache, "Core write, line = %llu, "
-			"sector = %llu, count = %llu", iter->core_line, begin,
-			end - begin);
+			"sector = %llu, count = %llu", iter->core_line,
+			range->begin, range->count);
 
 	/* Increase IO counter to be processed */
 	env_atomic_inc(&req->req_remaining);
 
 	/* Send IO */
-	ocf_volume_submit_io(io);
+	if (_ocf_cleaner_map_zero(iter))
+		ocf_volume_submit_write_zeroes(io);
+	else
+		ocf_volume_submit_io(io);
 
-	return;
+	return true;
 error:
-	iter->invalid = true;
+	lines = (range->begin + range->count - 1) / ocf_line_sectors(cache) + 1;
+	for (i = 0; i < lines; i++)
+		iter[i].invalid = true;
 	_ocf_cleaner_set_error(req);
+	_ocf_cleaner_core_slot_put(core);
+	return true;
 }
 
-static void _ocf_cleaner_core_submit_io(struct ocf_request *req,
-		struct ocf_map_info *iter)
+static bool _ocf_cleaner_core_range_extends(struct ocf_cache *cache,
+		struct ocf_cleaner_core_range *range, struct ocf_map_info *iter,
+		uint64_t begin, uint64_t end)
 {
-	uint64_t i, dirty_start = 0;
-	struct ocf_cache *cache = req->cache;
-	bool counting_dirty = false;
+	struct ocf_map_info *first = range->first;
+	uint64_t lines = iter - first;
 
-	/* Check integrity of entry to be cleaned */
-	if (metadata_test_valid(cache, iter->coll_idx)
-		&& metadata_test_dirty(cache, iter->coll_idx)) {
+	if (iter->core_id != first->core_id)
+		return false;
 
-		_ocf_cleaner_core_io_for_dirty_range(req, iter, 0,
-				ocf_line_sectors(cache));
+	if (_ocf_cleaner_map_zero(iter) != _ocf_cleaner_map_zero(first))
+		return false;
 
-		return;
+	if (iter->core_line != first->core_line + lines ||
+			iter->hash_key != first->hash_key + lines) {
+		return false;
 	}
 
-	/* Sector cleaning, a little effort is required to this */
-	for (i = 0; i < ocf_line_sectors(cache); i++) {
-		if (!_ocf_cleaner_sector_is_dirty(cache, iter->coll_idx, i)) {
-			if (counting_dirty) {
-				counting_dirty = false;
-				_ocf_cleaner_core_io_for_dirty_range(req, iter,
-						dirty_start, i);
-			}
+	/* Range has to end exactly where new one starts */
+	if (range->begin + range->count !=
+			lines * ocf_line_sectors(cache) + begin) {
+		return false;
+	}
 
-			continue;
+	return range->count + (end - begin) <= range->max_count;
+}
+
+static bool _ocf_cleaner_core_range_add(struct ocf_request *req,
+		struct ocf_cleaner_core_range *range, struct ocf_map_info *iter,
+		uint64_t begin, uint64_t end)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_core_t core = &cache->core[iter->core_id];
+	uint64_t max_io_size;
+	ocf_core_id_t core_id;
+
+	if (range->first && _ocf_cleaner_core_range_extends(cache, range,
+			iter, begin, end)) {
+		range->count += end - begin;
+		return true;
+	}
+
+	if (range->first) {
+		core_id = range->first->core_id;
+		if (!_ocf_cleaner_core_io_for_dirty_range(req, range)) {
+			ocf_volume_unplug(&cache->core[core_id].volume);
+			return false;
 		}
+	}
 
-		if (!counting_dirty) {
-			counting_dirty = true;
-			dirty_start = i;
+	/* Keep volume of core of current range plugged */
+	if (!range->first || range->first->core_id != iter->core_id) {
+		if (range->first) {
+			ocf_volume_unplug(
+				&cache->core[range->first->core_id].volume);
 		}
+		ocf_volume_plug(&core->volume);
+	}
 
+	range->first = iter;
+	range->begin = begin;
+	range->count = end - begin;
+
+	/* Single cache line is written at once regardless of volume limit */
+	max_io_size = ocf_volume_get_max_io_size(&core->volume);
+	if (core->writeback.max_io_size) {
+		max_io_size = OCF_MIN(max_io_size,
+				(uint64_t)core->writeback.max_io_size);
 	}
+	range->max_count = OCF_MAX(BYTES_TO_SECTORS(max_io_size),
+			(uint64_t)ocf_line_sectors(cache));
 
-	if (counting_dirty)
-		_ocf_cleaner_core_io_for_dirty_range(req, iter, dirty_start, i);
+	return true;
 }
 
+static bool _ocf_cleaner_core_submit_io(struct ocf_request *req,
+		struct ocf_cleaner_core_range *range, struct ocf_map_info *iter,
+		uint64_t begin)
+{
+	uint64_t end;
+	struct ocf_cache *cache = req->cache;
+
+	/* Check integrity of entry to be cleaned */
+	if (begin == 0 && metadata_test_valid(cache, iter->coll_idx)
+		&& metadata_test_dirty(cache, iter->coll_idx)) {
+
+		return _ocf_cleaner_core_range_add(req, range, iter, 0,
+				ocf_line_sectors(cache));
+	}
+
+	/* Sector cleaning, a little effort is required to this */
+	for (; _ocf_cleaner_dirty_range(cache, iter->coll_idx,
+			&begin, &end); begin = end) {
+		if (!_ocf_cleaner_core_range_add(req, range, iter, begin, end))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Submits writes to the core, merging contiguous dirty ranges. When core
+ * has no free slot of in-flight write, request is parked and this function
+ * is called again from the position stored in request.
+ */
 static int _ocf_cleaner_fire_core(struct ocf_request *req)
 {
-	uint32_t i;
+	uint32_t i = req->cleaner_resume_line;
+	uint64_t begin = req->cleaner_resume_sector;
 	struct ocf_map_info *iter;
+	struct ocf_cleaner_core_range range = { .first = NULL };
+	struct ocf_cache *cache = req->cache;
+	ocf_core_id_t core_id;
+	bool parked;
 
 	OCF_DEBUG_TRACE(req->cache);
 
-	/* Protect IO completion race */
-	env_atomic_set(&req->req_remaining, 1);
-
-	/* Submits writes to the core */
-	for (i = 0; i < req->core_line_count; i++) {
+	for (; i < req->core_line_count; i++, begin = 0) {
 		iter = &(req->map[i]);
 
 		if (iter->invalid) {
@@ -584,7 +960,16 @@ static int _ocf_cleaner_fire_core(struct ocf_request *req)
 		if (iter->status == LOOKUP_MISS)
 			continue;
 
-		_ocf_cleaner_core_submit_io(req, iter);
+		if (!_ocf_cleaner_core_submit_io(req, &range, iter, begin))
+			return 0;
+	}
+
+	if (range.first) {
+		core_id = range.first->core_id;
+		parked = !_ocf_cleaner_core_io_for_dirty_range(req, &range);
+		ocf_volume_unplug(&cache->core[core_id].volume);
+		if (parked)
+			return 0;
 	}
 
 	/* Protect IO completion race */
@@ -607,6 +992,11 @@ static void _ocf_cleaner_cache_io_end(struct ocf_request *req)
 	 * All cache read requests done, now we can submit writes to cores,
 	 * Move processing to thread, where IO will be (and can be) submitted
 	 */
+	/* Protect IO completion race */
+	env_atomic_set(&req->req_remaining, 1);
+	req->cleaner_resume_line = 0;
+	req->cleaner_resume_sector = 0;
+
 	req->io_if = &_io_if_fire_core;
 	ocf_engine_push_req_front(req, true);
 
@@ -621,8 +1011,8 @@ static void _ocf_cleaner_cache_io_cmpl(struct ocf_io *io, int error)
 	if (error) {
 		map->invalid |= 1;
 		_ocf_cleaner_set_error(req);
-		env_atomic_inc(&req->cache->core[map->core_id].counters->
-				cache_errors.read);
+		env_atomic_inc(&ocf_core_stats(&req->cache->core[map->core_id],
+				req->io_queue)->cache_errors.read);
 	}
 
 	_ocf_cleaner_cache_io_end(req);
@@ -630,70 +1020,104 @@ static void _ocf_cleaner_cache_io_cmpl(struct ocf_io *io, int error)
 	ocf_io_put(io);
 }
 
-/*
- * cleaner - Traverse cache lines to be cleaned, detect sequential IO, and
- * perform cache reads and core writes
- */
-static int _ocf_cleaner_fire_cache(struct ocf_request *req)
+static void _ocf_cleaner_cache_io_for_range(struct ocf_request *req,
+		struct ocf_map_info *iter, uint64_t begin, uint64_t end)
 {
 	struct ocf_cache *cache = req->cache;
-	uint32_t i;
-	struct ocf_map_info *iter = req->map;
+	struct ocf_counters_block *cache_stats =
+		&ocf_core_stats(&cache->core[iter->core_id],
+			req->io_queue)->cache_blocks;
 	uint64_t addr, offset;
 	ocf_part_id_t part_id;
 	struct ocf_io *io;
 	int err;
-	struct ocf_counters_block *cache_stats;
 
-	/* Protect IO completion race */
+	io = ocf_new_cache_io(cache);
+	if (!io)
+		goto error;
+
+	OCF_DEBUG_PARAM(req->cache, "Cache read, line = %u, sector = %llu, "
+			"count = %llu", iter->coll_idx, begin, end - begin);
+
+	addr = ocf_metadata_map_lg2phy(cache,
+			iter->coll_idx);
+	addr *= ocf_line_size(cache);
+	addr += cache->device->metadata_offset;
+	addr += SECTORS_TO_BYTES(begin);
+
+	offset = ocf_line_size(cache) * iter->hash_key;
+	offset += SECTORS_TO_BYTES(begin);
+
+	part_id = ocf_metadata_get_partition_id(cache, iter->coll_idx);
+
+	ocf_io_set_cmpl(io, iter, req, _ocf_cleaner_cache_io_cmpl);
+	ocf_io_configure(io, addr, SECTORS_TO_BYTES(end - begin), OCF_READ,
+			part_id, 0);
+	ocf_io_set_queue(io, req->io_queue);
+	err = ocf_io_set_data(io, req->data, offset);
+	if (err) {
+		ocf_io_put(io);
+		goto error;
+	}
+
+	env_atomic64_add(SECTORS_TO_BYTES(end - begin),
+			&cache_stats->read_bytes);
+
+	/* Dirty data has to be cleaned anyway, so it's only accounted */
+	ocf_part_qos_charge(cache, part_id, SECTORS_TO_BYTES(end - begin));
+
+	/* Increase IO counter to be processed */
 	env_atomic_inc(&req->req_remaining);
 
+	ocf_volume_submit_io(io);
+
+	return;
+error:
+	iter->invalid = true;
+	_ocf_cleaner_set_error(req);
+}
+
+/*
+ * cleaner - Traverse cache lines to be cleaned and read their dirty sectors
+ * from cache. Only dirty sectors are written to core, so clean ones are not
+ * read at all.
+ */
+static int _ocf_cleaner_fire_cache(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+	struct ocf_map_info *iter = req->map;
+	uint64_t begin, end;
+	uint32_t i;
+
+	/* Protect IO completion race */
+	env_atomic_set(&req->req_remaining, 1);
+
+	ocf_volume_plug(&cache->device->volume);
+
 	for (i = 0; i < req->core_line_count; i++, iter++) {
 		if (iter->core_id == OCF_CORE_MAX)
 			continue;
 		if (iter->status == LOOKUP_MISS)
 			continue;
 
-		cache_stats = &cache->core[iter->core_id].
-				counters->cache_blocks;
-
-		io = ocf_new_cache_io(cache);
-		if (!io) {
-			/* Allocation error */
-			iter->invalid = true;
-			_ocf_cleaner_set_error(req);
+		if (_ocf_cleaner_zero_line(req, iter))
 			continue;
-		}
-
-		OCF_DEBUG_PARAM(req->cache, "Cache read, line =  %u",
-				iter->coll_idx);
 
-		addr = ocf_metadata_map_lg2phy(cache,
-				iter->coll_idx);
-		addr *= ocf_line_size(cache);
-		addr += cache->device->metadata_offset;
-
-		offset = ocf_line_size(cache) * iter->hash_key;
-
-		part_id = ocf_metadata_get_partition_id(cache, iter->coll_idx);
-
-		ocf_io_set_cmpl(io, iter, req, _ocf_cleaner_cache_io_cmpl);
-		ocf_io_configure(io, addr, ocf_line_size(cache), OCF_READ,
-				part_id, 0);
-		ocf_io_set_queue(io, req->io_queue);
-		err = ocf_io_set_data(io, req->data, offset);
-		if (err) {
-			ocf_io_put(io);
-			iter->invalid = true;
-			_ocf_cleaner_set_error(req);
+		if (metadata_test_valid(cache, iter->coll_idx) &&
+				metadata_test_dirty(cache, iter->coll_idx)) {
+			_ocf_cleaner_cache_io_for_range(req, iter, 0,
+					ocf_line_sectors(cache));
 			continue;
 		}
 
-		env_atomic64_add(ocf_line_size(cache), &cache_stats->read_bytes);
-
-		ocf_volume_submit_io(io);
+		for (begin = 0; _ocf_cleaner_dirty_range(cache, iter->coll_idx,
+				&begin, &end); begin = end) {
+			_ocf_cleaner_cache_io_for_range(req, iter, begin, end);
+		}
 	}
 
+	ocf_volume_unplug(&cache->device->volume);
+
 	/* Protect IO completion race */
 	_ocf_cleaner_cache_io_end(req);
 
@@ -753,6 +1177,13 @@ static int _ocf_cleaner_cmp_private(const void *a, const void *b)
 	return (_a->core_id > _b->core_id) ? 1 : -1;
 }
 
+static uint64_t _ocf_cleaner_key_private(const void *entry, uint32_t key)
+{
+	const struct ocf_map_info *map = entry;
+
+	return key ? map->core_line : map->core_id;
+}
+
 /**
  * Prepare cleaning request to be fired
  *
@@ -764,8 +1195,6 @@ static int _ocf_cleaner_do_fire(struct ocf_request *req,  uint32_t i_out,
 		bool do_sort)
 {
 	uint32_t i;
-	/* Set counts of cache IOs */
-	env_atomic_set(&req->req_remaining, i_out);
 
 	/* fill tail of a request with fake MISSes so that it won't
 	 *  be cleaned
@@ -779,8 +1208,9 @@ static int _ocf_cleaner_do_fire(struct ocf_request *req,  uint32_t i_out,
 
 	if (do_sort) {
 		/* Sort by core id and core line */
-		env_sort(req->map, req->core_line_count, sizeof(req->map[0]),
-			_ocf_cleaner_cmp_private, NULL);
+		ocf_sort(req->map, req->core_line_count, sizeof(req->map[0]),
+			2, _ocf_cleaner_key_private, _ocf_cleaner_cmp_private,
+			NULL);
 		for (i = 0; i < req->core_line_count; i++)
 			req->map[i].hash_key = i;
 	}
@@ -793,7 +1223,7 @@ static inline uint32_t _ocf_cleaner_get_req_max_count(uint32_t count,
 		bool low_mem)
 {
 	if (low_mem || count <= 4096)
-		return count < 128 ? count : 128;
+		return OCF_MIN(count, (uint32_t)OCF_CLEANER_REQ_MAX_LINES);
 
 	return 1024;
 }
@@ -998,9 +1428,17 @@ static void _ocf_cleaner_swap(void *a, void *b, int size)
 	*_b = t;
 }
 
+static uint64_t _ocf_cleaner_key(const void *entry, uint32_t key)
+{
+	const struct flush_data *data = entry;
+
+	return key ? data->core_line : data->core_id;
+}
+
 void ocf_cleaner_sort_sectors(struct flush_data *tbl, uint32_t num)
 {
-	env_sort(tbl, num, sizeof(*tbl), _ocf_cleaner_cmp, _ocf_cleaner_swap);
+	ocf_sort(tbl, num, sizeof(*tbl), 2, _ocf_cleaner_key, _ocf_cleaner_cmp,
+			_ocf_cleaner_swap);
 }
 
 void ocf_cleaner_sort_flush_containers(struct flush_container *fctbl,
@@ -1008,9 +1446,6 @@ void ocf_cleaner_sort_flush_containers(struct flush_container *fctbl,
 {
 	int i;
 
-	for (i = 0; i < num; i++) {
-		env_sort(fctbl[i].flush_data, fctbl[i].count,
-				sizeof(*fctbl[i].flush_data), _ocf_cleaner_cmp,
-				_ocf_cleaner_swap);
-	}
+	for (i = 0; i < num; i++)
+		ocf_cleaner_sort_sectors(fctbl[i].flush_data, fctbl[i].count);
 }
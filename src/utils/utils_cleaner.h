@@ -57,6 +57,19 @@ struct flush_data {
 
 typedef void (*ocf_flush_containter_coplete_t)(void *ctx);
 
+struct flush_container;
+
+/**
+ * @brief Portion of flush container submitted to cleaner at once
+ */
+struct flush_portion {
+	struct flush_container *fc;
+	uint32_t count;
+	uint64_t ticks1;
+	uint64_t ticks2;
+	bool busy;
+};
+
 /**
  * @brief Flush table container
  */
@@ -66,19 +79,75 @@ struct flush_container {
 	uint32_t count;
 	uint32_t iter;
 
+	bool stream;
+		/*!< Dirty lines are collected in batches while flushing */
+	ocf_cache_line_t scan;
+		/*!< Next collision table entry to be scanned for dirty lines */
+	bool indexed;
+		/*!< Stream is collected from index of mapped core lines */
+	uint64_t core_scan;
+		/*!< Next core line to be looked up in index */
+	uint64_t resume;
+		/*!< Stream position flush was resumed from */
+	bool wrapped;
+		/*!< Stream reached its end and continues from the beginning
+		 * up to resume position
+		 */
+	uint64_t batch;
+		/*!< Stream position at which current batch was collected */
+
 	struct ocf_cleaner_attribs attribs;
 	ocf_cache_t cache;
 
 	struct ocf_request *req;
 
 	uint64_t flush_portion;
-	uint64_t ticks1;
-	uint64_t ticks2;
+
+	struct flush_portion *portions;
+		/*!< Portions which may be flushed concurrently */
+	uint32_t queue_depth;
+
+	env_spinlock lock;
+		/*!< Protects inflight, scheduled and busy state of portions */
+	uint32_t inflight;
+	bool scheduled;
 
 	ocf_flush_containter_coplete_t end;
 	struct ocf_mngt_cache_flush_context *context;
 };
 
+/**
+ * @brief Size cleaner data buffer pool for cleaning batch of policy
+ *
+ * @param cache - Cache instance
+ * @param batch - Number of cache lines cleaned by policy in single run
+ */
+void ocf_cleaner_pool_set_batch(ocf_cache_t cache, uint32_t batch);
+
+/**
+ * @brief Free all buffers of cleaner data buffer pool and turn it off
+ *
+ * @param cache - Cache instance
+ */
+void ocf_cleaner_pool_drain(ocf_cache_t cache);
+
+/**
+ * @brief Initialize write-back limits of core, no limits are set
+ *
+ * @param core - Core handle
+ */
+void ocf_cleaner_core_init(ocf_core_t core);
+
+/**
+ * @brief Set write-back limits of core honoured by cleaner
+ *
+ * @param core - Core handle
+ * @param max_inflight - Maximum number of in-flight writes, 0 for no limit
+ * @param max_io_size - Maximum write size in bytes, 0 for volume limit
+ */
+void ocf_cleaner_core_set_limits(ocf_core_t core, uint32_t max_inflight,
+		uint32_t max_io_size);
+
 /**
  * @brief Run cleaning procedure
  *
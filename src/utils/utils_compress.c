@@ -0,0 +1,215 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_ctx_priv.h"
+#include "../ocf_def_priv.h"
+#include "utils_cache_line.h"
+#include "utils_compress.h"
+
+#define COMPRESS_HASH_BITS	12
+#define COMPRESS_MIN_MATCH	4
+#define COMPRESS_MAX_OFFSET	65535
+/* LZ4 block ends with literals, last match starts at least this far away */
+#define COMPRESS_LAST_LITERALS	5
+#define COMPRESS_MATCH_LIMIT	12
+
+struct ocf_compress_est {
+	env_rwlock lock;
+		/*!< Write lock for sample, samplers skip line when it's held */
+
+	env_atomic64 seen;
+		/*!< Number of cache device writes since estimator reset */
+
+	ctx_data_t *data;
+	uint8_t *buf;
+		/*!< Copy of sampled cache line */
+
+	uint32_t *table;
+		/*!< Match finder hash table of positions + 1 */
+
+	struct ocf_stats_compress stats;
+};
+
+static inline uint32_t _ocf_compress_read32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Bytes taken by literal run and its length in LZ4 sequence */
+static inline uint32_t _ocf_compress_literals(uint32_t len)
+{
+	return len + (len >= 15 ? (len - 15) / 255 + 1 : 0);
+}
+
+/* Bytes taken by match offset and extra length bytes in LZ4 sequence */
+static inline uint32_t _ocf_compress_match(uint32_t len)
+{
+	len -= COMPRESS_MIN_MATCH;
+
+	return 2 + (len >= 15 ? (len - 15) / 255 + 1 : 0);
+}
+
+/* Size of LZ4 block which greedy compression of src would produce */
+static uint32_t _ocf_compress_size(const uint8_t *src, uint32_t size,
+		uint32_t *table)
+{
+	uint32_t limit = size > COMPRESS_MATCH_LIMIT ?
+			size - COMPRESS_MATCH_LIMIT : 0;
+	uint32_t pos = 0, anchor = 0, out = 0;
+	uint32_t seq, hash, ref, len;
+
+	ENV_BUG_ON(env_memset(table, sizeof(*table) << COMPRESS_HASH_BITS, 0));
+
+	while (pos < limit) {
+		seq = _ocf_compress_read32(src + pos);
+		hash = (seq * 2654435761U) >> (32 - COMPRESS_HASH_BITS);
+		ref = table[hash];
+		table[hash] = pos + 1;
+
+		if (!ref || pos - (ref - 1) > COMPRESS_MAX_OFFSET ||
+				_ocf_compress_read32(src + ref - 1) != seq) {
+			pos++;
+			continue;
+		}
+		ref--;
+
+		for (len = COMPRESS_MIN_MATCH;
+				pos + len < size - COMPRESS_LAST_LITERALS &&
+				src[ref + len] == src[pos + len];) {
+			len++;
+		}
+
+		out += 1 + _ocf_compress_literals(pos - anchor) +
+				_ocf_compress_match(len);
+
+		pos += len;
+		anchor = pos;
+	}
+
+	return out + 1 + _ocf_compress_literals(size - anchor);
+}
+
+int ocf_compress_est_init(ocf_cache_t cache)
+{
+	struct ocf_compress_est *est = cache->compress_est;
+
+	if (est) {
+		env_rwlock_write_lock(&est->lock);
+		ENV_BUG_ON(env_memset(&est->stats, sizeof(est->stats), 0));
+		env_atomic64_set(&est->seen, 0);
+		env_rwlock_write_unlock(&est->lock);
+		return 0;
+	}
+
+	est = env_vzalloc(sizeof(*est));
+	if (!est)
+		return -OCF_ERR_NO_MEM;
+
+	est->buf = env_vmalloc(ocf_cache_line_size_max);
+	est->table = env_vmalloc(sizeof(*est->table) << COMPRESS_HASH_BITS);
+	est->data = ctx_data_alloc(cache->owner,
+			BYTES_TO_PAGES(ocf_cache_line_size_max));
+	if (!est->buf || !est->table || !est->data) {
+		if (est->data)
+			ctx_data_free(cache->owner, est->data);
+		env_vfree(est->table);
+		env_vfree(est->buf);
+		env_vfree(est);
+		return -OCF_ERR_NO_MEM;
+	}
+
+	env_rwlock_init(&est->lock);
+	env_atomic64_set(&est->seen, 0);
+
+	cache->compress_est = est;
+
+	return 0;
+}
+
+void ocf_compress_est_deinit(ocf_cache_t cache)
+{
+	struct ocf_compress_est *est = cache->compress_est;
+
+	cache->compress_est_enabled = false;
+
+	if (!est)
+		return;
+
+	cache->compress_est = NULL;
+
+	ctx_data_free(cache->owner, est->data);
+	env_vfree(est->table);
+	env_vfree(est->buf);
+	env_vfree(est);
+}
+
+void ocf_compress_est_sample(struct ocf_request *req, uint32_t first,
+		uint32_t count)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_compress_est *est = cache->compress_est;
+	uint64_t line_size = ocf_line_size(cache);
+	uint64_t seek = req->byte_position % line_size;
+	uint64_t offset = 0;
+	uint32_t i, size, stored;
+
+	if (!cache->compress_est_enabled)
+		return;
+
+	if (env_atomic64_inc_return(&est->seen) %
+			OCF_CONFIG_COMPRESS_SAMPLE_RATE) {
+		return;
+	}
+
+	/* Sample first cache line written as a whole */
+	for (i = first; i < first + count; i++) {
+		if (i == 0 && seek)
+			continue;
+
+		offset = i * line_size - seek;
+		if (offset + line_size <= req->byte_length)
+			break;
+	}
+
+	if (i == first + count)
+		return;
+
+	if (env_rwlock_write_trylock(&est->lock))
+		return;
+
+	ctx_data_cpy(cache->owner, est->data, req->data, 0,
+			req->data_offset + offset, line_size);
+	ctx_data_seek_check(cache->owner, est->data, ctx_data_seek_begin, 0);
+	ctx_data_rd_check(cache->owner, est->buf, est->data, line_size);
+
+	size = _ocf_compress_size(est->buf, line_size, est->table);
+
+	/* Incompressible line is stored as is */
+	stored = OCF_MIN(SECTORS_TO_BYTES(BYTES_TO_SECTORS(size +
+			SECTORS_TO_BYTES(1) - 1)), line_size);
+
+	est->stats.sampled_lines++;
+	est->stats.sampled_bytes += line_size;
+	est->stats.compressed_bytes += OCF_MIN(size, line_size);
+	est->stats.stored_bytes += stored;
+	if (stored == line_size)
+		est->stats.incompressible_lines++;
+
+	env_rwlock_write_unlock(&est->lock);
+}
+
+void ocf_compress_est_get(ocf_cache_t cache, struct ocf_stats_compress *stats)
+{
+	struct ocf_compress_est *est = cache->compress_est;
+
+	env_rwlock_write_lock(&est->lock);
+	*stats = est->stats;
+	env_rwlock_write_unlock(&est->lock);
+
+	stats->capacity_ratio = stats->stored_bytes ?
+			stats->sampled_bytes * 1000 / stats->stored_bytes : 0;
+}
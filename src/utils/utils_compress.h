@@ -0,0 +1,60 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_COMPRESS_H__
+#define __UTILS_COMPRESS_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_request.h"
+
+/**
+ * @file utils_compress.h
+ * @brief Sampling estimator of cached data compressibility
+ *
+ * One cache line of every OCF_CONFIG_COMPRESS_SAMPLE_RATE-th write to cache
+ * device is compressed with greedy LZ4 class match finder, which only
+ * counts size of output. Compressed size rounded up to whole sectors is
+ * space cache line would take in packed layout, which gives estimate of
+ * effective cache capacity with compressed cache lines.
+ */
+
+struct ocf_compress_est;
+
+/**
+ * @brief Allocate compressibility estimator of cache, or reset existing one
+ *
+ * @param cache - OCF cache instance
+ *
+ * @retval 0 Estimator is ready
+ * @retval Non-zero Allocation failed
+ */
+int ocf_compress_est_init(ocf_cache_t cache);
+
+/**
+ * @brief Free compressibility estimator of cache
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_compress_est_deinit(ocf_cache_t cache);
+
+/**
+ * @brief Account cache lines written to cache device by request
+ *
+ * @param req - OCF request which data is written
+ * @param first - Index of first map entry written
+ * @param count - Number of map entries written
+ */
+void ocf_compress_est_sample(struct ocf_request *req, uint32_t first,
+		uint32_t count);
+
+/**
+ * @brief Get compressibility estimate
+ *
+ * @param cache - OCF cache instance
+ * @param stats - Compressibility statistics
+ */
+void ocf_compress_est_get(ocf_cache_t cache, struct ocf_stats_compress *stats);
+
+#endif /* __UTILS_COMPRESS_H__ */
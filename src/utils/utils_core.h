@@ -10,4 +10,10 @@
 	for (iter = 0; iter < OCF_CORE_MAX; iter++) \
 		if (cache->core_conf_meta[iter].added)
 
+/* Iterate over cores which may have dirty cache lines */
+#define for_each_dirty_core(cache, iter) \
+	for (iter = ocf_cache_dirty_core_next(cache, 0); \
+			iter < OCF_CORE_MAX; \
+			iter = ocf_cache_dirty_core_next(cache, iter + 1))
+
 #endif /* __UTILS_CORE_H__ */
@@ -0,0 +1,143 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "utils_data.h"
+#include "../ocf_ctx_priv.h"
+#include "../ocf_def_priv.h"
+
+/*
+ * Buffers are pooled in power of two page count classes, larger ones are
+ * always allocated and freed through context
+ */
+#define OCF_DATA_POOL_CLASSES	8
+
+struct ocf_data_pool_class {
+	env_spinlock lock;
+	uint32_t count;
+	ctx_data_t *data[OCF_CONFIG_CTX_DATA_POOL];
+};
+
+struct ocf_data_pool {
+	struct ocf_data_pool_class classes[OCF_DATA_POOL_CLASSES];
+};
+
+static inline uint32_t _ocf_data_pool_class(uint32_t pages)
+{
+	uint32_t class = 0;
+
+	while ((1U << class) < pages)
+		class++;
+
+	return class;
+}
+
+static ctx_data_t *_ocf_data_alloc_locked(ocf_ctx_t ctx, uint32_t pages)
+{
+	ctx_data_t *data;
+
+	data = ctx_data_alloc(ctx, pages);
+	if (!data)
+		return NULL;
+
+	if (ctx_data_mlock(ctx, data)) {
+		ctx_data_free(ctx, data);
+		return NULL;
+	}
+
+	return data;
+}
+
+static void _ocf_data_free_locked(ocf_ctx_t ctx, ctx_data_t *data)
+{
+	ctx_data_munlock(ctx, data);
+	ctx_data_free(ctx, data);
+}
+
+int ocf_data_pool_init(ocf_ctx_t ctx)
+{
+	struct ocf_data_pool *pool;
+	uint32_t i;
+
+	if (!OCF_CONFIG_CTX_DATA_POOL)
+		return 0;
+
+	pool = env_vzalloc(sizeof(*pool));
+	if (!pool)
+		return -OCF_ERR_NO_MEM;
+
+	for (i = 0; i < OCF_DATA_POOL_CLASSES; i++)
+		env_spinlock_init(&pool->classes[i].lock);
+
+	ctx->resources.data_pool = pool;
+
+	return 0;
+}
+
+void ocf_data_pool_deinit(ocf_ctx_t ctx)
+{
+	struct ocf_data_pool *pool = ctx->resources.data_pool;
+	struct ocf_data_pool_class *class;
+	uint32_t i;
+
+	if (!pool)
+		return;
+
+	for (i = 0; i < OCF_DATA_POOL_CLASSES; i++) {
+		class = &pool->classes[i];
+		while (class->count)
+			_ocf_data_free_locked(ctx, class->data[--class->count]);
+	}
+
+	env_vfree(pool);
+	ctx->resources.data_pool = NULL;
+}
+
+ctx_data_t *ocf_data_get_locked(ocf_ctx_t ctx, uint32_t pages)
+{
+	struct ocf_data_pool *pool = ctx->resources.data_pool;
+	struct ocf_data_pool_class *class;
+	uint32_t id = _ocf_data_pool_class(pages);
+	ctx_data_t *data = NULL;
+
+	if (!pool || id >= OCF_DATA_POOL_CLASSES)
+		return _ocf_data_alloc_locked(ctx, pages);
+
+	class = &pool->classes[id];
+
+	env_spinlock_lock(&class->lock);
+	if (class->count)
+		data = class->data[--class->count];
+	env_spinlock_unlock(&class->lock);
+
+	if (!data)
+		return _ocf_data_alloc_locked(ctx, 1U << id);
+
+	/* Previous user could leave data position anywhere */
+	ctx_data_seek(ctx, data, ctx_data_seek_begin, 0);
+
+	return data;
+}
+
+void ocf_data_put_locked(ocf_ctx_t ctx, ctx_data_t *data, uint32_t pages)
+{
+	struct ocf_data_pool *pool = ctx->resources.data_pool;
+	struct ocf_data_pool_class *class;
+	uint32_t id = _ocf_data_pool_class(pages);
+	bool pooled = false;
+
+	if (pool && id < OCF_DATA_POOL_CLASSES) {
+		class = &pool->classes[id];
+
+		env_spinlock_lock(&class->lock);
+		if (class->count < OCF_CONFIG_CTX_DATA_POOL) {
+			class->data[class->count++] = data;
+			pooled = true;
+		}
+		env_spinlock_unlock(&class->lock);
+	}
+
+	if (!pooled)
+		_ocf_data_free_locked(ctx, data);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_DATA_H__
+#define __UTILS_DATA_H__
+
+#include "ocf/ocf.h"
+
+/**
+ * @file utils_data.h
+ * @brief Pool of locked context data buffers used for internal I/O
+ */
+
+/**
+ * @brief Initialize pool of data buffers of context
+ *
+ * @param ctx - OCF context
+ *
+ * @retval 0 Pool initialized
+ * @retval Non-zero Memory allocation failure
+ */
+int ocf_data_pool_init(ocf_ctx_t ctx);
+
+/**
+ * @brief Free pool of data buffers of context along with pooled buffers
+ *
+ * @param ctx - OCF context
+ */
+void ocf_data_pool_deinit(ocf_ctx_t ctx);
+
+/**
+ * @brief Get locked data buffer of at least given number of pages
+ *
+ * Buffer is taken from pool, or allocated and locked when pool is empty.
+ * Its content is undefined.
+ *
+ * @param ctx - OCF context
+ * @param pages - Number of pages of buffer
+ *
+ * @return Data buffer, NULL on allocation failure
+ */
+ctx_data_t *ocf_data_get_locked(ocf_ctx_t ctx, uint32_t pages);
+
+/**
+ * @brief Give back buffer obtained with ocf_data_get_locked()
+ *
+ * @param ctx - OCF context
+ * @param data - Data buffer
+ * @param pages - Number of pages buffer was requested with
+ */
+void ocf_data_put_locked(ocf_ctx_t ctx, ctx_data_t *data, uint32_t pages);
+
+#endif /* __UTILS_DATA_H__ */
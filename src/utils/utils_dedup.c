@@ -0,0 +1,258 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_ctx_priv.h"
+#include "../ocf_def_priv.h"
+#include "utils_cache_line.h"
+#include "utils_dedup.h"
+
+struct ocf_dedup_entry {
+	uint64_t fp;
+		/*!< Fingerprint, 0 if entry is free */
+
+	uint64_t refs;
+		/*!< Number of sampled cache lines with this fingerprint */
+};
+
+struct ocf_dedup_est {
+	env_rwlock lock;
+		/*!< Write lock for sample, samplers skip line when it's held */
+
+	env_atomic64 seen;
+		/*!< Number of cache device writes since estimator reset */
+
+	ctx_data_t *data;
+	uint64_t *buf;
+		/*!< Copy of sampled cache line */
+
+	struct ocf_dedup_entry *table;
+		/*!< Open addressing hash table of tracked fingerprints */
+
+	uint32_t table_mask;
+	uint32_t count;
+		/*!< Number of tracked fingerprints */
+
+	uint32_t shift;
+		/*!< Fingerprints below 2^(64 - shift) are tracked */
+
+	uint64_t sampled;
+	uint64_t refs;
+		/*!< Sum of references of tracked fingerprints */
+};
+
+static inline uint64_t _ocf_dedup_mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+static uint64_t _ocf_dedup_fingerprint(const uint64_t *buf, uint32_t size)
+{
+	uint64_t h = size;
+	uint32_t i;
+
+	for (i = 0; i < size / sizeof(*buf); i++)
+		h = (h ^ _ocf_dedup_mix(buf[i] + i)) * 0x9E3779B97F4A7C15ULL;
+
+	/* Keep 0 for free table entries */
+	return _ocf_dedup_mix(h) ?: 1;
+}
+
+static inline bool _ocf_dedup_tracked(struct ocf_dedup_est *est, uint64_t fp)
+{
+	return est->shift == 0 || (fp >> (64 - est->shift)) == 0;
+}
+
+static struct ocf_dedup_entry *_ocf_dedup_slot(struct ocf_dedup_est *est,
+		uint64_t fp)
+{
+	uint32_t pos = (fp >> 7) & est->table_mask;
+
+	while (est->table[pos].fp && est->table[pos].fp != fp)
+		pos = (pos + 1) & est->table_mask;
+
+	return &est->table[pos];
+}
+
+/* Halve sampled fingerprint range and rebuild table out of what's left */
+static void _ocf_dedup_lower_threshold(struct ocf_dedup_est *est)
+{
+	struct ocf_dedup_entry entry, *slot;
+	uint32_t i;
+
+	est->shift++;
+
+	for (i = 0; i <= est->table_mask; i++) {
+		if (!est->table[i].fp || _ocf_dedup_tracked(est,
+				est->table[i].fp)) {
+			continue;
+		}
+
+		est->count--;
+		est->refs -= est->table[i].refs;
+		est->table[i].fp = 0;
+	}
+
+	/* Reinsert entries which could be moved past new holes */
+	for (i = 0; i <= est->table_mask; i++) {
+		if (!est->table[i].fp)
+			continue;
+
+		entry = est->table[i];
+		est->table[i].fp = 0;
+
+		slot = _ocf_dedup_slot(est, entry.fp);
+		*slot = entry;
+	}
+}
+
+int ocf_dedup_est_init(ocf_cache_t cache)
+{
+	struct ocf_dedup_est *est = cache->dedup_est;
+	uint32_t size;
+
+	if (est) {
+		env_rwlock_write_lock(&est->lock);
+		ENV_BUG_ON(env_memset(est->table, sizeof(*est->table) *
+				(est->table_mask + 1), 0));
+		est->count = 0;
+		est->shift = 0;
+		est->sampled = 0;
+		est->refs = 0;
+		env_atomic64_set(&est->seen, 0);
+		env_rwlock_write_unlock(&est->lock);
+		return 0;
+	}
+
+	/* Keep hash table at most half full */
+	for (size = 1; size < 2 * OCF_CONFIG_DEDUP_SAMPLES;)
+		size <<= 1;
+
+	est = env_vzalloc(sizeof(*est));
+	if (!est)
+		return -OCF_ERR_NO_MEM;
+
+	est->buf = env_vmalloc(ocf_cache_line_size_max);
+	est->table = env_vzalloc(sizeof(*est->table) * size);
+	est->data = ctx_data_alloc(cache->owner,
+			BYTES_TO_PAGES(ocf_cache_line_size_max));
+	if (!est->buf || !est->table || !est->data) {
+		if (est->data)
+			ctx_data_free(cache->owner, est->data);
+		env_vfree(est->table);
+		env_vfree(est->buf);
+		env_vfree(est);
+		return -OCF_ERR_NO_MEM;
+	}
+
+	est->table_mask = size - 1;
+
+	env_rwlock_init(&est->lock);
+	env_atomic64_set(&est->seen, 0);
+
+	cache->dedup_est = est;
+
+	return 0;
+}
+
+void ocf_dedup_est_deinit(ocf_cache_t cache)
+{
+	struct ocf_dedup_est *est = cache->dedup_est;
+
+	cache->dedup_est_enabled = false;
+
+	if (!est)
+		return;
+
+	cache->dedup_est = NULL;
+
+	ctx_data_free(cache->owner, est->data);
+	env_vfree(est->table);
+	env_vfree(est->buf);
+	env_vfree(est);
+}
+
+void ocf_dedup_est_sample(struct ocf_request *req, uint32_t first,
+		uint32_t count)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_dedup_est *est = cache->dedup_est;
+	uint64_t line_size = ocf_line_size(cache);
+	uint64_t seek = req->byte_position % line_size;
+	struct ocf_dedup_entry *slot;
+	uint64_t offset = 0, fp;
+	uint32_t i;
+
+	if (!cache->dedup_est_enabled)
+		return;
+
+	if (env_atomic64_inc_return(&est->seen) %
+			OCF_CONFIG_DEDUP_SAMPLE_RATE) {
+		return;
+	}
+
+	/* Sample first cache line written as a whole */
+	for (i = first; i < first + count; i++) {
+		if (i == 0 && seek)
+			continue;
+
+		offset = i * line_size - seek;
+		if (offset + line_size <= req->byte_length)
+			break;
+	}
+
+	if (i == first + count)
+		return;
+
+	if (env_rwlock_write_trylock(&est->lock))
+		return;
+
+	ctx_data_cpy(cache->owner, est->data, req->data, 0,
+			req->data_offset + offset, line_size);
+	ctx_data_seek_check(cache->owner, est->data, ctx_data_seek_begin, 0);
+	ctx_data_rd_check(cache->owner, est->buf, est->data, line_size);
+
+	fp = _ocf_dedup_fingerprint(est->buf, line_size);
+
+	est->sampled++;
+
+	if (_ocf_dedup_tracked(est, fp)) {
+		slot = _ocf_dedup_slot(est, fp);
+		if (!slot->fp) {
+			slot->fp = fp;
+			est->count++;
+		}
+		slot->refs++;
+		est->refs++;
+
+		if (est->count > OCF_CONFIG_DEDUP_SAMPLES && est->shift < 63)
+			_ocf_dedup_lower_threshold(est);
+	}
+
+	env_rwlock_write_unlock(&est->lock);
+}
+
+void ocf_dedup_est_get(ocf_cache_t cache, struct ocf_stats_dedup *stats)
+{
+	struct ocf_dedup_est *est = cache->dedup_est;
+
+	env_rwlock_write_lock(&est->lock);
+	stats->sampled_lines = est->sampled;
+	stats->tracked_lines = est->refs;
+	stats->distinct_lines = est->count;
+	stats->sampling_ppm = 1000000 >> est->shift;
+	env_rwlock_write_unlock(&est->lock);
+
+	stats->capacity_ratio = stats->distinct_lines ? OCF_MIN(
+			stats->tracked_lines * 1000 / stats->distinct_lines,
+			(uint64_t)UINT32_MAX) : 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_DEDUP_H__
+#define __UTILS_DEDUP_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_request.h"
+
+/**
+ * @file utils_dedup.h
+ * @brief Sampling estimator of duplicate data in cache
+ *
+ * One cache line of every OCF_CONFIG_DEDUP_SAMPLE_RATE-th write to cache
+ * device is fingerprinted. Fingerprints below threshold are tracked with
+ * number of their references, and when OCF_CONFIG_DEDUP_SAMPLES of them
+ * are tracked, threshold is halved and fingerprints above it are dropped.
+ * Ratio of references to distinct fingerprints is then estimated ratio of
+ * cache lines to distinct contents over constant memory.
+ */
+
+struct ocf_dedup_est;
+
+/**
+ * @brief Allocate deduplication estimator of cache, or reset existing one
+ *
+ * @param cache - OCF cache instance
+ *
+ * @retval 0 Estimator is ready
+ * @retval Non-zero Allocation failed
+ */
+int ocf_dedup_est_init(ocf_cache_t cache);
+
+/**
+ * @brief Free deduplication estimator of cache
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_dedup_est_deinit(ocf_cache_t cache);
+
+/**
+ * @brief Account cache lines written to cache device by request
+ *
+ * @param req - OCF request which data is written
+ * @param first - Index of first map entry written
+ * @param count - Number of map entries written
+ */
+void ocf_dedup_est_sample(struct ocf_request *req, uint32_t first,
+		uint32_t count);
+
+/**
+ * @brief Get deduplication estimate
+ *
+ * @param cache - OCF cache instance
+ * @param stats - Deduplication statistics
+ */
+void ocf_dedup_est_get(ocf_cache_t cache, struct ocf_stats_dedup *stats);
+
+#endif /* __UTILS_DEDUP_H__ */
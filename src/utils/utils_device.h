@@ -15,7 +15,7 @@ static inline int _ocf_uuid_set(const struct ocf_volume_uuid *uuid,
 		return -EINVAL;
 	}
 
-	if (!uuid->data || !muuid->data) {
+	if (!uuid->data) {
 		return -EINVAL;
 	}
 
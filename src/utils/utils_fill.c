@@ -0,0 +1,217 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_ctx_priv.h"
+#include "../ocf_def_priv.h"
+#include "../engine/cache_engine.h"
+#include "../engine/engine_common.h"
+#include "../concurrency/ocf_concurrency.h"
+#include "utils_cache_line.h"
+#include "utils_fill.h"
+
+#if OCF_CONFIG_HIT_UNDER_FILL
+
+/* Number of hash buckets of in-flight backfills table, power of two */
+#define FILL_TABLE_BUCKETS 4096
+
+struct ocf_fill_entry {
+	struct ocf_fill_entry *next;
+		/*!< Next entry in hash bucket */
+
+	struct ocf_request *req;
+		/*!< Request being backfilled */
+
+	ocf_cache_line_t line;
+	uint64_t core_line;
+};
+
+struct ocf_fill_table {
+	struct ocf_fill_entry *buckets[FILL_TABLE_BUCKETS];
+
+	env_atomic count;
+		/*!< Registered requests, lookup is skipped if there are none */
+
+	env_rwlock lock;
+		/*!< Read for lookup and copy out, write for changes */
+};
+
+static inline uint32_t fill_hash(ocf_cache_line_t line)
+{
+	return (uint32_t)(line * 0x9E3779B1U) >> (32 - 12);
+}
+
+int ocf_fill_attach(ocf_cache_t cache)
+{
+	struct ocf_fill_table *table;
+
+	ENV_BUG_ON(cache->fill);
+
+	table = env_vzalloc(sizeof(*table));
+	if (!table)
+		return -OCF_ERR_NO_MEM;
+
+	env_atomic_set(&table->count, 0);
+	env_rwlock_init(&table->lock);
+
+	cache->fill = table;
+
+	return 0;
+}
+
+void ocf_fill_detach(ocf_cache_t cache)
+{
+	struct ocf_fill_table *table = cache->fill;
+
+	if (!table)
+		return;
+
+	ENV_BUG_ON(env_atomic_read(&table->count));
+
+	cache->fill = NULL;
+	env_vfree(table);
+}
+
+void ocf_fill_register(struct ocf_request *req)
+{
+	struct ocf_fill_table *table = req->cache->fill;
+	struct ocf_fill_entry *entries;
+	uint32_t i, bucket;
+
+	if (!table || !req->cp_data || req->info.split_read)
+		return;
+
+	/* Registering is best effort, readers wait for lock otherwise */
+	entries = env_malloc(sizeof(*entries) * req->core_line_count,
+			ENV_MEM_NOIO);
+	if (!entries)
+		return;
+
+	env_rwlock_write_lock(&table->lock);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		entries[i].req = req;
+		entries[i].line = req->map[i].coll_idx;
+		entries[i].core_line = req->map[i].core_line;
+
+		bucket = fill_hash(entries[i].line);
+		entries[i].next = table->buckets[bucket];
+		table->buckets[bucket] = &entries[i];
+	}
+
+	req->fill = entries;
+	env_atomic_inc(&table->count);
+
+	env_rwlock_write_unlock(&table->lock);
+}
+
+void ocf_fill_unregister(struct ocf_request *req)
+{
+	struct ocf_fill_table *table = req->cache->fill;
+	struct ocf_fill_entry **pos;
+	uint32_t i;
+
+	if (!req->fill)
+		return;
+
+	env_rwlock_write_lock(&table->lock);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		pos = &table->buckets[fill_hash(req->fill[i].line)];
+		while (*pos != &req->fill[i])
+			pos = &(*pos)->next;
+
+		*pos = req->fill[i].next;
+	}
+
+	env_atomic_dec(&table->count);
+
+	env_rwlock_write_unlock(&table->lock);
+
+	env_free(req->fill);
+	req->fill = NULL;
+}
+
+/* In-flight backfill holding core line mapped to given cache line */
+static struct ocf_request *fill_lookup(struct ocf_fill_table *table,
+		struct ocf_request *req, uint32_t idx)
+{
+	struct ocf_fill_entry *entry;
+
+	entry = table->buckets[fill_hash(req->map[idx].coll_idx)];
+	for (; entry; entry = entry->next) {
+		if (entry->line == req->map[idx].coll_idx &&
+				entry->core_line == req->map[idx].core_line &&
+				entry->req->core_id == req->core_id) {
+			return entry->req;
+		}
+	}
+
+	return NULL;
+}
+
+/* Check that backfill data covers part of request in given cache line */
+static bool fill_covers(struct ocf_request *fill, uint64_t addr,
+		uint64_t bytes)
+{
+	return addr >= fill->byte_position && addr + bytes <=
+			fill->byte_position + fill->byte_length;
+}
+
+bool ocf_fill_read(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_fill_table *table = cache->fill;
+	uint64_t line_size = ocf_line_size(cache);
+	uint64_t seek = ocf_bytes_line_offset(cache, req->byte_position);
+	struct ocf_request *fill;
+	uint64_t offset, bytes;
+	uint32_t i;
+
+	if (!table || !env_atomic_read(&table->count))
+		return false;
+
+	/* Lines being filled are mapped, mapping of line checked with its
+	 * registered entry can't change until entry is removed
+	 */
+	ocf_req_hash_lock_rd(req);
+	ocf_engine_traverse(req);
+	ocf_req_hash_unlock_rd(req);
+
+	env_rwlock_read_lock(&table->lock);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		offset = i ? i * line_size - seek : 0;
+		bytes = OCF_MIN(line_size - (i ? 0 : seek),
+				req->byte_length - offset);
+
+		fill = req->map[i].status == LOOKUP_HIT ?
+				fill_lookup(table, req, i) : NULL;
+		if (!fill || !fill_covers(fill, req->byte_position + offset,
+				bytes)) {
+			env_rwlock_read_unlock(&table->lock);
+			return false;
+		}
+	}
+
+	for (i = 0; i < req->core_line_count; i++) {
+		offset = i ? i * line_size - seek : 0;
+		bytes = OCF_MIN(line_size - (i ? 0 : seek),
+				req->byte_length - offset);
+
+		fill = fill_lookup(table, req, i);
+		ctx_data_cpy(cache->owner, req->data, fill->cp_data,
+				req->data_offset + offset,
+				req->byte_position + offset - fill->byte_position,
+				bytes);
+	}
+
+	env_rwlock_read_unlock(&table->lock);
+
+	return true;
+}
+
+#endif
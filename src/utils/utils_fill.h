@@ -0,0 +1,90 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_FILL_H__
+#define __UTILS_FILL_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_request.h"
+
+/**
+ * @file utils_fill.h
+ * @brief Reads served from data of in-flight backfills
+ *
+ * Read miss which copied its data to cp_data registers its cache lines for
+ * the time of backfill, while they are write locked. Reads of registered
+ * cache lines copy their data from cp_data instead of waiting for the lock,
+ * so that many readers of line being filled cost single core read. Entry is
+ * removed before cp_data is freed, and readers copy under table lock.
+ */
+
+struct ocf_fill_table;
+
+#if OCF_CONFIG_HIT_UNDER_FILL
+/**
+ * @brief Allocate table of in-flight backfills of attached cache
+ *
+ * @param cache - OCF cache instance
+ *
+ * @retval 0 Table allocated
+ * @retval Non-zero Allocation failed
+ */
+int ocf_fill_attach(ocf_cache_t cache);
+
+/**
+ * @brief Free table of in-flight backfills
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_fill_detach(ocf_cache_t cache);
+
+/**
+ * @brief Register cache lines of request being backfilled from cp_data
+ *
+ * @param req - OCF request write locked on its cache lines
+ */
+void ocf_fill_register(struct ocf_request *req);
+
+/**
+ * @brief Remove cache lines of request from table, before cp_data is freed
+ *
+ * @param req - OCF request
+ */
+void ocf_fill_unregister(struct ocf_request *req);
+
+/**
+ * @brief Copy data of read request from in-flight backfills
+ *
+ * @param req - OCF read request, not locked
+ *
+ * @retval true Request data filled in
+ * @retval false Some of data is not in in-flight backfills
+ */
+bool ocf_fill_read(struct ocf_request *req);
+#else
+static inline int ocf_fill_attach(ocf_cache_t cache)
+{
+	return 0;
+}
+
+static inline void ocf_fill_detach(ocf_cache_t cache)
+{
+}
+
+static inline void ocf_fill_register(struct ocf_request *req)
+{
+}
+
+static inline void ocf_fill_unregister(struct ocf_request *req)
+{
+}
+
+static inline bool ocf_fill_read(struct ocf_request *req)
+{
+	return false;
+}
+#endif
+
+#endif /* __UTILS_FILL_H__ */
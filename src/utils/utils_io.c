@@ -7,9 +7,15 @@
 #include "../ocf_priv.h"
 #include "../ocf_cache_priv.h"
 #include "../ocf_volume_priv.h"
+#include "../ocf_io_priv.h"
 #include "../ocf_request.h"
 #include "utils_io.h"
 #include "utils_cache_line.h"
+#include "utils_ram_tier.h"
+#include "utils_compress.h"
+#include "utils_dedup.h"
+#include "utils_zero.h"
+#include "../ocf_trace_priv.h"
 
 struct ocf_submit_volume_context {
 	env_atomic req_remaining;
@@ -233,6 +239,316 @@ static void ocf_submit_volume_req_cmpl(struct ocf_io *io, int error)
 	ocf_io_put(io);
 }
 
+static void ocf_submit_cache_req_cmpl(struct ocf_io *io, int error)
+{
+	if (ocf_io_steer_cmpl(io, error))
+		return;
+
+	ocf_trace_req_stage(io->priv1, ocf_event_req_stage_cache_io_completed,
+			0);
+
+	ocf_submit_volume_req_cmpl(io, error);
+}
+
+/* Number of cache lines covered by cache IO of request */
+static uint32_t ocf_submit_cache_run_lines(struct ocf_request *req,
+		struct ocf_io *io)
+{
+	ocf_cache_t cache = req->cache;
+	uint64_t offset = io->addr - cache->device->metadata_offset;
+
+	return ocf_bytes_2_lines(cache, offset + io->bytes - 1) -
+			ocf_bytes_2_lines(cache, offset) + 1;
+}
+
+/*
+ * Successfully completed lines are accounted in req_remaining all but the
+ * last one at once, which can't complete request as the last line is still
+ * pending. The last line goes through callback, which may complete request.
+ */
+static void ocf_submit_cache_lines_cmpl(struct ocf_request *req,
+		ocf_req_end_t callback, uint32_t lines)
+{
+	if (lines > 1)
+		env_atomic_sub(lines - 1, &req->req_remaining);
+
+	callback(req, 0);
+}
+
+/*
+ * Single cache IO covers run of physically contiguous cache lines, while
+ * caller expects completion per cache line. Number of lines is recovered
+ * from IO range.
+ */
+static void ocf_submit_cache_run_cmpl(struct ocf_io *io, int error)
+{
+	struct ocf_request *req = io->priv1;
+	ocf_req_end_t callback = io->priv2;
+	uint32_t lines;
+
+	if (ocf_io_steer_cmpl(io, error))
+		return;
+
+	ocf_trace_req_stage(req, ocf_event_req_stage_cache_io_completed, 0);
+
+	lines = ocf_submit_cache_run_lines(req, io);
+
+	ocf_io_put(io);
+
+	if (!error) {
+		ocf_submit_cache_lines_cmpl(req, callback, lines);
+		return;
+	}
+
+	/* Errors are accounted per cache line. Request may be completed by
+	 * the last callback.
+	 */
+	while (lines--)
+		callback(req, error);
+}
+
+uint32_t ocf_io_end_run(struct ocf_io **ios, const int *errors,
+		uint32_t count)
+{
+	struct ocf_io *io = ios[0];
+	struct ocf_request *req = io->priv1;
+	ocf_req_end_t callback = io->priv2;
+	uint32_t i, lines = 0;
+
+	if (io->end != ocf_submit_cache_run_cmpl || (errors && errors[0])) {
+		ocf_io_end(io, errors ? errors[0] : 0);
+		return 1;
+	}
+
+	for (i = 0; i < count; i++) {
+		io = ios[i];
+		if (io->end != ocf_submit_cache_run_cmpl ||
+				io->priv1 != req || io->priv2 != callback ||
+				(errors && errors[i])) {
+			break;
+		}
+
+		ocf_trace_req_stage(req, ocf_event_req_stage_cache_io_completed,
+				0);
+		lines += ocf_submit_cache_run_lines(req, io);
+		ocf_io_put(io);
+	}
+
+	ocf_submit_cache_lines_cmpl(req, callback, lines);
+
+	return i;
+}
+
+/* Number of cache lines following the first one which make single IO */
+static uint32_t ocf_submit_cache_run_length(struct ocf_cache *cache,
+		struct ocf_map_info *map_info, uint32_t first, uint32_t reqs,
+		uint32_t max_lines)
+{
+	ocf_cache_line_t phys, next;
+	uint32_t i;
+
+	phys = ocf_metadata_map_lg2phy(cache, map_info[first].coll_idx);
+
+	for (i = first + 1; i < reqs && i - first < max_lines; i++) {
+		next = ocf_metadata_map_lg2phy(cache, map_info[i].coll_idx);
+		if (next != phys + 1)
+			break;
+		phys = next;
+	}
+
+	return i - first;
+}
+
+static void _ocf_submit_cache_lines(struct ocf_cache *cache,
+		struct ocf_request *req, int dir, uint32_t first,
+		uint32_t count, ocf_req_end_t callback);
+
+#if OCF_CONFIG_ZERO_LINES
+/* Write zeroes to sectors of cache line, completion is accounted to request */
+static void ocf_submit_cache_zeroes(struct ocf_request *req,
+		ocf_cache_line_t line, uint8_t start, uint8_t stop,
+		ocf_req_end_t callback)
+{
+	struct ocf_cache *cache = req->cache;
+	uint64_t flags = req->io ? req->io->flags : 0;
+	uint32_t class = req->io ? req->io->io_class : 0;
+	uint64_t addr, bytes = SECTORS_TO_BYTES(stop - start + 1);
+	struct ocf_io *io;
+	int err;
+
+	env_atomic_inc(&req->req_remaining);
+
+	io = ocf_new_cache_io(cache);
+	if (!io) {
+		callback(req, -OCF_ERR_NO_MEM);
+		return;
+	}
+
+	addr  = ocf_metadata_map_lg2phy(cache, line);
+	addr *= ocf_line_size(cache);
+	addr += cache->device->metadata_offset;
+	addr += SECTORS_TO_BYTES(start);
+
+	ocf_io_configure(io, addr, bytes, OCF_WRITE, class, flags);
+	ocf_io_set_queue(io, req->io_queue);
+	ocf_io_set_cmpl(io, req, callback, ocf_submit_cache_req_cmpl);
+
+	err = ocf_io_set_data(io, cache->zero_lines.data, 0);
+	if (err) {
+		ocf_io_put(io);
+		callback(req, err);
+		return;
+	}
+
+	ocf_volume_submit_io(io);
+}
+
+/*
+ * Zero line gets data written to sectors start..stop, so its other valid
+ * sectors are written with zeroes and it stops being zero line
+ */
+static void ocf_submit_zero_line_fill(struct ocf_request *req,
+		ocf_cache_line_t line, uint8_t start, uint8_t stop,
+		ocf_req_end_t callback)
+{
+	struct ocf_cache *cache = req->cache;
+	uint8_t end = ocf_line_end_sector(cache);
+
+	if (metadata_test_valid_any_out_sec(cache, line, start, stop)) {
+		if (start > 0)
+			ocf_submit_cache_zeroes(req, line, 0, start - 1,
+					callback);
+		if (stop < end)
+			ocf_submit_cache_zeroes(req, line, stop + 1, end,
+					callback);
+	}
+
+	ocf_metadata_set_zero(cache, line, false);
+}
+
+/* Number of cache lines from the first one served without cache IO */
+static uint32_t ocf_submit_zero_lines(struct ocf_request *req, int dir,
+		uint32_t first, uint32_t last, ocf_req_end_t callback)
+{
+	uint8_t start, stop;
+	uint32_t i;
+
+	for (i = first; i < last; i++) {
+		if (dir == OCF_WRITE) {
+			if (!ocf_zero_line_write(req, i))
+				break;
+		} else {
+			ocf_map_info_sectors(req, i, &start, &stop);
+			if (!ocf_zero_line_read(req, i, start, stop))
+				break;
+		}
+	}
+
+	/* Request may be completed here only if these were its last lines */
+	if (i > first)
+		ocf_submit_cache_lines_cmpl(req, callback, i - first);
+
+	return i - first;
+}
+
+/*
+ * Cuts run of cache lines before the first one served without cache IO.
+ * Zero lines of written run are filled first. Lines after the cut are
+ * checked again as first ones of the next run, which repeats the check.
+ */
+static uint32_t ocf_submit_zero_run(struct ocf_request *req, int dir,
+		uint32_t first, uint32_t run, ocf_req_end_t callback)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_cache_line_t line;
+	uint8_t start, stop;
+	uint32_t i;
+
+	for (i = first + 1; i < first + run; i++) {
+		if (dir == OCF_WRITE) {
+			if (ocf_zero_line_write(req, i))
+				break;
+		} else if (ocf_metadata_get_zero(cache,
+				req->map[i].coll_idx)) {
+			break;
+		}
+	}
+
+	run = i - first;
+
+	if (dir != OCF_WRITE)
+		return run;
+
+	for (i = first; i < first + run; i++) {
+		line = req->map[i].coll_idx;
+		if (!ocf_metadata_get_zero(cache, line))
+			continue;
+
+		ocf_map_info_sectors(req, i, &start, &stop);
+		ocf_submit_zero_line_fill(req, line, start, stop, callback);
+	}
+
+	return run;
+}
+
+/*
+ * Sectors of cache line are read or written separately. Zero line is read
+ * with zeroes, and gets the other valid sectors of request range filled
+ * once data is written, as sectors written separately are clean ones of
+ * backfill merged with dirty sectors of the line.
+ */
+static bool ocf_submit_zero_sectors(struct ocf_request *req, int dir,
+		uint32_t map_idx, uint8_t start, uint8_t stop,
+		ocf_req_end_t callback)
+{
+	struct ocf_cache *cache = req->cache;
+	ocf_cache_line_t line = req->map[map_idx].coll_idx;
+	uint8_t begin, end, s, e;
+
+	if (dir != OCF_WRITE) {
+		if (!ocf_zero_line_read(req, map_idx, start, stop))
+			return false;
+
+		callback(req, 0);
+		return true;
+	}
+
+	if (!ocf_metadata_get_zero(cache, line))
+		return false;
+
+	ocf_map_info_sectors(req, map_idx, &begin, &end);
+
+	for (s = begin; s <= end; s = e + 1) {
+		e = ocf_dirty_run_end(cache, line, s, end);
+		if (metadata_test_dirty_one(cache, line, s))
+			ocf_submit_cache_zeroes(req, line, s, e, callback);
+	}
+
+	ocf_submit_zero_line_fill(req, line, begin, end, callback);
+
+	return false;
+}
+#else
+static inline uint32_t ocf_submit_zero_lines(struct ocf_request *req,
+		int dir, uint32_t first, uint32_t last, ocf_req_end_t callback)
+{
+	return 0;
+}
+
+static inline uint32_t ocf_submit_zero_run(struct ocf_request *req,
+		int dir, uint32_t first, uint32_t run, ocf_req_end_t callback)
+{
+	return run;
+}
+
+static inline bool ocf_submit_zero_sectors(struct ocf_request *req, int dir,
+		uint32_t map_idx, uint8_t start, uint8_t stop,
+		ocf_req_end_t callback)
+{
+	return false;
+}
+#endif
+
 void ocf_submit_cache_reqs(struct ocf_cache *cache,
 		struct ocf_map_info *map_info, struct ocf_request *req, int dir,
 		unsigned int reqs, ocf_req_end_t callback)
@@ -241,12 +557,37 @@ void ocf_submit_cache_reqs(struct ocf_cache *cache,
 	uint64_t flags = req->io ? req->io->flags : 0;
 	uint32_t class = req->io ? req->io->io_class : 0;
 	uint64_t addr, bytes, total_bytes = 0;
+	uint32_t i, run, max_lines;
 	struct ocf_io *io;
-	uint32_t i;
 	int err;
 
-	cache_stats = &cache->core[req->core_id].
-			counters->cache_blocks;
+	cache_stats = &ocf_req_core_stats(req)->cache_blocks;
+
+	if (dir == OCF_WRITE && map_info == req->map) {
+		ocf_compress_est_sample(req, 0, req->core_line_count);
+		ocf_dedup_est_sample(req, 0, req->core_line_count);
+	}
+
+	if (cache->ram_tier && map_info == req->map) {
+		if (dir == OCF_WRITE) {
+			ocf_ram_tier_drop_req(req, 0, req->core_line_count);
+		} else if (dir == OCF_READ && ocf_ram_tier_read(req)) {
+			/* Served from RAM tier, no cache IO */
+			ocf_submit_cache_lines_cmpl(req, callback, reqs);
+			return;
+		}
+	}
+
+	if (OCF_CONFIG_ZERO_LINES && map_info == req->map &&
+			req->byte_length) {
+		/* Zero lines are served per cache line, so completions are
+		 * accounted per cache line as well */
+		env_atomic_add(req->core_line_count - reqs,
+				&req->req_remaining);
+		_ocf_submit_cache_lines(cache, req, dir, 0,
+				req->core_line_count, callback);
+		return;
+	}
 
 	if (reqs == 1) {
 		io = ocf_new_cache_io(cache);
@@ -259,42 +600,53 @@ void ocf_submit_cache_reqs(struct ocf_cache *cache,
 					map_info[0].coll_idx);
 		addr *= ocf_line_size(cache);
 		addr += cache->device->metadata_offset;
-		addr += (req->byte_position % ocf_line_size(cache));
+		addr += ocf_bytes_line_offset(cache, req->byte_position);
 		bytes = req->byte_length;
 
 		ocf_io_configure(io, addr, bytes, dir, class, flags);
 		ocf_io_set_queue(io, req->io_queue);
-		ocf_io_set_cmpl(io, req, callback, ocf_submit_volume_req_cmpl);
+		ocf_io_set_cmpl(io, req, callback, ocf_submit_cache_req_cmpl);
 
-		err = ocf_io_set_data(io, req->data, 0);
+		err = ocf_io_set_data(io, req->data, req->data_offset);
 		if (err) {
 			ocf_io_put(io);
 			callback(req, err);
 			goto update_stats;
 		}
 
+		ocf_trace_req_stage(req, ocf_event_req_stage_cache_io_submitted,
+				bytes);
 		ocf_volume_submit_io(io);
 		total_bytes = req->byte_length;
 
 		goto update_stats;
 	}
 
-	/* Issue requests to cache. */
-	for (i = 0; i < reqs; i++) {
+	max_lines = OCF_MAX(1U, ocf_volume_get_max_io_size(
+			&cache->device->volume) / ocf_line_size(cache));
+
+	ocf_volume_plug(&cache->device->volume);
+
+	/* Issue requests to cache, single IO per physically contiguous run
+	 * of cache lines. */
+	for (i = 0; i < reqs; i += run) {
+		run = ocf_submit_cache_run_length(cache, map_info, i, reqs,
+				max_lines);
+
 		io = ocf_new_cache_io(cache);
 
 		if (!io) {
 			/* Finish all IOs which left with ERROR */
 			for (; i < reqs; i++)
 				callback(req, -ENOMEM);
-			goto update_stats;
+			break;
 		}
 
 		addr  = ocf_metadata_map_lg2phy(cache,
 				map_info[i].coll_idx);
 		addr *= ocf_line_size(cache);
 		addr += cache->device->metadata_offset;
-		bytes = ocf_line_size(cache);
+		bytes = ocf_line_size(cache) * run;
 
 		if (i == 0) {
 			uint64_t seek = (req->byte_position %
@@ -302,30 +654,37 @@ void ocf_submit_cache_reqs(struct ocf_cache *cache,
 
 			addr += seek;
 			bytes -= seek;
-		} else  if (i == (reqs - 1)) {
-			uint64_t skip = (ocf_line_size(cache) -
-				((req->byte_position + req->byte_length) %
-				ocf_line_size(cache))) % ocf_line_size(cache);
+		}
+
+		if (i + run == reqs) {
+			uint64_t skip = ocf_bytes_line_offset(cache,
+				ocf_line_size(cache) - ocf_bytes_line_offset(
+				cache, req->byte_position + req->byte_length));
 
 			bytes -= skip;
 		}
 
 		ocf_io_configure(io, addr, bytes, dir, class, flags);
 		ocf_io_set_queue(io, req->io_queue);
-		ocf_io_set_cmpl(io, req, callback, ocf_submit_volume_req_cmpl);
+		ocf_io_set_cmpl(io, req, callback, ocf_submit_cache_run_cmpl);
 
-		err = ocf_io_set_data(io, req->data, total_bytes);
+		err = ocf_io_set_data(io, req->data,
+				req->data_offset + total_bytes);
 		if (err) {
 			ocf_io_put(io);
 			/* Finish all IOs which left with ERROR */
 			for (; i < reqs; i++)
 				callback(req, err);
-			goto update_stats;
+			break;
 		}
+		ocf_trace_req_stage(req, ocf_event_req_stage_cache_io_submitted,
+				bytes);
 		ocf_volume_submit_io(io);
 		total_bytes += bytes;
 	}
 
+	ocf_volume_unplug(&cache->device->volume);
+
 update_stats:
 	if (dir == OCF_WRITE)
 		env_atomic64_add(total_bytes, &cache_stats->write_bytes);
@@ -333,10 +692,209 @@ update_stats:
 		env_atomic64_add(total_bytes, &cache_stats->read_bytes);
 }
 
-void ocf_submit_volume_req(ocf_volume_t volume, struct ocf_request *req,
-		ocf_req_end_t callback)
+/* Byte range of request covered by map entries first .. first + count - 1 */
+static void ocf_req_lines_range(struct ocf_request *req, uint32_t first,
+		uint32_t count, uint64_t *offset, uint64_t *bytes)
 {
 	struct ocf_cache *cache = req->cache;
+	uint64_t start, end;
+
+	if (first)
+		start = ocf_lines_2_bytes(cache, req->core_line_first + first);
+	else
+		start = req->byte_position;
+
+	if (first + count < req->core_line_count) {
+		end = ocf_lines_2_bytes(cache,
+				req->core_line_first + first + count);
+	} else {
+		end = req->byte_position + req->byte_length;
+	}
+
+	*offset = start - req->byte_position;
+	*bytes = end - start;
+}
+
+static void _ocf_submit_cache_lines(struct ocf_cache *cache,
+		struct ocf_request *req, int dir, uint32_t first,
+		uint32_t count, ocf_req_end_t callback)
+{
+	struct ocf_counters_block *cache_stats;
+	uint64_t flags = req->io ? req->io->flags : 0;
+	uint32_t class = req->io ? req->io->io_class : 0;
+	uint64_t addr, offset, bytes, total_bytes = 0;
+	uint32_t i, run, max_lines, last = first + count;
+	struct ocf_io *io;
+	int err;
+
+	cache_stats = &ocf_req_core_stats(req)->cache_blocks;
+
+	max_lines = OCF_MAX(1U, ocf_volume_get_max_io_size(
+			&cache->device->volume) / ocf_line_size(cache));
+
+	ocf_volume_plug(&cache->device->volume);
+
+	for (i = first; i < last; i += run) {
+		run = ocf_submit_zero_lines(req, dir, i, last, callback);
+		if (run)
+			continue;
+
+		run = ocf_submit_cache_run_length(cache, req->map, i, last,
+				max_lines);
+		run = ocf_submit_zero_run(req, dir, i, run, callback);
+
+		io = ocf_new_cache_io(cache);
+		if (!io) {
+			/* Finish all IOs which left with ERROR */
+			for (; i < last; i++)
+				callback(req, -ENOMEM);
+			break;
+		}
+
+		ocf_req_lines_range(req, i, run, &offset, &bytes);
+
+		addr  = ocf_metadata_map_lg2phy(cache, req->map[i].coll_idx);
+		addr *= ocf_line_size(cache);
+		addr += cache->device->metadata_offset;
+		addr += ocf_bytes_line_offset(cache, req->byte_position + offset);
+
+		ocf_io_configure(io, addr, bytes, dir, class, flags);
+		ocf_io_set_queue(io, req->io_queue);
+		ocf_io_set_cmpl(io, req, callback, ocf_submit_cache_run_cmpl);
+
+		err = ocf_io_set_data(io, req->data, req->data_offset + offset);
+		if (err) {
+			ocf_io_put(io);
+			/* Finish all IOs which left with ERROR */
+			for (; i < last; i++)
+				callback(req, err);
+			break;
+		}
+		ocf_trace_req_stage(req, ocf_event_req_stage_cache_io_submitted,
+				bytes);
+		ocf_volume_submit_io(io);
+		total_bytes += bytes;
+	}
+
+	ocf_volume_unplug(&cache->device->volume);
+
+	if (dir == OCF_WRITE)
+		env_atomic64_add(total_bytes, &cache_stats->write_bytes);
+	else if (dir == OCF_READ)
+		env_atomic64_add(total_bytes, &cache_stats->read_bytes);
+}
+
+void ocf_submit_cache_lines(struct ocf_cache *cache, struct ocf_request *req,
+		int dir, uint32_t first, uint32_t count, ocf_req_end_t callback)
+{
+	if (dir == OCF_WRITE) {
+		ocf_ram_tier_drop_req(req, first, count);
+		ocf_compress_est_sample(req, first, count);
+		ocf_dedup_est_sample(req, first, count);
+	}
+
+	_ocf_submit_cache_lines(cache, req, dir, first, count, callback);
+}
+
+void ocf_submit_cache_sectors(struct ocf_cache *cache,
+		struct ocf_request *req, int dir, uint32_t map_idx,
+		uint8_t start, uint8_t stop, ocf_req_end_t callback)
+{
+	struct ocf_counters_block *cache_stats;
+	uint64_t flags = req->io ? req->io->flags : 0;
+	uint32_t class = req->io ? req->io->io_class : 0;
+	uint64_t addr, offset, bytes;
+	struct ocf_io *io;
+	int err;
+
+	cache_stats = &ocf_req_core_stats(req)->cache_blocks;
+
+	if (dir == OCF_WRITE)
+		ocf_ram_tier_drop_req(req, map_idx, 1);
+
+	if (ocf_submit_zero_sectors(req, dir, map_idx, start, stop, callback))
+		return;
+
+	io = ocf_new_cache_io(cache);
+	if (!io) {
+		callback(req, -ENOMEM);
+		return;
+	}
+
+	offset = ocf_lines_2_bytes(cache, req->core_line_first + map_idx) +
+			SECTORS_TO_BYTES(start) - req->byte_position;
+	bytes = SECTORS_TO_BYTES(stop - start + 1);
+
+	addr  = ocf_metadata_map_lg2phy(cache, req->map[map_idx].coll_idx);
+	addr *= ocf_line_size(cache);
+	addr += cache->device->metadata_offset;
+	addr += SECTORS_TO_BYTES(start);
+
+	ocf_io_configure(io, addr, bytes, dir, class, flags);
+	ocf_io_set_queue(io, req->io_queue);
+	ocf_io_set_cmpl(io, req, callback, ocf_submit_cache_req_cmpl);
+
+	err = ocf_io_set_data(io, req->data, req->data_offset + offset);
+	if (err) {
+		ocf_io_put(io);
+		callback(req, err);
+		return;
+	}
+
+	ocf_trace_req_stage(req, ocf_event_req_stage_cache_io_submitted,
+			bytes);
+	ocf_volume_submit_io(io);
+
+	if (dir == OCF_WRITE)
+		env_atomic64_add(bytes, &cache_stats->write_bytes);
+	else if (dir == OCF_READ)
+		env_atomic64_add(bytes, &cache_stats->read_bytes);
+}
+
+/* Weight of new sample in core read latency moving average */
+#define OCF_CORE_LATENCY_WEIGHT 8
+
+static void ocf_submit_core_read_cmpl(struct ocf_io *io, int error)
+{
+	struct ocf_request *req = io->priv1;
+	struct ocf_core *core = &req->cache->core[req->core_id];
+	int64_t sample, avg;
+
+	/* Latency is sampled before completion waits on I/O queue */
+	if (!error && !ocf_io_cmpl_steered(io)) {
+		sample = env_ticks_to_nsecs(env_get_tick_count() -
+				req->core_submit_ticks);
+		avg = env_atomic64_read(&core->read_latency);
+		avg = avg ? avg + (sample - avg) / OCF_CORE_LATENCY_WEIGHT :
+				sample;
+
+		/* Lost update only drops single sample */
+		env_atomic64_set(&core->read_latency, avg);
+	}
+
+	if (ocf_io_steer_cmpl(io, error))
+		return;
+
+	ocf_trace_req_stage(req, ocf_event_req_stage_core_io_completed, 0);
+
+	ocf_submit_volume_req_cmpl(io, error);
+}
+
+static void ocf_submit_core_write_cmpl(struct ocf_io *io, int error)
+{
+	if (ocf_io_steer_cmpl(io, error))
+		return;
+
+	ocf_trace_req_stage(io->priv1, ocf_event_req_stage_core_io_completed,
+			0);
+
+	ocf_submit_volume_req_cmpl(io, error);
+}
+
+static void _ocf_submit_volume_req(ocf_volume_t volume,
+		struct ocf_request *req, uint64_t offset, uint64_t bytes,
+		ocf_req_end_t callback)
+{
 	struct ocf_counters_block *core_stats;
 	uint64_t flags = req->io ? req->io->flags : 0;
 	uint32_t class = req->io ? req->io->io_class : 0;
@@ -344,12 +902,11 @@ void ocf_submit_volume_req(ocf_volume_t volume, struct ocf_request *req,
 	struct ocf_io *io;
 	int err;
 
-	core_stats = &cache->core[req->core_id].
-			counters->core_blocks;
+	core_stats = &ocf_req_core_stats(req)->core_blocks;
 	if (dir == OCF_WRITE)
-		env_atomic64_add(req->byte_length, &core_stats->write_bytes);
+		env_atomic64_add(bytes, &core_stats->write_bytes);
 	else if (dir == OCF_READ)
-		env_atomic64_add(req->byte_length, &core_stats->read_bytes);
+		env_atomic64_add(bytes, &core_stats->read_bytes);
 
 	io = ocf_volume_new_io(volume);
 	if (!io) {
@@ -357,15 +914,37 @@ void ocf_submit_volume_req(ocf_volume_t volume, struct ocf_request *req,
 		return;
 	}
 
-	ocf_io_configure(io, req->byte_position, req->byte_length, dir,
+	ocf_io_configure(io, req->byte_position + offset, bytes, dir,
 			class, flags);
 	ocf_io_set_queue(io, req->io_queue);
-	ocf_io_set_cmpl(io, req, callback, ocf_submit_volume_req_cmpl);
-	err = ocf_io_set_data(io, req->data, 0);
+	if (dir == OCF_READ) {
+		req->core_submit_ticks = env_get_tick_count();
+		ocf_io_set_cmpl(io, req, callback, ocf_submit_core_read_cmpl);
+	} else {
+		ocf_io_set_cmpl(io, req, callback, ocf_submit_core_write_cmpl);
+	}
+	err = ocf_io_set_data(io, req->data, req->data_offset + offset);
 	if (err) {
 		ocf_io_put(io);
 		callback(req, err);
 		return;
 	}
+	ocf_trace_req_stage(req, ocf_event_req_stage_core_io_submitted, bytes);
 	ocf_volume_submit_io(io);
 }
+
+void ocf_submit_volume_req(ocf_volume_t volume, struct ocf_request *req,
+		ocf_req_end_t callback)
+{
+	_ocf_submit_volume_req(volume, req, 0, req->byte_length, callback);
+}
+
+void ocf_submit_volume_req_lines(ocf_volume_t volume, struct ocf_request *req,
+		uint32_t first, uint32_t count, ocf_req_end_t callback)
+{
+	uint64_t offset, bytes;
+
+	ocf_req_lines_range(req, first, count, &offset, &bytes);
+
+	_ocf_submit_volume_req(volume, req, offset, bytes, callback);
+}
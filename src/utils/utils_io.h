@@ -60,11 +60,86 @@ void ocf_submit_cache_page(ocf_cache_t cache, uint64_t addr, int dir,
 void ocf_submit_volume_req(ocf_volume_t volume, struct ocf_request *req,
 		ocf_req_end_t callback);
 
+/**
+ * @brief Submit request IO for range of request cache lines to volume
+ *
+ * @param volume - volume to submit IO to
+ * @param req - OCF request
+ * @param first - index of first map entry of range
+ * @param count - number of map entries in range
+ * @param callback - called once IO is completed
+ */
+void ocf_submit_volume_req_lines(ocf_volume_t volume, struct ocf_request *req,
+		uint32_t first, uint32_t count, ocf_req_end_t callback);
 
+/**
+ * @brief Submit request IO to cache, single IO per run of physically
+ *	contiguous cache lines
+ *
+ * Callback is called once per cache line and must account completion in
+ * req->req_remaining, as successfully completed lines of single IO may be
+ * accounted there at once.
+ *
+ * @param cache - OCF cache instance
+ * @param map_info - map entries of cache lines
+ * @param req - OCF request
+ * @param dir - IO direction
+ * @param reqs - number of map entries
+ * @param callback - called on completion of each cache line
+ */
 void ocf_submit_cache_reqs(struct ocf_cache *cache,
 		struct ocf_map_info *map_info, struct ocf_request *req, int dir,
 		unsigned int reqs, ocf_req_end_t callback);
 
+/**
+ * @brief Submit cache IO for range of request cache lines
+ *
+ * Callback is called once per cache line, as in ocf_submit_cache_reqs().
+ *
+ * @param cache - OCF cache instance
+ * @param req - OCF request
+ * @param dir - IO direction
+ * @param first - index of first map entry of range
+ * @param count - number of map entries in range
+ * @param callback - called on completion of each cache line
+ */
+void ocf_submit_cache_lines(struct ocf_cache *cache, struct ocf_request *req,
+		int dir, uint32_t first, uint32_t count, ocf_req_end_t callback);
+
+/**
+ * @brief Submit cache IO for range of sectors of single request cache line
+ *
+ * Callback is called once. Sector range has to be within request.
+ *
+ * @param cache - OCF cache instance
+ * @param req - OCF request
+ * @param dir - IO direction
+ * @param map_idx - index of map entry of cache line
+ * @param start - first sector of range in cache line
+ * @param stop - last sector of range in cache line
+ * @param callback - called once IO is completed
+ */
+void ocf_submit_cache_sectors(struct ocf_cache *cache,
+		struct ocf_request *req, int dir, uint32_t map_idx,
+		uint8_t start, uint8_t stop, ocf_req_end_t callback);
+
+/**
+ * @brief Complete IOs from the beginning of array which can be accounted
+ *	to their request in one step
+ *
+ * Cache IOs of the same request and callback submitted with
+ * ocf_submit_cache_reqs() or ocf_submit_cache_lines() are completed
+ * together, any other IO is completed alone.
+ *
+ * @param ios - completed IOs
+ * @param errors - completion status of each IO, NULL if all succeeded
+ * @param count - number of IOs in array
+ *
+ * @retval Number of completed IOs
+ */
+uint32_t ocf_io_end_run(struct ocf_io **ios, const int *errors,
+		uint32_t count);
+
 static inline struct ocf_io *ocf_new_cache_io(struct ocf_cache *cache)
 {
 	return ocf_volume_new_io(&cache->device->volume);
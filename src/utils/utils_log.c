@@ -0,0 +1,100 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "utils_log.h"
+#include "../ocf_queue_priv.h"
+
+#if OCF_CONFIG_LOG_RING > 0
+
+bool ocf_log_ring_req_error(struct ocf_request *req, const char *msg)
+{
+	ocf_queue_t queue = req->io_queue;
+	struct ocf_log_ring_entry *entry;
+	uint32_t i;
+
+	if (!queue)
+		return false;
+
+	env_spinlock_lock(&queue->log_lock);
+
+	for (i = 0; i < queue->log_count; i++) {
+		entry = &queue->log_ring[i];
+		if (entry->msg == msg && entry->core_id == req->core_id) {
+			entry->count++;
+			goto unlock;
+		}
+	}
+
+	if (queue->log_count == OCF_CONFIG_LOG_RING) {
+		queue->log_dropped++;
+		goto unlock;
+	}
+
+	entry = &queue->log_ring[queue->log_count++];
+	entry->msg = msg;
+	entry->sector = BYTES_TO_SECTORS(req->byte_position);
+	entry->bytes = req->byte_length;
+	entry->count = 1;
+	entry->core_id = req->core_id;
+
+unlock:
+	env_spinlock_unlock(&queue->log_lock);
+
+	return true;
+}
+
+void ocf_log_ring_flush(ocf_queue_t queue)
+{
+	struct ocf_log_ring_entry ring[OCF_CONFIG_LOG_RING];
+	struct ocf_log_ring_entry *entry;
+	ocf_cache_t cache = queue->cache;
+	uint32_t count, dropped, i;
+
+	if (!cache || (!queue->log_count && !queue->log_dropped))
+		return;
+
+	/* Messages are logged outside of lock, which I/O path takes */
+	env_spinlock_lock(&queue->log_lock);
+	count = queue->log_count;
+	dropped = queue->log_dropped;
+	for (i = 0; i < count; i++)
+		ring[i] = queue->log_ring[i];
+	queue->log_count = 0;
+	queue->log_dropped = 0;
+	env_spinlock_unlock(&queue->log_lock);
+
+	for (i = 0; i < count; i++) {
+		entry = &ring[i];
+
+		if (entry->count == 1) {
+			ocf_core_log(&cache->core[entry->core_id], log_err,
+					"%s sector: %" ENV_PRIu64 ", bytes: %u\n",
+					entry->msg, entry->sector, entry->bytes);
+		} else {
+			ocf_core_log(&cache->core[entry->core_id], log_err,
+					"%s sector: %" ENV_PRIu64 ", bytes: %u "
+					"(repeated %u times)\n", entry->msg,
+					entry->sector, entry->bytes,
+					entry->count);
+		}
+	}
+
+	if (dropped) {
+		ocf_cache_log(cache, log_err, "%u error messages dropped\n",
+				dropped);
+	}
+}
+
+void ocf_log_ring_flush_all(ocf_cache_t cache)
+{
+	ocf_queue_t queue;
+
+	env_rwlock_read_lock(&cache->io_queues_lock);
+	list_for_each_entry(queue, &cache->io_queues, list)
+		ocf_log_ring_flush(queue);
+	env_rwlock_read_unlock(&cache->io_queues_lock);
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_LOG_H__
+#define __UTILS_LOG_H__
+
+#include "../ocf_cache_priv.h"
+
+/**
+ * @file utils_log.h
+ * @brief Log rings of I/O queues
+ *
+ * Messages of I/O error paths are put into log ring of request queue,
+ * where repeated ones are coalesced, and are logged later by cleaner, so
+ * that I/O never waits for logging.
+ */
+
+#if OCF_CONFIG_LOG_RING > 0
+/**
+ * @brief Put error message of request into log ring of its queue
+ *
+ * @param req - Failed request
+ * @param msg - Message, has to be static string
+ *
+ * @retval false if message has to be logged by caller
+ */
+bool ocf_log_ring_req_error(struct ocf_request *req, const char *msg);
+
+/**
+ * @brief Log and empty log ring of queue
+ *
+ * @param queue - I/O queue
+ */
+void ocf_log_ring_flush(ocf_queue_t queue);
+
+/**
+ * @brief Log and empty log rings of all I/O queues of cache
+ *
+ * @param cache - Cache
+ */
+void ocf_log_ring_flush_all(ocf_cache_t cache);
+#else
+static inline bool ocf_log_ring_req_error(struct ocf_request *req,
+		const char *msg)
+{
+	return false;
+}
+
+static inline void ocf_log_ring_flush(ocf_queue_t queue)
+{
+}
+
+static inline void ocf_log_ring_flush_all(ocf_cache_t cache)
+{
+}
+#endif
+
+#endif /* __UTILS_LOG_H__ */
@@ -0,0 +1,200 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "utils_mode_advisor.h"
+#include "utils_core.h"
+#include "../ocf_cache_priv.h"
+#include "../engine/cache_engine.h"
+
+/* Minimum number of requests of interval for mode to be picked */
+#define OCF_MODE_ADVISOR_MIN_REQS 1024
+
+/* Write share of read-mostly core (percent) */
+#define OCF_MODE_ADVISOR_READ_MOSTLY 10
+
+/* Write share or write hit ratio of core worth writing back (percent) */
+#define OCF_MODE_ADVISOR_WRITE_HEAVY 50
+
+/* Write hit ratio below which written data is not worth caching (percent) */
+#define OCF_MODE_ADVISOR_REWRITE_LOW 10
+
+#define OCF_MODE_ADVISOR_DEFAULT_MODES ((1 << ocf_cache_mode_wt) | \
+		(1 << ocf_cache_mode_wb) | (1 << ocf_cache_mode_wa))
+
+/* Modes advised instead of picked one if it is not allowed, in order */
+static const ocf_cache_mode_t ocf_mode_advisor_fallback[][4] = {
+	[ocf_cache_mode_wt] = { ocf_cache_mode_wt, ocf_cache_mode_wa,
+			ocf_cache_mode_wi, ocf_cache_mode_wb },
+	[ocf_cache_mode_wb] = { ocf_cache_mode_wb, ocf_cache_mode_wt,
+			ocf_cache_mode_wa, ocf_cache_mode_wi },
+	[ocf_cache_mode_wa] = { ocf_cache_mode_wa, ocf_cache_mode_wi,
+			ocf_cache_mode_wt, ocf_cache_mode_wb },
+};
+
+struct ocf_mode_advisor_counters {
+	uint64_t reads, read_hits, writes, write_hits;
+};
+
+static void ocf_mode_advisor_read(ocf_core_t core,
+		struct ocf_mode_advisor_counters *counters)
+{
+	struct ocf_counters_part *part;
+	uint64_t read_misses = 0, write_misses = 0;
+	int shard, part_id;
+
+	counters->reads = 0;
+	counters->writes = 0;
+
+	for (shard = 0; shard < OCF_STATS_SHARDS; shard++) {
+		for (part_id = 0; part_id < OCF_IO_CLASS_MAX; part_id++) {
+			part = &core->counters[shard].part_counters[part_id];
+
+			counters->reads += env_atomic64_read(
+					&part->read_reqs.total);
+			read_misses += env_atomic64_read(
+					&part->read_reqs.partial_miss) +
+				env_atomic64_read(&part->read_reqs.full_miss);
+			counters->writes += env_atomic64_read(
+					&part->write_reqs.total);
+			write_misses += env_atomic64_read(
+					&part->write_reqs.partial_miss) +
+				env_atomic64_read(&part->write_reqs.full_miss);
+		}
+	}
+
+	counters->read_hits = counters->reads - read_misses;
+	counters->write_hits = counters->writes - write_misses;
+}
+
+/* Counter which went backwards was reset, so whole value is the increase */
+static inline uint64_t ocf_mode_advisor_delta(uint64_t curr, uint64_t prev)
+{
+	return curr >= prev ? curr - prev : curr;
+}
+
+static ocf_cache_mode_t ocf_mode_advisor_pick(
+		const struct ocf_mode_advisor_counters *delta)
+{
+	uint64_t total = delta->reads + delta->writes;
+	uint64_t write_pct, rewrite_pct;
+
+	if (total < OCF_MODE_ADVISOR_MIN_REQS)
+		return ocf_cache_mode_none;
+
+	write_pct = delta->writes * 100 / total;
+	rewrite_pct = delta->writes ?
+			delta->write_hits * 100 / delta->writes : 0;
+
+	if (write_pct <= OCF_MODE_ADVISOR_READ_MOSTLY)
+		return ocf_cache_mode_wt;
+
+	if (write_pct >= OCF_MODE_ADVISOR_WRITE_HEAVY ||
+			rewrite_pct >= OCF_MODE_ADVISOR_WRITE_HEAVY) {
+		return ocf_cache_mode_wb;
+	}
+
+	if (rewrite_pct < OCF_MODE_ADVISOR_REWRITE_LOW)
+		return ocf_cache_mode_wa;
+
+	return ocf_cache_mode_wb;
+}
+
+static ocf_cache_mode_t ocf_mode_advisor_allowed(ocf_core_t core,
+		ocf_cache_mode_t mode)
+{
+	const ocf_cache_mode_t *fallback = ocf_mode_advisor_fallback[mode];
+	uint32_t allowed = core->mode_advisor.allowed_modes ?:
+			OCF_MODE_ADVISOR_DEFAULT_MODES;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(ocf_mode_advisor_fallback[mode]); i++) {
+		if (allowed & (1 << fallback[i]))
+			return fallback[i];
+	}
+
+	return ocf_cache_mode_none;
+}
+
+static void ocf_mode_advisor_update(ocf_core_t core)
+{
+	struct ocf_core_mode_advisor *advisor = &core->mode_advisor;
+	struct ocf_mode_advisor_counters curr, delta;
+	ocf_cache_mode_t pick;
+
+	ocf_mode_advisor_read(core, &curr);
+
+	delta.reads = ocf_mode_advisor_delta(curr.reads, advisor->reads);
+	delta.read_hits = ocf_mode_advisor_delta(curr.read_hits,
+			advisor->read_hits);
+	delta.writes = ocf_mode_advisor_delta(curr.writes, advisor->writes);
+	delta.write_hits = ocf_mode_advisor_delta(curr.write_hits,
+			advisor->write_hits);
+
+	advisor->reads = curr.reads;
+	advisor->read_hits = curr.read_hits;
+	advisor->writes = curr.writes;
+	advisor->write_hits = curr.write_hits;
+
+	/* Interval with too little IO keeps advised mode */
+	pick = ocf_mode_advisor_pick(&delta);
+	if (pick == ocf_cache_mode_none)
+		return;
+
+	pick = ocf_mode_advisor_allowed(core, pick);
+
+	if (pick == advisor->pick &&
+			pick != env_atomic_read(&advisor->mode)) {
+		env_atomic_set(&advisor->mode, pick);
+		ocf_core_log(core, log_info, "Advised cache mode %s\n",
+				ocf_get_io_iface_name(pick));
+	}
+
+	advisor->pick = pick;
+}
+
+void ocf_mode_advisor_reset(ocf_core_t core)
+{
+	struct ocf_core_mode_advisor *advisor = &core->mode_advisor;
+	struct ocf_mode_advisor_counters curr;
+
+	ocf_mode_advisor_read(core, &curr);
+
+	advisor->reads = curr.reads;
+	advisor->read_hits = curr.read_hits;
+	advisor->writes = curr.writes;
+	advisor->write_hits = curr.write_hits;
+	advisor->pick = ocf_cache_mode_none;
+	env_atomic_set(&advisor->mode, ocf_cache_mode_none);
+}
+
+void ocf_mode_advisor_tick(ocf_cache_t cache)
+{
+	ocf_core_id_t core_id;
+	ocf_core_t core;
+	uint64_t now;
+
+	now = env_get_tick_count();
+	if (env_ticks_to_msecs(now - cache->mode_advisor.last_ticks) <
+			OCF_CONFIG_MODE_ADVISOR_INTERVAL_MS) {
+		return;
+	}
+
+	/* Cleaner instances run concurrently, one closes the interval */
+	if (env_atomic_cmpxchg(&cache->mode_advisor.busy, 0, 1))
+		return;
+
+	for_each_core(cache, core_id) {
+		core = &cache->core[core_id];
+
+		if (core->mode_advisor.policy != ocf_mode_advisor_off &&
+				core->counters) {
+			ocf_mode_advisor_update(core);
+		}
+	}
+
+	cache->mode_advisor.last_ticks = now;
+
+	env_atomic_set(&cache->mode_advisor.busy, 0);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_MODE_ADVISOR_H__
+#define __UTILS_MODE_ADVISOR_H__
+
+#include "../ocf_core_priv.h"
+
+/**
+ * @file utils_mode_advisor.h
+ * @brief Cache mode advisor of core
+ *
+ * Cache mode is picked from read/write ratio and write hit ratio of IO of
+ * core in last interval. Advised mode follows pick once it was the same in
+ * two intervals in a row.
+ */
+
+/**
+ * @brief Restart advisor of core, counters of current interval start now
+ *
+ * @param core - Core
+ */
+void ocf_mode_advisor_reset(ocf_core_t core);
+
+/**
+ * @brief Close interval of advisors of cache cores, if it has elapsed
+ *
+ * @param cache - Cache
+ */
+void ocf_mode_advisor_tick(ocf_cache_t cache);
+
+/* Cache mode to apply to IO of core, ocf_cache_mode_none if there is none */
+static inline ocf_cache_mode_t ocf_mode_advisor_get(ocf_core_t core)
+{
+	if (likely(core->mode_advisor.policy != ocf_mode_advisor_apply))
+		return ocf_cache_mode_none;
+
+	return env_atomic_read(&core->mode_advisor.mode);
+}
+
+#endif /* __UTILS_MODE_ADVISOR_H__ */
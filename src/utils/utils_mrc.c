@@ -0,0 +1,365 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_priv.h"
+#include "utils_mrc.h"
+
+struct ocf_mrc_key {
+	uint64_t hash;
+	uint32_t stamp;
+	uint32_t heap_idx;
+};
+
+struct ocf_mrc {
+	env_spinlock lock;
+
+	uint64_t threshold;
+	/*!< Keys with hash below threshold are sampled */
+
+	uint32_t size;
+	uint32_t count;
+	/*!< Number of tracked keys */
+
+	uint32_t clock;
+	/*!< Stamp of next reference */
+
+	uint32_t stamps;
+	/*!< Number of stamps before they are renumbered */
+
+	uint32_t table_mask;
+
+	uint64_t references;
+	/*!< Number of sampled references */
+
+	uint64_t weight;
+	/*!< Estimated number of all references */
+
+	uint64_t distinct;
+	/*!< Estimated number of distinct keys */
+
+	uint64_t hist[OCF_STATS_MRC_POINTS + 1];
+	/*!< Estimated references by smallest power of two cache they hit in,
+	 * last entry counts cold references. Each sampled reference counts
+	 * with reciprocal of sampling rate at the time it was made.
+	 */
+
+	struct ocf_mrc_key *keys;
+
+	uint32_t *table;
+	/*!< Open addressing hash table of key indexes + 1 */
+
+	uint32_t *heap;
+	/*!< Key indexes, max-heap by hash */
+
+	uint32_t *tree;
+	/*!< Fenwick tree counting live stamps */
+
+	uint32_t *rank;
+	/*!< Scratch space for renumbering stamps */
+};
+
+static inline uint64_t _ocf_mrc_hash(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+
+	return key;
+}
+
+/* Reciprocal of sampling rate */
+static inline uint64_t _ocf_mrc_scale(struct ocf_mrc *mrc)
+{
+	return (1ULL << 32) / ((mrc->threshold >> 32) + 1);
+}
+
+static void _ocf_mrc_tree_add(struct ocf_mrc *mrc, uint32_t stamp, int delta)
+{
+	uint32_t i;
+
+	for (i = stamp + 1; i <= mrc->stamps; i += i & -i)
+		mrc->tree[i] += delta;
+}
+
+/* Number of live stamps not greater than stamp */
+static uint32_t _ocf_mrc_tree_sum(struct ocf_mrc *mrc, uint32_t stamp)
+{
+	uint32_t i, sum = 0;
+
+	for (i = stamp + 1; i > 0; i -= i & -i)
+		sum += mrc->tree[i];
+
+	return sum;
+}
+
+static uint32_t *_ocf_mrc_table_slot(struct ocf_mrc *mrc, uint64_t hash)
+{
+	uint32_t pos = hash & mrc->table_mask;
+
+	while (mrc->table[pos] &&
+			mrc->keys[mrc->table[pos] - 1].hash != hash) {
+		pos = (pos + 1) & mrc->table_mask;
+	}
+
+	return &mrc->table[pos];
+}
+
+static void _ocf_mrc_table_remove(struct ocf_mrc *mrc, uint64_t hash)
+{
+	uint32_t pos, next, home;
+
+	pos = _ocf_mrc_table_slot(mrc, hash) - mrc->table;
+	mrc->table[pos] = 0;
+
+	/* Shift back entries which would be unreachable past the hole */
+	for (next = (pos + 1) & mrc->table_mask; mrc->table[next];
+			next = (next + 1) & mrc->table_mask) {
+		home = mrc->keys[mrc->table[next] - 1].hash & mrc->table_mask;
+
+		if (((next - home) & mrc->table_mask) >=
+				((next - pos) & mrc->table_mask)) {
+			mrc->table[pos] = mrc->table[next];
+			mrc->table[next] = 0;
+			pos = next;
+		}
+	}
+}
+
+static void _ocf_mrc_heap_set(struct ocf_mrc *mrc, uint32_t idx, uint32_t key)
+{
+	mrc->heap[idx] = key;
+	mrc->keys[key].heap_idx = idx;
+}
+
+static void _ocf_mrc_heap_up(struct ocf_mrc *mrc, uint32_t idx)
+{
+	uint32_t key = mrc->heap[idx], parent;
+
+	while (idx) {
+		parent = (idx - 1) / 2;
+		if (mrc->keys[mrc->heap[parent]].hash >= mrc->keys[key].hash)
+			break;
+		_ocf_mrc_heap_set(mrc, idx, mrc->heap[parent]);
+		idx = parent;
+	}
+
+	_ocf_mrc_heap_set(mrc, idx, key);
+}
+
+static void _ocf_mrc_heap_down(struct ocf_mrc *mrc, uint32_t idx)
+{
+	uint32_t key = mrc->heap[idx], child;
+
+	while ((child = 2 * idx + 1) < mrc->count) {
+		if (child + 1 < mrc->count &&
+				mrc->keys[mrc->heap[child + 1]].hash >
+				mrc->keys[mrc->heap[child]].hash) {
+			child++;
+		}
+		if (mrc->keys[key].hash >= mrc->keys[mrc->heap[child]].hash)
+			break;
+		_ocf_mrc_heap_set(mrc, idx, mrc->heap[child]);
+		idx = child;
+	}
+
+	_ocf_mrc_heap_set(mrc, idx, key);
+}
+
+/* Drop key with the largest hash, keeping keys table dense */
+static void _ocf_mrc_evict(struct ocf_mrc *mrc)
+{
+	uint32_t victim = mrc->heap[0], last;
+
+	_ocf_mrc_table_remove(mrc, mrc->keys[victim].hash);
+	_ocf_mrc_tree_add(mrc, mrc->keys[victim].stamp, -1);
+
+	mrc->count--;
+	if (mrc->count) {
+		_ocf_mrc_heap_set(mrc, 0, mrc->heap[mrc->count]);
+		_ocf_mrc_heap_down(mrc, 0);
+	}
+
+	last = mrc->count;
+	if (victim != last) {
+		mrc->keys[victim] = mrc->keys[last];
+		mrc->heap[mrc->keys[victim].heap_idx] = victim;
+		*_ocf_mrc_table_slot(mrc, mrc->keys[victim].hash) = victim + 1;
+	}
+}
+
+/* Renumber stamps of tracked keys to 0..count-1 keeping their order */
+static void _ocf_mrc_renumber(struct ocf_mrc *mrc)
+{
+	uint32_t i;
+
+	for (i = 0; i < mrc->count; i++)
+		mrc->rank[i] = _ocf_mrc_tree_sum(mrc, mrc->keys[i].stamp) - 1;
+
+	ENV_BUG_ON(env_memset(mrc->tree, sizeof(*mrc->tree) *
+			(mrc->stamps + 1), 0));
+
+	for (i = 0; i < mrc->count; i++) {
+		mrc->keys[i].stamp = mrc->rank[i];
+		_ocf_mrc_tree_add(mrc, mrc->rank[i], 1);
+	}
+
+	mrc->clock = mrc->count;
+}
+
+static uint32_t _ocf_mrc_bucket(uint64_t distance)
+{
+	uint32_t bucket = 0;
+
+	/* Reference hits in cache of 2^bucket lines or larger */
+	while (distance && bucket < OCF_STATS_MRC_POINTS) {
+		distance >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+struct ocf_mrc *ocf_mrc_init(uint32_t size)
+{
+	struct ocf_mrc *mrc;
+	uint32_t table_size = 1;
+	void *mem;
+
+	while (table_size < 2 * size)
+		table_size <<= 1;
+
+	mrc = env_vzalloc(sizeof(*mrc) + sizeof(*mrc->keys) * size +
+			sizeof(*mrc->table) * table_size +
+			sizeof(*mrc->heap) * size +
+			sizeof(*mrc->tree) * (4 * size + 1) +
+			sizeof(*mrc->rank) * size);
+	if (!mrc)
+		return NULL;
+
+	mem = mrc + 1;
+	mrc->keys = mem;
+	mrc->table = (uint32_t *)(mrc->keys + size);
+	mrc->heap = mrc->table + table_size;
+	mrc->tree = mrc->heap + size;
+	mrc->rank = mrc->tree + 4 * size + 1;
+
+	env_spinlock_init(&mrc->lock);
+	mrc->size = size;
+	mrc->stamps = 4 * size;
+	mrc->table_mask = table_size - 1;
+	mrc->threshold = ~0ULL;
+
+	return mrc;
+}
+
+void ocf_mrc_deinit(struct ocf_mrc *mrc)
+{
+	env_vfree(mrc);
+}
+
+void ocf_mrc_reset(struct ocf_mrc *mrc)
+{
+	env_spinlock_lock(&mrc->lock);
+
+	ENV_BUG_ON(env_memset(mrc->table, sizeof(*mrc->table) *
+			(mrc->table_mask + 1), 0));
+	ENV_BUG_ON(env_memset(mrc->tree, sizeof(*mrc->tree) *
+			(mrc->stamps + 1), 0));
+	ENV_BUG_ON(env_memset(mrc->hist, sizeof(mrc->hist), 0));
+
+	mrc->threshold = ~0ULL;
+	mrc->count = 0;
+	mrc->clock = 0;
+	mrc->references = 0;
+	mrc->weight = 0;
+	mrc->distinct = 0;
+
+	env_spinlock_unlock(&mrc->lock);
+}
+
+void ocf_mrc_access(struct ocf_mrc *mrc, uint64_t key)
+{
+	uint64_t hash = _ocf_mrc_hash(key);
+	uint32_t *slot, idx, distance;
+	uint64_t scale;
+
+	/* Racy check filters out most of not sampled keys without locking */
+	if (hash >= mrc->threshold)
+		return;
+
+	env_spinlock_lock(&mrc->lock);
+
+	if (hash >= mrc->threshold)
+		goto unlock;
+
+	scale = _ocf_mrc_scale(mrc);
+
+	mrc->references++;
+	mrc->weight += scale;
+
+	if (mrc->clock == mrc->stamps)
+		_ocf_mrc_renumber(mrc);
+
+	slot = _ocf_mrc_table_slot(mrc, hash);
+	if (*slot) {
+		idx = *slot - 1;
+
+		/* Number of distinct keys referenced since last reference */
+		distance = mrc->count - _ocf_mrc_tree_sum(mrc,
+				mrc->keys[idx].stamp);
+		mrc->hist[_ocf_mrc_bucket(distance * scale)] += scale;
+
+		_ocf_mrc_tree_add(mrc, mrc->keys[idx].stamp, -1);
+	} else {
+		mrc->hist[OCF_STATS_MRC_POINTS] += scale;
+		mrc->distinct += scale;
+
+		if (mrc->count == mrc->size) {
+			if (hash > mrc->keys[mrc->heap[0]].hash) {
+				mrc->threshold = hash;
+				goto unlock;
+			}
+			mrc->threshold = mrc->keys[mrc->heap[0]].hash;
+			_ocf_mrc_evict(mrc);
+		}
+
+		idx = mrc->count++;
+		mrc->keys[idx].hash = hash;
+		_ocf_mrc_heap_set(mrc, idx, idx);
+		_ocf_mrc_heap_up(mrc, idx);
+		*_ocf_mrc_table_slot(mrc, hash) = idx + 1;
+	}
+
+	mrc->keys[idx].stamp = mrc->clock++;
+	_ocf_mrc_tree_add(mrc, mrc->keys[idx].stamp, 1);
+
+unlock:
+	env_spinlock_unlock(&mrc->lock);
+}
+
+void ocf_mrc_get(struct ocf_mrc *mrc, struct ocf_stats_mrc *stats)
+{
+	uint64_t hits = 0;
+	uint32_t i;
+
+	ENV_BUG_ON(env_memset(stats, sizeof(*stats), 0));
+
+	env_spinlock_lock(&mrc->lock);
+
+	stats->references = mrc->references;
+	stats->working_set = mrc->distinct;
+	stats->sampling_ppm = ((mrc->threshold >> 32) * 1000000) >> 32;
+
+	for (i = 0; i < OCF_STATS_MRC_POINTS; i++) {
+		hits += mrc->hist[i];
+		stats->hit_ratio[i] = mrc->weight ?
+				hits * 1000 / mrc->weight : 0;
+	}
+
+	env_spinlock_unlock(&mrc->lock);
+}
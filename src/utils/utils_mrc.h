@@ -0,0 +1,63 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_MRC_H__
+#define __UTILS_MRC_H__
+
+#include "ocf/ocf.h"
+
+/**
+ * @file utils_mrc.h
+ * @brief Sampling miss ratio curve estimator
+ *
+ * Fixed-size SHARDS: keys whose hash falls below threshold are sampled and
+ * LRU reuse distances of sampled keys are measured, scaled by sampling
+ * rate. When tracked keys exceed given size, key with the largest hash is
+ * dropped and threshold is lowered to its hash, so memory stays constant
+ * whatever the working set is.
+ */
+
+struct ocf_mrc;
+
+/**
+ * @brief Allocate estimator
+ *
+ * @param size - Maximum number of tracked sampled keys
+ *
+ * @retval Estimator, NULL if allocation failed
+ */
+struct ocf_mrc *ocf_mrc_init(uint32_t size);
+
+/**
+ * @brief Free estimator
+ *
+ * @param mrc - Estimator
+ */
+void ocf_mrc_deinit(struct ocf_mrc *mrc);
+
+/**
+ * @brief Forget all references seen by estimator
+ *
+ * @param mrc - Estimator
+ */
+void ocf_mrc_reset(struct ocf_mrc *mrc);
+
+/**
+ * @brief Account reference of key
+ *
+ * @param mrc - Estimator
+ * @param key - Referenced key
+ */
+void ocf_mrc_access(struct ocf_mrc *mrc, uint64_t key);
+
+/**
+ * @brief Get estimated miss ratio curve
+ *
+ * @param mrc - Estimator
+ * @param stats - Miss ratio curve statistics
+ */
+void ocf_mrc_get(struct ocf_mrc *mrc, struct ocf_stats_mrc *stats);
+
+#endif /* __UTILS_MRC_H__ */
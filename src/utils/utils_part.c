@@ -81,12 +81,105 @@ static int ocf_part_lst_cmp_valid(struct ocf_cache *cache,
 
 int ocf_part_init(struct ocf_cache *cache)
 {
+	ocf_part_id_t part_id;
+
 	ocf_lst_init(cache, &cache->lst_part, OCF_IO_CLASS_MAX,
 			ocf_part_lst_getter_valid, ocf_part_lst_cmp_valid);
 
+	for (part_id = 0; part_id <= OCF_IO_CLASS_MAX; part_id++) {
+		cache->user_parts[part_id].evict_rank =
+				OCF_PART_EVICT_RANK_NONE;
+	}
+
 	return 0;
 }
 
+void ocf_part_sort(struct ocf_cache *cache)
+{
+	struct ocf_part_evict_plan *plan = &cache->part_evict;
+	bool attached = ocf_cache_is_device_attached(cache);
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+	uint16_t rank = 0;
+
+	ocf_lst_sort(&cache->lst_part);
+
+	for (part_id = 0; part_id <= OCF_IO_CLASS_MAX; part_id++) {
+		cache->user_parts[part_id].evict_rank =
+				OCF_PART_EVICT_RANK_NONE;
+	}
+
+	/* Rebuild eviction plan in order of sorted partition list */
+	ENV_BUG_ON(env_memset(plan->evictable, sizeof(plan->evictable), 0));
+
+	for_each_part(cache, part, part_id) {
+		part->evict_rank = rank;
+		plan->order[rank] = part_id;
+
+		if (attached && ocf_part_is_evictable(part))
+			env_bit_set(rank, plan->evictable);
+
+		rank++;
+	}
+
+	plan->count = rank;
+
+	env_atomic_inc(&cache->part_sort_gen);
+}
+
+static void _ocf_part_move_line(struct ocf_cache *cache,
+		ocf_cache_line_t line, ocf_core_id_t core_id,
+		ocf_part_id_t id_old, ocf_part_id_t id_new)
+{
+	ocf_cleaning_t type = cache->conf_meta->cleaning_policy_type;
+
+	ENV_BUG_ON(type >= ocf_cleaning_max);
+
+	/* Remove from old eviction */
+	ocf_eviction_purge_cache_line(cache, line);
+
+	if (metadata_test_dirty(cache, line)) {
+		/*
+		 * Remove cline from cleaning - this if for ioclass
+		 * oriented cleaning policy (e.g. ALRU).
+		 * TODO: Consider adding update_cache_line() ops
+		 * to cleaning policy to let policies handle this.
+		 */
+		if (cleaning_policy_ops[type].purge_cache_block)
+			cleaning_policy_ops[type].
+					purge_cache_block(cache, line);
+	}
+
+	/* Let's change partition */
+	ocf_metadata_remove_from_partition(cache, id_old, line);
+	ocf_metadata_add_to_partition(cache, id_new, line);
+
+	/* Add to new eviction */
+	ocf_eviction_init_cache_line(cache, line, id_new);
+	ocf_eviction_set_hot_cache_line(cache, line);
+
+	/* Check if cache line is dirty. If yes then need to change
+	 * cleaning  policy and update partition dirty clines
+	 * statistics.
+	 */
+	if (metadata_test_dirty(cache, line)) {
+		/* Add cline back to cleaning policy */
+		if (cleaning_policy_ops[type].set_hot_cache_line)
+			cleaning_policy_ops[type].
+				set_hot_cache_line(cache, line);
+
+		env_atomic_inc(&cache->core_runtime_meta[core_id].
+				part_counters[id_new].dirty_clines);
+		env_atomic_dec(&cache->core_runtime_meta[core_id].
+				part_counters[id_old].dirty_clines);
+	}
+
+	env_atomic_inc(&cache->core_runtime_meta[core_id].
+			part_counters[id_new].cached_clines);
+	env_atomic_dec(&cache->core_runtime_meta[core_id].
+			part_counters[id_old].cached_clines);
+}
+
 void ocf_part_move(struct ocf_request *req)
 {
 	struct ocf_cache *cache = req->cache;
@@ -94,9 +187,6 @@ void ocf_part_move(struct ocf_request *req)
 	ocf_cache_line_t line;
 	ocf_part_id_t id_old, id_new;
 	uint32_t i;
-	ocf_cleaning_t type = cache->conf_meta->cleaning_policy_type;
-
-	ENV_BUG_ON(type >= ocf_cleaning_max);
 
 	entry = &req->map[0];
 	for (i = 0; i < req->core_line_count; i++, entry++) {
@@ -124,52 +214,187 @@ void ocf_part_move(struct ocf_request *req)
 			continue;
 		}
 
-		/* Remove from old eviction */
-		ocf_eviction_purge_cache_line(cache, line);
+		_ocf_part_move_line(cache, line, req->core_id, id_old, id_new);
+	}
+}
 
-		if (metadata_test_dirty(cache, line)) {
-			/*
-			 * Remove cline from cleaning - this if for ioclass
-			 * oriented cleaning policy (e.g. ALRU).
-			 * TODO: Consider adding update_cache_line() ops
-			 * to cleaning policy to let policies handle this.
-			 */
-			if (cleaning_policy_ops[type].purge_cache_block)
-				cleaning_policy_ops[type].
-						purge_cache_block(cache, line);
-		}
+#if OCF_CONFIG_PART_MOVE_BATCH > 0
+void ocf_part_move_apply(struct ocf_cache *cache)
+{
+	struct ocf_part_move_entry *move;
+	ocf_part_id_t id_old;
+	ocf_core_id_t core_id;
+	uint64_t core_line;
+	uint32_t i;
 
-		/* Let's change partition */
-		ocf_metadata_remove_from_partition(cache, id_old, line);
-		ocf_metadata_add_to_partition(cache, id_new, line);
+	env_spinlock_lock(&cache->part_moves.lock);
 
-		/* Add to new eviction */
-		ocf_eviction_init_cache_line(cache, line, id_new);
-		ocf_eviction_set_hot_cache_line(cache, line);
+	for (i = 0; i < cache->part_moves.count; i++) {
+		move = &cache->part_moves.entries[i];
 
-		/* Check if cache line is dirty. If yes then need to change
-		 * cleaning  policy and update partition dirty clines
-		 * statistics.
+		/* Cache line might have been evicted and remapped since
+		 * the move was queued
 		 */
-		if (metadata_test_dirty(cache, line)) {
-			/* Add cline back to cleaning policy */
-			if (cleaning_policy_ops[type].set_hot_cache_line)
-				cleaning_policy_ops[type].
-					set_hot_cache_line(cache, line);
-
-			env_atomic_inc(&cache->core_runtime_meta[req->core_id].
-					part_counters[id_new].dirty_clines);
-			env_atomic_dec(&cache->core_runtime_meta[req->core_id].
-					part_counters[id_old].dirty_clines);
+		ocf_metadata_get_core_info(cache, move->line, &core_id,
+				&core_line);
+		if (core_id != move->core_id || core_line != move->core_line)
+			continue;
+
+		if (!metadata_test_valid_any(cache, move->line))
+			continue;
+
+		/* IO class might have been removed meanwhile */
+		if (!ocf_part_is_valid(&cache->user_parts[move->part_id]))
+			continue;
+
+		id_old = ocf_metadata_get_partition_id(cache, move->line);
+		ENV_BUG_ON(id_old >= OCF_IO_CLASS_MAX);
+
+		if (id_old == move->part_id)
+			continue;
+
+		_ocf_part_move_line(cache, move->line, core_id, id_old,
+				move->part_id);
+	}
+
+	cache->part_moves.count = 0;
+
+	env_spinlock_unlock(&cache->part_moves.lock);
+}
+
+void ocf_part_move_drop(struct ocf_cache *cache)
+{
+	env_spinlock_lock(&cache->part_moves.lock);
+	cache->part_moves.count = 0;
+	env_spinlock_unlock(&cache->part_moves.lock);
+}
+#endif
+
+void ocf_part_move_deferred(struct ocf_request *req)
+{
+	struct ocf_cache *cache = req->cache;
+#if OCF_CONFIG_PART_MOVE_BATCH > 0
+	struct ocf_part_move_entry *move;
+	struct ocf_map_info *entry;
+	bool full;
+	uint32_t i;
+
+	for (i = 0; i < req->core_line_count; i++) {
+		entry = &req->map[i];
+
+		if (!entry->re_part || entry->status != LOOKUP_HIT)
+			continue;
+
+		env_spinlock_lock(&cache->part_moves.lock);
+		full = cache->part_moves.count == OCF_CONFIG_PART_MOVE_BATCH;
+		if (!full) {
+			move = &cache->part_moves.entries[
+					cache->part_moves.count++];
+			move->line = entry->coll_idx;
+			move->core_id = req->core_id;
+			move->core_line = entry->core_line;
+			move->part_id = req->part_id;
 		}
+		env_spinlock_unlock(&cache->part_moves.lock);
 
-		env_atomic_inc(&cache->core_runtime_meta[req->core_id].
-				part_counters[id_new].cached_clines);
-		env_atomic_dec(&cache->core_runtime_meta[req->core_id].
-				part_counters[id_old].cached_clines);
+		if (full) {
+			OCF_METADATA_LOCK_WR();
+			ocf_part_move_apply(cache);
+			OCF_METADATA_UNLOCK_WR();
 
-		/* DONE */
+			/* Retry queueing this cache line */
+			i--;
+		}
 	}
+#else
+	OCF_METADATA_LOCK_WR();
+
+	/* Probably some cache lines are assigned into wrong
+	 * partition. Need to move it to new one
+	 */
+	ocf_part_move(req);
+
+	OCF_METADATA_UNLOCK_WR();
+#endif
+}
+
+/*
+ * Publish IO class mapping read by I/O path without locks. Snapshot not in
+ * use is filled and then made current, so readers see either old or new
+ * mapping, never a mix of both. Caller has to serialize publishers.
+ */
+void ocf_part_class_map_publish(struct ocf_cache *cache)
+{
+	uint32_t version = env_atomic_read(&cache->class_map.version);
+	struct ocf_part_class_map *map =
+			&cache->class_map.maps[(version + 1) & 1];
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+
+	for (part_id = 0; part_id < OCF_IO_CLASS_MAX; part_id++) {
+		part = &cache->user_parts[part_id];
+
+		map->part_id[part_id] = ocf_part_is_valid(part) ?
+				part_id : PARTITION_DEFAULT;
+		map->cache_mode[part_id] = part->config->cache_mode;
+	}
+
+	/* Atomic increment is a full barrier, snapshot is complete first */
+	env_atomic_inc(&cache->class_map.version);
+}
+
+/*
+ * Number of cache lines of pinned partitions. Sizes are read without lock,
+ * so requests mapping concurrently may overrun pinned capacity by their
+ * own cache lines.
+ */
+uint32_t ocf_part_pinned_lines(struct ocf_cache *cache)
+{
+	struct ocf_user_part *part;
+	ocf_part_id_t part_id;
+	uint32_t lines = 0;
+
+	for (part_id = 0; part_id < OCF_IO_CLASS_MAX; part_id++) {
+		part = &cache->user_parts[part_id];
+		if (ocf_part_is_pinned(part))
+			lines += part->runtime->curr_size;
+	}
+
+	return lines;
+}
+
+/* Bucket is refilled at most once per this period */
+#define OCF_PART_QOS_REFILL_US 1000
+
+/*
+ * Add tokens earned since last refill, returns true if bucket is not empty
+ * afterwards. Only one of concurrent callers gets to refill.
+ */
+bool ocf_part_qos_refill(struct ocf_part_qos *qos)
+{
+	uint64_t now = env_get_tick_count();
+	long last = env_atomic64_read(&qos->refill_ticks);
+	long tokens, new_tokens;
+	uint64_t us;
+
+	us = env_ticks_to_nsecs(now - last) / 1000;
+	if (us < OCF_PART_QOS_REFILL_US)
+		return false;
+
+	if (env_atomic64_cmpxchg(&qos->refill_ticks, last, now) != last)
+		return env_atomic64_read(&qos->tokens) > 0;
+
+	/* Bucket holds at most burst, no point in counting more than 1s */
+	us = OCF_MIN(us, 1000000ULL);
+
+	do {
+		tokens = env_atomic64_read(&qos->tokens);
+		new_tokens = OCF_MIN(tokens + (long)(qos->rate * us / 1000000),
+				(long)qos->burst);
+	} while (env_atomic64_cmpxchg(&qos->tokens, tokens, new_tokens) !=
+			tokens);
+
+	return new_tokens > 0;
 }
 
 void ocf_part_set_valid(struct ocf_cache *cache, ocf_part_id_t id,
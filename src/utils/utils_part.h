@@ -41,34 +41,210 @@ static inline bool ocf_part_is_added(struct ocf_user_part *part)
 	return !!part->config->flags.added;
 }
 
+void ocf_part_class_map_publish(struct ocf_cache *cache);
+
+static inline const struct ocf_part_class_map *ocf_part_class_map_get(
+		struct ocf_cache *cache)
+{
+	return &cache->class_map.maps[
+			env_atomic_read(&cache->class_map.version) & 1];
+}
+
 static inline ocf_part_id_t ocf_part_class2id(ocf_cache_t cache, uint64_t class)
 {
 	if (class < OCF_IO_CLASS_MAX)
-		if (cache->user_parts[class].config->flags.valid)
-			return class;
+		return ocf_part_class_map_get(cache)->part_id[class];
 
 	return PARTITION_DEFAULT;
 }
 
 void ocf_part_move(struct ocf_request *req);
 
+/**
+ * @brief Move hit cache lines of request to partition of its IO class
+ *
+ * Moves are queued and applied in batch by ocf_part_move_apply(), so that
+ * hits don't need exclusive metadata access. When the queue is full, it is
+ * applied by the caller.
+ *
+ * @note The caller must not hold metadata lock
+ *
+ * @param req - OCF request with re_part set
+ */
+void ocf_part_move_deferred(struct ocf_request *req);
+
+#if OCF_CONFIG_PART_MOVE_BATCH > 0
+/**
+ * @brief Apply queued partition moves of cache lines
+ *
+ * @note The caller must hold the metadata WR lock
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_part_move_apply(struct ocf_cache *cache);
+
+/**
+ * @brief Drop queued partition moves of cache lines of detached cache
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_part_move_drop(struct ocf_cache *cache);
+#else
+static inline void ocf_part_move_apply(struct ocf_cache *cache)
+{
+}
+
+static inline void ocf_part_move_drop(struct ocf_cache *cache)
+{
+}
+#endif
+
 #define for_each_part(cache, part, id) \
 	for_each_lst_entry(&cache->lst_part, part, id, \
 		struct ocf_user_part, lst_valid)
 
-static inline void ocf_part_sort(struct ocf_cache *cache)
+void ocf_part_sort(struct ocf_cache *cache);
+
+/* Number of cache lines of partition protected from eviction */
+static inline uint32_t ocf_part_get_evict_min_size(struct ocf_user_part *part)
+{
+	uint32_t target = env_atomic_read(&part->ghost_target);
+
+	return OCF_MAX(part->config->min_size, target);
+}
+
+static inline bool ocf_part_is_pinned(struct ocf_user_part *part)
+{
+	return part->config->priority == OCF_IO_CLASS_PRIO_PINNED;
+}
+
+uint32_t ocf_part_pinned_lines(struct ocf_cache *cache);
+
+/* Check if lines mapped to partition stay within pinned capacity */
+static inline bool ocf_part_pinned_fits(struct ocf_cache *cache,
+		ocf_part_id_t part_id, uint32_t lines)
+{
+	if (!cache->pinned_max || part_id >= OCF_IO_CLASS_MAX ||
+			!ocf_part_is_pinned(&cache->user_parts[part_id])) {
+		return true;
+	}
+
+	return (uint64_t)ocf_part_pinned_lines(cache) + lines <=
+			cache->pinned_max;
+}
+
+static inline bool ocf_part_is_evictable(struct ocf_user_part *part)
 {
-	ocf_lst_sort(&cache->lst_part);
+	return part->config->flags.eviction &&
+		part->runtime->curr_size > ocf_part_get_evict_min_size(part);
 }
 
+/*
+ * Update partition bit in eviction plan, called whenever partition
+ * size changes
+ */
+static inline void ocf_part_evict_update(struct ocf_cache *cache,
+		struct ocf_user_part *part)
+{
+	unsigned long *map = cache->part_evict.evictable;
+	uint16_t rank = part->evict_rank;
+	bool evictable;
+
+	if (rank == OCF_PART_EVICT_RANK_NONE)
+		return;
+
+	evictable = ocf_part_is_evictable(part);
+	if (evictable == env_bit_test(rank, map))
+		return;
+
+	if (evictable)
+		env_bit_set(rank, map);
+	else
+		env_bit_clear(rank, map);
+}
+
+static inline uint16_t ocf_part_evict_next(struct ocf_cache *cache,
+		uint16_t rank)
+{
+	unsigned long *map = cache->part_evict.evictable;
+
+	for (; rank < cache->part_evict.count; rank++) {
+		if (!map[rank / OCF_PART_EVICT_MAP_BITS]) {
+			/* Skip whole word */
+			rank |= OCF_PART_EVICT_MAP_BITS - 1;
+			continue;
+		}
+
+		if (env_bit_test(rank, map))
+			return rank;
+	}
+
+	return OCF_PART_EVICT_RANK_NONE;
+}
+
+/* Iterate partitions having cache lines to evict, in eviction order */
+#define for_each_evictable_part(cache, part, id, rank) \
+	for (rank = ocf_part_evict_next(cache, 0); \
+		rank != OCF_PART_EVICT_RANK_NONE && \
+		(id = cache->part_evict.order[rank], \
+		part = &cache->user_parts[id], true); \
+		rank = ocf_part_evict_next(cache, rank + 1))
+
 static inline ocf_cache_mode_t ocf_part_get_cache_mode(struct ocf_cache *cache,
 		ocf_part_id_t part_id)
 {
 	if (part_id < OCF_IO_CLASS_MAX)
-		return cache->user_parts[part_id].config->cache_mode;
+		return ocf_part_class_map_get(cache)->cache_mode[part_id];
 	return ocf_cache_mode_none;
 }
 
+/* Cache mode of IO class, with partition and mode from one snapshot */
+static inline ocf_cache_mode_t ocf_part_class_cache_mode(ocf_cache_t cache,
+		uint64_t class)
+{
+	const struct ocf_part_class_map *map = ocf_part_class_map_get(cache);
+
+	if (class >= OCF_IO_CLASS_MAX)
+		class = PARTITION_DEFAULT;
+
+	return map->cache_mode[map->part_id[class]];
+}
+
+bool ocf_part_qos_refill(struct ocf_part_qos *qos);
+
+/*
+ * Account bytes of cache device traffic of partition in its token bucket.
+ * Traffic is never held back, bucket just goes below zero.
+ */
+static inline void ocf_part_qos_charge(struct ocf_cache *cache,
+		ocf_part_id_t part_id, uint64_t bytes)
+{
+	struct ocf_part_qos *qos;
+
+	if (part_id >= OCF_IO_CLASS_MAX)
+		return;
+
+	qos = &cache->user_parts[part_id].qos;
+	if (qos->rate)
+		env_atomic64_sub(bytes, &qos->tokens);
+}
+
+/* Check if partition used up its cache device bandwidth */
+static inline bool ocf_part_qos_exceeded(struct ocf_cache *cache,
+		ocf_part_id_t part_id)
+{
+	struct ocf_part_qos *qos;
+
+	if (part_id >= OCF_IO_CLASS_MAX)
+		return false;
+
+	qos = &cache->user_parts[part_id].qos;
+	if (!qos->rate || env_atomic64_read(&qos->tokens) > 0)
+		return false;
+
+	return !ocf_part_qos_refill(qos);
+}
+
 static inline bool ocf_part_is_prio_valid(int64_t prio)
 {
 	switch (prio) {
@@ -12,9 +12,42 @@ struct ocf_pipeline {
 	bool finish;
 	int error;
 
+#if OCF_CONFIG_PIPELINE_TIMING
+	struct ocf_pipeline_step *step;
+	uint64_t step_start;
+#endif
+
 	void *priv;
 };
 
+#if OCF_CONFIG_PIPELINE_TIMING
+/*
+ * Step is done when pipeline is resumed, so its time includes completion of
+ * I/O and nested pipelines it started.
+ */
+static void _ocf_pipeline_step_timing(ocf_pipeline_t pipeline,
+		struct ocf_pipeline_step *next)
+{
+	struct ocf_pipeline_step *step = pipeline->step;
+	uint64_t now = env_get_tick_count();
+
+	if (step) {
+		ocf_cache_log(pipeline->req->cache, log_info,
+				"Pipeline step %s: %" ENV_PRIu64 " us\n",
+				step->name, env_ticks_to_nsecs(now -
+				pipeline->step_start) / 1000);
+	}
+
+	pipeline->step = next;
+	pipeline->step_start = now;
+}
+#else
+static inline void _ocf_pipeline_step_timing(ocf_pipeline_t pipeline,
+		struct ocf_pipeline_step *next)
+{
+}
+#endif
+
 static int _ocf_pipeline_run_step(struct ocf_request *req)
 {
 	ocf_pipeline_t pipeline = req->priv;
@@ -22,6 +55,7 @@ static int _ocf_pipeline_run_step(struct ocf_request *req)
 	ocf_pipeline_arg_t arg;
 
 	if (pipeline->finish) {
+		_ocf_pipeline_step_timing(pipeline, NULL);
 		pipeline->properties->finish(pipeline, pipeline->priv,
 				pipeline->error);
 		return 0;
@@ -31,6 +65,7 @@ static int _ocf_pipeline_run_step(struct ocf_request *req)
 		step = &pipeline->properties->steps[pipeline->next_step];
 		switch (step->type) {
 		case ocf_pipeline_step_single:
+			_ocf_pipeline_step_timing(pipeline, step);
 			pipeline->next_step++;
 			step->hndl(pipeline, pipeline->priv, &step->arg);
 			return 0;
@@ -41,9 +76,11 @@ static int _ocf_pipeline_run_step(struct ocf_request *req)
 				pipeline->next_step++;
 				continue;
 			}
+			_ocf_pipeline_step_timing(pipeline, step);
 			step->hndl(pipeline, pipeline->priv, arg);
 			return 0;
 		case ocf_pipeline_step_terminator:
+			_ocf_pipeline_step_timing(pipeline, NULL);
 			pipeline->properties->finish(pipeline, pipeline->priv,
 					pipeline->error);
 			return 0;
@@ -82,6 +119,15 @@ int ocf_pipeline_create(ocf_pipeline_t *pipeline, ocf_cache_t cache,
 		return -OCF_ERR_NO_MEM;
 	}
 
+	/* Pipeline request doesn't access cache device itself, so it must not
+	 * hold back detach pipeline waiting for cache requests to finish
+	 */
+	if (!req->d2c) {
+		ocf_refcnt_dec_shard(&cache->pending_cache_requests,
+				req->io_queue->id);
+		req->d2c = 1;
+	}
+
 	tmp_pipeline->properties = properties;
 	tmp_pipeline->req = req;
 	tmp_pipeline->next_step = 0;
@@ -89,6 +135,7 @@ int ocf_pipeline_create(ocf_pipeline_t *pipeline, ocf_cache_t cache,
 	tmp_pipeline->error = 0;
 
 	req->info.internal = true;
+	req->mngt = 1;
 	req->io_if = &_io_if_pipeline;
 	req->priv = tmp_pipeline;
 
@@ -68,6 +68,7 @@ typedef void (*ocf_pipeline_finish_t)(ocf_pipeline_t pipeline,
 struct ocf_pipeline_step {
 	enum ocf_pipeline_step_type type;
 	ocf_pipeline_step_hndl_t hndl;
+	const char *name;
 	union {
 		struct ocf_pipeline_arg arg;
 		struct ocf_pipeline_arg *args;
@@ -78,12 +79,14 @@ struct ocf_pipeline_step {
 	{ \
 		.type = ocf_pipeline_step_single, \
 		.hndl = _hndl, \
+		.name = #_hndl, \
 	}
 
 #define OCF_PL_STEP_ARG_INT(_hndl, _int) \
 	{ \
 		.type = ocf_pipeline_step_single, \
 		.hndl = _hndl, \
+		.name = #_hndl, \
 		.arg = { \
 			.type = ocf_pipeline_arg_int, \
 			.val.i = _int, \
@@ -94,6 +97,7 @@ struct ocf_pipeline_step {
 	{ \
 		.type = ocf_pipeline_step_single, \
 		.hndl = _hndl, \
+		.name = #_hndl, \
 		.arg = { \
 			.type = ocf_pipeline_arg_ptr, \
 			.val.p = _ptr, \
@@ -104,6 +108,7 @@ struct ocf_pipeline_step {
 	{ \
 		.type = ocf_pipeline_step_foreach, \
 		.hndl = _hndl, \
+		.name = #_hndl, \
 		.args = _args, \
 	}
 
@@ -0,0 +1,329 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_ctx_priv.h"
+#include "../ocf_def_priv.h"
+#include "../engine/cache_engine.h"
+#include "utils_cache_line.h"
+#include "utils_ram_tier.h"
+
+#define RAM_TIER_NONE ((uint32_t)-1)
+
+struct ocf_ram_tier_slot {
+	ocf_cache_line_t line;
+		/*!< Cache line held by slot, RAM_TIER_NONE if slot is free */
+
+	uint32_t next;
+		/*!< Next slot in hash chain */
+
+	uint8_t referenced;
+		/*!< Slot was read since CLOCK hand passed it */
+};
+
+struct ocf_ram_tier {
+	struct ocf_ram_tier_slot *slots;
+	uint32_t *hash;
+	ctx_data_t *data;
+		/*!< Cache line size of data for each slot */
+
+	uint32_t slot_count;
+	uint32_t hash_bits;
+	uint32_t hand;
+
+	env_rwlock lock;
+		/*!< Read for lookup and copy out, write for changes of slots */
+};
+
+static inline uint32_t ram_tier_hash(struct ocf_ram_tier *tier,
+		ocf_cache_line_t line)
+{
+	return (uint32_t)(line * 0x9E3779B1U) >> (32 - tier->hash_bits);
+}
+
+static uint32_t ram_tier_lookup(struct ocf_ram_tier *tier,
+		ocf_cache_line_t line)
+{
+	uint32_t slot = tier->hash[ram_tier_hash(tier, line)];
+
+	while (slot != RAM_TIER_NONE && tier->slots[slot].line != line)
+		slot = tier->slots[slot].next;
+
+	return slot;
+}
+
+static void ram_tier_remove(struct ocf_ram_tier *tier, uint32_t slot)
+{
+	uint32_t *pos = &tier->hash[ram_tier_hash(tier,
+			tier->slots[slot].line)];
+
+	while (*pos != slot)
+		pos = &tier->slots[*pos].next;
+
+	*pos = tier->slots[slot].next;
+
+	tier->slots[slot].line = RAM_TIER_NONE;
+	tier->slots[slot].referenced = 0;
+}
+
+static void ram_tier_insert(struct ocf_ram_tier *tier, uint32_t slot,
+		ocf_cache_line_t line)
+{
+	uint32_t *head = &tier->hash[ram_tier_hash(tier, line)];
+
+	tier->slots[slot].line = line;
+	tier->slots[slot].next = *head;
+	*head = slot;
+}
+
+/* Find slot to reuse, the first not referenced one after CLOCK hand */
+static uint32_t ram_tier_victim(struct ocf_ram_tier *tier)
+{
+	uint32_t slot;
+
+	for (;;) {
+		slot = tier->hand;
+		tier->hand = (tier->hand + 1) % tier->slot_count;
+
+		if (!tier->slots[slot].referenced)
+			return slot;
+
+		tier->slots[slot].referenced = 0;
+	}
+}
+
+int ocf_ram_tier_attach(ocf_cache_t cache)
+{
+	uint64_t line_size = ocf_line_size(cache);
+	struct ocf_ram_tier *tier;
+	uint64_t slot_count;
+	uint32_t i;
+
+	ENV_BUG_ON(cache->ram_tier);
+
+	slot_count = OCF_MIN(((uint64_t)OCF_CONFIG_RAM_TIER_SIZE << 20) /
+			line_size,
+			(uint64_t)cache->device->collision_table_entries);
+	if (!slot_count)
+		return 0;
+
+	tier = env_vzalloc(sizeof(*tier));
+	if (!tier)
+		goto err;
+
+	tier->slot_count = slot_count;
+	for (tier->hash_bits = 1; (1ULL << tier->hash_bits) < slot_count;)
+		tier->hash_bits++;
+
+	tier->slots = env_vmalloc(sizeof(*tier->slots) * slot_count);
+	tier->hash = env_vmalloc(sizeof(*tier->hash) << tier->hash_bits);
+	tier->data = ctx_data_alloc(cache->owner, OCF_DIV_ROUND_UP(
+			slot_count * line_size, PAGE_SIZE));
+	if (!tier->slots || !tier->hash || !tier->data)
+		goto err_free;
+
+	for (i = 0; i < slot_count; i++) {
+		tier->slots[i].line = RAM_TIER_NONE;
+		tier->slots[i].next = RAM_TIER_NONE;
+		tier->slots[i].referenced = 0;
+	}
+
+	for (i = 0; i < (1U << tier->hash_bits); i++)
+		tier->hash[i] = RAM_TIER_NONE;
+
+	env_rwlock_init(&tier->lock);
+
+	cache->ram_tier = tier;
+
+	ocf_cache_log(cache, log_info, "RAM tier of %u cache lines\n",
+			tier->slot_count);
+
+	return 0;
+
+err_free:
+	if (tier->data)
+		ctx_data_free(cache->owner, tier->data);
+	env_vfree(tier->hash);
+	env_vfree(tier->slots);
+	env_vfree(tier);
+err:
+	ocf_cache_log(cache, log_err, "Cannot allocate RAM tier\n");
+	return -OCF_ERR_NO_MEM;
+}
+
+void ocf_ram_tier_detach(ocf_cache_t cache)
+{
+	struct ocf_ram_tier *tier = cache->ram_tier;
+
+	if (!tier)
+		return;
+
+	cache->ram_tier = NULL;
+
+	ctx_data_free(cache->owner, tier->data);
+	env_vfree(tier->hash);
+	env_vfree(tier->slots);
+	env_vfree(tier);
+}
+
+bool ocf_ram_tier_read(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_ram_tier *tier = cache->ram_tier;
+	uint64_t line_size = ocf_line_size(cache);
+	uint64_t seek = req->byte_position % line_size;
+	uint64_t offset, from, bytes;
+	uint32_t i, slot;
+
+	if (!tier)
+		return false;
+
+	env_rwlock_read_lock(&tier->lock);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (req->map[i].status != LOOKUP_HIT ||
+				ram_tier_lookup(tier, req->map[i].coll_idx) ==
+				RAM_TIER_NONE) {
+			env_rwlock_read_unlock(&tier->lock);
+			return false;
+		}
+	}
+
+	for (i = 0; i < req->core_line_count; i++) {
+		slot = ram_tier_lookup(tier, req->map[i].coll_idx);
+
+		offset = i ? i * line_size - seek : 0;
+		from = slot * line_size + (i ? 0 : seek);
+		bytes = OCF_MIN(line_size - (i ? 0 : seek),
+				req->byte_length - offset);
+
+		ctx_data_cpy(cache->owner, req->data, tier->data,
+				req->data_offset + offset, from, bytes);
+
+		tier->slots[slot].referenced = 1;
+	}
+
+	env_rwlock_read_unlock(&tier->lock);
+
+	return true;
+}
+
+/* Offset in request data of cache line it covers as a whole */
+static inline bool ram_tier_req_line(struct ocf_request *req, uint32_t i,
+		uint64_t *offset)
+{
+	uint64_t line_size = ocf_line_size(req->cache);
+	uint64_t seek = req->byte_position % line_size;
+
+	if (req->map[i].status != LOOKUP_HIT || (i == 0 && seek))
+		return false;
+
+	*offset = i * line_size - seek;
+
+	return *offset + line_size <= req->byte_length;
+}
+
+void ocf_ram_tier_fill(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_ram_tier *tier = cache->ram_tier;
+	uint64_t line_size = ocf_line_size(cache);
+	ocf_cache_line_t line;
+	uint32_t i, slot, missing = 0;
+	uint64_t offset;
+
+	if (!tier || req->error)
+		return;
+
+	/* Most of hot lines are already there, only mark them referenced */
+	env_rwlock_read_lock(&tier->lock);
+	for (i = 0; i < req->core_line_count; i++) {
+		if (!ram_tier_req_line(req, i, &offset))
+			continue;
+
+		slot = ram_tier_lookup(tier, req->map[i].coll_idx);
+		if (slot == RAM_TIER_NONE)
+			missing++;
+		else
+			tier->slots[slot].referenced = 1;
+	}
+	env_rwlock_read_unlock(&tier->lock);
+
+	if (!missing)
+		return;
+
+	env_rwlock_write_lock(&tier->lock);
+	for (i = 0; i < req->core_line_count; i++) {
+		if (!ram_tier_req_line(req, i, &offset))
+			continue;
+
+		line = req->map[i].coll_idx;
+		if (ram_tier_lookup(tier, line) != RAM_TIER_NONE)
+			continue;
+
+		slot = ram_tier_victim(tier);
+		if (tier->slots[slot].line != RAM_TIER_NONE)
+			ram_tier_remove(tier, slot);
+
+		ctx_data_cpy(cache->owner, tier->data, req->data,
+				slot * line_size, req->data_offset + offset,
+				line_size);
+
+		ram_tier_insert(tier, slot, line);
+	}
+	env_rwlock_write_unlock(&tier->lock);
+}
+
+void ocf_ram_tier_drop_req(struct ocf_request *req, uint32_t first,
+		uint32_t count)
+{
+	struct ocf_ram_tier *tier = req->cache->ram_tier;
+	uint32_t i, slot;
+	bool found = false;
+
+	if (!tier)
+		return;
+
+	env_rwlock_read_lock(&tier->lock);
+	for (i = first; i < first + count && !found; i++) {
+		found = ram_tier_lookup(tier, req->map[i].coll_idx) !=
+				RAM_TIER_NONE;
+	}
+	env_rwlock_read_unlock(&tier->lock);
+
+	if (!found)
+		return;
+
+	env_rwlock_write_lock(&tier->lock);
+	for (i = first; i < first + count; i++) {
+		slot = ram_tier_lookup(tier, req->map[i].coll_idx);
+		if (slot != RAM_TIER_NONE)
+			ram_tier_remove(tier, slot);
+	}
+	env_rwlock_write_unlock(&tier->lock);
+}
+
+void ocf_ram_tier_drop(ocf_cache_t cache, ocf_cache_line_t line)
+{
+	struct ocf_ram_tier *tier = cache->ram_tier;
+	uint32_t slot;
+
+	if (!tier)
+		return;
+
+	env_rwlock_read_lock(&tier->lock);
+	slot = ram_tier_lookup(tier, line);
+	env_rwlock_read_unlock(&tier->lock);
+
+	if (slot == RAM_TIER_NONE)
+		return;
+
+	env_rwlock_write_lock(&tier->lock);
+	slot = ram_tier_lookup(tier, line);
+	if (slot != RAM_TIER_NONE)
+		ram_tier_remove(tier, slot);
+	env_rwlock_write_unlock(&tier->lock);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_RAM_TIER_H__
+#define __UTILS_RAM_TIER_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_request.h"
+
+/**
+ * @file utils_ram_tier.h
+ * @brief In-memory copies of hot cache lines
+ *
+ * Cache lines read from cache device as a whole are copied into RAM slots,
+ * so that following reads covering only such lines are served by memory
+ * copy instead of cache device read. Slots are replaced in CLOCK order.
+ * Copy of cache line is dropped whenever the line is written to cache
+ * device or invalidated, so callers need to hold cache line locks, which
+ * they do for any access of cache line data.
+ */
+
+struct ocf_ram_tier;
+
+/**
+ * @brief Allocate RAM tier of attached cache, sized by
+ *	OCF_CONFIG_RAM_TIER_SIZE
+ *
+ * @param cache - OCF cache instance
+ *
+ * @retval 0 RAM tier allocated or disabled
+ * @retval Non-zero Allocation failed
+ */
+int ocf_ram_tier_attach(ocf_cache_t cache);
+
+/**
+ * @brief Free RAM tier of cache
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_ram_tier_detach(ocf_cache_t cache);
+
+/**
+ * @brief Copy cache lines of request to its data if all are in RAM tier
+ *
+ * @param req - OCF request, hit on all its cache lines and read locked
+ *
+ * @retval true Request data filled in
+ * @retval false Some of cache lines are not in RAM tier
+ */
+bool ocf_ram_tier_read(struct ocf_request *req);
+
+/**
+ * @brief Copy cache lines fully covered by request data to RAM tier
+ *
+ * @param req - OCF request which read its data from cache device
+ */
+void ocf_ram_tier_fill(struct ocf_request *req);
+
+/**
+ * @brief Drop copies of cache lines of request from RAM tier
+ *
+ * @param req - OCF request
+ * @param first - Index of first map entry
+ * @param count - Number of map entries
+ */
+void ocf_ram_tier_drop_req(struct ocf_request *req, uint32_t first,
+		uint32_t count);
+
+/**
+ * @brief Drop copy of cache line from RAM tier
+ *
+ * @param cache - OCF cache instance
+ * @param line - Cache line
+ */
+void ocf_ram_tier_drop(ocf_cache_t cache, ocf_cache_line_t line);
+
+#endif /* __UTILS_RAM_TIER_H__ */
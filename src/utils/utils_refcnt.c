@@ -5,23 +5,44 @@
 
 #include "../utils/utils_refcnt.h"
 
-void ocf_refcnt_dec(struct ocf_refcnt *rc)
+static inline env_atomic *_ocf_refcnt_shard(struct ocf_refcnt *rc,
+		uint32_t id)
 {
-	int val = env_atomic_dec_return(&rc->counter);
+	return &rc->shard[id % OCF_REFCNT_SHARDS].counter;
+}
+
+int ocf_refcnt_read(struct ocf_refcnt *rc)
+{
+	int i, val = 0;
+
+	for (i = 0; i < OCF_REFCNT_SHARDS; i++)
+		val += env_atomic_read(&rc->shard[i].counter);
+
+	return val;
+}
+
+void ocf_refcnt_dec_shard(struct ocf_refcnt *rc, uint32_t id)
+{
+	int val = env_atomic_dec_return(_ocf_refcnt_shard(rc, id));
 	ENV_BUG_ON(val < 0);
 
-	if (!val && env_atomic_cmpxchg(&rc->callback, 1, 0))
+	/* Shards are summed only when callback is pending. Whoever drops the
+	 * last reference sees all other shards at 0. */
+	if (val || !env_atomic_read(&rc->callback))
+		return;
+
+	if (!ocf_refcnt_read(rc) && env_atomic_cmpxchg(&rc->callback, 1, 0))
 		rc->cb(rc->priv);
 }
 
-bool ocf_refcnt_inc(struct ocf_refcnt  *rc)
+bool ocf_refcnt_inc_shard(struct ocf_refcnt *rc, uint32_t id)
 {
 	if (!env_atomic_read(&rc->freeze)) {
-		env_atomic_inc(&rc->counter);
+		env_atomic_inc(_ocf_refcnt_shard(rc, id));
 		if (!env_atomic_read(&rc->freeze))
 			return  true;
 		else
-			ocf_refcnt_dec(rc);
+			ocf_refcnt_dec_shard(rc, id);
 	}
 
 	return false;
@@ -39,11 +60,11 @@ void ocf_refcnt_register_zero_cb(struct ocf_refcnt *rc, ocf_refcnt_cb_t cb,
 	ENV_BUG_ON(!env_atomic_read(&rc->freeze));
 	ENV_BUG_ON(env_atomic_read(&rc->callback));
 
-	env_atomic_inc(&rc->counter);
+	env_atomic_inc(_ocf_refcnt_shard(rc, 0));
 	rc->cb = cb;
 	rc->priv = priv;
 	env_atomic_set(&rc->callback, 1);
-	ocf_refcnt_dec(rc);
+	ocf_refcnt_dec_shard(rc, 0);
 }
 
 void ocf_refcnt_unfreeze(struct ocf_refcnt *rc)
@@ -8,22 +8,57 @@
 
 #include "ocf_env.h"
 
+/* Number of counter shards, selected by I/O queue */
+#define OCF_REFCNT_SHARDS 16
+
 typedef void (*ocf_refcnt_cb_t)(void *priv);
 
+struct ocf_refcnt_shard {
+	env_atomic counter;
+} __attribute__((aligned(64)));
+
+/* Reference counter split into shards, so that references taken and
+ * dropped on different I/O queues don't share CPU cache line. Reference must
+ * be dropped on the same shard it was taken on. Shards are summed only to
+ * check if counter dropped to 0. */
 struct ocf_refcnt
 {
-	env_atomic counter;
+	struct ocf_refcnt_shard shard[OCF_REFCNT_SHARDS];
 	env_atomic freeze;
 	env_atomic callback;
 	ocf_refcnt_cb_t cb;
 	void *priv;
 };
 
+/* Try to increment counter shard selected by id (e.g. I/O queue id).
+ * Returns true if successfull, false if freezed */
+bool ocf_refcnt_inc_shard(struct ocf_refcnt *rc, uint32_t id);
+
+/* Increment counter shard selected by id even if counter is freezed, for
+ * references which can't be refused. Zero callback waits for them as well. */
+static inline void ocf_refcnt_inc_shard_force(struct ocf_refcnt *rc,
+		uint32_t id)
+{
+	env_atomic_inc(&rc->shard[id % OCF_REFCNT_SHARDS].counter);
+}
+
+/* Decrement counter shard selected by id */
+void ocf_refcnt_dec_shard(struct ocf_refcnt *rc, uint32_t id);
+
 /* Try to increment counter. Returns true if successfull, false if freezed */
-bool ocf_refcnt_inc(struct ocf_refcnt  *rc);
+static inline bool ocf_refcnt_inc(struct ocf_refcnt *rc)
+{
+	return ocf_refcnt_inc_shard(rc, 0);
+}
 
 /* Decrement reference counter */
-void ocf_refcnt_dec(struct ocf_refcnt *rc);
+static inline void ocf_refcnt_dec(struct ocf_refcnt *rc)
+{
+	ocf_refcnt_dec_shard(rc, 0);
+}
+
+/* Read counter value, summed over all shards */
+int ocf_refcnt_read(struct ocf_refcnt *rc);
 
 /* Disallow incrementing of underlying counter - attempts to increment counter
  * will be failing until ocf_refcnt_unfreeze is calleed.
@@ -36,9 +36,23 @@ enum ocf_req_size {
 	ocf_req_size_max,
 };
 
+/*
+ * Maps of requests larger than biggest request class are allocated from
+ * their own pools, up to the biggest map class
+ */
+enum ocf_req_map_size {
+	ocf_req_map_size_256 = 0,
+	ocf_req_map_size_512,
+	ocf_req_map_size_1024,
+	ocf_req_map_size_2048,
+	ocf_req_map_size_4096,
+	ocf_req_map_size_max,
+};
+
 struct ocf_req_allocator {
 	env_allocator *allocator[ocf_req_size_max];
 	size_t size[ocf_req_size_max];
+	env_allocator *map_allocator[ocf_req_map_size_max];
 };
 
 static inline size_t ocf_req_sizeof_map(struct ocf_request *req)
@@ -60,17 +74,21 @@ static inline size_t ocf_req_sizeof(uint32_t lines)
 }
 
 #define ALLOCATOR_NAME_FMT "ocf_req_%u"
+#define MAP_ALLOCATOR_NAME_FMT "ocf_req_map_%u"
 /* Max number of digits in decimal representation of unsigned int is 10 */
 #define ALLOCATOR_NAME_MAX (sizeof(ALLOCATOR_NAME_FMT) + 10)
 
 int ocf_req_allocator_init(struct ocf_ctx *ocf_ctx)
 {
 	int i;
+	uint32_t lines;
 	struct ocf_req_allocator *req;
-	char name[ALLOCATOR_NAME_MAX] = { '\0' };
+	char name[ALLOCATOR_NAME_MAX + 4] = { '\0' };
 
 	OCF_DEBUG_TRACE(cache);
 
+	ENV_BUG_ON(ocf_req_size_max != OCF_QUEUE_REQ_CLASSES);
+
 	ocf_ctx->resources.req = env_zalloc(sizeof(*(ocf_ctx->resources.req)),
 			ENV_MEM_NORMAL);
 	req = ocf_ctx->resources.req;
@@ -95,6 +113,21 @@ int ocf_req_allocator_init(struct ocf_ctx *ocf_ctx)
 				"size = %lu", 1 << i, req->size[i]);
 	}
 
+	for (i = 0; i < ARRAY_SIZE(req->map_allocator); i++) {
+		lines = 1 << (i + ocf_req_size_max);
+
+		if (snprintf(name, sizeof(name), MAP_ALLOCATOR_NAME_FMT,
+				lines) < 0) {
+			goto ocf_utils_req_init_ERROR;
+		}
+
+		req->map_allocator[i] = env_allocator_create(
+				lines * sizeof(struct ocf_map_info), name);
+
+		if (!req->map_allocator[i])
+			goto ocf_utils_req_init_ERROR;
+	}
+
 	return 0;
 
 ocf_utils_req_init_ERROR:
@@ -124,26 +157,78 @@ void ocf_req_allocator_deinit(struct ocf_ctx *ocf_ctx)
 		}
 	}
 
+	for (i = 0; i < ARRAY_SIZE(req->map_allocator); i++) {
+		if (req->map_allocator[i]) {
+			env_allocator_destroy(req->map_allocator[i]);
+			req->map_allocator[i] = NULL;
+		}
+	}
+
 	env_free(req);
 	ocf_ctx->resources.req = NULL;
 }
 
+void ocf_req_allocator_mem_usage(struct ocf_ctx *ocf_ctx,
+		struct ocf_cache_memory_usage *usage)
+{
+	struct ocf_req_allocator *req = ocf_ctx->resources.req;
+	uint32_t lines, items;
+	size_t size;
+	int i;
+
+	ENV_BUG_ON(ocf_req_size_max + ocf_req_map_size_max !=
+			OCF_CACHE_MEMORY_REQ_CLASSES);
+
+	for (i = 0; i < OCF_CACHE_MEMORY_REQ_CLASSES; i++) {
+		lines = 1 << i;
+		if (i < ocf_req_size_max) {
+			size = req->size[i];
+			items = env_allocator_item_count(req->allocator[i]);
+		} else {
+			size = lines * sizeof(struct ocf_map_info);
+			items = env_allocator_item_count(
+				req->map_allocator[i - ocf_req_size_max]);
+		}
+
+		usage->req_classes[i].lines = lines;
+		usage->req_classes[i].items = items;
+		usage->req_classes[i].bytes = (uint64_t)items * size;
+	}
+}
+
 static inline env_allocator *_ocf_req_get_allocator_1(
 	struct ocf_cache *cache)
 {
 	return cache->owner->resources.req->allocator[0];
 }
 
-static env_allocator *_ocf_req_get_allocator(
-	struct ocf_cache *cache, uint32_t count)
+/*
+ * Size class of request with map of given number of lines, ocf_req_size_max
+ * if map is allocated separately
+ */
+static inline unsigned int _ocf_req_get_order(uint32_t count)
 {
-	struct ocf_ctx *ocf_ctx = cache->owner;
 	unsigned int idx = 31 - __builtin_clz(count);
 
+	ENV_BUG_ON(count == 0);
+
 	if (__builtin_ffs(count) <= idx)
 		idx++;
 
-	ENV_BUG_ON(count == 0);
+	return idx;
+}
+
+static inline unsigned int _ocf_req_get_size_idx(uint32_t count)
+{
+	return OCF_MIN(_ocf_req_get_order(count),
+			(unsigned int)ocf_req_size_max);
+}
+
+static env_allocator *_ocf_req_get_allocator(
+	struct ocf_cache *cache, uint32_t count)
+{
+	struct ocf_ctx *ocf_ctx = cache->owner;
+	unsigned int idx = _ocf_req_get_size_idx(count);
 
 	if (idx >= ocf_req_size_max)
 		return NULL;
@@ -151,51 +236,146 @@ static env_allocator *_ocf_req_get_allocator(
 	return ocf_ctx->resources.req->allocator[idx];
 }
 
+/* Pool of separately allocated map, NULL if map comes from heap */
+static env_allocator *_ocf_req_get_map_allocator(
+	struct ocf_cache *cache, uint32_t count)
+{
+	struct ocf_ctx *ocf_ctx = cache->owner;
+	unsigned int idx = _ocf_req_get_order(count) - ocf_req_size_max;
+
+	if (idx >= ocf_req_map_size_max)
+		return NULL;
+
+	return ocf_ctx->resources.req->map_allocator[idx];
+}
+
+#if OCF_CONFIG_QUEUE_REQ_CACHE > 0
+/*
+ * Requests with separately allocated map are cached in the smallest class,
+ * as they are allocated from its allocator
+ */
+static inline unsigned int _ocf_req_cache_class(uint32_t count)
+{
+	unsigned int idx = _ocf_req_get_size_idx(count);
+
+	return idx < ocf_req_size_max ? idx : ocf_req_size_1;
+}
+
+static struct ocf_request *ocf_req_cache_get(ocf_queue_t queue,
+		uint32_t count)
+{
+	unsigned int idx = _ocf_req_cache_class(count);
+	struct ocf_request *req = NULL;
+
+	env_spinlock_lock(&queue->req_cache_lock);
+	if (!list_empty(&queue->req_cache[idx])) {
+		req = list_first_entry(&queue->req_cache[idx],
+				struct ocf_request, list);
+		list_del(&req->list);
+		queue->req_cache_count[idx]--;
+	}
+	env_spinlock_unlock(&queue->req_cache_lock);
+
+	if (!req)
+		return NULL;
+
+	/* Clear request as allocator would do, including map it owns */
+	if (_ocf_req_get_size_idx(count) < ocf_req_size_max)
+		ENV_BUG_ON(env_memset(req, ocf_req_sizeof(count), 0));
+	else
+		ENV_BUG_ON(env_memset(req, sizeof(*req), 0));
+
+	return req;
+}
+
+static bool ocf_req_cache_put(ocf_queue_t queue, struct ocf_request *req)
+{
+	unsigned int idx = _ocf_req_cache_class(req->alloc_core_line_count);
+	bool cached = false;
+
+	/* Management queue may outlive request allocators */
+	if (queue == req->cache->mngt_queue)
+		return false;
+
+	env_spinlock_lock(&queue->req_cache_lock);
+	if (queue->req_cache_count[idx] < OCF_CONFIG_QUEUE_REQ_CACHE) {
+		list_add(&req->list, &queue->req_cache[idx]);
+		queue->req_cache_count[idx]++;
+		cached = true;
+	}
+	env_spinlock_unlock(&queue->req_cache_lock);
+
+	return cached;
+}
+
+void ocf_req_cache_drain(ocf_queue_t queue)
+{
+	env_allocator *allocator;
+	struct ocf_request *req;
+	unsigned int idx;
+
+	for (idx = 0; idx < OCF_QUEUE_REQ_CLASSES; idx++) {
+		allocator = queue->cache->owner->resources.req->allocator[idx];
+
+		while (!list_empty(&queue->req_cache[idx])) {
+			req = list_first_entry(&queue->req_cache[idx],
+					struct ocf_request, list);
+			list_del(&req->list);
+			env_allocator_del(allocator, req);
+		}
+
+		queue->req_cache_count[idx] = 0;
+	}
+}
+#else
+static inline struct ocf_request *ocf_req_cache_get(ocf_queue_t queue,
+		uint32_t count)
+{
+	return NULL;
+}
+
+static inline bool ocf_req_cache_put(ocf_queue_t queue,
+		struct ocf_request *req)
+{
+	return false;
+}
+
+void ocf_req_cache_drain(ocf_queue_t queue)
+{
+}
+#endif
+
 static void start_cache_req(struct ocf_request *req)
 {
 	ocf_cache_t cache = req->cache;
 
 	req->d2c = 1;
-	if (env_atomic_read(&cache->attached)) {
+	if (env_atomic_read(&cache->attached) &&
+			ocf_refcnt_inc_shard(&cache->pending_cache_requests,
+				req->io_queue->id)) {
 		req->d2c = 0;
-		env_atomic_inc(&cache->pending_cache_requests);
 		if (!env_atomic_read(&cache->attached)) {
 			req->d2c = 1;
-			env_atomic_dec(&cache->pending_cache_requests);
+			ocf_refcnt_dec_shard(&cache->pending_cache_requests,
+					req->io_queue->id);
 		}
 	}
 }
 
-struct ocf_request *ocf_req_new(ocf_queue_t queue, ocf_core_t core,
-		uint64_t addr, uint32_t bytes, int rw)
+static inline void ocf_req_get_lines(ocf_cache_t cache, uint64_t addr,
+		uint32_t bytes, uint64_t *first, uint64_t *last)
 {
-	uint64_t core_line_first, core_line_last, core_line_count;
-	ocf_cache_t cache = queue->cache;
-	struct ocf_request *req;
-	env_allocator *allocator;
-
-	if (likely(bytes)) {
-		core_line_first = ocf_bytes_2_lines(cache, addr);
-		core_line_last = ocf_bytes_2_lines(cache, addr + bytes - 1);
-		core_line_count = core_line_last - core_line_first + 1;
-	} else {
-		core_line_first = ocf_bytes_2_lines(cache, addr);
-		core_line_last = core_line_first;
-		core_line_count = 1;
-	}
-
-	allocator = _ocf_req_get_allocator(cache, core_line_count);
-	if (allocator) {
-		req = env_allocator_new(allocator);
-	} else {
-		req = env_allocator_new(_ocf_req_get_allocator_1(cache));
-	}
-
-	if (unlikely(!req))
-		return NULL;
+	*first = ocf_bytes_2_lines(cache, addr);
+	*last = likely(bytes) ? ocf_bytes_2_lines(cache, addr + bytes - 1) :
+			*first;
+}
 
-	if (allocator)
-		req->map = req->__map;
+static void ocf_req_init(struct ocf_request *req, ocf_queue_t queue,
+		ocf_core_t core, uint64_t addr, uint32_t bytes, int rw,
+		uint64_t core_line_first, uint64_t core_line_last)
+{
+	ocf_cache_t cache = queue->cache;
+	uint32_t core_line_count = core_line_last - core_line_first + 1;
 
 	OCF_DEBUG_TRACE(cache);
 
@@ -207,7 +387,8 @@ struct ocf_request *ocf_req_new(ocf_queue_t queue, ocf_core_t core,
 	req->cache = cache;
 
 	if (queue != cache->mngt_queue)
-		env_atomic_inc(&cache->pending_requests);
+		ocf_refcnt_inc_shard_force(&cache->pending_requests,
+				queue->id);
 
 	start_cache_req(req);
 
@@ -221,16 +402,84 @@ struct ocf_request *ocf_req_new(ocf_queue_t queue, ocf_core_t core,
 	req->alloc_core_line_count = core_line_count;
 	req->rw = rw;
 	req->part_id = PARTITION_DEFAULT;
+#if OCF_CONFIG_STATS_LATENCY
+	req->start_ticks = env_get_tick_count();
+#endif
+}
+
+struct ocf_request *ocf_req_new(ocf_queue_t queue, ocf_core_t core,
+		uint64_t addr, uint32_t bytes, int rw)
+{
+	uint64_t core_line_first, core_line_last, core_line_count;
+	ocf_cache_t cache = queue->cache;
+	struct ocf_request *req;
+	env_allocator *allocator;
+
+	ocf_req_get_lines(cache, addr, bytes, &core_line_first,
+			&core_line_last);
+	core_line_count = core_line_last - core_line_first + 1;
+
+	allocator = _ocf_req_get_allocator(cache, core_line_count);
+
+	req = ocf_req_cache_get(queue, core_line_count);
+	if (!req && allocator)
+		req = env_allocator_new(allocator);
+	else if (!req)
+		req = env_allocator_new(_ocf_req_get_allocator_1(cache));
+
+	if (unlikely(!req))
+		return NULL;
+
+	if (allocator)
+		req->map = req->__map;
+
+	ocf_req_init(req, queue, core, addr, bytes, rw, core_line_first,
+			core_line_last);
+
+	return req;
+}
+
+struct ocf_request *ocf_req_new_embedded(struct ocf_io *io, ocf_core_t core,
+		void *mem, uint32_t lines)
+{
+	uint64_t core_line_first, core_line_last, core_line_count;
+	ocf_queue_t queue = io->io_queue;
+	struct ocf_request *req = mem;
+
+	ocf_req_get_lines(queue->cache, io->addr, io->bytes, &core_line_first,
+			&core_line_last);
+	core_line_count = core_line_last - core_line_first + 1;
+
+	/* Memory is still taken by request of previous submission of IO */
+	if (core_line_count > lines || req->owner_io)
+		return NULL;
+
+	ENV_BUG_ON(env_memset(req, ocf_req_sizeof(core_line_count), 0));
+
+	req->map = req->__map;
+	req->owner_io = io;
+	ocf_io_get(io);
+
+	ocf_req_init(req, queue, core, io->addr, io->bytes, io->dir,
+			core_line_first, core_line_last);
 
 	return req;
 }
 
 int ocf_req_alloc_map(struct ocf_request *req)
 {
+	env_allocator *allocator;
+
 	if (req->map)
 		return 0;
 
-	req->map = env_zalloc(ocf_req_sizeof_map(req), ENV_MEM_NOIO);
+	allocator = _ocf_req_get_map_allocator(req->cache,
+			req->alloc_core_line_count);
+	if (allocator)
+		req->map = env_allocator_new(allocator);
+	else
+		req->map = env_zalloc(ocf_req_sizeof_map(req), ENV_MEM_NOIO);
+
 	if (!req->map) {
 		req->error = -ENOMEM;
 		return -ENOMEM;
@@ -278,33 +527,73 @@ void ocf_req_get(struct ocf_request *req)
 	env_atomic_inc(&req->ref_count);
 }
 
+/* Request memory is released together with IO it is embedded in */
+static void ocf_req_put_embedded(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	ocf_queue_t queue = req->io_queue;
+	uint32_t queue_id = queue->id;
+	struct ocf_io *io = req->owner_io;
+
+	ocf_queue_put(queue);
+
+	if (!req->d2c) {
+		ocf_refcnt_dec_shard(&cache->pending_cache_requests,
+				queue_id);
+	}
+
+	if (queue != cache->mngt_queue)
+		ocf_refcnt_dec_shard(&cache->pending_requests, queue_id);
+
+	req->owner_io = NULL;
+	ocf_io_put(io);
+}
+
 void ocf_req_put(struct ocf_request *req)
 {
+	ocf_cache_t cache = req->cache;
+	ocf_queue_t queue = req->io_queue;
+	uint32_t queue_id = queue->id;
+	bool d2c = req->d2c;
 	env_allocator *allocator;
+	bool cached;
 
 	if (env_atomic_dec_return(&req->ref_count))
 		return;
 
-	ocf_queue_put(req->io_queue);
+	OCF_DEBUG_TRACE(cache);
 
-	OCF_DEBUG_TRACE(req->cache);
+	if (req->owner_io) {
+		ocf_req_put_embedded(req);
+		return;
+	}
 
-	if (!req->d2c && !env_atomic_dec_return(
-			&req->cache->pending_cache_requests)) {
-		env_waitqueue_wake_up(&req->cache->pending_cache_wq);
+	allocator = _ocf_req_get_allocator(cache, req->alloc_core_line_count);
+	if (!allocator) {
+		allocator = _ocf_req_get_map_allocator(cache,
+				req->alloc_core_line_count);
+		if (allocator && req->map)
+			env_allocator_del(allocator, req->map);
+		else
+			env_free(req->map);
+		allocator = _ocf_req_get_allocator_1(cache);
 	}
 
-	if (req->io_queue != req->cache->mngt_queue)
-		env_atomic_dec(&req->cache->pending_requests);
+	/* Cached request is freed together with queue, so it must not be
+	 * accessed after queue is put
+	 */
+	cached = ocf_req_cache_put(queue, req);
 
-	allocator = _ocf_req_get_allocator(req->cache,
-			req->alloc_core_line_count);
-	if (allocator) {
+	ocf_queue_put(queue);
+
+	if (!d2c)
+		ocf_refcnt_dec_shard(&cache->pending_cache_requests, queue_id);
+
+	if (queue != cache->mngt_queue)
+		ocf_refcnt_dec_shard(&cache->pending_requests, queue_id);
+
+	if (!cached)
 		env_allocator_del(allocator, req);
-	} else {
-		env_free(req->map);
-		env_allocator_del(_ocf_req_get_allocator_1(req->cache), req);
-	}
 }
 
 void ocf_req_clear_info(struct ocf_request *req)
@@ -321,5 +610,5 @@ void ocf_req_clear_map(struct ocf_request *req)
 
 uint32_t ocf_req_get_allocated(struct ocf_cache *cache)
 {
-	return env_atomic_read(&cache->pending_requests);
+	return ocf_refcnt_read(&cache->pending_requests);
 }
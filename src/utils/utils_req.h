@@ -30,6 +30,22 @@ int ocf_req_allocator_init(struct ocf_ctx *ocf_ctx);
  */
 void ocf_req_allocator_deinit(struct ocf_ctx *ocf_ctx);
 
+/**
+ * @brief Get number of items and memory of request allocators per size class
+ *
+ * @param ocf_ctx - OCF context
+ * @param usage - Memory usage to be filled in
+ */
+void ocf_req_allocator_mem_usage(struct ocf_ctx *ocf_ctx,
+		struct ocf_cache_memory_usage *usage);
+
+/**
+ * @brief Free requests kept for reuse by I/O queue
+ *
+ * @param queue - I/O queue being released
+ */
+void ocf_req_cache_drain(ocf_queue_t queue);
+
 /**
  * @brief Allocate new OCF request
  *
@@ -44,6 +60,29 @@ void ocf_req_allocator_deinit(struct ocf_ctx *ocf_ctx);
 struct ocf_request *ocf_req_new(ocf_queue_t queue, ocf_core_t core,
 		uint64_t addr, uint32_t bytes, int rw);
 
+/**
+ * @brief Initialize OCF request of IO in memory embedded in the IO
+ *
+ * Request holds reference of the IO until it is put, so memory of both is
+ * released together.
+ *
+ * @param io - IO of request
+ * @param core - OCF core instance
+ * @param mem - Memory for request with map of given number of lines
+ * @param lines - Number of map entries which fit in memory
+ *
+ * @return new OCF request, NULL if IO spans more cache lines than fit in
+ *	memory or memory is still taken by previous request of the IO
+ */
+struct ocf_request *ocf_req_new_embedded(struct ocf_io *io, ocf_core_t core,
+		void *mem, uint32_t lines);
+
+/**
+ * @brief Size of memory of request embedded in IO
+ */
+#define OCF_REQ_EMBEDDED_SIZE(lines) (sizeof(struct ocf_request) + \
+		(lines) * sizeof(struct ocf_map_info))
+
 /**
  * @brief Allocate OCF request map
  *
@@ -0,0 +1,117 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "utils_sort.h"
+#include "../ocf_def_priv.h"
+
+/*
+ * LSD radix sort of (key, index) pairs, one key at a time from the least
+ * significant one. Only digits which differ among entries are sorted by,
+ * thus dense keys take few passes over table. Table itself is permuted
+ * once, after order of all keys is known.
+ */
+#define OCF_SORT_RADIX_BITS		8
+#define OCF_SORT_RADIX_BUCKETS		(1 << OCF_SORT_RADIX_BITS)
+#define OCF_SORT_RADIX_MASK		(OCF_SORT_RADIX_BUCKETS - 1)
+
+/* Below this number of entries comparison sort is faster */
+#define OCF_SORT_RADIX_MIN_ENTRIES	256
+
+struct ocf_sort_entry {
+	uint64_t key;
+	uint32_t idx;
+};
+
+static void _ocf_sort_radix_pass(struct ocf_sort_entry *from,
+		struct ocf_sort_entry *to, uint32_t num, uint32_t shift)
+{
+	uint32_t count[OCF_SORT_RADIX_BUCKETS] = { 0 };
+	uint32_t i, digit, pos, tmp;
+	uint32_t step = 0;
+
+	for (i = 0; i < num; i++)
+		count[(from[i].key >> shift) & OCF_SORT_RADIX_MASK]++;
+
+	for (digit = 0, pos = 0; digit < OCF_SORT_RADIX_BUCKETS; digit++) {
+		tmp = count[digit];
+		count[digit] = pos;
+		pos += tmp;
+	}
+
+	for (i = 0; i < num; i++) {
+		digit = (from[i].key >> shift) & OCF_SORT_RADIX_MASK;
+		to[count[digit]++] = from[i];
+
+		OCF_COND_RESCHED(step, 1000000)
+	}
+}
+
+static int _ocf_sort_radix(void *base, uint32_t num, uint32_t size,
+		uint32_t keys, ocf_sort_key_t key_fn)
+{
+	struct ocf_sort_entry *from, *to, *tmp;
+	bool sorted = true;
+	uint64_t diff;
+	uint32_t i, key, shift;
+	void *buf, *data;
+
+	buf = env_vmalloc((sizeof(*from) * 2 + size) * num);
+	if (!buf)
+		return -OCF_ERR_NO_MEM;
+
+	from = buf;
+	to = from + num;
+	data = to + num;
+
+	for (i = 0; i < num; i++)
+		from[i].idx = i;
+
+	/* Each pass is stable, so less significant key goes first */
+	for (key = keys; key-- > 0; ) {
+		diff = 0;
+		for (i = 0; i < num; i++) {
+			from[i].key = key_fn(base + from[i].idx * size, key);
+			diff |= from[i].key ^ from[0].key;
+		}
+
+		for (shift = 0; shift < 64 && (diff >> shift);
+				shift += OCF_SORT_RADIX_BITS) {
+			if (!((diff >> shift) & OCF_SORT_RADIX_MASK))
+				continue;
+
+			_ocf_sort_radix_pass(from, to, num, shift);
+			tmp = from;
+			from = to;
+			to = tmp;
+			sorted = false;
+		}
+	}
+
+	if (!sorted) {
+		for (i = 0; i < num; i++) {
+			env_memcpy(data + i * size, size,
+					base + from[i].idx * size, size);
+		}
+		env_memcpy(base, size * num, data, size * num);
+	}
+
+	env_vfree(buf);
+
+	return 0;
+}
+
+void ocf_sort(void *base, uint32_t num, uint32_t size, uint32_t keys,
+		ocf_sort_key_t key_fn,
+		int (*cmp_fn)(const void *, const void *),
+		void (*swap_fn)(void *, void *, int size))
+{
+	if (num >= OCF_SORT_RADIX_MIN_ENTRIES &&
+			!_ocf_sort_radix(base, num, size, keys, key_fn)) {
+		return;
+	}
+
+	/* Fall back to comparison sort if there is no memory for buffers */
+	env_sort(base, num, size, cmp_fn, swap_fn);
+}
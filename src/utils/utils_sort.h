@@ -0,0 +1,47 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_SORT_H__
+#define __UTILS_SORT_H__
+
+#include "ocf/ocf.h"
+
+/**
+ * @file utils_sort.h
+ * @brief Sorting of tables by integer keys
+ */
+
+/**
+ * @brief Get integer sort key of table entry
+ *
+ * @param entry - Table entry
+ * @param key - Key number, key 0 being the most significant one
+ *
+ * @retval Value of key
+ */
+typedef uint64_t (*ocf_sort_key_t)(const void *entry, uint32_t key);
+
+/**
+ * @brief Sort table by integer keys in ascending order
+ *
+ * Large tables are sorted with LSD radix sort on keys returned by key_fn,
+ * which calls no comparator at all. Small tables, and tables for which
+ * radix sort buffers can't be allocated, are sorted with env_sort() using
+ * cmp_fn and swap_fn, which must give the same order.
+ *
+ * @param base - Table to be sorted
+ * @param num - Number of table entries
+ * @param size - Size of table entry
+ * @param keys - Number of keys of entry
+ * @param key_fn - Key extractor
+ * @param cmp_fn - Entries comparator
+ * @param swap_fn - Entries swap function, may be NULL
+ */
+void ocf_sort(void *base, uint32_t num, uint32_t size, uint32_t keys,
+		ocf_sort_key_t key_fn,
+		int (*cmp_fn)(const void *, const void *),
+		void (*swap_fn)(void *, void *, int size));
+
+#endif /* __UTILS_SORT_H__ */
@@ -0,0 +1,202 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_def_priv.h"
+#include "../metadata/metadata.h"
+#include "../engine/cache_engine.h"
+#include "../engine/engine_common.h"
+#include "utils_cache_line.h"
+#include "utils_checkpoint.h"
+#include "utils_io.h"
+#include "utils_req.h"
+#include "utils_trim.h"
+
+#if OCF_CONFIG_TRIM_MIN_LINES > 0
+
+/* Number of cache lines checked by single search of marked run */
+#define OCF_TRIM_SCAN_LINES (64 * 1024)
+
+/* Maximum size of range discarded at once */
+#define OCF_TRIM_MAX_BYTES (64 * MiB)
+
+void ocf_trim_reset(ocf_cache_t cache)
+{
+	struct ocf_cache_device *device = cache->device;
+
+	env_memset(device->trim.bits, sizeof(uint64_t) *
+			OCF_DIV_ROUND_UP(device->collision_table_entries, 64),
+			0);
+	device->trim.cursor = 0;
+	device->trim.count = 0;
+}
+
+static inline bool ocf_trim_test(struct ocf_cache_device *device,
+		ocf_cache_line_t phy)
+{
+	return device->trim.bits[phy / 64] & (1ULL << (phy % 64));
+}
+
+/*
+ * Find run of at least OCF_CONFIG_TRIM_MIN_LINES marked cache lines. Search
+ * starts where previous one ended and is bounded, so it may take a few
+ * searches to get through whole cache.
+ *
+ * Returns false if no run was found.
+ */
+static bool ocf_trim_find(ocf_cache_t cache, ocf_cache_line_t *start,
+		ocf_cache_line_t *end)
+{
+	struct ocf_cache_device *device = cache->device;
+	ocf_cache_line_t entries = device->collision_table_entries;
+	ocf_cache_line_t max = OCF_MAX(OCF_TRIM_MAX_BYTES / ocf_line_size(cache),
+			OCF_CONFIG_TRIM_MIN_LINES);
+	ocf_cache_line_t limit = OCF_MIN(entries, OCF_TRIM_SCAN_LINES);
+	ocf_cache_line_t phy = device->trim.cursor;
+	ocf_cache_line_t scanned = 0, first, skip;
+	uint64_t rest;
+
+	while (scanned < limit) {
+		if (phy >= entries)
+			phy = 0;
+
+		rest = device->trim.bits[phy / 64] >> (phy % 64);
+		if (!rest) {
+			skip = 64 - phy % 64;
+			phy += skip;
+			scanned += skip;
+			continue;
+		}
+
+		skip = __builtin_ctzll(rest);
+		phy += skip;
+		scanned += skip;
+
+		first = phy;
+		while (phy < entries && phy - first < max &&
+				ocf_trim_test(device, phy)) {
+			phy++;
+		}
+		scanned += phy - first;
+
+		if (phy - first >= OCF_CONFIG_TRIM_MIN_LINES) {
+			device->trim.cursor = phy;
+			*start = first;
+			*end = phy;
+			return true;
+		}
+	}
+
+	device->trim.cursor = phy;
+
+	return false;
+}
+
+static void ocf_trim_complete(void *priv, int error)
+{
+	struct ocf_request *req = priv;
+
+	req->error = error;
+	ocf_engine_push_req_back(req, false);
+}
+
+/*
+ * Put run discarded in previous step back on free list, unmarked, and
+ * discard next one. Stops once no run is found or discard fails.
+ */
+static int ocf_trim_step(struct ocf_request *req)
+{
+	ocf_cache_t cache = req->cache;
+	struct ocf_cache_device *device = cache->device;
+	uint64_t line_size = ocf_line_size(cache);
+	ocf_cache_line_t phy, start, end;
+	bool found = false;
+
+	OCF_METADATA_LOCK_WR();
+
+	for (phy = device->trim.start; phy < device->trim.end; phy++) {
+		ocf_metadata_add_to_free_list(cache,
+				ocf_metadata_map_phy2lg(cache, phy));
+		ocf_trim_unmark(cache, phy);
+	}
+	device->trim.start = device->trim.end = 0;
+
+	if (!req->error && device->trim.count >= OCF_CONFIG_TRIM_MIN_LINES)
+		found = ocf_trim_find(cache, &start, &end);
+
+	if (found) {
+		/* No I/O may be mapped to range being discarded */
+		for (phy = start; phy < end; phy++) {
+			ocf_metadata_remove_from_free_list(cache,
+					ocf_metadata_map_phy2lg(cache, phy));
+		}
+		device->trim.start = start;
+		device->trim.end = end;
+	}
+
+	OCF_METADATA_UNLOCK_WR();
+
+	if (!found) {
+		if (req->error) {
+			ocf_cache_log(cache, log_warn, "Discarding freed cache "
+					"lines failed\n");
+		}
+
+		env_atomic_set(&device->trim.active, 0);
+		ocf_checkpoint_put(cache, req->io_queue->id);
+		ocf_req_put(req);
+		return 0;
+	}
+
+	req->error = 0;
+	ocf_submit_volume_discard(&device->volume,
+			device->metadata_offset + start * line_size,
+			(end - start) * line_size, ocf_trim_complete, req);
+
+	return 0;
+}
+
+static const struct ocf_io_if _io_if_trim = {
+	.read = ocf_trim_step,
+	.write = ocf_trim_step,
+};
+
+void ocf_trim_kick(ocf_cache_t cache, ocf_queue_t queue)
+{
+	struct ocf_cache_device *device = cache->device;
+	struct ocf_request *req;
+
+	/* Atomic cache device zeroes freed cache lines */
+	if (ocf_volume_is_atomic(&device->volume))
+		return;
+
+	if (device->trim.count < OCF_CONFIG_TRIM_MIN_LINES)
+		return;
+
+	if (env_atomic_cmpxchg(&device->trim.active, 0, 1))
+		return;
+
+	/* Discarded cache lines may still be mapped in metadata checkpoint */
+	if (!ocf_checkpoint_get(cache, queue->id)) {
+		env_atomic_set(&device->trim.active, 0);
+		return;
+	}
+
+	req = ocf_req_new(queue, NULL, 0, 0, OCF_WRITE);
+	if (!req) {
+		ocf_checkpoint_put(cache, queue->id);
+		env_atomic_set(&device->trim.active, 0);
+		return;
+	}
+
+	req->info.internal = true;
+	req->io_if = &_io_if_trim;
+	req->error = 0;
+
+	ocf_engine_push_req_back(req, false);
+}
+
+#endif
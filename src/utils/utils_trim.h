@@ -0,0 +1,94 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_TRIM_H__
+#define __UTILS_TRIM_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+
+/**
+ * @file utils_trim.h
+ * @brief Discarding of freed cache lines
+ *
+ * Physical cache lines put on free list are marked, and mark is dropped
+ * when cache line is taken off free list. The cleaner looks for runs of at
+ * least OCF_CONFIG_TRIM_MIN_LINES marked cache lines, takes each run off free
+ * list, discards it on cache device and puts it back on free list unmarked.
+ * One run is discarded at a time, so that discards don't compete with I/O.
+ */
+
+#if OCF_CONFIG_TRIM_MIN_LINES > 0
+/**
+ * @brief Mark cache line put on free list
+ *
+ * @note Caller has to have exclusive metadata access or free list lock
+ *
+ * @param cache - OCF cache instance
+ * @param phy - Physical cache line
+ */
+static inline void ocf_trim_mark(ocf_cache_t cache, ocf_cache_line_t phy)
+{
+	uint64_t *word = &cache->device->trim.bits[phy / 64];
+	uint64_t bit = 1ULL << (phy % 64);
+
+	if (!(*word & bit)) {
+		*word |= bit;
+		cache->device->trim.count++;
+	}
+}
+
+/**
+ * @brief Drop mark of cache line taken off free list
+ *
+ * @note Caller has to have exclusive metadata access or free list lock
+ *
+ * @param cache - OCF cache instance
+ * @param phy - Physical cache line
+ */
+static inline void ocf_trim_unmark(ocf_cache_t cache, ocf_cache_line_t phy)
+{
+	uint64_t *word = &cache->device->trim.bits[phy / 64];
+	uint64_t bit = 1ULL << (phy % 64);
+
+	if (*word & bit) {
+		*word &= ~bit;
+		cache->device->trim.count--;
+	}
+}
+
+/**
+ * @brief Drop all marks, free list was set up in bulk
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_trim_reset(ocf_cache_t cache);
+
+/**
+ * @brief Start discarding of freed cache lines if enough of them are marked
+ *
+ * @param cache - OCF cache instance
+ * @param queue - Queue to discard on
+ */
+void ocf_trim_kick(ocf_cache_t cache, ocf_queue_t queue);
+#else
+static inline void ocf_trim_mark(ocf_cache_t cache, ocf_cache_line_t phy)
+{
+}
+
+static inline void ocf_trim_unmark(ocf_cache_t cache, ocf_cache_line_t phy)
+{
+}
+
+static inline void ocf_trim_reset(ocf_cache_t cache)
+{
+}
+
+static inline void ocf_trim_kick(ocf_cache_t cache, ocf_queue_t queue)
+{
+}
+#endif
+
+#endif /* __UTILS_TRIM_H__ */
@@ -0,0 +1,108 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "ocf/ocf.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_ctx_priv.h"
+#include "../ocf_def_priv.h"
+#include "../metadata/metadata.h"
+#include "utils_cache_line.h"
+#include "utils_zero.h"
+
+#if OCF_CONFIG_ZERO_LINES
+
+int ocf_zero_lines_attach(ocf_cache_t cache)
+{
+	uint64_t line_size = ocf_line_size(cache);
+	ctx_data_t *data;
+
+	ENV_BUG_ON(cache->zero_lines.data);
+
+	data = ctx_data_alloc(cache->owner,
+			OCF_DIV_ROUND_UP(line_size, PAGE_SIZE));
+	if (!data) {
+		ocf_cache_log(cache, log_err,
+				"Cannot allocate zero lines data\n");
+		return -OCF_ERR_NO_MEM;
+	}
+
+	ctx_data_zero_check(cache->owner, data, line_size);
+
+	cache->zero_lines.data = data;
+
+	/* Zero line mark is not written together with data to atomic cache
+	 * device, so that zero writes are written as they are then
+	 */
+	cache->zero_lines.detect = cache->owner->ops->data.is_zero &&
+			!ocf_volume_is_atomic(&cache->device->volume);
+
+	return 0;
+}
+
+void ocf_zero_lines_detach(ocf_cache_t cache)
+{
+	if (!cache->zero_lines.data)
+		return;
+
+	ctx_data_free(cache->owner, cache->zero_lines.data);
+	cache->zero_lines.data = NULL;
+	cache->zero_lines.detect = false;
+}
+
+/* Offset in request data of given sector of cache line of map entry */
+static inline uint64_t ocf_zero_data_offset(struct ocf_request *req,
+		uint32_t map_idx, uint8_t start)
+{
+	return req->data_offset + ocf_lines_2_bytes(req->cache,
+			req->core_line_first + map_idx) +
+			SECTORS_TO_BYTES(start) - req->byte_position;
+}
+
+bool ocf_zero_line_read(struct ocf_request *req, uint32_t map_idx,
+		uint8_t start, uint8_t stop)
+{
+	ocf_cache_t cache = req->cache;
+
+	if (!ocf_metadata_get_zero(cache, req->map[map_idx].coll_idx))
+		return false;
+
+	ctx_data_cpy(cache->owner, req->data, cache->zero_lines.data,
+			ocf_zero_data_offset(req, map_idx, start), 0,
+			SECTORS_TO_BYTES(stop - start + 1));
+
+	return true;
+}
+
+bool ocf_zero_line_write(struct ocf_request *req, uint32_t map_idx)
+{
+	ocf_cache_t cache = req->cache;
+	ocf_cache_line_t line = req->map[map_idx].coll_idx;
+	uint8_t start, stop;
+	bool zero;
+
+	if (!cache->zero_lines.detect)
+		return false;
+
+	ocf_map_info_sectors(req, map_idx, &start, &stop);
+
+	zero = ocf_metadata_get_zero(cache, line);
+
+	/* Data of other valid sectors keeps cache line on cache device */
+	if (!zero && metadata_test_valid_any_out_sec(cache, line, start, stop))
+		return false;
+
+	if (!ctx_data_is_zero(cache->owner, req->data,
+			ocf_zero_data_offset(req, map_idx, start),
+			SECTORS_TO_BYTES(stop - start + 1))) {
+		return false;
+	}
+
+	if (!zero)
+		ocf_metadata_set_zero(cache, line, true);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __UTILS_ZERO_H__
+#define __UTILS_ZERO_H__
+
+#include "ocf/ocf.h"
+#include "../ocf_request.h"
+
+/**
+ * @file utils_zero.h
+ * @brief Cache lines holding only zeroes
+ *
+ * Cache line whose sectors written by request are all zeroes, while its
+ * other valid sectors are zeroes as well, is marked as zero line in metadata
+ * instead of being written to cache device. Reads of zero line copy zeroes
+ * to request data. Once data is written to some sectors of zero line, its
+ * other valid sectors are written to cache device with zeroes and the mark
+ * is cleared. Callers hold cache line locks, as for any access of cache line
+ * data.
+ */
+
+#if OCF_CONFIG_ZERO_LINES
+/**
+ * @brief Allocate cache line of zeroes of attached cache
+ *
+ * @param cache - OCF cache instance
+ *
+ * @retval 0 Zero lines set up
+ * @retval Non-zero Allocation failed
+ */
+int ocf_zero_lines_attach(ocf_cache_t cache);
+
+/**
+ * @brief Free cache line of zeroes
+ *
+ * @param cache - OCF cache instance
+ */
+void ocf_zero_lines_detach(ocf_cache_t cache);
+
+/**
+ * @brief Copy zeroes to request data of sectors of zero line
+ *
+ * @param req - OCF request
+ * @param map_idx - Index of map entry
+ * @param start - First sector of cache line to be read
+ * @param stop - Last sector of cache line to be read
+ *
+ * @retval true Cache line is zero line, request data filled in
+ * @retval false Cache line has to be read from cache device
+ */
+bool ocf_zero_line_read(struct ocf_request *req, uint32_t map_idx,
+		uint8_t start, uint8_t stop);
+
+/**
+ * @brief Mark cache line as zero line if request writes zeroes to it
+ *
+ * @param req - OCF request
+ * @param map_idx - Index of map entry, whose whole request range is written
+ *
+ * @retval true Cache line is zero line, nothing to be written
+ * @retval false Cache line has to be written to cache device
+ */
+bool ocf_zero_line_write(struct ocf_request *req, uint32_t map_idx);
+#else
+static inline int ocf_zero_lines_attach(ocf_cache_t cache)
+{
+	return 0;
+}
+
+static inline void ocf_zero_lines_detach(ocf_cache_t cache)
+{
+}
+#endif
+
+#endif /* __UTILS_ZERO_H__ */
@@ -0,0 +1,437 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * OCF cache line concurrency stress test. Cache line lock module is set up
+ * for bare cache structure and each thread repeatedly locks request mapped
+ * to random, distinct cache lines for read or write with ocf_req_trylock_rd()
+ * and ocf_req_trylock_wr(), waits for resume if lock was not acquired at once
+ * and releases request with one of unlock functions.
+ *
+ * Each cache line has shadow counter updated by lock holders, which checks
+ * that writer is exclusive and readers never overlap with writer. When all
+ * threads are done lock module has to be idle, with no waiters left.
+ *
+ * Three workloads are run at growing number of threads:
+ * - contended, requests of few hot cache lines, so that most of locks go
+ *   through waiters lists and lock hand-over between readers and writers,
+ * - sequential, as contended, but half of requests are mapped to
+ *   consecutive cache lines with no misses, so that they may be range
+ *   locked when built with OCF_CONFIG_RANGE_LOCK_MIN_LINES,
+ * - scaling, requests spread over many cache lines, to measure throughput
+ *   of uncontended paths.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include "ocf/ocf.h"
+#include "ocf/ocf_cache_priv.h"
+#include "ocf/ocf_request.h"
+#include "ocf/engine/cache_engine.h"
+#include "ocf/concurrency/ocf_concurrency.h"
+
+#define STRESS_LINES		(1024 * 1024)
+#define STRESS_REQ_LINES	8
+#define STRESS_MISS_RATIO	8
+#define STRESS_DURATION_MS	500
+#define STRESS_THREADS_MAX	64
+
+/* Shadow counter value of cache line held for write */
+#define STRESS_SHADOW_WR	(1 << 20)
+
+struct stress_workload {
+	const char *name;
+	ocf_cache_line_t lines;
+	uint32_t write_pct;
+	uint32_t seq_pct;
+	uint32_t hold;
+};
+
+static const struct stress_workload stress_workloads[] = {
+	{ .name = "contended", .lines = 64, .write_pct = 50, .hold = 64 },
+	{ .name = "sequential", .lines = 64, .write_pct = 50, .seq_pct = 50,
+			.hold = 64 },
+	{ .name = "scaling", .lines = STRESS_LINES, .write_pct = 30, },
+};
+
+struct stress_thread {
+	pthread_t thread;
+	const struct stress_workload *workload;
+	struct ocf_request *req;
+	env_atomic granted;
+	uint64_t rng;
+	uint64_t ops;
+	uint64_t waits;
+};
+
+static struct ocf_cache stress_cache;
+static struct ocf_cache_device stress_device;
+static env_atomic *stress_shadow;
+static env_atomic stress_violations;
+static env_atomic stress_stop;
+
+static inline uint64_t stress_rand(struct stress_thread *t)
+{
+	/* xorshift64 */
+	t->rng ^= t->rng << 13;
+	t->rng ^= t->rng >> 7;
+	t->rng ^= t->rng << 17;
+
+	return t->rng;
+}
+
+static void stress_violation(const char *what, ocf_cache_line_t line,
+		int value)
+{
+	if (env_atomic_inc_return(&stress_violations) <= 16) {
+		fprintf(stderr, "VIOLATION: %s, cache line %u, shadow %d\n",
+				what, line, value);
+	}
+}
+
+static void stress_resume(struct ocf_request *req)
+{
+	struct stress_thread *t = req->priv;
+
+	env_atomic_set(&t->granted, 1);
+}
+
+/*
+ * Map request to random distinct cache lines, some entries are misses, or
+ * to run of consecutive cache lines
+ */
+static void stress_req_map(struct stress_thread *t)
+{
+	const struct stress_workload *w = t->workload;
+	struct ocf_request *req = t->req;
+	ocf_cache_line_t line;
+	uint32_t i, j;
+
+	req->core_line_count = stress_rand(t) % STRESS_REQ_LINES + 1;
+	req->rw = stress_rand(t) % 100 < w->write_pct ? OCF_WRITE : OCF_READ;
+
+	if (stress_rand(t) % 100 < w->seq_pct) {
+		line = stress_rand(t) % (w->lines - req->core_line_count + 1);
+		for (i = 0; i < req->core_line_count; i++) {
+			req->map[i].coll_idx = line + i;
+			req->map[i].status = LOOKUP_HIT;
+		}
+		return;
+	}
+
+	for (i = 0; i < req->core_line_count; i++) {
+		do {
+			line = stress_rand(t) % w->lines;
+			for (j = 0; j < i; j++) {
+				if (req->map[j].coll_idx == line)
+					break;
+			}
+		} while (j < i);
+
+		req->map[i].coll_idx = line;
+		req->map[i].status = stress_rand(t) % STRESS_MISS_RATIO ?
+				LOOKUP_HIT : LOOKUP_MISS;
+	}
+}
+
+/*
+ * Account lock holder in shadow counters of request cache lines and check
+ * that lock was granted exclusively to writer or to readers only
+ */
+static void stress_req_hold(struct stress_thread *t)
+{
+	struct ocf_request *req = t->req;
+	ocf_cache_line_t line;
+	uint32_t i;
+	int value;
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (req->map[i].status == LOOKUP_MISS)
+			continue;
+
+		line = req->map[i].coll_idx;
+
+		if (req->rw == OCF_WRITE) {
+			if (!req->map[i].wr_locked || req->map[i].rd_locked)
+				stress_violation("write lock flags", line, 0);
+			value = env_atomic_add_return(STRESS_SHADOW_WR,
+					&stress_shadow[line]);
+			if (value != STRESS_SHADOW_WR)
+				stress_violation("write lock shared", line, value);
+		} else {
+			if (!req->map[i].rd_locked || req->map[i].wr_locked)
+				stress_violation("read lock flags", line, 0);
+			value = env_atomic_inc_return(&stress_shadow[line]);
+			if (value >= STRESS_SHADOW_WR)
+				stress_violation("read lock with writer", line,
+						value);
+		}
+	}
+
+	/* Keep lock for a while to widen contention windows */
+	for (i = 0; i < t->workload->hold; i++)
+		env_atomic_read(&stress_shadow[req->map[0].coll_idx]);
+
+	for (i = 0; i < req->core_line_count; i++) {
+		if (req->map[i].status == LOOKUP_MISS)
+			continue;
+
+		line = req->map[i].coll_idx;
+
+		if (req->rw == OCF_WRITE)
+			env_atomic_sub(STRESS_SHADOW_WR, &stress_shadow[line]);
+		else
+			env_atomic_dec(&stress_shadow[line]);
+	}
+}
+
+/*
+ * Release request with specific unlock function, generic one or entry by
+ * entry, so that all unlock paths are exercised
+ */
+static void stress_req_unlock(struct stress_thread *t)
+{
+	struct ocf_request *req = t->req;
+	uint32_t i;
+
+	switch (stress_rand(t) % 3) {
+	case 0:
+		if (req->rw == OCF_WRITE)
+			ocf_req_unlock_wr(req);
+		else
+			ocf_req_unlock_rd(req);
+		break;
+	case 1:
+		ocf_req_unlock(req);
+		break;
+	default:
+		for (i = 0; i < req->core_line_count; i++) {
+			if (req->map[i].status != LOOKUP_MISS)
+				ocf_req_unlock_entry(&stress_cache, req, i);
+		}
+		break;
+	}
+}
+
+static void *stress_thread_run(void *arg)
+{
+	struct stress_thread *t = arg;
+	struct ocf_request *req = t->req;
+	int ret;
+
+	while (!env_atomic_read(&stress_stop)) {
+		stress_req_map(t);
+
+		env_atomic_set(&t->granted, 0);
+		if (req->rw == OCF_WRITE)
+			ret = ocf_req_trylock_wr(req);
+		else
+			ret = ocf_req_trylock_rd(req);
+
+		if (ret < 0) {
+			stress_violation("lock error", 0, ret);
+			break;
+		}
+
+		if (ret != OCF_LOCK_ACQUIRED) {
+			/* Lock is granted and request resumed by other thread */
+			while (!env_atomic_read(&t->granted))
+				sched_yield();
+			t->waits++;
+		}
+
+		stress_req_hold(t);
+		stress_req_unlock(t);
+		t->ops++;
+	}
+
+	return NULL;
+}
+
+/*
+ * Check that all cache lines are unlocked with no waiters left
+ */
+static void stress_check_idle(const struct stress_workload *w)
+{
+	ocf_cache_line_t line;
+
+	if (ocf_cache_concurrency_suspended_no(&stress_cache)) {
+		stress_violation("suspended requests left", 0,
+				ocf_cache_concurrency_suspended_no(
+				&stress_cache));
+	}
+
+	for (line = 0; line < w->lines; line++) {
+		if (ocf_cache_line_is_used(&stress_cache, line)) {
+			stress_violation("cache line used", line,
+					env_atomic_read(&stress_shadow[line]));
+		}
+		if (env_atomic_read(&stress_shadow[line])) {
+			stress_violation("shadow not released", line,
+					env_atomic_read(&stress_shadow[line]));
+		}
+	}
+}
+
+static int stress_run(const struct stress_workload *w, uint32_t nthreads,
+		uint32_t duration_ms)
+{
+	struct stress_thread *threads;
+	uint64_t start, nsecs, ops = 0, waits = 0;
+	uint32_t i, started;
+	int ret = 0;
+
+	threads = calloc(nthreads, sizeof(*threads));
+	if (!threads)
+		return -ENOMEM;
+
+	for (i = 0; i < nthreads; i++) {
+		threads[i].workload = w;
+		threads[i].rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+		threads[i].req = calloc(1, sizeof(*threads[i].req) +
+				STRESS_REQ_LINES * sizeof(threads[i].req->__map[0]));
+		if (!threads[i].req) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		threads[i].req->cache = &stress_cache;
+		threads[i].req->map = threads[i].req->__map;
+		threads[i].req->priv = &threads[i];
+		threads[i].req->resume = stress_resume;
+	}
+
+	env_atomic_set(&stress_stop, 0);
+	start = env_get_tick_count();
+
+	for (started = 0; started < nthreads; started++) {
+		ret = pthread_create(&threads[started].thread, NULL,
+				stress_thread_run, &threads[started]);
+		if (ret) {
+			ret = -ret;
+			break;
+		}
+	}
+
+	if (!ret)
+		usleep(duration_ms * 1000);
+
+	env_atomic_set(&stress_stop, 1);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i].thread, NULL);
+
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+
+	if (ret)
+		goto out;
+
+	stress_check_idle(w);
+
+	for (i = 0; i < nthreads; i++) {
+		ops += threads[i].ops;
+		waits += threads[i].waits;
+	}
+
+	printf("  %3u threads %10llu requests %8llu Kreq/s %5.1f%% waited\n",
+			nthreads, (unsigned long long)ops,
+			(unsigned long long)(ops * 1000000ULL / nsecs),
+			ops ? 100.0 * waits / ops : 0.0);
+
+out:
+	for (i = 0; i < nthreads; i++)
+		free(threads[i].req);
+	free(threads);
+
+	return ret;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-t max threads] [-d duration of each run in ms]\n",
+			name);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t max_threads = OCF_MIN(sysconf(_SC_NPROCESSORS_ONLN) * 2,
+			STRESS_THREADS_MAX);
+	uint32_t duration_ms = STRESS_DURATION_MS;
+	uint32_t i, nthreads;
+	int opt, ret = 0;
+
+	while ((opt = getopt(argc, argv, "t:d:h")) != -1) {
+		switch (opt) {
+		case 't':
+			max_threads = strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			duration_ms = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (!max_threads || !duration_ms) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	stress_cache.device = &stress_device;
+	stress_device.collision_table_entries = STRESS_LINES;
+
+	stress_shadow = calloc(STRESS_LINES, sizeof(*stress_shadow));
+	if (!stress_shadow)
+		return 1;
+
+	/* Lock functions sample hash bucket generations of request */
+	if (ocf_metadata_concurrency_attached_init(&stress_cache)) {
+		free(stress_shadow);
+		return 1;
+	}
+
+	if (ocf_cache_concurrency_init(&stress_cache)) {
+		ocf_metadata_concurrency_attached_deinit(&stress_cache);
+		free(stress_shadow);
+		return 1;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(stress_workloads) && !ret; i++) {
+		printf("cache line locks, %s: %u cache lines, %u%% writes\n",
+				stress_workloads[i].name,
+				stress_workloads[i].lines,
+				stress_workloads[i].write_pct);
+
+		for (nthreads = 1; !ret; nthreads *= 2) {
+			nthreads = OCF_MIN(nthreads, max_threads);
+			ret = stress_run(&stress_workloads[i], nthreads,
+					duration_ms);
+			if (nthreads == max_threads)
+				break;
+		}
+	}
+
+	ocf_cache_concurrency_deinit(&stress_cache);
+	ocf_metadata_concurrency_attached_deinit(&stress_cache);
+	free(stress_shadow);
+
+	if (ret) {
+		printf("Stress test failed (%d)\n", ret);
+		return 1;
+	}
+
+	if (env_atomic_read(&stress_violations)) {
+		printf("FAILED: %d lock violations\n",
+				env_atomic_read(&stress_violations));
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,1240 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * OCF cache startup, load and shutdown benchmark. For each cache size cache
+ * is started on sparse file, filled with dirty cache lines mapped directly
+ * in metadata, without any data I/O, and timed through:
+ * - start and attach,
+ * - stop with all cache lines dirty,
+ * - load after clean shutdown,
+ * - load after dirty shutdown (recovery),
+ * - flush of all dirty cache lines,
+ * - stop of clean cache,
+ * - start, attach and load after dirty shutdown (recovery) of cache on
+ *   volume with atomic writes, which holds metadata of each sector.
+ * Cache volume keeps only metadata in the sparse file, its data area and
+ * core volume complete I/O immediately without touching data. Dirty
+ * shutdown is made by stopping cache with cache volume ignoring writes.
+ *
+ * It has to be built with OCF_CONFIG_PIPELINE_TIMING, time of management
+ * pipeline steps is taken from OCF log and printed for each operation,
+ * steps run more than once are summed up.
+ *
+ * Cache sizes in GiB may be given as arguments, 100 GiB, 1 TiB and 4 TiB
+ * caches are benchmarked by default. Sizes which don't fit in free memory
+ * are skipped.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/stat.h>
+#include "ocf/ocf.h"
+#include "ocf/ocf_cache_priv.h"
+#include "ocf/ocf_request.h"
+#include "ocf/metadata/metadata.h"
+#include "ocf/engine/engine_common.h"
+#include "ocf/utils/utils_req.h"
+#include "ocf/utils/utils_cache_line.h"
+
+#if !OCF_CONFIG_PIPELINE_TIMING
+#error "Management benchmark requires OCF_CONFIG_PIPELINE_TIMING"
+#endif
+
+#define BENCH_NULL_TYPE		1
+#define BENCH_FILE_TYPE		2
+#define BENCH_ATOMIC_TYPE	3
+#define BENCH_CORE_SIZE		(1ULL << 50)
+#define BENCH_REQ_LINES		128
+#define BENCH_STEPS_MAX		128
+#define BENCH_STEP_NAME_SIZE	64
+
+/* Data buffer, accessed at its position moved by reads and writes */
+struct bench_data {
+	void *ptr;
+	uint32_t offset;
+};
+
+struct bench_io {
+	ctx_data_t *data;
+	uint32_t offset;
+};
+
+/* Cache volume state, kept across cache stop and load */
+static struct {
+	uint64_t persist_limit;
+	/*!< Data beyond it is not kept in file */
+
+	bool frozen;
+	/*!< Writes are completed without being done, to make dirty shutdown */
+
+	uint64_t data_offset;
+	uint32_t line_sectors;
+	ocf_seq_no_t core_seq_no;
+	/*!< Atomic metadata of each sector is made up from them */
+} bench_volume;
+
+/* Steps of management pipelines of timed operation */
+static struct {
+	pthread_mutex_t lock;
+	uint32_t count;
+	struct {
+		char name[BENCH_STEP_NAME_SIZE];
+		uint64_t usecs;
+		uint32_t runs;
+	} steps[BENCH_STEPS_MAX];
+} bench_steps = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static ctx_data_t *bench_data_alloc(uint32_t pages)
+{
+	struct bench_data *data;
+
+	data = calloc(1, sizeof(*data));
+	if (!data)
+		return NULL;
+
+	data->ptr = calloc(pages, PAGE_SIZE);
+	if (!data->ptr) {
+		free(data);
+		return NULL;
+	}
+
+	return data;
+}
+
+static void bench_data_free(ctx_data_t *ctx_data)
+{
+	struct bench_data *data = ctx_data;
+
+	if (!data)
+		return;
+
+	free(data->ptr);
+	free(data);
+}
+
+static int bench_data_mlock(ctx_data_t *ctx_data)
+{
+	return 0;
+}
+
+static void bench_data_munlock(ctx_data_t *ctx_data)
+{
+}
+
+static uint32_t bench_data_read(void *dst, ctx_data_t *src, uint32_t size)
+{
+	struct bench_data *data = src;
+
+	memcpy(dst, data->ptr + data->offset, size);
+	data->offset += size;
+
+	return size;
+}
+
+static uint32_t bench_data_write(ctx_data_t *dst, const void *src,
+		uint32_t size)
+{
+	struct bench_data *data = dst;
+
+	memcpy(data->ptr + data->offset, src, size);
+	data->offset += size;
+
+	return size;
+}
+
+static uint32_t bench_data_zero(ctx_data_t *dst, uint32_t size)
+{
+	struct bench_data *data = dst;
+
+	memset(data->ptr + data->offset, 0, size);
+	data->offset += size;
+
+	return size;
+}
+
+static uint32_t bench_data_seek(ctx_data_t *dst, ctx_data_seek_t seek,
+		uint32_t offset)
+{
+	struct bench_data *data = dst;
+
+	switch (seek) {
+	case ctx_data_seek_begin:
+		data->offset = offset;
+		break;
+	case ctx_data_seek_current:
+		data->offset += offset;
+		break;
+	}
+
+	return offset;
+}
+
+static uint64_t bench_data_copy(ctx_data_t *dst, ctx_data_t *src,
+		uint64_t to, uint64_t from, uint64_t bytes)
+{
+	struct bench_data *data_dst = dst;
+	struct bench_data *data_src = src;
+
+	memcpy(data_dst->ptr + to, data_src->ptr + from, bytes);
+
+	return bytes;
+}
+
+static void bench_data_secure_erase(ctx_data_t *ctx_data)
+{
+}
+
+/* Cleaner is never run, dirty cache lines are cleaned by timed flush */
+static int bench_cleaner_init(ocf_cleaner_t c)
+{
+	return 0;
+}
+
+static void bench_cleaner_stop(ocf_cleaner_t c)
+{
+}
+
+/*
+ * Metadata updater has to run in its own thread, as it is kicked with
+ * metadata I/O serialization lock held.
+ */
+struct bench_metadata_updater {
+	ocf_metadata_updater_t mu;
+	pthread_t thread;
+	sem_t sem;
+	bool stop;
+};
+
+static void *bench_metadata_updater_thread(void *arg)
+{
+	struct bench_metadata_updater *bmu = arg;
+
+	while (true) {
+		sem_wait(&bmu->sem);
+		if (bmu->stop)
+			break;
+		while (ocf_metadata_updater_run(bmu->mu))
+			;
+	}
+
+	return NULL;
+}
+
+static int bench_metadata_updater_init(ocf_metadata_updater_t mu)
+{
+	struct bench_metadata_updater *bmu;
+	int ret;
+
+	bmu = calloc(1, sizeof(*bmu));
+	if (!bmu)
+		return -ENOMEM;
+
+	bmu->mu = mu;
+	sem_init(&bmu->sem, 0, 0);
+	ocf_metadata_updater_set_priv(mu, bmu);
+
+	ret = pthread_create(&bmu->thread, NULL,
+			bench_metadata_updater_thread, bmu);
+	if (ret) {
+		sem_destroy(&bmu->sem);
+		free(bmu);
+		return -ret;
+	}
+
+	return 0;
+}
+
+static void bench_metadata_updater_kick(ocf_metadata_updater_t mu)
+{
+	struct bench_metadata_updater *bmu = ocf_metadata_updater_get_priv(mu);
+
+	sem_post(&bmu->sem);
+}
+
+static void bench_metadata_updater_stop(ocf_metadata_updater_t mu)
+{
+	struct bench_metadata_updater *bmu = ocf_metadata_updater_get_priv(mu);
+
+	bmu->stop = true;
+	sem_post(&bmu->sem);
+	pthread_join(bmu->thread, NULL);
+
+	sem_destroy(&bmu->sem);
+	free(bmu);
+}
+
+/*
+ * Account pipeline step logged by OCF, steps of the same name are summed
+ */
+static void bench_steps_add(const char *msg)
+{
+	char name[BENCH_STEP_NAME_SIZE];
+	unsigned long long usecs;
+	uint32_t i;
+
+	msg = strstr(msg, "Pipeline step ");
+	if (!msg || sscanf(msg, "Pipeline step %63[^:]: %llu us", name,
+			&usecs) != 2) {
+		return;
+	}
+
+	pthread_mutex_lock(&bench_steps.lock);
+
+	for (i = 0; i < bench_steps.count; i++) {
+		if (!strcmp(bench_steps.steps[i].name, name))
+			break;
+	}
+
+	if (i == bench_steps.count) {
+		if (i == BENCH_STEPS_MAX)
+			goto unlock;
+		strcpy(bench_steps.steps[i].name, name);
+		bench_steps.steps[i].usecs = 0;
+		bench_steps.steps[i].runs = 0;
+		bench_steps.count++;
+	}
+
+	bench_steps.steps[i].usecs += usecs;
+	bench_steps.steps[i].runs++;
+
+unlock:
+	pthread_mutex_unlock(&bench_steps.lock);
+}
+
+static int bench_logger_printf(ocf_logger_t logger, ocf_logger_lvl_t lvl,
+		const char *fmt, va_list args)
+{
+	char msg[256];
+	int ret;
+
+	ret = vsnprintf(msg, sizeof(msg), fmt, args);
+
+	bench_steps_add(msg);
+
+	if (lvl <= log_warn)
+		fputs(msg, stderr);
+
+	return ret;
+}
+
+static const struct ocf_ctx_config bench_ctx_cfg = {
+	.name = "OCF management benchmark",
+	.ops = {
+		.data = {
+			.alloc = bench_data_alloc,
+			.free = bench_data_free,
+			.mlock = bench_data_mlock,
+			.munlock = bench_data_munlock,
+			.read = bench_data_read,
+			.write = bench_data_write,
+			.zero = bench_data_zero,
+			.seek = bench_data_seek,
+			.copy = bench_data_copy,
+			.secure_erase = bench_data_secure_erase,
+		},
+
+		.cleaner = {
+			.init = bench_cleaner_init,
+			.stop = bench_cleaner_stop,
+		},
+
+		.metadata_updater = {
+			.init = bench_metadata_updater_init,
+			.kick = bench_metadata_updater_kick,
+			.stop = bench_metadata_updater_stop,
+		},
+
+		.logger = {
+			.printf = bench_logger_printf,
+		},
+	},
+};
+
+static int bench_io_set_data(struct ocf_io *io, ctx_data_t *data,
+		uint32_t offset)
+{
+	struct bench_io *bench_io = ocf_io_get_priv(io);
+
+	bench_io->data = data;
+	bench_io->offset = offset;
+
+	return 0;
+}
+
+static ctx_data_t *bench_io_get_data(struct ocf_io *io)
+{
+	struct bench_io *bench_io = ocf_io_get_priv(io);
+
+	return bench_io->data;
+}
+
+/*
+ * Null volume, used as core. Its length is given in volume uuid as decimal
+ * number.
+ */
+static int bench_null_open(ocf_volume_t volume, void *volume_params)
+{
+	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(volume);
+	uint64_t *length = ocf_volume_get_priv(volume);
+
+	*length = strtoull(ocf_uuid_to_str(uuid), NULL, 10);
+
+	return *length ? 0 : -EINVAL;
+}
+
+static void bench_null_close(ocf_volume_t volume)
+{
+}
+
+static void bench_null_submit(struct ocf_io *io)
+{
+	io->end(io, 0);
+}
+
+static unsigned int bench_get_max_io_size(ocf_volume_t volume)
+{
+	return 128 * KiB;
+}
+
+static uint64_t bench_null_get_length(ocf_volume_t volume)
+{
+	return *(uint64_t *)ocf_volume_get_priv(volume);
+}
+
+static const struct ocf_volume_properties bench_null_properties = {
+	.name = "Null volume",
+	.io_priv_size = sizeof(struct bench_io),
+	.volume_priv_size = sizeof(uint64_t),
+	.caps = {
+		.atomic_writes = 0,
+	},
+	.ops = {
+		.open = bench_null_open,
+		.close = bench_null_close,
+		.submit_io = bench_null_submit,
+		.submit_flush = bench_null_submit,
+		.submit_discard = bench_null_submit,
+		.get_max_io_size = bench_get_max_io_size,
+		.get_length = bench_null_get_length,
+	},
+	.io_ops = {
+		.set_data = bench_io_set_data,
+		.get_data = bench_io_get_data,
+	},
+};
+
+/*
+ * Sparse file volume, used as cache. Its uuid is path of the file.
+ */
+struct bench_file {
+	int fd;
+	uint64_t length;
+};
+
+static int bench_file_open(ocf_volume_t volume, void *volume_params)
+{
+	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(volume);
+	struct bench_file *file = ocf_volume_get_priv(volume);
+	struct stat st;
+
+	file->fd = open(ocf_uuid_to_str(uuid), O_RDWR);
+	if (file->fd < 0)
+		return -errno;
+
+	if (fstat(file->fd, &st)) {
+		close(file->fd);
+		return -errno;
+	}
+
+	file->length = st.st_size;
+
+	return 0;
+}
+
+static void bench_file_close(ocf_volume_t volume)
+{
+	struct bench_file *file = ocf_volume_get_priv(volume);
+
+	close(file->fd);
+}
+
+static void bench_file_submit_io(struct ocf_io *io)
+{
+	struct bench_file *file = ocf_volume_get_priv(io->volume);
+	struct bench_io *bench_io = ocf_io_get_priv(io);
+	struct bench_data *data = bench_io->data;
+	void *buf = data->ptr + bench_io->offset;
+	uint64_t bytes = io->bytes;
+	ssize_t ret;
+
+	if (io->addr >= bench_volume.persist_limit) {
+		io->end(io, 0);
+		return;
+	}
+
+	bytes = OCF_MIN(bytes, bench_volume.persist_limit - io->addr);
+
+	if (io->dir == OCF_WRITE) {
+		ret = bench_volume.frozen ? bytes :
+				pwrite(file->fd, buf, bytes, io->addr);
+	} else {
+		ret = pread(file->fd, buf, bytes, io->addr);
+	}
+
+	io->end(io, ret == bytes ? 0 : -EIO);
+}
+
+static void bench_file_submit_flush(struct ocf_io *io)
+{
+	struct bench_file *file = ocf_volume_get_priv(io->volume);
+
+	io->end(io, fdatasync(file->fd) ? -errno : 0);
+}
+
+/* Discarded range reads as zeroes */
+static void bench_file_submit_discard(struct ocf_io *io)
+{
+	struct bench_file *file = ocf_volume_get_priv(io->volume);
+	uint64_t bytes;
+	int ret = 0;
+
+	if (io->addr < bench_volume.persist_limit && !bench_volume.frozen) {
+		bytes = OCF_MIN((uint64_t)io->bytes,
+				bench_volume.persist_limit - io->addr);
+		ret = fallocate(file->fd, FALLOC_FL_PUNCH_HOLE |
+				FALLOC_FL_KEEP_SIZE, io->addr, bytes);
+	}
+
+	io->end(io, ret ? -errno : 0);
+}
+
+/*
+ * Metadata of each sector of cache volume with atomic writes. All sectors
+ * are valid and dirty, cache line n holds core line n of the only core.
+ */
+static void bench_file_submit_metadata(struct ocf_io *io)
+{
+	struct bench_io *bench_io = ocf_io_get_priv(io);
+	struct bench_data *data = bench_io->data;
+	struct ocf_atomic_metadata *meta = data->ptr + bench_io->offset;
+	uint64_t sector = BYTES_TO_SECTORS(io->addr -
+			bench_volume.data_offset);
+	uint32_t i;
+
+	for (i = 0; i < BYTES_TO_SECTORS(io->bytes); i++, sector++) {
+		meta[i] = (struct ocf_atomic_metadata) {
+			.core_line = sector / bench_volume.line_sectors,
+			.core_seq_no = bench_volume.core_seq_no,
+			.valid = 1,
+			.dirty = 1,
+		};
+	}
+
+	io->end(io, 0);
+}
+
+static uint64_t bench_file_get_length(ocf_volume_t volume)
+{
+	struct bench_file *file = ocf_volume_get_priv(volume);
+
+	return file->length;
+}
+
+#define BENCH_FILE_OPS \
+	{ \
+		.open = bench_file_open, \
+		.close = bench_file_close, \
+		.submit_io = bench_file_submit_io, \
+		.submit_flush = bench_file_submit_flush, \
+		.submit_discard = bench_file_submit_discard, \
+		.submit_write_zeroes = bench_file_submit_discard, \
+		.submit_metadata = bench_file_submit_metadata, \
+		.get_max_io_size = bench_get_max_io_size, \
+		.get_length = bench_file_get_length, \
+	}
+
+static const struct ocf_volume_properties bench_file_properties = {
+	.name = "Sparse file volume",
+	.io_priv_size = sizeof(struct bench_io),
+	.volume_priv_size = sizeof(struct bench_file),
+	.caps = {
+		.atomic_writes = 0,
+	},
+	.ops = BENCH_FILE_OPS,
+	.io_ops = {
+		.set_data = bench_io_set_data,
+		.get_data = bench_io_get_data,
+	},
+};
+
+static const struct ocf_volume_properties bench_atomic_properties = {
+	.name = "Sparse file volume with atomic writes",
+	.io_priv_size = sizeof(struct bench_io),
+	.volume_priv_size = sizeof(struct bench_file),
+	.caps = {
+		.atomic_writes = 1,
+	},
+	.ops = BENCH_FILE_OPS,
+	.io_ops = {
+		.set_data = bench_io_set_data,
+		.get_data = bench_io_get_data,
+	},
+};
+
+/*
+ * Each queue is served by its own thread, so that management operations and
+ * metadata I/O never run recursively in context of caller.
+ */
+struct bench_queue {
+	ocf_queue_t queue;
+	pthread_t thread;
+	sem_t sem;
+	sem_t synced;
+	bool sync;
+	bool started;
+	bool stop;
+};
+
+static void *bench_queue_thread(void *arg)
+{
+	struct bench_queue *bq = arg;
+
+	while (true) {
+		sem_wait(&bq->sem);
+		ocf_queue_run(bq->queue);
+		if (bq->sync) {
+			bq->sync = false;
+			sem_post(&bq->synced);
+		}
+		if (bq->stop)
+			break;
+	}
+
+	return NULL;
+}
+
+static void bench_queue_kick(ocf_queue_t q)
+{
+	struct bench_queue *bq = ocf_queue_get_priv(q);
+
+	sem_post(&bq->sem);
+}
+
+static void bench_queue_stop(ocf_queue_t q)
+{
+	struct bench_queue *bq = ocf_queue_get_priv(q);
+
+	bq->stop = true;
+	sem_post(&bq->sem);
+	if (bq->started)
+		pthread_join(bq->thread, NULL);
+
+	sem_destroy(&bq->synced);
+	sem_destroy(&bq->sem);
+	free(bq);
+}
+
+static const struct ocf_queue_ops bench_queue_ops = {
+	.kick = bench_queue_kick,
+	.kick_sync = bench_queue_kick,
+	.stop = bench_queue_stop,
+};
+
+static int bench_queue_create(ocf_cache_t cache, ocf_queue_t *queue)
+{
+	struct bench_queue *bq;
+	int ret;
+
+	bq = calloc(1, sizeof(*bq));
+	if (!bq)
+		return -ENOMEM;
+
+	sem_init(&bq->sem, 0, 0);
+	sem_init(&bq->synced, 0, 0);
+
+	ret = ocf_queue_create(cache, &bq->queue, &bench_queue_ops);
+	if (ret) {
+		sem_destroy(&bq->synced);
+		sem_destroy(&bq->sem);
+		free(bq);
+		return ret;
+	}
+
+	ocf_queue_set_priv(bq->queue, bq);
+
+	ret = pthread_create(&bq->thread, NULL, bench_queue_thread, bq);
+	if (ret) {
+		ocf_queue_put(bq->queue);
+		return -ret;
+	}
+
+	bq->started = true;
+
+	*queue = bq->queue;
+
+	return 0;
+}
+
+/*
+ * Wait until queue thread is done with requests it is handling. Cache stop
+ * completes before management queue is done with it.
+ */
+static void bench_queue_sync(ocf_queue_t queue)
+{
+	struct bench_queue *bq = ocf_queue_get_priv(queue);
+
+	bq->sync = true;
+	sem_post(&bq->sem);
+	sem_wait(&bq->synced);
+}
+
+struct bench_mngt {
+	sem_t sem;
+	int error;
+	ocf_core_t core;
+};
+
+static void bench_mngt_init(struct bench_mngt *mngt)
+{
+	sem_init(&mngt->sem, 0, 0);
+	mngt->error = 0;
+	mngt->core = NULL;
+}
+
+static int bench_mngt_wait(struct bench_mngt *mngt)
+{
+	sem_wait(&mngt->sem);
+	sem_destroy(&mngt->sem);
+
+	return mngt->error;
+}
+
+static void bench_mngt_cache_cmpl(ocf_cache_t cache, void *priv, int error)
+{
+	struct bench_mngt *mngt = priv;
+
+	mngt->error = error;
+	sem_post(&mngt->sem);
+}
+
+static void bench_mngt_core_cmpl(ocf_cache_t cache, ocf_core_t core,
+		void *priv, int error)
+{
+	struct bench_mngt *mngt = priv;
+
+	mngt->core = core;
+	mngt->error = error;
+	sem_post(&mngt->sem);
+}
+
+struct bench {
+	ocf_ctx_t ctx;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	ocf_queue_t mngt_queue;
+	ocf_queue_t queue;
+	ocf_cache_line_size_t line_size;
+	const char *dir;
+	char path[PATH_MAX];
+	uint64_t start;
+};
+
+static void bench_op_start(struct bench *bench)
+{
+	pthread_mutex_lock(&bench_steps.lock);
+	bench_steps.count = 0;
+	pthread_mutex_unlock(&bench_steps.lock);
+
+	bench->start = env_get_tick_count();
+}
+
+static void bench_op_print(struct bench *bench, const char *name)
+{
+	uint64_t nsecs = env_ticks_to_nsecs(env_get_tick_count() -
+			bench->start);
+	uint32_t i;
+
+	printf("  %-40s %10.1f ms\n", name, nsecs / 1000000.0);
+
+	pthread_mutex_lock(&bench_steps.lock);
+	for (i = 0; i < bench_steps.count; i++) {
+		printf("    %-46s %10.1f ms", bench_steps.steps[i].name,
+				bench_steps.steps[i].usecs / 1000.0);
+		if (bench_steps.steps[i].runs > 1)
+			printf(" (%u runs)", bench_steps.steps[i].runs);
+		printf("\n");
+	}
+	pthread_mutex_unlock(&bench_steps.lock);
+
+	/* Keep output in order with OCF warnings */
+	fflush(stdout);
+}
+
+static int bench_stop(struct bench *bench)
+{
+	struct bench_mngt mngt;
+	int ret;
+
+	bench_mngt_init(&mngt);
+	ocf_mngt_cache_stop(bench->cache, bench_mngt_cache_cmpl, &mngt);
+	ret = bench_mngt_wait(&mngt);
+
+	if (bench->mngt_queue)
+		bench_queue_sync(bench->mngt_queue);
+
+	return ret;
+}
+
+/*
+ * Start cache and attach or load cache volume
+ */
+static int bench_start(struct bench *bench, uint8_t volume_type, bool load)
+{
+	struct ocf_mngt_cache_config cache_cfg = { };
+	struct ocf_mngt_cache_device_config device_cfg = { };
+	struct bench_mngt mngt;
+	int ret;
+
+	bench->mngt_queue = NULL;
+	bench->core = NULL;
+
+	cache_cfg.id = OCF_CACHE_ID_INVALID;
+	cache_cfg.name = "bench";
+	cache_cfg.cache_mode = ocf_cache_mode_wb;
+	cache_cfg.cache_line_size = bench->line_size;
+	cache_cfg.backfill.max_queue_size = 65536;
+	cache_cfg.backfill.queue_unblock_size = 60000;
+	cache_cfg.locked = true;
+
+	ret = ocf_mngt_cache_start(bench->ctx, &bench->cache, &cache_cfg);
+	if (ret)
+		return ret;
+
+	ret = bench_queue_create(bench->cache, &bench->mngt_queue);
+	if (ret)
+		goto err_stop;
+
+	ocf_mngt_cache_set_mngt_queue(bench->cache, bench->mngt_queue);
+
+	ret = bench_queue_create(bench->cache, &bench->queue);
+	if (ret)
+		goto err_stop;
+
+	device_cfg.volume_type = volume_type;
+	device_cfg.cache_line_size = bench->line_size;
+	device_cfg.force = true;
+	device_cfg.perform_test = true;
+	device_cfg.discard_on_start = true;
+	ret = ocf_uuid_set_str(&device_cfg.uuid, bench->path);
+	if (ret)
+		goto err_stop;
+
+	/* Whole volume is kept in file until data area is known */
+	bench_volume.persist_limit = ~0ULL;
+
+	bench_mngt_init(&mngt);
+	if (load) {
+		ocf_mngt_cache_load(bench->cache, &device_cfg,
+				bench_mngt_cache_cmpl, &mngt);
+	} else {
+		ocf_mngt_cache_attach(bench->cache, &device_cfg,
+				bench_mngt_cache_cmpl, &mngt);
+	}
+	ret = bench_mngt_wait(&mngt);
+	if (ret)
+		goto err_stop;
+
+	bench_volume.data_offset = bench->cache->device->metadata_offset;
+	bench_volume.persist_limit = bench_volume.data_offset;
+
+	if (load)
+		ret = ocf_core_get(bench->cache, 0, &bench->core);
+
+	return ret;
+
+err_stop:
+	bench_stop(bench);
+	return ret;
+}
+
+static int bench_add_core(struct bench *bench)
+{
+	struct ocf_mngt_core_config core_cfg = { };
+	struct bench_mngt mngt;
+	char uuid[OCF_VOLUME_UUID_MAX_SIZE];
+	int ret;
+
+	snprintf(uuid, sizeof(uuid), "%llu", BENCH_CORE_SIZE);
+
+	core_cfg.volume_type = BENCH_NULL_TYPE;
+	core_cfg.core_id = 0;
+	core_cfg.name = "core";
+	ret = ocf_uuid_set_str(&core_cfg.uuid, uuid);
+	if (ret)
+		return ret;
+
+	bench_mngt_init(&mngt);
+	ocf_mngt_cache_add_core(bench->cache, &core_cfg, bench_mngt_core_cmpl,
+			&mngt);
+	ret = bench_mngt_wait(&mngt);
+	if (ret)
+		return ret;
+
+	bench->core = mngt.core;
+	bench_volume.core_seq_no = bench->cache->core_conf_meta[0].seq_no;
+
+	return 0;
+}
+
+static void bench_resume(struct ocf_request *req)
+{
+	/* Cache lines are never locked */
+	ENV_BUG();
+}
+
+/*
+ * Map all cache lines to consecutive core lines and mark them valid and
+ * dirty, the same way write-back engine does
+ */
+static int bench_populate(struct bench *bench)
+{
+	ocf_cache_t cache = bench->cache;
+	ocf_cache_line_t lines = cache->device->collision_table_entries;
+	struct ocf_request *req;
+	uint64_t core_line;
+	int ret = 0;
+
+	req = ocf_req_new(bench->queue, bench->core, 0,
+			BENCH_REQ_LINES * bench->line_size, OCF_WRITE);
+	if (!req)
+		return -ENOMEM;
+
+	if (ocf_req_alloc_map(req)) {
+		ocf_req_put(req);
+		return -ENOMEM;
+	}
+
+	req->resume = bench_resume;
+
+	OCF_METADATA_LOCK_WR();
+
+	for (core_line = 0; core_line < lines; core_line += BENCH_REQ_LINES) {
+		req->core_line_first = core_line;
+		req->core_line_count = OCF_MIN(BENCH_REQ_LINES,
+				lines - core_line);
+		req->core_line_last = core_line + req->core_line_count - 1;
+		req->byte_position = core_line * bench->line_size;
+		req->byte_length = req->core_line_count * bench->line_size;
+
+		ocf_engine_traverse(req);
+		ocf_engine_map(req);
+		if (req->info.eviction_error) {
+			ret = -ENOSPC;
+			break;
+		}
+
+		ocf_set_valid_map_info(req);
+		ocf_set_dirty_map_info(req);
+	}
+
+	OCF_METADATA_UNLOCK_WR();
+
+	ocf_req_put(req);
+
+	return ret;
+}
+
+static int bench_flush(struct bench *bench)
+{
+	struct bench_mngt mngt;
+
+	bench_mngt_init(&mngt);
+	ocf_mngt_cache_flush(bench->cache, false, bench_mngt_cache_cmpl,
+			&mngt);
+
+	return bench_mngt_wait(&mngt);
+}
+
+/*
+ * Stop cache leaving metadata on cache volume as it was after start, as if
+ * the system crashed
+ */
+static int bench_crash(struct bench *bench)
+{
+	int ret;
+
+	bench_volume.frozen = true;
+	ret = bench_stop(bench);
+	bench_volume.frozen = false;
+
+	return ret;
+}
+
+static int bench_file_create(struct bench *bench, uint64_t size)
+{
+	int fd;
+
+	snprintf(bench->path, sizeof(bench->path), "%s/ocf_mngt_bench.XXXXXX",
+			bench->dir);
+
+	fd = mkstemp(bench->path);
+	if (fd < 0)
+		return -errno;
+
+	if (ftruncate(fd, size)) {
+		close(fd);
+		unlink(bench->path);
+		return -errno;
+	}
+
+	close(fd);
+
+	return 0;
+}
+
+static void bench_print_memory(struct bench *bench)
+{
+	struct ocf_cache_memory_usage usage;
+	uint32_t i;
+
+	if (ocf_cache_get_memory_usage(bench->cache, &usage))
+		return;
+
+	printf("  memory usage %38.1f MiB\n", usage.total / (double)MiB);
+	for (i = 0; i < usage.segments_count; i++) {
+		printf("    %-46s %10.1f MiB\n", usage.segments[i].name,
+				usage.segments[i].bytes / (double)MiB);
+	}
+	printf("    %-46s %10.1f MiB\n", "Other metadata",
+			usage.metadata_other / (double)MiB);
+	printf("    %-46s %10.1f MiB\n", "Concurrency",
+			usage.concurrency / (double)MiB);
+	printf("    %-46s %10.1f MiB\n", "Cleaning policy",
+			usage.cleaning / (double)MiB);
+	printf("    %-46s %10.1f MiB\n", "Promotion",
+			usage.promotion / (double)MiB);
+	printf("    %-46s %10.1f MiB\n", "Statistics",
+			usage.stats / (double)MiB);
+	fflush(stdout);
+}
+
+#define BENCH_OP(bench, name, op) ({ \
+	int __ret; \
+	bench_op_start(bench); \
+	__ret = (op); \
+	if (!__ret) \
+		bench_op_print(bench, name); \
+	__ret; \
+})
+
+static int bench_run_legacy(struct bench *bench)
+{
+	int ret;
+
+	ret = BENCH_OP(bench, "start",
+			bench_start(bench, BENCH_FILE_TYPE, false));
+	if (ret)
+		return ret;
+
+	printf("  %u cache lines, %llu MiB of metadata\n",
+			bench->cache->device->collision_table_entries,
+			(unsigned long long)(bench->cache->device->
+			metadata_offset / MiB));
+
+	ret = bench_add_core(bench);
+	if (ret)
+		goto err_stop;
+
+	ret = BENCH_OP(bench, "populate (no pipeline)", bench_populate(bench));
+	if (ret)
+		goto err_stop;
+
+	bench_print_memory(bench);
+
+	ret = BENCH_OP(bench, "stop, dirty", bench_stop(bench));
+	if (ret)
+		return ret;
+
+	ret = BENCH_OP(bench, "load, clean shutdown",
+			bench_start(bench, BENCH_FILE_TYPE, true));
+	if (ret)
+		return ret;
+
+	ret = bench_crash(bench);
+	if (ret)
+		return ret;
+
+	ret = BENCH_OP(bench, "load, dirty shutdown",
+			bench_start(bench, BENCH_FILE_TYPE, true));
+	if (ret)
+		return ret;
+
+	ret = BENCH_OP(bench, "flush", bench_flush(bench));
+	if (ret)
+		goto err_stop;
+
+	return BENCH_OP(bench, "stop, clean", bench_stop(bench));
+
+err_stop:
+	bench_stop(bench);
+	return ret;
+}
+
+static int bench_run_atomic(struct bench *bench)
+{
+	int ret;
+
+	ret = BENCH_OP(bench, "start, atomic",
+			bench_start(bench, BENCH_ATOMIC_TYPE, false));
+	if (ret)
+		return ret;
+
+	ret = bench_add_core(bench);
+	if (ret) {
+		bench_stop(bench);
+		return ret;
+	}
+
+	bench_volume.line_sectors = ocf_line_sectors(bench->cache);
+
+	ret = bench_crash(bench);
+	if (ret)
+		return ret;
+
+	ret = BENCH_OP(bench, "load, atomic, dirty shutdown",
+			bench_start(bench, BENCH_ATOMIC_TYPE, true));
+	if (ret)
+		return ret;
+
+	return BENCH_OP(bench, "stop, atomic, dirty", bench_stop(bench));
+}
+
+static int bench_run(struct bench *bench, uint64_t size)
+{
+	int (*const runs[])(struct bench *bench) = {
+		bench_run_legacy,
+		bench_run_atomic,
+	};
+	uint32_t i;
+	int ret = 0;
+
+	printf("%llu GiB cache, %u KiB cache lines:\n",
+			(unsigned long long)(size / GiB),
+			(uint32_t)(bench->line_size / KiB));
+
+	for (i = 0; i < ARRAY_SIZE(runs) && !ret; i++) {
+		ret = bench_file_create(bench, size);
+		if (ret) {
+			printf("  skipped, unable to create %s (%d)\n",
+					bench->path, ret);
+			return 0;
+		}
+
+		ret = runs[i](bench);
+		unlink(bench->path);
+
+		if (ret == -OCF_ERR_NO_FREE_RAM) {
+			printf("  skipped, not enough free memory\n");
+			return 0;
+		}
+	}
+
+	if (ret)
+		printf("Benchmark failed (%d)\n", ret);
+
+	return ret;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [-l cache line size in KiB] [-d directory of "
+			"cache files] [cache size in GiB...]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	static const uint64_t defaults[] = { 100, 1024, 4096 };
+	struct bench bench = {
+		.line_size = ocf_cache_line_size_4,
+		.dir = "/tmp",
+	};
+	uint64_t size;
+	int opt, count, i, ret;
+
+	while ((opt = getopt(argc, argv, "l:d:h")) != -1) {
+		switch (opt) {
+		case 'l':
+			bench.line_size = strtoul(optarg, NULL, 10) * KiB;
+			break;
+		case 'd':
+			bench.dir = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (!ocf_cache_line_size_is_valid(bench.line_size)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	count = optind < argc ? argc - optind : ARRAY_SIZE(defaults);
+
+	ret = ocf_ctx_init(&bench.ctx, &bench_ctx_cfg);
+	if (ret)
+		return 1;
+
+	/* Cores of loaded cache are looked up in core pool */
+	ocf_mngt_core_pool_init(bench.ctx);
+
+	ret = ocf_ctx_register_volume_type(bench.ctx, BENCH_NULL_TYPE,
+			&bench_null_properties);
+	if (ret)
+		goto out;
+
+	ret = ocf_ctx_register_volume_type(bench.ctx, BENCH_FILE_TYPE,
+			&bench_file_properties);
+	if (ret)
+		goto out_null;
+
+	ret = ocf_ctx_register_volume_type(bench.ctx, BENCH_ATOMIC_TYPE,
+			&bench_atomic_properties);
+	if (ret)
+		goto out_file;
+
+	for (i = 0; i < count && !ret; i++) {
+		size = optind < argc ? strtoull(argv[optind + i], NULL, 10) :
+				defaults[i];
+		if (!size) {
+			usage(argv[0]);
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = bench_run(&bench, size * GiB);
+	}
+
+	ocf_ctx_unregister_volume_type(bench.ctx, BENCH_ATOMIC_TYPE);
+out_file:
+	ocf_ctx_unregister_volume_type(bench.ctx, BENCH_FILE_TYPE);
+out_null:
+	ocf_ctx_unregister_volume_type(bench.ctx, BENCH_NULL_TYPE);
+out:
+	ocf_mngt_core_pool_deinit(bench.ctx);
+	ocf_ctx_exit(bench.ctx);
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,1224 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * OCF metadata primitives benchmark. Starts a cache on a null volume, which
+ * completes I/O immediately without touching data, and times the primitives
+ * on the I/O path single threaded:
+ * - hash lookup of core line at growing collision chain length,
+ * - mapping of cache lines from the free list and with eviction,
+ * - traverse of multi-line requests,
+ * - collision chain lengths of hash table of full cache,
+ * - LRU promotion of cache line,
+ * - cache line read and write locks of request,
+ * - sector status bit operations.
+ * Cache line sizes in KiB may be given as arguments, 4 and 64 KiB lines are
+ * benchmarked by default to cover the narrowest and widest status bit maps.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include "ocf/ocf.h"
+#include "ocf/ocf_cache_priv.h"
+#include "ocf/ocf_request.h"
+#include "ocf/metadata/metadata.h"
+#include "ocf/engine/engine_common.h"
+#include "ocf/eviction/ops.h"
+#include "ocf/eviction/lru.h"
+#include "ocf/concurrency/ocf_concurrency.h"
+#include "ocf/utils/utils_req.h"
+#include "ocf/utils/utils_cache_line.h"
+
+#define BENCH_VOL_TYPE		1
+#define BENCH_CACHE_LINES	32768
+#define BENCH_CACHE_EXTRA	(64ULL * MiB)
+#define BENCH_CORE_SIZE		(1ULL << 50)
+
+#define BENCH_BUCKETS		1024
+#define BENCH_CHAIN_MAX		16
+#define BENCH_LOOKUP_ROUNDS	256
+#define BENCH_TRAVERSE_LINES	32
+#define BENCH_LOCK_LINES	32
+#define BENCH_LOCK_ROUNDS	(256 * 1024)
+#define BENCH_BITS_ROUNDS	16
+#define BENCH_SUBMIT_ROUNDS	(256 * 1024)
+
+/* Core lines mapped by mapping benchmark, away from lookup chains */
+#define BENCH_MAP_BASE		(1ULL << 32)
+
+struct bench_data {
+	void *ptr;
+	uint32_t offset;
+};
+
+struct bench_io {
+	ctx_data_t *data;
+	uint32_t offset;
+};
+
+static volatile uint64_t bench_sink;
+
+static ctx_data_t *bench_data_alloc(uint32_t pages)
+{
+	struct bench_data *data;
+
+	data = calloc(1, sizeof(*data));
+	if (!data)
+		return NULL;
+
+	data->ptr = calloc(pages, PAGE_SIZE);
+	if (!data->ptr) {
+		free(data);
+		return NULL;
+	}
+
+	return data;
+}
+
+static void bench_data_free(ctx_data_t *ctx_data)
+{
+	struct bench_data *data = ctx_data;
+
+	if (!data)
+		return;
+
+	free(data->ptr);
+	free(data);
+}
+
+static int bench_data_mlock(ctx_data_t *ctx_data)
+{
+	return 0;
+}
+
+static void bench_data_munlock(ctx_data_t *ctx_data)
+{
+}
+
+static uint32_t bench_data_read(void *dst, ctx_data_t *src, uint32_t size)
+{
+	struct bench_data *data = src;
+
+	memcpy(dst, data->ptr + data->offset, size);
+
+	return size;
+}
+
+static uint32_t bench_data_write(ctx_data_t *dst, const void *src,
+		uint32_t size)
+{
+	struct bench_data *data = dst;
+
+	memcpy(data->ptr + data->offset, src, size);
+
+	return size;
+}
+
+static uint32_t bench_data_zero(ctx_data_t *dst, uint32_t size)
+{
+	struct bench_data *data = dst;
+
+	memset(data->ptr + data->offset, 0, size);
+
+	return size;
+}
+
+static uint32_t bench_data_seek(ctx_data_t *dst, ctx_data_seek_t seek,
+		uint32_t offset)
+{
+	struct bench_data *data = dst;
+
+	switch (seek) {
+	case ctx_data_seek_begin:
+		data->offset = offset;
+		break;
+	case ctx_data_seek_current:
+		data->offset += offset;
+		break;
+	}
+
+	return offset;
+}
+
+static uint64_t bench_data_copy(ctx_data_t *dst, ctx_data_t *src,
+		uint64_t to, uint64_t from, uint64_t bytes)
+{
+	struct bench_data *data_dst = dst;
+	struct bench_data *data_src = src;
+
+	memcpy(data_dst->ptr + to, data_src->ptr + from, bytes);
+
+	return bytes;
+}
+
+static void bench_data_secure_erase(ctx_data_t *ctx_data)
+{
+}
+
+/* Cleaner is never run, primitives are timed on clean cache */
+static int bench_cleaner_init(ocf_cleaner_t c)
+{
+	return 0;
+}
+
+static void bench_cleaner_stop(ocf_cleaner_t c)
+{
+}
+
+/*
+ * Metadata updater has to run in its own thread, as it is kicked with
+ * metadata I/O serialization lock held.
+ */
+struct bench_metadata_updater {
+	ocf_metadata_updater_t mu;
+	pthread_t thread;
+	sem_t sem;
+	bool stop;
+};
+
+static void *bench_metadata_updater_thread(void *arg)
+{
+	struct bench_metadata_updater *bmu = arg;
+
+	while (true) {
+		sem_wait(&bmu->sem);
+		if (bmu->stop)
+			break;
+		while (ocf_metadata_updater_run(bmu->mu))
+			;
+	}
+
+	return NULL;
+}
+
+static int bench_metadata_updater_init(ocf_metadata_updater_t mu)
+{
+	struct bench_metadata_updater *bmu;
+	int ret;
+
+	bmu = calloc(1, sizeof(*bmu));
+	if (!bmu)
+		return -ENOMEM;
+
+	bmu->mu = mu;
+	sem_init(&bmu->sem, 0, 0);
+	ocf_metadata_updater_set_priv(mu, bmu);
+
+	ret = pthread_create(&bmu->thread, NULL,
+			bench_metadata_updater_thread, bmu);
+	if (ret) {
+		sem_destroy(&bmu->sem);
+		free(bmu);
+		return -ret;
+	}
+
+	return 0;
+}
+
+static void bench_metadata_updater_kick(ocf_metadata_updater_t mu)
+{
+	struct bench_metadata_updater *bmu = ocf_metadata_updater_get_priv(mu);
+
+	sem_post(&bmu->sem);
+}
+
+static void bench_metadata_updater_stop(ocf_metadata_updater_t mu)
+{
+	struct bench_metadata_updater *bmu = ocf_metadata_updater_get_priv(mu);
+
+	bmu->stop = true;
+	sem_post(&bmu->sem);
+	pthread_join(bmu->thread, NULL);
+
+	sem_destroy(&bmu->sem);
+	free(bmu);
+}
+
+static int bench_logger_printf(ocf_logger_t logger, ocf_logger_lvl_t lvl,
+		const char *fmt, va_list args)
+{
+	if (lvl > log_warn)
+		return 0;
+
+	return vfprintf(stderr, fmt, args);
+}
+
+static const struct ocf_ctx_config bench_ctx_cfg = {
+	.name = "OCF primitives benchmark",
+	.ops = {
+		.data = {
+			.alloc = bench_data_alloc,
+			.free = bench_data_free,
+			.mlock = bench_data_mlock,
+			.munlock = bench_data_munlock,
+			.read = bench_data_read,
+			.write = bench_data_write,
+			.zero = bench_data_zero,
+			.seek = bench_data_seek,
+			.copy = bench_data_copy,
+			.secure_erase = bench_data_secure_erase,
+		},
+
+		.cleaner = {
+			.init = bench_cleaner_init,
+			.stop = bench_cleaner_stop,
+		},
+
+		.metadata_updater = {
+			.init = bench_metadata_updater_init,
+			.kick = bench_metadata_updater_kick,
+			.stop = bench_metadata_updater_stop,
+		},
+
+		.logger = {
+			.printf = bench_logger_printf,
+		},
+	},
+};
+
+/*
+ * Null volume. Its length is given in volume uuid as decimal number.
+ */
+static int bench_volume_open(ocf_volume_t volume, void *volume_params)
+{
+	const struct ocf_volume_uuid *uuid = ocf_volume_get_uuid(volume);
+	uint64_t *length = ocf_volume_get_priv(volume);
+
+	*length = strtoull(ocf_uuid_to_str(uuid), NULL, 10);
+
+	return *length ? 0 : -EINVAL;
+}
+
+static void bench_volume_close(ocf_volume_t volume)
+{
+}
+
+static void bench_volume_submit(struct ocf_io *io)
+{
+	io->end(io, 0);
+}
+
+static unsigned int bench_volume_get_max_io_size(ocf_volume_t volume)
+{
+	return 128 * KiB;
+}
+
+static uint64_t bench_volume_get_length(ocf_volume_t volume)
+{
+	return *(uint64_t *)ocf_volume_get_priv(volume);
+}
+
+static int bench_io_set_data(struct ocf_io *io, ctx_data_t *data,
+		uint32_t offset)
+{
+	struct bench_io *bench_io = ocf_io_get_priv(io);
+
+	bench_io->data = data;
+	bench_io->offset = offset;
+
+	return 0;
+}
+
+static ctx_data_t *bench_io_get_data(struct ocf_io *io)
+{
+	struct bench_io *bench_io = ocf_io_get_priv(io);
+
+	return bench_io->data;
+}
+
+static const struct ocf_volume_properties bench_volume_properties = {
+	.name = "Null volume",
+	.io_priv_size = sizeof(struct bench_io),
+	.volume_priv_size = sizeof(uint64_t),
+	.caps = {
+		.atomic_writes = 0,
+	},
+	.ops = {
+		.open = bench_volume_open,
+		.close = bench_volume_close,
+		.submit_io = bench_volume_submit,
+		.submit_flush = bench_volume_submit,
+		.submit_discard = bench_volume_submit,
+		.get_max_io_size = bench_volume_get_max_io_size,
+		.get_length = bench_volume_get_length,
+	},
+	.io_ops = {
+		.set_data = bench_io_set_data,
+		.get_data = bench_io_get_data,
+	},
+};
+
+/*
+ * Each queue is served by its own thread, so that management operations and
+ * metadata I/O never run recursively in context of caller.
+ */
+struct bench_queue {
+	ocf_queue_t queue;
+	pthread_t thread;
+	sem_t sem;
+	sem_t synced;
+	bool sync;
+	bool started;
+	bool stop;
+};
+
+static void *bench_queue_thread(void *arg)
+{
+	struct bench_queue *bq = arg;
+
+	while (true) {
+		sem_wait(&bq->sem);
+		ocf_queue_run(bq->queue);
+		if (bq->sync) {
+			bq->sync = false;
+			sem_post(&bq->synced);
+		}
+		if (bq->stop)
+			break;
+	}
+
+	return NULL;
+}
+
+static void bench_queue_kick(ocf_queue_t q)
+{
+	struct bench_queue *bq = ocf_queue_get_priv(q);
+
+	sem_post(&bq->sem);
+}
+
+static void bench_queue_stop(ocf_queue_t q)
+{
+	struct bench_queue *bq = ocf_queue_get_priv(q);
+
+	bq->stop = true;
+	sem_post(&bq->sem);
+	if (bq->started)
+		pthread_join(bq->thread, NULL);
+
+	sem_destroy(&bq->synced);
+	sem_destroy(&bq->sem);
+	free(bq);
+}
+
+static const struct ocf_queue_ops bench_queue_ops = {
+	.kick = bench_queue_kick,
+	.kick_sync = bench_queue_kick,
+	.stop = bench_queue_stop,
+};
+
+static int bench_queue_create(ocf_cache_t cache, ocf_queue_t *queue)
+{
+	struct bench_queue *bq;
+	int ret;
+
+	bq = calloc(1, sizeof(*bq));
+	if (!bq)
+		return -ENOMEM;
+
+	sem_init(&bq->sem, 0, 0);
+	sem_init(&bq->synced, 0, 0);
+
+	ret = ocf_queue_create(cache, &bq->queue, &bench_queue_ops);
+	if (ret) {
+		sem_destroy(&bq->synced);
+		sem_destroy(&bq->sem);
+		free(bq);
+		return ret;
+	}
+
+	ocf_queue_set_priv(bq->queue, bq);
+
+	ret = pthread_create(&bq->thread, NULL, bench_queue_thread, bq);
+	if (ret) {
+		ocf_queue_put(bq->queue);
+		return -ret;
+	}
+
+	bq->started = true;
+
+	*queue = bq->queue;
+
+	return 0;
+}
+
+/*
+ * Wait until queue thread is done with requests it is handling. Cache stop
+ * completes before management queue is done with it.
+ */
+static void bench_queue_sync(ocf_queue_t queue)
+{
+	struct bench_queue *bq = ocf_queue_get_priv(queue);
+
+	bq->sync = true;
+	sem_post(&bq->sem);
+	sem_wait(&bq->synced);
+}
+
+struct bench_mngt {
+	sem_t sem;
+	int error;
+	ocf_core_t core;
+};
+
+static void bench_mngt_init(struct bench_mngt *mngt)
+{
+	sem_init(&mngt->sem, 0, 0);
+	mngt->error = 0;
+	mngt->core = NULL;
+}
+
+static int bench_mngt_wait(struct bench_mngt *mngt)
+{
+	sem_wait(&mngt->sem);
+	sem_destroy(&mngt->sem);
+
+	return mngt->error;
+}
+
+static void bench_mngt_cache_cmpl(ocf_cache_t cache, void *priv, int error)
+{
+	struct bench_mngt *mngt = priv;
+
+	mngt->error = error;
+	sem_post(&mngt->sem);
+}
+
+static void bench_mngt_core_cmpl(ocf_cache_t cache, ocf_core_t core,
+		void *priv, int error)
+{
+	struct bench_mngt *mngt = priv;
+
+	mngt->core = core;
+	mngt->error = error;
+	sem_post(&mngt->sem);
+}
+
+struct bench {
+	ocf_ctx_t ctx;
+	ocf_cache_t cache;
+	ocf_core_t core;
+	ocf_queue_t mngt_queue;
+	ocf_queue_t queue;
+	ocf_cache_line_size_t line_size;
+};
+
+static int bench_stop(struct bench *bench)
+{
+	struct bench_mngt mngt;
+	int ret;
+
+	bench_mngt_init(&mngt);
+	ocf_mngt_cache_stop(bench->cache, bench_mngt_cache_cmpl, &mngt);
+	ret = bench_mngt_wait(&mngt);
+
+	if (bench->mngt_queue)
+		bench_queue_sync(bench->mngt_queue);
+
+	return ret;
+}
+
+static int bench_start(struct bench *bench, ocf_cache_line_size_t line_size)
+{
+	struct ocf_mngt_cache_config cache_cfg = { };
+	struct ocf_mngt_cache_device_config device_cfg = { };
+	struct ocf_mngt_core_config core_cfg = { };
+	struct bench_mngt mngt;
+	char uuid[OCF_VOLUME_UUID_MAX_SIZE];
+	int ret;
+
+	bench->line_size = line_size;
+	bench->mngt_queue = NULL;
+
+	cache_cfg.id = OCF_CACHE_ID_INVALID;
+	cache_cfg.name = "bench";
+	cache_cfg.cache_mode = ocf_cache_mode_wt;
+	cache_cfg.cache_line_size = line_size;
+	cache_cfg.backfill.max_queue_size = 65536;
+	cache_cfg.backfill.queue_unblock_size = 60000;
+	cache_cfg.locked = true;
+
+	ret = ocf_mngt_cache_start(bench->ctx, &bench->cache, &cache_cfg);
+	if (ret)
+		return ret;
+
+	ret = bench_queue_create(bench->cache, &bench->mngt_queue);
+	if (ret)
+		goto err_stop;
+
+	ocf_mngt_cache_set_mngt_queue(bench->cache, bench->mngt_queue);
+
+	ret = bench_queue_create(bench->cache, &bench->queue);
+	if (ret)
+		goto err_stop;
+
+	snprintf(uuid, sizeof(uuid), "%llu", (unsigned long long)
+			(BENCH_CACHE_LINES * (uint64_t)line_size +
+			BENCH_CACHE_EXTRA));
+
+	device_cfg.volume_type = BENCH_VOL_TYPE;
+	device_cfg.cache_line_size = line_size;
+	device_cfg.force = true;
+	ret = ocf_uuid_set_str(&device_cfg.uuid, uuid);
+	if (ret)
+		goto err_stop;
+
+	bench_mngt_init(&mngt);
+	ocf_mngt_cache_attach(bench->cache, &device_cfg, bench_mngt_cache_cmpl,
+			&mngt);
+	ret = bench_mngt_wait(&mngt);
+	if (ret)
+		goto err_stop;
+
+	snprintf(uuid, sizeof(uuid), "%llu", BENCH_CORE_SIZE);
+
+	core_cfg.volume_type = BENCH_VOL_TYPE;
+	core_cfg.core_id = OCF_CORE_ID_INVALID;
+	core_cfg.name = "core";
+	ret = ocf_uuid_set_str(&core_cfg.uuid, uuid);
+	if (ret)
+		goto err_stop;
+
+	bench_mngt_init(&mngt);
+	ocf_mngt_cache_add_core(bench->cache, &core_cfg, bench_mngt_core_cmpl,
+			&mngt);
+	ret = bench_mngt_wait(&mngt);
+	if (ret)
+		goto err_stop;
+
+	bench->core = mngt.core;
+
+	return 0;
+
+err_stop:
+	bench_stop(bench);
+	return ret;
+}
+
+static void bench_resume(struct ocf_request *req)
+{
+	/* Locks of benchmark requests are never contended */
+	ENV_BUG();
+}
+
+static struct ocf_request *bench_req_new(struct bench *bench,
+		uint32_t lines)
+{
+	struct ocf_request *req;
+
+	req = ocf_req_new(bench->queue, bench->core, 0,
+			lines * bench->line_size, OCF_READ);
+	if (!req)
+		return NULL;
+
+	if (ocf_req_alloc_map(req)) {
+		ocf_req_put(req);
+		return NULL;
+	}
+
+	req->resume = bench_resume;
+
+	return req;
+}
+
+/*
+ * Map request to core lines starting at core_line, the same way I/O engines
+ * do. Caller has to hold metadata lock exclusively.
+ */
+static bool bench_req_map(struct ocf_request *req, uint64_t core_line)
+{
+	req->core_line_first = core_line;
+	req->core_line_last = core_line + req->core_line_count - 1;
+
+	ocf_engine_traverse(req);
+	if (ocf_engine_is_hit(req))
+		return true;
+
+	ocf_engine_map(req);
+
+	return !req->info.eviction_error;
+}
+
+static void bench_print(const char *name, uint64_t nsecs, uint64_t ops)
+{
+	printf("  %-40s %8.1f ns/op\n", name, (double)nsecs / ops);
+}
+
+/*
+ * Find core lines which land in BENCH_BUCKETS hash buckets spread over hash
+ * table, BENCH_CHAIN_MAX + 1 of them per bucket. Line [b][k] is k-th line
+ * of bucket b, the last one is never mapped and used for misses.
+ */
+static void bench_lookup_lines(ocf_cache_t cache, ocf_core_id_t core_id,
+		uint64_t (*lines)[BENCH_CHAIN_MAX + 1])
+{
+	uint32_t stride = cache->device->hash_table_entries / BENCH_BUCKETS;
+	uint32_t count[BENCH_BUCKETS] = { };
+	uint32_t found = 0, b;
+	ocf_cache_line_t hash;
+	uint64_t core_line;
+
+	for (core_line = 0; found < BENCH_BUCKETS; core_line++) {
+		hash = ocf_metadata_hash_func(cache, core_line, core_id);
+		if (hash % stride)
+			continue;
+
+		b = hash / stride;
+		if (b >= BENCH_BUCKETS || count[b] > BENCH_CHAIN_MAX)
+			continue;
+
+		lines[b][count[b]++] = core_line;
+		if (count[b] > BENCH_CHAIN_MAX)
+			found++;
+	}
+}
+
+/*
+ * Lookup time at collision chain length L. Mapping L core lines of each of
+ * BENCH_BUCKETS buckets builds chains of L entries. Mapping inserts at chain
+ * head, so the first mapped entry is the last one found, and miss has to
+ * walk the whole chain.
+ */
+static int bench_lookup(struct bench *bench)
+{
+	ocf_cache_t cache = bench->cache;
+	ocf_core_id_t core_id = ocf_core_get_id(bench->core);
+	struct ocf_map_info entry = { };
+	struct ocf_request *req;
+	uint64_t (*lines)[BENCH_CHAIN_MAX + 1];
+	uint32_t len, b, k, r, hits;
+	uint64_t start, nsecs;
+	char name[64];
+	int ret = 0;
+
+	if (BENCH_BUCKETS > cache->device->hash_table_entries ||
+			BENCH_BUCKETS * BENCH_CHAIN_MAX >
+			cache->device->collision_table_entries) {
+		return -ENOSPC;
+	}
+
+	lines = calloc(BENCH_BUCKETS, sizeof(*lines));
+	if (!lines)
+		return -ENOMEM;
+
+	req = bench_req_new(bench, 1);
+	if (!req) {
+		free(lines);
+		return -ENOMEM;
+	}
+
+	bench_lookup_lines(cache, core_id, lines);
+
+	printf(" lookup (ocf_engine_lookup_map_entry), %u buckets:\n",
+			BENCH_BUCKETS);
+
+	for (len = 1, k = 0; len <= BENCH_CHAIN_MAX; len *= 2) {
+		OCF_METADATA_LOCK_WR();
+		for (; k < len; k++) {
+			for (b = 0; b < BENCH_BUCKETS; b++) {
+				if (!bench_req_map(req, lines[b][k])) {
+					OCF_METADATA_UNLOCK_WR();
+					ret = -ENOSPC;
+					goto out;
+				}
+			}
+		}
+		OCF_METADATA_UNLOCK_WR();
+
+		OCF_METADATA_LOCK_RD();
+
+		hits = 0;
+		start = env_get_tick_count();
+		for (r = 0; r < BENCH_LOOKUP_ROUNDS; r++) {
+			for (b = 0; b < BENCH_BUCKETS; b++) {
+				ocf_engine_lookup_map_entry(cache, &entry,
+						core_id, lines[b][0]);
+				hits += entry.status == LOOKUP_HIT;
+			}
+		}
+		nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+		ENV_BUG_ON(hits != BENCH_LOOKUP_ROUNDS * BENCH_BUCKETS);
+		snprintf(name, sizeof(name), "chain %2u, hit at chain tail", len);
+		bench_print(name, nsecs, BENCH_LOOKUP_ROUNDS * BENCH_BUCKETS);
+
+		hits = 0;
+		start = env_get_tick_count();
+		for (r = 0; r < BENCH_LOOKUP_ROUNDS; r++) {
+			for (b = 0; b < BENCH_BUCKETS; b++) {
+				ocf_engine_lookup_map_entry(cache, &entry,
+						core_id, lines[b][BENCH_CHAIN_MAX]);
+				hits += entry.status == LOOKUP_HIT;
+			}
+		}
+		nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+		ENV_BUG_ON(hits);
+		snprintf(name, sizeof(name), "chain %2u, miss", len);
+		bench_print(name, nsecs, BENCH_LOOKUP_ROUNDS * BENCH_BUCKETS);
+
+		OCF_METADATA_UNLOCK_RD();
+	}
+
+out:
+	ocf_req_put(req);
+	free(lines);
+
+	return ret;
+}
+
+/*
+ * Mapping time of single line requests, first from the free list until the
+ * cache is full, then with eviction of the same number of lines.
+ */
+static int bench_map(struct bench *bench)
+{
+	ocf_cache_t cache = bench->cache;
+	struct ocf_request *req;
+	uint64_t core_line = BENCH_MAP_BASE;
+	uint64_t start, nsecs;
+	uint32_t i, count;
+
+	count = cache->device->freelist_part->curr_size;
+	if (!count)
+		return -ENOSPC;
+
+	req = bench_req_new(bench, 1);
+	if (!req)
+		return -ENOMEM;
+
+	printf(" map (ocf_engine_traverse + ocf_engine_map), 1 line:\n");
+
+	OCF_METADATA_LOCK_WR();
+
+	start = env_get_tick_count();
+	for (i = 0; i < count; i++)
+		ENV_BUG_ON(!bench_req_map(req, core_line++));
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("from free list", nsecs, count);
+
+	start = env_get_tick_count();
+	for (i = 0; i < count; i++)
+		ENV_BUG_ON(!bench_req_map(req, core_line++));
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("with eviction", nsecs, count);
+
+	OCF_METADATA_UNLOCK_WR();
+
+	ocf_req_put(req);
+
+	return 0;
+}
+
+/*
+ * Traverse time of multi-line requests over core lines mapped by mapping
+ * benchmark. Mapping range is walked once, so lookups of most requests
+ * don't find hash buckets and collision entries in CPU cache.
+ */
+static int bench_traverse(struct bench *bench)
+{
+	ocf_cache_t cache = bench->cache;
+	uint32_t count = cache->device->collision_table_entries * 2 /
+			BENCH_TRAVERSE_LINES;
+	struct ocf_request *req;
+	uint64_t start, nsecs, hits = 0;
+	uint32_t i, j;
+
+	req = bench_req_new(bench, BENCH_TRAVERSE_LINES);
+	if (!req)
+		return -ENOMEM;
+
+	printf(" traverse (ocf_engine_traverse), %u lines, lookup batch %u:\n",
+			BENCH_TRAVERSE_LINES, OCF_CONFIG_LOOKUP_BATCH);
+
+	OCF_METADATA_LOCK_RD();
+
+	start = env_get_tick_count();
+	for (i = 0; i < count; i++) {
+		req->core_line_first = BENCH_MAP_BASE +
+				(uint64_t)i * BENCH_TRAVERSE_LINES;
+		req->core_line_last = req->core_line_first +
+				BENCH_TRAVERSE_LINES - 1;
+		ocf_engine_traverse(req);
+		for (j = 0; j < BENCH_TRAVERSE_LINES; j++)
+			hits += req->map[j].status == LOOKUP_HIT;
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	printf("  %" ENV_PRIu64 " of %u core lines hit\n", hits,
+			count * BENCH_TRAVERSE_LINES);
+	bench_print("per core line", nsecs, count * BENCH_TRAVERSE_LINES);
+
+	OCF_METADATA_UNLOCK_RD();
+
+	ocf_req_put(req);
+
+	return 0;
+}
+
+/*
+ * LRU promotion time of mapped cache lines in pseudo random order. All
+ * benchmark requests are mapped to default partition.
+ */
+static int bench_lru(struct bench *bench)
+{
+	ocf_cache_t cache = bench->cache;
+	ocf_cache_line_t entries = cache->device->collision_table_entries;
+	ocf_cache_line_t *lines, line;
+	uint64_t start, nsecs;
+	uint32_t i, count = 0;
+
+	lines = calloc(entries, sizeof(*lines));
+	if (!lines)
+		return -ENOMEM;
+
+	OCF_METADATA_LOCK_WR();
+
+	/* Large step walks lines in different order than LRU list */
+	for (i = 0, line = 0; i < entries; i++) {
+		line = (line + 2654435761U) % entries;
+		if (ocf_metadata_get_partition_id(cache, line) ==
+				PARTITION_DEFAULT) {
+			lines[count++] = line;
+		}
+	}
+
+	printf(" LRU, %u lines:\n", count);
+
+	start = env_get_tick_count();
+	for (i = 0; i < count; i++)
+		evp_lru_hot_cline(cache, lines[i]);
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("evp_lru_hot_cline", nsecs, count);
+
+	start = env_get_tick_count();
+	for (i = 0; i < count; i++)
+		ocf_eviction_set_hot_cache_line(cache, lines[i]);
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("ocf_eviction_set_hot_cache_line", nsecs, count);
+
+	OCF_METADATA_UNLOCK_WR();
+
+	free(lines);
+
+	return 0;
+}
+
+static int bench_lock_req(struct bench *bench, uint32_t lines)
+{
+	ocf_cache_t cache = bench->cache;
+	struct ocf_request *req;
+	uint64_t start, nsecs;
+	char name[64];
+	uint32_t i;
+
+	req = bench_req_new(bench, lines);
+	if (!req)
+		return -ENOMEM;
+
+	OCF_METADATA_LOCK_WR();
+	ENV_BUG_ON(!bench_req_map(req, BENCH_MAP_BASE));
+	OCF_METADATA_UNLOCK_WR();
+
+	start = env_get_tick_count();
+	for (i = 0; i < BENCH_LOCK_ROUNDS; i++) {
+		ENV_BUG_ON(ocf_req_trylock_rd(req) != OCF_LOCK_ACQUIRED);
+		ocf_req_unlock_rd(req);
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	snprintf(name, sizeof(name), "read lock + unlock, %u lines", lines);
+	bench_print(name, nsecs, BENCH_LOCK_ROUNDS);
+
+	start = env_get_tick_count();
+	for (i = 0; i < BENCH_LOCK_ROUNDS; i++) {
+		ENV_BUG_ON(ocf_req_trylock_wr(req) != OCF_LOCK_ACQUIRED);
+		ocf_req_unlock_wr(req);
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	snprintf(name, sizeof(name), "write lock + unlock, %u lines", lines);
+	bench_print(name, nsecs, BENCH_LOCK_ROUNDS);
+
+	ocf_req_put(req);
+
+	return 0;
+}
+
+static int bench_lock(struct bench *bench)
+{
+	int ret;
+
+	printf(" request cache line locks (ocf_req_trylock_*):\n");
+
+	ret = bench_lock_req(bench, 1);
+	if (ret)
+		return ret;
+
+	return bench_lock_req(bench, BENCH_LOCK_LINES);
+}
+
+static void bench_submit_end(struct ocf_io *io, int error)
+{
+	env_atomic *completed = io->priv1;
+
+	ENV_BUG_ON(error);
+	env_atomic_inc(completed);
+}
+
+static struct ocf_io *bench_submit_io_new(struct bench *bench,
+		ctx_data_t *data, int dir, env_atomic *completed)
+{
+	struct ocf_io *io;
+
+	io = ocf_core_new_io(bench->core);
+	if (!io)
+		return NULL;
+
+	ocf_io_configure(io, BENCH_MAP_BASE * bench->line_size, 4 * KiB, dir,
+			0, 0);
+	ocf_io_set_queue(io, bench->queue);
+	ocf_io_set_cmpl(io, completed, NULL, bench_submit_end);
+	if (ocf_io_set_data(io, data, 0)) {
+		ocf_io_put(io);
+		return NULL;
+	}
+
+	return io;
+}
+
+/*
+ * 4 KiB read hits submitted through fast path, which null volumes complete
+ * in place. Time includes allocation of IO and its request.
+ */
+static int bench_submit(struct bench *bench)
+{
+	env_atomic completed;
+	uint64_t start, nsecs;
+	ctx_data_t *data;
+	struct ocf_io *io;
+	uint32_t i;
+
+	printf(" IO submission (ocf_core_submit_io_fast):\n");
+
+	data = bench_data_alloc(1);
+	if (!data)
+		return -ENOMEM;
+
+	/* Line is inserted into cache by write-through */
+	env_atomic_set(&completed, 0);
+	io = bench_submit_io_new(bench, data, OCF_WRITE, &completed);
+	if (!io) {
+		bench_data_free(data);
+		return -ENOMEM;
+	}
+	ocf_core_submit_io(io);
+	ocf_io_put(io);
+	while (!env_atomic_read(&completed))
+		sched_yield();
+
+	env_atomic_set(&completed, 0);
+	start = env_get_tick_count();
+	for (i = 0; i < BENCH_SUBMIT_ROUNDS; i++) {
+		io = bench_submit_io_new(bench, data, OCF_READ, &completed);
+		ENV_BUG_ON(!io);
+		ENV_BUG_ON(ocf_core_submit_io_fast(io));
+		ocf_io_put(io);
+	}
+	while (env_atomic_read(&completed) < BENCH_SUBMIT_ROUNDS)
+		sched_yield();
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("read hit, 4 KiB", nsecs, BENCH_SUBMIT_ROUNDS);
+
+	bench_data_free(data);
+
+	return 0;
+}
+
+/*
+ * Status bit operations over all cache lines, on whole line and on single
+ * sector ranges. Dirty bits are cleared again, so the cache stays clean.
+ */
+static void bench_bits(struct bench *bench)
+{
+	ocf_cache_t cache = bench->cache;
+	ocf_cache_line_t lines = cache->device->collision_table_entries;
+	uint8_t end = ocf_line_end_sector(cache);
+	uint64_t ops = (uint64_t)lines * BENCH_BITS_ROUNDS;
+	uint64_t start, nsecs, sink = 0;
+	ocf_cache_line_t line;
+	uint32_t r;
+
+	printf(" status bits, %u sectors per line:\n", end + 1);
+
+	start = env_get_tick_count();
+	for (r = 0; r < BENCH_BITS_ROUNDS; r++) {
+		for (line = 0; line < lines; line++)
+			metadata_set_dirty_sec(cache, line, 0, end);
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("metadata_set_dirty_sec, whole line", nsecs, ops);
+
+	start = env_get_tick_count();
+	for (r = 0; r < BENCH_BITS_ROUNDS; r++) {
+		for (line = 0; line < lines; line++)
+			sink += metadata_test_dirty(cache, line);
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("metadata_test_dirty", nsecs, ops);
+
+	start = env_get_tick_count();
+	for (r = 0; r < BENCH_BITS_ROUNDS; r++) {
+		for (line = 0; line < lines; line++) {
+			sink += metadata_test_dirty_all_sec(cache, line,
+					0, end);
+		}
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("metadata_test_dirty_all_sec, whole line", nsecs, ops);
+
+	start = env_get_tick_count();
+	for (r = 0; r < BENCH_BITS_ROUNDS; r++) {
+		for (line = 0; line < lines; line++) {
+			sink += metadata_find_dirty_sec(cache, line, 0,
+					false);
+		}
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("metadata_find_dirty_sec, none found", nsecs, ops);
+
+	start = env_get_tick_count();
+	for (r = 0; r < BENCH_BITS_ROUNDS; r++) {
+		for (line = 0; line < lines; line++)
+			metadata_clear_dirty_sec(cache, line, end, end);
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("metadata_clear_dirty_sec, one sector", nsecs, ops);
+
+	start = env_get_tick_count();
+	for (r = 0; r < BENCH_BITS_ROUNDS; r++) {
+		for (line = 0; line < lines; line++)
+			metadata_clear_dirty_sec(cache, line, 0, end);
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("metadata_clear_dirty_sec, whole line", nsecs, ops);
+
+	start = env_get_tick_count();
+	for (r = 0; r < BENCH_BITS_ROUNDS; r++) {
+		for (line = 0; line < lines; line++)
+			sink += metadata_test_valid_sec(cache, line, 0, end);
+	}
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+	bench_print("metadata_test_valid_sec, whole line", nsecs, ops);
+
+	bench_sink = sink;
+}
+
+/*
+ * Collision chain lengths of hash table filled by bench_map()
+ */
+static int bench_hash(struct bench *bench)
+{
+	struct ocf_stats_hash hash;
+	uint32_t i;
+	int ret;
+
+	ret = ocf_stats_collect_hash(bench->cache, &hash);
+	if (ret)
+		return ret;
+
+	printf(" hash chains (ocf_stats_collect_hash), load factor %u:\n",
+			hash.load_factor);
+	printf("  %u cache lines in %u of %u buckets, longest chain %u\n",
+			hash.lines, hash.used, hash.entries, hash.max_chain);
+	printf("  buckets by chain length:");
+	for (i = 0; i < OCF_STATS_HASH_CHAIN_HIST; i++)
+		printf(" %u", hash.chains[i]);
+	printf("\n");
+
+	return 0;
+}
+
+static int bench_run(struct bench *bench, ocf_cache_line_size_t line_size)
+{
+	int ret;
+
+	ret = bench_start(bench, line_size);
+	if (ret) {
+		printf("Unable to start cache (%d)\n", ret);
+		return ret;
+	}
+
+	printf("%u KiB cache lines, %u cache lines, %u hash buckets:\n",
+			(uint32_t)(line_size / KiB),
+			bench->cache->device->collision_table_entries,
+			bench->cache->device->hash_table_entries);
+
+	ret = bench_lookup(bench);
+	if (!ret)
+		ret = bench_map(bench);
+	if (!ret)
+		ret = bench_traverse(bench);
+	if (!ret)
+		ret = bench_hash(bench);
+	if (!ret)
+		ret = bench_lru(bench);
+	if (!ret)
+		ret = bench_lock(bench);
+	if (!ret)
+		ret = bench_submit(bench);
+	if (!ret)
+		bench_bits(bench);
+
+	if (ret)
+		printf("Benchmark failed (%d)\n", ret);
+
+	if (bench_stop(bench)) {
+		printf("Unable to stop cache\n");
+		return ret ?: -EIO;
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	static const ocf_cache_line_size_t defaults[] = {
+		ocf_cache_line_size_4,
+		ocf_cache_line_size_64,
+	};
+	struct bench bench = { };
+	ocf_cache_line_size_t line_size;
+	int count = argc > 1 ? argc - 1 : ARRAY_SIZE(defaults);
+	int i, ret;
+
+	ret = ocf_ctx_init(&bench.ctx, &bench_ctx_cfg);
+	if (ret)
+		return 1;
+
+	ret = ocf_ctx_register_volume_type(bench.ctx, BENCH_VOL_TYPE,
+			&bench_volume_properties);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		line_size = argc > 1 ? strtoul(argv[i + 1], NULL, 10) * KiB :
+				defaults[i];
+
+		if (!ocf_cache_line_size_is_valid(line_size)) {
+			printf("Invalid cache line size %s\n", argv[i + 1]);
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = bench_run(&bench, line_size);
+		if (ret)
+			break;
+	}
+
+	ocf_ctx_unregister_volume_type(bench.ctx, BENCH_VOL_TYPE);
+out:
+	ocf_ctx_exit(bench.ctx);
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * OCF I/O queue benchmark. Several producer threads push requests to
+ * a single queue, some of them to the front of the queue as resumed
+ * requests are. One consumer thread processes the queue with
+ * ocf_queue_run(). Build it with OCF_CONFIG_QUEUE_LOCKLESS set to 0 or 1
+ * to compare the spinlock protected list with the lock-free queue.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "ocf/ocf.h"
+#include "ocf/ocf_queue_priv.h"
+#include "ocf/ocf_cache_priv.h"
+#include "ocf/ocf_request.h"
+#include "ocf/engine/engine_common.h"
+
+#define BENCH_PRODUCERS		4
+#define BENCH_REQS_PER_PRODUCER	(1024 * 1024)
+#define BENCH_INFLIGHT		1024
+#define BENCH_FRONT_RATIO	16
+
+struct bench_producer {
+	pthread_t thread;
+	ocf_queue_t queue;
+	struct ocf_request **reqs;
+	env_atomic *inflight;
+};
+
+static env_atomic bench_done;
+static env_atomic bench_stop;
+
+static void bench_handle(struct ocf_io *io, void *opaque)
+{
+	struct ocf_request *req = opaque;
+
+	env_atomic_set(req->priv, 0);
+	env_atomic_inc(&bench_done);
+}
+
+static void bench_kick(ocf_queue_t q)
+{
+}
+
+static void bench_stop_queue(ocf_queue_t q)
+{
+}
+
+static const struct ocf_queue_ops bench_queue_ops = {
+	.kick = bench_kick,
+	.stop = bench_stop_queue,
+};
+
+static void *bench_producer_fn(void *arg)
+{
+	struct bench_producer *p = arg;
+	struct ocf_request *req;
+	uint32_t i, idx;
+
+	for (i = 0; i < BENCH_REQS_PER_PRODUCER; i++) {
+		idx = i % BENCH_INFLIGHT;
+		req = p->reqs[idx];
+
+		/* Wait until previous use of request is processed */
+		while (env_atomic_read(&p->inflight[idx]))
+			sched_yield();
+		env_atomic_set(&p->inflight[idx], 1);
+
+		if (i % BENCH_FRONT_RATIO)
+			ocf_engine_push_req_back(req, false);
+		else
+			ocf_engine_push_req_front(req, false);
+	}
+
+	return NULL;
+}
+
+static void *bench_consumer_fn(void *arg)
+{
+	ocf_queue_t q = arg;
+
+	while (!env_atomic_read(&bench_stop)) {
+		if (ocf_queue_pending_io(q))
+			ocf_queue_run(q);
+		else
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static int bench_producer_init(struct bench_producer *p, ocf_cache_t cache,
+		ocf_queue_t q, struct ocf_io *io)
+{
+	struct ocf_request *req;
+	uint32_t i;
+
+	p->queue = q;
+	p->reqs = calloc(BENCH_INFLIGHT, sizeof(*p->reqs));
+	p->inflight = calloc(BENCH_INFLIGHT, sizeof(*p->inflight));
+	if (!p->reqs || !p->inflight)
+		return -ENOMEM;
+
+	for (i = 0; i < BENCH_INFLIGHT; i++) {
+		req = calloc(1, sizeof(*req) + sizeof(req->__map[0]));
+		if (!req)
+			return -ENOMEM;
+
+		req->cache = cache;
+		req->io_queue = q;
+		req->io = io;
+		req->map = req->__map;
+		req->info.internal = true;
+		req->priv = &p->inflight[i];
+		p->reqs[i] = req;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct bench_producer producers[BENCH_PRODUCERS] = { };
+	struct ocf_io io = { .handle = bench_handle };
+	uint64_t total = (uint64_t)BENCH_PRODUCERS * BENCH_REQS_PER_PRODUCER;
+	uint64_t start, nsecs;
+	pthread_t consumer;
+	ocf_cache_t cache;
+	ocf_queue_t q;
+	int i;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return 1;
+	INIT_LIST_HEAD(&cache->io_queues);
+
+	if (ocf_queue_create(cache, &q, &bench_queue_ops))
+		return 1;
+
+	for (i = 0; i < BENCH_PRODUCERS; i++) {
+		if (bench_producer_init(&producers[i], cache, q, &io))
+			return 1;
+	}
+
+	pthread_create(&consumer, NULL, bench_consumer_fn, q);
+
+	start = env_get_tick_count();
+
+	for (i = 0; i < BENCH_PRODUCERS; i++) {
+		pthread_create(&producers[i].thread, NULL, bench_producer_fn,
+				&producers[i]);
+	}
+
+	for (i = 0; i < BENCH_PRODUCERS; i++)
+		pthread_join(producers[i].thread, NULL);
+
+	while (env_atomic_read(&bench_done) != total)
+		sched_yield();
+
+	nsecs = env_ticks_to_nsecs(env_get_tick_count() - start);
+
+	env_atomic_set(&bench_stop, 1);
+	pthread_join(consumer, NULL);
+
+	printf("%s queue: %d producers, %llu requests, %llu ns/request, "
+			"%llu Kreq/s\n",
+			OCF_CONFIG_QUEUE_LOCKLESS ? "lockless" : "list",
+			BENCH_PRODUCERS, (unsigned long long)total,
+			(unsigned long long)(nsecs / total),
+			(unsigned long long)(total * 1000000ULL / nsecs));
+
+	ocf_queue_put(q);
+
+	return 0;
+}
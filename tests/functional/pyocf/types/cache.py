@@ -24,12 +24,18 @@ from .shared import Uuid, OcfError, CacheLineSize, CacheLines, OcfCompletion
 from ..utils import Size, struct_to_dict
 from .core import Core
 from .queue import Queue
+from .cleaner import Cleaner
 from .stats.cache import CacheInfo
 from .stats.shared import UsageStats, RequestsStats, BlocksStats, ErrorsStats
 
 
 class Backfill(Structure):
-    _fields_ = [("_max_queue_size", c_uint32), ("_queue_unblock_size", c_uint32)]
+    _fields_ = [
+        ("_max_queue_size", c_uint32),
+        ("_queue_unblock_size", c_uint32),
+        ("_zero_copy", c_bool),
+        ("_latency_target_us", c_uint32),
+    ]
 
 
 class CacheConfig(Structure):
@@ -38,6 +44,7 @@ class CacheConfig(Structure):
         ("_name", c_char_p),
         ("_cache_mode", c_uint32),
         ("_eviction_policy", c_uint32),
+        ("_promotion_policy", c_uint32),
         ("_cache_line_size", c_uint64),
         ("_metadata_layout", c_uint32),
         ("_metadata_volatile", c_bool),
@@ -45,6 +52,8 @@ class CacheConfig(Structure):
         ("_locked", c_bool),
         ("_pt_unaligned_io", c_bool),
         ("_use_submit_io_fast", c_bool),
+        ("_cleaner_instances", c_uint32),
+        ("_hash_load_factor", c_uint32),
     ]
 
 
@@ -57,6 +66,9 @@ class CacheDeviceConfig(Structure):
         ("_min_free_ram", c_uint64),
         ("_perform_test", c_bool),
         ("_discard_on_start", c_bool),
+        ("_discard_in_background", c_bool),
+        ("_max_size", c_uint64),
+        ("_volume_params", c_void_p),
     ]
 
 
@@ -71,9 +83,18 @@ class CacheMode(IntEnum):
 
 class EvictionPolicy(IntEnum):
     LRU = 0
+    CLOCK = 1
+    TWOQ = 2
+    LRU_COST = 3
     DEFAULT = LRU
 
 
+class PromotionPolicy(IntEnum):
+    ALWAYS = 0
+    NHIT = 1
+    DEFAULT = ALWAYS
+
+
 class CleaningPolicy(IntEnum):
     NOP = 0
     ALRU = 1
@@ -101,14 +122,18 @@ class Cache:
         name: str = "",
         cache_mode: CacheMode = CacheMode.DEFAULT,
         eviction_policy: EvictionPolicy = EvictionPolicy.DEFAULT,
+        promotion_policy: PromotionPolicy = PromotionPolicy.DEFAULT,
         cache_line_size: CacheLineSize = CacheLineSize.DEFAULT,
         metadata_layout: MetadataLayout = MetadataLayout.DEFAULT,
         metadata_volatile: bool = False,
         max_queue_size: int = DEFAULT_BACKFILL_QUEUE_SIZE,
         queue_unblock_size: int = DEFAULT_BACKFILL_UNBLOCK,
+        backfill_zero_copy: bool = False,
+        backfill_latency_target_us: int = 0,
         locked: bool = True,
         pt_unaligned_io: bool = DEFAULT_PT_UNALIGNED_IO,
         use_submit_fast: bool = DEFAULT_USE_SUBMIT_FAST,
+        hash_load_factor: int = 0,
     ):
 
         self.owner = owner
@@ -119,16 +144,20 @@ class Cache:
             _name=name.encode("ascii") if name else None,
             _cache_mode=cache_mode,
             _eviction_policy=eviction_policy,
+            _promotion_policy=promotion_policy,
             _cache_line_size=cache_line_size,
             _metadata_layout=metadata_layout,
             _metadata_volatile=metadata_volatile,
             _backfill=Backfill(
                 _max_queue_size=max_queue_size,
                 _queue_unblock_size=queue_unblock_size,
+                _zero_copy=backfill_zero_copy,
+                _latency_target_us=backfill_latency_target_us,
             ),
             _locked=locked,
             _pt_unaligned_io=pt_unaligned_io,
             _use_submit_fast=use_submit_fast,
+            _hash_load_factor=hash_load_factor,
         )
         self.cache_handle = c_void_p()
         self._as_parameter_ = self.cache_handle
@@ -158,7 +187,12 @@ class Cache:
             raise OcfError("Error setting management queue", status)
 
     def configure_device(
-        self, device, force=False, perform_test=False, cache_line_size=None
+        self,
+        device,
+        force=False,
+        perform_test=False,
+        cache_line_size=None,
+        max_size=None,
     ):
         self.device_name = device.uuid
         self.dev_cfg = CacheDeviceConfig(
@@ -177,12 +211,22 @@ class Cache:
             _min_free_ram=0,
             _perform_test=perform_test,
             _discard_on_start=False,
+            _discard_in_background=False,
+            _max_size=int(max_size) if max_size else 0,
+            _volume_params=None,
         )
 
     def attach_device(
-        self, device, force=False, perform_test=False, cache_line_size=None
+        self,
+        device,
+        force=False,
+        perform_test=False,
+        cache_line_size=None,
+        max_size=None,
     ):
-        self.configure_device(device, force, perform_test, cache_line_size)
+        self.configure_device(
+            device, force, perform_test, cache_line_size, max_size
+        )
 
         c = OcfCompletion(
             [("cache", c_void_p), ("priv", c_void_p), ("error", c_int)]
@@ -213,20 +257,26 @@ class Cache:
     def load_from_device(cls, device, name=""):
         c = cls(name=name, owner=device.owner)
         c.start_cache()
-        c.load_cache(device)
+        try:
+            c.load_cache(device)
+        finally:
+            c.owner.lib.ocf_mngt_cache_unlock(c)
         return c
 
     @classmethod
-    def start_on_device(cls, device, **kwargs):
+    def start_on_device(cls, device, max_size=None, **kwargs):
         c = cls(locked=True, owner=device.owner, **kwargs)
 
         c.start_cache()
         try:
-            c.attach_device(device, force=True)
+            c.attach_device(device, force=True, max_size=max_size)
         except:
+            c.owner.lib.ocf_mngt_cache_unlock(c)
             c.stop(flush=False)
             raise
 
+        c.owner.lib.ocf_mngt_cache_unlock(c)
+
         return c
 
     def _get_and_lock(self, read=True):
@@ -289,6 +339,29 @@ class Cache:
 
         self.put_and_write_unlock()
 
+    def resize(self, size):
+        self.get_and_write_lock()
+
+        status = self.owner.lib.ocf_mngt_cache_resize(
+            self.cache_handle, c_uint64(int(size))
+        )
+
+        self.put_and_write_unlock()
+        if status:
+            raise OcfError("Error resizing cache", status)
+
+    def run_cleaner(self):
+        cleaner = c_void_p(Cleaner.get_by_cache(self.cache_handle.value))
+
+        c = OcfCompletion([("cleaner", c_void_p), ("interval", c_uint32)])
+        self.owner.lib.ocf_cleaner_set_cmpl(cleaner, c)
+        self.owner.lib.ocf_cleaner_run(cleaner, self.get_default_queue())
+        c.wait()
+
+        # Wait for background work started by cleaner holding cache lock
+        self.get_and_write_lock()
+        self.put_and_write_unlock()
+
     def get_stats(self):
         cache_info = CacheInfo()
         usage = UsageStats()
@@ -5,17 +5,20 @@
 
 from ctypes import c_void_p, CFUNCTYPE, Structure, c_int
 from .shared import SharedOcfObject
+from ..ocf import OcfLib
 
 
 class CleanerOps(Structure):
     INIT = CFUNCTYPE(c_int, c_void_p)
     STOP = CFUNCTYPE(None, c_void_p)
+    KICK = CFUNCTYPE(None, c_void_p)
 
-    _fields_ = [("init", INIT), ("stop", STOP)]
+    _fields_ = [("init", INIT), ("stop", STOP), ("kick", KICK)]
 
 
 class Cleaner(SharedOcfObject):
     _instances_ = {}
+    _cache_cleaners_ = {}
     _fields_ = [("cleaner", c_void_p)]
 
     def __init__(self):
@@ -26,12 +29,27 @@ class Cleaner(SharedOcfObject):
     def get_ops(cls):
         return CleanerOps(init=cls._init, stop=cls._stop)
 
+    @classmethod
+    def get_by_cache(cls, cache_handle):
+        return cls._cache_cleaners_[cache_handle]
+
     @staticmethod
     @CleanerOps.INIT
     def _init(cleaner):
+        # Cleaner isn't run in background, tests run first instance of
+        # cache on demand
+        cache = OcfLib.getInstance().ocf_cleaner_get_cache(cleaner)
+        Cleaner._cache_cleaners_.setdefault(cache, cleaner)
         return 0
 
     @staticmethod
     @CleanerOps.STOP
     def _stop(cleaner):
-        pass
+        for cache, instance in list(Cleaner._cache_cleaners_.items()):
+            if instance == cleaner:
+                del Cleaner._cache_cleaners_[cache]
+
+
+lib = OcfLib.getInstance()
+lib.ocf_cleaner_get_cache.argtypes = [c_void_p]
+lib.ocf_cleaner_get_cache.restype = c_void_p
@@ -55,6 +55,8 @@ class OcfCtx:
         if result != 0:
             raise OcfError("Context initialization failed", result)
 
+        self.lib.ocf_mngt_core_pool_init(self.ctx_handle)
+
     def register_volume_type(self, volume_type):
         self.volume_types[self.volume_types_count] = volume_type.get_props()
         volume_type.type_id = self.volume_types_count
@@ -71,6 +73,7 @@ class OcfCtx:
         self.volume_types_count += 1
 
     def exit(self):
+        self.lib.ocf_mngt_core_pool_deinit(self.ctx_handle)
         self.lib.ocf_ctx_exit(self.ctx_handle)
 
 
@@ -5,6 +5,7 @@
 
 from ctypes import (
     c_void_p,
+    c_bool,
     c_uint32,
     CFUNCTYPE,
     c_uint64,
@@ -40,6 +41,7 @@ class DataOps(Structure):
     SEEK = CFUNCTYPE(c_uint32, c_void_p, c_uint32, c_uint32)
     COPY = CFUNCTYPE(c_uint64, c_void_p, c_void_p, c_uint64, c_uint64, c_uint64)
     SECURE_ERASE = CFUNCTYPE(None, c_void_p)
+    IS_ZERO = CFUNCTYPE(c_bool, c_void_p, c_uint64, c_uint64)
 
     _fields_ = [
         ("_alloc", ALLOC),
@@ -52,6 +54,7 @@ class DataOps(Structure):
         ("_seek", SEEK),
         ("_copy", COPY),
         ("_secure_erase", SECURE_ERASE),
+        ("_is_zero", IS_ZERO),
     ]
 
 
@@ -86,6 +89,7 @@ class Data(SharedOcfObject):
             _seek=cls._seek,
             _copy=cls._copy,
             _secure_erase=cls._secure_erase,
+            _is_zero=cls._is_zero,
         )
 
     @classmethod
@@ -172,14 +176,21 @@ class Data(SharedOcfObject):
     def _secure_erase(dst):
         Data.get_instance(dst).secure_erase()
 
+    @staticmethod
+    @DataOps.IS_ZERO
+    def _is_zero(src, start, size):
+        return Data.get_instance(src).is_zero(start, size)
+
     def read(self, dst, size):
         to_read = min(self.size - self.position, size)
         memmove(dst, self.data + self.position, to_read)
+        self.position += to_read
         return to_read
 
     def write(self, src, size):
         to_write = min(self.size - self.position, size)
         memmove(self.data + self.position, src, to_write)
+        self.position += to_write
         return to_write
 
     def mlock(self):
@@ -191,6 +202,7 @@ class Data(SharedOcfObject):
     def zero(self, size):
         to_zero = min(self.size - self.position, size)
         memset(self.data + self.position, 0, to_zero)
+        self.position += to_zero
         return to_zero
 
     def seek(self, seek, size):
@@ -204,11 +216,15 @@ class Data(SharedOcfObject):
         return to_move
 
     def copy(self, src, end, start, size):
+        memmove(self.data + end, src.data + start, size)
         return size
 
     def secure_erase(self):
         pass
 
+    def is_zero(self, start, size):
+        return not any(string_at(self.data + start, size))
+
     def dump(self):
         print_buffer(self.buffer, self.size)
 
@@ -0,0 +1,127 @@
+#
+# Copyright(c) 2019 Intel Corporation
+# SPDX-License-Identifier: BSD-3-Clause-Clear
+#
+
+from ctypes import c_void_p, c_int, c_uint32, c_uint64, Structure, POINTER, byref
+
+from ..ocf import OcfLib
+from .data import Data
+from .shared import OcfError
+
+
+class IoGenConfig(Structure):
+    _fields_ = [
+        ("offset", c_uint64),
+        ("size", c_uint64),
+        ("count", c_uint64),
+        ("seed", c_uint64),
+        ("block_size", c_uint32),
+        ("queue_depth", c_uint32),
+        ("write_pct", c_uint32),
+        ("random", c_uint32),
+        ("io_class", c_uint32),
+        ("flags", c_uint32),
+    ]
+
+
+class IoGenStats(Structure):
+    _fields_ = [
+        ("ios", c_uint64),
+        ("reads", c_uint64),
+        ("writes", c_uint64),
+        ("bytes", c_uint64),
+        ("errors", c_uint64),
+        ("elapsed_ns", c_uint64),
+        ("lat_min_ns", c_uint64),
+        ("lat_avg_ns", c_uint64),
+        ("lat_max_ns", c_uint64),
+        ("lat_p50_ns", c_uint64),
+        ("lat_p99_ns", c_uint64),
+        ("lat_p999_ns", c_uint64),
+    ]
+
+
+class IoGenerator:
+    """
+    Runs I/O workload on core from C, so that submission and completion of
+    each I/O doesn't go through Python. Only volume and data operations of
+    pyocf are called back into Python.
+    """
+
+    def __init__(
+        self,
+        core,
+        *,
+        size: int,
+        block_size: int = 4096,
+        queue_depth: int = 1,
+        write_pct: int = 0,
+        random: bool = False,
+        offset: int = 0,
+        seed: int = 0,
+        io_class: int = 0,
+        flags: int = 0,
+    ):
+        self.core = core
+        self.cfg = IoGenConfig(
+            offset=offset,
+            size=size,
+            seed=seed,
+            block_size=block_size,
+            queue_depth=queue_depth,
+            write_pct=write_pct,
+            random=int(random),
+            io_class=io_class,
+            flags=flags,
+        )
+        self.data = [Data(block_size) for _ in range(queue_depth)]
+        self.buffers = (c_void_p * queue_depth)(*[d.data for d in self.data])
+
+    def run(self, count: int, queue=None):
+        if queue is None:
+            queue = self.core.cache.get_default_queue()
+
+        self.cfg.count = count
+        stats = IoGenStats()
+
+        status = OcfLib.getInstance().pyocf_iogen_run(
+            self.core.handle,
+            queue.handle,
+            byref(self.cfg),
+            self.buffers,
+            byref(stats),
+        )
+        if status:
+            raise OcfError("I/O generator failed", status)
+
+        elapsed = stats.elapsed_ns / 1e9 if stats.elapsed_ns else 0
+        return {
+            "ios": stats.ios,
+            "reads": stats.reads,
+            "writes": stats.writes,
+            "bytes": stats.bytes,
+            "errors": stats.errors,
+            "elapsed_ns": stats.elapsed_ns,
+            "iops": stats.ios / elapsed if elapsed else 0,
+            "bandwidth": stats.bytes / elapsed if elapsed else 0,
+            "latency_ns": {
+                "min": stats.lat_min_ns,
+                "avg": stats.lat_avg_ns,
+                "max": stats.lat_max_ns,
+                "p50": stats.lat_p50_ns,
+                "p99": stats.lat_p99_ns,
+                "p99.9": stats.lat_p999_ns,
+            },
+        }
+
+
+lib = OcfLib.getInstance()
+lib.pyocf_iogen_run.argtypes = [
+    c_void_p,
+    c_void_p,
+    POINTER(IoGenConfig),
+    POINTER(c_void_p),
+    POINTER(IoGenStats),
+]
+lib.pyocf_iogen_run.restype = c_int
@@ -39,6 +39,7 @@ class OcfErrorCode(IntEnum):
     OCF_ERR_CORE_IN_INACTIVE_STATE = auto()
     OCF_ERR_INVALID_CACHE_MODE = auto()
     OCF_ERR_INVALID_CACHE_LINE_SIZE = auto()
+    OCF_ERR_CORE_SIZE_EXCEEDED = auto()
 
 
 class OcfCompletion:
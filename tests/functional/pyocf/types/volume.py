@@ -10,6 +10,7 @@ from ctypes import (
     c_char_p,
     create_string_buffer,
     memmove,
+    memset,
     Structure,
     CFUNCTYPE,
     c_int,
@@ -42,6 +43,9 @@ class VolumeOps(Structure):
     CLOSE = CFUNCTYPE(None, c_void_p)
     GET_MAX_IO_SIZE = CFUNCTYPE(c_uint, c_void_p)
     GET_LENGTH = CFUNCTYPE(c_uint64, c_void_p)
+    PLUG = CFUNCTYPE(None, c_void_p)
+    UNPLUG = CFUNCTYPE(None, c_void_p)
+    GET_DIRECT_MAPPING = CFUNCTYPE(c_void_p, c_void_p)
 
     _fields_ = [
         ("_submit_io", SUBMIT_IO),
@@ -53,6 +57,9 @@ class VolumeOps(Structure):
         ("_close", CLOSE),
         ("_get_max_io_size", GET_MAX_IO_SIZE),
         ("_get_length", GET_LENGTH),
+        ("_plug", PLUG),
+        ("_unplug", UNPLUG),
+        ("_get_direct_mapping", GET_DIRECT_MAPPING),
     ]
 
 
@@ -68,7 +75,7 @@ class VolumeProperties(Structure):
 
 
 class VolumeIoPriv(Structure):
-    _fields_ = [("_data", c_void_p)]
+    _fields_ = [("_data", c_void_p), ("_offset", c_uint64)]
 
 
 class Volume(Structure):
@@ -156,7 +163,10 @@ class Volume(Structure):
     @staticmethod
     @VolumeOps.SUBMIT_WRITE_ZEROES
     def _submit_write_zeroes(write_zeroes):
-        pass
+        io_structure = cast(write_zeroes, POINTER(Io))
+        volume = Volume.get_instance(io_structure.contents._volume)
+
+        volume.submit_write_zeroes(io_structure)
 
     @staticmethod
     @CFUNCTYPE(c_int, c_void_p)
@@ -199,7 +209,7 @@ class Volume(Structure):
             OcfLib.getInstance().ocf_io_get_priv(io), POINTER(VolumeIoPriv)
         )
         data = Data.get_instance(data)
-        data.position = offset
+        io_priv.contents._offset = offset
         io_priv.contents._data = data.data
         return 0
 
@@ -233,6 +243,14 @@ class Volume(Structure):
     def submit_discard(self, discard):
         discard.contents._end(discard, 0)
 
+    def submit_write_zeroes(self, write_zeroes):
+        memset(
+            self._storage + write_zeroes.contents._addr,
+            0,
+            write_zeroes.contents._bytes,
+        )
+        write_zeroes.contents._end(write_zeroes, 0)
+
     def get_stats(self):
         return self.stats
 
@@ -242,13 +260,19 @@ class Volume(Structure):
     def submit_io(self, io):
         try:
             self.stats[IoDir(io.contents._dir)] += 1
+
+            io_priv = cast(
+                OcfLib.getInstance().ocf_io_get_priv(io), POINTER(VolumeIoPriv)
+            )
+            offset = io_priv.contents._offset
+
             if io.contents._dir == IoDir.WRITE:
                 src_ptr = cast(io.contents._ops.contents._get_data(io), c_void_p)
-                src = Data.get_instance(src_ptr.value)
+                src = src_ptr.value + offset
                 dst = self._storage + io.contents._addr
             elif io.contents._dir == IoDir.READ:
                 dst_ptr = cast(io.contents._ops.contents._get_data(io), c_void_p)
-                dst = Data.get_instance(dst_ptr.value)
+                dst = dst_ptr.value + offset
                 src = self._storage + io.contents._addr
 
             memmove(dst, src, io.contents._bytes)
@@ -0,0 +1,303 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * I/O generator for performance tests. Python configures the workload and
+ * calls pyocf_iogen_run(), which keeps queue depth of I/Os in flight to
+ * OCF core until requested number of I/Os is done, without going back to
+ * Python for submission or completion of each I/O.
+ */
+
+#include "ocf/ocf.h"
+#include "ocf_env.h"
+
+/* Log-linear latency histogram, 16 sub-buckets per power of two */
+#define IOGEN_HIST_SUB_BITS	4
+#define IOGEN_HIST_SUB		(1 << IOGEN_HIST_SUB_BITS)
+#define IOGEN_HIST_BUCKETS	(64 * IOGEN_HIST_SUB)
+
+struct pyocf_iogen_config {
+	uint64_t offset;
+	/*!< Start of address range of I/Os in bytes */
+	uint64_t size;
+	/*!< Length of address range of I/Os in bytes */
+	uint64_t count;
+	/*!< Number of I/Os to do */
+	uint64_t seed;
+	/*!< Seed of random addresses and directions */
+	uint32_t block_size;
+	/*!< Size of each I/O in bytes */
+	uint32_t queue_depth;
+	/*!< Number of I/Os kept in flight */
+	uint32_t write_pct;
+	/*!< Percentage of writes, rest are reads */
+	uint32_t random;
+	/*!< Random addresses if set, sequential otherwise */
+	uint32_t io_class;
+	uint32_t flags;
+};
+
+struct pyocf_iogen_stats {
+	uint64_t ios;
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t bytes;
+	uint64_t errors;
+	uint64_t elapsed_ns;
+	uint64_t lat_min_ns;
+	uint64_t lat_avg_ns;
+	uint64_t lat_max_ns;
+	uint64_t lat_p50_ns;
+	uint64_t lat_p99_ns;
+	uint64_t lat_p999_ns;
+};
+
+struct iogen;
+
+struct iogen_slot {
+	struct iogen *gen;
+	ctx_data_t *data;
+	uint64_t start;
+	uint32_t dir;
+};
+
+struct iogen {
+	const struct pyocf_iogen_config *cfg;
+	struct pyocf_iogen_stats *stats;
+	ocf_core_t core;
+	ocf_queue_t queue;
+	struct iogen_slot *slots;
+	struct iogen_slot **free;
+	uint32_t free_count;
+	uint64_t blocks;
+	uint64_t next_block;
+	uint64_t rng;
+	uint64_t lat_sum;
+	uint64_t *hist;
+	env_mutex lock;
+	pthread_cond_t cond;
+};
+
+static inline uint64_t iogen_rand(struct iogen *gen)
+{
+	/* xorshift64 */
+	gen->rng ^= gen->rng << 13;
+	gen->rng ^= gen->rng >> 7;
+	gen->rng ^= gen->rng << 17;
+
+	return gen->rng;
+}
+
+static uint32_t iogen_hist_bucket(uint64_t ns)
+{
+	uint32_t msb;
+
+	if (ns < IOGEN_HIST_SUB)
+		return ns;
+
+	msb = 63 - __builtin_clzll(ns);
+
+	return (msb - IOGEN_HIST_SUB_BITS + 1) * IOGEN_HIST_SUB +
+			((ns >> (msb - IOGEN_HIST_SUB_BITS)) &
+			(IOGEN_HIST_SUB - 1));
+}
+
+/* Upper bound of latencies accounted in histogram bucket */
+static uint64_t iogen_hist_value(uint32_t bucket)
+{
+	uint32_t exp = bucket / IOGEN_HIST_SUB;
+	uint64_t sub = bucket % IOGEN_HIST_SUB;
+
+	if (!exp)
+		return sub;
+
+	return ((IOGEN_HIST_SUB + sub + 1) << (exp - 1)) - 1;
+}
+
+static uint64_t iogen_percentile(struct iogen *gen, uint64_t permille)
+{
+	uint64_t target = (gen->stats->ios * permille + 999) / 1000;
+	uint64_t seen = 0;
+	uint32_t i;
+
+	for (i = 0; i < IOGEN_HIST_BUCKETS; i++) {
+		seen += gen->hist[i];
+		if (seen >= target && seen)
+			return MIN(iogen_hist_value(i), gen->stats->lat_max_ns);
+	}
+
+	return gen->stats->lat_max_ns;
+}
+
+static void iogen_complete(struct ocf_io *io, int error)
+{
+	struct iogen_slot *slot = io->priv1;
+	struct iogen *gen = slot->gen;
+	struct pyocf_iogen_stats *stats = gen->stats;
+	uint64_t lat = env_ticks_to_nsecs(env_get_tick_count() - slot->start);
+
+	ocf_io_put(io);
+
+	env_mutex_lock(&gen->lock);
+
+	stats->ios++;
+	if (slot->dir == OCF_WRITE)
+		stats->writes++;
+	else
+		stats->reads++;
+	if (error)
+		stats->errors++;
+	else
+		stats->bytes += gen->cfg->block_size;
+
+	gen->lat_sum += lat;
+	stats->lat_min_ns = MIN(stats->lat_min_ns, lat);
+	stats->lat_max_ns = MAX(stats->lat_max_ns, lat);
+	gen->hist[iogen_hist_bucket(lat)]++;
+
+	gen->free[gen->free_count++] = slot;
+	pthread_cond_signal(&gen->cond);
+
+	env_mutex_unlock(&gen->lock);
+}
+
+static int iogen_submit(struct iogen *gen, struct iogen_slot *slot)
+{
+	const struct pyocf_iogen_config *cfg = gen->cfg;
+	struct ocf_io *io;
+	uint64_t block;
+	int ret;
+
+	if (cfg->random) {
+		block = iogen_rand(gen) % gen->blocks;
+	} else {
+		block = gen->next_block;
+		gen->next_block = (gen->next_block + 1) % gen->blocks;
+	}
+
+	slot->dir = iogen_rand(gen) % 100 < cfg->write_pct ?
+			OCF_WRITE : OCF_READ;
+
+	io = ocf_core_new_io(gen->core);
+	if (!io)
+		return -OCF_ERR_NO_MEM;
+
+	ocf_io_configure(io, cfg->offset + block * cfg->block_size,
+			cfg->block_size, slot->dir, cfg->io_class, cfg->flags);
+
+	ret = ocf_io_set_data(io, slot->data, 0);
+	if (ret) {
+		ocf_io_put(io);
+		return ret;
+	}
+
+	ocf_io_set_queue(io, gen->queue);
+	ocf_io_set_cmpl(io, slot, NULL, iogen_complete);
+
+	slot->start = env_get_tick_count();
+	ocf_core_submit_io(io);
+
+	return 0;
+}
+
+/*
+ * Run I/O workload described by cfg on core. Each of cfg->queue_depth
+ * buffers in data has to hold at least cfg->block_size bytes. Returns when
+ * all I/Os are completed, with stats filled in.
+ */
+int pyocf_iogen_run(ocf_core_t core, ocf_queue_t queue,
+		const struct pyocf_iogen_config *cfg, ctx_data_t **data,
+		struct pyocf_iogen_stats *stats)
+{
+	struct iogen gen = { };
+	uint64_t submitted = 0, start;
+	uint32_t i;
+	int ret = 0;
+
+	if (!cfg->block_size || !cfg->queue_depth ||
+			cfg->size < cfg->block_size ||
+			cfg->write_pct > 100) {
+		return -OCF_ERR_INVAL;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	stats->lat_min_ns = ~0ULL;
+
+	gen.cfg = cfg;
+	gen.stats = stats;
+	gen.core = core;
+	gen.queue = queue;
+	gen.blocks = cfg->size / cfg->block_size;
+	gen.rng = cfg->seed ?: 0x9E3779B97F4A7C15ULL;
+
+	gen.slots = env_zalloc(sizeof(*gen.slots) * cfg->queue_depth,
+			ENV_MEM_NORMAL);
+	gen.free = env_zalloc(sizeof(*gen.free) * cfg->queue_depth,
+			ENV_MEM_NORMAL);
+	gen.hist = env_zalloc(sizeof(*gen.hist) * IOGEN_HIST_BUCKETS,
+			ENV_MEM_NORMAL);
+	if (!gen.slots || !gen.free || !gen.hist) {
+		ret = -OCF_ERR_NO_MEM;
+		goto out;
+	}
+
+	for (i = 0; i < cfg->queue_depth; i++) {
+		gen.slots[i].gen = &gen;
+		gen.slots[i].data = data[i];
+		gen.free[gen.free_count++] = &gen.slots[i];
+	}
+
+	env_mutex_init(&gen.lock);
+	pthread_cond_init(&gen.cond, NULL);
+
+	start = env_get_tick_count();
+
+	/*
+	 * I/Os are submitted only from this loop, so that I/O completed in
+	 * context of its submission doesn't recurse into next submission.
+	 */
+	env_mutex_lock(&gen.lock);
+	while (stats->ios < cfg->count) {
+		if (!gen.free_count || submitted == cfg->count) {
+			pthread_cond_wait(&gen.cond, &gen.lock.m);
+			continue;
+		}
+
+		env_mutex_unlock(&gen.lock);
+		ret = iogen_submit(&gen, gen.free[--gen.free_count]);
+		env_mutex_lock(&gen.lock);
+
+		if (ret) {
+			gen.free_count++;
+			/* Wait for I/Os in flight before bailing out */
+			while (gen.free_count != cfg->queue_depth)
+				pthread_cond_wait(&gen.cond, &gen.lock.m);
+			break;
+		}
+
+		submitted++;
+	}
+	env_mutex_unlock(&gen.lock);
+
+	stats->elapsed_ns = env_ticks_to_nsecs(env_get_tick_count() - start);
+
+	if (stats->ios) {
+		stats->lat_avg_ns = gen.lat_sum / stats->ios;
+		stats->lat_p50_ns = iogen_percentile(&gen, 500);
+		stats->lat_p99_ns = iogen_percentile(&gen, 990);
+		stats->lat_p999_ns = iogen_percentile(&gen, 999);
+	} else {
+		stats->lat_min_ns = 0;
+	}
+
+	pthread_cond_destroy(&gen.cond);
+
+out:
+	env_free(gen.hist);
+	env_free(gen.free);
+	env_free(gen.slots);
+
+	return ret;
+}
@@ -0,0 +1,132 @@
+#
+# Copyright(c) 2019 Intel Corporation
+# SPDX-License-Identifier: BSD-3-Clause-Clear
+#
+
+from ctypes import c_int, memmove, cast, c_void_p, string_at
+
+from pyocf.types.cache import Cache, CacheMode
+from pyocf.types.core import Core
+from pyocf.types.volume import Volume, ErrorDevice
+from pyocf.types.data import Data
+from pyocf.types.io import IoDir
+from pyocf.types.shared import OcfCompletion, CacheLineSize
+from pyocf.utils import Size as S
+
+LINE_SIZE = CacheLineSize.LINE_64KiB
+SECTOR_SIZE = 512
+
+# 4K writes into two cache lines, unaligned to each other
+DIRTY_RANGES = [
+    (S.from_KiB(8).B, S.from_KiB(4).B),
+    (S.from_KiB(40).B, S.from_KiB(4).B),
+    (S.from_KiB(64 + 60).B, S.from_KiB(4).B),
+]
+
+
+def pattern(seed, size):
+    return bytes((seed + i * 7) & 0xFF for i in range(size))
+
+
+def io_to_exp_obj(core, address, size, data, direction):
+    io = core.new_io()
+    io.set_data(data)
+    io.configure(address, size, direction, 0, 0)
+    io.set_queue(core.cache.get_default_queue())
+
+    cmpl = OcfCompletion([("err", c_int)])
+    io.callback = cmpl.callback
+    io.submit()
+    cmpl.wait()
+
+    return cmpl.results["err"]
+
+
+def write_dirty(core, expected):
+    for i, (address, size) in enumerate(DIRTY_RANGES):
+        buf = pattern(0x40 + i, size)
+        err = io_to_exp_obj(core, address, size, Data.from_bytes(buf), IoDir.WRITE)
+        assert err == 0
+
+        expected[address : address + size] = buf
+
+
+def read_lines(core, lines):
+    size = lines * LINE_SIZE
+    data = Data(size)
+    err = io_to_exp_obj(core, 0, size, data, IoDir.READ)
+
+    return err, string_at(data.data, size)
+
+
+def dirty_bytes(cache):
+    return int(cache.get_stats()["conf"]["dirty"])
+
+
+def prepare(cache_device, lines):
+    core_device = Volume(S.from_MiB(10))
+    core_data = pattern(0x11, lines * LINE_SIZE)
+    memmove(core_device.data, core_data, len(core_data))
+
+    cache = Cache.start_on_device(
+        cache_device, cache_mode=CacheMode.WB, cache_line_size=LINE_SIZE
+    )
+    core = Core.using_device(core_device)
+    cache.add_core(core)
+
+    return cache, core, core_device, bytearray(core_data)
+
+
+def test_read_merges_dirty_sectors(pyocf_ctx):
+    """
+    Read miss of cache lines with dirty sectors returns dirty data from cache
+    merged over data from core, without writing dirty data to core
+    """
+    lines = 2
+    cache, core, core_device, expected = prepare(Volume(S.from_MiB(100)), lines)
+    core_data = bytes(expected)
+
+    write_dirty(core, expected)
+    dirty = dirty_bytes(cache)
+
+    err, data = read_lines(core, lines)
+    assert err == 0
+    assert data == bytes(expected)
+
+    # Dirty data was not cleaned to core
+    assert string_at(core_device.data, len(core_data)) == core_data
+    assert dirty_bytes(cache) == dirty
+
+    # Lines are fully valid now, second read is a hit
+    err, data = read_lines(core, lines)
+    assert err == 0
+    assert data == bytes(expected)
+
+
+def test_read_merge_cache_error_keeps_dirty(pyocf_ctx):
+    """
+    Cache read error during merge fails the request, but doesn't purge dirty
+    sectors of merged lines
+    """
+    lines = 2
+    cache_device = ErrorDevice(S.from_MiB(100))
+    cache, core, core_device, expected = prepare(cache_device, lines)
+    core_data = bytes(expected)
+
+    write_dirty(core, expected)
+    dirty = dirty_bytes(cache)
+
+    cache_device.set_mapping(
+        set(range(0, int(cache_device.size), SECTOR_SIZE))
+    )
+    err, _ = read_lines(core, lines)
+    cache_device.set_mapping(set())
+
+    assert err != 0
+    assert cache_device.get_stats()["errors"][IoDir.READ] > 0
+    assert dirty_bytes(cache) == dirty
+
+    err, data = read_lines(core, lines)
+    assert err == 0
+    assert data == bytes(expected)
+    assert string_at(core_device.data, len(core_data)) == core_data
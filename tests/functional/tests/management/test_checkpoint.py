@@ -0,0 +1,132 @@
+#
+# Copyright(c) 2019 Intel Corporation
+# SPDX-License-Identifier: BSD-3-Clause-Clear
+#
+
+from ctypes import c_int, byref, memmove, string_at
+
+from pyocf.types.cache import Cache, CacheMode
+from pyocf.types.core import Core
+from pyocf.types.volume import Volume
+from pyocf.types.data import Data
+from pyocf.types.io import IoDir
+from pyocf.types.shared import OcfCompletion, CacheLineSize
+from pyocf.utils import Size as S
+
+LINE_SIZE = CacheLineSize.LINE_64KiB
+CACHED_SIZE = S.from_MiB(8)
+OCF_CORE_MAX = 4096
+
+
+def pattern(seed, size):
+    return bytes((seed + i * 7) & 0xFF for i in range(size))
+
+
+def io_to_exp_obj(core, address, size, data, direction):
+    io = core.new_io()
+    io.set_data(data)
+    io.configure(address, size, direction, 0, 0)
+    io.set_queue(core.cache.get_default_queue())
+
+    cmpl = OcfCompletion([("err", c_int)])
+    io.callback = cmpl.callback
+    io.submit()
+    cmpl.wait()
+
+    return cmpl.results["err"]
+
+
+def occupancy(cache):
+    return int(cache.get_stats()["conf"]["occupancy"])
+
+
+def read_hits(cache):
+    return cache.get_stats()["req"]["rd_hits"]["value"]
+
+
+def loaded_core(cache, core_device):
+    """
+    Get the only core of loaded cache, which was added back from metadata
+    """
+    core = Core.using_device(core_device)
+    core.cache = cache
+    for core_id in range(OCF_CORE_MAX):
+        status = cache.owner.lib.ocf_core_get(
+            cache.cache_handle, core_id, byref(core.handle)
+        )
+        if status == 0:
+            return core
+
+    assert False, "Core not loaded"
+
+
+def crash(cache, cache_device):
+    """
+    Copy cache device as left by power failure, before cache is stopped
+    """
+    crashed = Volume(cache_device.size)
+    memmove(crashed.data, cache_device.data, int(cache_device.size))
+    cache.stop(flush=False)
+
+    return crashed
+
+
+def prepare(pyocf_ctx):
+    cache_device = Volume(S.from_MiB(100))
+    core_device = Volume(S.from_MiB(100))
+
+    cache = Cache.start_on_device(
+        cache_device, cache_mode=CacheMode.WT, cache_line_size=LINE_SIZE
+    )
+    core = Core.using_device(core_device)
+    cache.add_core(core)
+
+    data = pattern(0x5A, int(CACHED_SIZE))
+    err = io_to_exp_obj(
+        core, 0, len(data), Data.from_bytes(data), IoDir.WRITE
+    )
+    assert err == 0
+    assert occupancy(cache) == CACHED_SIZE.B / LINE_SIZE
+
+    return cache, core, cache_device, core_device, data
+
+
+def test_recovery_restores_checkpoint(pyocf_ctx):
+    """
+    Clean cache lines of metadata checkpoint written while cache was idle
+    come back when cache is loaded after dirty shutdown
+    """
+    cache, core, cache_device, core_device, data = prepare(pyocf_ctx)
+
+    cache.run_cleaner()
+    cache = Cache.load_from_device(crash(cache, cache_device))
+
+    assert occupancy(cache) == CACHED_SIZE.B / LINE_SIZE
+
+    core = loaded_core(cache, core_device)
+    read = Data(len(data))
+    assert io_to_exp_obj(core, 0, len(data), read, IoDir.READ) == 0
+    assert string_at(read.data, len(data)) == data
+    assert read_hits(cache) == 1
+
+
+def test_recovery_drops_checkpoint_after_io(pyocf_ctx):
+    """
+    Checkpoint is invalidated by first I/O submitted after it was written,
+    as it might have changed data of cache lines, so that clean cache lines
+    are dropped by recovery
+    """
+    cache, core, cache_device, core_device, data = prepare(pyocf_ctx)
+
+    cache.run_cleaner()
+
+    update = pattern(0xA5, int(LINE_SIZE))
+    err = io_to_exp_obj(
+        core, 0, len(update), Data.from_bytes(update), IoDir.WRITE
+    )
+    assert err == 0
+
+    cache = Cache.load_from_device(crash(cache, cache_device))
+
+    assert occupancy(cache) == 0
+    assert string_at(core_device.data, len(update)) == update
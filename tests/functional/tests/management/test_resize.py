@@ -0,0 +1,83 @@
+#
+# Copyright(c) 2019 Intel Corporation
+# SPDX-License-Identifier: BSD-3-Clause-Clear
+#
+
+import pytest
+from ctypes import c_int
+
+from pyocf.types.cache import Cache
+from pyocf.types.core import Core
+from pyocf.types.volume import Volume
+from pyocf.types.data import Data
+from pyocf.types.io import IoDir
+from pyocf.types.shared import OcfError, OcfCompletion, CacheLineSize
+from pyocf.utils import Size as S
+
+LINE_SIZE = CacheLineSize.LINE_64KiB
+IO_SIZE = S.from_MiB(1)
+
+
+def write_core(core, size):
+    for address in range(0, int(size), int(IO_SIZE)):
+        io = core.new_io()
+        io.set_data(Data(IO_SIZE))
+        io.configure(address, int(IO_SIZE), IoDir.WRITE, 0, 0)
+        io.set_queue(core.cache.get_default_queue())
+
+        cmpl = OcfCompletion([("err", c_int)])
+        io.callback = cmpl.callback
+        io.submit()
+        cmpl.wait()
+
+        assert cmpl.results["err"] == 0
+
+
+def cache_lines(cache):
+    return int(cache.get_stats()["conf"]["size"])
+
+
+def occupancy(cache):
+    return int(cache.get_stats()["conf"]["occupancy"])
+
+
+def test_resize_grows_past_attached_device(pyocf_ctx):
+    """
+    Cache attached with max_size larger than cache device uses whole device
+    only, and grows into space added to cache device once resized
+    """
+    cache_device = Volume(S.from_MiB(240))
+    cache_device.size = S.from_MiB(120)
+    core_device = Volume(S.from_MiB(400))
+
+    cache = Cache.start_on_device(
+        cache_device, cache_line_size=LINE_SIZE, max_size=S.from_MiB(240)
+    )
+    core = Core.using_device(core_device)
+    cache.add_core(core)
+
+    attached = cache_lines(cache)
+    assert attached < S.from_MiB(120).B / LINE_SIZE
+
+    write_core(core, S.from_MiB(150))
+    assert occupancy(cache) <= attached
+
+    # Cache device hasn't grown yet
+    with pytest.raises(OcfError):
+        cache.resize(S.from_MiB(200))
+
+    cache_device.size = S.from_MiB(240)
+    cache.resize(S.from_MiB(200))
+    assert cache_lines(cache) == S.from_MiB(200).B / LINE_SIZE
+
+    write_core(core, S.from_MiB(150))
+    assert occupancy(cache) == S.from_MiB(150).B / LINE_SIZE
+
+    # Metadata is sized for max_size only
+    cache_device.size = S.from_MiB(480)
+    with pytest.raises(OcfError):
+        cache.resize(S.from_MiB(400))
+
+    cache.resize(S.from_MiB(100))
+    assert cache_lines(cache) == S.from_MiB(100).B / LINE_SIZE
+    assert occupancy(cache) <= cache_lines(cache)
@@ -0,0 +1,65 @@
+#
+# Copyright(c) 2019 Intel Corporation
+# SPDX-License-Identifier: BSD-3-Clause-Clear
+#
+
+import logging
+
+from pyocf.types.cache import Cache
+from pyocf.types.core import Core
+from pyocf.types.volume import Volume
+from pyocf.types.iogen import IoGenerator
+from pyocf.types.io import IoDir
+from pyocf.utils import Size as S
+
+logger = logging.getLogger(__name__)
+
+
+def log_stats(name, stats):
+    logger.info(
+        "{}: {} I/Os {:.0f} IOPS {:.1f} MiB/s latency avg {} p99 {} ns".format(
+            name,
+            stats["ios"],
+            stats["iops"],
+            stats["bandwidth"] / S.from_MiB(1).B,
+            stats["latency_ns"]["avg"],
+            stats["latency_ns"]["p99"],
+        )
+    )
+
+
+def test_iogen_write_read_back(pyocf_ctx):
+    cache_device = Volume(S.from_MiB(30))
+    core_device = Volume(S.from_MiB(30))
+
+    cache = Cache.start_on_device(cache_device)
+    core = Core.using_device(core_device)
+    cache.add_core(core)
+
+    size = S.from_MiB(1).B
+    count = size // S.from_KiB(4).B
+
+    writer = IoGenerator(core, size=size, queue_depth=8, write_pct=100)
+    stats = writer.run(count)
+    log_stats("sequential write", stats)
+
+    assert stats["ios"] == count
+    assert stats["writes"] == count
+    assert stats["errors"] == 0
+    assert stats["bytes"] == size
+    assert core_device.get_stats()[IoDir.WRITE] == count
+
+    reader = IoGenerator(core, size=size, queue_depth=8, random=True, seed=1)
+    stats = reader.run(count)
+    log_stats("random read", stats)
+
+    assert stats["ios"] == count
+    assert stats["reads"] == count
+    assert stats["errors"] == 0
+    assert 0 < stats["latency_ns"]["min"] <= stats["latency_ns"]["p50"]
+    assert stats["latency_ns"]["p50"] <= stats["latency_ns"]["p99"]
+    assert stats["latency_ns"]["p99"] <= stats["latency_ns"]["max"]
+
+    core_stats = core.get_stats()
+    assert core_stats["req"]["rd_hits"]["value"] == count
+    assert core_stats["req"]["rd_full_misses"]["value"] == 0
@@ -15,6 +15,7 @@
 //<tested_function>ocf_cleaner_run</tested_function>
 //<functions_to_leave>
 //ocf_cleaner_set_cmpl
+//ocf_cleaner_get_cache
 //</functions_to_leave>
 
 
@@ -40,8 +41,8 @@
  * in tested source file.
  */
 
-int __wrap_cleaning_nop_perform_cleaning(struct ocf_cache *cache,
-		                ocf_cleaner_end_t cmpl)
+void __wrap_cleaning_nop_perform_cleaning(struct ocf_cache *cache,
+		ocf_cleaner_t cleaner, ocf_cleaner_end_t cmpl)
 {
 }
 
@@ -63,8 +64,8 @@ int __wrap_cleaning_policy_acp_initialize(struct ocf_cache *cache,
 
 void __wrap_cleaning_policy_acp_deinitialize(struct ocf_cache *cache){}
 
-int __wrap_cleaning_policy_acp_perform_cleaning(struct ocf_cache *cache,
-		                ocf_cleaner_end_t cmpl){}
+void __wrap_cleaning_policy_acp_perform_cleaning(struct ocf_cache *cache,
+		ocf_cleaner_t cleaner, ocf_cleaner_end_t cmpl){}
 
 void __wrap_cleaning_policy_acp_init_cache_block(struct ocf_cache *cache,
 		                uint32_t cache_line){}
@@ -170,17 +171,11 @@ void __wrap_ocf_queue_get(ocf_queue_t queue)
 
 }
 
-int __wrap_cleaning_alru_perform_cleaning(struct ocf_cache *cache, ocf_cleaner_end_t cmpl)
+void __wrap_cleaning_alru_perform_cleaning(struct ocf_cache *cache,
+		ocf_cleaner_t cleaner, ocf_cleaner_end_t cmpl)
 {
 	function_called();
-	return mock();
-}
-
-
-ocf_cache_t __wrap_ocf_cleaner_get_cache(ocf_cleaner_t c)
-{
-	function_called();
-	return mock_ptr_type(struct ocf_cache*);
+	check_expected_ptr(cleaner);
 }
 
 bool __wrap_ocf_mngt_is_cache_locked(ocf_cache_t cache)
@@ -207,17 +202,62 @@ int __wrap_env_bit_test(int nr, const void *addr)
 	return mock();
 }
 
-int __wrap_env_rwsem_down_write_trylock(env_rwsem *s)
+int __wrap_env_rwsem_down_read_trylock(env_rwsem *s)
 {
 	function_called();
 	return mock();
 }
 
-void __wrap_env_rwsem_up_write(env_rwsem *s)
+void __wrap_env_rwsem_up_read(env_rwsem *s)
+{
+	function_called();
+}
+
+void __wrap_ocf_cleaner_throttle_update(ocf_cleaner_t cleaner)
+{
+	function_called();
+}
+
+void __wrap_ocf_stats_window_tick(ocf_cache_t cache)
+{
+	function_called();
+}
+
+void __wrap_ocf_cleaner_checkpoint(ocf_cache_t cache)
+{
+	function_called();
+}
+
+void __wrap_ocf_cleaner_drain_update(ocf_cache_t cache)
+{
+	function_called();
+}
+
+void __wrap_ocf_trim_kick(ocf_cache_t cache, ocf_queue_t queue)
 {
 	function_called();
 }
 
+void __wrap_ocf_mode_advisor_tick(ocf_cache_t cache)
+{
+	function_called();
+}
+
+void __wrap_ocf_log_ring_flush_all(ocf_cache_t cache)
+{
+	function_called();
+}
+
+size_t __wrap_cleaning_policy_alru_size_of(ocf_cache_t cache)
+{
+	return 0;
+}
+
+size_t __wrap_cleaning_policy_acp_size_of(ocf_cache_t cache)
+{
+	return 0;
+}
+
 static void cleaner_complete(ocf_cleaner_t cleaner, uint32_t interval)
 {
 	function_called();
@@ -230,39 +270,54 @@ static void cleaner_complete(ocf_cleaner_t cleaner, uint32_t interval)
 
 static void ocf_cleaner_run_test01(void **state)
 {
-	struct ocf_cache cache;
-	ocf_part_id_t part_id;
-	uint32_t io_queue;
-	int result;
+	struct ocf_cache cache = {};
+	ocf_cleaner_t cleaner = &cache.cleaner.instance[0];
 
 	//Initialize needed structures.
 	cache.conf_meta = test_malloc(sizeof(struct ocf_superblock_config));
 	cache.conf_meta->cleaning_policy_type = ocf_cleaning_alru;
+	cleaner->cache = &cache;
 
 	print_test_description("Parts are ready for cleaning - should perform cleaning"
 			" for each part");
 
-	expect_function_call(__wrap_ocf_cleaner_get_cache);
-	will_return(__wrap_ocf_cleaner_get_cache, &cache);
-
 	expect_function_call(__wrap_env_bit_test);
 	will_return(__wrap_env_bit_test, 1);
 
 	expect_function_call(__wrap_ocf_mngt_is_cache_locked);
 	will_return(__wrap_ocf_mngt_is_cache_locked, 0);
 
-	expect_function_call(__wrap_env_rwsem_down_write_trylock);
-	will_return(__wrap_env_rwsem_down_write_trylock, 0);
+	expect_function_call(__wrap_env_rwsem_down_read_trylock);
+	will_return(__wrap_env_rwsem_down_read_trylock, 0);
+
+	expect_function_call(__wrap_ocf_cleaner_checkpoint);
+
+	expect_function_call(__wrap_ocf_trim_kick);
+
+	expect_function_call(__wrap_ocf_cleaner_drain_update);
 
 	expect_function_call(__wrap__ocf_cleaner_run_check_dirty_inactive);
 	will_return(__wrap__ocf_cleaner_run_check_dirty_inactive, 0);
 
+	expect_function_call(__wrap_ocf_cleaner_throttle_update);
+
+	expect_function_call(__wrap_ocf_stats_window_tick);
+
+	expect_function_call(__wrap_ocf_mode_advisor_tick);
+
+	expect_function_call(__wrap_ocf_log_ring_flush_all);
+
+	expect_function_call(__wrap_env_rwsem_up_read);
+
 	expect_function_call(__wrap_cleaning_alru_perform_cleaning);
-	will_return(__wrap_cleaning_alru_perform_cleaning, 0);
+	expect_value(__wrap_cleaning_alru_perform_cleaning, cleaner, cleaner);
+
+	ocf_cleaner_set_cmpl(cleaner, cleaner_complete);
 
-	ocf_cleaner_set_cmpl(&cache.cleaner, cleaner_complete);
+	ocf_cleaner_run(cleaner, (ocf_queue_t)0xdeadbeef);
 
-	ocf_cleaner_run(&cache.cleaner, 0xdeadbeef);
+	assert_int_equal(env_atomic_read(&cleaner->running), 1);
+	assert_int_equal(env_atomic_read(&cache.cleaner.active), 1);
 
 	/* Release allocated memory if allocated with test_* functions */
 
@@ -0,0 +1,308 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+/*
+<tested_file_path>src/eviction/eviction.c</tested_file_path>
+<tested_function>ocf_eviction_walk_hot</tested_function>
+<functions_to_leave>
+</functions_to_leave>
+*/
+
+#undef static
+#undef inline
+/*
+ * This headers must be in test source file. It's important that cmocka.h is
+ * last.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "print_desc.h"
+
+/*
+ * Headers from tested target.
+ */
+#include "eviction.h"
+#include "ops.h"
+#include "../ocf_cache_priv.h"
+#include "../metadata/metadata.h"
+
+#define TEST_CACHE_LINES	64
+#define TEST_PART_ID		1
+#define TEST_VISITED_MAX	TEST_CACHE_LINES
+
+struct test_ctx {
+	struct ocf_cache cache;
+	struct ocf_cache_device device;
+	struct ocf_superblock_config conf_meta;
+	struct ocf_user_part_runtime runtime;
+	ocf_part_id_t part_id[TEST_CACHE_LINES];
+	ocf_cache_line_t next[TEST_CACHE_LINES];
+	ocf_cache_line_t visited[TEST_VISITED_MAX];
+	uint32_t visited_count;
+	uint32_t visit_limit;
+};
+
+static struct test_ctx *test_ctx;
+
+/*
+ * Mocked functions. Eviction policies are referenced by ops table only.
+ */
+
+void evp_lru_init_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+void evp_lru_rm_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+uint32_t evp_lru_req_clines(struct ocf_cache *cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no,
+		ocf_core_id_t core_id)
+{
+	return 0;
+}
+
+uint32_t evp_lru_cost_req_clines(struct ocf_cache *cache,
+		ocf_queue_t io_queue, ocf_part_id_t part_id, uint32_t cline_no,
+		ocf_core_id_t core_id)
+{
+	return 0;
+}
+
+void evp_lru_hot_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+void evp_lru_init_evp(struct ocf_cache *cache, ocf_part_id_t part_id)
+{
+}
+
+void evp_lru_dirty_cline(struct ocf_cache *cache, ocf_part_id_t part_id,
+		uint32_t cline)
+{
+}
+
+void evp_lru_clean_cline(struct ocf_cache *cache, ocf_part_id_t part_id,
+		uint32_t cline)
+{
+}
+
+void evp_lru_walk_hot(struct ocf_cache *cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv)
+{
+}
+
+void evp_clock_init_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+void evp_clock_rm_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+uint32_t evp_clock_req_clines(struct ocf_cache *cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no,
+		ocf_core_id_t core_id)
+{
+	return 0;
+}
+
+void evp_clock_hot_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+void evp_clock_init_evp(struct ocf_cache *cache, ocf_part_id_t part_id)
+{
+}
+
+void evp_2q_init_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+void evp_2q_rm_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+uint32_t evp_2q_req_clines(struct ocf_cache *cache, ocf_queue_t io_queue,
+		ocf_part_id_t part_id, uint32_t cline_no,
+		ocf_core_id_t core_id)
+{
+	return 0;
+}
+
+void evp_2q_hot_cline(struct ocf_cache *cache, ocf_cache_line_t cline)
+{
+}
+
+void evp_2q_init_evp(struct ocf_cache *cache, ocf_part_id_t part_id)
+{
+}
+
+void evp_2q_walk_hot(struct ocf_cache *cache, ocf_part_id_t part_id,
+		ocf_eviction_visit_t visit, void *priv)
+{
+}
+
+int ocf_eviction_reserve_refill(struct ocf_request *req)
+{
+	return 0;
+}
+
+ocf_part_id_t __wrap_ocf_metadata_get_partition_id(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	assert_true(line < TEST_CACHE_LINES);
+
+	return test_ctx->part_id[line];
+}
+
+ocf_cache_line_t __wrap_ocf_metadata_get_partition_next(
+		struct ocf_cache *cache, ocf_cache_line_t line)
+{
+	assert_true(line < TEST_CACHE_LINES);
+
+	return test_ctx->next[line];
+}
+
+static bool test_visit(ocf_cache_t cache, ocf_cache_line_t line, void *priv)
+{
+	struct test_ctx *ctx = priv;
+
+	assert_true(ctx->visited_count < TEST_VISITED_MAX);
+	ctx->visited[ctx->visited_count++] = line;
+
+	return ctx->visited_count < ctx->visit_limit;
+}
+
+static void test_init(struct test_ctx *ctx)
+{
+	ocf_cache_line_t line;
+
+	memset(ctx, 0, sizeof(*ctx));
+
+	ctx->device.collision_table_entries = TEST_CACHE_LINES;
+	ctx->cache.device = &ctx->device;
+	ctx->cache.conf_meta = &ctx->conf_meta;
+	ctx->cache.user_parts[TEST_PART_ID].runtime = &ctx->runtime;
+
+	/* CLOCK keeps no recency order, so partition is walked by eviction */
+	ctx->conf_meta.eviction_policy_type = ocf_eviction_clock;
+
+	for (line = 0; line < TEST_CACHE_LINES; line++) {
+		ctx->part_id[line] = PARTITION_INVALID;
+		ctx->next[line] = TEST_CACHE_LINES;
+	}
+
+	ctx->visit_limit = TEST_VISITED_MAX;
+
+	test_ctx = ctx;
+}
+
+/*
+ * Partition tracked by counters has its cache lines marked by partition id
+ * only, list head stays at collision_table_entries
+ */
+static void test_init_counted(struct test_ctx *ctx)
+{
+	ocf_cache_line_t line;
+
+	test_init(ctx);
+
+	for (line = 3; line < TEST_CACHE_LINES; line += 5) {
+		ctx->part_id[line] = TEST_PART_ID;
+		ctx->runtime.curr_size++;
+	}
+	ctx->part_id[4] = TEST_PART_ID + 1;
+
+	ctx->runtime.head = TEST_CACHE_LINES;
+}
+
+static void ocf_eviction_walk_hot_test01(void **state)
+{
+	struct test_ctx ctx;
+	uint32_t i;
+
+	print_test_description("CLOCK with partition counters visits cache "
+			"lines of partition by partition id");
+
+	test_init_counted(&ctx);
+
+	ocf_eviction_walk_hot(&ctx.cache, TEST_PART_ID, test_visit, &ctx);
+
+	assert_int_equal(ctx.visited_count, ctx.runtime.curr_size);
+	for (i = 0; i < ctx.visited_count; i++)
+		assert_int_equal(ctx.visited[i], 3 + 5 * i);
+}
+
+static void ocf_eviction_walk_hot_test02(void **state)
+{
+	struct test_ctx ctx;
+
+	print_test_description("CLOCK with partition counters stops walk "
+			"once visitor returns false");
+
+	test_init_counted(&ctx);
+	ctx.visit_limit = 2;
+
+	ocf_eviction_walk_hot(&ctx.cache, TEST_PART_ID, test_visit, &ctx);
+
+	assert_int_equal(ctx.visited_count, 2);
+	assert_int_equal(ctx.visited[0], 3);
+	assert_int_equal(ctx.visited[1], 8);
+}
+
+static void ocf_eviction_walk_hot_test03(void **state)
+{
+	struct test_ctx ctx;
+
+	print_test_description("CLOCK with empty partition counted visits "
+			"nothing");
+
+	test_init(&ctx);
+	ctx.part_id[7] = TEST_PART_ID + 1;
+	ctx.runtime.head = TEST_CACHE_LINES;
+
+	ocf_eviction_walk_hot(&ctx.cache, TEST_PART_ID, test_visit, &ctx);
+
+	assert_int_equal(ctx.visited_count, 0);
+}
+
+static void ocf_eviction_walk_hot_test04(void **state)
+{
+	struct test_ctx ctx;
+
+	print_test_description("CLOCK with partition list visits cache lines "
+			"in list order");
+
+	test_init(&ctx);
+	ctx.runtime.head = 9;
+	ctx.next[9] = 2;
+	ctx.next[2] = 30;
+	ctx.part_id[9] = ctx.part_id[2] = ctx.part_id[30] = TEST_PART_ID;
+	ctx.runtime.curr_size = 3;
+
+	ocf_eviction_walk_hot(&ctx.cache, TEST_PART_ID, test_visit, &ctx);
+
+	assert_int_equal(ctx.visited_count, 3);
+	assert_int_equal(ctx.visited[0], 9);
+	assert_int_equal(ctx.visited[1], 2);
+	assert_int_equal(ctx.visited[2], 30);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(ocf_eviction_walk_hot_test01),
+		cmocka_unit_test(ocf_eviction_walk_hot_test02),
+		cmocka_unit_test(ocf_eviction_walk_hot_test03),
+		cmocka_unit_test(ocf_eviction_walk_hot_test04),
+	};
+
+	print_message("Unit test of ocf_eviction_walk_hot\n");
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
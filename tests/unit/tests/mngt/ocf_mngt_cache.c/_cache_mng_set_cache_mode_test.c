@@ -99,6 +99,11 @@ int __wrap_ocf_mngt_cache_reset_fallback_pt_error_counter(ocf_cache_t cache)
 	return mock();
 }
 
+void __wrap_ocf_cleaner_drain_stop(ocf_cache_t cache)
+{
+	function_called();
+}
+
 char *__wrap_ocf_cache_get_name(ocf_cache_t cache)
 {
 }
@@ -163,6 +168,11 @@ void __wrap__ocf_mngt_attach_clean_pol(
 {
 }
 
+void __wrap__ocf_mngt_attach_capacity(
+		  ocf_pipeline_t pipeline, void *priv, ocf_pipeline_arg_t arg)
+{
+}
+
 void __wrap__ocf_mngt_attach_flush_metadata(
 		  ocf_pipeline_t pipeline, void *priv, ocf_pipeline_arg_t arg)
 {
@@ -233,6 +243,14 @@ void __wrap__ocf_mngt_test_volume_first_read(
 {
 }
 
+int __wrap__ocf_mngt_init_instance_open_core_job(struct ocf_request *req)
+{
+}
+
+int __wrap__ocf_mngt_bg_discard_step(struct ocf_request *req)
+{
+}
+
 void __wrap__ocf_mngt_test_volume_finish(
 		  ocf_pipeline_t pipeline, void *priv, int error)
 {
@@ -336,6 +354,9 @@ static void _cache_mng_set_cache_mode_test03(void **state)
 	print_test_description("Old cache mode is write back. "
 		       "Setting new cache mode is succesfull");
 
+	/* Drain is stopped only when switching to write-back, so
+	 * __wrap_ocf_cleaner_drain_stop must not be called here */
+
 	expect_function_call(__wrap_ocf_cache_mode_is_valid);
 	will_return(__wrap_ocf_cache_mode_is_valid, 1);
 
@@ -376,9 +397,44 @@ static void _cache_mng_set_cache_mode_test04(void **state)
 
 	print_test_description("Mode changed successfully");
 
+	/* Drain is stopped only when switching to write-back, so
+	 * __wrap_ocf_cleaner_drain_stop must not be called here */
+
+	expect_function_call(__wrap_ocf_cache_mode_is_valid);
+	will_return(__wrap_ocf_cache_mode_is_valid, 1);
+
+	expect_function_call(__wrap_ocf_log_raw);
+	will_return(__wrap_ocf_log_raw, 0);
+
+	result = _cache_mng_set_cache_mode(&cache, mode_new);
+
+	assert_int_equal(result, 0);
+	assert_int_equal(cache.conf_meta->cache_mode, mode_new);
+}
+
+static void _cache_mng_set_cache_mode_test05(void **state)
+{
+	ocf_cache_mode_t mode_old = ocf_cache_mode_wt;
+	ocf_cache_mode_t mode_new = ocf_cache_mode_wb;
+	struct ocf_ctx ctx = {
+		.logger = 0x1, /* Just not NULL, we don't care. */
+	};
+	struct ocf_superblock_config sb_config = {
+		.cache_mode = mode_old,
+	};
+	struct ocf_cache cache = {
+		.owner = &ctx,
+		.conf_meta = &sb_config,
+	};
+	int result;
+
+	print_test_description("Switching to write back stops drain of dirty data");
+
 	expect_function_call(__wrap_ocf_cache_mode_is_valid);
 	will_return(__wrap_ocf_cache_mode_is_valid, 1);
 
+	expect_function_call(__wrap_ocf_cleaner_drain_stop);
+
 	expect_function_call(__wrap_ocf_log_raw);
 	will_return(__wrap_ocf_log_raw, 0);
 
@@ -398,6 +454,7 @@ int main(void)
 		cmocka_unit_test(_cache_mng_set_cache_mode_test02),
 		cmocka_unit_test(_cache_mng_set_cache_mode_test03),
 		cmocka_unit_test(_cache_mng_set_cache_mode_test04),
+		cmocka_unit_test(_cache_mng_set_cache_mode_test05),
 	};
 
 	print_message("Unit test of _cache_mng_set_cache_mode\n");
@@ -120,6 +120,11 @@ void __wrap__ocf_mngt_attach_clean_pol(
 {
 }
 
+void __wrap__ocf_mngt_attach_capacity(
+		  ocf_pipeline_t pipeline, void *priv, ocf_pipeline_arg_t arg)
+{
+}
+
 void __wrap__ocf_mngt_attach_flush_metadata(
 		  ocf_pipeline_t pipeline, void *priv, ocf_pipeline_arg_t arg)
 {
@@ -190,6 +195,14 @@ void __wrap__ocf_mngt_test_volume_first_read(
 {
 }
 
+int __wrap__ocf_mngt_init_instance_open_core_job(struct ocf_request *req)
+{
+}
+
+int __wrap__ocf_mngt_bg_discard_step(struct ocf_request *req)
+{
+}
+
 void __wrap__ocf_mngt_test_volume_finish(
 		  ocf_pipeline_t pipeline, void *priv, int error)
 {
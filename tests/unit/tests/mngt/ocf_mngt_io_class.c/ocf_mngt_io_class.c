@@ -113,6 +113,11 @@ void __wrap_ocf_part_sort(struct ocf_cache *cache)
 	function_called();
 }
 
+void __wrap_ocf_part_class_map_publish(struct ocf_cache *cache)
+{
+	function_called();
+}
+
 int __wrap_ocf_metadata_flush_superblock(struct ocf_cache *cache)
 {
 }
@@ -166,6 +171,7 @@ static void ocf_mngt_io_classes_configure_test03(void **state)
 	}
 
 	expect_function_call(__wrap_ocf_part_sort);
+	expect_function_call(__wrap_ocf_part_class_map_publish);
 
 	result = ocf_mngt_cache_io_classes_configure(&cache, &cfg);
 
@@ -225,6 +231,7 @@ static void ocf_mngt_io_classes_configure_test02(void **state)
 	}
 
 	expect_function_call(__wrap_ocf_part_sort);
+	expect_function_call(__wrap_ocf_part_class_map_publish);
 
 	result = ocf_mngt_cache_io_classes_configure(&cache, &cfg);
 
@@ -33,6 +33,24 @@ void env_free(const void *ptr)
 	return free((void *) ptr);
 }
 
+void *env_vzalloc_huge(size_t size)
+{
+	return NULL;
+}
+
+void env_vfree_huge(void *ptr, size_t size)
+{
+}
+
+void *env_zalloc_node(size_t size, int flags, int node)
+{
+	return calloc(1, size);
+}
+
+void env_numa_interleave(void *ptr, size_t size)
+{
+}
+
 void *env_vmalloc(size_t size)
 {
 	return malloc(size);
@@ -396,6 +414,11 @@ void env_atomic64_dec(env_atomic64 *a)
 	--*a;
 }
 
+long env_atomic64_inc_return(env_atomic64 *a)
+{
+	return ++*a;
+}
+
 long env_atomic64_cmpxchg(env_atomic64 *a, long old, long new)
 {
 	long oldval = *a;
@@ -464,6 +487,20 @@ void env_rwlock_write_unlock(env_rwlock *l)
 	check_expected_ptr(l);
 }
 
+int env_rwlock_read_trylock(env_rwlock *l)
+{
+	function_called();
+	check_expected_ptr(l);
+	return mock();
+}
+
+int env_rwlock_write_trylock(env_rwlock *l)
+{
+	function_called();
+	check_expected_ptr(l);
+	return mock();
+}
+
 void env_waitqueue_init(env_waitqueue *w)
 {
 	w->completed = false;
@@ -515,6 +552,11 @@ void env_schedule(void)
 	function_called();
 }
 
+void env_cpu_relax(void)
+{
+	function_called();
+}
+
 int env_in_interrupt(void)
 {
 	function_called();
@@ -106,6 +106,14 @@ void *env_vzalloc(size_t size);
 
 void env_vfree(const void *ptr);
 
+void *env_vzalloc_huge(size_t size);
+
+void env_vfree_huge(void *ptr, size_t size);
+
+void *env_zalloc_node(size_t size, int flags, int node);
+
+void env_numa_interleave(void *ptr, size_t size);
+
 uint64_t env_get_free_memory(void);
 
 /* *** ALLOCATOR *** */
@@ -225,6 +233,8 @@ void env_atomic64_inc(env_atomic64 *a);
 
 void env_atomic64_dec(env_atomic64 *a);
 
+long env_atomic64_inc_return(env_atomic64 *a);
+
 long env_atomic64_cmpxchg(env_atomic64 *a, long old, long new);
 
 typedef int Coroutine;
@@ -278,6 +288,10 @@ void env_rwlock_write_lock(env_rwlock *l);
 
 void env_rwlock_write_unlock(env_rwlock *l);
 
+int env_rwlock_read_trylock(env_rwlock *l);
+
+int env_rwlock_write_trylock(env_rwlock *l);
+
 /* *** WAITQUEUE *** */
 
 typedef struct {
@@ -312,10 +326,14 @@ bool env_bit_test(int nr, const volatile unsigned long *addr);
 
 /* *** SCHEDULING *** */
 
+#define env_cond_resched()      ({})
+
 void env_touch_softlockup_wd(void);
 
 void env_schedule(void);
 
+void env_cpu_relax(void);
+
 int env_in_interrupt(void);
 
 uint64_t env_get_tick_count(void);
@@ -0,0 +1,257 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+/*
+<tested_file_path>src/promotion/nhit.c</tested_file_path>
+<tested_function>nhit_req_should_promote</tested_function>
+<functions_to_leave>
+nhit_policy
+nhit_hash
+nhit_record_miss
+nhit_setup
+</functions_to_leave>
+*/
+
+#undef static
+#undef inline
+/*
+ * This headers must be in test source file. It's important that cmocka.h is
+ * last.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "print_desc.h"
+
+/*
+ * Headers from tested target.
+ */
+#include "nhit.h"
+#include "../ocf_cache_priv.h"
+#include "../ocf_request.h"
+#include "../engine/cache_engine.h"
+
+#define TEST_TABLE_ENTRIES	1024
+#define TEST_CACHE_LINES	(2 * TEST_TABLE_ENTRIES)
+
+uint64_t nhit_hash(ocf_core_id_t core_id, uint64_t core_line);
+
+struct test_ctx {
+	struct ocf_cache cache;
+	struct ocf_cache_device device;
+	struct ocf_part freelist;
+	struct ocf_map_info map;
+	struct ocf_request req;
+};
+
+static struct nhit_promotion_policy *test_nhit(struct test_ctx *ctx)
+{
+	return &ctx->cache.promotion.policy.nhit;
+}
+
+static void test_init(struct test_ctx *ctx, uint32_t free_lines)
+{
+	struct nhit_promotion_policy *nhit;
+
+	memset(ctx, 0, sizeof(*ctx));
+
+	ctx->device.collision_table_entries = TEST_CACHE_LINES;
+	ctx->device.freelist_part = &ctx->freelist;
+	ctx->freelist.curr_size = free_lines;
+	ctx->cache.device = &ctx->device;
+
+	nhit_setup(&ctx->cache);
+
+	nhit = test_nhit(ctx);
+	nhit->table = test_calloc(TEST_TABLE_ENTRIES, sizeof(*nhit->table));
+	nhit->table_entries = TEST_TABLE_ENTRIES;
+	nhit->trigger_threshold = 0;
+
+	ctx->req.map = &ctx->map;
+	ctx->req.core_line_count = 1;
+}
+
+static void test_deinit(struct test_ctx *ctx)
+{
+	test_free(test_nhit(ctx)->table);
+}
+
+static bool test_miss(struct test_ctx *ctx, ocf_core_id_t core_id,
+		uint64_t core_line)
+{
+	ctx->req.core_id = core_id;
+	ctx->req.core_line_first = core_line;
+	ctx->map.status = LOOKUP_MISS;
+
+	return nhit_req_should_promote(&ctx->cache, &ctx->req);
+}
+
+static uint32_t test_slot(ocf_core_id_t core_id, uint64_t core_line)
+{
+	return nhit_hash(core_id, core_line) & (TEST_TABLE_ENTRIES - 1);
+}
+
+static void nhit_req_should_promote_test01(void **state)
+{
+	struct test_ctx ctx;
+	uint32_t threshold = OCF_NHIT_DEFAULT_INSERTION_THRESHOLD;
+	uint32_t i;
+
+	print_test_description("Core line is promoted on insertion_threshold-th "
+			"miss");
+
+	test_init(&ctx, 0);
+
+	for (i = 1; i < threshold; i++)
+		assert_false(test_miss(&ctx, 0, 100));
+
+	assert_true(test_miss(&ctx, 0, 100));
+	assert_true(test_miss(&ctx, 0, 100));
+
+	/* Other core line and the same line of other core count separately */
+	assert_false(test_miss(&ctx, 0, 101));
+	assert_false(test_miss(&ctx, 1, 100));
+
+	test_deinit(&ctx);
+}
+
+static void nhit_req_should_promote_test02(void **state)
+{
+	struct test_ctx ctx;
+
+	print_test_description("Everything is promoted and no miss is recorded "
+			"while occupancy is below trigger_threshold");
+
+	/* 3/4 of cache is occupied */
+	test_init(&ctx, TEST_CACHE_LINES / 4);
+	test_nhit(&ctx)->trigger_threshold = 80;
+
+	assert_true(test_miss(&ctx, 0, 100));
+	assert_int_equal(env_atomic64_read(&test_nhit(&ctx)->misses), 0);
+
+	/* 80% occupancy reached, line has to wait for threshold */
+	ctx.freelist.curr_size = TEST_CACHE_LINES / 5;
+
+	assert_false(test_miss(&ctx, 0, 100));
+	assert_int_equal(env_atomic64_read(&test_nhit(&ctx)->misses), 1);
+
+	test_deinit(&ctx);
+}
+
+static void nhit_req_should_promote_test03(void **state)
+{
+	struct test_ctx ctx;
+
+	print_test_description("Hits are promoted and not recorded as misses");
+
+	test_init(&ctx, 0);
+
+	ctx.req.core_line_first = 100;
+	ctx.map.status = LOOKUP_HIT;
+
+	assert_true(nhit_req_should_promote(&ctx.cache, &ctx.req));
+	assert_int_equal(env_atomic64_read(&test_nhit(&ctx)->misses), 0);
+
+	test_deinit(&ctx);
+}
+
+static void nhit_req_should_promote_test04(void **state)
+{
+	struct test_ctx ctx;
+	struct nhit_promotion_policy *nhit;
+
+	print_test_description("Misses count within current and previous window, "
+			"older ones are expired");
+
+	test_init(&ctx, 0);
+	nhit = test_nhit(&ctx);
+
+	assert_false(test_miss(&ctx, 0, 100));
+	assert_false(test_miss(&ctx, 0, 100));
+
+	/* Next window, misses from previous one still count */
+	env_atomic64_add(TEST_TABLE_ENTRIES, &nhit->misses);
+	assert_true(test_miss(&ctx, 0, 100));
+
+	/* Two windows later counter starts over */
+	env_atomic64_add(2 * TEST_TABLE_ENTRIES, &nhit->misses);
+	assert_false(test_miss(&ctx, 0, 100));
+	assert_false(test_miss(&ctx, 0, 100));
+	assert_true(test_miss(&ctx, 0, 100));
+
+	test_deinit(&ctx);
+}
+
+static void nhit_req_should_promote_test05(void **state)
+{
+	struct test_ctx ctx;
+	uint64_t other;
+
+	print_test_description("Colliding core line resets bucket counter");
+
+	test_init(&ctx, 0);
+
+	for (other = 101; test_slot(0, other) != test_slot(0, 100); other++)
+		;
+
+	assert_false(test_miss(&ctx, 0, 100));
+	assert_false(test_miss(&ctx, 0, 100));
+
+	assert_false(test_miss(&ctx, 0, other));
+
+	assert_false(test_miss(&ctx, 0, 100));
+	assert_false(test_miss(&ctx, 0, 100));
+	assert_true(test_miss(&ctx, 0, 100));
+
+	test_deinit(&ctx);
+}
+
+static void nhit_req_should_promote_test06(void **state)
+{
+	struct test_ctx ctx;
+	struct ocf_map_info map[2] = { };
+	uint32_t i;
+
+	print_test_description("Request is promoted only when all its missed "
+			"lines reached threshold, all of them are recorded");
+
+	test_init(&ctx, 0);
+
+	/* Second line got missed once before */
+	assert_false(test_miss(&ctx, 0, 101));
+
+	ctx.req.map = map;
+	ctx.req.core_line_count = 2;
+	ctx.req.core_line_first = 100;
+
+	for (i = 1; i < OCF_NHIT_DEFAULT_INSERTION_THRESHOLD; i++) {
+		map[0].status = map[1].status = LOOKUP_MISS;
+		assert_false(nhit_req_should_promote(&ctx.cache, &ctx.req));
+	}
+
+	map[0].status = map[1].status = LOOKUP_MISS;
+	assert_true(nhit_req_should_promote(&ctx.cache, &ctx.req));
+
+	assert_int_equal(env_atomic64_read(&test_nhit(&ctx)->misses),
+			1 + 2 * OCF_NHIT_DEFAULT_INSERTION_THRESHOLD);
+
+	test_deinit(&ctx);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(nhit_req_should_promote_test01),
+		cmocka_unit_test(nhit_req_should_promote_test02),
+		cmocka_unit_test(nhit_req_should_promote_test03),
+		cmocka_unit_test(nhit_req_should_promote_test04),
+		cmocka_unit_test(nhit_req_should_promote_test05),
+		cmocka_unit_test(nhit_req_should_promote_test06),
+	};
+
+	print_message("Unit test of src/promotion/nhit.c\n");
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
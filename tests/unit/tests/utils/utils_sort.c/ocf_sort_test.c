@@ -0,0 +1,439 @@
+/*
+ * Copyright(c) 2019 Intel Corporation
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+/*
+<tested_file_path>src/utils/utils_sort.c</tested_file_path>
+<tested_function>ocf_sort</tested_function>
+<functions_to_leave>
+_ocf_sort_radix_pass
+_ocf_sort_radix
+</functions_to_leave>
+*/
+
+#undef static
+#undef inline
+/*
+ * This headers must be in test source file. It's important that cmocka.h is
+ * last.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "print_desc.h"
+
+/*
+ * Headers from tested target.
+ */
+#include "utils_sort.h"
+#include "../ocf_def_priv.h"
+
+/* Radix sort is used from this number of entries on */
+#define TEST_RADIX_MIN_ENTRIES	256
+
+void *__real_env_vmalloc(size_t size);
+
+void *__wrap_env_vmalloc(size_t size)
+{
+	function_called();
+
+	if (!mock())
+		return NULL;
+
+	return __real_env_vmalloc(size);
+}
+
+void __real_env_sort(void *base, size_t num, size_t size,
+		int (*cmp_fn)(const void *, const void *),
+		void (*swap_fn)(void *, void *, int size));
+
+void __wrap_env_sort(void *base, size_t num, size_t size,
+		int (*cmp_fn)(const void *, const void *),
+		void (*swap_fn)(void *, void *, int size))
+{
+	function_called();
+	__real_env_sort(base, num, size, cmp_fn, swap_fn);
+}
+
+/* Entry of flush table, seq is position before sort */
+struct test_flush_entry {
+	uint64_t core_line;
+	uint32_t core_id;
+	uint32_t seq;
+};
+
+static uint64_t test_flush_key(const void *entry, uint32_t key)
+{
+	const struct test_flush_entry *e = entry;
+
+	return key ? e->core_line : e->core_id;
+}
+
+static int test_flush_cmp(const void *a, const void *b)
+{
+	const struct test_flush_entry *_a = a, *_b = b;
+
+	if (_a->core_id != _b->core_id)
+		return _a->core_id > _b->core_id ? 1 : -1;
+	if (_a->core_line != _b->core_line)
+		return _a->core_line > _b->core_line ? 1 : -1;
+
+	return 0;
+}
+
+/* Reference order: by keys, equal entries keep their original order */
+static int test_flush_cmp_stable(const void *a, const void *b)
+{
+	const struct test_flush_entry *_a = a, *_b = b;
+	int result = test_flush_cmp(a, b);
+
+	if (result)
+		return result;
+
+	return _a->seq > _b->seq ? 1 : -1;
+}
+
+static uint32_t test_rand(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 8;
+}
+
+static struct test_flush_entry *test_flush_table(uint32_t num,
+		uint32_t cores, uint64_t lines, uint32_t seed)
+{
+	struct test_flush_entry *tbl = test_malloc(sizeof(*tbl) * num);
+	uint32_t i;
+
+	for (i = 0; i < num; i++) {
+		tbl[i].core_id = test_rand(&seed) % cores;
+		tbl[i].core_line = test_rand(&seed) % lines;
+		tbl[i].seq = i;
+	}
+
+	return tbl;
+}
+
+static struct test_flush_entry *test_flush_reference(
+		struct test_flush_entry *tbl, uint32_t num)
+{
+	struct test_flush_entry *ref = test_malloc(sizeof(*ref) * num);
+
+	memcpy(ref, tbl, sizeof(*ref) * num);
+	qsort(ref, num, sizeof(*ref), test_flush_cmp_stable);
+
+	return ref;
+}
+
+/* Sorted table is the reference one, including order of equal entries */
+static void test_flush_check_stable(struct test_flush_entry *tbl,
+		struct test_flush_entry *ref, uint32_t num)
+{
+	uint32_t i;
+
+	for (i = 0; i < num; i++) {
+		assert_int_equal(tbl[i].core_id, ref[i].core_id);
+		assert_int_equal(tbl[i].core_line, ref[i].core_line);
+		assert_int_equal(tbl[i].seq, ref[i].seq);
+	}
+}
+
+/* Keys are in reference order, equal entries may be reordered */
+static void test_flush_check_order(struct test_flush_entry *tbl,
+		struct test_flush_entry *ref, uint32_t num)
+{
+	uint32_t i;
+
+	for (i = 0; i < num; i++) {
+		assert_int_equal(tbl[i].core_id, ref[i].core_id);
+		assert_int_equal(tbl[i].core_line, ref[i].core_line);
+	}
+}
+
+static void test_flush_sort(struct test_flush_entry *tbl, uint32_t num)
+{
+	ocf_sort(tbl, num, sizeof(*tbl), 2, test_flush_key, test_flush_cmp,
+			NULL);
+}
+
+static void ocf_sort_test01(void **state)
+{
+	uint32_t num = TEST_RADIX_MIN_ENTRIES - 1;
+	struct test_flush_entry *tbl, *ref;
+
+	print_test_description("Table below radix threshold is sorted with "
+			"env_sort()");
+
+	tbl = test_flush_table(num, 4, 100000, 1);
+	ref = test_flush_reference(tbl, num);
+
+	expect_function_call(__wrap_env_sort);
+
+	test_flush_sort(tbl, num);
+
+	test_flush_check_order(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static void ocf_sort_test02(void **state)
+{
+	uint32_t num = TEST_RADIX_MIN_ENTRIES;
+	struct test_flush_entry *tbl, *ref;
+
+	print_test_description("Table at radix threshold is sorted with radix "
+			"sort, stable");
+
+	tbl = test_flush_table(num, 4, 100000, 2);
+	ref = test_flush_reference(tbl, num);
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+
+	test_flush_sort(tbl, num);
+
+	test_flush_check_stable(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static void ocf_sort_test03(void **state)
+{
+	uint32_t num = 100000;
+	struct test_flush_entry *tbl, *ref;
+
+	print_test_description("Large table with many cores and core lines "
+			"is sorted with radix sort, stable");
+
+	tbl = test_flush_table(num, 64, 1ULL << 40, 3);
+	ref = test_flush_reference(tbl, num);
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+
+	test_flush_sort(tbl, num);
+
+	test_flush_check_stable(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static void ocf_sort_test04(void **state)
+{
+	uint32_t num = 4096;
+	struct test_flush_entry *tbl, *ref;
+
+	print_test_description("Duplicate keys keep their original order");
+
+	/* Only 2 cores and 16 core lines, so most entries are duplicates */
+	tbl = test_flush_table(num, 2, 16, 4);
+	ref = test_flush_reference(tbl, num);
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+
+	test_flush_sort(tbl, num);
+
+	test_flush_check_stable(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static void ocf_sort_test05(void **state)
+{
+	uint32_t num = 4096;
+	struct test_flush_entry *tbl, *ref;
+
+	print_test_description("Table is sorted with env_sort() if radix sort "
+			"buffer can't be allocated");
+
+	tbl = test_flush_table(num, 4, 100000, 5);
+	ref = test_flush_reference(tbl, num);
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 0);
+	expect_function_call(__wrap_env_sort);
+
+	test_flush_sort(tbl, num);
+
+	test_flush_check_order(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static uint64_t test_page_key(const void *entry, uint32_t key)
+{
+	return *(const uint32_t *)entry;
+}
+
+static int test_page_cmp(const void *a, const void *b)
+{
+	uint32_t _a = *(const uint32_t *)a, _b = *(const uint32_t *)b;
+
+	if (_a == _b)
+		return 0;
+
+	return _a > _b ? 1 : -1;
+}
+
+static void test_page_sort(uint32_t *tbl, uint32_t num)
+{
+	ocf_sort(tbl, num, sizeof(*tbl), 1, test_page_key, test_page_cmp,
+			NULL);
+}
+
+static void test_page_check(uint32_t *tbl, uint32_t *ref, uint32_t num)
+{
+	uint32_t i;
+
+	qsort(ref, num, sizeof(*ref), test_page_cmp);
+
+	for (i = 0; i < num; i++)
+		assert_int_equal(tbl[i], ref[i]);
+}
+
+static void ocf_sort_test06(void **state)
+{
+	uint32_t num = 10000;
+	uint32_t *tbl, *ref;
+	uint32_t seed = 6;
+	uint32_t i;
+
+	print_test_description("Table of 32 bit single key entries is sorted "
+			"with radix sort");
+
+	tbl = test_malloc(sizeof(*tbl) * num);
+	ref = test_malloc(sizeof(*ref) * num);
+
+	for (i = 0; i < num; i++)
+		tbl[i] = ref[i] = test_rand(&seed) ^ (test_rand(&seed) << 24);
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+
+	test_page_sort(tbl, num);
+
+	test_page_check(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static void ocf_sort_test07(void **state)
+{
+	uint32_t num = 1000;
+	uint32_t *tbl, *ref;
+	uint32_t i;
+
+	print_test_description("Already sorted, reversed and constant tables "
+			"are sorted correctly");
+
+	tbl = test_malloc(sizeof(*tbl) * num);
+	ref = test_malloc(sizeof(*ref) * num);
+
+	for (i = 0; i < num; i++)
+		tbl[i] = ref[i] = i * 3;
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+	test_page_sort(tbl, num);
+	test_page_check(tbl, ref, num);
+
+	for (i = 0; i < num; i++)
+		tbl[i] = ref[i] = (num - i) << 16;
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+	test_page_sort(tbl, num);
+	test_page_check(tbl, ref, num);
+
+	for (i = 0; i < num; i++)
+		tbl[i] = ref[i] = 0xdeadbeef;
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+	test_page_sort(tbl, num);
+	test_page_check(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static void ocf_sort_test08(void **state)
+{
+	uint32_t num = 2048;
+	struct test_flush_entry *tbl, *ref;
+	uint32_t i;
+
+	print_test_description("Keys differing only in most significant bits "
+			"are sorted, stable");
+
+	tbl = test_flush_table(num, 3, 4, 8);
+	for (i = 0; i < num; i++)
+		tbl[i].core_line = (tbl[i].core_line << 62) | 0x1234;
+
+	ref = test_flush_reference(tbl, num);
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 1);
+
+	test_flush_sort(tbl, num);
+
+	test_flush_check_stable(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+static void ocf_sort_test09(void **state)
+{
+	uint32_t num = 3000;
+	uint32_t *tbl, *ref;
+	uint32_t seed = 9;
+	uint32_t i;
+
+	print_test_description("Single key table is sorted with env_sort() "
+			"if radix sort buffer can't be allocated");
+
+	tbl = test_malloc(sizeof(*tbl) * num);
+	ref = test_malloc(sizeof(*ref) * num);
+
+	for (i = 0; i < num; i++)
+		tbl[i] = ref[i] = test_rand(&seed) % 500;
+
+	expect_function_call(__wrap_env_vmalloc);
+	will_return(__wrap_env_vmalloc, 0);
+	expect_function_call(__wrap_env_sort);
+
+	test_page_sort(tbl, num);
+
+	test_page_check(tbl, ref, num);
+
+	test_free(ref);
+	test_free(tbl);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(ocf_sort_test01),
+		cmocka_unit_test(ocf_sort_test02),
+		cmocka_unit_test(ocf_sort_test03),
+		cmocka_unit_test(ocf_sort_test04),
+		cmocka_unit_test(ocf_sort_test05),
+		cmocka_unit_test(ocf_sort_test06),
+		cmocka_unit_test(ocf_sort_test07),
+		cmocka_unit_test(ocf_sort_test08),
+		cmocka_unit_test(ocf_sort_test09),
+	};
+
+	print_message("Unit test of src/utils/utils_sort.c\n");
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}